@@ -0,0 +1,69 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace TrenchBroom {
+    static std::atomic<size_t> s_allocationCount(0);
+    static std::atomic<size_t> s_allocatedBytes(0);
+
+    // every block is prefixed with its size so that the deallocation functions can track the allocated bytes
+    static constexpr size_t HeaderSize = alignof(std::max_align_t);
+
+    size_t allocationCount() {
+        return s_allocationCount.load(std::memory_order_relaxed);
+    }
+
+    size_t allocatedBytes() {
+        return s_allocatedBytes.load(std::memory_order_relaxed);
+    }
+}
+
+// replaces the global allocation functions so that the benchmarks can count allocations
+void* operator new(const std::size_t size) {
+    using namespace TrenchBroom;
+
+    if (void* block = std::malloc(HeaderSize + size)) {
+        s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+        s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        *static_cast<std::size_t*>(block) = size;
+        return static_cast<char*>(block) + HeaderSize;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    using namespace TrenchBroom;
+
+    if (ptr != nullptr) {
+        void* block = static_cast<char*>(ptr) - HeaderSize;
+        s_allocatedBytes.fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+void operator delete(void* ptr, const std::size_t size) noexcept {
+    operator delete(ptr);
+}
@@ -0,0 +1,49 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_AllocationCounter_h
+#define TrenchBroom_AllocationCounter_h
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+namespace TrenchBroom {
+    /**
+     * Returns the number of times the global operator new has been called since the benchmark started.
+     */
+    size_t allocationCount();
+
+    /**
+     * Returns the number of bytes that are currently allocated by the global operator new.
+     */
+    size_t allocatedBytes();
+
+    template<class L>
+    static void countAllocations(L&& lambda, const std::string& message) {
+        const size_t before = allocationCount();
+        lambda();
+        const size_t after = allocationCount();
+
+        printf("Allocations for '%s': %zu\n", message.c_str(), after - before);
+    }
+}
+
+#endif /* TrenchBroom_AllocationCounter_h */
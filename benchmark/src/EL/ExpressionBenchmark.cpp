@@ -0,0 +1,158 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+#include <gtest/gtest.h>
+
+#include "AllocationCounter.h"
+#include "BenchmarkUtils.h"
+#include "Assets/ModelDefinition.h"
+#include "EL/EvaluationContext.h"
+#include "EL/Expression.h"
+#include "IO/ELParser.h"
+#include "Model/EntityAttributes.h"
+#include "Model/EntityAttributesVariableStore.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace EL {
+        static constexpr size_t NumEntities = 20000;
+
+        /**
+         * The model expressions of the point entity definitions in Quake.fgd.
+         */
+        static const std::vector<String> QuakeModelExpressions = {
+            "{{ spawnflags & 1 -> \":maps/b_batt1.bsp\", \":maps/b_batt0.bsp\" }}",
+            "{{ spawnflags & 1 -> \":maps/b_rock1.bsp\", \":maps/b_rock0.bsp\" }}",
+            "{{ spawnflags & 1 -> \":maps/b_shell1.bsp\", \":maps/b_shell0.bsp\" }}",
+            "{{ spawnflags & 1 -> \":maps/b_nail1.bsp\", \":maps/b_nail0.bsp\" }}",
+            "{{ spawnflags & 2 -> \":maps/b_bh100.bsp\", spawnflags & 1 -> \":maps/b_bh10.bsp\", \":maps/b_bh25.bsp\" }}",
+            "{ \"path\": \":progs/suit.mdl\" }",
+            "{ \"path\": \":progs/quaddama.mdl\" }",
+            "{ \"path\": \":progs/invulner.mdl\" }",
+            "{ \"path\": \":progs/invisibl.mdl\" }",
+            "{ \"path\": \":progs/armor.mdl\", \"skin\": 2 }",
+            "{ \"path\": \":progs/armor.mdl\", \"skin\": 1 }",
+            "{ \"path\": \":progs/armor.mdl\" }",
+            "{ \"path\": \":progs/w_s_key.mdl\" }",
+            "{ \"path\": \":progs/w_g_key.mdl\" }",
+            "{ \"path\": \":progs/end1.mdl\" }",
+            "{ \"path\": \":progs/g_shot.mdl\" }",
+            "{ \"path\": \":progs/g_nail.mdl\" }",
+            "{ \"path\": \":progs/g_nail2.mdl\" }",
+            "{ \"path\": \":progs/g_rock.mdl\" }",
+            "{ \"path\": \":progs/g_rock2.mdl\" }",
+            "{ \"path\": \":progs/g_light.mdl\" }",
+            "{ \"path\": \":progs/soldier.mdl\" }",
+            "{ \"path\": \":progs/dog.mdl\" }",
+            "{ \"path\": \":progs/ogre.mdl\" }",
+            "{ \"path\": \":progs/ogre.mdl\" }",
+            "{ \"path\": \":progs/knight.mdl\" }",
+            "{ \"path\": \":progs/hknight.mdl\" }",
+            "{ \"path\": \":progs/wizard.mdl\" }",
+            "{ \"path\": \":progs/demon.mdl\" }",
+            "{ \"path\": \":progs/shambler.mdl\" }",
+            "{ \"path\": \":progs/boss.mdl\" }",
+            "{ \"path\": \":progs/enforcer.mdl\" }",
+            "{ \"path\": \":progs/shalrath.mdl\" }",
+            "{ \"path\": \":progs/tarbaby.mdl\" }",
+            "{ \"path\": \":progs/fish.mdl\" }",
+            "{ \"path\": \":progs/oldone.mdl\" }",
+            "{ \"path\": \":progs/zombie.mdl\" }",
+            "{ \"path\": \":progs/flame2.mdl\" }",
+            "{ \"path\": \":progs/flame2.mdl\" }",
+            "{ \"path\": \":progs/flame2.mdl\" }",
+            "{ \"path\": \":progs/flame.mdl\" }",
+            "{ \"path\": \":progs/lavaball.mdl\" }",
+            "{ \"path\": \":maps/b_explob.bsp\" }",
+            "{ \"path\": \":maps/b_exbox2.bsp\" }",
+            "{ \"path\": \":progs/teleport.mdl\" }"
+        };
+
+        static size_t checksum(const Value& value) {
+            return value.type() == Type_String ? value.stringValue().size() : value.length();
+        }
+
+        TEST(ExpressionBenchmark, evaluateQuakeModelExpressions) {
+            std::vector<Expression> expressions;
+            std::vector<std::unique_ptr<ExpressionBase>> trees;
+            for (const String& str : QuakeModelExpressions) {
+                expressions.push_back(IO::ELParser::parseStrict(str));
+                expressions.back().optimize();
+                trees.emplace_back(expressions.back().clone());
+            }
+
+            std::mt19937 random(0);
+            std::vector<Model::EntityAttributes> entities(NumEntities);
+            for (size_t i = 0; i < NumEntities; ++i) {
+                entities[i].addOrUpdateAttribute("classname", "entity" + std::to_string(i % expressions.size()), nullptr);
+                entities[i].addOrUpdateAttribute("spawnflags", std::to_string(random() % 4), nullptr);
+                entities[i].addOrUpdateAttribute("origin", "0 0 0", nullptr);
+            }
+
+            // the contexts are created up front so that only the evaluation itself is measured
+            std::vector<std::unique_ptr<EvaluationContext>> contexts;
+            contexts.reserve(NumEntities);
+            for (const Model::EntityAttributes& attributes : entities)
+                contexts.emplace_back(new EvaluationContext(Model::EntityAttributesVariableStore(attributes)));
+
+            const String description = std::to_string(NumEntities) + " entities";
+
+            const String treeDescription = "evaluate model expression trees for " + description;
+            size_t treeChecksum = 0;
+            countAllocations([&]() {
+                timeLambda([&]() {
+                    for (size_t i = 0; i < NumEntities; ++i)
+                        treeChecksum += checksum(trees[i % trees.size()]->evaluate(*contexts[i]));
+                }, treeDescription);
+            }, treeDescription);
+
+            const String programDescription = "evaluate compiled model expressions for " + description;
+            size_t programChecksum = 0;
+            countAllocations([&]() {
+                timeLambda([&]() {
+                    for (size_t i = 0; i < NumEntities; ++i)
+                        programChecksum += checksum(expressions[i % expressions.size()].evaluate(*contexts[i]));
+                }, programDescription);
+            }, programDescription);
+
+            ASSERT_EQ(treeChecksum, programChecksum);
+
+            std::vector<Assets::ModelDefinition> modelDefinitions;
+            for (const Expression& expression : expressions)
+                modelDefinitions.push_back(Assets::ModelDefinition(expression));
+
+            size_t specificationChecksum = 0;
+            timeLambda([&]() {
+                for (size_t i = 0; i < NumEntities; ++i) {
+                    const Assets::ModelSpecification specification = modelDefinitions[i % modelDefinitions.size()].modelSpecification(entities[i]);
+                    specificationChecksum += specification.path.length() + specification.skinIndex;
+                }
+            }, "compute model specifications for " + description);
+
+            ASSERT_LT(0u, specificationChecksum);
+        }
+    }
+}
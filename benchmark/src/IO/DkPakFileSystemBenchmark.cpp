@@ -0,0 +1,188 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "IO/CharArrayReader.h"
+#include "IO/DkPakFileSystem.h"
+#include "IO/FileMatcher.h"
+#include "IO/MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        static constexpr size_t NumEntries = 400;
+        static constexpr size_t NumCommandsPerEntry = 8000;
+
+        struct CompressedEntry {
+            String name;
+            String data;
+            size_t uncompressedSize;
+        };
+
+        /**
+         * Creates a compressed entry from randomly chosen commands, with a mix resembling compressed textures.
+         */
+        static CompressedEntry createCompressedEntry(const String& name, const unsigned int seed) {
+            std::mt19937 random(seed);
+            String compressed;
+            size_t size = 0;
+
+            for (size_t i = 0; i < NumCommandsPerEntry; ++i) {
+                const auto command = random() % 8;
+                if (command < 3 || size < 2) {
+                    const auto x = static_cast<unsigned char>(random() % 0x40);
+                    compressed.push_back(static_cast<char>(x));
+                    for (size_t j = 0; j <= x; ++j)
+                        compressed.push_back(static_cast<char>(random()));
+                    size += static_cast<size_t>(x) + 1;
+                } else if (command == 3) {
+                    const auto x = static_cast<unsigned char>(0x40 + random() % 0x40);
+                    compressed.push_back(static_cast<char>(x));
+                    size += static_cast<size_t>(x) - 62;
+                } else if (command == 4) {
+                    const auto x = static_cast<unsigned char>(0x80 + random() % 0x40);
+                    compressed.push_back(static_cast<char>(x));
+                    compressed.push_back(static_cast<char>(random()));
+                    size += static_cast<size_t>(x) - 126;
+                } else {
+                    const auto x = static_cast<unsigned char>(0xC0 + random() % 0x3E);
+                    const auto offset = random() % (std::min(size - 2, size_t(255)) + 1);
+                    compressed.push_back(static_cast<char>(x));
+                    compressed.push_back(static_cast<char>(offset));
+                    size += static_cast<size_t>(x) - 190;
+                }
+            }
+            compressed.push_back(static_cast<char>(0xFF));
+
+            return CompressedEntry { name, compressed, size };
+        }
+
+        static MappedFile::Ptr createDkPak(const Path& path, const std::vector<CompressedEntry>& entries) {
+            std::vector<char> data(12, 0);
+            std::vector<int32_t> addresses;
+            for (const CompressedEntry& entry : entries) {
+                addresses.push_back(static_cast<int32_t>(data.size()));
+                data.insert(std::end(data), std::begin(entry.data), std::end(entry.data));
+            }
+
+            const auto directoryAddress = static_cast<int32_t>(data.size());
+            const auto directorySize = static_cast<int32_t>(entries.size() * 0x48);
+            for (size_t i = 0; i < entries.size(); ++i) {
+                char entry[0x48];
+                std::memset(entry, 0, sizeof(entry));
+                std::strncpy(entry, entries[i].name.c_str(), 0x37);
+                const int32_t values[] = {
+                    addresses[i],
+                    static_cast<int32_t>(entries[i].uncompressedSize),
+                    static_cast<int32_t>(entries[i].data.size()),
+                    1
+                };
+                std::memcpy(entry + 0x38, values, sizeof(values));
+                data.insert(std::end(data), entry, entry + sizeof(entry));
+            }
+
+            std::memcpy(data.data(), "PACK", 4);
+            std::memcpy(data.data() + 4, &directoryAddress, sizeof(int32_t));
+            std::memcpy(data.data() + 8, &directorySize, sizeof(int32_t));
+
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+            return MappedFile::Ptr(new MappedFileBuffer(path, buffer, data.size()));
+        }
+
+        /**
+         * Decompresses the given entry one byte at a time through a CharArrayReader, for comparison.
+         */
+        static void decompressBytewise(const CompressedEntry& entry, std::vector<char>& result) {
+            result.resize(entry.uncompressedSize);
+            CharArrayReader reader(entry.data.data(), entry.data.data() + entry.data.size());
+            size_t out = 0;
+
+            unsigned char x;
+            while (reader.canRead(1) && (x = reader.readUnsignedChar<unsigned char>()) < 0xFF) {
+                if (x < 0x40) {
+                    for (size_t i = 0; i <= x; ++i)
+                        result[out++] = reader.readChar<char>();
+                } else if (x < 0x80) {
+                    for (size_t i = 0; i < static_cast<size_t>(x) - 62; ++i)
+                        result[out++] = 0;
+                } else if (x < 0xC0) {
+                    const char c = reader.readChar<char>();
+                    for (size_t i = 0; i < static_cast<size_t>(x) - 126; ++i)
+                        result[out++] = c;
+                } else if (x < 0xFE) {
+                    const size_t distance = reader.readSize<unsigned char>() + 2;
+                    for (size_t i = 0; i < static_cast<size_t>(x) - 190; ++i, ++out)
+                        result[out] = result[out - distance];
+                }
+            }
+        }
+
+        TEST(DkPakFileSystemBenchmark, openCompressedFiles) {
+            std::vector<CompressedEntry> entries;
+            size_t totalSize = 0;
+            for (size_t i = 0; i < NumEntries; ++i) {
+                entries.push_back(createCompressedEntry("textures/dir" + std::to_string(i % 20) + "/texture" + std::to_string(i) + ".wal", static_cast<unsigned int>(i)));
+                totalSize += entries.back().uncompressedSize;
+            }
+
+            const Path pakPath("pak0.pak");
+            const DkPakFileSystem fs(pakPath, createDkPak(pakPath, entries));
+            const Path::List paths = fs.findItemsRecursively(Path(""), FileTypeMatcher(true, false));
+            ASSERT_EQ(NumEntries, paths.size());
+
+            const String description = std::to_string(NumEntries) + " files (" + std::to_string(totalSize / 1024 / 1024) + " MB)";
+
+            std::vector<char> buffer;
+            size_t checksum = 0;
+            timeLambda([&]() {
+                for (const CompressedEntry& entry : entries) {
+                    decompressBytewise(entry, buffer);
+                    checksum += static_cast<size_t>(buffer.back());
+                }
+            }, "decompress " + description + " byte by byte");
+
+            size_t fsChecksum = 0;
+            timeLambda([&]() {
+                for (const Path& path : paths)
+                    fsChecksum += static_cast<size_t>(*(fs.openFile(path)->end() - 1));
+            }, "open " + description);
+
+            // the most recently opened files are kept in memory
+            timeLambda([&]() {
+                for (size_t i = 0; i < 10; ++i) {
+                    for (size_t j = paths.size() - 20; j < paths.size(); ++j)
+                        fs.openFile(paths[j]);
+                }
+            }, "open 20 recently used files 10 times");
+
+            ASSERT_EQ(checksum, fsChecksum);
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "IO/FileSystemHierarchy.h"
+#include "IO/IdPakFileSystem.h"
+#include "IO/MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        static constexpr size_t NumPaks = 20;
+        static constexpr size_t NumFilesPerPak = 1000;
+        static constexpr size_t NumLookups = 20000;
+
+        static IdPakFileSystem* createPak(const String& pakName, const StringList& fileNames) {
+            std::vector<char> data(12, 0);
+            std::vector<int32_t> addresses;
+            for (const String& fileName : fileNames) {
+                addresses.push_back(static_cast<int32_t>(data.size()));
+                data.insert(std::end(data), std::begin(fileName), std::end(fileName));
+            }
+
+            const auto directoryAddress = static_cast<int32_t>(data.size());
+            const auto directorySize = static_cast<int32_t>(fileNames.size() * 0x40);
+            for (size_t i = 0; i < fileNames.size(); ++i) {
+                char entry[0x40];
+                std::memset(entry, 0, sizeof(entry));
+                std::strncpy(entry, fileNames[i].c_str(), 0x37);
+                const auto length = static_cast<int32_t>(fileNames[i].size());
+                std::memcpy(entry + 0x38, &addresses[i], sizeof(int32_t));
+                std::memcpy(entry + 0x3C, &length, sizeof(int32_t));
+                data.insert(std::end(data), entry, entry + sizeof(entry));
+            }
+
+            std::memcpy(data.data(), "PACK", 4);
+            std::memcpy(data.data() + 4, &directoryAddress, sizeof(int32_t));
+            std::memcpy(data.data() + 8, &directorySize, sizeof(int32_t));
+
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+
+            const Path path(pakName);
+            return new IdPakFileSystem(path, MappedFile::Ptr(new MappedFileBuffer(path, buffer, data.size())));
+        }
+
+        TEST(FileSystemHierarchyBenchmark, resolveModelsAndTextures) {
+            FileSystemHierarchy hierarchy;
+            std::vector<const FileSystem*> paks;
+
+            // every pak contains models and textures, half of which override those of the previous pak
+            for (size_t i = 0; i < NumPaks; ++i) {
+                StringList fileNames;
+                for (size_t j = 0; j < NumFilesPerPak / 2; ++j) {
+                    const size_t index = i * NumFilesPerPak / 4 + j;
+                    fileNames.push_back("progs/model" + std::to_string(index) + ".mdl");
+                    fileNames.push_back("textures/base/texture" + std::to_string(index) + ".wal");
+                }
+
+                auto* pak = createPak("pak" + std::to_string(i) + ".pak", fileNames);
+                hierarchy.pushFileSystem(pak);
+                paks.push_back(pak);
+            }
+
+            // look up existing and missing models and textures with mixed case
+            std::vector<Path> paths;
+            const size_t maxIndex = NumPaks * NumFilesPerPak / 4 + NumFilesPerPak;
+            for (size_t i = 0; i < NumLookups; ++i) {
+                const size_t index = (i * 7919) % maxIndex;
+                if (i % 2 == 0) {
+                    paths.push_back(Path("progs/Model" + std::to_string(index) + ".mdl"));
+                } else {
+                    paths.push_back(Path("textures/base/TEXTURE" + std::to_string(index) + ".wal"));
+                }
+            }
+
+            std::vector<const FileSystem*> owners;
+            timeLambda([&]() {
+                for (const Path& path : paths) {
+                    const FileSystem* owner = nullptr;
+                    for (auto it = paks.rbegin(), end = paks.rend(); it != end && owner == nullptr; ++it) {
+                        if ((*it)->fileExists(path)) {
+                            owner = *it;
+                        }
+                    }
+                    owners.push_back(owner);
+                }
+            }, "resolve " + std::to_string(NumLookups) + " paths by probing " + std::to_string(NumPaks) + " paks");
+
+            std::vector<bool> exists;
+            timeLambda([&]() {
+                for (const Path& path : paths) {
+                    exists.push_back(hierarchy.fileExists(path));
+                }
+            }, "resolve " + std::to_string(NumLookups) + " paths using the hierarchy index");
+
+            printf("Resolved %zu of %zu paths\n", static_cast<size_t>(std::count(std::begin(exists), std::end(exists), true)), paths.size());
+
+            for (size_t i = 0; i < paths.size(); ++i) {
+                ASSERT_EQ(owners[i] != nullptr, exists[i]);
+            }
+
+            // the file must be opened from the topmost pak that contains it
+            for (size_t i = 0; i < paths.size(); i += 97) {
+                if (owners[i] != nullptr) {
+                    ASSERT_EQ(owners[i]->openFile(paths[i])->begin(), hierarchy.openFile(paths[i])->begin());
+                }
+            }
+        }
+    }
+}
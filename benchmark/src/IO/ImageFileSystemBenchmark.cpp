@@ -0,0 +1,146 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "IO/FileMatcher.h"
+#include "IO/IdPakFileSystem.h"
+#include "IO/MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        static constexpr size_t NumDirectories = 200;
+        static constexpr size_t NumFilesPerDirectory = 200;
+        static constexpr size_t NumLookups = 200000;
+        static constexpr size_t NumGameFiles = 50000;
+
+        static MappedFile::Ptr createPak(const Path& path, const StringList& fileNames) {
+            std::vector<char> data(12, 0);
+            std::vector<int32_t> addresses;
+            for (const String& fileName : fileNames) {
+                addresses.push_back(static_cast<int32_t>(data.size()));
+                data.insert(std::end(data), std::begin(fileName), std::end(fileName));
+            }
+
+            const auto directoryAddress = static_cast<int32_t>(data.size());
+            const auto directorySize = static_cast<int32_t>(fileNames.size() * 0x40);
+            for (size_t i = 0; i < fileNames.size(); ++i) {
+                char entry[0x40];
+                std::memset(entry, 0, sizeof(entry));
+                std::strncpy(entry, fileNames[i].c_str(), 0x37);
+                const auto length = static_cast<int32_t>(fileNames[i].size());
+                std::memcpy(entry + 0x38, &addresses[i], sizeof(int32_t));
+                std::memcpy(entry + 0x3C, &length, sizeof(int32_t));
+                data.insert(std::end(data), entry, entry + sizeof(entry));
+            }
+
+            std::memcpy(data.data(), "PACK", 4);
+            std::memcpy(data.data() + 4, &directoryAddress, sizeof(int32_t));
+            std::memcpy(data.data() + 8, &directorySize, sizeof(int32_t));
+
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+            return MappedFile::Ptr(new MappedFileBuffer(path, buffer, data.size()));
+        }
+
+        TEST(ImageFileSystemBenchmark, lookupFiles) {
+            StringList fileNames;
+            for (size_t i = 0; i < NumDirectories; ++i) {
+                for (size_t j = 0; j < NumFilesPerDirectory; ++j) {
+                    fileNames.push_back("textures/dir" + std::to_string(i) + "/Texture" + std::to_string(j) + ".wal");
+                }
+            }
+
+            const Path pakPath("pak0.pak");
+            const auto pakFile = createPak(pakPath, fileNames);
+
+            std::unique_ptr<IdPakFileSystem> fs;
+            timeLambda([&]() {
+                fs = std::make_unique<IdPakFileSystem>(pakPath, pakFile);
+            }, "read directory of " + std::to_string(fileNames.size()) + " files");
+
+            // look up existing and missing files with mixed case
+            std::vector<Path> paths;
+            for (size_t i = 0; i < NumLookups; ++i) {
+                const size_t dir = (i * 7919) % NumDirectories;
+                const size_t file = (i * 104729) % (NumFilesPerDirectory + NumFilesPerDirectory / 4);
+                paths.push_back(Path("Textures/DIR" + std::to_string(dir) + "/texture" + std::to_string(file) + ".wal"));
+            }
+
+            size_t found = 0;
+            timeLambda([&]() {
+                for (const Path& path : paths) {
+                    if (fs->fileExists(path)) {
+                        ++found;
+                    }
+                }
+            }, "look up " + std::to_string(NumLookups) + " files");
+
+            size_t opened = 0;
+            timeLambda([&]() {
+                for (size_t i = 0; i < paths.size(); i += 4) {
+                    if (fs->fileExists(paths[i]) && fs->openFile(paths[i]) != nullptr) {
+                        ++opened;
+                    }
+                }
+            }, "open " + std::to_string(NumLookups / 4) + " files");
+
+            ASSERT_EQ(NumLookups * 4 / 5, found);
+            ASSERT_LT(0u, opened);
+        }
+
+        TEST(ImageFileSystemBenchmark, findItemsRecursively) {
+            // mimic the layout of a game directory with models, sounds, maps and textures in nested directories
+            StringList fileNames;
+            for (size_t i = 0; fileNames.size() < NumGameFiles; ++i) {
+                const auto index = std::to_string(i);
+                fileNames.push_back("progs/monsters/set" + std::to_string(i % 50) + "/model" + index + ".mdl");
+                fileNames.push_back("sound/ambience/set" + std::to_string(i % 40) + "/sound" + index + ".wav");
+                fileNames.push_back("maps/episode" + std::to_string(i % 4) + "/map" + index + ".bsp");
+                fileNames.push_back("textures/base/group" + std::to_string(i % 100) + "/sub" + std::to_string(i % 7) + "/texture" + index + ".wal");
+                fileNames.push_back("gfx/env/sky" + index + ".tga");
+            }
+
+            const Path pakPath("pak0.pak");
+            const IdPakFileSystem fs(pakPath, createPak(pakPath, fileNames));
+
+            Path::List files;
+            timeLambda([&]() {
+                files = fs.findItemsRecursively(Path(""), FileTypeMatcher(true, false));
+            }, "find " + std::to_string(fileNames.size()) + " files recursively");
+
+            Path::List textures;
+            timeLambda([&]() {
+                textures = fs.findItemsRecursively(Path("textures"), FileExtensionMatcher("wal"));
+            }, "find textures recursively");
+
+            ASSERT_EQ(fileNames.size(), files.size());
+            ASSERT_EQ(NumGameFiles / 5, textures.size());
+        }
+    }
+}
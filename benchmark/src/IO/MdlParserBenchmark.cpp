@@ -0,0 +1,157 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "AllocationCounter.h"
+#include "BenchmarkUtils.h"
+#include "Assets/EntityModel.h"
+#include "Assets/MdlModel.h"
+#include "Assets/Palette.h"
+#include "IO/MappedFile.h"
+#include "IO/MdlParser.h"
+#include "IO/Path.h"
+
+#include <vecmath/bbox.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        // roughly the contents of the progs directory of id1: a few dozen animated monsters and weapons, and many
+        // static items with only a handful of frames
+        static constexpr size_t NumAnimatedModels = 30;
+        static constexpr size_t NumStaticModels = 50;
+
+        struct ModelFile {
+            String name;
+            MappedFile::Ptr file;
+            size_t frameCount;
+            size_t triangleCount;
+        };
+
+        template <typename T>
+        static void append(std::vector<char>& data, const T value) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            data.insert(std::end(data), bytes, bytes + sizeof(T));
+        }
+
+        static ModelFile createMdl(const String& name, const size_t vertexCount, const size_t triangleCount, const size_t frameCount, const unsigned int seed) {
+            std::mt19937 random(seed);
+            const size_t skinWidth = 128;
+            const size_t skinHeight = 128;
+
+            std::vector<char> data;
+            data.insert(std::end(data), { 'I', 'D', 'P', 'O' });
+            append<int32_t>(data, 6);
+            for (const float f : { 0.25f, 0.25f, 0.25f, -32.0f, -32.0f, -24.0f, 40.0f, 0.0f, 0.0f, 24.0f })
+                append<float>(data, f);
+            for (const size_t i : { size_t(1), skinWidth, skinHeight, vertexCount, triangleCount, frameCount, size_t(0), size_t(0), size_t(0) })
+                append<int32_t>(data, static_cast<int32_t>(i));
+
+            append<int32_t>(data, 0);
+            for (size_t i = 0; i < skinWidth * skinHeight; ++i)
+                data.push_back(static_cast<char>(random()));
+
+            for (size_t i = 0; i < vertexCount; ++i) {
+                append<int32_t>(data, static_cast<int32_t>(random() % 2));
+                append<int32_t>(data, static_cast<int32_t>(random() % skinWidth));
+                append<int32_t>(data, static_cast<int32_t>(random() % skinHeight));
+            }
+            for (size_t i = 0; i < triangleCount; ++i) {
+                append<int32_t>(data, static_cast<int32_t>(random() % 2));
+                for (size_t j = 0; j < 3; ++j)
+                    append<int32_t>(data, static_cast<int32_t>(random() % vertexCount));
+            }
+
+            for (size_t i = 0; i < frameCount; ++i) {
+                append<int32_t>(data, 0);
+                data.insert(std::end(data), 8, 0);
+                const String frameName = "frame" + std::to_string(i);
+                char nameBytes[16] = { 0 };
+                std::strncpy(nameBytes, frameName.c_str(), 15);
+                data.insert(std::end(data), nameBytes, nameBytes + 16);
+                for (size_t j = 0; j < vertexCount * 4; ++j)
+                    data.push_back(static_cast<char>(random()));
+            }
+
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+            return ModelFile { name, MappedFile::Ptr(new MappedFileBuffer(Path(name), buffer, data.size())), frameCount, triangleCount };
+        }
+
+        TEST(MdlParserBenchmark, loadProgsDirectory) {
+            std::mt19937 random(0);
+            std::vector<ModelFile> files;
+            for (size_t i = 0; i < NumAnimatedModels; ++i) {
+                const size_t vertexCount = 150 + random() % 250;
+                files.push_back(createMdl("progs/monster" + std::to_string(i) + ".mdl", vertexCount, 2 * vertexCount, 60 + random() % 240, static_cast<unsigned int>(i)));
+            }
+            for (size_t i = 0; i < NumStaticModels; ++i) {
+                const size_t vertexCount = 20 + random() % 80;
+                files.push_back(createMdl("progs/item" + std::to_string(i) + ".mdl", vertexCount, 2 * vertexCount, 1 + random() % 8, static_cast<unsigned int>(NumAnimatedModels + i)));
+            }
+
+            // what the parser used to keep in memory when it decoded all frames up front
+            size_t allFramesSize = 0;
+            for (const ModelFile& file : files)
+                allFramesSize += file.frameCount * file.triangleCount * 3 * sizeof(Assets::MdlFrame::Vertex);
+
+            auto* paletteData = new unsigned char[768];
+            std::fill(paletteData, paletteData + 768, 0);
+            const Assets::Palette palette(768, paletteData);
+
+            const String description = std::to_string(files.size()) + " models";
+            const size_t bytesBefore = allocatedBytes();
+            printf("Memory in use before loading %s: %zu bytes\n", description.c_str(), bytesBefore);
+
+            std::vector<std::unique_ptr<Assets::EntityModel>> models;
+            timeLambda([&]() {
+                for (const ModelFile& file : files) {
+                    MdlParser parser(file.name, file.file, palette);
+                    models.emplace_back(parser.parseModel());
+                }
+            }, "load " + description);
+
+            const size_t bytesLoaded = allocatedBytes();
+            printf("Memory in use after loading %s: %zu bytes (+%zu bytes)\n", description.c_str(), bytesLoaded, bytesLoaded - bytesBefore);
+
+            // the editor displays the first frame of most models
+            float checksum = 0.0f;
+            timeLambda([&]() {
+                for (const auto& model : models)
+                    checksum += model->bounds(0, 0).size().x();
+            }, "decode the first frame of " + description);
+
+            const size_t bytesDecoded = allocatedBytes();
+            printf("Memory in use after decoding the first frame of %s: %zu bytes (+%zu bytes)\n", description.c_str(), bytesDecoded, bytesDecoded - bytesBefore);
+            printf("Vertex data of all frames of %s: %zu bytes\n", description.c_str(), allFramesSize);
+
+            ASSERT_LT(0.0f, checksum);
+        }
+    }
+}
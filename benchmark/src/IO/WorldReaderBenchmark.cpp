@@ -0,0 +1,83 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "IO/SimpleParserStatus.h"
+#include "IO/WorldReader.h"
+#include "Model/Entity.h"
+#include "Model/Layer.h"
+#include "Model/World.h"
+
+#include <memory>
+#include <string>
+
+namespace TrenchBroom {
+    namespace IO {
+        static constexpr size_t NumEntities = 20000;
+
+        /**
+         * Creates a map with chains of triggers and doors that target each other, as they appear in large maps.
+         */
+        static String createLinkedMap() {
+            StringStream str;
+            str << "{\n\"classname\" \"worldspawn\"\n}\n";
+            for (size_t i = 0; i < NumEntities; ++i) {
+                str << "{\n";
+                str << "\"classname\" \"" << (i % 2 == 0 ? "trigger_multiple" : "func_door") << "\"\n";
+                str << "\"origin\" \"" << (i % 100) * 64 << " " << (i / 100) * 64 << " 0\"\n";
+                str << "\"spawnflags\" \"" << i % 8 << "\"\n";
+                str << "\"targetname\" \"t" << i << "\"\n";
+                str << "\"target\" \"t" << (i + 1) % NumEntities << "\"\n";
+                if (i % 4 == 0)
+                    str << "\"killtarget\" \"t" << (i + 2) % NumEntities << "\"\n";
+                str << "}\n";
+            }
+            return str.str();
+        }
+
+        TEST(WorldReaderBenchmark, readLinkedMap) {
+            const String data = createLinkedMap();
+            const vm::bbox3 worldBounds(8192);
+            const String description = std::to_string(NumEntities) + " linked entities";
+
+            std::unique_ptr<Model::World> world;
+            timeLambda([&]() {
+                SimpleParserStatus status(nullptr);
+                WorldReader reader(data, nullptr);
+                world.reset(reader.read(Model::MapFormat::Standard, worldBounds, status));
+            }, "read map with " + description);
+
+            // reading the map builds the index once, this builds it again to report the time on its own
+            timeLambda([&]() {
+                world->rebuildAttributableIndex();
+            }, "build attribute index and links of " + description);
+
+            const Model::NodeList& entities = world->defaultLayer()->children();
+            ASSERT_EQ(NumEntities, entities.size());
+            for (const Model::Node* node : entities) {
+                const Model::Entity* entity = static_cast<const Model::Entity*>(node);
+                ASSERT_EQ(1u, entity->linkSources().size());
+                ASSERT_EQ(1u, entity->linkTargets().size());
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "AllocationCounter.h"
+#include "BenchmarkUtils.h"
+#include "Model/EntityAttributes.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        static constexpr size_t NumEntities = 30000;
+
+        TEST(EntityAttributesBenchmark, buildAndQueryAttributes) {
+            // between three and ten attributes per entity, as in a typical large map
+            std::vector<EntityAttribute::List> attributeLists(NumEntities);
+            for (size_t i = 0; i < NumEntities; ++i) {
+                EntityAttribute::List& list = attributeLists[i];
+                list.push_back(EntityAttribute(AttributeNames::Classname, "light"));
+                list.push_back(EntityAttribute(AttributeNames::Origin, std::to_string(i) + " 128 -64"));
+                list.push_back(EntityAttribute(AttributeNames::Spawnflags, std::to_string(i % 8)));
+                for (size_t j = 0; j < i % 8; ++j)
+                    list.push_back(EntityAttribute("_key" + std::to_string(j), std::to_string(i * j)));
+            }
+
+            std::vector<std::unique_ptr<EntityAttributes>> entities;
+            entities.reserve(NumEntities);
+
+            const String description = std::to_string(NumEntities) + " entities";
+            const size_t bytesBefore = allocatedBytes();
+            countAllocations([&]() {
+                timeLambda([&]() {
+                    for (const EntityAttribute::List& list : attributeLists) {
+                        entities.emplace_back(new EntityAttributes());
+                        entities.back()->setAttributes(list);
+                    }
+                }, "set attributes of " + description);
+            }, "set attributes of " + description);
+            printf("Memory used by the attributes of %s: %zu bytes\n", description.c_str(), allocatedBytes() - bytesBefore);
+
+            size_t found = 0;
+            timeLambda([&]() {
+                for (const auto& entity : entities) {
+                    if (entity->attribute(AttributeNames::Classname) != nullptr)
+                        ++found;
+                    if (entity->attribute(AttributeNames::Spawnflags) != nullptr)
+                        ++found;
+                    if (entity->attribute(AttributeNames::Targetname) != nullptr)
+                        ++found;
+                }
+            }, "look up attributes of " + description);
+
+            ASSERT_EQ(2 * NumEntities, found);
+        }
+    }
+}
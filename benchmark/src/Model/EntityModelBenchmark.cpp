@@ -0,0 +1,90 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "Assets/EntityDefinition.h"
+#include "Assets/ModelDefinition.h"
+#include "IO/ELParser.h"
+#include "Model/Entity.h"
+
+#include <vecmath/bbox.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        static constexpr size_t NumEntities = 20000;
+        static constexpr size_t NumFrames = 10;
+
+        TEST(EntityModelBenchmark, queryModelSpecifications) {
+            const std::vector<String> modelExpressions = {
+                "{{ spawnflags & 1 -> \":maps/b_batt1.bsp\", \":maps/b_batt0.bsp\" }}",
+                "{{ spawnflags & 2 -> \":maps/b_bh100.bsp\", spawnflags & 1 -> \":maps/b_bh10.bsp\", \":maps/b_bh25.bsp\" }}",
+                "{ \"path\": \":progs/armor.mdl\", \"skin\": 2 }",
+                "{ \"path\": \":progs/soldier.mdl\" }",
+                "{ \"path\": \":progs/flame2.mdl\" }"
+            };
+
+            std::vector<std::unique_ptr<Assets::PointEntityDefinition>> definitions;
+            for (size_t i = 0; i < modelExpressions.size(); ++i) {
+                const Assets::ModelDefinition modelDefinition(IO::ELParser::parseStrict(modelExpressions[i]));
+                definitions.emplace_back(new Assets::PointEntityDefinition("entity" + std::to_string(i), Color(), vm::bbox3(8.0), "", Assets::AttributeDefinitionList(), modelDefinition));
+            }
+
+            std::vector<std::unique_ptr<Entity>> entities;
+            for (size_t i = 0; i < NumEntities; ++i) {
+                entities.emplace_back(new Entity());
+                entities.back()->setAttributes({
+                    EntityAttribute("classname", "entity" + std::to_string(i % definitions.size())),
+                    EntityAttribute("spawnflags", std::to_string(i % 4)),
+                    EntityAttribute("origin", "0 0 0")
+                });
+                entities.back()->setDefinition(definitions[i % definitions.size()].get());
+            }
+
+            // Every frame that invalidates the entity renderer queries the model specification of each entity twice:
+            // once when building the bounds and once when updating the model renderer. In between, some entities are
+            // moved, which does not affect their models.
+            size_t queries = 0;
+            size_t checksum = 0;
+            timeLambda([&]() {
+                for (size_t frame = 0; frame < NumFrames; ++frame) {
+                    for (size_t i = frame; i < NumEntities; i += 100)
+                        entities[i]->addOrUpdateAttribute("origin", std::to_string(frame) + " 0 0");
+
+                    for (const auto& entity : entities) {
+                        checksum += entity->modelSpecification().skinIndex;
+                        checksum += entity->modelSpecification().path.length();
+                        queries += 2;
+                    }
+                }
+            }, "query model specifications for " + std::to_string(NumEntities) + " entities in " + std::to_string(NumFrames) + " frames");
+
+            printf("Model specification queries per frame: %zu\n", queries / NumFrames);
+            ASSERT_LT(0u, checksum);
+
+            for (const auto& entity : entities)
+                entity->setDefinition(nullptr);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/CollectContainedNodesVisitor.h"
+#include "Model/CollectTouchingNodesVisitor.h"
+#include "Model/EditorContext.h"
+#include "Model/Layer.h"
+#include "Model/MapFormat.h"
+#include "Model/World.h"
+
+#include <vecmath/bbox.h>
+#include <vecmath/vec.h>
+
+#include <algorithm>
+#include <string>
+
+namespace TrenchBroom {
+    namespace Model {
+        static constexpr size_t MapSizeX = 60;
+        static constexpr size_t MapSizeY = 50;
+        static constexpr size_t MapSizeZ = 20;
+        static constexpr FloatType CellSize = 32.0;
+
+        TEST(SelectTouchingBenchmark, benchSelectTouchingAndInside) {
+            const vm::bbox3 worldBounds(8192.0);
+            World world(MapFormat::Standard, nullptr, worldBounds);
+            BrushBuilder builder(&world, worldBounds);
+            EditorContext editorContext;
+
+            // a block of 60k cubes with gaps between them
+            for (size_t x = 0; x < MapSizeX; ++x) {
+                for (size_t y = 0; y < MapSizeY; ++y) {
+                    for (size_t z = 0; z < MapSizeZ; ++z) {
+                        const auto min = vm::vec3(static_cast<FloatType>(x), static_cast<FloatType>(y), static_cast<FloatType>(z)) * CellSize;
+                        Brush* brush = builder.createCuboid(vm::bbox3(min, min + vm::vec3(24.0, 24.0, 24.0)), "cube");
+                        world.defaultLayer()->addChild(brush);
+                    }
+                }
+            }
+
+            // a large brush covering a region of about 4k cubes
+            Brush* selector = builder.createCuboid(vm::bbox3(vm::vec3(300.0, 200.0, 100.0), vm::vec3(900.0, 700.0, 400.0)), "selector");
+            world.defaultLayer()->addChild(selector);
+            const BrushList selectors { selector };
+
+            NodeList visitorTouching, visitorContained;
+            timeLambda([&]() {
+                CollectTouchingNodesVisitor<BrushList::const_iterator> visitor(std::begin(selectors), std::end(selectors), editorContext);
+                world.acceptAndRecurse(visitor);
+                visitorTouching = visitor.nodes();
+            }, "select touching by visiting all nodes");
+            timeLambda([&]() {
+                CollectContainedNodesVisitor<BrushList::const_iterator> visitor(std::begin(selectors), std::end(selectors), editorContext);
+                world.acceptAndRecurse(visitor);
+                visitorContained = visitor.nodes();
+            }, "select inside by visiting all nodes");
+
+            NodeList treeTouching, treeContained;
+            timeLambda([&]() { treeTouching = world.findNodesTouching(selectors, editorContext); }, "select touching using the node tree");
+            timeLambda([&]() { treeContained = world.findNodesContainedIn(selectors, editorContext); }, "select inside using the node tree");
+
+            printf("Found %zu touching and %zu contained brushes\n", treeTouching.size(), treeContained.size());
+
+            std::sort(std::begin(visitorTouching), std::end(visitorTouching));
+            std::sort(std::begin(visitorContained), std::end(visitorContained));
+            std::sort(std::begin(treeTouching), std::end(treeTouching));
+            std::sort(std::begin(treeContained), std::end(treeContained));
+            ASSERT_EQ(visitorTouching, treeTouching);
+            ASSERT_EQ(visitorContained, treeContained);
+        }
+    }
+}
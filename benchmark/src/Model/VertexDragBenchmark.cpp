@@ -0,0 +1,166 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/Layer.h"
+#include "Model/MapFormat.h"
+#include "Model/World.h"
+
+#include <vecmath/bbox.h>
+#include <vecmath/constants.h>
+#include <vecmath/polygon.h>
+#include <vecmath/vec.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        static constexpr size_t NumBrushes = 500;
+        static constexpr size_t NumDragSteps = 50;
+
+        static BrushList createBrushes(World& world, const vm::bbox3& worldBounds) {
+            BrushBuilder builder(&world, worldBounds);
+
+            BrushList brushes;
+            for (size_t i = 0; i < NumBrushes; ++i) {
+                const auto min = vm::vec3(static_cast<FloatType>(i % 25), static_cast<FloatType>(i / 25), 0.0) * 128.0;
+                Brush* brush = builder.createCuboid(vm::bbox3(min, min + vm::vec3(64.0, 64.0, 64.0)), "texture");
+                world.defaultLayer()->addChild(brush);
+                brushes.push_back(brush);
+            }
+            return brushes;
+        }
+
+        static BrushList createCones(World& world, const vm::bbox3& worldBounds) {
+            BrushBuilder builder(&world, worldBounds);
+
+            static constexpr size_t NumBaseVertices = 32;
+
+            BrushList brushes;
+            for (size_t i = 0; i < NumBrushes / 5; ++i) {
+                const auto center = vm::vec3(static_cast<FloatType>(i % 10), static_cast<FloatType>(i / 10), 0.0) * 256.0;
+
+                std::vector<vm::vec3> points;
+                for (size_t j = 0; j < NumBaseVertices; ++j) {
+                    const auto angle = 2.0 * vm::C::pi() * static_cast<FloatType>(j) / static_cast<FloatType>(NumBaseVertices);
+                    points.push_back(center + round(vm::vec3(std::cos(angle), std::sin(angle), 0.0) * 96.0));
+                }
+                points.push_back(center + vm::vec3(0.0, 0.0, 96.0));
+
+                Brush* brush = builder.createBrush(points, "texture");
+                world.defaultLayer()->addChild(brush);
+                brushes.push_back(brush);
+            }
+            return brushes;
+        }
+
+        TEST(VertexDragBenchmark, dragVertices) {
+            const vm::bbox3 worldBounds(8192.0);
+            World world(MapFormat::Standard, nullptr, worldBounds);
+            const auto brushes = createBrushes(world, worldBounds);
+
+            // drag the top corner vertex of every brush outwards; only the first step changes the topology
+            std::vector<std::vector<vm::vec3>> vertices;
+            for (const Brush* brush : brushes) {
+                vertices.push_back({ brush->bounds().max });
+            }
+
+            const vm::vec3 delta(1.0, 1.0, 1.0);
+            timeLambda([&]() {
+                for (size_t step = 0; step < NumDragSteps; ++step) {
+                    for (size_t i = 0; i < brushes.size(); ++i) {
+                        ASSERT_TRUE(brushes[i]->canMoveVertices(worldBounds, vertices[i], delta));
+                        vertices[i] = brushes[i]->moveVertices(worldBounds, vertices[i], delta);
+                    }
+                }
+            }, "drag one vertex of " + std::to_string(brushes.size()) + " brushes in " + std::to_string(NumDragSteps) + " steps");
+
+            for (const Brush* brush : brushes) {
+                ASSERT_EQ(9u, brush->faceCount());
+            }
+        }
+
+        TEST(VertexDragBenchmark, dragVerticesOfDetailedBrushes) {
+            const vm::bbox3 worldBounds(8192.0);
+            World world(MapFormat::Standard, nullptr, worldBounds);
+            const auto brushes = createCones(world, worldBounds);
+
+            // drag the apex of every cone upwards, which never changes the topology, so the geometry of these brushes
+            // with many faces never has to be rebuilt
+            std::vector<std::vector<vm::vec3>> vertices;
+            std::vector<size_t> faceCounts;
+            for (const Brush* brush : brushes) {
+                vertices.push_back({ vm::vec3(brush->bounds().center().x(), brush->bounds().center().y(), brush->bounds().max.z()) });
+                faceCounts.push_back(brush->faceCount());
+            }
+
+            const vm::vec3 delta(0.0, 0.0, 1.0);
+            timeLambda([&]() {
+                for (size_t step = 0; step < NumDragSteps; ++step) {
+                    for (size_t i = 0; i < brushes.size(); ++i) {
+                        ASSERT_TRUE(brushes[i]->canMoveVertices(worldBounds, vertices[i], delta));
+                        vertices[i] = brushes[i]->moveVertices(worldBounds, vertices[i], delta);
+                    }
+                }
+            }, "drag the apex of " + std::to_string(brushes.size()) + " cones in " + std::to_string(NumDragSteps) + " steps");
+
+            for (size_t i = 0; i < brushes.size(); ++i) {
+                ASSERT_EQ(faceCounts[i], brushes[i]->faceCount());
+            }
+        }
+
+        TEST(VertexDragBenchmark, dragFaces) {
+            const vm::bbox3 worldBounds(8192.0);
+            World world(MapFormat::Standard, nullptr, worldBounds);
+            const auto brushes = createBrushes(world, worldBounds);
+
+            // drag the top face of every brush diagonally, which never changes the topology
+            std::vector<std::vector<vm::polygon3>> faces;
+            for (const Brush* brush : brushes) {
+                const auto& bounds = brush->bounds();
+                faces.push_back({ vm::polygon3({
+                    vm::vec3(bounds.min.x(), bounds.min.y(), bounds.max.z()),
+                    vm::vec3(bounds.max.x(), bounds.min.y(), bounds.max.z()),
+                    vm::vec3(bounds.max.x(), bounds.max.y(), bounds.max.z()),
+                    vm::vec3(bounds.min.x(), bounds.max.y(), bounds.max.z())
+                }) });
+            }
+
+            const vm::vec3 delta(1.0, 0.0, 1.0);
+            timeLambda([&]() {
+                for (size_t step = 0; step < NumDragSteps; ++step) {
+                    for (size_t i = 0; i < brushes.size(); ++i) {
+                        ASSERT_TRUE(brushes[i]->canMoveFaces(worldBounds, faces[i], delta));
+                        faces[i] = brushes[i]->moveFaces(worldBounds, faces[i], delta);
+                    }
+                }
+            }, "drag one face of " + std::to_string(brushes.size()) + " brushes in " + std::to_string(NumDragSteps) + " steps");
+
+            for (const Brush* brush : brushes) {
+                ASSERT_EQ(6u, brush->faceCount());
+            }
+        }
+    }
+}
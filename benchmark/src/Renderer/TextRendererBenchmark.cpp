@@ -0,0 +1,192 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "AttrString.h"
+#include "BenchmarkUtils.h"
+#include "Color.h"
+#include "Renderer/FontGlyph.h"
+#include "Renderer/FontTexture.h"
+#include "Renderer/RenderUtils.h"
+#include "Renderer/TextureFont.h"
+#include "Renderer/VertexSpec.h"
+
+#include <vecmath/forward.h>
+#include <vecmath/vec.h>
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        static constexpr size_t NumEntities = 5000;
+        static constexpr size_t NumFrames = 200;
+        static constexpr float WorldSize = 4096.0f;
+        static constexpr float MaxViewDistance = 768.0f;
+        static constexpr float CornerRadius = 3.0f;
+        static constexpr size_t CornerSegments = 3;
+
+        static const vm::vec2f Inset(4.0f, 4.0f);
+
+        struct Label {
+            vm::vec3f position;
+            AttrString string;
+        };
+
+        static std::unique_ptr<TextureFont> createFont() {
+            // a font with fixed size glyphs, laid out like FreeTypeFontFactory would
+            const unsigned char firstChar = 32;
+            const unsigned char charCount = 96;
+            auto* texture = new FontTexture(charCount, 16, 3);
+
+            FontGlyph::List glyphs;
+            for (size_t i = 0; i < charCount; ++i)
+                glyphs.push_back(FontGlyph((i % 10) * 19, (i / 10) * 19, 8, 14, 7 + i % 3));
+            return std::make_unique<TextureFont>(texture, glyphs, 14, firstChar, charCount);
+        }
+
+        static std::vector<Label> createLabels() {
+            static const char* classnames[] = { "light", "info_player_start", "monster_army", "item_shells", "func_door", "trigger_once", "path_corner", "weapon_nailgun" };
+
+            std::mt19937 random(0);
+            std::uniform_real_distribution<float> coord(0.0f, WorldSize);
+
+            std::vector<Label> labels;
+            for (size_t i = 0; i < NumEntities; ++i) {
+                const String classname = classnames[random() % 8];
+                const String string = random() % 4 == 0 ? classname + " (" + std::to_string(i % 200) + ")" : classname;
+                labels.push_back(Label { vm::vec3f(coord(random), coord(random), coord(random) / 8.0f), AttrString(string) });
+            }
+            return labels;
+        }
+
+        static vm::vec3f cameraPosition(const size_t frame) {
+            // fly diagonally through the map
+            const float t = static_cast<float>(frame) / static_cast<float>(NumFrames);
+            return vm::vec3f(t * WorldSize, t * WorldSize, 128.0f);
+        }
+
+        TEST(TextRendererBenchmark, renderEntityLabels) {
+            const std::vector<Label> labels = createLabels();
+            typedef VertexSpecs::P3T2C4::Vertex TextVertex;
+            typedef VertexSpecs::P3C4::Vertex RectVertex;
+            const Color color(1.0f, 1.0f, 1.0f, 1.0f);
+
+            // the previous TextRenderer: lay out and measure every string before culling it, build a new rounded
+            // rectangle per string and upload text and backgrounds in separate arrays
+            size_t layoutsBefore = 0;
+            size_t uploadsBefore = 0;
+            size_t verticesBefore = 0;
+            auto font = createFont();
+            timeLambda([&]() {
+                for (size_t frame = 0; frame < NumFrames; ++frame) {
+                    const vm::vec3f camera = cameraPosition(frame);
+
+                    TextVertex::List textVertices;
+                    RectVertex::List rectVertices;
+                    for (const Label& label : labels) {
+                        const vm::vec2f size = round(font->measure(label.string));
+                        ++layoutsBefore;
+                        if (distance(camera, label.position) > MaxViewDistance)
+                            continue;
+
+                        const std::vector<vm::vec2f> quads = font->quads(label.string, true);
+                        const vm::vec2f stringSize = font->measure(label.string);
+                        const vm::vec2f offset = label.position.xy() - camera.xy() - size / 2.0f;
+                        for (size_t i = 0; i < quads.size() / 2; ++i)
+                            textVertices.push_back(TextVertex(vm::vec3f(quads[2 * i] + offset, 0.0f), quads[2 * i + 1], color));
+
+                        const std::vector<vm::vec2f> rect = roundedRect2D(stringSize + 2.0f * Inset, CornerRadius, CornerSegments);
+                        for (const vm::vec2f& vertex : rect)
+                            rectVertices.push_back(RectVertex(vm::vec3f(vertex + offset + stringSize / 2.0f, 0.0f), color));
+                    }
+
+                    uploadsBefore += 2;
+                    verticesBefore += textVertices.size() + rectVertices.size();
+                }
+            }, "render labels, layout per frame");
+
+            // mirrors TextRenderer: cull by distance first, reuse the cached runs, derive the backgrounds from a
+            // template rectangle and put everything into one vertex array
+            size_t layoutsAfter = 0;
+            size_t cacheHits = 0;
+            size_t culled = 0;
+            size_t uploadsAfter = 0;
+            size_t verticesAfter = 0;
+            font = createFont();
+
+            const RoundedRect2DTemplate rectTemplate(CornerRadius, CornerSegments);
+
+            timeLambda([&]() {
+                for (size_t frame = 0; frame < NumFrames; ++frame) {
+                    const vm::vec3f camera = cameraPosition(frame);
+
+                    std::vector<std::pair<TextureFont::RunPtr, vm::vec2f>> entries;
+                    for (const Label& label : labels) {
+                        if (distance(camera, label.position) > MaxViewDistance) {
+                            ++culled;
+                            continue;
+                        }
+
+                        const size_t cachedRunCount = font->cachedRunCount();
+                        TextureFont::RunPtr run = font->run(label.string);
+                        if (font->cachedRunCount() == cachedRunCount)
+                            ++cacheHits;
+                        else
+                            ++layoutsAfter;
+
+                        const vm::vec2f offset = label.position.xy() - camera.xy() - round(run->size) / 2.0f;
+                        entries.push_back(std::make_pair(std::move(run), offset));
+                    }
+
+                    TextVertex::List vertices;
+                    for (const auto& entry : entries) {
+                        const vm::vec2f& stringSize = entry.first->size;
+                        const vm::vec2f center = entry.second + stringSize / 2.0f;
+                        const vm::vec2f rectSize = stringSize + 2.0f * Inset;
+                        for (size_t i = 0; i < rectTemplate.vertexCount(); ++i)
+                            vertices.push_back(TextVertex(vm::vec3f(center + rectTemplate.vertex(i, rectSize), 0.0f), vm::vec2f::zero, color));
+                    }
+                    for (const auto& entry : entries) {
+                        const std::vector<vm::vec2f>& quads = entry.first->vertices;
+                        for (size_t i = 0; i < quads.size() / 2; ++i)
+                            vertices.push_back(TextVertex(vm::vec3f(quads[2 * i] + entry.second, 0.0f), quads[2 * i + 1], color));
+                    }
+
+                    ++uploadsAfter;
+                    verticesAfter += vertices.size();
+                }
+            }, "render labels, cached runs");
+
+            printf("Frames: %zu, labels: %zu\n", NumFrames, NumEntities);
+            printf("Layouts per frame before: %f, after: %f\n", static_cast<double>(layoutsBefore) / NumFrames, static_cast<double>(layoutsAfter) / NumFrames);
+            printf("Culled per frame: %f, run cache hits per frame: %f, cached runs: %zu\n", static_cast<double>(culled) / NumFrames, static_cast<double>(cacheHits) / NumFrames, font->cachedRunCount());
+            printf("Vertex uploads per frame before: %f, after: %f\n", static_cast<double>(uploadsBefore) / NumFrames, static_cast<double>(uploadsAfter) / NumFrames);
+
+            ASSERT_EQ(verticesBefore, verticesAfter);
+            ASSERT_LT(layoutsAfter, layoutsBefore);
+        }
+    }
+}
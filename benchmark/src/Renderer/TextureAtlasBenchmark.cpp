@@ -0,0 +1,142 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "Renderer/TextureAtlas.h"
+#include "View/CellLayout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        static constexpr size_t NumTextures = 10000;
+        static constexpr float ViewWidth = 400.0f;
+        static constexpr float ViewHeight = 800.0f;
+        static constexpr float ScrollStep = 40.0f;
+
+        struct BrowserTexture {
+            size_t width;
+            size_t height;
+            size_t mipLevelCount;
+            bool overridden;
+        };
+
+        typedef View::CellLayout<const BrowserTexture*, int> Layout;
+
+        TEST(TextureAtlasBenchmark, scrollTextureBrowser) {
+            static const size_t sizes[] = { 32, 64, 64, 64, 128, 256 };
+
+            std::mt19937 random(0);
+            std::vector<BrowserTexture> textures;
+            for (size_t i = 0; i < NumTextures; ++i) {
+                const size_t width = sizes[random() % 6];
+                const size_t height = sizes[random() % 6];
+                textures.push_back(BrowserTexture { width, height, 4, random() % 50 == 0 });
+            }
+
+            Layout layout;
+            layout.setWidth(ViewWidth);
+            layout.setOuterMargin(5.0f);
+            layout.setGroupMargin(5.0f);
+            layout.setRowMargin(5.0f);
+            layout.setCellMargin(5.0f);
+            layout.setTitleMargin(2.0f);
+            layout.setCellWidth(64.0f, 64.0f);
+            layout.setCellHeight(64.0f, 128.0f);
+            for (const BrowserTexture& texture : textures)
+                layout.addItem(&texture, static_cast<float>(texture.width), static_cast<float>(texture.height), 60.0f, 12.0f);
+
+            // mirrors TextureBrowserView::renderTextures without the GL calls
+            TextureAtlas atlas(2048, 4);
+            std::map<const BrowserTexture*, TextureAtlas::Region> regions;
+            size_t atlasGeneration = atlas.generation();
+
+            size_t frameCount = 0;
+            size_t cellCount = 0;
+            size_t drawCallCount = 0;
+            size_t maxDrawCalls = 0;
+            double maxFrameTime = 0.0;
+
+            timeLambda([&]() {
+                for (float y = 0.0f; y < layout.height(); y += ScrollStep) {
+                    const auto start = std::chrono::high_resolution_clock::now();
+
+                    std::map<std::pair<size_t, bool>, std::vector<vm::vec2f>> batches;
+                    for (size_t i = 0; i < layout.size(); ++i) {
+                        const Layout::Group& group = layout[i];
+                        const auto rows = group.rowsIntersectingY(y, ViewHeight);
+                        for (size_t j = rows.first; j < rows.second; ++j) {
+                            const Layout::Group::Row& row = group[j];
+                            for (size_t k = 0; k < row.size(); ++k) {
+                                const Layout::Group::Row::Cell& cell = row[k];
+                                const BrowserTexture* texture = cell.item();
+                                const View::LayoutBounds& bounds = cell.itemBounds();
+
+                                if (atlas.generation() != atlasGeneration) {
+                                    regions.clear();
+                                    atlasGeneration = atlas.generation();
+                                }
+
+                                auto it = regions.find(texture);
+                                if (it == std::end(regions)) {
+                                    const size_t minWidth = static_cast<size_t>(std::ceil(bounds.width()));
+                                    const size_t minHeight = static_cast<size_t>(std::ceil(bounds.height()));
+                                    const size_t level = TextureAtlas::mipLevel(texture->width, texture->height, texture->mipLevelCount, minWidth, minHeight);
+
+                                    TextureAtlas::Region region;
+                                    ASSERT_TRUE(atlas.allocate(texture->width >> level, texture->height >> level, region));
+                                    it = regions.insert(std::make_pair(texture, region)).first;
+                                }
+
+                                auto& vertices = batches[std::make_pair(it->second.page, texture->overridden)];
+                                vertices.push_back(vm::vec2f(bounds.left(), bounds.top()));
+                                vertices.push_back(it->second.texCoordsMin);
+                                vertices.push_back(vm::vec2f(bounds.right(), bounds.bottom()));
+                                vertices.push_back(it->second.texCoordsMax);
+                                ++cellCount;
+                            }
+                        }
+                    }
+
+                    const auto end = std::chrono::high_resolution_clock::now();
+                    maxFrameTime = std::max(maxFrameTime, std::chrono::duration<double>(end - start).count() * 1000.0);
+
+                    ++frameCount;
+                    drawCallCount += batches.size();
+                    maxDrawCalls = std::max(maxDrawCalls, batches.size());
+                }
+            }, "scroll through " + std::to_string(NumTextures) + " textures");
+
+            printf("Frames: %zu, slowest frame: %fms\n", frameCount, maxFrameTime);
+            printf("Draw calls per frame with one draw per cell: %f\n", static_cast<double>(cellCount) / static_cast<double>(frameCount));
+            printf("Draw calls per frame with the atlas: %f (at most %zu)\n", static_cast<double>(drawCallCount) / static_cast<double>(frameCount), maxDrawCalls);
+            printf("Atlas pages: %zu, atlas generation: %zu\n", atlas.pageCount(), atlas.generation());
+
+            ASSERT_LT(drawCallCount, cellCount);
+        }
+    }
+}
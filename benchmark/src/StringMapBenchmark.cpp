@@ -0,0 +1,84 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "AllocationCounter.h"
+#include "BenchmarkUtils.h"
+#include "StringMap.h"
+
+#include <string>
+
+namespace TrenchBroom {
+    typedef StringMap<size_t, StringMultiMapValueContainer<size_t>> EntityIndex;
+
+    static constexpr size_t NumEntities = 30000;
+
+    static EntityIndex::KeyValueList makeAttributes(const bool names) {
+        // the attributes of a large map: a few common names with many distinct values, plus numbered targets
+        static const String Classnames[] = { "light", "info_player_deathmatch", "func_door", "trigger_multiple", "monster_army" };
+
+        EntityIndex::KeyValueList result;
+        for (size_t i = 0; i < NumEntities; ++i) {
+            result.emplace_back(names ? "classname" : Classnames[i % 5], i);
+            result.emplace_back(names ? "origin" : std::to_string(i) + " 128 -64", i);
+            result.emplace_back(names ? "spawnflags" : std::to_string(i % 8), i);
+            if (i % 3 == 0) {
+                result.emplace_back(names ? "targetname" : "t" + std::to_string(i / 3), i);
+                result.emplace_back(names ? "target" + std::to_string(i % 4) : "t" + std::to_string(i / 3 + 1), i);
+            }
+        }
+        return result;
+    }
+
+    TEST(StringMapBenchmark, buildAttributeIndex) {
+        const EntityIndex::KeyValueList names = makeAttributes(true);
+        const EntityIndex::KeyValueList values = makeAttributes(false);
+        const String description = std::to_string(names.size()) + " attributes of " + std::to_string(NumEntities) + " entities";
+
+        EntityIndex incrementalNames, incrementalValues;
+        countAllocations([&]() {
+            timeLambda([&]() {
+                for (const auto& keyValue : names)
+                    incrementalNames.insert(keyValue.first, keyValue.second);
+                for (const auto& keyValue : values)
+                    incrementalValues.insert(keyValue.first, keyValue.second);
+            }, "insert " + description + " one by one");
+        }, "insert " + description + " one by one");
+
+        EntityIndex bulkNames, bulkValues;
+        countAllocations([&]() {
+            timeLambda([&]() {
+                bulkNames.insert(names);
+                bulkValues.insert(values);
+            }, "insert " + description + " in bulk");
+        }, "insert " + description + " in bulk");
+
+        size_t found = 0;
+        timeLambda([&]() {
+            for (size_t i = 0; i < NumEntities; ++i)
+                found += bulkValues.queryExactMatches("t" + std::to_string(i)).size();
+        }, "query values of " + description);
+
+        ASSERT_EQ(incrementalNames.queryNumberedMatches("target"), bulkNames.queryNumberedMatches("target"));
+        ASSERT_EQ(incrementalValues.queryPrefixMatches("t1"), bulkValues.queryPrefixMatches("t1"));
+        ASSERT_LT(0u, found);
+    }
+}
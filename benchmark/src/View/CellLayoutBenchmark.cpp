@@ -0,0 +1,160 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "StringUtils.h"
+#include "View/CellLayout.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace View {
+        static constexpr size_t NumTextures = 10000;
+        static constexpr float ViewWidth = 400.0f;
+        static constexpr float ViewHeight = 800.0f;
+
+        struct BrowserTexture {
+            String name;
+            String lowercaseName;
+            float width;
+            float height;
+        };
+
+        typedef std::vector<const BrowserTexture*> BrowserTextureList;
+        typedef CellLayout<const BrowserTexture*, String> Layout;
+
+        static std::vector<BrowserTexture> createTextures() {
+            static const StringList prefixes = { "Metal", "Tech", "Wood", "Stone", "Brick", "Sky", "Water", "Lava", "Floor", "Wall", "Door", "Light", "Trim", "Crate", "Rock", "Base" };
+            static const float sizes[] = { 32.0f, 64.0f, 64.0f, 64.0f, 128.0f };
+
+            std::mt19937 random(0);
+            std::vector<BrowserTexture> textures;
+            textures.reserve(NumTextures);
+            for (size_t i = 0; i < NumTextures; ++i) {
+                String name = prefixes[random() % prefixes.size()] + "_";
+                for (size_t j = 0; j < 4; ++j)
+                    name += static_cast<char>('a' + random() % 26);
+                name += std::to_string(i);
+
+                const float size = sizes[random() % 5];
+                textures.push_back(BrowserTexture { name, StringUtils::toLower(name), size, size });
+            }
+            return textures;
+        }
+
+        static void initLayout(Layout& layout) {
+            layout.setWidth(ViewWidth);
+            layout.setOuterMargin(5.0f);
+            layout.setGroupMargin(5.0f);
+            layout.setRowMargin(5.0f);
+            layout.setCellMargin(5.0f);
+            layout.setTitleMargin(2.0f);
+            layout.setCellWidth(64.0f, 64.0f);
+            layout.setCellHeight(64.0f, 128.0f);
+        }
+
+        static size_t buildLayout(Layout& layout, const BrowserTextureList& textures, const bool visibleRowsOnly) {
+            layout.clear();
+            for (const BrowserTexture* texture : textures)
+                layout.addItem(texture, texture->width, texture->height, 8.0f * static_cast<float>(texture->name.size()), 12.0f);
+
+            // what rendering the first frame after the keystroke touches
+            size_t cellCount = 0;
+            for (size_t i = 0; i < layout.size(); ++i) {
+                const Layout::Group& group = layout[i];
+                const auto rows = visibleRowsOnly ? group.rowsIntersectingY(0.0f, ViewHeight) : std::make_pair(size_t(0), group.size());
+                for (size_t j = rows.first; j < rows.second; ++j) {
+                    const Layout::Group::Row& row = group[j];
+                    if (row.intersectsY(0.0f, ViewHeight))
+                        cellCount += row.size();
+                }
+            }
+            return cellCount;
+        }
+
+        TEST(CellLayoutBenchmark, typeFilterText) {
+            const std::vector<BrowserTexture> textures = createTextures();
+
+            BrowserTextureList sortedTextures;
+            for (const BrowserTexture& texture : textures)
+                sortedTextures.push_back(&texture);
+            std::sort(std::begin(sortedTextures), std::end(sortedTextures), [](const BrowserTexture* lhs, const BrowserTexture* rhs) {
+                return lhs->lowercaseName < rhs->lowercaseName;
+            });
+
+            // type "metal_b", then delete it again
+            StringList filters;
+            const String typed = "metal_b";
+            for (size_t i = 0; i <= typed.size(); ++i)
+                filters.push_back(typed.substr(0, i));
+            for (size_t i = typed.size(); i > 0; --i)
+                filters.push_back(typed.substr(0, i - 1));
+
+            Layout layout;
+            initLayout(layout);
+
+            size_t eagerCells = 0;
+            timeLambda([&]() {
+                for (const String& filter : filters) {
+                    BrowserTextureList filtered;
+                    for (const BrowserTexture& texture : textures) {
+                        if (StringUtils::containsCaseInsensitive(texture.name, filter))
+                            filtered.push_back(&texture);
+                    }
+                    std::sort(std::begin(filtered), std::end(filtered), [](const BrowserTexture* lhs, const BrowserTexture* rhs) {
+                        return StringUtils::CaseInsensitiveStringLess()(lhs->name, rhs->name);
+                    });
+                    eagerCells += buildLayout(layout, filtered, false);
+                }
+            }, std::to_string(filters.size()) + " keystrokes, sorting and laying out all rows");
+
+            size_t visibleCells = 0;
+            timeLambda([&]() {
+                for (const String& filter : filters) {
+                    BrowserTextureList filtered;
+                    filtered.reserve(sortedTextures.size());
+                    for (const BrowserTexture* texture : sortedTextures) {
+                        if (texture->lowercaseName.find(filter) != String::npos)
+                            filtered.push_back(texture);
+                    }
+                    visibleCells += buildLayout(layout, filtered, true);
+                }
+            }, std::to_string(filters.size()) + " keystrokes, filtering the name index and laying out visible rows");
+
+            for (const String& filter : filters) {
+                BrowserTextureList filtered;
+                for (const BrowserTexture* texture : sortedTextures) {
+                    if (texture->lowercaseName.find(filter) != String::npos)
+                        filtered.push_back(texture);
+                }
+                timeLambda([&]() {
+                    buildLayout(layout, filtered, true);
+                }, "layout for '" + filter + "' (" + std::to_string(filtered.size()) + " textures)");
+            }
+
+            ASSERT_EQ(eagerCells, visibleCells);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/MapFormat.h"
+#include "Model/NodeCollection.h"
+#include "Model/TestGame.h"
+#include "Model/World.h"
+#include "View/MapDocument.h"
+#include "View/MapDocumentCommandFacade.h"
+
+#include <vecmath/bbox.h>
+#include <vecmath/vec.h>
+
+#include <cstdio>
+#include <string>
+
+namespace TrenchBroom {
+    namespace View {
+        static constexpr size_t RegionSizeX = 40;
+        static constexpr size_t RegionSizeY = 25;
+        static constexpr size_t RegionSizeZ = 20;
+        static constexpr size_t NumCutterBrushes = 200;
+        static constexpr FloatType CellSize = 32.0;
+
+        TEST(CsgBenchmark, benchSubtract) {
+            auto document = MapDocumentCommandFacade::newMapDocument();
+            document->newDocument(Model::MapFormat::Standard, vm::bbox3(8192.0), Model::GameSPtr(new Model::TestGame()));
+            Model::BrushBuilder builder(document->world(), document->worldBounds());
+
+            // a block of 20k cubes
+            Model::NodeList region;
+            for (size_t x = 0; x < RegionSizeX; ++x) {
+                for (size_t y = 0; y < RegionSizeY; ++y) {
+                    for (size_t z = 0; z < RegionSizeZ; ++z) {
+                        const auto min = vm::vec3(static_cast<FloatType>(x), static_cast<FloatType>(y), static_cast<FloatType>(z)) * CellSize;
+                        region.push_back(builder.createCuboid(vm::bbox3(min, min + vm::vec3(CellSize, CellSize, CellSize)), "region"));
+                    }
+                }
+            }
+
+            // a cutter made of vertical columns that reach through the entire region
+            Model::NodeList cutter;
+            for (size_t i = 0; i < NumCutterBrushes; ++i) {
+                const auto x = 16.0 + static_cast<FloatType>(i % 20) * 64.0;
+                const auto y = 16.0 + static_cast<FloatType>(i / 20) * 80.0;
+                const auto bounds = vm::bbox3(vm::vec3(x, y, -16.0), vm::vec3(x + 24.0, y + 24.0, static_cast<FloatType>(RegionSizeZ) * CellSize + 16.0));
+                cutter.push_back(builder.createCuboid(bounds, "cutter"));
+            }
+
+            document->addNodes(region, document->currentParent());
+            document->addNodes(cutter, document->currentParent());
+            document->select(region);
+
+            // subtract one column at a time, the remaining region and the fragments stay selected and the column that
+            // is selected last is the subtrahend
+            timeLambda([&]() {
+                for (Model::Node* column : cutter) {
+                    document->select(column);
+                    ASSERT_TRUE(document->csgSubtract());
+                }
+            }, "subtract " + std::to_string(cutter.size()) + " cutter brushes from " + std::to_string(region.size()) + " selected brushes");
+
+            printf("Subtraction left %zu selected brushes\n", document->selectedNodes().brushCount());
+            ASSERT_LT(region.size(), document->selectedNodes().brushCount());
+        }
+    }
+}
@@ -0,0 +1,186 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "BenchmarkUtils.h"
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/Layer.h"
+#include "Model/MapFormat.h"
+#include "Model/PickResult.h"
+#include "Model/World.h"
+#include "Renderer/PerspectiveCamera.h"
+#include "View/VertexHandleManager.h"
+
+#include <vecmath/constants.h>
+#include <vecmath/vec.h>
+#include <vecmath/ray.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace View {
+        static constexpr size_t GridWidth = 100;
+        static constexpr size_t GridDepth = 100;
+        static constexpr size_t GridHeight = 20;
+        static constexpr size_t NumPicks = 1000;
+        static constexpr size_t NumBrushes = 1000;
+        static constexpr size_t NumDragSteps = 10;
+
+        TEST(VertexHandleManagerBenchmark, hoverPick) {
+            VertexHandleManager manager;
+            timeLambda([&]() {
+                for (size_t x = 0; x < GridWidth; ++x) {
+                    for (size_t y = 0; y < GridDepth; ++y) {
+                        for (size_t z = 0; z < GridHeight; ++z) {
+                            manager.add(vm::vec3(static_cast<FloatType>(x) * 16.0, static_cast<FloatType>(y) * 16.0, static_cast<FloatType>(z) * 16.0));
+                        }
+                    }
+                }
+            }, "add 200k handles");
+            ASSERT_EQ(GridWidth * GridDepth * GridHeight, manager.allHandles().size());
+
+            const Renderer::Camera::Viewport viewport(0, 0, 1024, 768);
+            const Renderer::PerspectiveCamera camera(90.0f, 1.0f, 8192.0f, viewport, vm::vec3f(-256.0f, -256.0f, 512.0f), vm::normalize(vm::vec3f(1.0f, 1.0f, -0.5f)), vm::vec3f::pos_z);
+
+            size_t hitCount = 0;
+            timeLambda([&]() {
+                // simulate the mouse moving diagonally across the viewport
+                for (size_t i = 0; i < NumPicks; ++i) {
+                    const auto x = static_cast<int>(i * 1024 / NumPicks);
+                    const auto y = static_cast<int>(i * 768 / NumPicks);
+
+                    Model::PickResult pickResult;
+                    manager.pick(vm::ray3(camera.pickRay(x, y)), camera, pickResult);
+                    hitCount += pickResult.size();
+                }
+            }, "pick 200k handles 1000 times");
+            ASSERT_LT(0u, hitCount);
+        }
+
+        static Model::BrushList createBrushes(Model::World& world, const vm::bbox3& worldBounds) {
+            Model::BrushBuilder builder(&world, worldBounds);
+
+            // 16 sided cylinders, so that moving a vertex only changes some of a brush's handles
+            std::vector<vm::vec3> points;
+            for (size_t i = 0; i < 16; ++i) {
+                const auto angle = static_cast<FloatType>(i) * vm::C::twoPi() / 16.0;
+                const auto x = std::round(std::cos(angle) * 32.0);
+                const auto y = std::round(std::sin(angle) * 32.0);
+                points.emplace_back(x, y, 0.0);
+                points.emplace_back(x, y, 64.0);
+            }
+
+            Model::BrushList brushes;
+            for (size_t i = 0; i < NumBrushes; ++i) {
+                const auto offset = vm::vec3(static_cast<FloatType>(i % 32), static_cast<FloatType>(i / 32), 0.0) * 128.0;
+
+                std::vector<vm::vec3> brushPoints;
+                for (const auto& point : points) {
+                    brushPoints.push_back(point + offset);
+                }
+
+                Model::Brush* brush = builder.createBrush(brushPoints, "texture");
+                world.defaultLayer()->addChild(brush);
+                brushes.push_back(brush);
+            }
+            return brushes;
+        }
+
+        template <typename U>
+        static void dragVertices(const std::string& message, const U& updateHandles) {
+            const vm::bbox3 worldBounds(8192.0);
+            Model::World world(Model::MapFormat::Standard, nullptr, worldBounds);
+            const auto brushes = createBrushes(world, worldBounds);
+
+            VertexHandleManager vertexHandles;
+            EdgeHandleManager edgeHandles;
+            FaceHandleManager faceHandles;
+            vertexHandles.addHandles(std::begin(brushes), std::end(brushes));
+            edgeHandles.addHandles(std::begin(brushes), std::end(brushes));
+            faceHandles.addHandles(std::begin(brushes), std::end(brushes));
+
+            // drag one top vertex of every brush outwards in the same way as VertexToolBase does
+            std::vector<std::vector<vm::vec3>> vertices;
+            for (const Model::Brush* brush : brushes) {
+                vertices.push_back({ vm::vec3(brush->bounds().max.x(), brush->bounds().center().y(), brush->bounds().max.z()) });
+            }
+
+            // only the time spent updating the handles is measured, not the time spent moving the vertices
+            using Clock = std::chrono::high_resolution_clock;
+            Clock::duration elapsed(0);
+
+            const vm::vec3 delta(1.0, 0.0, 0.0);
+            for (size_t step = 0; step < NumDragSteps; ++step) {
+                for (size_t i = 0; i < brushes.size(); ++i) {
+                    auto start = Clock::now();
+                    updateHandles(vertexHandles, edgeHandles, faceHandles, brushes[i], [&]() {
+                        elapsed += Clock::now() - start;
+                        vertices[i] = brushes[i]->moveVertices(worldBounds, vertices[i], delta);
+                        start = Clock::now();
+                    });
+                    elapsed += Clock::now() - start;
+                }
+            }
+
+            printf("Time elapsed for '%s': %fms (%fms per drag step)\n", message.c_str(),
+                   std::chrono::duration<double>(elapsed).count() * 1000.0,
+                   std::chrono::duration<double>(elapsed).count() * 1000.0 / static_cast<double>(NumDragSteps));
+
+            size_t vertexCount = 0, edgeCount = 0, faceCount = 0;
+            for (const Model::Brush* brush : brushes) {
+                vertexCount += brush->vertexCount();
+                edgeCount += brush->edgeCount();
+                faceCount += brush->faceCount();
+            }
+            ASSERT_EQ(vertexCount, vertexHandles.allHandles().size());
+            ASSERT_EQ(edgeCount, edgeHandles.allHandles().size());
+            ASSERT_EQ(faceCount, faceHandles.allHandles().size());
+        }
+
+        TEST(VertexHandleManagerBenchmark, dragVerticesReplacingHandles) {
+            dragVertices("drag vertices, replacing all handles of each brush", [](auto& vertexHandles, auto& edgeHandles, auto& faceHandles, const Model::Brush* brush, const auto& move) {
+                vertexHandles.removeHandles(brush);
+                edgeHandles.removeHandles(brush);
+                faceHandles.removeHandles(brush);
+                move();
+                vertexHandles.addHandles(brush);
+                edgeHandles.addHandles(brush);
+                faceHandles.addHandles(brush);
+            });
+        }
+
+        TEST(VertexHandleManagerBenchmark, dragVerticesUpdatingHandles) {
+            dragVertices("drag vertices, updating the changed handles of each brush", [](auto& vertexHandles, auto& edgeHandles, auto& faceHandles, const Model::Brush* brush, const auto& move) {
+                vertexHandles.beginUpdateHandles(brush);
+                edgeHandles.beginUpdateHandles(brush);
+                faceHandles.beginUpdateHandles(brush);
+                move();
+                vertexHandles.endUpdateHandles(brush);
+                edgeHandles.endUpdateHandles(brush);
+                faceHandles.endUpdateHandles(brush);
+            });
+        }
+    }
+}
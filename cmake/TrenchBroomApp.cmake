@@ -100,7 +100,7 @@ IF(COMPILER_IS_GNU AND TB_ENABLE_ASAN)
     TARGET_LINK_LIBRARIES(TrenchBroom asan)
 ENDIF()
 
-TARGET_LINK_LIBRARIES(TrenchBroom glew ${wxWidgets_LIBRARIES} ${FREETYPE_LIBRARIES} ${FREEIMAGE_LIBRARIES} vecmath)
+TARGET_LINK_LIBRARIES(TrenchBroom glew ${wxWidgets_LIBRARIES} ${FREETYPE_LIBRARIES} ${FREEIMAGE_LIBRARIES} vecmath Threads::Threads)
 IF (COMPILER_IS_MSVC)
     TARGET_LINK_LIBRARIES(TrenchBroom stackwalker)
 ENDIF()
@@ -10,6 +10,14 @@ FILE(GLOB_RECURSE BENCHMARK_SOURCE
 	"${BENCHMARK_SOURCE_DIR}/*.cpp"	
 )
 
+# Benchmarks that operate on a map document need a game
+LIST(APPEND BENCHMARK_SOURCE
+    "${TEST_SOURCE_DIR}/IO/TestParserStatus.h"
+    "${TEST_SOURCE_DIR}/IO/TestParserStatus.cpp"
+    "${TEST_SOURCE_DIR}/Model/TestGame.h"
+    "${TEST_SOURCE_DIR}/Model/TestGame.cpp"
+)
+
 get_target_property(common_TYPE common TYPE)
 IF(common_TYPE STREQUAL "OBJECT_LIBRARY")
 	ADD_EXECUTABLE(TrenchBroom-Test ${TEST_SOURCE} $<TARGET_OBJECTS:common>)
@@ -28,9 +36,10 @@ ENDIF()
 
 ADD_TARGET_PROPERTY(TrenchBroom-Test INCLUDE_DIRECTORIES "${TEST_SOURCE_DIR}")
 ADD_TARGET_PROPERTY(TrenchBroom-Benchmark INCLUDE_DIRECTORIES "${BENCHMARK_SOURCE_DIR}")
+ADD_TARGET_PROPERTY(TrenchBroom-Benchmark INCLUDE_DIRECTORIES "${TEST_SOURCE_DIR}")
 
-TARGET_LINK_LIBRARIES(TrenchBroom-Test glew gtest gmock ${wxWidgets_LIBRARIES} ${FREETYPE_LIBRARIES} ${FREEIMAGE_LIBRARIES} vecmath)
-TARGET_LINK_LIBRARIES(TrenchBroom-Benchmark glew gtest gmock ${wxWidgets_LIBRARIES} ${FREETYPE_LIBRARIES} ${FREEIMAGE_LIBRARIES} vecmath)
+TARGET_LINK_LIBRARIES(TrenchBroom-Test glew gtest gmock ${wxWidgets_LIBRARIES} ${FREETYPE_LIBRARIES} ${FREEIMAGE_LIBRARIES} vecmath Threads::Threads)
+TARGET_LINK_LIBRARIES(TrenchBroom-Benchmark glew gtest gmock ${wxWidgets_LIBRARIES} ${FREETYPE_LIBRARIES} ${FREEIMAGE_LIBRARIES} vecmath Threads::Threads)
 
 SET_TARGET_PROPERTIES(TrenchBroom-Test PROPERTIES COMPILE_DEFINITIONS "GLEW_STATIC")
 SET_TARGET_PROPERTIES(TrenchBroom-Benchmark PROPERTIES COMPILE_DEFINITIONS "GLEW_STATIC")
@@ -24,6 +24,7 @@
 #include "Exceptions.h"
 #include <vecmath/scalar.h>
 #include <vecmath/bbox.h>
+#include <vecmath/plane.h>
 #include <vecmath/ray.h>
 #include <vecmath/intersection.h>
 
@@ -33,6 +34,7 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <vector>
 
 template <typename T, size_t S, typename U, typename Cmp = std::less<U>>
 class AABBTree : public NodeTree<T,S,U,Cmp> {
@@ -556,6 +558,70 @@ public:
         }
     }
 
+    List findIntersectors(const Box& box) const override {
+        List result;
+        findIntersectors(box, std::back_inserter(result));
+        return result;
+    }
+
+    /**
+     * Finds every data item in this tree whose bounding box intersects with the given box and appends it to the given
+     * output iterator.
+     *
+     * @tparam O the output iterator type
+     * @param box the box to test
+     * @param out the output iterator to append to
+     */
+    template <typename O>
+    void findIntersectors(const Box& box, O out) const {
+        if (!empty()) {
+            LambdaVisitor visitor(
+                    [&](const InnerNode* innerNode) {
+                        return innerNode->bounds().intersects(box);
+                    },
+                    [&](const LeafNode* leaf) {
+                        if (leaf->bounds().intersects(box)) {
+                            out = leaf->data();
+                            ++out;
+                        }
+                    }
+            );
+            m_root->accept(visitor);
+        }
+    }
+
+    List findIntersectors(const std::vector<vm::plane<T,S>>& planes) const override {
+        List result;
+        findIntersectors(planes, std::back_inserter(result));
+        return result;
+    }
+
+    /**
+     * Finds every data item in this tree whose bounding box may intersect with the convex volume bounded by the given
+     * planes and appends it to the given output iterator.
+     *
+     * @tparam O the output iterator type
+     * @param planes the planes bounding the convex volume
+     * @param out the output iterator to append to
+     */
+    template <typename O>
+    void findIntersectors(const std::vector<vm::plane<T,S>>& planes, O out) const {
+        if (!empty()) {
+            LambdaVisitor visitor(
+                    [&](const InnerNode* innerNode) {
+                        return vm::intersects(innerNode->bounds(), std::begin(planes), std::end(planes));
+                    },
+                    [&](const LeafNode* leaf) {
+                        if (vm::intersects(leaf->bounds(), std::begin(planes), std::end(planes))) {
+                            out = leaf->data();
+                            ++out;
+                        }
+                    }
+            );
+            m_root->accept(visitor);
+        }
+    }
+
      List findContainers(const vm::vec<T,S>& point) const override {
          List result;
          findContainers(point, std::back_inserter(result));
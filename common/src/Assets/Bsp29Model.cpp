@@ -38,6 +38,10 @@ namespace TrenchBroom {
         m_vertices(0) {
             m_vertices.reserve(vertexCount);
         }
+
+        Bsp29Model::Face::Face(Assets::Texture* texture, const VertexList& vertices) :
+        m_texture(texture),
+        m_vertices(vertices) {}
         
         void Bsp29Model::Face::addVertex(const vm::vec3f& vertex, const vm::vec2f& texCoord) {
             m_vertices.push_back(Vertex(vertex, texCoord));
@@ -83,6 +87,24 @@ namespace TrenchBroom {
             m_subModels.push_back(SubModel(faces, bounds));
         }
 
+        const TextureCollection& Bsp29Model::textureCollection() const {
+            return *m_textureCollection;
+        }
+
+        size_t Bsp29Model::subModelCount() const {
+            return m_subModels.size();
+        }
+
+        const Bsp29Model::FaceList& Bsp29Model::subModelFaces(const size_t index) const {
+            assert(index < m_subModels.size());
+            return m_subModels[index].faces;
+        }
+
+        const vm::bbox3f& Bsp29Model::subModelBounds(const size_t index) const {
+            assert(index < m_subModels.size());
+            return m_subModels[index].bounds;
+        }
+
         Renderer::TexturedIndexRangeRenderer* Bsp29Model::doBuildRenderer(const size_t skinIndex, const size_t frameIndex) const {
             const SubModel& model = m_subModels.front();
 
@@ -43,6 +43,7 @@ namespace TrenchBroom {
                 VertexList m_vertices;
             public:
                 Face(Texture* texture, size_t vertexCount);
+                Face(Texture* texture, const VertexList& vertices);
                 void addVertex(const vm::vec3f& vertex, const vm::vec2f& texCoord);
                 
                 Texture* texture() const;
@@ -67,6 +68,11 @@ namespace TrenchBroom {
             ~Bsp29Model() override;
             
             void addModel(const FaceList& faces, const vm::bbox3f& bounds);
+
+            const TextureCollection& textureCollection() const;
+            size_t subModelCount() const;
+            const FaceList& subModelFaces(size_t index) const;
+            const vm::bbox3f& subModelBounds(size_t index) const;
         private:
             Renderer::TexturedIndexRangeRenderer* doBuildRenderer(const size_t skinIndex, const size_t frameIndex) const override;
             vm::bbox3f doGetBounds(const size_t skinIndex, const size_t frameIndex) const override;
@@ -0,0 +1,98 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_EntityModelFrameCache
+#define TrenchBroom_EntityModelFrameCache
+
+#include <cassert>
+#include <functional>
+#include <list>
+#include <memory>
+#include <utility>
+
+namespace TrenchBroom {
+    namespace Assets {
+        /**
+         * Decodes the frames of an entity model on demand and keeps the most recently used ones.
+         *
+         * Animated models contain hundreds of frames, but the editor only ever displays one frame per entity. The
+         * model parsers therefore only index the frames of a model and leave it to this cache to decode a frame when
+         * it is requested.
+         *
+         * Frames are handed out as shared pointers, so a frame that is evicted from the cache remains valid for as
+         * long as it is used.
+         */
+        template <typename F>
+        class EntityModelFrameCache {
+        public:
+            using Frame = F;
+            using FramePtr = std::shared_ptr<const Frame>;
+            using Decoder = std::function<Frame*(size_t)>;
+
+            static const size_t DefaultCapacity = 4;
+        private:
+            using Entry = std::pair<size_t, FramePtr>;
+            using EntryList = std::list<Entry>;
+
+            size_t m_frameCount;
+            Decoder m_decoder;
+            size_t m_capacity;
+            mutable EntryList m_entries; // the most recently used frame comes first
+        public:
+            EntityModelFrameCache(const size_t frameCount, const Decoder& decoder, const size_t capacity = DefaultCapacity) :
+            m_frameCount(frameCount),
+            m_decoder(decoder),
+            m_capacity(capacity) {
+                assert(m_capacity > 0);
+            }
+
+            size_t frameCount() const {
+                return m_frameCount;
+            }
+
+            size_t cachedFrameCount() const {
+                return m_entries.size();
+            }
+
+            /**
+             * Returns the frame with the given index, decoding it if it is not cached.
+             */
+            FramePtr frame(const size_t index) const {
+                assert(index < m_frameCount);
+
+                for (auto it = std::begin(m_entries); it != std::end(m_entries); ++it) {
+                    if (it->first == index) {
+                        m_entries.splice(std::begin(m_entries), m_entries, it);
+                        return it->second;
+                    }
+                }
+
+                const FramePtr result(m_decoder(index));
+                m_entries.emplace_front(index, result);
+                if (m_entries.size() > m_capacity) {
+                    m_entries.pop_back();
+                }
+                return result;
+            }
+        };
+    }
+}
+
+#endif /* defined(TrenchBroom_EntityModelFrameCache) */
@@ -22,25 +22,189 @@
 #include "CollectionUtils.h"
 #include "Exceptions.h"
 #include "Logger.h"
+#include "ParallelUtils.h"
 #include "Assets/EntityModel.h"
 #include "IO/EntityModelLoader.h"
 #include "Model/Entity.h"
 #include "Renderer/TexturedIndexRangeRenderer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+
 namespace TrenchBroom {
     namespace Assets {
+        /**
+         * A pool of worker threads that load models in the order in which they were queued. The threads are started
+         * when the first model is queued.
+         */
+        class EntityModelManager::LoadQueue {
+        public:
+            typedef std::chrono::steady_clock Clock;
+
+            struct Result {
+                IO::Path path;
+                EntityModel* model;
+                String error;
+                double latency;
+            };
+        private:
+            struct Job {
+                IO::Path path;
+                const IO::EntityModelLoader* loader;
+                Clock::time_point queued;
+            };
+
+            const size_t m_threadCount;
+            std::vector<std::thread> m_workers;
+
+            mutable std::mutex m_mutex;
+            std::condition_variable m_jobsAvailable;
+            std::condition_variable m_jobDone;
+            std::deque<Job> m_jobs;
+            std::vector<Result> m_results;
+            // the number of jobs that are being processed by workers
+            size_t m_active;
+            bool m_stop;
+            LoadCallback m_loadCallback;
+        public:
+            explicit LoadQueue(const size_t threadCount) :
+            m_threadCount(threadCount),
+            m_active(0),
+            m_stop(false) {}
+
+            ~LoadQueue() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                    m_jobs.clear();
+                }
+                m_jobsAvailable.notify_all();
+
+                for (auto& worker : m_workers) {
+                    worker.join();
+                }
+                deleteResults();
+            }
+
+            void setLoadCallback(const LoadCallback& loadCallback) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_loadCallback = loadCallback;
+            }
+
+            void enqueue(const IO::Path& path, const IO::EntityModelLoader* loader) {
+                if (m_workers.empty()) {
+                    for (size_t i = 0; i < m_threadCount; ++i) {
+                        m_workers.emplace_back([this]() { work(); });
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_jobs.push_back(Job{ path, loader, Clock::now() });
+                }
+                m_jobsAvailable.notify_one();
+            }
+
+            /**
+             * Removes all queued jobs and waits for the workers to finish the jobs they are processing. The results
+             * of all jobs are discarded.
+             */
+            void cancel() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_jobs.clear();
+                m_jobDone.wait(lock, [this]() { return m_active == 0; });
+                deleteResults();
+            }
+
+            std::vector<Result> takeResults() {
+                std::vector<Result> results;
+                std::lock_guard<std::mutex> lock(m_mutex);
+                swap(results, m_results);
+                return results;
+            }
+
+            size_t queueDepth() const {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_jobs.size() + m_active;
+            }
+        private:
+            void work() {
+                while (true) {
+                    Job job;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_jobsAvailable.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+                        if (m_stop) {
+                            return;
+                        }
+                        job = m_jobs.front();
+                        m_jobs.pop_front();
+                        ++m_active;
+                    }
+
+                    auto result = Result{ job.path, nullptr, "", 0.0 };
+                    try {
+                        result.model = job.loader->loadEntityModel(job.path);
+                        ensure(result.model != nullptr, "model is null");
+                    } catch (const std::exception& e) {
+                        result.error = e.what();
+                    }
+                    result.latency = std::chrono::duration<double, std::milli>(Clock::now() - job.queued).count();
+
+                    LoadCallback loadCallback;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_results.push_back(result);
+                        loadCallback = m_loadCallback;
+                    }
+
+                    // the job is only done once the callback has returned so that cancel() does not return while
+                    // callbacks for discarded jobs are still pending
+                    if (loadCallback) {
+                        loadCallback();
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        --m_active;
+                    }
+                    m_jobDone.notify_all();
+                }
+            }
+
+            void deleteResults() {
+                for (auto& result : m_results) {
+                    delete result.model;
+                }
+                m_results.clear();
+            }
+        };
+
+        // the time that may be spent preparing models for rendering in one frame, in milliseconds
+        static const double ModelPreparationBudget = 4.0;
+
         EntityModelManager::EntityModelManager(Logger* logger, int minFilter, int magFilter) :
         m_logger(logger),
         m_loader(nullptr),
         m_minFilter(minFilter),
         m_magFilter(magFilter),
-        m_resetTextureMode(false) {}
+        m_resetTextureMode(false),
+        m_loadQueue(std::make_unique<LoadQueue>(std::max(size_t(1), ParallelUtils::threadCount(std::numeric_limits<size_t>::max()) - 1))),
+        m_changed(false),
+        m_stats({ 0u, 0u, 0u, 0u, 0.0, 0.0 }) {}
         
         EntityModelManager::~EntityModelManager() {
             clear();
         }
         
         void EntityModelManager::clear() {
+            cancelLoading();
+
             MapUtils::clearAndDelete(m_renderers);
             MapUtils::clearAndDelete(m_models);
             m_rendererMismatches.clear();
@@ -63,6 +227,56 @@ namespace TrenchBroom {
             m_loader = loader;
         }
 
+        void EntityModelManager::setLoadCallback(const LoadCallback& loadCallback) {
+            m_loadQueue->setLoadCallback(loadCallback);
+        }
+
+        bool EntityModelManager::update() {
+            for (const auto& result : m_loadQueue->takeResults()) {
+                m_loadingModels.erase(result.path);
+                m_changed = true;
+
+                if (result.model != nullptr) {
+                    m_models[result.path] = result.model;
+                    m_unpreparedModels.push_back(result.model);
+                    ++m_stats.loaded;
+
+                    if (m_logger != nullptr)
+                        m_logger->debug("Loaded entity model %s in %.1f ms", result.path.asString().c_str(), result.latency);
+                } else {
+                    m_modelMismatches.insert(result.path);
+                    ++m_stats.failed;
+
+                    if (m_logger != nullptr)
+                        m_logger->error(result.error);
+                }
+
+                m_stats.totalLatency += result.latency;
+                m_stats.maxLatency = std::max(m_stats.maxLatency, result.latency);
+            }
+            m_stats.queueDepth = m_loadingModels.size();
+
+            if (!m_changed)
+                return false;
+
+            const auto now = LoadQueue::Clock::now();
+            const bool loading = !m_loadingModels.empty() || !m_unpreparedModels.empty();
+            if (loading && std::chrono::duration<double, std::milli>(now - m_lastUpdate).count() < UpdateInterval)
+                return false;
+
+            m_changed = false;
+            m_lastUpdate = now;
+            return true;
+        }
+
+        bool EntityModelManager::hasPendingChanges() const {
+            return m_changed;
+        }
+
+        EntityModelManager::Stats EntityModelManager::stats() const {
+            return m_stats;
+        }
+
         EntityModel* EntityModelManager::model(const IO::Path& path) const {
             if (path.isEmpty())
                 return nullptr;
@@ -71,23 +285,16 @@ namespace TrenchBroom {
             if (it != std::end(m_models))
                 return it->second;
             
-            if (m_modelMismatches.count(path) > 0)
+            if (m_modelMismatches.count(path) > 0 || m_loadingModels.count(path) > 0)
                 return nullptr;
             
-            try {
-                EntityModel* model = loadModel(path);
-                ensure(model != nullptr, "model is null");
-                m_models[path] = model;
-                m_unpreparedModels.push_back(model);
-                
-                if (m_logger != nullptr)
-                    m_logger->debug("Loaded entity model %s", path.asString().c_str());
+            ensure(m_loader != nullptr, "loader is null");
+            m_loadQueue->enqueue(path, m_loader);
+            m_loadingModels.insert(path);
 
-                return model;
-            } catch (const GameException&) {
-                m_modelMismatches.insert(path);
-                throw;
-            }
+            m_stats.queueDepth = m_loadingModels.size();
+            m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_stats.queueDepth);
+            return nullptr;
         }
         
         EntityModel* EntityModelManager::safeGetModel(const IO::Path& path) const {
@@ -101,9 +308,8 @@ namespace TrenchBroom {
         Renderer::TexturedIndexRangeRenderer* EntityModelManager::renderer(const Assets::ModelSpecification& spec) const {
             EntityModel* entityModel = safeGetModel(spec.path);
 
-            if (entityModel == nullptr)
+            if (entityModel == nullptr || !entityModel->prepared())
                 return nullptr;
-            
             RendererCache::const_iterator it = m_renderers.find(spec);
             if (it != std::end(m_renderers))
                 return it->second;
@@ -135,9 +341,10 @@ namespace TrenchBroom {
             return renderer(spec) != nullptr;
         }
 
-        EntityModel* EntityModelManager::loadModel(const IO::Path& path) const {
-            ensure(m_loader != nullptr, "loader is null");
-            return m_loader->loadEntityModel(path);
+        void EntityModelManager::cancelLoading() {
+            m_loadQueue->cancel();
+            m_loadingModels.clear();
+            m_stats.queueDepth = 0;
         }
 
         void EntityModelManager::prepare(Renderer::Vbo& vbo) {
@@ -157,9 +364,19 @@ namespace TrenchBroom {
         }
         
         void EntityModelManager::prepareModels() {
-            for (Assets::EntityModel* model : m_unpreparedModels)
-                model->prepare(m_minFilter, m_magFilter);
-            m_unpreparedModels.clear();
+            if (m_unpreparedModels.empty())
+                return;
+
+            // Models that were prepared become available for rendering with the next call to update().
+            const auto start = LoadQueue::Clock::now();
+            auto it = std::begin(m_unpreparedModels);
+            do {
+                (*it++)->prepare(m_minFilter, m_magFilter);
+            } while (it != std::end(m_unpreparedModels) &&
+                     std::chrono::duration<double, std::milli>(LoadQueue::Clock::now() - start).count() < ModelPreparationBudget);
+
+            m_unpreparedModels.erase(std::begin(m_unpreparedModels), it);
+            m_changed = true;
         }
         
         void EntityModelManager::prepareRenderers(Renderer::Vbo& vbo) {
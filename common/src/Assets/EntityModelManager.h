@@ -24,7 +24,10 @@
 #include "IO/Path.h"
 #include "Model/ModelTypes.h"
 
+#include <chrono>
+#include <functional>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -43,10 +46,37 @@ namespace TrenchBroom {
     namespace Assets {
         class EntityModel;
         
+        /**
+         * Loads entity models on a number of worker threads and keeps them until they are cleared.
+         *
+         * A model that is requested for the first time is queued for loading and reported as missing until it has
+         * been loaded and prepared for rendering, so callers must be prepared to render a placeholder in the meantime.
+         * Loaded models are taken over by calling update() on the main thread, and they are prepared for rendering
+         * a few at a time by prepare() so that a large number of models does not stall a single frame.
+         */
         class EntityModelManager {
+        public:
+            struct Stats {
+                size_t loaded;
+                size_t failed;
+                // the number of models that are queued or being loaded
+                size_t queueDepth;
+                size_t maxQueueDepth;
+                // the time between queueing a model and having it loaded, in milliseconds
+                double totalLatency;
+                double maxLatency;
+            };
+
+            typedef std::function<void()> LoadCallback;
+
+            // the minimum time between two reports of changed models while models are being loaded, in milliseconds
+            static const int UpdateInterval = 100;
         private:
+            class LoadQueue;
+
             typedef std::map<IO::Path, EntityModel*> ModelCache;
             typedef std::set<IO::Path> ModelMismatches;
+            typedef std::set<IO::Path> ModelPaths;
             typedef std::vector<EntityModel*> ModelList;
             
             typedef std::map<Assets::ModelSpecification, Renderer::TexturedIndexRangeRenderer*> RendererCache;
@@ -67,6 +97,14 @@ namespace TrenchBroom {
 
             mutable ModelList m_unpreparedModels;
             mutable RendererList m_unpreparedRenderers;
+
+            std::unique_ptr<LoadQueue> m_loadQueue;
+            mutable ModelPaths m_loadingModels;
+
+            // whether models were taken over or prepared since the last time update() returned true
+            bool m_changed;
+            std::chrono::steady_clock::time_point m_lastUpdate;
+            mutable Stats m_stats;
         public:
             EntityModelManager(Logger* logger, int minFilter, int magFilter);
             ~EntityModelManager();
@@ -75,7 +113,37 @@ namespace TrenchBroom {
 
             void setTextureMode(int minFilter, int magFilter);
             void setLoader(const IO::EntityModelLoader* loader);
-            
+
+            /**
+             * Sets a function that is called on a worker thread whenever a model has been loaded. It should cause
+             * update() to be called on the main thread. Since clear() waits for running callbacks to return, the
+             * callback must not wait for the main thread.
+             */
+            void setLoadCallback(const LoadCallback& loadCallback);
+
+            /**
+             * Takes over the models that were loaded since the last call. Must be called on the main thread.
+             *
+             * Observers usually reload all entity models when this returns true, so while models are still being
+             * loaded or prepared, changes are reported at most once per update interval.
+             *
+             * @return true if models were loaded, failed to load or were prepared for rendering since changes were
+             * last reported and the update interval has passed
+             */
+            bool update();
+
+            /**
+             * Indicates whether update() has deferred reporting changes because it was called too soon after the
+             * previous report. If so, update() must be called again once the update interval has passed.
+             */
+            bool hasPendingChanges() const;
+
+            Stats stats() const;
+
+            /**
+             * Returns the model with the given path, or null if the model is still being loaded or could not be
+             * loaded. If the model has not been requested before, it is queued for loading.
+             */
             EntityModel* model(const IO::Path& path) const;
             EntityModel* safeGetModel(const IO::Path& path) const;
             Renderer::TexturedIndexRangeRenderer* renderer(const Assets::ModelSpecification& spec) const;
@@ -83,7 +151,7 @@ namespace TrenchBroom {
             bool hasModel(const Model::Entity* entity) const;
             bool hasModel(const Assets::ModelSpecification& spec) const;
         private:
-            EntityModel* loadModel(const IO::Path& path) const;
+            void cancelLoading();
         public:
             void prepare(Renderer::Vbo& vbo);
         private:
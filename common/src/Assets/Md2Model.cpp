@@ -65,30 +65,46 @@ namespace TrenchBroom {
             return m_bounds;
         }
 
-        Md2Model::Md2Model(const String& name, const TextureList& skins, const FrameList& frames) :
+        Md2Model::Md2Model(const String& name, const TextureList& skins, const size_t frameCount, const FrameCache::Decoder& frameDecoder) :
         m_name(name),
         m_skins(new TextureCollection(IO::Path(name), skins)),
-        m_frames(frames) {}
+        m_frames(frameCount, frameDecoder) {}
         
         Md2Model::~Md2Model() {
-            VectorUtils::clearAndDelete(m_frames);
             delete m_skins;
             m_skins = nullptr;
         }
 
+        const TextureList& Md2Model::skins() const {
+            return m_skins->textures();
+        }
+
+        size_t Md2Model::frameCount() const {
+            return m_frames.frameCount();
+        }
+
+        size_t Md2Model::cachedFrameCount() const {
+            return m_frames.cachedFrameCount();
+        }
+
+        Md2Model::FrameCache::FramePtr Md2Model::frame(const size_t index) const {
+            return m_frames.frame(index);
+        }
+
         Renderer::TexturedIndexRangeRenderer* Md2Model::doBuildRenderer(const size_t skinIndex, const size_t frameIndex) const {
             const auto& textures = m_skins->textures();
             
             ensure(skinIndex < textures.size(), "skin index out of range");
-            ensure(frameIndex < m_frames.size(), "frame index out of range");
+            ensure(frameIndex < m_frames.frameCount(), "frame index out of range");
 
             const auto* skin = textures[skinIndex];
-            const auto* frame = m_frames[frameIndex];
+            const auto frame = m_frames.frame(frameIndex);
             
             const auto& vertices = frame->vertices();
             const auto& indices = frame->indices();
             
-            const auto vertexArray = Renderer::VertexArray::ref(vertices);
+            // the frame may be evicted from the cache while the renderer is alive
+            const auto vertexArray = Renderer::VertexArray::copy(vertices);
             const Renderer::TexturedIndexRangeMap texturedIndices(skin, indices);
             
             return new Renderer::TexturedIndexRangeRenderer(vertexArray, texturedIndices);
@@ -96,17 +112,17 @@ namespace TrenchBroom {
         
         vm::bbox3f Md2Model::doGetBounds(const size_t skinIndex, const size_t frameIndex) const {
             ensure(skinIndex < m_skins->textures().size(), "skin index out of range");
-            ensure(frameIndex < m_frames.size(), "frame index out of range");
+            ensure(frameIndex < m_frames.frameCount(), "frame index out of range");
             
-            const auto* frame = m_frames[frameIndex];
+            const auto frame = m_frames.frame(frameIndex);
             return frame->bounds();
         }
         
         vm::bbox3f Md2Model::doGetTransformedBounds(const size_t skinIndex, const size_t frameIndex, const vm::mat4x4f& transformation) const {
             ensure(skinIndex < m_skins->textures().size(), "skin index out of range");
-            ensure(frameIndex < m_frames.size(), "frame index out of range");
+            ensure(frameIndex < m_frames.frameCount(), "frame index out of range");
             
-            const auto* frame = m_frames[frameIndex];
+            const auto frame = m_frames.frame(frameIndex);
             return frame->transformedBounds(transformation);
         }
 
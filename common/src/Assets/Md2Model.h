@@ -22,6 +22,7 @@
 
 #include "Assets/AssetTypes.h"
 #include "Assets/EntityModel.h"
+#include "Assets/EntityModelFrameCache.h"
 #include "StringUtils.h"
 #include "Renderer/VertexSpec.h"
 #include "Renderer/IndexRangeMap.h"
@@ -55,14 +56,27 @@ namespace TrenchBroom {
                 const vm::bbox3f& bounds() const;
             };
 
-            typedef std::vector<Frame*> FrameList;
+            typedef EntityModelFrameCache<Frame> FrameCache;
         private:
             String m_name;
             TextureCollection* m_skins;
-            FrameList m_frames;
+            FrameCache m_frames;
         public:
-            Md2Model(const String& name, const TextureList& skins, const FrameList& frames);
+            /**
+             * Creates a model with the given number of frames, which are decoded by the given decoder when they are
+             * first requested.
+             */
+            Md2Model(const String& name, const TextureList& skins, size_t frameCount, const FrameCache::Decoder& frameDecoder);
             ~Md2Model() override;
+
+            const TextureList& skins() const;
+            size_t frameCount() const;
+
+            /**
+             * Returns the number of frames that have been decoded and are currently kept by this model.
+             */
+            size_t cachedFrameCount() const;
+            FrameCache::FramePtr frame(size_t index) const;
         private:
             Renderer::TexturedIndexRangeRenderer* doBuildRenderer(const size_t skinIndex, const size_t frameIndex) const override;
             vm::bbox3f doGetBounds(const size_t skinIndex, const size_t frameIndex) const override;
@@ -57,15 +57,21 @@ namespace TrenchBroom {
             return m_textures.textures().front();
         }
 
-        MdlBaseFrame::~MdlBaseFrame() {}
+        const TextureList& MdlSkin::pictures() const {
+            return m_textures.textures();
+        }
+
+        const MdlTimeList& MdlSkin::times() const {
+            return m_times;
+        }
 
         MdlFrame::MdlFrame(const String& name, const VertexList& triangles, const vm::bbox3f& bounds) :
         m_name(name),
         m_triangles(triangles),
         m_bounds(bounds) {}
         
-        const MdlFrame* MdlFrame::firstFrame() const {
-            return this;
+        const String& MdlFrame::name() const {
+            return m_name;
         }
 
         const MdlFrame::VertexList& MdlFrame::triangles() const {
@@ -96,74 +102,75 @@ namespace TrenchBroom {
             return bounds;
         }
 
-        MdlFrameGroup::~MdlFrameGroup() {
-            VectorUtils::clearAndDelete(m_frames);
-        }
-        
-        const MdlFrame* MdlFrameGroup::firstFrame() const {
-            if (m_frames.empty()) {
-                return nullptr;
-            } else {
-                return m_frames[0]->firstFrame();
-            }
-        }
-        
-        void MdlFrameGroup::addFrame(MdlFrame* frame, const float time) {
-            m_frames.push_back(frame);
-            m_times.push_back(time);
-        }
-
-        MdlModel::MdlModel(const String& name) :
-        m_name(name) {}
+        MdlModel::MdlModel(const String& name, const size_t frameCount, const FrameCache::Decoder& frameDecoder) :
+        m_name(name),
+        m_frames(frameCount, frameDecoder) {}
 
         MdlModel::~MdlModel() {
             VectorUtils::clearAndDelete(m_skins);
-            VectorUtils::clearAndDelete(m_frames);
         }
 
         void MdlModel::addSkin(MdlSkin* skin) {
             m_skins.push_back(skin);
         }
 
-        void MdlModel::addFrame(MdlBaseFrame* frame) {
-            m_frames.push_back(frame);
+        size_t MdlModel::skinCount() const {
+            return m_skins.size();
+        }
+
+        const MdlSkin* MdlModel::skin(const size_t index) const {
+            assert(index < m_skins.size());
+            return m_skins[index];
+        }
+
+        size_t MdlModel::frameCount() const {
+            return m_frames.frameCount();
+        }
+
+        size_t MdlModel::cachedFrameCount() const {
+            return m_frames.cachedFrameCount();
+        }
+
+        MdlModel::FrameCache::FramePtr MdlModel::frame(const size_t index) const {
+            return m_frames.frame(index);
         }
 
         Renderer::TexturedIndexRangeRenderer* MdlModel::doBuildRenderer(const size_t skinIndex, const size_t frameIndex) const {
             if (skinIndex >= m_skins.size()) {
                 return nullptr;
             }
-            if (frameIndex >= m_frames.size()) {
+            if (frameIndex >= m_frames.frameCount()) {
                 return nullptr;
             }
 
             const auto* skin = m_skins[skinIndex];
-            const auto* frame = m_frames[frameIndex]->firstFrame();
+            const auto frame = m_frames.frame(frameIndex);
 
             const auto* texture = skin->firstPicture();
             const auto& vertices = frame->triangles();
             const auto vertexCount = vertices.size();
             
-            const auto vertexArray = Renderer::VertexArray::ref(vertices);
+            // the frame may be evicted from the cache while the renderer is alive
+            const auto vertexArray = Renderer::VertexArray::copy(vertices);
             const Renderer::TexturedIndexRangeMap indexArray(texture, GL_TRIANGLES, 0, vertexCount);
             
             return new Renderer::TexturedIndexRangeRenderer(vertexArray, indexArray);
         }
 
         vm::bbox3f MdlModel::doGetBounds(const size_t /* skinIndex */, const size_t frameIndex) const {
-            if (frameIndex >= m_frames.size()) {
+            if (frameIndex >= m_frames.frameCount()) {
                 return vm::bbox3f(-8.0f, 8.0f);
             } else {
-                const auto* frame = m_frames[frameIndex]->firstFrame();
+                const auto frame = m_frames.frame(frameIndex);
                 return frame->bounds();
             }
         }
 
         vm::bbox3f MdlModel::doGetTransformedBounds(const size_t /* skinIndex */, const size_t frameIndex, const vm::mat4x4f& transformation) const {
-            if (frameIndex >= m_frames.size()) {
+            if (frameIndex >= m_frames.frameCount()) {
                 return vm::bbox3f(-8.0f, 8.0f);
             } else {
-                const auto* frame = m_frames[frameIndex]->firstFrame();
+                const auto frame = m_frames.frame(frameIndex);
                 return frame->transformedBounds(transformation);
             };
         }
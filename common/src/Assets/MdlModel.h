@@ -23,6 +23,7 @@
 #include "StringUtils.h"
 #include "Assets/AssetTypes.h"
 #include "Assets/EntityModel.h"
+#include "Assets/EntityModelFrameCache.h"
 #include "Assets/TextureCollection.h"
 #include "Renderer/VertexSpec.h"
 #include "Renderer/Vertex.h"
@@ -48,17 +49,11 @@ namespace TrenchBroom {
             void prepare(int minFilter, int magFilter);
             void setTextureMode(int minFilter, int magFilter);
             const Texture* firstPicture() const;
+            const TextureList& pictures() const;
+            const MdlTimeList& times() const;
         };
 
-        class MdlFrame;
-        
-        class MdlBaseFrame {
-        public:
-            virtual ~MdlBaseFrame();
-            virtual const MdlFrame* firstFrame() const = 0;
-        };
-        
-        class MdlFrame : public MdlBaseFrame {
+        class MdlFrame {
         public:
             typedef Renderer::VertexSpecs::P3T2::Vertex Vertex;
             typedef Vertex::List VertexList;
@@ -68,38 +63,39 @@ namespace TrenchBroom {
             vm::bbox3f m_bounds;
         public:
             MdlFrame(const String& name, const VertexList& triangles, const vm::bbox3f& bounds);
-            const MdlFrame* firstFrame() const override;
+            const String& name() const;
             const VertexList& triangles() const;
             vm::bbox3f bounds() const;
             vm::bbox3f transformedBounds(const vm::mat4x4f& transformation) const;
         };
         
-        class MdlFrameGroup : public MdlBaseFrame {
-        private:
-            typedef std::vector<MdlFrame*> SingleFrameList;
-            
-            MdlTimeList m_times;
-            SingleFrameList m_frames;
-        public:
-            ~MdlFrameGroup() override;
-            const MdlFrame* firstFrame() const override;
-            void addFrame(MdlFrame* frame, float time);
-        };
-        
         class MdlModel : public EntityModel {
         private:
             typedef std::vector<MdlSkin*> MdlSkinList;
-            typedef std::vector<MdlBaseFrame*> MdlFrameList;
-            
+        public:
+            typedef EntityModelFrameCache<MdlFrame> FrameCache;
+        private:
             String m_name;
             MdlSkinList m_skins;
-            MdlFrameList m_frames;
+            FrameCache m_frames;
         public:
-            explicit MdlModel(const String& name);
+            /**
+             * Creates a model with the given number of frames, which are decoded by the given decoder when they are
+             * first requested. For a frame group, only its first frame is decoded.
+             */
+            MdlModel(const String& name, size_t frameCount, const FrameCache::Decoder& frameDecoder);
             ~MdlModel() override;
             
             void addSkin(MdlSkin* skin);
-            void addFrame(MdlBaseFrame* frame);
+            size_t skinCount() const;
+            const MdlSkin* skin(size_t index) const;
+            size_t frameCount() const;
+
+            /**
+             * Returns the number of frames that have been decoded and are currently kept by this model.
+             */
+            size_t cachedFrameCount() const;
+            FrameCache::FramePtr frame(size_t index) const;
         private:
             Renderer::TexturedIndexRangeRenderer* doBuildRenderer(size_t skinIndex, size_t frameIndex) const override;
             vm::bbox3f doGetBounds(size_t skinIndex, size_t frameIndex) const override;
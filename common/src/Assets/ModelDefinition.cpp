@@ -84,7 +84,8 @@ namespace TrenchBroom {
         m_expression(EL::LiteralExpression::create(EL::Value::Undefined, line, column)) {}
 
         ModelDefinition::ModelDefinition(const EL::Expression& expression) :
-        m_expression(expression) {}
+        m_expression(expression),
+        m_attributeDependencies(m_expression.variables()) {}
 
         void ModelDefinition::append(const ModelDefinition& other) {
             EL::ExpressionBase::List cases;
@@ -94,6 +95,7 @@ namespace TrenchBroom {
             const size_t line = m_expression.line();
             const size_t column = m_expression.column();
             m_expression = EL::SwitchOperator::create(cases, line, column);
+            m_attributeDependencies = m_expression.variables();
         }
 
         ModelSpecification ModelDefinition::modelSpecification(const Model::EntityAttributes& attributes) const {
@@ -113,6 +115,14 @@ namespace TrenchBroom {
             }
         }
 
+        const StringList& ModelDefinition::attributeDependencies() const {
+            return m_attributeDependencies;
+        }
+
+        const EL::Expression& ModelDefinition::expression() const {
+            return m_expression;
+        }
+
         ModelSpecification ModelDefinition::convertToModel(const EL::Value& value) const {
             switch (value.type()) {
                 case EL::Type_Map:
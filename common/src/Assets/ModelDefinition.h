@@ -48,6 +48,7 @@ namespace TrenchBroom {
         class ModelDefinition {
         private:
             EL::Expression m_expression;
+            StringList m_attributeDependencies;
         public:
             ModelDefinition();
             ModelDefinition(size_t line, size_t column);
@@ -57,6 +58,14 @@ namespace TrenchBroom {
 
             ModelSpecification modelSpecification(const Model::EntityAttributes& attributes) const;
             ModelSpecification defaultModelSpecification() const;
+
+            /**
+             * Returns the names of the entity attributes that the model expression reads. The model specification of
+             * an entity can only change if one of these attributes changes.
+             */
+            const StringList& attributeDependencies() const;
+
+            const EL::Expression& expression() const;
         private:
             ModelSpecification convertToModel(const EL::Value& value) const;
             IO::Path path(const EL::Value& value) const;
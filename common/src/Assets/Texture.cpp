@@ -21,6 +21,7 @@
 #include "Assets/ImageUtils.h"
 #include "Assets/TextureCollection.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace TrenchBroom {
@@ -58,7 +59,8 @@ namespace TrenchBroom {
         m_overridden(false),
         m_format(format),
         m_type(type),
-        m_textureId(0) {
+        m_textureId(0),
+        m_mipLevelCount(0) {
             assert(m_width > 0);
             assert(m_height > 0);
             assert(buffer.size() >= m_width * m_height * bytesPerPixelForFormat(format));
@@ -76,7 +78,8 @@ namespace TrenchBroom {
         m_format(format),
         m_type(type),
         m_textureId(0),
-        m_buffers(buffers) {
+        m_buffers(buffers),
+        m_mipLevelCount(0) {
             assert(m_width > 0);
             assert(m_height > 0);
             for (size_t i = 0; i < m_buffers.size(); ++i) {
@@ -94,7 +97,8 @@ namespace TrenchBroom {
         m_overridden(false),
         m_format(format),
         m_type(type),
-        m_textureId(0) {}
+        m_textureId(0),
+        m_mipLevelCount(0) {}
 
         Texture::~Texture() {
             if (m_collection == nullptr && m_textureId != 0)
@@ -117,6 +121,18 @@ namespace TrenchBroom {
         const Color& Texture::averageColor() const {
             return m_averageColor;
         }
+
+        GLenum Texture::format() const {
+            return m_format;
+        }
+
+        TextureType Texture::type() const {
+            return m_type;
+        }
+
+        const TextureBuffer::List& Texture::buffers() const {
+            return m_buffers;
+        }
         
         size_t Texture::usageCount() const {
             return m_usageCount;
@@ -147,6 +163,10 @@ namespace TrenchBroom {
             return m_textureId != 0;
         }
 
+        size_t Texture::mipLevelCount() const {
+            return m_mipLevelCount;
+        }
+
         void Texture::prepare(const GLuint textureId, const int minFilter, const int magFilter) {
             assert(textureId > 0);
             assert(!m_buffers.empty());
@@ -198,6 +218,14 @@ namespace TrenchBroom {
                 mipHeight /= 2;
             }
             
+            if (generateMipmaps) {
+                m_mipLevelCount = 1;
+                while ((std::max(m_width, m_height) >> m_mipLevelCount) > 0)
+                    ++m_mipLevelCount;
+            } else {
+                m_mipLevelCount = m_buffers.size();
+            }
+
             m_buffers.clear();
             m_textureId = textureId;
         }
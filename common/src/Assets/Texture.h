@@ -58,6 +58,7 @@ namespace TrenchBroom {
 
             mutable GLuint m_textureId;
             mutable TextureBuffer::List m_buffers;
+            size_t m_mipLevelCount;
         public:
             Texture(const String& name, size_t width, size_t height, const Color& averageColor, const TextureBuffer& buffer, GLenum format, TextureType type);
             Texture(const String& name, size_t width, size_t height, const Color& averageColor, const TextureBuffer::List& buffers, GLenum format, TextureType type);
@@ -69,6 +70,13 @@ namespace TrenchBroom {
             size_t width() const;
             size_t height() const;
             const Color& averageColor() const;
+            GLenum format() const;
+            TextureType type() const;
+
+            /**
+             * Returns the image data of every mip level. The data is released once the texture has been prepared.
+             */
+            const TextureBuffer::List& buffers() const;
 
             size_t usageCount() const;
             void incUsageCount();
@@ -77,6 +85,11 @@ namespace TrenchBroom {
             void setOverridden(const bool overridden);
 
             bool isPrepared() const;
+
+            /**
+             * Returns the number of mip levels of the prepared texture, including the levels generated by OpenGL.
+             */
+            size_t mipLevelCount() const;
             void prepare(GLuint textureId, int minFilter, int magFilter);
             void setMode(int minFilter, int magFilter);
 
@@ -55,13 +55,13 @@ namespace TrenchBroom {
         m_resetTextureMode(false) {}
         
         TextureManager::~TextureManager() {
-            clear();
+            clearCollections();
         }
         
         void TextureManager::setTextureCollections(const IO::Path::List& paths, IO::TextureLoader& loader) {
             TextureCollectionMap collections = collectionMap();
             m_collections.clear();
-            clear();
+            clearCollections();
             
             for (const IO::Path& path : paths) {
                 const auto it = collections.find(path);
@@ -85,6 +85,7 @@ namespace TrenchBroom {
             
             updateTextures();
             VectorUtils::append(m_toRemove, collections);
+            texturesDidChange();
         }
 
         TextureManager::TextureCollectionMap TextureManager::collectionMap() const {
@@ -104,6 +105,11 @@ namespace TrenchBroom {
         }
 
         void TextureManager::clear() {
+            clearCollections();
+            texturesDidChange();
+        }
+
+        void TextureManager::clearCollections() {
             VectorUtils::clearAndDelete(m_collections);
             VectorUtils::clearAndDelete(m_toRemove);
             
@@ -120,6 +126,14 @@ namespace TrenchBroom {
             m_resetTextureMode = true;
         }
 
+        int TextureManager::minFilter() const {
+            return m_minFilter;
+        }
+
+        int TextureManager::magFilter() const {
+            return m_magFilter;
+        }
+
         void TextureManager::commitChanges() {
             resetTextureMode();
             prepare();
@@ -57,6 +57,7 @@ namespace TrenchBroom {
             bool m_resetTextureMode;
         public:
             Notifier0 usageCountDidChange;
+            Notifier0 texturesDidChange;
         public:
             TextureManager(Logger* logger, int minFilter, int magFilter);
             ~TextureManager();
@@ -69,6 +70,8 @@ namespace TrenchBroom {
             void clear();
             
             void setTextureMode(int minFilter, int magFilter);
+            int minFilter() const;
+            int magFilter() const;
             void commitChanges();
             
             Texture* texture(const String& name) const;
@@ -80,6 +83,7 @@ namespace TrenchBroom {
             void prepare();
 
             void updateTextures();
+            void clearCollections();
         };
     }
 }
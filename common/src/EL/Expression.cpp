@@ -21,11 +21,22 @@
 
 #include "CollectionUtils.h"
 #include "EL/EvaluationContext.h"
+#include "EL/ExpressionIO.h"
+#include "EL/Program.h"
+
+#include <mutex>
+#include <vector>
 
 namespace TrenchBroom {
     namespace EL {
+        struct Expression::CompiledProgram {
+            std::once_flag once;
+            std::unique_ptr<Program> program;
+        };
+
         Expression::Expression(ExpressionBase* expression) :
-        m_expression(expression) {
+        m_expression(expression),
+        m_program(std::make_shared<CompiledProgram>()) {
             ensure(m_expression.get() != nullptr, "expression is null");
         }
         
@@ -33,13 +44,18 @@ namespace TrenchBroom {
             ExpressionBase* optimized = m_expression->optimize();
             if (optimized != nullptr && optimized != m_expression.get()) {
                 m_expression.reset(optimized);
+                m_program = std::make_shared<CompiledProgram>();
                 return true;
             }
             return false;
         }
         
         Value Expression::evaluate(const EvaluationContext& context) const {
-            return m_expression->evaluate(context);
+            return program().evaluate(context);
+        }
+
+        const StringList& Expression::variables() const {
+            return program().variables();
         }
         
         ExpressionBase* Expression::clone() const {
@@ -62,6 +78,18 @@ namespace TrenchBroom {
             return stream << *(expression.m_expression.get());
         }
 
+        void Expression::write(ExpressionWriter& writer) const {
+            writer.writeExpression(*m_expression);
+        }
+
+        const Program& Expression::program() const {
+            CompiledProgram& compiled = *m_program;
+            std::call_once(compiled.once, [&]() {
+                compiled.program = std::make_unique<Program>(*m_expression);
+            });
+            return *compiled.program;
+        }
+
         void ExpressionBase::replaceExpression(ExpressionBase*& oldExpression, ExpressionBase* newExpression) {
             if (newExpression != nullptr && newExpression != oldExpression) {
                 delete oldExpression;
@@ -92,6 +120,10 @@ namespace TrenchBroom {
             return doEvaluate(context);
         }
         
+        void ExpressionBase::compile(Program& program) const {
+            doCompile(program);
+        }
+        
         String ExpressionBase::asString() const {
             StringStream result;
             appendToStream(result);
@@ -107,6 +139,10 @@ namespace TrenchBroom {
             return stream;
         }
 
+        void ExpressionBase::write(ExpressionWriter& writer) const {
+            doWrite(writer);
+        }
+
         ExpressionBase* ExpressionBase::doReorderByPrecedence() {
             return this;
         }
@@ -135,10 +171,19 @@ namespace TrenchBroom {
             return m_value;
         }
         
+        void LiteralExpression::doCompile(Program& program) const {
+            program.emit(Program::Op_PushConstant, m_line, m_column, program.addConstant(m_value));
+        }
+        
         void LiteralExpression::doAppendToStream(std::ostream& str) const {
             m_value.appendToStream(str, false);
         }
 
+        void LiteralExpression::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Literal, m_line, m_column);
+            writer.writeValue(m_value);
+        }
+
         VariableExpression::VariableExpression(const String& variableName, const size_t line, const size_t column) :
         ExpressionBase(line, column),
         m_variableName(variableName) {}
@@ -159,10 +204,23 @@ namespace TrenchBroom {
             return context.variableValue(m_variableName);
         }
         
+        void VariableExpression::doCompile(Program& program) const {
+            const size_t slot = program.addVariable(m_variableName);
+            if (m_variableName == RangeOperator::AutoRangeParameterName())
+                program.emit(Program::Op_LoadAutoRange, m_line, m_column, slot);
+            else
+                program.emit(Program::Op_LoadVariable, m_line, m_column, slot);
+        }
+        
         void VariableExpression::doAppendToStream(std::ostream& str) const {
             str << m_variableName;
         }
 
+        void VariableExpression::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Variable, m_line, m_column);
+            writer.writeString(m_variableName);
+        }
+
         ArrayExpression::ArrayExpression(const ExpressionBase::List& elements, const size_t line, const size_t column) :
         ExpressionBase(line, column),
         m_elements(elements) {}
@@ -215,6 +273,12 @@ namespace TrenchBroom {
             return Value(array, m_line, m_column);
         }
         
+        void ArrayExpression::doCompile(Program& program) const {
+            for (const ExpressionBase* element : m_elements)
+                element->compile(program);
+            program.emit(Program::Op_MakeArray, m_line, m_column, m_elements.size());
+        }
+        
         void ArrayExpression::doAppendToStream(std::ostream& str) const {
             str << "[ ";
             
@@ -229,6 +293,13 @@ namespace TrenchBroom {
             str << "] ";
         }
 
+        void ArrayExpression::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Array, m_line, m_column);
+            writer.writeSize(m_elements.size());
+            for (const ExpressionBase* expression : m_elements)
+                writer.writeExpression(*expression);
+        }
+
         MapExpression::MapExpression(const ExpressionBase::Map& elements, const size_t line, const size_t column) :
         ExpressionBase(line, column),
         m_elements(elements) {}
@@ -280,6 +351,16 @@ namespace TrenchBroom {
             return Value(map, m_line, m_column);
         }
         
+        void MapExpression::doCompile(Program& program) const {
+            StringList keys;
+            keys.reserve(m_elements.size());
+            for (const auto& entry : m_elements) {
+                entry.second->compile(program);
+                keys.push_back(entry.first);
+            }
+            program.emit(Program::Op_MakeMap, m_line, m_column, program.addKeys(keys));
+        }
+        
         void MapExpression::doAppendToStream(std::ostream& str) const {
             str << "{ ";
             size_t i = 0;
@@ -295,6 +376,15 @@ namespace TrenchBroom {
             str << " }";
         }
 
+        void MapExpression::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Map, m_line, m_column);
+            writer.writeSize(m_elements.size());
+            for (const auto& entry : m_elements) {
+                writer.writeString(entry.first);
+                writer.writeExpression(*entry.second);
+            }
+        }
+
         UnaryOperator::UnaryOperator(ExpressionBase* operand, const size_t line, const size_t column) :
         ExpressionBase(line, column),
         m_operand(operand) {
@@ -330,10 +420,20 @@ namespace TrenchBroom {
             return Value(+m_operand->evaluate(context), m_line, m_column);
         }
         
+        void UnaryPlusOperator::doCompile(Program& program) const {
+            m_operand->compile(program);
+            program.emit(Program::Op_UnaryPlus, m_line, m_column);
+        }
+        
         void UnaryPlusOperator::doAppendToStream(std::ostream& str) const {
             str << "+" << *m_operand;
         }
 
+        void UnaryPlusOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_UnaryPlus, m_line, m_column);
+            writer.writeExpression(*m_operand);
+        }
+
         UnaryMinusOperator::UnaryMinusOperator(ExpressionBase* operand, const size_t line, const size_t column) :
         UnaryOperator(operand, line, column) {}
         
@@ -349,10 +449,20 @@ namespace TrenchBroom {
             return Value(-m_operand->evaluate(context), m_line, m_column);
         }
         
+        void UnaryMinusOperator::doCompile(Program& program) const {
+            m_operand->compile(program);
+            program.emit(Program::Op_UnaryMinus, m_line, m_column);
+        }
+        
         void UnaryMinusOperator::doAppendToStream(std::ostream& str) const {
             str << "-" << *m_operand;
         }
 
+        void UnaryMinusOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_UnaryMinus, m_line, m_column);
+            writer.writeExpression(*m_operand);
+        }
+
         LogicalNegationOperator::LogicalNegationOperator(ExpressionBase* operand, const size_t line, const size_t column) :
         UnaryOperator(operand, line, column) {}
         
@@ -368,10 +478,20 @@ namespace TrenchBroom {
             return Value(!m_operand->evaluate(context), m_line, m_column);
         }
         
+        void LogicalNegationOperator::doCompile(Program& program) const {
+            m_operand->compile(program);
+            program.emit(Program::Op_LogicalNegation, m_line, m_column);
+        }
+        
         void LogicalNegationOperator::doAppendToStream(std::ostream& str) const {
             str << "!" << *m_operand;
         }
 
+        void LogicalNegationOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_LogicalNegation, m_line, m_column);
+            writer.writeExpression(*m_operand);
+        }
+
         BitwiseNegationOperator::BitwiseNegationOperator(ExpressionBase* operand, const size_t line, const size_t column) :
         UnaryOperator(operand, line, column) {}
 
@@ -386,11 +506,21 @@ namespace TrenchBroom {
         Value BitwiseNegationOperator::doEvaluate(const EvaluationContext& context) const {
             return Value(~m_operand->evaluate(context), m_line, m_column);
         }
+        
+        void BitwiseNegationOperator::doCompile(Program& program) const {
+            m_operand->compile(program);
+            program.emit(Program::Op_BitwiseNegation, m_line, m_column);
+        }
 
         void BitwiseNegationOperator::doAppendToStream(std::ostream& str) const {
             str << "~" << *m_operand;
         }
 
+        void BitwiseNegationOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_BitwiseNegation, m_line, m_column);
+            writer.writeExpression(*m_operand);
+        }
+
         GroupingOperator::GroupingOperator(ExpressionBase* operand, const size_t line, const size_t column) :
         UnaryOperator(operand, line, column) {}
         
@@ -406,10 +536,20 @@ namespace TrenchBroom {
             return Value(m_operand->evaluate(context), m_line, m_column);
         }
         
+        void GroupingOperator::doCompile(Program& program) const {
+            m_operand->compile(program);
+            program.emit(Program::Op_Group, m_line, m_column);
+        }
+        
         void GroupingOperator::doAppendToStream(std::ostream& str) const {
             str << "( " << *m_operand << " )";
         }
 
+        void GroupingOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Grouping, m_line, m_column);
+            writer.writeExpression(*m_operand);
+        }
+
         SubscriptOperator::SubscriptOperator(ExpressionBase* indexableOperand, ExpressionBase* indexOperand, const size_t line, const size_t column) :
         ExpressionBase(line, column),
         m_indexableOperand(indexableOperand),
@@ -454,10 +594,23 @@ namespace TrenchBroom {
             return indexableValue[indexValue];
         }
         
+        void SubscriptOperator::doCompile(Program& program) const {
+            m_indexableOperand->compile(program);
+            program.emit(Program::Op_BeginSubscript, m_line, m_column);
+            m_indexOperand->compile(program);
+            program.emit(Program::Op_EndSubscript, m_line, m_column);
+        }
+        
         void SubscriptOperator::doAppendToStream(std::ostream& str) const {
             str << *m_indexableOperand << "[" << *m_indexOperand << "]";
         }
 
+        void SubscriptOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Subscript, m_line, m_column);
+            writer.writeExpression(*m_indexableOperand);
+            writer.writeExpression(*m_indexOperand);
+        }
+
         BinaryOperator::BinaryOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, const size_t line, const size_t column) :
         ExpressionBase(line, column),
         m_leftOperand(leftOperand),
@@ -563,9 +716,21 @@ namespace TrenchBroom {
             return Value(leftValue + rightValue, m_line, m_column);
         }
         
+        void AdditionOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_Add, m_line, m_column);
+        }
+        
         void AdditionOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " + " << *m_rightOperand;
         }
+
+        void AdditionOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Addition, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits AdditionOperator::doGetTraits() const {
             return Traits(10, true, true);
@@ -588,10 +753,22 @@ namespace TrenchBroom {
             return Value(leftValue - rightValue, m_line, m_column);
         }
         
+        void SubtractionOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_Subtract, m_line, m_column);
+        }
+        
         void SubtractionOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " - " << *m_rightOperand;
         }
 
+        void SubtractionOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Subtraction, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
+
         BinaryOperator::Traits SubtractionOperator::doGetTraits() const {
             return Traits(10, false, false);
         }
@@ -613,9 +790,21 @@ namespace TrenchBroom {
             return Value(leftValue * rightValue, m_line, m_column);
         }
         
+        void MultiplicationOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_Multiply, m_line, m_column);
+        }
+        
         void MultiplicationOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " * " << *m_rightOperand;
         }
+
+        void MultiplicationOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Multiplication, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits MultiplicationOperator::doGetTraits() const {
             return Traits(11, true, true);
@@ -638,9 +827,21 @@ namespace TrenchBroom {
             return Value(leftValue / rightValue, m_line, m_column);
         }
         
+        void DivisionOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_Divide, m_line, m_column);
+        }
+        
         void DivisionOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " / " << *m_rightOperand;
         }
+
+        void DivisionOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Division, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits DivisionOperator::doGetTraits() const {
             return Traits(11, false, false);
@@ -663,9 +864,21 @@ namespace TrenchBroom {
             return Value(leftValue % rightValue, m_line, m_column);
         }
         
+        void ModulusOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_Modulus, m_line, m_column);
+        }
+        
         void ModulusOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " % " << *m_rightOperand;
         }
+
+        void ModulusOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Modulus, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits ModulusOperator::doGetTraits() const {
             return Traits(11, false, false);
@@ -676,6 +889,29 @@ namespace TrenchBroom {
             return Name;
         }
         
+        Value RangeOperator::createRange(const Value& leftValue, const Value& rightValue, const size_t line, const size_t column) {
+            const long from = static_cast<long>(leftValue.convertTo(Type_Number).numberValue());
+            const long to = static_cast<long>(rightValue.convertTo(Type_Number).numberValue());
+            
+            RangeType range;
+            if (from <= to) {
+                range.reserve(static_cast<size_t>(to - from + 1));
+                for (long i = from; i <= to; ++i) {
+                    assert(range.capacity() > range.size());
+                    range.push_back(i);
+                }
+            } else if (to < from) {
+                range.reserve(static_cast<size_t>(from - to + 1));
+                for (long i = from; i >= to; --i) {
+                    assert(range.capacity() > range.size());
+                    range.push_back(i);
+                }
+            }
+            assert(range.capacity() == range.size());
+            
+            return Value(range, line, column);
+        }
+        
         LogicalAndOperator::LogicalAndOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, const size_t line, const size_t column) :
         BinaryOperator(leftOperand, rightOperand, line, column) {}
         
@@ -691,9 +927,23 @@ namespace TrenchBroom {
             return Value(m_leftOperand->evaluate(context) && m_rightOperand->evaluate(context), m_line, m_column);
         }
         
+        void LogicalAndOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            const size_t jump = program.emitJump(Program::Op_JumpIfFalse, m_line, m_column);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_ToBoolean, m_line, m_column);
+            program.patchJump(jump);
+        }
+        
         void LogicalAndOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " && " << *m_rightOperand;
         }
+
+        void LogicalAndOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_LogicalAnd, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits LogicalAndOperator::doGetTraits() const {
             return Traits(3, true, true);
@@ -714,9 +964,23 @@ namespace TrenchBroom {
             return Value(m_leftOperand->evaluate(context) || m_rightOperand->evaluate(context), m_line, m_column);
         }
         
+        void LogicalOrOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            const size_t jump = program.emitJump(Program::Op_JumpIfTrue, m_line, m_column);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_ToBoolean, m_line, m_column);
+            program.patchJump(jump);
+        }
+        
         void LogicalOrOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " || " << *m_rightOperand;
         }
+
+        void LogicalOrOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_LogicalOr, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits LogicalOrOperator::doGetTraits() const {
             return Traits(2, true, true);
@@ -737,9 +1001,21 @@ namespace TrenchBroom {
             return Value(m_leftOperand->evaluate(context) & m_rightOperand->evaluate(context), m_line, m_column);
         }
         
+        void BitwiseAndOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_BitwiseAnd, m_line, m_column);
+        }
+        
         void BitwiseAndOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " & " << *m_rightOperand;
         }
+
+        void BitwiseAndOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_BitwiseAnd, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits BitwiseAndOperator::doGetTraits() const {
             return Traits(6, true, true);
@@ -760,9 +1036,21 @@ namespace TrenchBroom {
             return Value(m_leftOperand->evaluate(context) ^ m_rightOperand->evaluate(context), m_line, m_column);
         }
         
+        void BitwiseXorOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_BitwiseXor, m_line, m_column);
+        }
+        
         void BitwiseXorOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " ^ " << *m_rightOperand;
         }
+
+        void BitwiseXorOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_BitwiseXor, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits BitwiseXorOperator::doGetTraits() const {
             return Traits(5, true, true);
@@ -783,9 +1071,21 @@ namespace TrenchBroom {
             return Value(m_leftOperand->evaluate(context) | m_rightOperand->evaluate(context), m_line, m_column);
         }
         
+        void BitwiseOrOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_BitwiseOr, m_line, m_column);
+        }
+        
         void BitwiseOrOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " | " << *m_rightOperand;
         }
+
+        void BitwiseOrOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_BitwiseOr, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits BitwiseOrOperator::doGetTraits() const {
             return Traits(4, true, true);
@@ -806,9 +1106,21 @@ namespace TrenchBroom {
             return Value(m_leftOperand->evaluate(context) << m_rightOperand->evaluate(context), m_line, m_column);
         }
         
+        void BitwiseShiftLeftOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_BitwiseShiftLeft, m_line, m_column);
+        }
+        
         void BitwiseShiftLeftOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " << " << *m_rightOperand;
         }
+
+        void BitwiseShiftLeftOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_BitwiseShiftLeft, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits BitwiseShiftLeftOperator::doGetTraits() const {
             return Traits(9, true, true);
@@ -829,9 +1141,21 @@ namespace TrenchBroom {
             return Value(m_leftOperand->evaluate(context) >> m_rightOperand->evaluate(context), m_line, m_column);
         }
         
+        void BitwiseShiftRightOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_BitwiseShiftRight, m_line, m_column);
+        }
+        
         void BitwiseShiftRightOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " >> " << *m_rightOperand;
         }
+
+        void BitwiseShiftRightOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_BitwiseShiftRight, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits BitwiseShiftRightOperator::doGetTraits() const {
             return Traits(9, true, true);
@@ -887,6 +1211,32 @@ namespace TrenchBroom {
             }
         }
         
+        void ComparisonOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            switch (m_op) {
+                case Op_Less:
+                    program.emit(Program::Op_Less, m_line, m_column);
+                    break;
+                case Op_LessOrEqual:
+                    program.emit(Program::Op_LessOrEqual, m_line, m_column);
+                    break;
+                case Op_Equal:
+                    program.emit(Program::Op_Equal, m_line, m_column);
+                    break;
+                case Op_Inequal:
+                    program.emit(Program::Op_Inequal, m_line, m_column);
+                    break;
+                case Op_GreaterOrEqual:
+                    program.emit(Program::Op_GreaterOrEqual, m_line, m_column);
+                    break;
+                case Op_Greater:
+                    program.emit(Program::Op_Greater, m_line, m_column);
+                    break;
+                switchDefault()
+            }
+        }
+        
         void ComparisonOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand;
             switch (m_op) {
@@ -912,6 +1262,32 @@ namespace TrenchBroom {
             }
             str << *m_rightOperand;
         }
+
+        void ComparisonOperator::doWrite(ExpressionWriter& writer) const {
+            switch (m_op) {
+                case Op_Less:
+                    writer.writeNode(ExpressionWriter::Node_Less, m_line, m_column);
+                    break;
+                case Op_LessOrEqual:
+                    writer.writeNode(ExpressionWriter::Node_LessOrEqual, m_line, m_column);
+                    break;
+                case Op_Equal:
+                    writer.writeNode(ExpressionWriter::Node_Equal, m_line, m_column);
+                    break;
+                case Op_Inequal:
+                    writer.writeNode(ExpressionWriter::Node_Inequal, m_line, m_column);
+                    break;
+                case Op_GreaterOrEqual:
+                    writer.writeNode(ExpressionWriter::Node_GreaterOrEqual, m_line, m_column);
+                    break;
+                case Op_Greater:
+                    writer.writeNode(ExpressionWriter::Node_Greater, m_line, m_column);
+                    break;
+                switchDefault()
+            }
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits ComparisonOperator::doGetTraits() const {
             switch (m_op) {
@@ -949,32 +1325,24 @@ namespace TrenchBroom {
         Value RangeOperator::doEvaluate(const EvaluationContext& context) const {
             const Value leftValue = m_leftOperand->evaluate(context);
             const Value rightValue = m_rightOperand->evaluate(context);
-            
-            const long from = static_cast<long>(leftValue.convertTo(Type_Number).numberValue());
-            const long to = static_cast<long>(rightValue.convertTo(Type_Number).numberValue());
-            
-            RangeType range;
-            if (from <= to) {
-                range.reserve(static_cast<size_t>(to - from + 1));
-                for (long i = from; i <= to; ++i) {
-                    assert(range.capacity() > range.size());
-                    range.push_back(i);
-                }
-            } else if (to < from) {
-                range.reserve(static_cast<size_t>(from - to + 1));
-                for (long i = from; i >= to; --i) {
-                    assert(range.capacity() > range.size());
-                    range.push_back(i);
-                }
-            }
-            assert(range.capacity() == range.size());
-            
-            return Value(range, m_line, m_column);
+            return createRange(leftValue, rightValue, m_line, m_column);
+        }
+        
+        void RangeOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            m_rightOperand->compile(program);
+            program.emit(Program::Op_Range, m_line, m_column);
         }
         
         void RangeOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << ".." << *m_rightOperand;
         }
+
+        void RangeOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Range, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits RangeOperator::doGetTraits() const {
             return Traits(1, false, false);
@@ -998,9 +1366,22 @@ namespace TrenchBroom {
             return Value::Undefined;
         }
         
+        void CaseOperator::doCompile(Program& program) const {
+            m_leftOperand->compile(program);
+            const size_t jump = program.emitJump(Program::Op_CaseJump, m_line, m_column);
+            m_rightOperand->compile(program);
+            program.patchJump(jump);
+        }
+        
         void CaseOperator::doAppendToStream(std::ostream& str) const {
             str << *m_leftOperand << " -> " << *m_rightOperand;
         }
+
+        void CaseOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Case, m_line, m_column);
+            writer.writeExpression(*m_leftOperand);
+            writer.writeExpression(*m_rightOperand);
+        }
         
         BinaryOperator::Traits CaseOperator::doGetTraits() const {
             return Traits(0, false, false);
@@ -1050,6 +1431,18 @@ namespace TrenchBroom {
             }
             return Value::Undefined;
         }
+        
+        void SwitchOperator::doCompile(Program& program) const {
+            std::vector<size_t> jumps;
+            jumps.reserve(m_cases.size());
+            for (const ExpressionBase* case_ : m_cases) {
+                case_->compile(program);
+                jumps.push_back(program.emitJump(Program::Op_SwitchJump, m_line, m_column));
+            }
+            program.emit(Program::Op_PushConstant, m_line, m_column, program.addConstant(Value::Undefined));
+            for (const size_t jump : jumps)
+                program.patchJump(jump);
+        }
 
         void SwitchOperator::doAppendToStream(std::ostream& str) const {
             str << "{{ ";
@@ -1062,5 +1455,12 @@ namespace TrenchBroom {
             }
             str << " }}";
         }
+
+        void SwitchOperator::doWrite(ExpressionWriter& writer) const {
+            writer.writeNode(ExpressionWriter::Node_Switch, m_line, m_column);
+            writer.writeSize(m_cases.size());
+            for (const ExpressionBase* expression : m_cases)
+                writer.writeExpression(*expression);
+        }
     }
 }
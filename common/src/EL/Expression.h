@@ -31,22 +31,49 @@ namespace TrenchBroom {
     namespace EL {
         class EvaluationContext;
         class ExpressionBase;
+        class ExpressionReader;
+        class ExpressionWriter;
+        class Program;
         
         class Expression {
         private:
             typedef std::shared_ptr<ExpressionBase> ExpressionPtr;
             ExpressionPtr m_expression;
+
+            struct CompiledProgram;
+            typedef std::shared_ptr<CompiledProgram> CompiledProgramPtr;
+            CompiledProgramPtr m_program;
         public:
             Expression(ExpressionBase* expression);
             
             bool optimize();
+
+            /**
+             * Evaluates this expression in the given context. The expression is compiled into a program on its first
+             * evaluation, and the program is shared by all copies of this expression.
+             *
+             * @param context the evaluation context
+             * @return the resulting value
+             */
             Value evaluate(const EvaluationContext& context) const;
+
+            /**
+             * Returns the names of the variables that this expression depends on. Like evaluate(), this compiles the
+             * expression if it has not been compiled yet.
+             *
+             * @return the variable names in the order of their first appearance
+             */
+            const StringList& variables() const;
             ExpressionBase* clone() const;
             
             size_t line() const;
             size_t column() const;
             String asString() const;
             friend std::ostream& operator<<(std::ostream& stream, const Expression& expression);
+
+            void write(ExpressionWriter& writer) const;
+        private:
+            const Program& program() const;
         };
         
         class BinaryOperator;
@@ -73,6 +100,8 @@ namespace TrenchBroom {
             ExpressionBase* clone() const;
             ExpressionBase* optimize();
             Value evaluate(const EvaluationContext& context) const;
+            void compile(Program& program) const;
+            void write(ExpressionWriter& writer) const;
             
             String asString() const;
             void appendToStream(std::ostream& str) const;
@@ -83,7 +112,9 @@ namespace TrenchBroom {
             virtual ExpressionBase* doClone() const = 0;
             virtual ExpressionBase* doOptimize() = 0;
             virtual Value doEvaluate(const EvaluationContext& context) const = 0;
+            virtual void doCompile(Program& program) const = 0;
             virtual void doAppendToStream(std::ostream& str) const = 0;
+            virtual void doWrite(ExpressionWriter& writer) const = 0;
             
             deleteCopyAndAssignment(ExpressionBase)
         };
@@ -99,7 +130,9 @@ namespace TrenchBroom {
             ExpressionBase* doClone() const override;
             ExpressionBase* doOptimize() override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(LiteralExpression)
         };
@@ -115,7 +148,9 @@ namespace TrenchBroom {
             ExpressionBase* doClone() const override;
             ExpressionBase* doOptimize() override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(VariableExpression)
         };
@@ -132,7 +167,9 @@ namespace TrenchBroom {
             ExpressionBase* doClone() const override;
             ExpressionBase* doOptimize() override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(ArrayExpression)
         };
@@ -149,7 +186,9 @@ namespace TrenchBroom {
             ExpressionBase* doClone() const override;
             ExpressionBase* doOptimize() override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(MapExpression)
         };
@@ -174,7 +213,9 @@ namespace TrenchBroom {
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(UnaryPlusOperator)
         };
@@ -187,7 +228,9 @@ namespace TrenchBroom {
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(UnaryMinusOperator)
         };
@@ -200,7 +243,9 @@ namespace TrenchBroom {
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(LogicalNegationOperator)
         };
@@ -213,7 +258,9 @@ namespace TrenchBroom {
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(BitwiseNegationOperator)
         };
@@ -226,7 +273,9 @@ namespace TrenchBroom {
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(GroupingOperator)
         };
@@ -236,6 +285,7 @@ namespace TrenchBroom {
             ExpressionBase* m_indexableOperand;
             ExpressionBase* m_indexOperand;
         private:
+            friend class ExpressionReader;
             SubscriptOperator(ExpressionBase* indexableOperand, ExpressionBase* indexOperand, size_t line, size_t column);
         public:
             ~SubscriptOperator() override;
@@ -245,7 +295,9 @@ namespace TrenchBroom {
             ExpressionBase* doClone() const override;
             ExpressionBase* doOptimize() override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             
             deleteCopyAndAssignment(SubscriptOperator)
         };
@@ -281,13 +333,16 @@ namespace TrenchBroom {
         
         class AdditionOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             AdditionOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(AdditionOperator)
@@ -295,13 +350,16 @@ namespace TrenchBroom {
         
         class SubtractionOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             SubtractionOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(SubtractionOperator)
@@ -309,13 +367,16 @@ namespace TrenchBroom {
         
         class MultiplicationOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             MultiplicationOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(MultiplicationOperator)
@@ -323,13 +384,16 @@ namespace TrenchBroom {
         
         class DivisionOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             DivisionOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(DivisionOperator)
@@ -337,13 +401,16 @@ namespace TrenchBroom {
         
         class ModulusOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             ModulusOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(ModulusOperator)
@@ -351,13 +418,16 @@ namespace TrenchBroom {
         
         class LogicalAndOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             LogicalAndOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(LogicalAndOperator)
@@ -365,13 +435,16 @@ namespace TrenchBroom {
         
         class LogicalOrOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             LogicalOrOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(LogicalOrOperator)
@@ -379,13 +452,16 @@ namespace TrenchBroom {
         
         class BitwiseAndOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             BitwiseAndOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(BitwiseAndOperator)
@@ -393,13 +469,16 @@ namespace TrenchBroom {
         
         class BitwiseXorOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             BitwiseXorOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(BitwiseXorOperator)
@@ -407,13 +486,16 @@ namespace TrenchBroom {
         
         class BitwiseOrOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             BitwiseOrOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(BitwiseOrOperator)
@@ -421,13 +503,16 @@ namespace TrenchBroom {
         
         class BitwiseShiftLeftOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             BitwiseShiftLeftOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(BitwiseShiftLeftOperator)
@@ -435,13 +520,16 @@ namespace TrenchBroom {
         
         class BitwiseShiftRightOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             BitwiseShiftRightOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(BitwiseShiftRightOperator)
@@ -459,6 +547,7 @@ namespace TrenchBroom {
             } Op;
             Op m_op;
         private:
+            friend class ExpressionReader;
             ComparisonOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, Op op, size_t line, size_t column);
         public:
             static ExpressionBase* createLess(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
@@ -470,7 +559,9 @@ namespace TrenchBroom {
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(ComparisonOperator)
@@ -479,7 +570,9 @@ namespace TrenchBroom {
         class RangeOperator : public BinaryOperator {
         public:
             static const String& AutoRangeParameterName();
+            static Value createRange(const Value& leftValue, const Value& rightValue, size_t line, size_t column);
         private:
+            friend class ExpressionReader;
             RangeOperator(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* leftOperand, ExpressionBase* rightOperand, size_t line, size_t column);
@@ -488,7 +581,9 @@ namespace TrenchBroom {
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(RangeOperator)
@@ -496,13 +591,16 @@ namespace TrenchBroom {
 
         class CaseOperator : public BinaryOperator {
         private:
+            friend class ExpressionReader;
             CaseOperator(ExpressionBase* premise, ExpressionBase* conclusion, size_t line, size_t column);
         public:
             static ExpressionBase* create(ExpressionBase* premise, ExpressionBase* conclusion, size_t line, size_t column);
         private:
             ExpressionBase* doClone() const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Traits doGetTraits() const override;
             
             deleteCopyAndAssignment(CaseOperator)
@@ -521,7 +619,9 @@ namespace TrenchBroom {
             ExpressionBase* doClone() const override;
             ExpressionBase* doOptimize() override;
             void doAppendToStream(std::ostream& str) const override;
+            void doWrite(ExpressionWriter& writer) const override;
             Value doEvaluate(const EvaluationContext& context) const override;
+            void doCompile(Program& program) const override;
             
             deleteCopyAndAssignment(SwitchOperator)
         };
@@ -0,0 +1,273 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ExpressionIO.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace EL {
+        void ExpressionWriter::writeExpression(const Expression& expression) {
+            expression.write(*this);
+        }
+
+        void ExpressionWriter::writeExpression(const ExpressionBase& expression) {
+            expression.write(*this);
+        }
+
+        void ExpressionWriter::writeNode(const NodeType type, const size_t line, const size_t column) {
+            write(static_cast<uint8_t>(type));
+            writeSize(line);
+            writeSize(column);
+        }
+
+        void ExpressionWriter::writeValue(const Value& value) {
+            write(static_cast<uint8_t>(value.type()));
+            writeSize(value.line());
+            writeSize(value.column());
+
+            switch (value.type()) {
+                case Type_Boolean:
+                    write(static_cast<uint8_t>(value.booleanValue() ? 1 : 0));
+                    break;
+                case Type_String:
+                    writeString(value.stringValue());
+                    break;
+                case Type_Number:
+                    write(value.numberValue());
+                    break;
+                case Type_Array:
+                    writeSize(value.arrayValue().size());
+                    for (const Value& element : value.arrayValue())
+                        writeValue(element);
+                    break;
+                case Type_Map:
+                    writeSize(value.mapValue().size());
+                    for (const auto& entry : value.mapValue()) {
+                        writeString(entry.first);
+                        writeValue(entry.second);
+                    }
+                    break;
+                case Type_Range:
+                    writeSize(value.rangeValue().size());
+                    for (const long index : value.rangeValue())
+                        write(static_cast<int64_t>(index));
+                    break;
+                case Type_Null:
+                case Type_Undefined:
+                    break;
+            }
+        }
+
+        void ExpressionWriter::writeString(const String& str) {
+            writeSize(str.size());
+            m_data.append(str);
+        }
+
+        void ExpressionWriter::writeSize(const size_t size) {
+            write(static_cast<uint64_t>(size));
+        }
+
+        const String& ExpressionWriter::data() const {
+            return m_data;
+        }
+
+        ExpressionReader::ExpressionReader(const char* begin, const char* end) :
+        m_begin(begin),
+        m_end(end),
+        m_current(m_begin) {}
+
+        ExpressionReader::ExpressionReader(const String& data) :
+        ExpressionReader(data.data(), data.data() + data.size()) {}
+
+        Expression ExpressionReader::readExpression() {
+            return Expression(readNode());
+        }
+
+        ExpressionBase* ExpressionReader::readNode() {
+            using NodeType = ExpressionWriter::NodeType;
+
+            const auto type = static_cast<NodeType>(read<uint8_t>());
+            const size_t line = readSize();
+            const size_t column = readSize();
+
+            switch (type) {
+                case ExpressionWriter::Node_Literal:
+                    return LiteralExpression::create(readValue(), line, column);
+                case ExpressionWriter::Node_Variable:
+                    return VariableExpression::create(readString(), line, column);
+                case ExpressionWriter::Node_Array:
+                    return ArrayExpression::create(readNodes(), line, column);
+                case ExpressionWriter::Node_Map: {
+                    const size_t count = readSize();
+                    std::vector<std::pair<String, ExpressionBase::Ptr>> elements;
+                    for (size_t i = 0; i < count; ++i) {
+                        String key = readString();
+                        elements.emplace_back(std::move(key), ExpressionBase::Ptr(readNode()));
+                    }
+
+                    ExpressionBase::Map map;
+                    for (auto& element : elements)
+                        map.insert(std::make_pair(element.first, element.second.release()));
+                    return MapExpression::create(map, line, column);
+                }
+                case ExpressionWriter::Node_UnaryPlus:
+                    return UnaryPlusOperator::create(readNode(), line, column);
+                case ExpressionWriter::Node_UnaryMinus:
+                    return UnaryMinusOperator::create(readNode(), line, column);
+                case ExpressionWriter::Node_LogicalNegation:
+                    return LogicalNegationOperator::create(readNode(), line, column);
+                case ExpressionWriter::Node_BitwiseNegation:
+                    return BitwiseNegationOperator::create(readNode(), line, column);
+                case ExpressionWriter::Node_Grouping:
+                    return GroupingOperator::create(readNode(), line, column);
+                case ExpressionWriter::Node_Switch:
+                    return SwitchOperator::create(readNodes(), line, column);
+                default:
+                    break;
+            }
+
+            /*
+             All remaining nodes have two operands. Their constructors are used instead of their factory functions,
+             which would reorder the operands by precedence again and thus could change the tree.
+             */
+            ExpressionBase::Ptr left(readNode());
+            ExpressionBase::Ptr right(readNode());
+
+            switch (type) {
+                case ExpressionWriter::Node_Subscript:
+                    return new SubscriptOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Addition:
+                    return new AdditionOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Subtraction:
+                    return new SubtractionOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Multiplication:
+                    return new MultiplicationOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Division:
+                    return new DivisionOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Modulus:
+                    return new ModulusOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_LogicalAnd:
+                    return new LogicalAndOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_LogicalOr:
+                    return new LogicalOrOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_BitwiseAnd:
+                    return new BitwiseAndOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_BitwiseXor:
+                    return new BitwiseXorOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_BitwiseOr:
+                    return new BitwiseOrOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_BitwiseShiftLeft:
+                    return new BitwiseShiftLeftOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_BitwiseShiftRight:
+                    return new BitwiseShiftRightOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Range:
+                    return new RangeOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Case:
+                    return new CaseOperator(left.release(), right.release(), line, column);
+                case ExpressionWriter::Node_Less:
+                    return new ComparisonOperator(left.release(), right.release(), ComparisonOperator::Op_Less, line, column);
+                case ExpressionWriter::Node_LessOrEqual:
+                    return new ComparisonOperator(left.release(), right.release(), ComparisonOperator::Op_LessOrEqual, line, column);
+                case ExpressionWriter::Node_Equal:
+                    return new ComparisonOperator(left.release(), right.release(), ComparisonOperator::Op_Equal, line, column);
+                case ExpressionWriter::Node_Inequal:
+                    return new ComparisonOperator(left.release(), right.release(), ComparisonOperator::Op_Inequal, line, column);
+                case ExpressionWriter::Node_GreaterOrEqual:
+                    return new ComparisonOperator(left.release(), right.release(), ComparisonOperator::Op_GreaterOrEqual, line, column);
+                case ExpressionWriter::Node_Greater:
+                    return new ComparisonOperator(left.release(), right.release(), ComparisonOperator::Op_Greater, line, column);
+                default:
+                    throw Exception("Unknown expression node type in expression data");
+            }
+        }
+
+        ExpressionBase::List ExpressionReader::readNodes() {
+            const size_t count = readSize();
+            std::vector<ExpressionBase::Ptr> nodes;
+            for (size_t i = 0; i < count; ++i)
+                nodes.emplace_back(readNode());
+
+            ExpressionBase::List result;
+            for (auto& node : nodes)
+                result.push_back(node.release());
+            return result;
+        }
+
+        Value ExpressionReader::readValue() {
+            const auto type = static_cast<ValueType>(read<uint8_t>());
+            const size_t line = readSize();
+            const size_t column = readSize();
+
+            switch (type) {
+                case Type_Boolean:
+                    return Value(read<uint8_t>() != 0, line, column);
+                case Type_String:
+                    return Value(readString(), line, column);
+                case Type_Number:
+                    return Value(read<NumberType>(), line, column);
+                case Type_Array: {
+                    const size_t count = readSize();
+                    ArrayType array;
+                    for (size_t i = 0; i < count; ++i)
+                        array.push_back(readValue());
+                    return Value(std::move(array), line, column);
+                }
+                case Type_Map: {
+                    const size_t count = readSize();
+                    MapType map;
+                    for (size_t i = 0; i < count; ++i) {
+                        String key = readString();
+                        map.insert(std::make_pair(std::move(key), readValue()));
+                    }
+                    return Value(std::move(map), line, column);
+                }
+                case Type_Range: {
+                    const size_t count = readSize();
+                    RangeType range;
+                    for (size_t i = 0; i < count; ++i)
+                        range.push_back(static_cast<long>(read<int64_t>()));
+                    return Value(range, line, column);
+                }
+                case Type_Null:
+                    return Value(Value::Null, line, column);
+                case Type_Undefined:
+                    return Value(Value::Undefined, line, column);
+                default:
+                    throw Exception("Unknown value type in expression data");
+            }
+        }
+
+        String ExpressionReader::readString() {
+            const size_t size = readSize();
+            if (static_cast<size_t>(m_end - m_current) < size)
+                throw Exception("Unexpected end of expression data");
+            String result(m_current, size);
+            m_current += size;
+            return result;
+        }
+
+        size_t ExpressionReader::readSize() {
+            return static_cast<size_t>(read<uint64_t>());
+        }
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_ExpressionIO_h
+#define TrenchBroom_ExpressionIO_h
+
+#include "StringUtils.h"
+#include "EL/ELExceptions.h"
+#include "EL/Expression.h"
+#include "EL/Value.h"
+
+#include <cstring>
+
+namespace TrenchBroom {
+    namespace EL {
+        /**
+         * Writes expression trees in a binary form that reproduces them exactly, including the line and column of
+         * every node and value. Unlike the string representation of an expression, this form does not depend on the
+         * expression being valid input for the parser. Values are stored in the native byte order, so the data must
+         * only be read on the machine that wrote it.
+         */
+        class ExpressionWriter {
+        public:
+            typedef enum {
+                Node_Literal,
+                Node_Variable,
+                Node_Array,
+                Node_Map,
+                Node_UnaryPlus,
+                Node_UnaryMinus,
+                Node_LogicalNegation,
+                Node_BitwiseNegation,
+                Node_Grouping,
+                Node_Subscript,
+                Node_Addition,
+                Node_Subtraction,
+                Node_Multiplication,
+                Node_Division,
+                Node_Modulus,
+                Node_LogicalAnd,
+                Node_LogicalOr,
+                Node_BitwiseAnd,
+                Node_BitwiseXor,
+                Node_BitwiseOr,
+                Node_BitwiseShiftLeft,
+                Node_BitwiseShiftRight,
+                Node_Less,
+                Node_LessOrEqual,
+                Node_Equal,
+                Node_Inequal,
+                Node_GreaterOrEqual,
+                Node_Greater,
+                Node_Range,
+                Node_Case,
+                Node_Switch
+            } NodeType;
+        private:
+            String m_data;
+        public:
+            void writeExpression(const Expression& expression);
+            void writeExpression(const ExpressionBase& expression);
+
+            /**
+             * Writes the type and position of a node. This and the following functions are used by the expression
+             * nodes to write themselves, followed by their contents and their child nodes.
+             */
+            void writeNode(NodeType type, size_t line, size_t column);
+            void writeValue(const Value& value);
+            void writeString(const String& str);
+            void writeSize(size_t size);
+
+            const String& data() const;
+        private:
+            template <typename T>
+            void write(const T value) {
+                m_data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+        };
+
+        /**
+         * Reads expression trees that were written by an ExpressionWriter.
+         */
+        class ExpressionReader {
+        private:
+            const char* m_begin;
+            const char* m_end;
+            const char* m_current;
+        public:
+            ExpressionReader(const char* begin, const char* end);
+            explicit ExpressionReader(const String& data);
+
+            /**
+             * Reads an expression tree.
+             *
+             * @return the expression
+             * @throws Exception if the data is truncated or corrupt
+             */
+            Expression readExpression();
+        private:
+            ExpressionBase* readNode();
+            ExpressionBase::List readNodes();
+            Value readValue();
+            String readString();
+            size_t readSize();
+
+            template <typename T>
+            T read() {
+                if (static_cast<size_t>(m_end - m_current) < sizeof(T))
+                    throw Exception("Unexpected end of expression data");
+                T result;
+                std::memcpy(&result, m_current, sizeof(T));
+                m_current += sizeof(T);
+                return result;
+            }
+        };
+    }
+}
+
+#endif /* TrenchBroom_ExpressionIO_h */
@@ -0,0 +1,402 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Program.h"
+
+#include "Macros.h"
+#include "EL/EvaluationContext.h"
+#include "EL/Expression.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace TrenchBroom {
+    namespace EL {
+        namespace {
+            /**
+             * The registers of a running program, which are the variable slots followed by the operand stack. Most
+             * programs need only a few registers, and those are kept in place instead of on the heap.
+             */
+            class Registers {
+            private:
+                static constexpr size_t InlineSize = 8;
+                Value m_inline[InlineSize];
+                std::vector<Value> m_heap;
+                Value* m_data;
+                size_t m_size;
+            public:
+                Registers(const size_t capacity, const size_t slots) :
+                m_data(m_inline),
+                m_size(slots) {
+                    if (capacity > InlineSize) {
+                        m_heap.resize(capacity);
+                        m_data = m_heap.data();
+                    }
+                    for (size_t i = 0; i < slots; ++i)
+                        m_data[i] = Value::Undefined;
+                }
+
+                Value& operator[](const size_t index) { return m_data[index]; }
+                size_t size() const { return m_size; }
+                Value* end() { return m_data + m_size; }
+                Value& back() { return m_data[m_size - 1]; }
+
+                void push_back(const Value& value) { m_data[m_size++] = value; }
+                void push_back(Value&& value) { m_data[m_size++] = std::move(value); }
+                void pop_back() { --m_size; }
+                void erase(const Value* first) { m_size = static_cast<size_t>(first - m_data); }
+
+                deleteCopyAndAssignment(Registers)
+            };
+        }
+
+        Program::Program(const ExpressionBase& expression) :
+        m_stackSize(0),
+        m_maxStackSize(0) {
+            expression.compile(*this);
+            assert(m_stackSize == 1);
+        }
+
+        Value Program::evaluate(const EvaluationContext& context) const {
+            // most model expressions are optimized into a single literal
+            if (m_instructions.size() == 1 && m_instructions.front().code == Op_PushConstant)
+                return m_constants[m_instructions.front().operand];
+
+            // the variable slots come first, followed by the operand stack
+            Registers stack(m_variables.size() + m_maxStackSize, m_variables.size());
+
+            // variables are looked up lazily since short circuiting operators may skip some of them; slots beyond
+            // the range of the mask are looked up every time
+            uint64_t resolved = 0;
+            const auto loadVariable = [&](const size_t slot) -> const Value& {
+                const uint64_t bit = slot < 64 ? uint64_t(1) << slot : 0;
+                if ((resolved & bit) == 0) {
+                    stack[slot] = context.variableValue(m_variables[slot]);
+                    resolved |= bit;
+                }
+                return stack[slot];
+            };
+
+            const auto pop = [&]() {
+                assert(stack.size() > m_variables.size());
+                Value result = std::move(stack.back());
+                stack.pop_back();
+                return result;
+            };
+
+            // the values of the auto range parameter for the enclosing subscript operators, innermost last
+            std::vector<Value> autoRanges;
+
+            size_t pc = 0;
+            while (pc < m_instructions.size()) {
+                const Instruction& instruction = m_instructions[pc];
+                const size_t line = m_locations[pc].line;
+                const size_t column = m_locations[pc].column;
+                ++pc;
+
+                switch (instruction.code) {
+                    case Op_PushConstant:
+                        stack.push_back(m_constants[instruction.operand]);
+                        break;
+                    case Op_LoadVariable:
+                        stack.push_back(loadVariable(instruction.operand));
+                        break;
+                    case Op_LoadAutoRange:
+                        if (!autoRanges.empty())
+                            stack.push_back(autoRanges.back());
+                        else
+                            stack.push_back(loadVariable(instruction.operand));
+                        break;
+                    case Op_MakeArray: {
+                        const Value* first = stack.end() - instruction.operand;
+                        ArrayType array;
+                        array.reserve(instruction.operand);
+                        for (auto it = first; it != stack.end(); ++it) {
+                            const Value& value = *it;
+                            if (value.type() == Type_Range) {
+                                const RangeType& range = value.rangeValue();
+                                array.reserve(array.size() + range.size());
+                                for (size_t i = 0; i < range.size(); ++i)
+                                    array.push_back(Value(range[i], value.line(), value.column()));
+                            } else {
+                                array.push_back(value);
+                            }
+                        }
+                        stack.erase(first);
+                        stack.push_back(Value(std::move(array), line, column));
+                        break;
+                    }
+                    case Op_MakeMap: {
+                        const StringList& keys = m_keys[instruction.operand];
+                        const Value* first = stack.end() - keys.size();
+                        MapType map;
+                        auto it = first;
+                        for (const String& key : keys)
+                            map.insert(std::make_pair(key, *it++));
+                        stack.erase(first);
+                        stack.push_back(Value(std::move(map), line, column));
+                        break;
+                    }
+                    case Op_UnaryPlus:
+                        stack.back() = Value(+stack.back(), line, column);
+                        break;
+                    case Op_UnaryMinus:
+                        stack.back() = Value(-stack.back(), line, column);
+                        break;
+                    case Op_LogicalNegation:
+                        stack.back() = Value(!stack.back(), line, column);
+                        break;
+                    case Op_BitwiseNegation:
+                        stack.back() = Value(~stack.back(), line, column);
+                        break;
+                    case Op_Group:
+                        stack.back() = Value(stack.back(), line, column);
+                        break;
+                    case Op_BeginSubscript:
+                        autoRanges.push_back(Value(stack.back().length() - 1, line, column));
+                        break;
+                    case Op_EndSubscript: {
+                        const Value index = pop();
+                        stack.back() = stack.back()[index];
+                        autoRanges.pop_back();
+                        break;
+                    }
+                    case Op_Add: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() + rhs, line, column);
+                        break;
+                    }
+                    case Op_Subtract: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() - rhs, line, column);
+                        break;
+                    }
+                    case Op_Multiply: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() * rhs, line, column);
+                        break;
+                    }
+                    case Op_Divide: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() / rhs, line, column);
+                        break;
+                    }
+                    case Op_Modulus: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() % rhs, line, column);
+                        break;
+                    }
+                    case Op_BitwiseAnd: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() & rhs, line, column);
+                        break;
+                    }
+                    case Op_BitwiseXor: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() ^ rhs, line, column);
+                        break;
+                    }
+                    case Op_BitwiseOr: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() | rhs, line, column);
+                        break;
+                    }
+                    case Op_BitwiseShiftLeft: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() << rhs, line, column);
+                        break;
+                    }
+                    case Op_BitwiseShiftRight: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() >> rhs, line, column);
+                        break;
+                    }
+                    case Op_Less: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() < rhs, line, column);
+                        break;
+                    }
+                    case Op_LessOrEqual: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() <= rhs, line, column);
+                        break;
+                    }
+                    case Op_Equal: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() == rhs, line, column);
+                        break;
+                    }
+                    case Op_Inequal: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() != rhs, line, column);
+                        break;
+                    }
+                    case Op_GreaterOrEqual: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() >= rhs, line, column);
+                        break;
+                    }
+                    case Op_Greater: {
+                        const Value rhs = pop();
+                        stack.back() = Value(stack.back() > rhs, line, column);
+                        break;
+                    }
+                    case Op_Range: {
+                        const Value rhs = pop();
+                        stack.back() = RangeOperator::createRange(stack.back(), rhs, line, column);
+                        break;
+                    }
+                    case Op_ToBoolean:
+                        stack.back() = Value(static_cast<bool>(stack.back()), line, column);
+                        break;
+                    case Op_JumpIfFalse:
+                        if (!static_cast<bool>(pop())) {
+                            stack.push_back(Value(false, line, column));
+                            pc = instruction.operand;
+                        }
+                        break;
+                    case Op_JumpIfTrue:
+                        if (static_cast<bool>(pop())) {
+                            stack.push_back(Value(true, line, column));
+                            pc = instruction.operand;
+                        }
+                        break;
+                    case Op_CaseJump:
+                        if (!static_cast<bool>(pop().convertTo(Type_Boolean))) {
+                            stack.push_back(Value::Undefined);
+                            pc = instruction.operand;
+                        }
+                        break;
+                    case Op_SwitchJump:
+                        if (!stack.back().undefined())
+                            pc = instruction.operand;
+                        else
+                            stack.pop_back();
+                        break;
+                    switchDefault()
+                }
+            }
+
+            assert(stack.size() == m_variables.size() + 1);
+            return stack.back();
+        }
+
+        size_t Program::instructionCount() const {
+            return m_instructions.size();
+        }
+
+        size_t Program::variableCount() const {
+            return m_variables.size();
+        }
+
+        const StringList& Program::variables() const {
+            return m_variables;
+        }
+
+        void Program::emit(const OpCode code, const size_t line, const size_t column, const size_t operand) {
+            assert(operand <= std::numeric_limits<uint32_t>::max());
+            m_instructions.push_back(Instruction{ code, static_cast<uint32_t>(operand) });
+            m_locations.push_back(Location{ line, column });
+
+            switch (code) {
+                case Op_PushConstant:
+                case Op_LoadVariable:
+                case Op_LoadAutoRange:
+                    ++m_stackSize;
+                    break;
+                case Op_MakeArray:
+                    assert(m_stackSize >= operand);
+                    m_stackSize = m_stackSize - operand + 1;
+                    break;
+                case Op_MakeMap:
+                    assert(m_stackSize >= m_keys[operand].size());
+                    m_stackSize = m_stackSize - m_keys[operand].size() + 1;
+                    break;
+                case Op_UnaryPlus:
+                case Op_UnaryMinus:
+                case Op_LogicalNegation:
+                case Op_BitwiseNegation:
+                case Op_Group:
+                case Op_BeginSubscript:
+                case Op_ToBoolean:
+                    break;
+                case Op_EndSubscript:
+                case Op_Add:
+                case Op_Subtract:
+                case Op_Multiply:
+                case Op_Divide:
+                case Op_Modulus:
+                case Op_BitwiseAnd:
+                case Op_BitwiseXor:
+                case Op_BitwiseOr:
+                case Op_BitwiseShiftLeft:
+                case Op_BitwiseShiftRight:
+                case Op_Less:
+                case Op_LessOrEqual:
+                case Op_Equal:
+                case Op_Inequal:
+                case Op_GreaterOrEqual:
+                case Op_Greater:
+                case Op_Range:
+                case Op_JumpIfFalse:
+                case Op_JumpIfTrue:
+                case Op_CaseJump:
+                case Op_SwitchJump:
+                    // jumps pop their operand when falling through, and the value they push when jumping takes the
+                    // place of the value computed by the skipped instructions
+                    assert(m_stackSize > 0);
+                    --m_stackSize;
+                    break;
+                switchDefault()
+            }
+            m_maxStackSize = std::max(m_maxStackSize, m_stackSize);
+        }
+
+        size_t Program::emitJump(const OpCode code, const size_t line, const size_t column) {
+            const size_t index = m_instructions.size();
+            emit(code, line, column);
+            return index;
+        }
+
+        void Program::patchJump(const size_t index) {
+            assert(index < m_instructions.size());
+            m_instructions[index].operand = static_cast<uint32_t>(m_instructions.size());
+        }
+
+        size_t Program::addConstant(const Value& value) {
+            m_constants.push_back(value);
+            return m_constants.size() - 1;
+        }
+
+        size_t Program::addVariable(const String& name) {
+            const auto it = std::find(std::begin(m_variables), std::end(m_variables), name);
+            if (it != std::end(m_variables))
+                return static_cast<size_t>(std::distance(std::begin(m_variables), it));
+            m_variables.push_back(name);
+            return m_variables.size() - 1;
+        }
+
+        size_t Program::addKeys(const StringList& keys) {
+            m_keys.push_back(keys);
+            return m_keys.size() - 1;
+        }
+    }
+}
@@ -0,0 +1,157 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef Program_h
+#define Program_h
+
+#include "StringUtils.h"
+#include "EL/Value.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace EL {
+        class EvaluationContext;
+        class ExpressionBase;
+
+        /**
+         * A compiled form of an expression tree. The tree is flattened into a sequence of stack machine instructions
+         * once, so that evaluating the expression does not need to walk the tree and dispatch virtual calls for every
+         * node. Literal values are kept in a constant pool, and every distinct variable name is assigned a slot whose
+         * value is looked up in the evaluation context at most once per evaluation.
+         *
+         * Evaluating a program yields the same values, including their line and column information, as evaluating the
+         * expression tree it was compiled from.
+         */
+        class Program {
+        public:
+            typedef enum {
+                Op_PushConstant,
+                Op_LoadVariable,
+                Op_LoadAutoRange,
+                Op_MakeArray,
+                Op_MakeMap,
+                Op_UnaryPlus,
+                Op_UnaryMinus,
+                Op_LogicalNegation,
+                Op_BitwiseNegation,
+                Op_Group,
+                Op_BeginSubscript,
+                Op_EndSubscript,
+                Op_Add,
+                Op_Subtract,
+                Op_Multiply,
+                Op_Divide,
+                Op_Modulus,
+                Op_BitwiseAnd,
+                Op_BitwiseXor,
+                Op_BitwiseOr,
+                Op_BitwiseShiftLeft,
+                Op_BitwiseShiftRight,
+                Op_Less,
+                Op_LessOrEqual,
+                Op_Equal,
+                Op_Inequal,
+                Op_GreaterOrEqual,
+                Op_Greater,
+                Op_Range,
+                Op_ToBoolean,
+                Op_JumpIfFalse,
+                Op_JumpIfTrue,
+                Op_CaseJump,
+                Op_SwitchJump
+            } OpCode;
+        private:
+            struct Instruction {
+                OpCode code;
+                uint32_t operand;
+            };
+
+            struct Location {
+                size_t line;
+                size_t column;
+            };
+
+            std::vector<Instruction> m_instructions;
+            std::vector<Location> m_locations;
+            std::vector<Value> m_constants;
+            StringList m_variables;
+            std::vector<StringList> m_keys;
+            size_t m_stackSize;
+            size_t m_maxStackSize;
+        public:
+            /**
+             * Compiles the given expression tree.
+             *
+             * @param expression the expression to compile
+             */
+            explicit Program(const ExpressionBase& expression);
+
+            /**
+             * Evaluates this program using the variables from the given context.
+             *
+             * @param context the evaluation context
+             * @return the resulting value
+             * @throws EvaluationError if the expression cannot be evaluated
+             */
+            Value evaluate(const EvaluationContext& context) const;
+
+            size_t instructionCount() const;
+            size_t variableCount() const;
+
+            /**
+             * Returns the names of the variables that this program reads, in the order of their first appearance.
+             */
+            const StringList& variables() const;
+        public:
+            /**
+             * Appends an instruction with the given operand. This and the following functions are used by the
+             * expression nodes to compile themselves into this program.
+             *
+             * @param code the operation code
+             * @param line the line of the expression that generated the instruction
+             * @param column the column of the expression that generated the instruction
+             * @param operand the operand
+             */
+            void emit(OpCode code, size_t line, size_t column, size_t operand = 0);
+
+            /**
+             * Appends a jump instruction whose target is not known yet.
+             *
+             * @return the index of the jump instruction, to be passed to patchJump once the target is known
+             */
+            size_t emitJump(OpCode code, size_t line, size_t column);
+
+            /**
+             * Sets the target of the given jump instruction to the next instruction to be emitted.
+             *
+             * @param index the index of the jump instruction
+             */
+            void patchJump(size_t index);
+
+            size_t addConstant(const Value& value);
+            size_t addVariable(const String& name);
+            size_t addKeys(const StringList& keys);
+        };
+    }
+}
+
+#endif /* Program_h */
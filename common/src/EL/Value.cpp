@@ -25,498 +25,63 @@
 #include <algorithm>
 #include <cmath>
 #include <iterator>
+#include <utility>
 
 namespace TrenchBroom {
     namespace EL {
-        ValueHolder::~ValueHolder() {}
-        
-        String ValueHolder::describe() const {
-            StringStream str;
-            appendToStream(str, false, "");
-            return str.str();
-        }
-        
-        const BooleanType& ValueHolder::booleanValue() const { throw DereferenceError(describe(), type(), Type_Boolean); }
-        const StringType&  ValueHolder::stringValue()  const { throw DereferenceError(describe(), type(), Type_String); }
-        const NumberType&  ValueHolder::numberValue()  const { throw DereferenceError(describe(), type(), Type_Number); }
-              IntegerType  ValueHolder::integerValue() const { return static_cast<IntegerType>(numberValue()); }
-        const ArrayType&   ValueHolder::arrayValue()   const { throw DereferenceError(describe(), type(), Type_Array); }
-        const MapType&     ValueHolder::mapValue()     const { throw DereferenceError(describe(), type(), Type_Map); }
-        const RangeType&   ValueHolder::rangeValue()   const { throw DereferenceError(describe(), type(), Type_Range); }
-        
-        BooleanValueHolder::BooleanValueHolder(const BooleanType& value) : m_value(value) {}
-        ValueType BooleanValueHolder::type() const { return Type_Boolean; }
-        const BooleanType& BooleanValueHolder::booleanValue() const { return m_value; }
-        size_t BooleanValueHolder::length() const { return 1; }
-        
-        bool BooleanValueHolder::convertibleTo(ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                    return true;
-                case Type_Array:
-                case Type_Map:
-                case Type_Range:
-                case Type_Undefined:
-                case Type_Null:
-                    break;
-            }
-            
-            return false;
-        }
-
-        ValueHolder* BooleanValueHolder::convertTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                    return new BooleanValueHolder(m_value);
-                case Type_String:
-                    return new StringValueHolder(m_value ? "true" : "false" );
-                case Type_Number:
-                    return new NumberValueHolder(m_value ? 1.0 : 0.0);
-                case Type_Array:
-                case Type_Map:
-                case Type_Range:
-                case Type_Undefined:
-                case Type_Null:
-                    break;
-            }
-            
-            throw ConversionError(describe(), type(), toType);
-        }
-        
-        ValueHolder* BooleanValueHolder::clone() const { return new BooleanValueHolder(m_value); }
-        void BooleanValueHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const { str << (m_value ? "true" : "false"); }
-        
-        StringHolder::~StringHolder() {}
-        ValueType StringHolder::type() const { return Type_String; }
-        const StringType& StringHolder::stringValue() const { return doGetValue(); }
-        size_t StringHolder::length() const { return doGetValue().length(); }
-        
-        bool StringHolder::convertibleTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                case Type_String:
-                    return true;
-                case Type_Number: {
-                    if (StringUtils::isBlank(doGetValue()))
-                        return true;
-                    const char* begin = doGetValue().c_str();
-                    char* end;
-                    const NumberType value = std::strtod(begin, &end);
-                    if (value == 0.0 && end == begin)
-                        return false;
-                    return true;
-                }
-                case Type_Array:
-                case Type_Map:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-
-            return false;
-        }
-        
-        ValueHolder* StringHolder::convertTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                    return new BooleanValueHolder(!StringUtils::caseSensitiveEqual(doGetValue(), "false") && !doGetValue().empty());
-                case Type_String:
-                    return new StringValueHolder(doGetValue());
-                case Type_Number: {
-                    if (StringUtils::isBlank(doGetValue()))
-                        return new NumberValueHolder(0.0);
-                    const char* begin = doGetValue().c_str();
-                    char* end;
-                    const NumberType value = std::strtod(begin, &end);
-                    if (value == 0.0 && end == begin)
-                        throw ConversionError(describe(), type(), toType);
-                    return new NumberValueHolder(value);
-                }
-                case Type_Array:
-                case Type_Map:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-            
-            throw ConversionError(describe(), type(), toType);
-        }
-        
-        void StringHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const {
-            // Unescaping happens in IO::ELParser::parseLiteral
-            str << "\"" << StringUtils::escape(doGetValue(), "\\\"") << "\"";
-        }
-
-        
-        
-        StringValueHolder::StringValueHolder(const StringType& value) : m_value(value) {}
-        ValueHolder* StringValueHolder::clone() const { return new StringValueHolder(m_value); }
-        const StringType& StringValueHolder::doGetValue() const { return m_value; }
-
-        
-        
-        StringReferenceHolder::StringReferenceHolder(const StringType& value) : m_value(value) {}
-        ValueHolder* StringReferenceHolder::clone() const { return new StringReferenceHolder(m_value); }
-        const StringType& StringReferenceHolder::doGetValue() const { return m_value; }
-        
-        
-        
-        NumberValueHolder::NumberValueHolder(const NumberType& value) : m_value(value) {}
-        ValueType NumberValueHolder::type() const { return Type_Number; }
-        const NumberType& NumberValueHolder::numberValue() const { return m_value; }
-        size_t NumberValueHolder::length() const { return 1; }
-        
-        bool NumberValueHolder::convertibleTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                    return true;
-                case Type_Array:
-                case Type_Map:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-
-            return false;
-        }
-        
-        ValueHolder* NumberValueHolder::convertTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                    return new BooleanValueHolder(m_value != 0.0);
-                case Type_String:
-                    return new StringValueHolder(describe());
-                case Type_Number:
-                    return new NumberValueHolder(m_value);
-                case Type_Array:
-                case Type_Map:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-            
-            throw ConversionError(describe(), type(), toType);
-        }
-        
-        ValueHolder* NumberValueHolder::clone() const { return new NumberValueHolder(m_value); }
+        static constexpr auto RoundingThreshold = 0.00001;
 
-        void NumberValueHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const {
-            if (std::abs(m_value - std::round(m_value)) < RoundingThreshold) {
-                str.precision(0);
-                str.setf(std::ios::fixed);
-            } else {
-                str.precision(17);
-                str.unsetf(std::ios::fixed);
-            }
-            str << m_value;
-        }
+        const Value Value::Null = Value(Storage(NullValue()), 0, 0);
+        const Value Value::Undefined = Value(Storage(UndefinedValue()), 0, 0);
         
+        Value::Value(Storage value, const size_t line, const size_t column)            : m_value(std::move(value)), m_line(line), m_column(column) {}
         
+        Value::Value(const BooleanType& value, const size_t line, const size_t column) : m_value(std::in_place_type<BooleanType>, value), m_line(line), m_column(column) {}
+        Value::Value(const BooleanType& value)                                         : m_value(std::in_place_type<BooleanType>, value), m_line(0), m_column(0) {}
         
-        ArrayValueHolder::ArrayValueHolder(const ArrayType& value) : m_value(value) {}
-        ValueType ArrayValueHolder::type() const { return Type_Array; }
-        const ArrayType& ArrayValueHolder::arrayValue() const { return m_value; }
-        size_t ArrayValueHolder::length() const { return m_value.size(); }
+        Value::Value(const StringType& value, const size_t line, const size_t column)  : m_value(makeString(value)), m_line(line), m_column(column) {}
+        Value::Value(const StringType& value)                                          : m_value(makeString(value)), m_line(0), m_column(0) {}
         
-        bool ArrayValueHolder::convertibleTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Array:
-                    return true;
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                case Type_Map:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-
-            return false;
-        }
+        Value::Value(const char* value, const size_t line, const size_t column)        : m_value(makeString(String(value))), m_line(line), m_column(column) {}
+        Value::Value(const char* value)                                                : m_value(makeString(String(value))), m_line(0), m_column(0) {}
         
-        ValueHolder* ArrayValueHolder::convertTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Array:
-                    return new ArrayValueHolder(m_value);
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                case Type_Map:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-            
-            throw ConversionError(describe(), type(), toType);
-        }
-        
-        ValueHolder* ArrayValueHolder::clone() const { return new ArrayValueHolder(m_value); }
-        
-        void ArrayValueHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const {
-            if (m_value.empty()) {
-                str << "[]";
-            } else {
-                const String childIndent = multiline ? indent + "\t" : "";
-                str << "[";
-                if (multiline)
-                    str << "\n";
-                else
-                    str << " ";
-                for (size_t i = 0; i < m_value.size(); ++i) {
-                    str << childIndent;
-                    m_value[i].appendToStream(str, multiline, childIndent);
-                    if (i < m_value.size() - 1) {
-                        str << ",";
-                        if (!multiline)
-                            str << " ";
-                    }
-                    if (multiline)
-                        str << "\n";
-                }
-                if (multiline)
-                    str << indent;
-                else
-                    str << " ";
-                str << "]";
-            }
-        }
+        Value::Value(const NumberType& value, const size_t line, const size_t column)  : m_value(std::in_place_type<NumberType>, value), m_line(line), m_column(column) {}
+        Value::Value(const NumberType& value)                                          : m_value(std::in_place_type<NumberType>, value), m_line(0), m_column(0) {}
         
+        Value::Value(const int value, const size_t line, const size_t column)          : m_value(std::in_place_type<NumberType>, static_cast<NumberType>(value)), m_line(line), m_column(column) {}
+        Value::Value(const int value)                                                  : m_value(std::in_place_type<NumberType>, static_cast<NumberType>(value)), m_line(0), m_column(0) {}
         
-        MapValueHolder::MapValueHolder(const MapType& value) : m_value(value) {}
-        ValueType MapValueHolder::type() const { return Type_Map; }
-        const MapType& MapValueHolder::mapValue() const { return m_value; }
-        size_t MapValueHolder::length() const { return m_value.size(); }
-        
-        bool MapValueHolder::convertibleTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Map:
-                    return true;
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                case Type_Array:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-
-            return false;
-        }
-        
-        ValueHolder* MapValueHolder::convertTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Map:
-                    return new MapValueHolder(m_value);
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                case Type_Array:
-                case Type_Range:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-            
-            throw ConversionError(describe(), type(), toType);
-        }
+        Value::Value(const long value, const size_t line, const size_t column)         : m_value(std::in_place_type<NumberType>, static_cast<NumberType>(value)), m_line(line), m_column(column) {}
+        Value::Value(const long value)                                                 : m_value(std::in_place_type<NumberType>, static_cast<NumberType>(value)), m_line(0), m_column(0) {}
         
-        ValueHolder* MapValueHolder::clone() const { return new MapValueHolder(m_value); }
-        
-        void MapValueHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const {
-            if (m_value.empty()) {
-                str << "{}";
-            } else {
-                const String childIndent = multiline ? indent + "\t" : "";
-                str << "{";
-                if (multiline)
-                    str << "\n";
-                else
-                    str << " ";
-
-                size_t i = 0;
-                for (const auto& entry : m_value) {
-                    str << childIndent << "\"" << entry.first << "\"" << ": ";
-                    entry.second.appendToStream(str, multiline, childIndent);
-                    if (i++ < m_value.size() - 1) {
-                        str << ",";
-                        if (!multiline)
-                            str << " ";
-                    }
-                    if (multiline)
-                        str << "\n";
-                }
-                if (multiline)
-                    str << indent;
-                else
-                    str << " ";
-                str << "}";
-            }
-        }
+        Value::Value(const size_t value, const size_t line, const size_t column)       : m_value(std::in_place_type<NumberType>, static_cast<NumberType>(value)), m_line(line), m_column(column) {}
+        Value::Value(const size_t value)                                               : m_value(std::in_place_type<NumberType>, static_cast<NumberType>(value)), m_line(0), m_column(0) {}
         
+        Value::Value(const ArrayType& value, const size_t line, const size_t column)   : m_value(std::make_shared<const ArrayType>(value)), m_line(line), m_column(column) {}
+        Value::Value(ArrayType&& value, const size_t line, const size_t column)        : m_value(std::make_shared<const ArrayType>(std::move(value))), m_line(line), m_column(column) {}
+        Value::Value(const ArrayType& value)                                           : m_value(std::make_shared<const ArrayType>(value)), m_line(0), m_column(0) {}
         
-        RangeValueHolder::RangeValueHolder(const RangeType& value) : m_value(value) {}
-        ValueType RangeValueHolder::type() const { return Type_Range; }
-        const RangeType& RangeValueHolder::rangeValue() const { return m_value; }
-        size_t RangeValueHolder::length() const { return m_value.size(); }
+        Value::Value(const MapType& value, const size_t line, const size_t column)     : m_value(std::make_shared<const MapType>(value)), m_line(line), m_column(column) {}
+        Value::Value(MapType&& value, const size_t line, const size_t column)          : m_value(std::make_shared<const MapType>(std::move(value))), m_line(line), m_column(column) {}
+        Value::Value(const MapType& value)                                             : m_value(std::make_shared<const MapType>(value)), m_line(0), m_column(0) {}
         
-        bool RangeValueHolder::convertibleTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Range:
-                    return true;
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                case Type_Array:
-                case Type_Map:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-
-            return false;
-        }
+        Value::Value(const RangeType& value, const size_t line, const size_t column)   : m_value(std::make_shared<const RangeType>(value)), m_line(line), m_column(column) {}
+        Value::Value(const RangeType& value)                                           : m_value(std::make_shared<const RangeType>(value)), m_line(0), m_column(0) {}
         
-        ValueHolder* RangeValueHolder::convertTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Range:
-                    return new RangeValueHolder(m_value);
-                case Type_Boolean:
-                case Type_String:
-                case Type_Number:
-                case Type_Array:
-                case Type_Map:
-                case Type_Null:
-                case Type_Undefined:
-                    break;
-            }
-            
-            throw ConversionError(describe(), type(), toType);
-        }
+        Value::Value(const Value& other, const size_t line, const size_t column)       : m_value(other.m_value), m_line(line), m_column(column) {}
         
-        ValueHolder* RangeValueHolder::clone() const { return new RangeValueHolder(m_value); }
+        Value::Value()                                                                 : m_value(NullValue()), m_line(0), m_column(0) {}
         
-        void RangeValueHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const {
-            str << "[";
-            for (size_t i = 0; i < m_value.size(); ++i) {
-                str << m_value[i];
-                if (i < m_value.size() - 1)
-                    str << ", ";
-            }
-            str << "]";
+        Value::Storage Value::makeString(const StringType& value) {
+            // strings that fit into the inline buffer of an empty string are copied without allocating
+            static const size_t InlineCapacity = StringType().capacity();
+            if (value.size() <= InlineCapacity)
+                return Storage(std::in_place_type<StringType>, value);
+            return Storage(std::make_shared<const StringType>(value));
         }
         
-        
-        ValueType NullValueHolder::type() const { return Type_Null; }
-        size_t NullValueHolder::length() const { return 0; }
-        const StringType& NullValueHolder::stringValue() const   { static const StringType result;         return result; }
-        const BooleanType& NullValueHolder::booleanValue() const { static const BooleanType result(false); return result; }
-        const NumberType& NullValueHolder::numberValue() const   { static const NumberType result(0.0);    return result; }
-        const ArrayType& NullValueHolder::arrayValue() const     { static const ArrayType result(0);       return result; }
-        const MapType& NullValueHolder::mapValue() const         { static const MapType result;            return result; }
-        
-        bool NullValueHolder::convertibleTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                case Type_Null:
-                case Type_Number:
-                case Type_String:
-                case Type_Array:
-                case Type_Map:
-                    return true;
-                case Type_Range:
-                case Type_Undefined:
-                    break;
-            }
-
-            return false;
-        }
-        
-        ValueHolder* NullValueHolder::convertTo(const ValueType toType) const {
-            switch (toType) {
-                case Type_Boolean:
-                    return new BooleanValueHolder(false);
-                case Type_Null:
-                    return new NullValueHolder();
-                case Type_Number:
-                    return new NumberValueHolder(0.0);
-                case Type_String:
-                    return new StringValueHolder("");
-                case Type_Array:
-                    return new ArrayValueHolder(ArrayType(0));
-                case Type_Map:
-                    return new MapValueHolder(MapType());
-                case Type_Range:
-                case Type_Undefined:
-                    break;
-            }
-            
-            throw ConversionError(describe(), type(), toType);
-        }
-        
-        ValueHolder* NullValueHolder::clone() const { return new NullValueHolder(); }
-        void NullValueHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const { str << "null"; }
-        
-        
-        ValueType UndefinedValueHolder::type() const { return Type_Undefined; }
-        size_t UndefinedValueHolder::length() const { return 0; }
-        bool UndefinedValueHolder::convertibleTo(const ValueType toType) const { return false; }
-        ValueHolder* UndefinedValueHolder::convertTo(const ValueType toType) const { throw ConversionError(describe(), type(), toType); }
-        ValueHolder* UndefinedValueHolder::clone() const { return new UndefinedValueHolder(); }
-        void UndefinedValueHolder::appendToStream(std::ostream& str, const bool multiline, const String& indent) const { str << "undefined"; }
-        
-        
-        const Value Value::Null = Value(new NullValueHolder(), 0, 0);
-        const Value Value::Undefined = Value(new UndefinedValueHolder(), 0, 0);
-        
-        Value::Value(ValueHolder* holder, const size_t line, const size_t column)      : m_value(holder), m_line(line), m_column(column) {}
-        
-        Value::Value(const BooleanType& value, const size_t line, const size_t column) : m_value(new BooleanValueHolder(value)), m_line(line), m_column(column) {}
-        Value::Value(const BooleanType& value)                                         : m_value(new BooleanValueHolder(value)), m_line(0), m_column(0) {}
-        
-        Value::Value(const StringType& value, const size_t line, const size_t column)  : m_value(new StringValueHolder(value)), m_line(line), m_column(column) {}
-        Value::Value(const StringType& value)                                          : m_value(new StringValueHolder(value)), m_line(0), m_column(0) {}
-        
-        Value::Value(const char* value, const size_t line, const size_t column)        : m_value(new StringValueHolder(String(value))), m_line(line), m_column(column) {}
-        Value::Value(const char* value)                                                : m_value(new StringValueHolder(String(value))), m_line(0), m_column(0) {}
-        
-        Value::Value(const NumberType& value, const size_t line, const size_t column)  : m_value(new NumberValueHolder(value)), m_line(line), m_column(column) {}
-        Value::Value(const NumberType& value)                                          : m_value(new NumberValueHolder(value)), m_line(0), m_column(0) {}
-        
-        Value::Value(const int value, const size_t line, const size_t column)          : m_value(new NumberValueHolder(static_cast<NumberType>(value))), m_line(line), m_column(column) {}
-        Value::Value(const int value)                                                  : m_value(new NumberValueHolder(static_cast<NumberType>(value))), m_line(0), m_column(0) {}
-        
-        Value::Value(const long value, const size_t line, const size_t column)         : m_value(new NumberValueHolder(static_cast<NumberType>(value))), m_line(line), m_column(column) {}
-        Value::Value(const long value)                                                 : m_value(new NumberValueHolder(static_cast<NumberType>(value))), m_line(0), m_column(0) {}
-        
-        Value::Value(const size_t value, const size_t line, const size_t column)       : m_value(new NumberValueHolder(static_cast<NumberType>(value))), m_line(line), m_column(column) {}
-        Value::Value(const size_t value)                                               : m_value(new NumberValueHolder(static_cast<NumberType>(value))), m_line(0), m_column(0) {}
-        
-        Value::Value(const ArrayType& value, const size_t line, const size_t column)   : m_value(new ArrayValueHolder(value)), m_line(line), m_column(column) {}
-        Value::Value(const ArrayType& value)                                           : m_value(new ArrayValueHolder(value)), m_line(0), m_column(0) {}
-        
-        Value::Value(const MapType& value, const size_t line, const size_t column)     : m_value(new MapValueHolder(value)), m_line(line), m_column(column) {}
-        Value::Value(const MapType& value)                                             : m_value(new MapValueHolder(value)), m_line(0), m_column(0) {}
-        
-        Value::Value(const RangeType& value, const size_t line, const size_t column)   : m_value(new RangeValueHolder(value)), m_line(line), m_column(column) {}
-        Value::Value(const RangeType& value)                                           : m_value(new RangeValueHolder(value)), m_line(0), m_column(0) {}
-        
-        Value::Value(const Value& other, const size_t line, const size_t column)       : m_value(other.m_value), m_line(line), m_column(column) {}
-        
-        Value::Value()                                                                 : m_value(new NullValueHolder()), m_line(0), m_column(0) {}
-        
         Value Value::ref(const StringType& value, const size_t line, const size_t column) {
-            return Value(new StringReferenceHolder(value), line, column);
+            return Value(Storage(std::in_place_type<const StringType*>, &value), line, column);
         }
         
         Value Value::ref(const StringType& value) {
@@ -524,7 +89,20 @@ namespace TrenchBroom {
         }
 
         ValueType Value::type() const {
-            return m_value->type();
+            static const ValueType Types[] = {
+                Type_Null,      // NullValue
+                Type_Undefined, // UndefinedValue
+                Type_Boolean,   // BooleanType
+                Type_Number,    // NumberType
+                Type_String,    // StringType
+                Type_String,    // StringPtr
+                Type_String,    // const StringType*
+                Type_Array,     // ArrayPtr
+                Type_Map,       // MapPtr
+                Type_Range      // RangePtr
+            };
+            static_assert(sizeof(Types) / sizeof(Types[0]) == std::variant_size<Storage>::value, "missing value type");
+            return Types[m_value.index()];
         }
         
         String Value::typeName() const {
@@ -532,7 +110,9 @@ namespace TrenchBroom {
         }
         
         String Value::describe() const {
-            return m_value->describe();
+            StringStream str;
+            appendToStream(str, false, "");
+            return str.str();
         }
         
         size_t Value::line() const {
@@ -545,39 +125,75 @@ namespace TrenchBroom {
         
         
         const StringType& Value::stringValue() const {
-            return m_value->stringValue();
+            if (const auto* value = std::get_if<StringType>(&m_value))
+                return *value;
+            if (const auto* value = std::get_if<StringPtr>(&m_value))
+                return **value;
+            if (const auto* value = std::get_if<const StringType*>(&m_value))
+                return **value;
+            if (null()) {
+                static const StringType result;
+                return result;
+            }
+            throw DereferenceError(describe(), type(), Type_String);
         }
         
         const BooleanType& Value::booleanValue() const {
-            return m_value->booleanValue();
+            if (const auto* value = std::get_if<BooleanType>(&m_value))
+                return *value;
+            if (null()) {
+                static const BooleanType result(false);
+                return result;
+            }
+            throw DereferenceError(describe(), type(), Type_Boolean);
         }
         
         const NumberType& Value::numberValue() const {
-            return m_value->numberValue();
+            if (const auto* value = std::get_if<NumberType>(&m_value))
+                return *value;
+            if (null()) {
+                static const NumberType result(0.0);
+                return result;
+            }
+            throw DereferenceError(describe(), type(), Type_Number);
         }
         
         IntegerType Value::integerValue() const {
-            return m_value->integerValue();
+            return static_cast<IntegerType>(numberValue());
         }
 
         const ArrayType& Value::arrayValue() const {
-            return m_value->arrayValue();
+            if (const auto* value = std::get_if<ArrayPtr>(&m_value))
+                return **value;
+            if (null()) {
+                static const ArrayType result(0);
+                return result;
+            }
+            throw DereferenceError(describe(), type(), Type_Array);
         }
         
         const MapType& Value::mapValue() const {
-            return m_value->mapValue();
+            if (const auto* value = std::get_if<MapPtr>(&m_value))
+                return **value;
+            if (null()) {
+                static const MapType result;
+                return result;
+            }
+            throw DereferenceError(describe(), type(), Type_Map);
         }
         
         const RangeType& Value::rangeValue() const {
-            return m_value->rangeValue();
+            if (const auto* value = std::get_if<RangePtr>(&m_value))
+                return **value;
+            throw DereferenceError(describe(), type(), Type_Range);
         }
         
         bool Value::null() const {
-            return type() == Type_Null;
+            return std::holds_alternative<NullValue>(m_value);
         }
         
         bool Value::undefined() const {
-            return type() == Type_Undefined;
+            return std::holds_alternative<UndefinedValue>(m_value);
         }
 
         const StringList Value::asStringList() const {
@@ -602,19 +218,180 @@ namespace TrenchBroom {
         }
         
         size_t Value::length() const {
-            return m_value->length();
+            switch (type()) {
+                case Type_Boolean:
+                case Type_Number:
+                    return 1;
+                case Type_String:
+                    return stringValue().length();
+                case Type_Array:
+                    return arrayValue().size();
+                case Type_Map:
+                    return mapValue().size();
+                case Type_Range:
+                    return rangeValue().size();
+                case Type_Null:
+                case Type_Undefined:
+                    break;
+            }
+            return 0;
         }
         
         bool Value::convertibleTo(const ValueType toType) const {
-            if (type() == toType)
+            const ValueType fromType = type();
+            if (fromType == toType)
                 return true;
-            return m_value->convertibleTo(toType);
+
+            switch (fromType) {
+                case Type_Boolean:
+                case Type_Number:
+                    switch (toType) {
+                        case Type_Boolean:
+                        case Type_String:
+                        case Type_Number:
+                            return true;
+                        case Type_Array:
+                        case Type_Map:
+                        case Type_Range:
+                        case Type_Null:
+                        case Type_Undefined:
+                            break;
+                    }
+                    break;
+                case Type_String:
+                    switch (toType) {
+                        case Type_Boolean:
+                        case Type_String:
+                            return true;
+                        case Type_Number: {
+                            const StringType& value = stringValue();
+                            if (StringUtils::isBlank(value))
+                                return true;
+                            const char* begin = value.c_str();
+                            char* end;
+                            const NumberType number = std::strtod(begin, &end);
+                            return number != 0.0 || end != begin;
+                        }
+                        case Type_Array:
+                        case Type_Map:
+                        case Type_Range:
+                        case Type_Null:
+                        case Type_Undefined:
+                            break;
+                    }
+                    break;
+                case Type_Null:
+                    switch (toType) {
+                        case Type_Boolean:
+                        case Type_Null:
+                        case Type_Number:
+                        case Type_String:
+                        case Type_Array:
+                        case Type_Map:
+                            return true;
+                        case Type_Range:
+                        case Type_Undefined:
+                            break;
+                    }
+                    break;
+                case Type_Array:
+                case Type_Map:
+                case Type_Range:
+                case Type_Undefined:
+                    break;
+            }
+            
+            return false;
         }
         
         Value Value::convertTo(const ValueType toType) const {
-            if (type() == toType)
+            const ValueType fromType = type();
+            if (fromType == toType)
                 return *this;
-            return Value(m_value->convertTo(toType), m_line, m_column);
+
+            switch (fromType) {
+                case Type_Boolean:
+                    switch (toType) {
+                        case Type_String:
+                            return Value(booleanValue() ? "true" : "false", m_line, m_column);
+                        case Type_Number:
+                            return Value(booleanValue() ? 1.0 : 0.0, m_line, m_column);
+                        case Type_Boolean:
+                        case Type_Array:
+                        case Type_Map:
+                        case Type_Range:
+                        case Type_Null:
+                        case Type_Undefined:
+                            break;
+                    }
+                    break;
+                case Type_String:
+                    switch (toType) {
+                        case Type_Boolean: {
+                            const StringType& value = stringValue();
+                            return Value(!StringUtils::caseSensitiveEqual(value, "false") && !value.empty(), m_line, m_column);
+                        }
+                        case Type_Number: {
+                            const StringType& value = stringValue();
+                            if (StringUtils::isBlank(value))
+                                return Value(0.0, m_line, m_column);
+                            const char* begin = value.c_str();
+                            char* end;
+                            const NumberType number = std::strtod(begin, &end);
+                            if (number == 0.0 && end == begin)
+                                throw ConversionError(describe(), fromType, toType);
+                            return Value(number, m_line, m_column);
+                        }
+                        case Type_String:
+                        case Type_Array:
+                        case Type_Map:
+                        case Type_Range:
+                        case Type_Null:
+                        case Type_Undefined:
+                            break;
+                    }
+                    break;
+                case Type_Number:
+                    switch (toType) {
+                        case Type_Boolean:
+                            return Value(numberValue() != 0.0, m_line, m_column);
+                        case Type_String:
+                            return Value(describe(), m_line, m_column);
+                        case Type_Number:
+                        case Type_Array:
+                        case Type_Map:
+                        case Type_Range:
+                        case Type_Null:
+                        case Type_Undefined:
+                            break;
+                    }
+                    break;
+                case Type_Null:
+                    switch (toType) {
+                        case Type_Boolean:
+                            return Value(false, m_line, m_column);
+                        case Type_Number:
+                            return Value(0.0, m_line, m_column);
+                        case Type_String:
+                            return Value("", m_line, m_column);
+                        case Type_Array:
+                            return Value(ArrayType(0), m_line, m_column);
+                        case Type_Map:
+                            return Value(MapType(), m_line, m_column);
+                        case Type_Null:
+                        case Type_Range:
+                        case Type_Undefined:
+                            break;
+                    }
+                    break;
+                case Type_Array:
+                case Type_Map:
+                case Type_Range:
+                case Type_Undefined:
+                    break;
+            }
+            
+            throw ConversionError(describe(), fromType, toType);
         }
         
         String Value::asString(const bool multiline) const {
@@ -624,7 +401,106 @@ namespace TrenchBroom {
         }
 
         void Value::appendToStream(std::ostream& str, const bool multiline, const String& indent) const {
-            m_value->appendToStream(str, multiline, indent);
+            switch (type()) {
+                case Type_Boolean:
+                    str << (booleanValue() ? "true" : "false");
+                    break;
+                case Type_String:
+                    // Unescaping happens in IO::ELParser::parseLiteral
+                    str << "\"" << StringUtils::escape(stringValue(), "\\\"") << "\"";
+                    break;
+                case Type_Number: {
+                    const NumberType value = numberValue();
+                    if (std::abs(value - std::round(value)) < RoundingThreshold) {
+                        str.precision(0);
+                        str.setf(std::ios::fixed);
+                    } else {
+                        str.precision(17);
+                        str.unsetf(std::ios::fixed);
+                    }
+                    str << value;
+                    break;
+                }
+                case Type_Array: {
+                    const ArrayType& array = arrayValue();
+                    if (array.empty()) {
+                        str << "[]";
+                    } else {
+                        const String childIndent = multiline ? indent + "\t" : "";
+                        str << "[";
+                        if (multiline)
+                            str << "\n";
+                        else
+                            str << " ";
+                        for (size_t i = 0; i < array.size(); ++i) {
+                            str << childIndent;
+                            array[i].appendToStream(str, multiline, childIndent);
+                            if (i < array.size() - 1) {
+                                str << ",";
+                                if (!multiline)
+                                    str << " ";
+                            }
+                            if (multiline)
+                                str << "\n";
+                        }
+                        if (multiline)
+                            str << indent;
+                        else
+                            str << " ";
+                        str << "]";
+                    }
+                    break;
+                }
+                case Type_Map: {
+                    const MapType& map = mapValue();
+                    if (map.empty()) {
+                        str << "{}";
+                    } else {
+                        const String childIndent = multiline ? indent + "\t" : "";
+                        str << "{";
+                        if (multiline)
+                            str << "\n";
+                        else
+                            str << " ";
+
+                        size_t i = 0;
+                        for (const auto& entry : map) {
+                            str << childIndent << "\"" << entry.first << "\"" << ": ";
+                            entry.second.appendToStream(str, multiline, childIndent);
+                            if (i++ < map.size() - 1) {
+                                str << ",";
+                                if (!multiline)
+                                    str << " ";
+                            }
+                            if (multiline)
+                                str << "\n";
+                        }
+                        if (multiline)
+                            str << indent;
+                        else
+                            str << " ";
+                        str << "}";
+                    }
+                    break;
+                }
+                case Type_Range: {
+                    const RangeType& range = rangeValue();
+                    str << "[";
+                    for (size_t i = 0; i < range.size(); ++i) {
+                        str << range[i];
+                        if (i < range.size() - 1)
+                            str << ", ";
+                    }
+                    str << "]";
+                    break;
+                }
+                case Type_Null:
+                    str << "null";
+                    break;
+                case Type_Undefined:
+                    str << "undefined";
+                    break;
+            }
         }
         
         std::ostream& operator<<(std::ostream& stream, const Value& value) {
@@ -26,163 +26,11 @@
 
 #include <algorithm>
 #include <iterator>
+#include <memory>
+#include <variant>
 
 namespace TrenchBroom {
     namespace EL {
-        class ValueHolder {
-        public:
-            virtual ~ValueHolder();
-            
-            virtual ValueType type() const = 0;
-            String describe() const;
-            
-            virtual const BooleanType& booleanValue() const;
-            virtual const StringType&  stringValue()  const;
-            virtual const NumberType&  numberValue()  const;
-                          IntegerType  integerValue() const;
-            virtual const ArrayType&   arrayValue()   const;
-            virtual const MapType&     mapValue()     const;
-            virtual const RangeType&   rangeValue()   const;
-            
-            virtual size_t length() const = 0;
-            virtual bool convertibleTo(ValueType toType) const = 0;
-            virtual ValueHolder* convertTo(ValueType toType) const = 0;
-            
-            virtual ValueHolder* clone() const = 0;
-            
-            virtual void appendToStream(std::ostream& str, bool multiline, const String& indent) const = 0;
-        };
-        
-        class BooleanValueHolder : public ValueHolder {
-        private:
-            BooleanType m_value;
-        public:
-            BooleanValueHolder(const BooleanType& value);
-            ValueType type() const override;
-            const BooleanType& booleanValue() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            ValueHolder* clone() const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        };
-
-        class StringHolder : public ValueHolder {
-        public:
-            virtual ~StringHolder() override;
-            
-            ValueType type() const override;
-            const StringType& stringValue() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        private:
-            virtual const StringType& doGetValue() const = 0;
-        };
-        
-        class StringValueHolder : public StringHolder {
-        private:
-            StringType m_value;
-        public:
-            StringValueHolder(const StringType& value);
-            ValueHolder* clone() const override;
-        private:
-            const StringType& doGetValue() const override;
-        };
-        
-        class StringReferenceHolder : public StringHolder {
-        private:
-            const StringType& m_value;
-        public:
-            StringReferenceHolder(const StringType& value);
-            ValueHolder* clone() const override;
-        private:
-            const StringType& doGetValue() const override;
-        };
-        
-        class NumberValueHolder : public ValueHolder {
-        private:
-            static constexpr auto RoundingThreshold = 0.00001;
-            NumberType m_value;
-        public:
-            NumberValueHolder(const NumberType& value);
-            ValueType type() const override;
-            const NumberType& numberValue() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            ValueHolder* clone() const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        };
-        
-        class ArrayValueHolder : public ValueHolder {
-        private:
-            ArrayType m_value;
-        public:
-            ArrayValueHolder(const ArrayType& value);
-            ValueType type() const override;
-            const ArrayType& arrayValue() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            ValueHolder* clone() const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        };
-        
-        class MapValueHolder : public ValueHolder {
-        private:
-            MapType m_value;
-        public:
-            MapValueHolder(const MapType& value);
-            ValueType type() const override;
-            const MapType& mapValue() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            ValueHolder* clone() const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        };
-        
-        class RangeValueHolder : public ValueHolder {
-        private:
-            RangeType m_value;
-        public:
-            RangeValueHolder(const RangeType& value);
-            ValueType type() const override;
-            const RangeType& rangeValue() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            ValueHolder* clone() const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        };
-        
-        class NullValueHolder : public ValueHolder {
-        public:
-            ValueType type() const override;
-            const StringType& stringValue() const override;
-            const BooleanType& booleanValue() const override;
-            const NumberType& numberValue() const override;
-            const ArrayType& arrayValue() const override;
-            const MapType& mapValue() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            ValueHolder* clone() const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        };
-        
-        class UndefinedValueHolder : public ValueHolder {
-        public:
-            ValueType type() const override;
-            size_t length() const override;
-            bool convertibleTo(ValueType toType) const override;
-            ValueHolder* convertTo(ValueType toType) const override;
-            ValueHolder* clone() const override;
-            void appendToStream(std::ostream& str, bool multiline, const String& indent) const override;
-        };
-        
         class Value {
         public:
             static const Value Null;
@@ -190,12 +38,38 @@ namespace TrenchBroom {
             typedef std::set<Value> Set;
         private:
             typedef std::vector<size_t> IndexList;
-            typedef std::shared_ptr<ValueHolder> ValuePtr;
-            ValuePtr m_value;
+
+            struct NullValue {};
+            struct UndefinedValue {};
+            typedef std::shared_ptr<const StringType> StringPtr;
+            typedef std::shared_ptr<const ArrayType> ArrayPtr;
+            typedef std::shared_ptr<const MapType> MapPtr;
+            typedef std::shared_ptr<const RangeType> RangePtr;
+
+            /**
+             * Null, undefined, boolean and number values and strings that fit into the string's own inline buffer are
+             * stored in place. Longer strings, arrays, maps and ranges are immutable once created and are shared by
+             * all copies of a value. A string reference points to a string that is owned by someone else.
+             */
+            typedef std::variant<
+                NullValue,
+                UndefinedValue,
+                BooleanType,
+                NumberType,
+                StringType,
+                StringPtr,
+                const StringType*,
+                ArrayPtr,
+                MapPtr,
+                RangePtr
+            > Storage;
+
+            Storage m_value;
             size_t m_line;
             size_t m_column;
         private:
-            Value(ValueHolder* holder, size_t line, size_t column);
+            Value(Storage value, size_t line, size_t column);
+            static Storage makeString(const StringType& value);
         public:
             Value(const BooleanType& value, size_t line, size_t column);
             explicit Value(const BooleanType& value);
@@ -219,32 +93,34 @@ namespace TrenchBroom {
             explicit Value(size_t value);
             
             Value(const ArrayType& value, size_t line, size_t column);
+            Value(ArrayType&& value, size_t line, size_t column);
             explicit Value(const ArrayType& value);
             
             template <typename T>
             Value(const std::vector<T>& value, size_t line, size_t column) :
-            m_value(new ArrayValueHolder(makeArray(value))),
+            m_value(std::make_shared<const ArrayType>(makeArray(value))),
             m_line(line),
             m_column(column){}
             
             template <typename T>
             explicit Value(const std::vector<T>& value) :
-            m_value(new ArrayValueHolder(makeArray(value))),
+            m_value(std::make_shared<const ArrayType>(makeArray(value))),
             m_line(0),
             m_column(0) {}
             
             Value(const MapType& value, size_t line, size_t column);
+            Value(MapType&& value, size_t line, size_t column);
             explicit Value(const MapType& value);
             
             template <typename T, typename C>
             Value(const std::map<String, T, C>& value, size_t line, size_t column) :
-            m_value(new MapValueHolder(makeMap(value))),
+            m_value(std::make_shared<const MapType>(makeMap(value))),
             m_line(line),
             m_column(column) {}
             
             template <typename T, typename C>
             explicit Value(const std::map<String, T, C>& value) :
-            m_value(new MapValueHolder(makeMap(value))),
+            m_value(std::make_shared<const MapType>(makeMap(value))),
             m_line(0),
             m_column(0) {}
             
@@ -0,0 +1,373 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "AssetCache.h"
+
+#include "Exceptions.h"
+#include "IO/DirectoryScanner.h"
+#include "IO/DiskIO.h"
+#include "IO/MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include <wx/filefn.h>
+
+namespace TrenchBroom {
+    namespace IO {
+        namespace {
+            const char EntryMagic[4] = { 'T', 'B', 'A', 'C' };
+            const String EntryExtension = "cache";
+            const size_t EntryHeaderSize = 24; // magic, format version, key length, reserved, data size
+            const size_t EntryAlignment = 16;
+
+            const uint64_t FnvOffsetBasis = 0xcbf29ce484222325ULL;
+            const uint64_t FnvPrime = 0x100000001b3ULL;
+
+            uint64_t hashBytes(uint64_t hash, const char* begin, const char* end) {
+                for (const char* cur = begin; cur < end; ++cur) {
+                    hash ^= static_cast<unsigned char>(*cur);
+                    hash *= FnvPrime;
+                }
+                return hash;
+            }
+
+            // hashes eight bytes at a time since this is used for the contents of whole files
+            uint64_t hashContents(const char* begin, const char* end) {
+                uint64_t hash = FnvOffsetBasis;
+                const char* cur = begin;
+                for (; end - cur >= 8; cur += 8) {
+                    uint64_t word;
+                    std::memcpy(&word, cur, sizeof(word));
+                    hash ^= word;
+                    hash *= FnvPrime;
+                    hash ^= hash >> 29;
+                }
+                return hashBytes(hash, cur, end);
+            }
+
+            struct FileStatus {
+                uint64_t size;
+                int64_t modificationTime; // in nanoseconds where the platform supports it
+            };
+
+            bool fileStatus(const Path& path, FileStatus& result) {
+#ifdef _WIN32
+                struct _stat64 status;
+                if (::_stat64(path.asString().c_str(), &status) != 0)
+                    return false;
+#else
+                struct stat status;
+                if (::stat(path.asString().c_str(), &status) != 0)
+                    return false;
+#endif
+                result.size = static_cast<uint64_t>(status.st_size);
+                result.modificationTime = static_cast<int64_t>(status.st_mtime) * 1000000000;
+#if defined(__APPLE__)
+                result.modificationTime += static_cast<int64_t>(status.st_mtimespec.tv_nsec);
+#elif defined(__linux__)
+                result.modificationTime += static_cast<int64_t>(status.st_mtim.tv_nsec);
+#endif
+                return true;
+            }
+
+            void touchFile(const Path& path) {
+#ifdef _WIN32
+                ::_utime(path.asString().c_str(), nullptr);
+#else
+                ::utime(path.asString().c_str(), nullptr);
+#endif
+            }
+
+            /*
+             The entries are accessed by their exact paths rather than through the functions in Disk. Those look paths
+             up in the directory cache, which would have to list the cache directory again after every change to it.
+             */
+
+            MappedFile::Ptr openEntry(const Path& path) {
+#ifdef _WIN32
+                return MappedFile::Ptr(new WinMappedFile(path, std::ios::in));
+#else
+                return MappedFile::Ptr(new PosixMappedFile(path, std::ios::in));
+#endif
+            }
+
+            void moveEntry(const Path& sourcePath, const Path& destPath) {
+                if (!::wxRenameFile(sourcePath.asString(), destPath.asString(), true))
+                    throw FileSystemException("Could not move file '" + sourcePath.asString() + "' to '" + destPath.asString() + "'");
+            }
+
+            void deleteEntry(const Path& path) {
+                if (std::remove(path.asString().c_str()) != 0)
+                    throw FileSystemException("Could not delete file '" + path.asString() + "'");
+            }
+
+            size_t dataOffset(const size_t keyLength) {
+                const size_t size = EntryHeaderSize + keyLength;
+                return (size + EntryAlignment - 1) / EntryAlignment * EntryAlignment;
+            }
+
+            template <typename T>
+            void writeValue(char* dest, const T value) {
+                std::memcpy(dest, &value, sizeof(T));
+            }
+
+            template <typename T>
+            T readValue(const char* src) {
+                T result;
+                std::memcpy(&result, src, sizeof(T));
+                return result;
+            }
+
+            struct Entry {
+                Path path;
+                FileStatus status;
+            };
+
+            std::vector<Entry> listEntries(const Path& directory) {
+                std::vector<Entry> result;
+                if (!Disk::directoryExists(directory))
+                    return result;
+
+                for (const DirectoryEntry& directoryEntry : Disk::scanDirectory(directory, false)) {
+                    if (!directoryEntry.directory && StringUtils::caseSensitiveEqual(directoryEntry.path.extension(), EntryExtension)) {
+                        Entry entry { directory + directoryEntry.path, FileStatus() };
+                        if (fileStatus(entry.path, entry.status))
+                            result.push_back(entry);
+                    }
+                }
+                return result;
+            }
+        }
+
+        const uint32_t AssetCache::FormatVersion = 1;
+
+        AssetCache::Key::Key(const String& kind) {
+            append(kind);
+            append(static_cast<uint64_t>(FormatVersion));
+        }
+
+        AssetCache::Key& AssetCache::Key::append(const String& value) {
+            m_identity += value;
+            m_identity += '\0';
+            return *this;
+        }
+
+        AssetCache::Key& AssetCache::Key::append(const uint64_t value) {
+            return append(std::to_string(value));
+        }
+
+        AssetCache::Key& AssetCache::Key::appendFile(const Path& path) {
+            FileStatus status;
+            if (!fileStatus(path, status))
+                throw FileSystemException("File not found: '" + path.asString() + "'");
+
+            append(path.asString());
+            append(status.size);
+            return append(static_cast<uint64_t>(status.modificationTime));
+        }
+
+        AssetCache::Key& AssetCache::Key::appendContents(const char* begin, const char* end) {
+            append(static_cast<uint64_t>(end - begin));
+            return append(hashContents(begin, end));
+        }
+
+        const String& AssetCache::Key::identity() const {
+            return m_identity;
+        }
+
+        uint64_t AssetCache::Key::hash() const {
+            return hashBytes(FnvOffsetBasis, m_identity.data(), m_identity.data() + m_identity.size());
+        }
+
+        AssetCache::AssetCache(const Path& directory, const size_t maxSize) :
+        m_directory(directory),
+        m_maxSize(maxSize),
+        m_size(0),
+        m_sizeKnown(false),
+        m_stats({ 0u, 0u, 0u }) {}
+
+        const Path& AssetCache::directory() const {
+            return m_directory;
+        }
+
+        size_t AssetCache::maxSize() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_maxSize;
+        }
+
+        void AssetCache::setMaxSize(const size_t maxSize) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_maxSize = maxSize;
+            try {
+                ensureSizeKnown();
+                if (m_size > m_maxSize)
+                    trim(m_maxSize);
+            } catch (const FileSystemException&) {}
+        }
+
+        MappedFile::Ptr AssetCache::find(const Key& key) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const Path path = entryPath(key);
+            try {
+                FileStatus status;
+                if (fileStatus(path, status) && status.size > 0) {
+                    const MappedFile::Ptr file = openEntry(path);
+                    const char* begin = file->begin();
+                    const size_t size = file->size();
+
+                    const String& identity = key.identity();
+                    const size_t offset = dataOffset(identity.size());
+                    if (size >= offset &&
+                        std::memcmp(begin, EntryMagic, sizeof(EntryMagic)) == 0 &&
+                        readValue<uint32_t>(begin + 4) == FormatVersion &&
+                        readValue<uint32_t>(begin + 8) == identity.size() &&
+                        readValue<uint64_t>(begin + 16) == size - offset &&
+                        std::memcmp(begin + EntryHeaderSize, identity.data(), identity.size()) == 0) {
+                        touchFile(path);
+                        ++m_stats.hits;
+                        return MappedFile::Ptr(new MappedFileView(file, path, begin + offset, size - offset));
+                    }
+                }
+            } catch (const FileSystemException&) {}
+
+            ++m_stats.misses;
+            return nullptr;
+        }
+
+        void AssetCache::store(const Key& key, const char* data, const size_t size) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const String& identity = key.identity();
+            const size_t offset = dataOffset(identity.size());
+
+            String header(offset, '\0');
+            std::memcpy(&header[0], EntryMagic, sizeof(EntryMagic));
+            writeValue<uint32_t>(&header[4], FormatVersion);
+            writeValue<uint32_t>(&header[8], static_cast<uint32_t>(identity.size()));
+            writeValue<uint64_t>(&header[16], static_cast<uint64_t>(size));
+            std::memcpy(&header[EntryHeaderSize], identity.data(), identity.size());
+
+            const Path path = entryPath(key);
+            const Path tempPath = path.replaceExtension("tmp");
+            try {
+                ensureSizeKnown();
+                if (!::wxDirExists(m_directory.asString()))
+                    Disk::ensureDirectoryExists(m_directory);
+
+                // write to a temporary file first so that a partially written entry is never found
+                {
+                    std::ofstream stream(tempPath.asString().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                    stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+                    stream.write(data, static_cast<std::streamsize>(size));
+                    if (!stream.good()) {
+                        stream.close();
+                        std::remove(tempPath.asString().c_str());
+                        return;
+                    }
+                }
+
+                FileStatus previous;
+                if (fileStatus(path, previous))
+                    m_size -= std::min(m_size, static_cast<size_t>(previous.size));
+
+                moveEntry(tempPath, path);
+                m_size += offset + size;
+
+                // trim below the maximum so that not every subsequent store has to trim again
+                if (m_size > m_maxSize)
+                    trim(m_maxSize - m_maxSize / 4, path);
+            } catch (const FileSystemException&) {
+                std::remove(tempPath.asString().c_str());
+            }
+        }
+
+        void AssetCache::clear() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            try {
+                trim(0);
+            } catch (const FileSystemException&) {}
+        }
+
+        AssetCache::Stats AssetCache::stats() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_stats;
+        }
+
+        Path AssetCache::entryPath(const Key& key) const {
+            static const char* digits = "0123456789abcdef";
+
+            uint64_t hash = key.hash();
+            String name(16, '0');
+            for (size_t i = 0; i < 16; ++i) {
+                name[15 - i] = digits[hash & 0xF];
+                hash >>= 4;
+            }
+            return m_directory + Path(name + "." + EntryExtension);
+        }
+
+        void AssetCache::ensureSizeKnown() {
+            if (m_sizeKnown)
+                return;
+
+            m_size = 0;
+            for (const Entry& entry : listEntries(m_directory))
+                m_size += static_cast<size_t>(entry.status.size);
+            m_sizeKnown = true;
+        }
+
+        void AssetCache::trim(const size_t targetSize, const Path& keep) {
+            std::vector<Entry> entries = listEntries(m_directory);
+
+            // finding an entry touches its file, so the least recently used entries come first
+            std::sort(std::begin(entries), std::end(entries), [](const Entry& lhs, const Entry& rhs) {
+                return std::tie(lhs.status.modificationTime, lhs.path) < std::tie(rhs.status.modificationTime, rhs.path);
+            });
+
+            m_size = 0;
+            for (const Entry& entry : entries)
+                m_size += static_cast<size_t>(entry.status.size);
+
+            for (const Entry& entry : entries) {
+                if (m_size <= targetSize)
+                    break;
+                if (entry.path == keep)
+                    continue;
+                deleteEntry(entry.path);
+                m_size -= static_cast<size_t>(entry.status.size);
+                ++m_stats.evictions;
+            }
+            m_sizeKnown = true;
+        }
+    }
+}
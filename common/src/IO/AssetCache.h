@@ -0,0 +1,156 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_AssetCache_h
+#define TrenchBroom_AssetCache_h
+
+#include "StringUtils.h"
+#include "IO/MappedFile.h"
+#include "IO/Path.h"
+
+#include <cstdint>
+#include <mutex>
+
+namespace TrenchBroom {
+    namespace IO {
+        /**
+         * Stores decoded assets in files in a directory on disk so that they can be mapped into memory instead of
+         * being decoded again when they are loaded the next time.
+         *
+         * Every entry is identified by a key that describes everything the decoded data depends on, such as the path,
+         * size and modification time of the source file and the settings used to decode it. Entries are stored in
+         * files named after a hash of the key, and each file repeats the full key so that hash collisions and stale
+         * entries are detected when the entry is read. Once the total size of all entries exceeds the maximum size,
+         * the least recently used entries are deleted.
+         *
+         * All member functions are thread safe.
+         */
+        class AssetCache {
+        public:
+            /**
+             * Describes the inputs of a cached asset. Two keys are equal if and only if the same values were appended
+             * to them in the same order.
+             */
+            class Key {
+            private:
+                String m_identity;
+            public:
+                /**
+                 * Creates a new key for an asset of the given kind.
+                 *
+                 * @param kind the kind of asset, e.g. "textures"
+                 */
+                explicit Key(const String& kind);
+
+                Key& append(const String& value);
+                Key& append(uint64_t value);
+
+                /**
+                 * Appends the path, size and modification time of the given file on disk.
+                 *
+                 * @param path the absolute path of the file
+                 * @return this key
+                 * @throws FileSystemException if the file does not exist
+                 */
+                Key& appendFile(const Path& path);
+
+                /**
+                 * Appends the size and a hash of the given data. Use this for sources that are not files on disk.
+                 *
+                 * @param begin the start of the data
+                 * @param end the end of the data
+                 * @return this key
+                 */
+                Key& appendContents(const char* begin, const char* end);
+
+                const String& identity() const;
+                uint64_t hash() const;
+            };
+
+            struct Stats {
+                size_t hits;
+                size_t misses;
+                size_t evictions;
+            };
+
+            static const uint32_t FormatVersion;
+        private:
+            Path m_directory;
+            size_t m_maxSize;
+            size_t m_size;
+            bool m_sizeKnown;
+            Stats m_stats;
+            mutable std::mutex m_mutex;
+        public:
+            /**
+             * Creates a new cache that stores its entries in the given directory. The directory is created when the
+             * first entry is stored.
+             *
+             * @param directory the absolute path of the cache directory
+             * @param maxSize the maximum total size of all entries in bytes
+             */
+            AssetCache(const Path& directory, size_t maxSize);
+
+            AssetCache(const AssetCache& other) = delete;
+            AssetCache& operator=(const AssetCache& other) = delete;
+
+            const Path& directory() const;
+            size_t maxSize() const;
+
+            /**
+             * Sets the maximum total size of all entries, deleting entries if the cache is larger than that.
+             *
+             * @param maxSize the maximum size in bytes
+             */
+            void setMaxSize(size_t maxSize);
+
+            /**
+             * Maps the data of the entry with the given key into memory.
+             *
+             * @param key the key
+             * @return the data of the entry, or null if there is no valid entry with the given key
+             */
+            MappedFile::Ptr find(const Key& key);
+
+            /**
+             * Stores the given data under the given key, replacing any previous entry with the same key. Errors are
+             * not reported since a failure to store an entry only means that the asset must be decoded again.
+             *
+             * @param key the key
+             * @param data the data to store
+             * @param size the size of the data
+             */
+            void store(const Key& key, const char* data, size_t size);
+
+            /**
+             * Deletes all entries.
+             */
+            void clear();
+
+            Stats stats() const;
+        private:
+            Path entryPath(const Key& key) const;
+            void ensureSizeKnown();
+            void trim(size_t targetSize, const Path& keep = Path(""));
+        };
+    }
+}
+
+#endif /* TrenchBroom_AssetCache_h */
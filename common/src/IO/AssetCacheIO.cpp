@@ -0,0 +1,133 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "AssetCacheIO.h"
+
+#include "Color.h"
+#include "Exceptions.h"
+#include "Assets/Texture.h"
+
+#include <cstring>
+
+namespace TrenchBroom {
+    namespace IO {
+        void AssetCacheWriter::write(const void* data, const size_t size) {
+            const char* begin = static_cast<const char*>(data);
+            m_data.insert(std::end(m_data), begin, begin + size);
+        }
+
+        void AssetCacheWriter::writeString(const String& str) {
+            writeValue(static_cast<uint32_t>(str.size()));
+            write(str.data(), str.size());
+        }
+
+        void AssetCacheWriter::writeTexture(const Assets::Texture& texture) {
+            writeString(texture.name());
+            writeValue(static_cast<uint32_t>(texture.width()));
+            writeValue(static_cast<uint32_t>(texture.height()));
+            for (size_t i = 0; i < 4; ++i)
+                writeValue(static_cast<float>(texture.averageColor()[i]));
+            writeValue(static_cast<uint32_t>(texture.format()));
+            writeValue(static_cast<uint32_t>(texture.type() == Assets::TextureType::Opaque ? 0 : 1));
+
+            const Assets::TextureBuffer::List& buffers = texture.buffers();
+            writeValue(static_cast<uint32_t>(buffers.size()));
+            for (const Assets::TextureBuffer& buffer : buffers) {
+                writeValue(static_cast<uint64_t>(buffer.size()));
+                if (buffer.size() > 0)
+                    write(buffer.ptr(), buffer.size());
+            }
+        }
+
+        const char* AssetCacheWriter::data() const {
+            return m_data.data();
+        }
+
+        size_t AssetCacheWriter::size() const {
+            return m_data.size();
+        }
+
+        AssetCacheReader::AssetCacheReader(const char* begin, const char* end) :
+        m_begin(begin),
+        m_end(end),
+        m_current(begin) {}
+
+        void AssetCacheReader::read(void* data, const size_t size) {
+            if (static_cast<size_t>(m_end - m_current) < size)
+                throw AssetException("Asset cache entry is truncated");
+            std::memcpy(data, m_current, size);
+            m_current += size;
+        }
+
+        void AssetCacheReader::skip(const size_t size) {
+            if (static_cast<size_t>(m_end - m_current) < size)
+                throw AssetException("Asset cache entry is truncated");
+            m_current += size;
+        }
+
+        String AssetCacheReader::readString() {
+            const size_t length = readValue<uint32_t>();
+            checkSize(length, 1);
+
+            const String result(m_current, length);
+            m_current += length;
+            return result;
+        }
+
+        Assets::Texture* AssetCacheReader::readTexture() {
+            const String name = readString();
+            const size_t width = readValue<uint32_t>();
+            const size_t height = readValue<uint32_t>();
+
+            Color averageColor;
+            for (size_t i = 0; i < 4; ++i)
+                averageColor[i] = readValue<float>();
+
+            const GLenum format = static_cast<GLenum>(readValue<uint32_t>());
+            const Assets::TextureType type = readValue<uint32_t>() == 0 ? Assets::TextureType::Opaque : Assets::TextureType::Masked;
+            if (width == 0 || height == 0 || (format != GL_RGB && format != GL_BGR && format != GL_RGBA))
+                throw AssetException("Asset cache entry is corrupt");
+
+            const size_t mipCount = readValue<uint32_t>();
+            Assets::TextureBuffer::List buffers;
+            buffers.reserve(mipCount);
+            for (size_t i = 0; i < mipCount; ++i) {
+                const size_t size = static_cast<size_t>(readValue<uint64_t>());
+                checkSize(size, 1);
+
+                Assets::TextureBuffer buffer(size);
+                read(buffer.ptr(), size);
+                buffers.push_back(buffer);
+            }
+
+            return new Assets::Texture(name, width, height, averageColor, buffers, format, type);
+        }
+
+        size_t AssetCacheReader::position() const {
+            return static_cast<size_t>(m_current - m_begin);
+        }
+
+        void AssetCacheReader::checkSize(const size_t count, const size_t elementSize) const {
+            // compare by division so that corrupt counts cannot overflow
+            if (count > static_cast<size_t>(m_end - m_current) / elementSize)
+                throw AssetException("Asset cache entry is truncated");
+        }
+    }
+}
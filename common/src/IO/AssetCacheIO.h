@@ -0,0 +1,134 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_AssetCacheIO_h
+#define TrenchBroom_AssetCacheIO_h
+
+#include "StringUtils.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Assets {
+        class Texture;
+    }
+
+    namespace IO {
+        /**
+         * Builds the data of an asset cache entry. Values are stored in the native byte order since cache entries
+         * are never shared between machines.
+         */
+        class AssetCacheWriter {
+        private:
+            std::vector<char> m_data;
+        public:
+            void write(const void* data, size_t size);
+
+            template <typename T>
+            void writeValue(const T value) {
+                static_assert(std::is_arithmetic<T>::value, "only arithmetic values can be written");
+                write(&value, sizeof(T));
+            }
+
+            /**
+             * Writes the number of the given vertices followed by their contents.
+             */
+            template <typename V>
+            void writeVertices(const std::vector<V>& vertices) {
+                static_assert(std::is_trivially_copyable<V>::value, "only trivially copyable vertices can be written");
+                writeValue(static_cast<uint32_t>(vertices.size()));
+                if (!vertices.empty())
+                    write(vertices.data(), vertices.size() * sizeof(V));
+            }
+
+            void writeString(const String& str);
+
+            /**
+             * Writes the name, size, average color, format, type and the image data of every mip level of the given
+             * texture. The texture must not have been prepared since that releases its image data.
+             */
+            void writeTexture(const Assets::Texture& texture);
+
+            const char* data() const;
+            size_t size() const;
+        };
+
+        /**
+         * Reads the data of an asset cache entry that was built by an AssetCacheWriter.
+         *
+         * All read functions throw an AssetException if the entry is truncated or corrupt.
+         */
+        class AssetCacheReader {
+        private:
+            const char* m_begin;
+            const char* m_end;
+            const char* m_current;
+        public:
+            AssetCacheReader(const char* begin, const char* end);
+
+            void read(void* data, size_t size);
+            void skip(size_t size);
+
+            template <typename T>
+            T readValue() {
+                static_assert(std::is_arithmetic<T>::value, "only arithmetic values can be read");
+                T result;
+                read(&result, sizeof(T));
+                return result;
+            }
+
+            template <typename V>
+            std::vector<V> readVertices() {
+                static_assert(std::is_trivially_copyable<V>::value, "only trivially copyable vertices can be read");
+                const size_t count = readValue<uint32_t>();
+                checkSize(count, sizeof(V));
+
+                std::vector<V> result(count);
+                if (count > 0)
+                    read(result.data(), count * sizeof(V));
+                return result;
+            }
+
+            /**
+             * Skips a list of vertices that was written by AssetCacheWriter::writeVertices.
+             */
+            template <typename V>
+            void skipVertices() {
+                const size_t count = readValue<uint32_t>();
+                checkSize(count, sizeof(V));
+                skip(count * sizeof(V));
+            }
+
+            String readString();
+            Assets::Texture* readTexture();
+
+            /**
+             * Returns the offset of the next value to read from the beginning of the entry.
+             */
+            size_t position() const;
+        private:
+            void checkSize(size_t count, size_t elementSize) const;
+        };
+    }
+}
+
+#endif /* TrenchBroom_AssetCacheIO_h */
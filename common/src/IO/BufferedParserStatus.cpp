@@ -0,0 +1,63 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "BufferedParserStatus.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace IO {
+        BufferedParserStatus::BufferedParserStatus() :
+        ParserStatus(nullptr),
+        m_progressStatus(nullptr) {}
+
+        BufferedParserStatus::BufferedParserStatus(ParserStatus& progressStatus) :
+        ParserStatus(nullptr),
+        m_progressStatus(&progressStatus) {}
+
+        BufferedParserStatus::BufferedParserStatus(const MessageList& messages) :
+        ParserStatus(nullptr),
+        m_progressStatus(nullptr),
+        m_messages(messages) {}
+
+        const BufferedParserStatus::MessageList& BufferedParserStatus::messages() const {
+            return m_messages;
+        }
+
+        void BufferedParserStatus::replay(ParserStatus& status) const {
+            replay(status, 0, m_messages.size());
+        }
+
+        void BufferedParserStatus::replay(ParserStatus& status, const size_t begin, const size_t end) const {
+            assert(begin <= end && end <= m_messages.size());
+            for (size_t i = begin; i < end; ++i)
+                status.doLog(m_messages[i].first, m_messages[i].second);
+        }
+
+        void BufferedParserStatus::doProgress(const double progress) {
+            if (m_progressStatus != nullptr)
+                m_progressStatus->progress(progress);
+        }
+
+        void BufferedParserStatus::doLog(const Logger::LogLevel level, const String& str) {
+            m_messages.push_back(Message(level, str));
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_BufferedParserStatus
+#define TrenchBroom_BufferedParserStatus
+
+#include "IO/ParserStatus.h"
+
+#include <utility>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        /**
+         * Collects the messages of a parser so that they can be passed on to another parser status later. This allows
+         * parsing on a worker thread without accessing the status of the calling thread, which is not thread safe.
+         * Progress updates are passed on to the given progress status immediately, or discarded if there is none.
+         */
+        class BufferedParserStatus : public ParserStatus {
+        public:
+            typedef std::pair<Logger::LogLevel, String> Message;
+            typedef std::vector<Message> MessageList;
+        private:
+            ParserStatus* m_progressStatus;
+            MessageList m_messages;
+        public:
+            BufferedParserStatus();
+
+            /**
+             * Creates a status that passes progress updates on to the given status.
+             */
+            explicit BufferedParserStatus(ParserStatus& progressStatus);
+
+            /**
+             * Creates a status that holds the given messages, e.g. messages that were stored in a cache.
+             */
+            explicit BufferedParserStatus(const MessageList& messages);
+
+            const MessageList& messages() const;
+
+            /**
+             * Passes all collected messages to the given status in the order in which they were logged.
+             */
+            void replay(ParserStatus& status) const;
+
+            /**
+             * Passes the collected messages in the given range of indices to the given status.
+             */
+            void replay(ParserStatus& status, size_t begin, size_t end) const;
+        private:
+            void doProgress(double progress) override;
+            void doLog(Logger::LogLevel level, const String& str) override;
+        };
+    }
+}
+
+#endif /* defined(TrenchBroom_BufferedParserStatus) */
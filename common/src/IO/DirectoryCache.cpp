@@ -0,0 +1,186 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DirectoryCache.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace TrenchBroom {
+    namespace IO {
+        DirectoryCache::DirectoryCache(const ListDirectory& listDirectory, const bool watch) :
+        m_listDirectory(listDirectory),
+        m_watch(watch),
+        m_stats({ 0u, 0u }),
+        m_notifier(-1) {
+#ifdef __linux__
+            if (watch) {
+                // if this fails, we just run without notifications
+                m_notifier = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            }
+#endif
+        }
+
+        DirectoryCache::~DirectoryCache() {
+#ifdef __linux__
+            if (m_notifier >= 0) {
+                close(m_notifier);
+            }
+#endif
+        }
+
+        String DirectoryCache::findEntry(const Path& directory, const String& name) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            processNotifications();
+
+            const String key = directory.asString();
+            const auto it = m_listings.find(key);
+            if (it != std::end(m_listings)) {
+                ++m_stats.hits;
+                return findEntry(it->second, name);
+            }
+
+            ++m_stats.misses;
+            Listing listing = readListing(directory);
+            const String result = findEntry(listing, name);
+
+            // a listing without a watch would never be invalidated if the caller relies on notifications
+            if (!m_watch || listing.watch >= 0) {
+                m_listings.insert(std::make_pair(key, std::move(listing)));
+            }
+            return result;
+        }
+
+        void DirectoryCache::invalidate(const Path& directory) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            removeListing(directory.asString());
+        }
+
+        void DirectoryCache::invalidateAll() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            removeAllListings();
+        }
+
+        bool DirectoryCache::watching() const {
+            return m_notifier >= 0;
+        }
+
+        DirectoryCache::Stats DirectoryCache::stats() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_stats;
+        }
+
+        DirectoryCache::Listing DirectoryCache::readListing(const Path& directory) {
+            const String key = directory.asString();
+
+            Listing result;
+            result.watch = -1;
+#ifdef __linux__
+            if (m_notifier >= 0) {
+                // register before reading the listing so that we don't miss any changes in between
+                result.watch = inotify_add_watch(m_notifier, key.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+                if (result.watch >= 0) {
+                    m_watches[result.watch].insert(key);
+                }
+            }
+#endif
+
+            StringList names;
+            if (m_listDirectory(directory, names)) {
+                for (const String& name : names) {
+                    result.names.insert(name);
+                    result.foldedNames.insert(std::make_pair(StringUtils::toLower(name), name));
+                }
+            }
+
+            return result;
+        }
+
+        String DirectoryCache::findEntry(const Listing& listing, const String& name) {
+            if (listing.names.count(name) > 0) {
+                return name;
+            }
+
+            const auto it = listing.foldedNames.find(StringUtils::toLower(name));
+            if (it != std::end(listing.foldedNames)) {
+                return it->second;
+            }
+            return "";
+        }
+
+        void DirectoryCache::removeListing(const String& key) {
+            const auto it = m_listings.find(key);
+            if (it != std::end(m_listings)) {
+#ifdef __linux__
+                const auto watchIt = m_watches.find(it->second.watch);
+                if (watchIt != std::end(m_watches)) {
+                    // only remove the watch once no other listing depends on it
+                    watchIt->second.erase(key);
+                    if (watchIt->second.empty()) {
+                        inotify_rm_watch(m_notifier, watchIt->first);
+                        m_watches.erase(watchIt);
+                    }
+                }
+#endif
+                m_listings.erase(it);
+            }
+        }
+
+        void DirectoryCache::removeAllListings() {
+#ifdef __linux__
+            for (const auto& entry : m_watches) {
+                inotify_rm_watch(m_notifier, entry.first);
+            }
+#endif
+            m_watches.clear();
+            m_listings.clear();
+        }
+
+        void DirectoryCache::processNotifications() {
+#ifdef __linux__
+            if (m_notifier < 0) {
+                return;
+            }
+
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(m_notifier, buffer, sizeof(buffer))) > 0) {
+                const char* cur = buffer;
+                while (cur < buffer + length) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(cur);
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        removeAllListings();
+                    } else {
+                        const auto it = m_watches.find(event->wd);
+                        if (it != std::end(m_watches)) {
+                            const std::unordered_set<String> keys = it->second;
+                            for (const String& key : keys) {
+                                removeListing(key);
+                            }
+                        }
+                    }
+                    cur += sizeof(inotify_event) + event->len;
+                }
+            }
+#endif
+        }
+    }
+}
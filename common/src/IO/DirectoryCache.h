@@ -0,0 +1,130 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_DirectoryCache_h
+#define TrenchBroom_DirectoryCache_h
+
+#include "StringUtils.h"
+#include "IO/Path.h"
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace TrenchBroom {
+    namespace IO {
+        /**
+         * Caches the names of the entries of directories on disk so that they can be looked up by name, ignoring case,
+         * without accessing the file system again.
+         *
+         * Cached listings become stale when the file system is changed, so they must be invalidated when that happens.
+         * If watching is enabled, the cache registers for change notifications for every directory it lists and
+         * invalidates the affected listings itself. Listings that cannot be watched, because the platform does not
+         * support notifications or the watch limit has been reached, are not cached at all in that case.
+         *
+         * All member functions are thread safe.
+         */
+        class DirectoryCache {
+        public:
+            /**
+             * Reads the names of the entries of the given directory into the given list, returning false if the
+             * directory cannot be read.
+             */
+            using ListDirectory = std::function<bool(const Path& directory, StringList& names)>;
+
+            struct Stats {
+                size_t hits;
+                size_t misses;
+            };
+        private:
+            struct Listing {
+                std::unordered_set<String> names;
+                // maps the lower case version of every name to the first matching name
+                std::unordered_map<String, String> foldedNames;
+                int watch;
+            };
+
+            ListDirectory m_listDirectory;
+            bool m_watch;
+            std::unordered_map<String, Listing> m_listings;
+            Stats m_stats;
+            mutable std::mutex m_mutex;
+
+            int m_notifier;
+            // several keys can share a watch if they name the same directory, e.g. through a symbolic link
+            std::unordered_map<int, std::unordered_set<String>> m_watches;
+        public:
+            /**
+             * Creates a new directory cache.
+             *
+             * @param listDirectory the function to read directory listings with
+             * @param watch whether to keep the cached listings fresh using file system change notifications; if
+             * false, the caller must invalidate the listings of directories that it changes
+             */
+            DirectoryCache(const ListDirectory& listDirectory, bool watch);
+            ~DirectoryCache();
+
+            DirectoryCache(const DirectoryCache& other) = delete;
+            DirectoryCache& operator=(const DirectoryCache& other) = delete;
+
+            /**
+             * Finds the entry of the given directory with the given name. If there is no entry with exactly the given
+             * name, an entry whose name differs from the given name only in case is returned.
+             *
+             * @param directory the absolute path of the directory to search
+             * @param name the name to find
+             * @return the name of the matching entry, or an empty string if the directory has no matching entry or
+             * cannot be read
+             */
+            String findEntry(const Path& directory, const String& name);
+
+            /**
+             * Discards the cached listing of the given directory.
+             *
+             * @param directory the directory
+             */
+            void invalidate(const Path& directory);
+
+            /**
+             * Discards all cached listings.
+             */
+            void invalidateAll();
+
+            /**
+             * Indicates whether this cache is kept fresh by file system change notifications.
+             */
+            bool watching() const;
+
+            /**
+             * Returns the number of lookups that were answered using a cached listing and the number of listings that
+             * had to be read from the file system.
+             */
+            Stats stats() const;
+        private:
+            Listing readListing(const Path& directory);
+            static String findEntry(const Listing& listing, const String& name);
+            void removeListing(const String& key);
+            void removeAllListings();
+            void processNotifications();
+        };
+    }
+}
+
+#endif /* TrenchBroom_DirectoryCache_h */
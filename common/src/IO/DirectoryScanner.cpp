@@ -0,0 +1,195 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "DirectoryScanner.h"
+
+#include "ParallelUtils.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace TrenchBroom {
+    namespace IO {
+        DirectoryEntry::DirectoryEntry(const Path& i_path, const bool i_directory) :
+        path(i_path),
+        directory(i_directory) {}
+
+        namespace {
+            struct Node {
+                Path path;
+                DirectoryEntryList entries;
+                // one node for every directory entry, in the order of the entries
+                std::vector<std::unique_ptr<Node>> subdirectories;
+
+                explicit Node(const Path& i_path) :
+                path(i_path) {}
+            };
+
+            class Scan {
+            private:
+                const DirectoryScanner::ListDirectory& m_listDirectory;
+                const Path& m_root;
+                const bool m_recurse;
+                const size_t m_queueCapacity;
+
+                std::mutex m_mutex;
+                std::condition_variable m_condition;
+                std::deque<Node*> m_queue;
+                // the number of queued nodes plus the number of nodes being listed by workers
+                size_t m_pending;
+                std::exception_ptr m_exception;
+            public:
+                Scan(const DirectoryScanner::ListDirectory& listDirectory, const Path& root, const bool recurse, const size_t queueCapacity) :
+                m_listDirectory(listDirectory),
+                m_root(root),
+                m_recurse(recurse),
+                m_queueCapacity(queueCapacity),
+                m_pending(0) {}
+
+                void run(Node& root, const size_t threadCount) {
+                    if (threadCount <= 1) {
+                        list(root);
+                        return;
+                    }
+
+                    m_queue.push_back(&root);
+                    m_pending = 1;
+
+                    std::vector<std::thread> workers;
+                    workers.reserve(threadCount - 1);
+                    for (size_t i = 0; i < threadCount - 1; ++i) {
+                        workers.emplace_back([this]() { work(); });
+                    }
+
+                    work();
+
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+
+                    if (m_exception) {
+                        std::rethrow_exception(m_exception);
+                    }
+                }
+            private:
+                void work() {
+                    while (true) {
+                        Node* node;
+                        {
+                            std::unique_lock<std::mutex> lock(m_mutex);
+                            m_condition.wait(lock, [this]() { return !m_queue.empty() || m_pending == 0; });
+                            if (m_queue.empty()) {
+                                return;
+                            }
+                            node = m_queue.front();
+                            m_queue.pop_front();
+                        }
+
+                        try {
+                            list(*node);
+                        } catch (...) {
+                            std::lock_guard<std::mutex> lock(m_mutex);
+                            if (!m_exception) {
+                                m_exception = std::current_exception();
+                            }
+                        }
+
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (--m_pending == 0) {
+                            m_condition.notify_all();
+                        }
+                    }
+                }
+
+                void list(Node& node) {
+                    m_listDirectory(m_root + node.path, node.entries);
+                    if (!m_recurse) {
+                        return;
+                    }
+
+                    for (const auto& entry : node.entries) {
+                        if (entry.directory) {
+                            node.subdirectories.push_back(std::make_unique<Node>(node.path + entry.path));
+                            auto& subdirectory = *node.subdirectories.back();
+                            if (!enqueue(subdirectory)) {
+                                list(subdirectory);
+                            }
+                        }
+                    }
+                }
+
+                /**
+                 * Passes the given node on to the workers. Returns false if the queue is full, in which case the
+                 * caller must list the node itself.
+                 */
+                bool enqueue(Node& node) {
+                    if (m_queueCapacity == 0) {
+                        return false;
+                    }
+
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_exception) {
+                        // the scan has failed, so the node is dropped
+                        return true;
+                    }
+                    if (m_queue.size() >= m_queueCapacity) {
+                        return false;
+                    }
+
+                    m_queue.push_back(&node);
+                    ++m_pending;
+                    m_condition.notify_one();
+                    return true;
+                }
+            };
+
+            void collectEntries(const Node& node, const bool recurse, DirectoryEntryList& result) {
+                auto subdirectory = std::begin(node.subdirectories);
+                for (const auto& entry : node.entries) {
+                    if (entry.directory && recurse) {
+                        collectEntries(**subdirectory++, recurse, result);
+                    }
+                    result.emplace_back(node.path + entry.path, entry.directory);
+                }
+            }
+        }
+
+        DirectoryScanner::DirectoryScanner(const ListDirectory& listDirectory, const size_t threadCount) :
+        m_listDirectory(listDirectory),
+        m_threadCount(threadCount > 0 ? threadCount : ParallelUtils::threadCount(std::numeric_limits<size_t>::max())) {}
+
+        DirectoryEntryList DirectoryScanner::scan(const Path& path, const bool recurse) const {
+            const auto threadCount = recurse ? m_threadCount : 1;
+
+            Node root(Path(""));
+            Scan scan(m_listDirectory, path, recurse, threadCount > 1 ? 4 * threadCount : 0);
+            scan.run(root, threadCount);
+
+            DirectoryEntryList result;
+            collectEntries(root, recurse, result);
+            return result;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_DirectoryScanner_h
+#define TrenchBroom_DirectoryScanner_h
+
+#include "IO/Path.h"
+
+#include <functional>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        struct DirectoryEntry {
+            Path path;
+            bool directory;
+
+            DirectoryEntry(const Path& i_path, bool i_directory);
+        };
+
+        using DirectoryEntryList = std::vector<DirectoryEntry>;
+
+        /**
+         * Lists the contents of directory trees. Subdirectories can be listed in parallel by a number of worker threads
+         * that share a bounded work queue. If the queue is full, a worker lists the subdirectories it finds itself.
+         *
+         * The order of the listed entries never depends on how the work was distributed among the worker threads.
+         */
+        class DirectoryScanner {
+        public:
+            /**
+             * Appends the entries of the given directory to the given list. The path of each appended entry must be
+             * its name. Throws an exception if the directory cannot be read.
+             *
+             * If the scanner uses more than one thread, this function is called concurrently for different directories.
+             */
+            using ListDirectory = std::function<void(const Path& directory, DirectoryEntryList& entries)>;
+        private:
+            ListDirectory m_listDirectory;
+            size_t m_threadCount;
+        public:
+            /**
+             * Creates a new scanner.
+             *
+             * @param listDirectory the function to read the entries of a single directory with
+             * @param threadCount the number of threads to list directories with, or 0 to use one thread per hardware
+             * thread
+             */
+            explicit DirectoryScanner(const ListDirectory& listDirectory, size_t threadCount = 0);
+
+            /**
+             * Lists the entries of the given directory and, if recurse is true, the entries of all of its
+             * subdirectories. The returned paths are relative to the given directory.
+             *
+             * The entries are returned in depth first order: the entries of every directory appear in the order in
+             * which they were listed, and the entries of a subdirectory directly precede the subdirectory itself.
+             *
+             * @param path the path of the directory to scan
+             * @param recurse whether to list the entries of subdirectories
+             * @return the listed entries
+             *
+             * @throws any exception thrown by the listing function, after all worker threads have stopped
+             */
+            DirectoryEntryList scan(const Path& path, bool recurse) const;
+        };
+    }
+}
+
+#endif /* TrenchBroom_DirectoryScanner_h */
@@ -55,6 +55,10 @@ namespace TrenchBroom {
             return Disk::openFile(makeAbsolute(path));
         }
         
+        DirectoryEntryList DiskFileSystem::doScanDirectory(const Path& path, const bool recurse) const {
+            return Disk::scanDirectory(makeAbsolute(path), recurse);
+        }
+        
         WritableDiskFileSystem::WritableDiskFileSystem(const Path& root, const bool create) :
         DiskFileSystem(root, !create) {
             if (create && !Disk::directoryExists(m_root))
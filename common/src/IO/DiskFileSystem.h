@@ -38,6 +38,7 @@ namespace TrenchBroom {
             
             Path::List doGetDirectoryContents(const Path& path) const override;
             const MappedFile::Ptr doOpenFile(const Path& path) const override;
+            DirectoryEntryList doScanDirectory(const Path& path, bool recurse) const override;
         };
         
 #ifdef _MSC_VER
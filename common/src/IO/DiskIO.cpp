@@ -19,17 +19,28 @@
 
 #include "DiskIO.h"
 
+#include "IO/DirectoryCache.h"
+
 #include <wx/dir.h>
 #include <wx/filefn.h>
 #include <wx/filename.h>
 
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
 #include <fstream>
+#include <memory>
 
 namespace TrenchBroom {
     namespace IO {
         namespace Disk {
             bool doCheckCaseSensitive();
-            Path findCaseSensitivePath(const Path::List& list, const Path& path);
+            DirectoryCache& directoryCache();
+            bool listDirectory(const Path& path, StringList& names);
+            void listDirectoryEntries(const Path& path, DirectoryEntryList& entries);
             Path fixCase(const Path& path);
             
             bool doCheckCaseSensitive() {
@@ -42,13 +53,73 @@ namespace TrenchBroom {
                 static const bool caseSensitive = doCheckCaseSensitive();
                 return caseSensitive;
             }
-            
-            Path findCaseSensitivePath(const Path::List& list, const Path& path) {
-                for (const Path& entry : list) {
-                    if (StringUtils::caseInsensitiveEqual(entry.asString(), path.asString()))
-                        return entry;
+
+            DirectoryCache& directoryCache() {
+                static DirectoryCache cache(listDirectory, true);
+                return cache;
+            }
+
+            bool listDirectory(const Path& path, StringList& names) {
+                wxDir dir(path.asString());
+                if (!dir.IsOpened())
+                    return false;
+
+                wxString filename;
+                if (dir.GetFirst(&filename)) {
+                    names.push_back(filename.ToStdString());
+                    while (dir.GetNext(&filename))
+                        names.push_back(filename.ToStdString());
                 }
-                return Path("");
+                return true;
+            }
+
+            void listDirectoryEntries(const Path& path, DirectoryEntryList& entries) {
+                const auto first = entries.size();
+#ifdef _WIN32
+                wxDir dir(path.asString());
+                if (!dir.IsOpened())
+                    throw FileSystemException("Cannot open directory: '" + path.asString() + "'");
+
+                wxString filename;
+                for (bool found = dir.GetFirst(&filename, wxEmptyString, wxDIR_DIRS | wxDIR_HIDDEN); found; found = dir.GetNext(&filename))
+                    entries.emplace_back(Path(filename.ToStdString()), true);
+                for (bool found = dir.GetFirst(&filename, wxEmptyString, wxDIR_FILES | wxDIR_HIDDEN); found; found = dir.GetNext(&filename))
+                    entries.emplace_back(Path(filename.ToStdString()), false);
+#else
+                const String pathStr = path.asString();
+                std::unique_ptr<DIR, int(*)(DIR*)> dir(::opendir(pathStr.c_str()), &::closedir);
+                if (dir == nullptr)
+                    throw FileSystemException("Cannot open directory: '" + pathStr + "'");
+
+                while (const dirent* entry = ::readdir(dir.get())) {
+                    const String name(entry->d_name);
+                    if (name == "." || name == "..")
+                        continue;
+
+                    bool directory;
+                    switch (entry->d_type) {
+                        case DT_DIR:
+                            directory = true;
+                            break;
+                        case DT_REG:
+                            directory = false;
+                            break;
+                        default: {
+                            // follow symbolic links, and query the type if the file system does not report it
+                            struct stat status;
+                            directory = ::stat((pathStr + "/" + name).c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+                            break;
+                        }
+                    }
+                    entries.emplace_back(Path(name), directory);
+                }
+#endif
+                std::sort(std::begin(entries) + static_cast<DirectoryEntryList::difference_type>(first), std::end(entries),
+                          [](const DirectoryEntry& lhs, const DirectoryEntry& rhs) { return lhs.path < rhs.path; });
+            }
+
+            DirectoryCache::Stats directoryCacheStats() {
+                return directoryCache().stats();
             }
             
             Path fixCase(const Path& path) {
@@ -64,21 +135,11 @@ namespace TrenchBroom {
                     
                     Path result(path.firstComponent());
                     Path remainder(path.deleteFirstComponent());
-                    if (remainder.isEmpty())
-                        return result;
-                    
                     while (!remainder.isEmpty()) {
-                        const String nextPathStr = (result + remainder.firstComponent()).asString();
-                        if (!::wxDirExists(nextPathStr) &&
-                            !::wxFileExists(nextPathStr)) {
-                            const Path::List content = getDirectoryContents(result);
-                            const Path part = findCaseSensitivePath(content, remainder.firstComponent());
-                            if (part.isEmpty())
-                                return path;
-                            result = result + part;
-                        } else {
-                            result = result + remainder.firstComponent();
-                        }
+                        const String entry = directoryCache().findEntry(result, remainder.firstComponent().asString());
+                        if (entry.empty())
+                            return path;
+                        result = result + Path(entry);
                         remainder = remainder.deleteFirstComponent();
                     }
                     return result;
@@ -129,6 +190,12 @@ namespace TrenchBroom {
                 return result;
             }
             
+            DirectoryEntryList scanDirectory(const Path& path, const bool recurse) {
+                const Path fixedPath = fixPath(path);
+                const DirectoryScanner scanner(listDirectoryEntries);
+                return scanner.scan(fixedPath, recurse);
+            }
+            
             MappedFile::Ptr openFile(const Path& path) {
                 const Path fixedPath = fixPath(path);
                 if (!fileExists(fixedPath))
@@ -165,6 +232,7 @@ namespace TrenchBroom {
                 const String fixedPathStr = fixedPath.asString();
                 std::ofstream stream(fixedPathStr.c_str());
                 stream  << contents;
+                directoryCache().invalidate(fixedPath.deleteLastComponent());
             }
 
             bool createDirectoryHelper(const Path& path);
@@ -185,7 +253,10 @@ namespace TrenchBroom {
                 const IO::Path parent = path.deleteLastComponent();
                 if (!::wxDirExists(parent.asString()) && !createDirectoryHelper(parent))
                     return false;
-                return ::wxMkdir(path.asString());
+                if (!::wxMkdir(path.asString()))
+                    return false;
+                directoryCache().invalidate(parent);
+                return true;
             }
 
             void ensureDirectoryExists(const Path& path) {
@@ -202,6 +273,7 @@ namespace TrenchBroom {
                     throw FileSystemException("Could not delete file '" + fixedPath.asString() + "': File does not exist.");
                 if (!::wxRemoveFile(fixedPath.asString()))
                     throw FileSystemException("Could not delete file '" + path.asString() + "'");
+                directoryCache().invalidate(fixedPath.deleteLastComponent());
             }
             
             void copyFile(const Path& sourcePath, const Path& destPath, const bool overwrite) {
@@ -213,6 +285,7 @@ namespace TrenchBroom {
                     fixedDestPath = fixedDestPath + sourcePath.lastComponent();
                 if (!::wxCopyFile(fixedSourcePath.asString(), fixedDestPath.asString(), overwrite))
                     throw FileSystemException("Could not copy file '" + fixedSourcePath.asString() + "' to '" + fixedDestPath.asString() + "'");
+                directoryCache().invalidate(fixedDestPath.deleteLastComponent());
             }
             
             void moveFile(const Path& sourcePath, const Path& destPath, const bool overwrite) {
@@ -224,6 +297,8 @@ namespace TrenchBroom {
                     fixedDestPath = fixedDestPath + sourcePath.lastComponent();
                 if (!::wxRenameFile(fixedSourcePath.asString(), fixedDestPath.asString(), overwrite))
                     throw FileSystemException("Could not move file '" + fixedSourcePath.asString() + "' to '" + fixedDestPath.asString() + "'");
+                directoryCache().invalidate(fixedSourcePath.deleteLastComponent());
+                directoryCache().invalidate(fixedDestPath.deleteLastComponent());
             }
             
             IO::Path resolvePath(const Path::List& searchPaths, const Path& path) {
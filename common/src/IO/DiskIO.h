@@ -23,6 +23,8 @@
 #include "Functor.h"
 
 #include "StringUtils.h"
+#include "IO/DirectoryCache.h"
+#include "IO/DirectoryScanner.h"
 #include "IO/FileMatcher.h"
 #include "IO/MappedFile.h"
 #include "IO/Path.h"
@@ -32,7 +34,19 @@ namespace TrenchBroom {
         namespace Disk {
             bool isCaseSensitive();
             
+            /**
+             * Fixes the case of every component of the given path to match an existing file or directory, looking up
+             * the directory contents in a process wide cache.
+             *
+             * @param path the absolute path to fix
+             * @return the fixed path, or the given path if no matching file or directory exists
+             */
             Path fixPath(const Path& path);
+
+            /**
+             * Returns the hit and miss counts of the directory listing cache.
+             */
+            DirectoryCache::Stats directoryCacheStats();
             
             bool directoryExists(const Path& path);
             bool fileExists(const Path& path);
@@ -40,17 +54,26 @@ namespace TrenchBroom {
             String replaceForbiddenChars(const String& name);
             
             Path::List getDirectoryContents(const Path& path);
+
+            /**
+             * Lists the entries of the given directory and, if recurse is true, of all of its subdirectories, reading
+             * the subdirectories in parallel. Where the platform reports the type of each entry along with its name,
+             * entries are not queried individually. The entries of every directory are sorted by name.
+             *
+             * @param path the path of the directory to scan
+             * @param recurse whether to list the entries of subdirectories
+             * @return the listed entries, with paths relative to the given directory
+             */
+            DirectoryEntryList scanDirectory(const Path& path, bool recurse);
             MappedFile::Ptr openFile(const Path& path);
             Path getCurrentWorkingDir();
             
             template <class M>
             void doFindItems(const Path& searchPath, const M& matcher, const bool recurse, Path::List& result) {
-                for (const Path& itemPath : getDirectoryContents(searchPath)) {
-                    const bool directory = directoryExists(searchPath + itemPath);
-                    if (directory && recurse)
-                        doFindItems(searchPath + itemPath, matcher, recurse, result);
-                    if (matcher(searchPath + itemPath, directory))
-                        result.push_back(searchPath + itemPath);
+                for (const DirectoryEntry& entry : scanDirectory(searchPath, recurse)) {
+                    const Path path = searchPath + entry.path;
+                    if (matcher(path, entry.directory))
+                        result.push_back(path);
                 }
             }
             
@@ -24,7 +24,10 @@
 #include "IO/DiskFileSystem.h"
 #include "IO/IOUtils.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <memory>
 
 namespace TrenchBroom {
     namespace IO {
@@ -35,63 +38,127 @@ namespace TrenchBroom {
             static const String HeaderMagic       = "PACK";
         }
         
-        DkPakFileSystem::CompressedFile::CompressedFile(MappedFile::Ptr file, const size_t uncompressedSize) :
+        namespace {
+            /**
+             * Decompresses the given data. The data is a sequence of commands, each consisting of a command byte x
+             * that may be followed by arguments:
+             *
+             * - x < 0x40: x + 1 bytes follow that are copied to the output
+             * - x < 0x80: x - 62 zero bytes are written to the output
+             * - x < 0xC0: one byte follows that is written x - 126 times to the output
+             * - x < 0xFE: one byte o follows, and x - 190 bytes are copied from the output, starting o + 2 bytes
+             *   before the current position in the output
+             * - x = 0xFF: end of data
+             */
+            void decompressData(const Path& path, const char* begin, const char* end, char* result, const size_t size) {
+                const unsigned char* in = reinterpret_cast<const unsigned char*>(begin);
+                const unsigned char* inEnd = reinterpret_cast<const unsigned char*>(end);
+                char* out = result;
+                char* outEnd = result + size;
+
+                const auto check = [&](const bool valid) {
+                    if (!valid)
+                        throw FileSystemException("Invalid compressed data in file '" + path.asString() + "'");
+                };
+
+                while (in < inEnd) {
+                    const unsigned char x = *in++;
+                    if (x < 0x40) {
+                        const size_t len = static_cast<size_t>(x) + 1;
+                        check(static_cast<size_t>(inEnd - in) >= len && static_cast<size_t>(outEnd - out) >= len);
+                        std::memcpy(out, in, len);
+                        in += len;
+                        out += len;
+                    } else if (x < 0x80) {
+                        const size_t len = static_cast<size_t>(x) - 62;
+                        check(static_cast<size_t>(outEnd - out) >= len);
+                        std::memset(out, 0, len);
+                        out += len;
+                    } else if (x < 0xC0) {
+                        const size_t len = static_cast<size_t>(x) - 126;
+                        check(in < inEnd && static_cast<size_t>(outEnd - out) >= len);
+                        std::memset(out, *in++, len);
+                        out += len;
+                    } else if (x < 0xFE) {
+                        const size_t len = static_cast<size_t>(x) - 190;
+                        check(in < inEnd);
+                        const size_t distance = static_cast<size_t>(*in++) + 2;
+                        check(static_cast<size_t>(out - result) >= distance && static_cast<size_t>(outEnd - out) >= len);
+
+                        // if the source overlaps the copied bytes, the last distance bytes repeat, so we copy them
+                        // in blocks of at most distance bytes
+                        const char* from = out - distance;
+                        for (size_t copied = 0; copied < len; copied += distance)
+                            std::memcpy(out + copied, from + copied, std::min(distance, len - copied));
+                        out += len;
+                    } else if (x == 0xFF) {
+                        break;
+                    }
+                }
+
+                check(out == outEnd);
+            }
+        }
+
+        const size_t DkPakFileSystem::DefaultCacheSize = 32u * 1024u * 1024u;
+
+        DkPakFileSystem::DecompressedFileCache::DecompressedFileCache(const size_t maxSize) :
+        m_maxSize(maxSize),
+        m_size(0) {}
+
+        MappedFile::Ptr DkPakFileSystem::DecompressedFileCache::find(const CompressedFile* file) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto it = m_index.find(file);
+            if (it == std::end(m_index))
+                return nullptr;
+
+            m_entries.splice(std::begin(m_entries), m_entries, it->second);
+            return it->second->contents;
+        }
+
+        void DkPakFileSystem::DecompressedFileCache::insert(const CompressedFile* file, MappedFile::Ptr contents) {
+            if (contents->size() > m_maxSize)
+                return;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_index.count(file) > 0) // another thread has decompressed the file in the meantime
+                return;
+
+            m_entries.push_front(Entry { file, contents });
+            m_index[file] = std::begin(m_entries);
+            m_size += contents->size();
+
+            while (m_size > m_maxSize) {
+                const Entry& last = m_entries.back();
+                m_size -= last.contents->size();
+                m_index.erase(last.file);
+                m_entries.pop_back();
+            }
+        }
+
+        DkPakFileSystem::CompressedFile::CompressedFile(DecompressedFileCache& cache, MappedFile::Ptr file, const size_t uncompressedSize) :
+        m_cache(cache),
         m_file(file),
         m_uncompressedSize(uncompressedSize) {}
 
         MappedFile::Ptr DkPakFileSystem::CompressedFile::doOpen() {
-            const char* data = decompress();
-            return MappedFile::Ptr(new MappedFileBuffer(m_file->path(), data, m_uncompressedSize));
+            MappedFile::Ptr contents = m_cache.find(this);
+            if (contents == nullptr) {
+                contents = decompress();
+                m_cache.insert(this, contents);
+            }
+            return contents;
         }
 
-        char* DkPakFileSystem::CompressedFile::decompress() const {
-            CharArrayReader reader(m_file->begin(), m_file->end());
-            
-            char* result = new char[m_uncompressedSize];
-            char* curTarget = result;
-            
-            unsigned char x;
-            while (!reader.eof() && (x = reader.readUnsignedChar<unsigned char>()) < 0xFF) {
-                if (x < 0x40) {
-                    // x+1 bytes of uncompressed data follow (just read+write them as they are)
-                    const size_t len = static_cast<size_t>(x) + 1;
-                    reader.read(curTarget, len);
-                    curTarget += len;
-                } else if (x < 0x80) {
-                    // run-length encoded zeros, write (x - 62) zero-bytes to output
-                    const size_t len = static_cast<size_t>(x) - 62;
-                    memset(curTarget, 0, len);
-                    curTarget += len;
-                } else if (x < 0xC0) {
-                    // run-length encoded data, read one byte, write it (x-126) times to output
-                    const size_t len = static_cast<size_t>(x) - 126;
-                    const int data = reader.readInt<unsigned char>();
-                    memset(curTarget, data, len);
-                    curTarget += len;
-                } else if (x < 0xFE) {
-                    // this references previously uncompressed data
-                    // read one byte to get _offset_
-                    // read (x-190) bytes from the already uncompressed and written output data,
-                    // starting at (offset+2) bytes before the current write position (and add them to output, of course)
-                    const size_t len = static_cast<size_t>(x) - 190;
-                    const size_t offset = reader.readSize<unsigned char>();
-                    char* from = curTarget - offset + 2;
-                    
-                    assert(from >= result);
-                    assert(from <  curTarget - len);
-                    
-                    memcpy(from, curTarget, len);
-                    curTarget += len;
-                }
-
-                x = reader.readUnsignedChar<unsigned char>();
-            }
-            
-            return result;
+        MappedFile::Ptr DkPakFileSystem::CompressedFile::decompress() const {
+            std::unique_ptr<char[]> data(new char[m_uncompressedSize]);
+            decompressData(m_file->path(), m_file->begin(), m_file->end(), data.get(), m_uncompressedSize);
+            return MappedFile::Ptr(new MappedFileBuffer(m_file->path(), data.release(), m_uncompressedSize));
         }
         
-        DkPakFileSystem::DkPakFileSystem(const Path& path, MappedFile::Ptr file) :
-        ImageFileSystem(path, file) {
+        DkPakFileSystem::DkPakFileSystem(const Path& path, MappedFile::Ptr file, const size_t cacheSize) :
+        ImageFileSystem(path, file),
+        m_cache(cacheSize) {
             initialize();
         }
         
@@ -112,15 +179,20 @@ namespace TrenchBroom {
                 const size_t compressedSize = reader.readSize<int32_t>();
                 const bool compressed = reader.readBool<int32_t>();
                 
+                const size_t entrySize = compressed ? compressedSize : uncompressedSize;
+                if (entryAddress > m_file->size() || entrySize > m_file->size() - entryAddress)
+                    throw FileSystemException("Entry '" + entryName + "' exceeds the bounds of '" + m_path.asString() + "'");
+
                 const char* entryBegin = m_file->begin() + entryAddress;
-                const char* entryEnd = entryBegin + compressedSize;
+                const char* entryEnd = entryBegin + entrySize;
+
                 const Path filePath(StringUtils::toLower(entryName));
                 MappedFile::Ptr entryFile(new MappedFileView(m_file, filePath, entryBegin, entryEnd));
                 
                 if (compressed)
-                    m_root.addFile(filePath, new SimpleFile(entryFile));
+                    m_directoryTable.addFile(filePath, new CompressedFile(m_cache, entryFile, uncompressedSize));
                 else
-                    m_root.addFile(filePath, new CompressedFile(entryFile, uncompressedSize));
+                    m_directoryTable.addFile(filePath, new SimpleFile(entryFile));
             }
         }
     }
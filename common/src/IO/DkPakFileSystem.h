@@ -24,24 +24,69 @@
 #include "IO/ImageFileSystem.h"
 #include "IO/Path.h"
 
-#include <map>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 namespace TrenchBroom {
     namespace IO {
         class DkPakFileSystem : public ImageFileSystem {
+        public:
+            /**
+             * The default maximum total size of the decompressed files kept in memory.
+             */
+            static const size_t DefaultCacheSize;
         private:
+            class CompressedFile;
+
+            /**
+             * Keeps the contents of the most recently opened compressed files in memory so that opening them again
+             * does not decompress them again. The least recently used files are dropped once the total size of the
+             * cached files exceeds the maximum size; files that are still open remain valid nevertheless.
+             */
+            class DecompressedFileCache {
+            private:
+                struct Entry {
+                    const CompressedFile* file;
+                    MappedFile::Ptr contents;
+                };
+                using EntryList = std::list<Entry>;
+
+                size_t m_maxSize;
+                size_t m_size;
+                EntryList m_entries; // most recently used first
+                std::unordered_map<const CompressedFile*, EntryList::iterator> m_index;
+                std::mutex m_mutex;
+            public:
+                explicit DecompressedFileCache(size_t maxSize);
+
+                MappedFile::Ptr find(const CompressedFile* file);
+                void insert(const CompressedFile* file, MappedFile::Ptr contents);
+            };
+
             class CompressedFile : public File {
             private:
+                DecompressedFileCache& m_cache;
                 MappedFile::Ptr m_file;
                 const size_t m_uncompressedSize;
             public:
-                CompressedFile(MappedFile::Ptr file, size_t uncompressedSize);
+                CompressedFile(DecompressedFileCache& cache, MappedFile::Ptr file, size_t uncompressedSize);
             private:
                 MappedFile::Ptr doOpen() override;
-                char* decompress() const;
+                MappedFile::Ptr decompress() const;
             };
+
+            DecompressedFileCache m_cache;
         public:
-            DkPakFileSystem(const Path& path, MappedFile::Ptr file);
+            /**
+             * Creates a new file system for the given Daikatana pak file. Compressed entries are decompressed when
+             * they are opened.
+             *
+             * @param path the path of the pak file
+             * @param file the contents of the pak file
+             * @param cacheSize the maximum total size of the decompressed files to keep in memory
+             */
+            DkPakFileSystem(const Path& path, MappedFile::Ptr file, size_t cacheSize = DefaultCacheSize);
         private:
             void doReadDirectory() override;
             
@@ -0,0 +1,401 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "EntityDefinitionCache.h"
+
+#include "CollectionUtils.h"
+#include "Exceptions.h"
+#include "Macros.h"
+#include "Assets/AttributeDefinition.h"
+#include "Assets/EntityDefinition.h"
+#include "Assets/ModelDefinition.h"
+#include "EL/ELExceptions.h"
+#include "EL/ExpressionIO.h"
+#include "IO/AssetCacheIO.h"
+#include "IO/DefParser.h"
+#include "IO/DiskIO.h"
+#include "IO/FgdParser.h"
+
+#include <vecmath/bbox.h>
+
+#include <cstdint>
+
+namespace TrenchBroom {
+    namespace IO {
+        namespace {
+            void writeColor(AssetCacheWriter& writer, const Color& color) {
+                for (size_t i = 0; i < 4; ++i)
+                    writer.writeValue(color[i]);
+            }
+
+            Color readColor(AssetCacheReader& reader) {
+                const float r = reader.readValue<float>();
+                const float g = reader.readValue<float>();
+                const float b = reader.readValue<float>();
+                const float a = reader.readValue<float>();
+                return Color(r, g, b, a);
+            }
+
+            void writeBounds(AssetCacheWriter& writer, const vm::bbox3& bounds) {
+                for (size_t i = 0; i < 3; ++i)
+                    writer.writeValue(bounds.min[i]);
+                for (size_t i = 0; i < 3; ++i)
+                    writer.writeValue(bounds.max[i]);
+            }
+
+            vm::bbox3 readBounds(AssetCacheReader& reader) {
+                vm::bbox3 bounds;
+                for (size_t i = 0; i < 3; ++i)
+                    bounds.min[i] = reader.readValue<double>();
+                for (size_t i = 0; i < 3; ++i)
+                    bounds.max[i] = reader.readValue<double>();
+                return bounds;
+            }
+
+            void writeBool(AssetCacheWriter& writer, const bool value) {
+                writer.writeValue(static_cast<uint8_t>(value ? 1 : 0));
+            }
+
+            bool readBool(AssetCacheReader& reader) {
+                return reader.readValue<uint8_t>() != 0;
+            }
+        }
+
+        /*
+         Every entry starts with the number of paths at which included files were searched while parsing, and every
+         such path together with the identity of a key containing a hash of the contents of the file at that path, or
+         marking its absence. It continues with the number of
+         messages the parser logged and the level and text of every message, followed by the number of definitions.
+
+         Every definition consists of its type, name, color and description, the number of its attribute definitions
+         and every attribute definition. Point entity definitions continue with their bounds and their model
+         definition.
+
+         An attribute definition consists of its type, name and descriptions, followed by its default value if it has
+         one and its options if it is a choice or flags attribute.
+
+         A model definition is stored as the data of an EL::ExpressionWriter, which reproduces the expression tree
+         including the positions of its nodes.
+         */
+
+        EntityDefinitionCache::EntityDefinitionCache(AssetCache& cache) :
+        m_cache(cache) {}
+
+        AssetCache::Key EntityDefinitionCache::createKey(const MappedFile& file, const Color& defaultColor) {
+            AssetCache::Key key("entity definitions");
+            key.append(file.path().asString());
+            key.appendContents(file.begin(), file.end());
+            key.append(StringUtils::toString(defaultColor));
+            return key;
+        }
+
+        Assets::EntityDefinitionList EntityDefinitionCache::loadFgdDefinitions(const AssetCache::Key& key, FgdParser& parser, ParserStatus& status) {
+            Assets::EntityDefinitionList definitions;
+            if (find(key, status, definitions))
+                return definitions;
+
+            BufferedParserStatus parserStatus;
+            definitions = parse(parser, parserStatus, status);
+            store(key, parser.searchedIncludePaths(), parserStatus.messages(), definitions);
+            return definitions;
+        }
+
+        Assets::EntityDefinitionList EntityDefinitionCache::loadDefDefinitions(const AssetCache::Key& key, DefParser& parser, ParserStatus& status) {
+            Assets::EntityDefinitionList definitions;
+            if (find(key, status, definitions))
+                return definitions;
+
+            BufferedParserStatus parserStatus;
+            definitions = parse(parser, parserStatus, status);
+            store(key, Path::List(), parserStatus.messages(), definitions);
+            return definitions;
+        }
+
+        bool EntityDefinitionCache::find(const AssetCache::Key& key, ParserStatus& status, Assets::EntityDefinitionList& result) {
+            const MappedFile::Ptr entry = m_cache.find(key);
+            if (entry == nullptr)
+                return false;
+
+            try {
+                BufferedParserStatus::MessageList messages;
+                result = readEntry(entry, messages);
+                BufferedParserStatus(messages).replay(status);
+                return true;
+            } catch (const AssetException&) {
+                // the entry is stale or unusable, so we parse the definitions and replace it
+                return false;
+            }
+        }
+
+        void EntityDefinitionCache::store(const AssetCache::Key& key, const Path::List& includePaths, const BufferedParserStatus::MessageList& messages, const Assets::EntityDefinitionList& definitions) {
+            AssetCacheWriter writer;
+            writeEntry(includePaths, messages, definitions, writer);
+            m_cache.store(key, writer.data(), writer.size());
+        }
+
+        Assets::EntityDefinitionList EntityDefinitionCache::parse(EntityDefinitionParser& parser, BufferedParserStatus& parserStatus, ParserStatus& status) {
+            try {
+                Assets::EntityDefinitionList definitions = parser.parseDefinitions(parserStatus);
+                parserStatus.replay(status);
+                return definitions;
+            } catch (...) {
+                parserStatus.replay(status);
+                throw;
+            }
+        }
+
+        Assets::EntityDefinitionList EntityDefinitionCache::readEntry(const MappedFile::Ptr& entry, BufferedParserStatus::MessageList& messages) {
+            AssetCacheReader reader(entry->begin(), entry->end());
+
+            const size_t includeCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < includeCount; ++i) {
+                const String path = reader.readString();
+                const String identity = reader.readString();
+                if (includeIdentity(Path(path)) != identity)
+                    throw AssetException("Entity definition cache entry is stale");
+            }
+
+            const size_t messageCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < messageCount; ++i) {
+                const auto level = static_cast<Logger::LogLevel>(reader.readValue<uint32_t>());
+                messages.push_back(BufferedParserStatus::Message(level, reader.readString()));
+            }
+
+            Assets::EntityDefinitionList definitions;
+            try {
+                const size_t definitionCount = reader.readValue<uint32_t>();
+                for (size_t i = 0; i < definitionCount; ++i)
+                    definitions.push_back(readDefinition(reader));
+                return definitions;
+            } catch (...) {
+                VectorUtils::clearAndDelete(definitions);
+                throw;
+            }
+        }
+
+        void EntityDefinitionCache::writeEntry(const Path::List& includePaths, const BufferedParserStatus::MessageList& messages, const Assets::EntityDefinitionList& definitions, AssetCacheWriter& writer) {
+            writer.writeValue(static_cast<uint32_t>(includePaths.size()));
+            for (const Path& path : includePaths) {
+                writer.writeString(path.asString());
+                writer.writeString(includeIdentity(path));
+            }
+
+            writer.writeValue(static_cast<uint32_t>(messages.size()));
+            for (const BufferedParserStatus::Message& message : messages) {
+                writer.writeValue(static_cast<uint32_t>(message.first));
+                writer.writeString(message.second);
+            }
+
+            writer.writeValue(static_cast<uint32_t>(definitions.size()));
+            for (const Assets::EntityDefinition* definition : definitions)
+                writeDefinition(*definition, writer);
+        }
+
+        Assets::EntityDefinition* EntityDefinitionCache::readDefinition(AssetCacheReader& reader) {
+            const auto type = static_cast<Assets::EntityDefinition::Type>(reader.readValue<uint32_t>());
+            const String name = reader.readString();
+            const Color color = readColor(reader);
+            const String description = reader.readString();
+
+            Assets::AttributeDefinitionList attributeDefinitions;
+            const size_t attributeCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < attributeCount; ++i)
+                attributeDefinitions.push_back(readAttributeDefinition(reader));
+
+            switch (type) {
+                case Assets::EntityDefinition::Type_PointEntity: {
+                    const vm::bbox3 bounds = readBounds(reader);
+                    const Assets::ModelDefinition modelDefinition = readModelDefinition(reader);
+                    return new Assets::PointEntityDefinition(name, color, bounds, description, attributeDefinitions, modelDefinition);
+                }
+                case Assets::EntityDefinition::Type_BrushEntity:
+                    return new Assets::BrushEntityDefinition(name, color, description, attributeDefinitions);
+                default:
+                    throw AssetException("Unknown entity definition type in cache entry");
+            }
+        }
+
+        void EntityDefinitionCache::writeDefinition(const Assets::EntityDefinition& definition, AssetCacheWriter& writer) {
+            writer.writeValue(static_cast<uint32_t>(definition.type()));
+            writer.writeString(definition.name());
+            writeColor(writer, definition.color());
+            writer.writeString(definition.description());
+
+            const Assets::AttributeDefinitionList& attributeDefinitions = definition.attributeDefinitions();
+            writer.writeValue(static_cast<uint32_t>(attributeDefinitions.size()));
+            for (const Assets::AttributeDefinitionPtr& attributeDefinition : attributeDefinitions)
+                writeAttributeDefinition(*attributeDefinition, writer);
+
+            if (definition.type() == Assets::EntityDefinition::Type_PointEntity) {
+                const auto& pointDefinition = static_cast<const Assets::PointEntityDefinition&>(definition);
+                writeBounds(writer, pointDefinition.bounds());
+                writeModelDefinition(pointDefinition.modelDefinition(), writer);
+            }
+        }
+
+        Assets::AttributeDefinitionPtr EntityDefinitionCache::readAttributeDefinition(AssetCacheReader& reader) {
+            const auto type = static_cast<Assets::AttributeDefinition::Type>(reader.readValue<uint32_t>());
+            const String name = reader.readString();
+            const String shortDescription = reader.readString();
+            const String longDescription = reader.readString();
+
+            switch (type) {
+                case Assets::AttributeDefinition::Type_TargetSourceAttribute:
+                case Assets::AttributeDefinition::Type_TargetDestinationAttribute:
+                    return Assets::AttributeDefinitionPtr(new Assets::AttributeDefinition(name, type, shortDescription, longDescription));
+                case Assets::AttributeDefinition::Type_StringAttribute: {
+                    const bool unknown = readBool(reader);
+                    if (!readBool(reader)) {
+                        if (unknown)
+                            return Assets::AttributeDefinitionPtr(new Assets::UnknownAttributeDefinition(name, shortDescription, longDescription));
+                        return Assets::AttributeDefinitionPtr(new Assets::StringAttributeDefinition(name, shortDescription, longDescription));
+                    }
+                    const String defaultValue = reader.readString();
+                    if (unknown)
+                        return Assets::AttributeDefinitionPtr(new Assets::UnknownAttributeDefinition(name, shortDescription, longDescription, defaultValue));
+                    return Assets::AttributeDefinitionPtr(new Assets::StringAttributeDefinition(name, shortDescription, longDescription, defaultValue));
+                }
+                case Assets::AttributeDefinition::Type_IntegerAttribute:
+                    if (!readBool(reader))
+                        return Assets::AttributeDefinitionPtr(new Assets::IntegerAttributeDefinition(name, shortDescription, longDescription));
+                    return Assets::AttributeDefinitionPtr(new Assets::IntegerAttributeDefinition(name, shortDescription, longDescription, reader.readValue<int32_t>()));
+                case Assets::AttributeDefinition::Type_FloatAttribute:
+                    if (!readBool(reader))
+                        return Assets::AttributeDefinitionPtr(new Assets::FloatAttributeDefinition(name, shortDescription, longDescription));
+                    return Assets::AttributeDefinitionPtr(new Assets::FloatAttributeDefinition(name, shortDescription, longDescription, reader.readValue<float>()));
+                case Assets::AttributeDefinition::Type_ChoiceAttribute: {
+                    Assets::ChoiceAttributeOption::List options;
+                    const size_t optionCount = reader.readValue<uint32_t>();
+                    for (size_t i = 0; i < optionCount; ++i) {
+                        const String value = reader.readString();
+                        const String description = reader.readString();
+                        options.push_back(Assets::ChoiceAttributeOption(value, description));
+                    }
+                    if (!readBool(reader))
+                        return Assets::AttributeDefinitionPtr(new Assets::ChoiceAttributeDefinition(name, shortDescription, longDescription, options));
+                    return Assets::AttributeDefinitionPtr(new Assets::ChoiceAttributeDefinition(name, shortDescription, longDescription, options, static_cast<size_t>(reader.readValue<uint64_t>())));
+                }
+                case Assets::AttributeDefinition::Type_FlagsAttribute: {
+                    auto* definition = new Assets::FlagsAttributeDefinition(name);
+                    Assets::AttributeDefinitionPtr result(definition);
+                    const size_t optionCount = reader.readValue<uint32_t>();
+                    for (size_t i = 0; i < optionCount; ++i) {
+                        const int value = reader.readValue<int32_t>();
+                        const String optionShortDescription = reader.readString();
+                        const String optionLongDescription = reader.readString();
+                        const bool isDefault = readBool(reader);
+                        definition->addOption(value, optionShortDescription, optionLongDescription, isDefault);
+                    }
+                    return result;
+                }
+                default:
+                    throw AssetException("Unknown attribute definition type in cache entry");
+            }
+        }
+
+        void EntityDefinitionCache::writeAttributeDefinition(const Assets::AttributeDefinition& definition, AssetCacheWriter& writer) {
+            writer.writeValue(static_cast<uint32_t>(definition.type()));
+            writer.writeString(definition.name());
+            writer.writeString(definition.shortDescription());
+            writer.writeString(definition.longDescription());
+
+            switch (definition.type()) {
+                case Assets::AttributeDefinition::Type_TargetSourceAttribute:
+                case Assets::AttributeDefinition::Type_TargetDestinationAttribute:
+                    break;
+                case Assets::AttributeDefinition::Type_StringAttribute: {
+                    const auto& stringDefinition = static_cast<const Assets::StringAttributeDefinition&>(definition);
+                    writeBool(writer, dynamic_cast<const Assets::UnknownAttributeDefinition*>(&definition) != nullptr);
+                    writeBool(writer, stringDefinition.hasDefaultValue());
+                    if (stringDefinition.hasDefaultValue())
+                        writer.writeString(stringDefinition.defaultValue());
+                    break;
+                }
+                case Assets::AttributeDefinition::Type_IntegerAttribute: {
+                    const auto& integerDefinition = static_cast<const Assets::IntegerAttributeDefinition&>(definition);
+                    writeBool(writer, integerDefinition.hasDefaultValue());
+                    if (integerDefinition.hasDefaultValue())
+                        writer.writeValue(static_cast<int32_t>(integerDefinition.defaultValue()));
+                    break;
+                }
+                case Assets::AttributeDefinition::Type_FloatAttribute: {
+                    const auto& floatDefinition = static_cast<const Assets::FloatAttributeDefinition&>(definition);
+                    writeBool(writer, floatDefinition.hasDefaultValue());
+                    if (floatDefinition.hasDefaultValue())
+                        writer.writeValue(floatDefinition.defaultValue());
+                    break;
+                }
+                case Assets::AttributeDefinition::Type_ChoiceAttribute: {
+                    const auto& choiceDefinition = static_cast<const Assets::ChoiceAttributeDefinition&>(definition);
+                    writer.writeValue(static_cast<uint32_t>(choiceDefinition.options().size()));
+                    for (const Assets::ChoiceAttributeOption& option : choiceDefinition.options()) {
+                        writer.writeString(option.value());
+                        writer.writeString(option.description());
+                    }
+                    writeBool(writer, choiceDefinition.hasDefaultValue());
+                    if (choiceDefinition.hasDefaultValue())
+                        writer.writeValue(static_cast<uint64_t>(choiceDefinition.defaultValue()));
+                    break;
+                }
+                case Assets::AttributeDefinition::Type_FlagsAttribute: {
+                    const auto& flagsDefinition = static_cast<const Assets::FlagsAttributeDefinition&>(definition);
+                    writer.writeValue(static_cast<uint32_t>(flagsDefinition.options().size()));
+                    for (const Assets::FlagsAttributeOption& option : flagsDefinition.options()) {
+                        writer.writeValue(static_cast<int32_t>(option.value()));
+                        writer.writeString(option.shortDescription());
+                        writer.writeString(option.longDescription());
+                        writeBool(writer, option.isDefault());
+                    }
+                    break;
+                }
+                switchDefault()
+            }
+        }
+
+        Assets::ModelDefinition EntityDefinitionCache::readModelDefinition(AssetCacheReader& reader) {
+            const String data = reader.readString();
+            try {
+                return Assets::ModelDefinition(EL::ExpressionReader(data).readExpression());
+            } catch (const EL::Exception&) {
+                throw AssetException("Cannot read model expression from cache entry");
+            }
+        }
+
+        void EntityDefinitionCache::writeModelDefinition(const Assets::ModelDefinition& definition, AssetCacheWriter& writer) {
+            EL::ExpressionWriter expressionWriter;
+            expressionWriter.writeExpression(definition.expression());
+            writer.writeString(expressionWriter.data());
+        }
+
+        String EntityDefinitionCache::includeIdentity(const Path& path) {
+            AssetCache::Key key("include");
+            key.append(path.asString());
+            try {
+                const MappedFile::Ptr file = Disk::openFile(path);
+                key.appendContents(file->begin(), file->end());
+            } catch (const FileNotFoundException&) {
+                key.append("missing");
+            } catch (const FileSystemException&) {
+                key.append("missing");
+            }
+            return key.identity();
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_EntityDefinitionCache_h
+#define TrenchBroom_EntityDefinitionCache_h
+
+#include "Color.h"
+#include "Assets/AssetTypes.h"
+#include "IO/AssetCache.h"
+#include "IO/BufferedParserStatus.h"
+#include "IO/MappedFile.h"
+#include "IO/Path.h"
+
+namespace TrenchBroom {
+    namespace Assets {
+        class AttributeDefinition;
+        class EntityDefinition;
+        class ModelDefinition;
+    }
+
+    namespace IO {
+        class AssetCacheReader;
+        class AssetCacheWriter;
+        class DefParser;
+        class EntityDefinitionParser;
+        class FgdParser;
+        class ParserStatus;
+
+        /**
+         * Stores the entity definitions parsed from entity definition files in an asset cache so that a file does not
+         * have to be parsed again when another map using it is opened, when the definition file is reloaded or when
+         * the application is started again.
+         *
+         * An entry holds the definitions together with the messages that the parser logged, which are passed on to
+         * the given parser status whenever the entry is used. An entry also lists every path at which an included
+         * file was searched while parsing, together with a hash of the contents of the file at that path or its
+         * absence. If any of these files has been created, changed or removed, the entry is ignored.
+         */
+        class EntityDefinitionCache {
+        private:
+            AssetCache& m_cache;
+        public:
+            /**
+             * Creates a new entity definition cache.
+             *
+             * @param cache the cache to store the definitions in
+             */
+            explicit EntityDefinitionCache(AssetCache& cache);
+
+            /**
+             * Creates a key for the definitions that are parsed from the given file using the given default entity
+             * color. The key contains the path of the file and a hash of its contents, so that an edit is detected
+             * even if it preserves the size and modification time of the file.
+             *
+             * @param file the definition file
+             * @param defaultColor the default entity color used when parsing
+             * @return the key
+             */
+            static AssetCache::Key createKey(const MappedFile& file, const Color& defaultColor);
+
+            /**
+             * Loads the definitions from the entry with the given key, or parses them with the given parser and stores
+             * them if there is no valid entry. In either case, the messages of the parser are passed on to the given
+             * status.
+             *
+             * @param key the key of the definitions
+             * @param parser the parser to use if the definitions are not cached
+             * @param status the status to pass the messages of the parser on to
+             * @return the definitions, the caller takes ownership
+             * @throws ParserException if the definitions cannot be parsed
+             */
+            Assets::EntityDefinitionList loadFgdDefinitions(const AssetCache::Key& key, FgdParser& parser, ParserStatus& status);
+            Assets::EntityDefinitionList loadDefDefinitions(const AssetCache::Key& key, DefParser& parser, ParserStatus& status);
+        private:
+            bool find(const AssetCache::Key& key, ParserStatus& status, Assets::EntityDefinitionList& result);
+            void store(const AssetCache::Key& key, const Path::List& includePaths, const BufferedParserStatus::MessageList& messages, const Assets::EntityDefinitionList& definitions);
+
+            static Assets::EntityDefinitionList parse(EntityDefinitionParser& parser, BufferedParserStatus& parserStatus, ParserStatus& status);
+
+            static Assets::EntityDefinitionList readEntry(const MappedFile::Ptr& entry, BufferedParserStatus::MessageList& messages);
+            static void writeEntry(const Path::List& includePaths, const BufferedParserStatus::MessageList& messages, const Assets::EntityDefinitionList& definitions, AssetCacheWriter& writer);
+
+            static Assets::EntityDefinition* readDefinition(AssetCacheReader& reader);
+            static void writeDefinition(const Assets::EntityDefinition& definition, AssetCacheWriter& writer);
+
+            static Assets::AttributeDefinitionPtr readAttributeDefinition(AssetCacheReader& reader);
+            static void writeAttributeDefinition(const Assets::AttributeDefinition& definition, AssetCacheWriter& writer);
+
+            static Assets::ModelDefinition readModelDefinition(AssetCacheReader& reader);
+            static void writeModelDefinition(const Assets::ModelDefinition& definition, AssetCacheWriter& writer);
+
+            static String includeIdentity(const Path& path);
+        };
+    }
+}
+
+#endif /* TrenchBroom_EntityDefinitionCache_h */
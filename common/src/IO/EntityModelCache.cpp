@@ -0,0 +1,437 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "EntityModelCache.h"
+
+#include "CollectionUtils.h"
+#include "Exceptions.h"
+#include "Assets/Bsp29Model.h"
+#include "Assets/Md2Model.h"
+#include "Assets/MdlModel.h"
+#include "Assets/Texture.h"
+#include "Assets/TextureCollection.h"
+#include "IO/AssetCacheIO.h"
+#include "IO/EntityModelParser.h"
+#include "IO/FileSystem.h"
+#include "IO/Md2Parser.h"
+#include "IO/MdlParser.h"
+#include "IO/Path.h"
+
+#include <vecmath/bbox.h>
+#include <vecmath/vec.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        namespace {
+            template <typename M, typename R, typename W>
+            Assets::EntityModel* loadModel(AssetCache& cache, const AssetCache::Key& key, EntityModelParser& parser, R read, W write) {
+                const MappedFile::Ptr entry = cache.find(key);
+                if (entry != nullptr) {
+                    try {
+                        return read(entry);
+                    } catch (const AssetException&) {
+                        // the entry is stale or unusable, so we parse the model and replace it
+                    }
+                }
+
+                std::unique_ptr<Assets::EntityModel> model(parser.parseModel());
+                if (model != nullptr) {
+                    try {
+                        AssetCacheWriter writer;
+                        write(static_cast<const M&>(*model), writer);
+                        cache.store(key, writer.data(), writer.size());
+                    } catch (const FileSystemException&) {
+                    } catch (const FileNotFoundException&) {}
+                }
+                return model.release();
+            }
+
+            void writeVec(AssetCacheWriter& writer, const vm::vec3f& vec) {
+                for (size_t i = 0; i < 3; ++i)
+                    writer.writeValue(vec[i]);
+            }
+
+            vm::vec3f readVec(AssetCacheReader& reader) {
+                vm::vec3f vec;
+                for (size_t i = 0; i < 3; ++i)
+                    vec[i] = reader.readValue<float>();
+                return vec;
+            }
+
+            void writeBounds(AssetCacheWriter& writer, const vm::bbox3f& bounds) {
+                writeVec(writer, bounds.min);
+                writeVec(writer, bounds.max);
+            }
+
+            vm::bbox3f readBounds(AssetCacheReader& reader) {
+                vm::bbox3f bounds;
+                bounds.min = readVec(reader);
+                bounds.max = readVec(reader);
+                return bounds;
+            }
+
+            void writeTextures(AssetCacheWriter& writer, const Assets::TextureList& textures) {
+                writer.writeValue(static_cast<uint32_t>(textures.size()));
+                for (const Assets::Texture* texture : textures)
+                    writer.writeTexture(*texture);
+            }
+
+            Assets::TextureList readTextures(AssetCacheReader& reader) {
+                Assets::TextureList textures;
+                try {
+                    const size_t textureCount = reader.readValue<uint32_t>();
+                    for (size_t i = 0; i < textureCount; ++i)
+                        textures.push_back(reader.readTexture());
+                    return textures;
+                } catch (...) {
+                    VectorUtils::clearAndDelete(textures);
+                    throw;
+                }
+            }
+
+        }
+
+        /*
+         Every entry starts with the number of files the model references, and the path and the identity of a key
+         describing the contents of every such file.
+
+         An MDL entry continues with
+         - the skin width and height, the origin and the scale of the frame vertices
+         - the number of skin vertices, and the seam flag and texture coordinates of every skin vertex
+         - the number of skin triangles, and the front flag and vertex indices of every skin triangle
+         - the number of frames, and for every frame the number of its bytes followed by the frame as stored in the
+           model file, or 0 for an empty frame group
+         - the number of skins, and for every skin the number of its pictures and every picture's time and texture
+
+         An MD2 entry continues with
+         - the number of vertices of a frame and the number of bytes of a frame
+         - the number of meshes, and for every mesh its type and the number of its vertices followed by the
+           texture coordinates and vertex index of every mesh vertex
+         - the number of frames followed by the frames as stored in the model file
+         - the skin textures
+
+         A BSP entry continues with
+         - the textures
+         - the number of sub models, and for every sub model its bounds and the number of its faces followed by the
+           texture index and the vertices of every face
+         */
+
+        EntityModelCache::EntityModelCache(AssetCache& cache, const FileSystem& fs) :
+        m_cache(cache),
+        m_fs(fs) {}
+
+        AssetCache::Key EntityModelCache::createKey(const String& format, const MappedFile& file) {
+            AssetCache::Key key("models");
+            key.append(format);
+            key.appendContents(file.begin(), file.end());
+            return key;
+        }
+
+        Assets::EntityModel* EntityModelCache::loadMdlModel(const AssetCache::Key& key, const String& name, MdlParser& parser) {
+            return loadModel<Assets::MdlModel>(m_cache, key, parser,
+                [&](const MappedFile::Ptr& entry) { return readMdlModel(name, entry); },
+                [&](const Assets::MdlModel& model, AssetCacheWriter& writer) { writeMdlModel(model, *parser.frameData(), writer); });
+        }
+
+        Assets::EntityModel* EntityModelCache::loadMd2Model(const AssetCache::Key& key, const String& name, Md2Parser& parser) {
+            return loadModel<Assets::Md2Model>(m_cache, key, parser,
+                [&](const MappedFile::Ptr& entry) { return readMd2Model(name, entry); },
+                [&](const Assets::Md2Model& model, AssetCacheWriter& writer) { writeMd2Model(model, *parser.frameData(), writer); });
+        }
+
+        Assets::EntityModel* EntityModelCache::loadBspModel(const AssetCache::Key& key, const String& name, EntityModelParser& parser) {
+            return loadModel<Assets::Bsp29Model>(m_cache, key, parser,
+                [&](const MappedFile::Ptr& entry) { return readBspModel(name, entry); },
+                [&](const Assets::Bsp29Model& model, AssetCacheWriter& writer) { writeBspModel(model, writer); });
+        }
+
+        Assets::EntityModel* EntityModelCache::readMdlModel(const String& name, const MappedFile::Ptr& entry) const {
+            AssetCacheReader reader(entry->begin(), entry->end());
+            readDependencies(reader);
+
+            // the frames are decoded from the mapped entry when the model requests them
+            auto frameData = std::make_shared<MdlParser::FrameData>();
+            frameData->file = entry;
+            frameData->skinWidth = reader.readValue<uint32_t>();
+            frameData->skinHeight = reader.readValue<uint32_t>();
+            frameData->origin = readVec(reader);
+            frameData->scale = readVec(reader);
+
+            const size_t skinVertexCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < skinVertexCount; ++i) {
+                MdlParser::MdlSkinVertex vertex;
+                vertex.onseam = reader.readValue<uint8_t>() != 0;
+                vertex.s = reader.readValue<int32_t>();
+                vertex.t = reader.readValue<int32_t>();
+                frameData->skinVertices.push_back(vertex);
+            }
+
+            const size_t skinTriangleCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < skinTriangleCount; ++i) {
+                MdlParser::MdlSkinTriangle triangle;
+                triangle.front = reader.readValue<uint8_t>() != 0;
+                for (size_t j = 0; j < 3; ++j) {
+                    triangle.vertices[j] = reader.readValue<uint32_t>();
+                    if (triangle.vertices[j] >= skinVertexCount)
+                        throw AssetException("Model cache entry is corrupt");
+                }
+                frameData->skinTriangles.push_back(triangle);
+            }
+
+            const size_t frameSize = MdlParser::frameSize(*frameData);
+            const size_t frameCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < frameCount; ++i) {
+                const size_t size = reader.readValue<uint32_t>();
+                if (size == 0) {
+                    frameData->frameOffsets.push_back(0);
+                } else if (size == frameSize && skinVertexCount > 0) {
+                    frameData->frameOffsets.push_back(reader.position());
+                    reader.skip(size);
+                } else {
+                    throw AssetException("Model cache entry is corrupt");
+                }
+            }
+
+            std::unique_ptr<Assets::MdlModel> model(new Assets::MdlModel(name, frameCount, [frameData](const size_t frameIndex) {
+                return MdlParser::parseFrame(*frameData, frameIndex);
+            }));
+
+            const size_t skinCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < skinCount; ++i) {
+                const size_t pictureCount = reader.readValue<uint32_t>();
+                Assets::MdlTimeList times;
+                for (size_t j = 0; j < pictureCount; ++j)
+                    times.push_back(reader.readValue<float>());
+
+                Assets::TextureList pictures = readTextures(reader);
+                if (pictures.empty() || pictures.size() != times.size()) {
+                    VectorUtils::clearAndDelete(pictures);
+                    throw AssetException("Model cache entry is corrupt");
+                }
+                model->addSkin(new Assets::MdlSkin(pictures, times));
+            }
+
+            return model.release();
+        }
+
+        void EntityModelCache::writeMdlModel(const Assets::MdlModel& model, const MdlParser::FrameData& frameData, AssetCacheWriter& writer) const {
+            writeDependencies(StringList(), writer);
+
+            writer.writeValue(static_cast<uint32_t>(frameData.skinWidth));
+            writer.writeValue(static_cast<uint32_t>(frameData.skinHeight));
+            writeVec(writer, frameData.origin);
+            writeVec(writer, frameData.scale);
+
+            writer.writeValue(static_cast<uint32_t>(frameData.skinVertices.size()));
+            for (const MdlParser::MdlSkinVertex& vertex : frameData.skinVertices) {
+                writer.writeValue(static_cast<uint8_t>(vertex.onseam ? 1 : 0));
+                writer.writeValue(static_cast<int32_t>(vertex.s));
+                writer.writeValue(static_cast<int32_t>(vertex.t));
+            }
+
+            writer.writeValue(static_cast<uint32_t>(frameData.skinTriangles.size()));
+            for (const MdlParser::MdlSkinTriangle& triangle : frameData.skinTriangles) {
+                writer.writeValue(static_cast<uint8_t>(triangle.front ? 1 : 0));
+                for (size_t j = 0; j < 3; ++j)
+                    writer.writeValue(static_cast<uint32_t>(triangle.vertices[j]));
+            }
+
+            // the frames are copied without decoding them
+            const size_t frameSize = MdlParser::frameSize(frameData);
+            writer.writeValue(static_cast<uint32_t>(frameData.frameOffsets.size()));
+            for (const size_t offset : frameData.frameOffsets) {
+                if (offset == 0) {
+                    writer.writeValue(uint32_t(0));
+                } else {
+                    writer.writeValue(static_cast<uint32_t>(frameSize));
+                    writer.write(frameData.file->begin() + offset, frameSize);
+                }
+            }
+
+            writer.writeValue(static_cast<uint32_t>(model.skinCount()));
+            for (size_t i = 0; i < model.skinCount(); ++i) {
+                const Assets::MdlSkin* skin = model.skin(i);
+                writer.writeValue(static_cast<uint32_t>(skin->times().size()));
+                for (const float time : skin->times())
+                    writer.writeValue(time);
+                writeTextures(writer, skin->pictures());
+            }
+        }
+
+        Assets::EntityModel* EntityModelCache::readMd2Model(const String& name, const MappedFile::Ptr& entry) const {
+            AssetCacheReader reader(entry->begin(), entry->end());
+            readDependencies(reader);
+
+            // the frames are decoded from the mapped entry when the model requests them
+            auto frameData = std::make_shared<Md2Parser::FrameData>();
+            frameData->file = entry;
+            frameData->frameVertexCount = reader.readValue<uint32_t>();
+            frameData->frameSize = reader.readValue<uint32_t>();
+            if (frameData->frameSize < Md2Parser::minFrameSize(frameData->frameVertexCount))
+                throw AssetException("Model cache entry is corrupt");
+
+            const size_t meshCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < meshCount; ++i) {
+                const bool fan = reader.readValue<uint32_t>() == Md2Parser::Md2Mesh::Fan;
+                const size_t vertexCount = reader.readValue<uint32_t>();
+                if (vertexCount > static_cast<size_t>(entry->end() - entry->begin()))
+                    throw AssetException("Model cache entry is corrupt");
+
+                Md2Parser::Md2Mesh mesh(fan ? -static_cast<int>(vertexCount) : static_cast<int>(vertexCount));
+                for (Md2Parser::Md2MeshVertex& vertex : mesh.vertices) {
+                    vertex.texCoords[0] = reader.readValue<float>();
+                    vertex.texCoords[1] = reader.readValue<float>();
+                    vertex.vertexIndex = reader.readValue<uint32_t>();
+                    if (vertex.vertexIndex >= frameData->frameVertexCount)
+                        throw AssetException("Model cache entry is corrupt");
+                }
+                frameData->meshes.push_back(mesh);
+            }
+
+            const size_t frameCount = reader.readValue<uint32_t>();
+            frameData->frameOffset = reader.position();
+            for (size_t i = 0; i < frameCount; ++i)
+                reader.skip(frameData->frameSize);
+
+            const Assets::TextureList skins = readTextures(reader);
+            return new Assets::Md2Model(name, skins, frameCount, [frameData](const size_t frameIndex) {
+                return Md2Parser::decodeFrame(*frameData, frameIndex);
+            });
+        }
+
+        void EntityModelCache::writeMd2Model(const Assets::Md2Model& model, const Md2Parser::FrameData& frameData, AssetCacheWriter& writer) const {
+            // the skins are read from separate files which may change without the model file changing
+            StringList skinPaths;
+            for (const Assets::Texture* skin : model.skins())
+                skinPaths.push_back(skin->name());
+            writeDependencies(skinPaths, writer);
+
+            writer.writeValue(static_cast<uint32_t>(frameData.frameVertexCount));
+            writer.writeValue(static_cast<uint32_t>(frameData.frameSize));
+
+            writer.writeValue(static_cast<uint32_t>(frameData.meshes.size()));
+            for (const Md2Parser::Md2Mesh& mesh : frameData.meshes) {
+                writer.writeValue(static_cast<uint32_t>(mesh.type));
+                writer.writeValue(static_cast<uint32_t>(mesh.vertices.size()));
+                for (const Md2Parser::Md2MeshVertex& vertex : mesh.vertices) {
+                    writer.writeValue(vertex.texCoords[0]);
+                    writer.writeValue(vertex.texCoords[1]);
+                    writer.writeValue(static_cast<uint32_t>(vertex.vertexIndex));
+                }
+            }
+
+            // the frames are copied without decoding them
+            writer.writeValue(static_cast<uint32_t>(model.frameCount()));
+            writer.write(frameData.file->begin() + frameData.frameOffset, model.frameCount() * frameData.frameSize);
+
+            writeTextures(writer, model.skins());
+        }
+
+        Assets::EntityModel* EntityModelCache::readBspModel(const String& name, const MappedFile::Ptr& entry) const {
+            AssetCacheReader reader(entry->begin(), entry->end());
+            readDependencies(reader);
+
+            Assets::TextureCollection* textures = new Assets::TextureCollection(IO::Path(name), readTextures(reader));
+            std::unique_ptr<Assets::Bsp29Model> model(new Assets::Bsp29Model(name, textures));
+
+            const size_t subModelCount = reader.readValue<uint32_t>();
+            if (subModelCount == 0)
+                throw AssetException("Model cache entry is corrupt");
+
+            for (size_t i = 0; i < subModelCount; ++i) {
+                const vm::bbox3f bounds = readBounds(reader);
+                const size_t faceCount = reader.readValue<uint32_t>();
+
+                Assets::Bsp29Model::FaceList faces;
+                for (size_t j = 0; j < faceCount; ++j) {
+                    const int32_t textureIndex = reader.readValue<int32_t>();
+                    if (textureIndex >= static_cast<int32_t>(textures->textures().size()))
+                        throw AssetException("Model cache entry is corrupt");
+
+                    Assets::Texture* texture = textureIndex < 0 ? nullptr : textures->textureByIndex(static_cast<size_t>(textureIndex));
+                    faces.push_back(Assets::Bsp29Model::Face(texture, reader.readVertices<Assets::Bsp29Model::Face::Vertex>()));
+                }
+                model->addModel(faces, bounds);
+            }
+
+            return model.release();
+        }
+
+        void EntityModelCache::writeBspModel(const Assets::Bsp29Model& model, AssetCacheWriter& writer) const {
+            writeDependencies(StringList(), writer);
+
+            const Assets::TextureList& textures = model.textureCollection().textures();
+            writeTextures(writer, textures);
+
+            std::map<const Assets::Texture*, int32_t> textureIndices;
+            for (size_t i = 0; i < textures.size(); ++i)
+                textureIndices[textures[i]] = static_cast<int32_t>(i);
+
+            writer.writeValue(static_cast<uint32_t>(model.subModelCount()));
+            for (size_t i = 0; i < model.subModelCount(); ++i) {
+                writeBounds(writer, model.subModelBounds(i));
+
+                const Assets::Bsp29Model::FaceList& faces = model.subModelFaces(i);
+                writer.writeValue(static_cast<uint32_t>(faces.size()));
+                for (const Assets::Bsp29Model::Face& face : faces) {
+                    const auto it = textureIndices.find(face.texture());
+                    writer.writeValue(it != std::end(textureIndices) ? it->second : int32_t(-1));
+                    writer.writeVertices(face.vertices());
+                }
+            }
+        }
+
+        void EntityModelCache::readDependencies(AssetCacheReader& reader) const {
+            const size_t count = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < count; ++i) {
+                const String path = reader.readString();
+                const String identity = reader.readString();
+                try {
+                    if (dependencyIdentity(path) != identity)
+                        throw AssetException("Model cache entry is stale");
+                } catch (const FileSystemException&) {
+                    throw AssetException("Model cache entry is stale");
+                } catch (const FileNotFoundException&) {
+                    throw AssetException("Model cache entry is stale");
+                }
+            }
+        }
+
+        void EntityModelCache::writeDependencies(const StringList& paths, AssetCacheWriter& writer) const {
+            writer.writeValue(static_cast<uint32_t>(paths.size()));
+            for (const String& path : paths) {
+                writer.writeString(path);
+                writer.writeString(dependencyIdentity(path));
+            }
+        }
+
+        String EntityModelCache::dependencyIdentity(const String& path) const {
+            const MappedFile::Ptr file = m_fs.openFile(Path(path));
+            AssetCache::Key key("dependency");
+            key.appendContents(file->begin(), file->end());
+            return key.identity();
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_EntityModelCache_h
+#define TrenchBroom_EntityModelCache_h
+
+#include "StringUtils.h"
+#include "IO/AssetCache.h"
+#include "IO/MappedFile.h"
+#include "IO/Md2Parser.h"
+#include "IO/MdlParser.h"
+
+namespace TrenchBroom {
+    namespace Assets {
+        class EntityModel;
+        class Bsp29Model;
+        class Md2Model;
+        class MdlModel;
+    }
+
+    namespace IO {
+        class AssetCacheReader;
+        class AssetCacheWriter;
+        class EntityModelParser;
+        class FileSystem;
+
+        /**
+         * Stores decoded entity models in an asset cache so that they can be loaded without parsing the model files
+         * and converting their skins again.
+         *
+         * An entry holds the skins as RGBA images. For animated models, it also holds what the parser needs to decode
+         * the frames and a copy of the frames as they are stored in the model file. Storing a model therefore does
+         * not decode its frames, and the frames of a cached model are decoded from the mapped entry when the model
+         * requests them. For BSP models, an entry holds the vertices of every face. An entry also lists the files
+         * that the model references, such as the skins of MD2 models, together with a hash of their contents. If any
+         * of them has changed, the entry is ignored.
+         */
+        class EntityModelCache {
+        private:
+            AssetCache& m_cache;
+            const FileSystem& m_fs;
+        public:
+            /**
+             * Creates a new entity model cache.
+             *
+             * @param cache the cache to store the models in
+             * @param fs the file system to read the files referenced by the models from
+             */
+            EntityModelCache(AssetCache& cache, const FileSystem& fs);
+
+            /**
+             * Creates a key for a model of the given format that is read from the given file. Since the file may be
+             * stored in an archive, the key contains a hash of its contents rather than its modification time.
+             *
+             * @param format the model format, e.g. "mdl"
+             * @param file the model file
+             * @return the key
+             */
+            static AssetCache::Key createKey(const String& format, const MappedFile& file);
+
+            /**
+             * Loads a model from the entry with the given key, or parses it with the given parser and stores it if
+             * there is no valid entry.
+             *
+             * @param key the key of the model
+             * @param name the name of the model
+             * @param parser the parser to use if the model is not cached
+             * @return the model
+             * @throws AssetException if the model cannot be parsed
+             */
+            Assets::EntityModel* loadMdlModel(const AssetCache::Key& key, const String& name, MdlParser& parser);
+            Assets::EntityModel* loadMd2Model(const AssetCache::Key& key, const String& name, Md2Parser& parser);
+            Assets::EntityModel* loadBspModel(const AssetCache::Key& key, const String& name, EntityModelParser& parser);
+        private:
+            Assets::EntityModel* readMdlModel(const String& name, const MappedFile::Ptr& entry) const;
+            void writeMdlModel(const Assets::MdlModel& model, const MdlParser::FrameData& frameData, AssetCacheWriter& writer) const;
+
+            Assets::EntityModel* readMd2Model(const String& name, const MappedFile::Ptr& entry) const;
+            void writeMd2Model(const Assets::Md2Model& model, const Md2Parser::FrameData& frameData, AssetCacheWriter& writer) const;
+
+            Assets::EntityModel* readBspModel(const String& name, const MappedFile::Ptr& entry) const;
+            void writeBspModel(const Assets::Bsp29Model& model, AssetCacheWriter& writer) const;
+
+            void readDependencies(AssetCacheReader& reader) const;
+            void writeDependencies(const StringList& paths, AssetCacheWriter& writer) const;
+            String dependencyIdentity(const String& path) const;
+        };
+    }
+}
+
+#endif /* TrenchBroom_EntityModelCache_h */
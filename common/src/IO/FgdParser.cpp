@@ -21,13 +21,17 @@
 
 #include "CollectionUtils.h"
 #include "Exceptions.h"
+#include "Macros.h"
+#include "ParallelUtils.h"
 #include "Assets/EntityDefinition.h"
 #include "Assets/AttributeDefinition.h"
 #include "Assets/ModelDefinition.h"
+#include "IO/BufferedParserStatus.h"
 #include "IO/DiskFileSystem.h"
 #include "IO/DiskIO.h"
 #include "IO/ELParser.h"
 #include "IO/LegacyModelDefinitionParser.h"
+#include "IO/MappedFile.h"
 #include "IO/ParserStatus.h"
 
 namespace TrenchBroom {
@@ -139,20 +143,36 @@ namespace TrenchBroom {
             return names;
         }
 
-        class FgdParser::PushIncludePath {
-        private:
-            FgdParser* m_parser;
-        public:
-            PushIncludePath(FgdParser* parser, const Path& path) :
-                m_parser(parser) {
-                m_parser->pushIncludePath(path);
-            }
+        struct FgdParser::IncludedFile {
+            size_t line;
+            Path path;
+            Path::List searchedPaths;
+            Path filePath;
+            MappedFile::Ptr file;
+            EntryList entries;
+            BufferedParserStatus status;
+            String error;
 
-            ~PushIncludePath() {
-                m_parser->popIncludePath();
-            }
+            IncludedFile(const size_t i_line, const Path& i_path) :
+            line(i_line),
+            path(i_path) {}
         };
 
+        FgdParser::Entry::Entry(const Type i_type, const EntityDefinitionClassInfo& i_classInfo, const StringList& i_superClasses) :
+        type(i_type),
+        classInfo(i_classInfo),
+        superClasses(i_superClasses),
+        messageEnd(0) {}
+
+        FgdParser::Entry::Entry(std::shared_ptr<IncludedFile> i_include) :
+        type(Type_Include),
+        include(std::move(i_include)),
+        messageEnd(0) {}
+
+        const Path::List& FgdParser::searchedIncludePaths() const {
+            return m_searchedIncludePaths;
+        }
+
         void FgdParser::pushIncludePath(const Path& path) {
             ensure(path.isAbsolute(), "include path must be absolute");
             assert(!isRecursiveInclude(path));
@@ -162,9 +182,18 @@ namespace TrenchBroom {
             m_paths.push_back(path);
         }
 
-        void FgdParser::popIncludePath() {
-            m_fileSystem.popFileSystem();
-            m_paths.pop_back();
+        Path::List FgdParser::searchPaths(const Path& path) const {
+            if (path.isAbsolute()) {
+                return Path::List(1, path);
+            }
+
+            // the folder of the innermost file is searched first
+            const auto relativePath = path.makeCanonical();
+            Path::List result;
+            for (auto it = m_paths.rbegin(), end = m_paths.rend(); it != end; ++it) {
+                result.push_back(it->deleteLastComponent() + relativePath);
+            }
+            return result;
         }
 
         bool FgdParser::isRecursiveInclude(const Path& path) const {
@@ -177,13 +206,18 @@ namespace TrenchBroom {
         }
 
         Assets::EntityDefinitionList FgdParser::doParseDefinitions(ParserStatus& status) {
+            BufferedParserStatus fileStatus(status);
+            EntryList entries;
+            try {
+                parseEntries(fileStatus, entries);
+            } catch (...) {
+                fileStatus.replay(status);
+                throw;
+            }
+
             Assets::EntityDefinitionList definitions;
             try {
-                auto token = m_tokenizer.peekToken();
-                while (!token.hasType(FgdToken::Eof)) {
-                    parseDefinitionOrInclude(status, definitions);
-                    token = m_tokenizer.peekToken();
-                }
+                resolveEntries(status, fileStatus, entries, definitions);
                 return definitions;
             } catch (...) {
                 VectorUtils::clearAndDelete(definitions);
@@ -191,71 +225,55 @@ namespace TrenchBroom {
             }
         }
 
-        void FgdParser::parseDefinitionOrInclude(ParserStatus& status, Assets::EntityDefinitionList& definitions) {
+        void FgdParser::parseEntries(BufferedParserStatus& status, EntryList& entries) {
+            auto token = m_tokenizer.peekToken();
+            while (!token.hasType(FgdToken::Eof)) {
+                const auto entryCount = entries.size();
+                parseDefinitionOrInclude(status, entries);
+                if (entries.size() > entryCount) {
+                    entries.back().messageEnd = status.messages().size();
+                }
+                token = m_tokenizer.peekToken();
+            }
+
+            openIncludedFiles(entries);
+            parseIncludedFiles(entries);
+        }
+
+        void FgdParser::parseDefinitionOrInclude(ParserStatus& status, EntryList& entries) {
             auto token = expect(status, FgdToken::Eof | FgdToken::Word, m_tokenizer.peekToken());
             if (token.hasType(FgdToken::Eof)) {
                 return;
             }
 
             if (StringUtils::caseInsensitiveEqual(token.data(), "@include")) {
-                const auto includedDefinitions = parseInclude(status);
-                VectorUtils::append(definitions, includedDefinitions);
+                entries.push_back(parseInclude(status));
             } else {
-                auto* definition = parseDefinition(status);
+                parseDefinition(status, entries);
                 status.progress(m_tokenizer.progress());
-                if (definition != nullptr) {
-                    definitions.push_back(definition);
-                }
             }
         }
 
-        Assets::EntityDefinition* FgdParser::parseDefinition(ParserStatus& status) {
+        void FgdParser::parseDefinition(ParserStatus& status, EntryList& entries) {
             auto token = expect(status, FgdToken::Word, m_tokenizer.nextToken());
 
             const auto classname = token.data();
             if (StringUtils::caseInsensitiveEqual(classname, "@SolidClass")) {
-                return parseSolidClass(status);
+                entries.push_back(parseClass(status, Entry::Type_SolidClass));
             } else if (StringUtils::caseInsensitiveEqual(classname, "@PointClass")) {
-                return parsePointClass(status);
+                entries.push_back(parseClass(status, Entry::Type_PointClass));
             } else if (StringUtils::caseInsensitiveEqual(classname, "@BaseClass")) {
-                const auto baseClass = parseBaseClass(status);
-                m_baseClasses[baseClass.name()] = baseClass;
-                return nullptr;
+                entries.push_back(parseClass(status, Entry::Type_BaseClass));
             } else if (StringUtils::caseInsensitiveEqual(classname, "@Main")) {
                 skipMainClass(status);
-                return nullptr;
             } else {
                 const auto msg = "Unknown entity definition class '" + classname + "'";
                 status.error(token.line(), token.column(), msg);
                 throw ParserException(token.line(), token.column(), msg);
             }
         }
-        
-        Assets::EntityDefinition* FgdParser::parseSolidClass(ParserStatus& status) {
-            EntityDefinitionClassInfo classInfo = parseClass(status);
-            if (classInfo.hasSize()) {
-                status.warn(classInfo.line(), classInfo.column(), "Solid entity definition must not have a size");
-            }
-            if (classInfo.hasModelDefinition()) {
-                status.warn(classInfo.line(), classInfo.column(), "Solid entity definition must not have model definitions");
-            }
-            return new Assets::BrushEntityDefinition(classInfo.name(), classInfo.color(), classInfo.description(), classInfo.attributeList());
-        }
-        
-        Assets::EntityDefinition* FgdParser::parsePointClass(ParserStatus& status) {
-            const auto classInfo = parseClass(status);
-            return new Assets::PointEntityDefinition(classInfo.name(), classInfo.color(), classInfo.size(), classInfo.description(), classInfo.attributeList(), classInfo.modelDefinition());
-        }
-        
-        EntityDefinitionClassInfo FgdParser::parseBaseClass(ParserStatus& status) {
-            const auto classInfo = parseClass(status);
-            if (m_baseClasses.count(classInfo.name()) > 0) {
-                status.warn(classInfo.line(), classInfo.column(), "Redefinition of base class '" + classInfo.name() + "'");
-            }
-            return classInfo;
-        }
-        
-        EntityDefinitionClassInfo FgdParser::parseClass(ParserStatus& status) {
+
+        FgdParser::Entry FgdParser::parseClass(ParserStatus& status, const Entry::Type type) {
             auto token = expect(status, FgdToken::Word | FgdToken::Equality, m_tokenizer.nextToken());
             
             StringList superClasses;
@@ -303,8 +321,7 @@ namespace TrenchBroom {
             }
             
             classInfo.addAttributeDefinitions(parseProperties(status));
-            classInfo.resolveBaseClasses(m_baseClasses, superClasses);
-            return classInfo;
+            return Entry(type, classInfo, superClasses);
         }
 
         void FgdParser::skipMainClass(ParserStatus& status) {
@@ -655,41 +672,135 @@ namespace TrenchBroom {
             return color;
         }
 
-        Assets::EntityDefinitionList FgdParser::parseInclude(ParserStatus& status) {
+        FgdParser::Entry FgdParser::parseInclude(ParserStatus& status) {
             auto token = expect(status, FgdToken::Word, m_tokenizer.nextToken());
             assert(StringUtils::caseInsensitiveEqual(token.data(), "@include"));
 
             expect(status, FgdToken::String, token = m_tokenizer.nextToken());
-            const auto path = Path(token.data());
-            return handleInclude(status, path);
+            return Entry(std::make_shared<IncludedFile>(m_tokenizer.line(), Path(token.data())));
         }
 
-        Assets::EntityDefinitionList FgdParser::handleInclude(ParserStatus& status, const Path& path) {
-            const auto snapshot = m_tokenizer.snapshot();
-            auto result = Assets::EntityDefinitionList(0);
-            try {
-                status.debug(m_tokenizer.line(), "Parsing included file '" + path.asString() + "'");
-                const auto file = m_fileSystem.openFile(path);
-                const auto filePath = file->path();
-                status.debug(m_tokenizer.line(), "Resolved '" + path.asString() + "' to '" + filePath.asString() + "'");
-
-                if (!isRecursiveInclude(filePath)) {
-                    const PushIncludePath pushIncludePath(this, filePath);
-                    m_tokenizer.replaceState(file->begin(), file->end());
-                    result = doParseDefinitions(status);
-                } else {
+        void FgdParser::openIncludedFiles(EntryList& entries) {
+            for (auto& entry : entries) {
+                if (entry.type != Entry::Type_Include) {
+                    continue;
+                }
+
+                // these messages precede the messages of the included file itself
+                auto& include = *entry.include;
+                auto& status = include.status;
+                try {
+                    status.debug(include.line, "Parsing included file '" + include.path.asString() + "'");
+                    include.searchedPaths = searchPaths(include.path);
+                    auto file = m_fileSystem.openFile(include.path);
+                    const auto filePath = file->path();
+                    status.debug(include.line, "Resolved '" + include.path.asString() + "' to '" + filePath.asString() + "'");
+
+                    if (!isRecursiveInclude(filePath)) {
+                        include.file = file;
+                        include.filePath = filePath;
+                    } else {
+                        auto str = StringStream();
+                        str << "Skipping recursively included file: " << include.path.asString() << " (" << filePath << ")";
+                        status.error(include.line, str.str());
+                    }
+                } catch (const Exception &e) {
                     auto str = StringStream();
-                    str << "Skipping recursively included file: " << path.asString() << " (" << filePath << ")";
-                    status.error(m_tokenizer.line(), str.str());
+                    str << "Failed to parse included file: " << e.what();
+                    status.error(include.line, str.str());
                 }
-            } catch (const Exception &e) {
-                auto str = StringStream();
-                str << "Failed to parse included file: " << e.what();
-                status.error(m_tokenizer.line(), str.str());
             }
+        }
 
-            m_tokenizer.restore(snapshot);
-            return result;
+        void FgdParser::parseIncludedFiles(EntryList& entries) {
+            std::vector<IncludedFile*> includes;
+            for (auto& entry : entries) {
+                if (entry.type == Entry::Type_Include && entry.include->file != nullptr) {
+                    includes.push_back(entry.include.get());
+                }
+            }
+
+            // Each included file is parsed by its own parser which only knows the include chain leading up to it.
+            // Its messages are buffered and passed on when its entries are resolved.
+            ParallelUtils::parallelFor(includes.size(), [&](const size_t i) {
+                auto& include = *includes[i];
+                try {
+                    FgdParser parser(include.file->begin(), include.file->end(), m_defaultEntityColor);
+                    for (const auto& path : m_paths) {
+                        parser.pushIncludePath(path);
+                    }
+                    parser.pushIncludePath(include.filePath);
+                    parser.parseEntries(include.status, include.entries);
+                } catch (const Exception& e) {
+                    include.entries.clear();
+                    include.error = e.what();
+                }
+            });
+        }
+
+        void FgdParser::resolveEntries(ParserStatus& status, const BufferedParserStatus& messages, EntryList& entries, Assets::EntityDefinitionList& definitions) {
+            size_t messageBegin = 0;
+            for (auto& entry : entries) {
+                messages.replay(status, messageBegin, entry.messageEnd);
+                messageBegin = entry.messageEnd;
+
+                switch (entry.type) {
+                    case Entry::Type_BaseClass:
+                        resolveBaseClass(status, entry);
+                        break;
+                    case Entry::Type_PointClass:
+                        definitions.push_back(resolvePointClass(status, entry));
+                        break;
+                    case Entry::Type_SolidClass:
+                        definitions.push_back(resolveSolidClass(status, entry));
+                        break;
+                    case Entry::Type_Include:
+                        resolveInclude(status, *entry.include, definitions);
+                        break;
+                    switchDefault()
+                }
+            }
+            messages.replay(status, messageBegin, messages.messages().size());
+        }
+
+        void FgdParser::resolveBaseClass(ParserStatus& status, Entry& entry) {
+            auto& classInfo = entry.classInfo;
+            classInfo.resolveBaseClasses(m_baseClasses, entry.superClasses);
+            if (m_baseClasses.count(classInfo.name()) > 0) {
+                status.warn(classInfo.line(), classInfo.column(), "Redefinition of base class '" + classInfo.name() + "'");
+            }
+            m_baseClasses[classInfo.name()] = classInfo;
+        }
+
+        Assets::EntityDefinition* FgdParser::resolveSolidClass(ParserStatus& status, Entry& entry) {
+            auto& classInfo = entry.classInfo;
+            classInfo.resolveBaseClasses(m_baseClasses, entry.superClasses);
+            if (classInfo.hasSize()) {
+                status.warn(classInfo.line(), classInfo.column(), "Solid entity definition must not have a size");
+            }
+            if (classInfo.hasModelDefinition()) {
+                status.warn(classInfo.line(), classInfo.column(), "Solid entity definition must not have model definitions");
+            }
+            return new Assets::BrushEntityDefinition(classInfo.name(), classInfo.color(), classInfo.description(), classInfo.attributeList());
+        }
+
+        Assets::EntityDefinition* FgdParser::resolvePointClass(ParserStatus& /* status */, Entry& entry) {
+            auto& classInfo = entry.classInfo;
+            classInfo.resolveBaseClasses(m_baseClasses, entry.superClasses);
+            return new Assets::PointEntityDefinition(classInfo.name(), classInfo.color(), classInfo.size(), classInfo.description(), classInfo.attributeList(), classInfo.modelDefinition());
+        }
+
+        void FgdParser::resolveInclude(ParserStatus& status, IncludedFile& include, Assets::EntityDefinitionList& definitions) {
+            // a file that is missing or cannot be parsed now may be included once it has been created or fixed
+            VectorUtils::append(m_searchedIncludePaths, include.searchedPaths);
+
+            // if the file could not be opened or parsed, it has no entries and all of its messages are passed on
+            resolveEntries(status, include.status, include.entries, definitions);
+            if (!include.error.empty()) {
+                auto str = StringStream();
+                str << "Failed to parse included file: " << include.error;
+                status.error(include.line, str.str());
+            }
         }
     }
 }
@@ -34,9 +34,13 @@
 #include <vecmath/forward.h>
 
 #include <list>
+#include <memory>
+#include <vector>
 
 namespace TrenchBroom {
     namespace IO {
+        class BufferedParserStatus;
+
         namespace FgdToken {
             typedef unsigned int Type;
             static const Type Integer           = 1 <<  0; // integer number
@@ -75,6 +79,37 @@ namespace TrenchBroom {
                 explicit DefaultValue(const T& i_value) : present(true), value(i_value) {}
             };
             
+            struct IncludedFile;
+
+            /**
+             * A class definition or an include directive, in the order in which it appears in the file. Base classes
+             * are resolved only once all included files have been parsed, which allows parsing the included files
+             * in parallel.
+             *
+             * The messages logged while parsing a file are buffered, and every entry records how many of them had
+             * been logged once it was parsed. They are passed on as the entries are resolved, so that they appear in
+             * the same order as if every included file had been parsed at the position of its include directive.
+             */
+            struct Entry {
+                typedef enum {
+                    Type_BaseClass,
+                    Type_PointClass,
+                    Type_SolidClass,
+                    Type_Include
+                } Type;
+
+                Type type;
+                EntityDefinitionClassInfo classInfo;
+                StringList superClasses;
+                std::shared_ptr<IncludedFile> include;
+                size_t messageEnd;
+
+                Entry(Type i_type, const EntityDefinitionClassInfo& i_classInfo, const StringList& i_superClasses);
+                explicit Entry(std::shared_ptr<IncludedFile> i_include);
+            };
+
+            typedef std::vector<Entry> EntryList;
+
             Color m_defaultEntityColor;
 
             std::list<Path> m_paths;
@@ -82,26 +117,32 @@ namespace TrenchBroom {
 
             FgdTokenizer m_tokenizer;
             EntityDefinitionClassInfoMap m_baseClasses;
+
+            Path::List m_searchedIncludePaths;
         public:
             FgdParser(const char* begin, const char* end, const Color& defaultEntityColor, const Path& path = Path(""));
             FgdParser(const String& str, const Color& defaultEntityColor, const Path& path = Path(""));
+
+            /**
+             * Returns the absolute paths at which included files were searched while parsing, in the order in which
+             * they were searched, whether a file existed there or not. The parsed definitions can only change if one
+             * of these files is created, changed or removed. Only valid after the definitions have been parsed.
+             */
+            const Path::List& searchedIncludePaths() const;
         private:
-            class PushIncludePath;
             void pushIncludePath(const Path& path);
-            void popIncludePath();
+            Path::List searchPaths(const Path& path) const;
 
             bool isRecursiveInclude(const Path& path) const;
         private:
             TokenNameMap tokenNames() const override;
             Assets::EntityDefinitionList doParseDefinitions(ParserStatus& status) override;
 
-            void parseDefinitionOrInclude(ParserStatus& status, Assets::EntityDefinitionList& definitions);
+            void parseEntries(BufferedParserStatus& status, EntryList& entries);
+            void parseDefinitionOrInclude(ParserStatus& status, EntryList& entries);
 
-            Assets::EntityDefinition* parseDefinition(ParserStatus& status);
-            Assets::EntityDefinition* parseSolidClass(ParserStatus& status);
-            Assets::EntityDefinition* parsePointClass(ParserStatus& status);
-            EntityDefinitionClassInfo parseBaseClass(ParserStatus& status);
-            EntityDefinitionClassInfo parseClass(ParserStatus& status);
+            void parseDefinition(ParserStatus& status, EntryList& entries);
+            Entry parseClass(ParserStatus& status, Entry::Type type);
             void skipMainClass(ParserStatus& status);
             
             StringList parseSuperClasses(ParserStatus& status);
@@ -128,8 +169,15 @@ namespace TrenchBroom {
             vm::bbox3 parseSize(ParserStatus& status);
             Color parseColor(ParserStatus& status);
 
-            Assets::EntityDefinitionList parseInclude(ParserStatus& status);
-            Assets::EntityDefinitionList handleInclude(ParserStatus& status, const Path& path);
+            Entry parseInclude(ParserStatus& status);
+            void openIncludedFiles(EntryList& entries);
+            void parseIncludedFiles(EntryList& entries);
+
+            void resolveEntries(ParserStatus& status, const BufferedParserStatus& messages, EntryList& entries, Assets::EntityDefinitionList& definitions);
+            void resolveBaseClass(ParserStatus& status, Entry& entry);
+            Assets::EntityDefinition* resolveSolidClass(ParserStatus& status, Entry& entry);
+            Assets::EntityDefinition* resolvePointClass(ParserStatus& status, Entry& entry);
+            void resolveInclude(ParserStatus& status, IncludedFile& include, Assets::EntityDefinitionList& definitions);
         };
     }
 }
@@ -89,6 +89,35 @@ namespace TrenchBroom {
             }
         }
 
+        DirectoryEntryList FileSystem::scanDirectory(const Path& path, const bool recurse) const {
+            try {
+                if (path.isAbsolute())
+                    throw FileSystemException("Path is absolute: '" + path.asString() + "'");
+                if (!directoryExists(path))
+                    throw FileSystemException("Directory not found: '" + path.asString() + "'");
+                return doScanDirectory(path, recurse);
+            } catch (const PathException& e) {
+                throw FileSystemException("Invalid path: '" + path.asString() + "'", e);
+            }
+        }
+
+        bool FileSystem::listFixedContents(Path::List& result) const {
+            return doListFixedContents(result);
+        }
+
+        bool FileSystem::doListFixedContents(Path::List& result) const {
+            return false;
+        }
+
+        DirectoryEntryList FileSystem::doScanDirectory(const Path& path, const bool recurse) const {
+            // file systems are not required to be thread safe, so this lists one directory at a time
+            const DirectoryScanner scanner([this](const Path& directory, DirectoryEntryList& entries) {
+                for (const Path& itemPath : getDirectoryContents(directory))
+                    entries.emplace_back(itemPath, directoryExists(directory + itemPath));
+            }, 1);
+            return scanner.scan(path, recurse);
+        }
+
         WritableFileSystem::WritableFileSystem() {}
 
         /*
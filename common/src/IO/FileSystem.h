@@ -22,6 +22,7 @@
 
 #include "Functor.h"
 #include "StringUtils.h"
+#include "IO/DirectoryScanner.h"
 #include "IO/DiskIO.h"
 #include "IO/MappedFile.h"
 #include "IO/Path.h"
@@ -64,15 +65,33 @@ namespace TrenchBroom {
             
             Path::List getDirectoryContents(const Path& path) const;
             const MappedFile::Ptr openFile(const Path& path) const;
+
+            /**
+             * Lists the entries of the given directory and, if recurse is true, of all of its subdirectories, in the
+             * order described in DirectoryScanner::scan.
+             *
+             * @param path the path of the directory to scan
+             * @param recurse whether to list the entries of subdirectories
+             * @return the listed entries, with paths relative to the given directory
+             */
+            DirectoryEntryList scanDirectory(const Path& path, bool recurse) const;
+
+            /**
+             * Appends the paths of all files in this file system to the given list if the contents of this file system
+             * never change, e.g. because it is backed by an archive. This allows clients to index the contents.
+             *
+             * @param result the list to append the file paths to
+             * @return true if the contents of this file system are fixed and their paths were appended, and false
+             * otherwise
+             */
+            bool listFixedContents(Path::List& result) const;
         private:
             template <class M>
             void doFindItems(const Path& searchPath, const M& matcher, const bool recurse, Path::List& result) const {
-                for (const Path& itemPath : getDirectoryContents(searchPath)) {
-                    const bool directory = directoryExists(searchPath + itemPath);
-                    if (directory && recurse)
-                        doFindItems(searchPath + itemPath, matcher, recurse, result);
-                    if (matcher(searchPath + itemPath, directory))
-                        result.push_back(searchPath + itemPath);
+                for (const DirectoryEntry& entry : scanDirectory(searchPath, recurse)) {
+                    const Path path = searchPath + entry.path;
+                    if (matcher(path, entry.directory))
+                        result.push_back(path);
                 }
             }
 
@@ -83,6 +102,10 @@ namespace TrenchBroom {
             virtual Path::List doGetDirectoryContents(const Path& path) const = 0;
 
             virtual const MappedFile::Ptr doOpenFile(const Path& path) const = 0;
+
+            virtual DirectoryEntryList doScanDirectory(const Path& path, bool recurse) const;
+
+            virtual bool doListFixedContents(Path::List& result) const;
         };
         
         class WritableFileSystem : public virtual FileSystem {
@@ -25,6 +25,8 @@
 #include "IO/FileMatcher.h"
 #include "IO/IdPakFileSystem.h"
 
+#include <cassert>
+
 namespace TrenchBroom {
     namespace IO {
         FileSystemHierarchy::FileSystemHierarchy() {}
@@ -36,16 +38,88 @@ namespace TrenchBroom {
         void FileSystemHierarchy::pushFileSystem(FileSystem* fileSystem) {
             ensure(fileSystem != nullptr, "filesystem is null");
             m_fileSystems.push_back(fileSystem);
+            addToIndex(m_fileSystems.size() - 1);
         }
 
         void FileSystemHierarchy::popFileSystem() {
             ensure(!m_fileSystems.empty(), "filesystem hierarchy is empty");
+            removeFromIndex(m_fileSystems.size() - 1);
             delete m_fileSystems.back();
             m_fileSystems.pop_back();
         }
 
+        size_t FileSystemHierarchy::fileSystemCount() const {
+            return m_fileSystems.size();
+        }
+
         void FileSystemHierarchy::clear() {
             VectorUtils::clearAndDelete(m_fileSystems);
+            m_mountIndices.clear();
+            m_fileIndex.clear();
+            m_directoryIndex.clear();
+        }
+
+        String FileSystemHierarchy::indexKey(const Path& path) {
+            return StringUtils::toLower(path.asString('/'));
+        }
+
+        void FileSystemHierarchy::addToIndex(const size_t index) {
+            assert(index == m_mountIndices.size());
+            m_mountIndices.push_back(MountIndex());
+            auto& mount = m_mountIndices.back();
+
+            Path::List files;
+            mount.indexed = m_fileSystems[index]->listFixedContents(files);
+
+            for (const Path& file : files) {
+                const String key = indexKey(file);
+                mount.files.insert(key);
+
+                // the new file system is on top, so it overrides all others
+                m_fileIndex[key] = index;
+
+                // add the parent directories up to the first one that we have already seen
+                auto directory = file.deleteLastComponent();
+                while (mount.directories.insert(indexKey(directory)).second && !directory.isEmpty()) {
+                    directory = directory.deleteLastComponent();
+                }
+            }
+
+            for (const String& key : mount.directories) {
+                ++m_directoryIndex[key];
+            }
+        }
+
+        void FileSystemHierarchy::removeFromIndex(const size_t index) {
+            assert(index == m_mountIndices.size() - 1);
+            const auto& mount = m_mountIndices.back();
+
+            for (const String& key : mount.files) {
+                auto it = m_fileIndex.find(key);
+                if (it != std::end(m_fileIndex) && it->second == index) {
+                    // hand the file over to the next indexed file system below that contains it, if any
+                    size_t owner = index;
+                    while (owner > 0 && m_mountIndices[owner - 1].files.count(key) == 0) {
+                        --owner;
+                    }
+
+                    if (owner > 0) {
+                        it->second = owner - 1;
+                    } else {
+                        m_fileIndex.erase(it);
+                    }
+                }
+            }
+
+            for (const String& key : mount.directories) {
+                auto it = m_directoryIndex.find(key);
+                assert(it != std::end(m_directoryIndex));
+                if (--it->second == 0) {
+                    m_directoryIndex.erase(it);
+                }
+            }
+
+            m_mountIndices.pop_back();
         }
 
         Path FileSystemHierarchy::doMakeAbsolute(const Path& relPath) const {
@@ -58,9 +132,13 @@ namespace TrenchBroom {
         }
 
         bool FileSystemHierarchy::doDirectoryExists(const Path& path) const {
-            for (auto it = m_fileSystems.rbegin(), end = m_fileSystems.rend(); it != end; ++it) {
-                const auto* fileSystem = *it;
-                if (fileSystem->directoryExists(path)) {
+            if (m_directoryIndex.count(indexKey(path)) > 0) {
+                return true;
+            }
+
+            for (size_t i = m_fileSystems.size(); i > 0; --i) {
+                const auto* fileSystem = m_fileSystems[i - 1];
+                if (!m_mountIndices[i - 1].indexed && fileSystem->directoryExists(path)) {
                     return true;
                 }
             }
@@ -72,13 +150,19 @@ namespace TrenchBroom {
         }
         
         FileSystem* FileSystemHierarchy::findFileSystemContaining(const Path& path) const {
-            for (auto it = m_fileSystems.rbegin(), end = m_fileSystems.rend(); it != end; ++it) {
-                auto* fileSystem = *it;
-                if (fileSystem->fileExists(path)) {
+            // the number of file systems up to and including the topmost indexed one that contains the file
+            const auto it = m_fileIndex.find(indexKey(path));
+            const size_t indexedCount = it != std::end(m_fileIndex) ? it->second + 1 : 0;
+
+            // only file systems above that one which are not indexed can override it
+            for (size_t i = m_fileSystems.size(); i > indexedCount; --i) {
+                auto* fileSystem = m_fileSystems[i - 1];
+                if (!m_mountIndices[i - 1].indexed && fileSystem->fileExists(path)) {
                     return fileSystem;
                 }
             }
-            return nullptr;
+
+            return indexedCount > 0 ? m_fileSystems[indexedCount - 1] : nullptr;
         }
 
         Path::List FileSystemHierarchy::doGetDirectoryContents(const Path& path) const {
@@ -96,6 +180,15 @@ namespace TrenchBroom {
         }
         
         const MappedFile::Ptr FileSystemHierarchy::doOpenFile(const Path& path) const {
+            const auto* owner = findFileSystemContaining(path);
+            if (owner != nullptr) {
+                const auto file = owner->openFile(path);
+                if (file.get() != nullptr) {
+                    return file;
+                }
+            }
+
+            // fall back to the other file systems if the owner could not open the file
             for (auto it = m_fileSystems.rbegin(), end = m_fileSystems.rend(); it != end; ++it) {
                 const FileSystem* fileSystem = *it;
                 if (fileSystem->fileExists(path)) {
@@ -26,24 +26,52 @@
 #include "IO/FileSystem.h"
 #include "IO/Path.h"
 
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace TrenchBroom {
     namespace IO {
         class Path;
         
+        /**
+         * A stack of file systems where the file systems at the top override the ones below them.
+         *
+         * The contents of all file systems with fixed contents, such as archives, are merged into an index that maps
+         * the case folded path of every file to the topmost of these file systems that contains it. The index is
+         * updated when file systems are pushed or popped. The file systems whose contents can change, such as those on
+         * disk, are not indexed and are still searched on every lookup.
+         */
         class FileSystemHierarchy : public virtual FileSystem {
         private:
             typedef std::vector<FileSystem*> FileSystemList;
             FileSystemList m_fileSystems;
+
+            using KeySet = std::unordered_set<String>;
+            struct MountIndex {
+                bool indexed;
+                KeySet files;
+                KeySet directories;
+            };
+
+            std::vector<MountIndex> m_mountIndices;
+            // maps the key of every indexed file to the index of the topmost indexed file system that contains it
+            std::unordered_map<String, size_t> m_fileIndex;
+            // maps the key of every indexed directory to the number of indexed file systems that contain it
+            std::unordered_map<String, size_t> m_directoryIndex;
         public:
             FileSystemHierarchy();
             virtual ~FileSystemHierarchy() override;
             
             void pushFileSystem(FileSystem* fileSystem);
             void popFileSystem();
+            size_t fileSystemCount() const;
             virtual void clear();
         private:
+            static String indexKey(const Path& path);
+            void addToIndex(size_t index);
+            void removeFromIndex(size_t index);
+
             Path doMakeAbsolute(const Path& relPath) const override;
             bool doDirectoryExists(const Path& path) const override;
             bool doFileExists(const Path& path) const override;
@@ -19,11 +19,12 @@
 
 #include "ImageFileSystem.h"
 
-#include "CollectionUtils.h"
 #include "IO/DiskFileSystem.h"
 #include "IO/IOUtils.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 
 namespace TrenchBroom {
     namespace IO {
@@ -40,122 +41,246 @@ namespace TrenchBroom {
             return m_file;
         }
         
-        ImageFileSystem::Directory::Directory(const Path& path) :
-        m_path(path) {}
-        
-        ImageFileSystem::Directory::~Directory() {
-            MapUtils::clearAndDelete(m_directories);
-            MapUtils::clearAndDelete(m_files);
+        const size_t ImageFileSystem::DirectoryTable::NoEntry = static_cast<size_t>(-1);
+
+        bool ImageFileSystem::DirectoryTable::Entry::directory() const {
+            return file == nullptr;
         }
-        
-        void ImageFileSystem::Directory::addFile(const Path& path, MappedFile::Ptr file) {
+
+        ImageFileSystem::DirectoryTable::DirectoryTable() :
+        m_buckets(16, NoEntry) {
+            createEntry(NoEntry, "", hashPath(""), nullptr);
+        }
+
+        ImageFileSystem::DirectoryTable::~DirectoryTable() {
+            for (auto& entry : m_entries) {
+                delete entry.file;
+            }
+        }
+
+        void ImageFileSystem::DirectoryTable::addFile(const Path& path, MappedFile::Ptr file) {
             addFile(path, new SimpleFile(file));
         }
 
-        void ImageFileSystem::Directory::addFile(const Path& path, File* file) {
+        void ImageFileSystem::DirectoryTable::addFile(const Path& path, File* file) {
             ensure(file != nullptr, "file is null");
-            const auto filename = path.lastComponent();
-            if (path.length() == 1) {
+            ensure(!path.isEmpty(), "path is empty");
+
+            const auto components = path.components();
+            const auto hash = hashPath(components);
+            const auto existing = findEntry(components, hash, false);
+            if (existing != NoEntry) {
                 // silently overwrite duplicates, the latest entries win
-                MapUtils::insertOrReplaceAndDelete(m_files, filename, file);
+                delete m_entries[existing].file;
+                m_entries[existing].file = file;
+                return;
+            }
+
+            const auto separator = components.rfind('/');
+            if (separator == std::string_view::npos) {
+                createEntry(0, components, hash, file);
             } else {
-                auto& dir = findOrCreateDirectory(path.deleteLastComponent());
-                dir.addFile(filename, file);
+                const auto parent = findOrCreateDirectory(components.substr(0, separator));
+                createEntry(parent, components.substr(separator + 1), hash, file);
             }
         }
-        
-        bool ImageFileSystem::Directory::directoryExists(const Path& path) const {
-            if (path.isEmpty()) {
-                return true;
+
+        bool ImageFileSystem::DirectoryTable::directoryExists(const Path& path) const {
+            return findEntry(path.components(), true) != NoEntry;
+        }
+
+        bool ImageFileSystem::DirectoryTable::fileExists(const Path& path) const {
+            return findEntry(path.components(), false) != NoEntry;
+        }
+
+        Path::List ImageFileSystem::DirectoryTable::directoryContents(const Path& path) const {
+            const auto children = sortedChildren(path);
+
+            Path::List result;
+            result.reserve(children.size());
+            for (const auto* child : children) {
+                result.push_back(entryName(*child));
             }
+            return result;
+        }
 
-            auto it = m_directories.find(path.firstComponent());
-            if (it == std::end(m_directories)) {
-                return false;
-            } else {
-                return it->second->directoryExists(path.deleteFirstComponent());
+        void ImageFileSystem::DirectoryTable::listDirectory(const Path& path, DirectoryEntryList& entries) const {
+            for (const auto* child : sortedChildren(path)) {
+                entries.emplace_back(entryName(*child), child->directory());
             }
         }
-        
-        bool ImageFileSystem::Directory::fileExists(const Path& path) const {
-            if (path.length() == 1) {
-                return m_files.count(path) > 0;
+
+        std::vector<const ImageFileSystem::DirectoryTable::Entry*> ImageFileSystem::DirectoryTable::sortedChildren(const Path& path) const {
+            const auto index = findEntry(path.components(), true);
+            if (index == NoEntry) {
+                throw FileSystemException("Path does not exist: '" + path.asString() + "'");
             }
 
-            auto it = m_directories.find(path.firstComponent());
-            if (it == std::end(m_directories)) {
-                return false;
-            } else {
-                return it->second->fileExists(path.deleteFirstComponent());
+            std::vector<const Entry*> children;
+            for (auto child = m_entries[index].firstChild; child != NoEntry; child = m_entries[child].nextSibling) {
+                children.push_back(&m_entries[child]);
             }
+
+            std::sort(std::begin(children), std::end(children), [&](const Entry* lhs, const Entry* rhs) {
+                if (lhs->directory() != rhs->directory()) {
+                    return lhs->directory();
+                }
+                const auto lhsName = name(*lhs);
+                const auto rhsName = name(*rhs);
+                return std::lexicographical_compare(std::begin(lhsName), std::end(lhsName), std::begin(rhsName), std::end(rhsName),
+                                                    [](const char l, const char r) {
+                                                        return std::tolower(static_cast<unsigned char>(l)) < std::tolower(static_cast<unsigned char>(r));
+                                                    });
+            });
+            return children;
         }
-        
-        const ImageFileSystem::Directory& ImageFileSystem::Directory::findDirectory(const Path& path) const {
-            if (path.isEmpty()) {
-                return *this;
+
+        const MappedFile::Ptr ImageFileSystem::DirectoryTable::findFile(const Path& path) const {
+            assert(!path.isEmpty());
+
+            const auto index = findEntry(path.components(), false);
+            if (index == NoEntry) {
+                throw FileSystemException("File not found: '" + path.asString() + "'");
             }
+            return m_entries[index].file->open();
+        }
 
-            auto it = m_directories.find(path.firstComponent());
-            if (it == std::end(m_directories)) {
-                throw FileSystemException("Path does not exist: '" + (m_path + path).asString() + "'");
-            } else {
-                return it->second->findDirectory(path.deleteFirstComponent());
+        void ImageFileSystem::DirectoryTable::collectFiles(Path::List& result) const {
+            for (const auto& entry : m_entries) {
+                if (!entry.directory()) {
+                    result.push_back(entryPath(entry));
+                }
             }
         }
-        
-        const MappedFile::Ptr ImageFileSystem::Directory::findFile(const Path& path) const {
-            assert(!path.isEmpty());
-            
-            const auto name = path.firstComponent();
-            if (path.length() == 1) {
-                auto it = m_files.find(name);
-                if (it == std::end(m_files)) {
-                    throw FileSystemException("File not found: '" + (m_path + path).asString() + "'");
-                } else {
-                    return it->second->open();
+
+        size_t ImageFileSystem::DirectoryTable::findEntry(const std::string_view path, const bool directory) const {
+            return findEntry(path, hashPath(path), directory);
+        }
+
+        size_t ImageFileSystem::DirectoryTable::findEntry(const std::string_view path, const uint64_t hash, const bool directory) const {
+            const auto mask = m_buckets.size() - 1;
+            for (auto bucket = static_cast<size_t>(hash) & mask; m_buckets[bucket] != NoEntry; bucket = (bucket + 1) & mask) {
+                const auto& entry = m_entries[m_buckets[bucket]];
+                if (entry.hash == hash && entry.directory() == directory && matches(entry, path)) {
+                    return m_buckets[bucket];
                 }
-            } else {
-                auto it = m_directories.find(name);
-                if (it == std::end(m_directories)) {
-                    throw FileSystemException("File not found: '" + (m_path + path).asString() + "'");
-                } else {
-                    return it->second->findFile(path.deleteFirstComponent());
+            }
+            return NoEntry;
+        }
+
+        size_t ImageFileSystem::DirectoryTable::findOrCreateDirectory(const std::string_view path) {
+            // walk the ancestors of the given path from the top, creating those that do not exist yet
+            auto parent = size_t(0);
+            auto hash = hashPath("");
+            size_t begin = 0;
+            while (true) {
+                auto end = path.find('/', begin);
+                if (end == std::string_view::npos) {
+                    end = path.size();
+                }
+
+                // extend the hash of the parent by the separator and the name of this directory
+                hash = hashPath(hash, path.substr(begin == 0 ? 0 : begin - 1, end - (begin == 0 ? 0 : begin - 1)));
+
+                const auto found = findEntry(path.substr(0, end), hash, true);
+                parent = found != NoEntry ? found : createEntry(parent, path.substr(begin, end - begin), hash, nullptr);
+                if (end == path.size()) {
+                    return parent;
                 }
+                begin = end + 1;
             }
         }
-        
-        Path::List ImageFileSystem::Directory::contents() const {
-            Path::List contents;
-            
-            for (const auto& entry : m_directories) {
-                contents.push_back(Path(entry.first));
+
+        size_t ImageFileSystem::DirectoryTable::createEntry(const size_t parent, const std::string_view name, const uint64_t hash, File* file) {
+            const auto index = m_entries.size();
+
+            Entry entry;
+            entry.pathOffset = m_strings.size();
+            if (parent != NoEntry && m_entries[parent].pathLength > 0) {
+                const auto& parentEntry = m_entries[parent];
+                m_strings.append(m_strings, parentEntry.pathOffset, parentEntry.pathLength);
+                m_strings.push_back('/');
             }
+            entry.nameOffset = m_strings.size();
+            m_strings.append(name);
+            entry.pathLength = m_strings.size() - entry.pathOffset;
+            entry.hash = hash;
+            entry.firstChild = NoEntry;
+            entry.nextSibling = NoEntry;
+            entry.file = file;
 
-            for (const auto& entry : m_files) {
-                contents.push_back(Path(entry.first));
+            if (parent != NoEntry) {
+                entry.nextSibling = m_entries[parent].firstChild;
+                m_entries[parent].firstChild = index;
             }
+            m_entries.push_back(entry);
 
-            return contents;
+            if (2 * m_entries.size() > m_buckets.size()) {
+                rehash(2 * m_buckets.size());
+            } else {
+                insertIntoBuckets(index);
+            }
+            return index;
         }
-        
-        ImageFileSystem::Directory& ImageFileSystem::Directory::findOrCreateDirectory(const Path& path) {
-            if (path.isEmpty()) {
-                return *this;
+
+        void ImageFileSystem::DirectoryTable::insertIntoBuckets(const size_t index) {
+            const auto mask = m_buckets.size() - 1;
+            auto bucket = static_cast<size_t>(m_entries[index].hash) & mask;
+            while (m_buckets[bucket] != NoEntry) {
+                bucket = (bucket + 1) & mask;
             }
+            m_buckets[bucket] = index;
+        }
 
-            const auto name = path.firstComponent();
-            auto it = m_directories.lower_bound(name);
-            if (it == std::end(m_directories) || name != it->first) {
-                it = m_directories.insert(it, std::make_pair(name, new Directory(m_path + Path(name))));
+        void ImageFileSystem::DirectoryTable::rehash(const size_t bucketCount) {
+            m_buckets.assign(bucketCount, NoEntry);
+            for (size_t i = 0; i < m_entries.size(); ++i) {
+                insertIntoBuckets(i);
             }
-            return it->second->findOrCreateDirectory(path.deleteFirstComponent());
         }
-        
+
+        bool ImageFileSystem::DirectoryTable::matches(const Entry& entry, const std::string_view path) const {
+            if (entry.pathLength != path.size()) {
+                return false;
+            }
+
+            const auto* cur = m_strings.data() + entry.pathOffset;
+            for (const auto c : path) {
+                if (std::tolower(static_cast<unsigned char>(*cur++)) != std::tolower(static_cast<unsigned char>(c))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Path ImageFileSystem::DirectoryTable::entryPath(const Entry& entry) const {
+            return Path(m_strings.substr(entry.pathOffset, entry.pathLength));
+        }
+
+        Path ImageFileSystem::DirectoryTable::entryName(const Entry& entry) const {
+            return Path(String(name(entry)));
+        }
+
+        std::string_view ImageFileSystem::DirectoryTable::name(const Entry& entry) const {
+            return std::string_view(m_strings.data() + entry.nameOffset, entry.pathOffset + entry.pathLength - entry.nameOffset);
+        }
+
+        uint64_t ImageFileSystem::DirectoryTable::hashPath(const std::string_view path) {
+            return hashPath(14695981039346656037ull, path);
+        }
+
+        uint64_t ImageFileSystem::DirectoryTable::hashPath(uint64_t hash, const std::string_view path) {
+            // FNV-1a over the case folded path
+            static const uint64_t Prime = 1099511628211ull;
+            for (const auto c : path) {
+                hash = (hash ^ static_cast<uint64_t>(std::tolower(static_cast<unsigned char>(c)))) * Prime;
+            }
+            return hash;
+        }
+
         ImageFileSystem::ImageFileSystem(const Path& path, MappedFile::Ptr file) :
         m_path(path),
-        m_file(file),
-        m_root(Path("")) {}
-        
+        m_file(file) {}
         
         ImageFileSystem::~ImageFileSystem() = default;
 
@@ -168,24 +293,32 @@ namespace TrenchBroom {
         }
         
         bool ImageFileSystem::doDirectoryExists(const Path& path) const {
-            const auto searchPath = path.makeLowerCase();
-            return m_root.directoryExists(searchPath);
+            return m_directoryTable.directoryExists(path);
         }
         
         bool ImageFileSystem::doFileExists(const Path& path) const {
-            const auto searchPath = path.makeLowerCase();
-            return m_root.fileExists(searchPath);
+            return m_directoryTable.fileExists(path);
         }
         
         Path::List ImageFileSystem::doGetDirectoryContents(const Path& path) const {
-            const auto searchPath = path.makeLowerCase();
-            const auto& directory = m_root.findDirectory(path);
-            return directory.contents();
+            return m_directoryTable.directoryContents(path);
         }
         
         const MappedFile::Ptr ImageFileSystem::doOpenFile(const Path& path) const {
-            const auto searchPath = path.makeLowerCase();
-            return m_root.findFile(path);
+            return m_directoryTable.findFile(path);
+        }
+
+        bool ImageFileSystem::doListFixedContents(Path::List& result) const {
+            m_directoryTable.collectFiles(result);
+            return true;
+        }
+
+        DirectoryEntryList ImageFileSystem::doScanDirectory(const Path& path, const bool recurse) const {
+            // the directory table is in memory, so there is nothing to gain from listing it on several threads
+            const DirectoryScanner scanner([this](const Path& directory, DirectoryEntryList& entries) {
+                m_directoryTable.listDirectory(directory, entries);
+            }, 1);
+            return scanner.scan(path, recurse);
         }
     }
 }
@@ -24,7 +24,9 @@
 #include "IO/FileSystem.h"
 #include "IO/Path.h"
 
-#include <map>
+#include <cstdint>
+#include <string_view>
+#include <vector>
 
 namespace TrenchBroom {
     namespace IO {
@@ -48,34 +50,88 @@ namespace TrenchBroom {
                 MappedFile::Ptr doOpen() override;
             };
             
-            class Directory {
+            /**
+             * A flat table of the files and directories contained in an image file system. All entries are stored
+             * in a single vector and refer to their names by offsets into a shared string arena. Entries are
+             * indexed by a hash of their case-folded path, so that lookups hash the components of the given path
+             * directly and do not allocate.
+             */
+            class DirectoryTable {
             private:
-                typedef std::map<Path, Directory*, Path::Less<StringUtils::CaseInsensitiveStringLess>> DirMap;
-                typedef std::map<Path, File*,      Path::Less<StringUtils::CaseInsensitiveStringLess>> FileMap;
-                
-                Path m_path;
-                DirMap m_directories;
-                FileMap m_files;
+                static const size_t NoEntry;
+
+                struct Entry {
+                    size_t pathOffset;
+                    size_t pathLength;
+                    size_t nameOffset;
+                    uint64_t hash;
+                    size_t firstChild;
+                    size_t nextSibling;
+                    File* file;
+
+                    bool directory() const;
+                };
+
+                String m_strings;
+                std::vector<Entry> m_entries;
+                std::vector<size_t> m_buckets;
             public:
-                Directory(const Path& path);
-                ~Directory();
-                
+                DirectoryTable();
+                ~DirectoryTable();
+
+                DirectoryTable(const DirectoryTable& other) = delete;
+                DirectoryTable& operator=(const DirectoryTable& other) = delete;
+
                 void addFile(const Path& path, MappedFile::Ptr file);
                 void addFile(const Path& path, File* file);
-                
+
                 bool directoryExists(const Path& path) const;
                 bool fileExists(const Path& path) const;
-                
-                const Directory& findDirectory(const Path& path) const;
+
+                /**
+                 * Returns the contents of the directory with the given path, directories first, each group sorted
+                 * case insensitively.
+                 *
+                 * @param path the path of the directory
+                 * @return the names of the directory's children
+                 *
+                 * @throws FileSystemException if no directory with the given path exists
+                 */
+                Path::List directoryContents(const Path& path) const;
+
+                /**
+                 * Appends the entries of the directory with the given path to the given list, in the same order as
+                 * directoryContents.
+                 *
+                 * @param path the path of the directory
+                 * @param entries the list to append the names and types of the directory's children to
+                 *
+                 * @throws FileSystemException if no directory with the given path exists
+                 */
+                void listDirectory(const Path& path, DirectoryEntryList& entries) const;
                 const MappedFile::Ptr findFile(const Path& path) const;
-                Path::List contents() const;
+                void collectFiles(Path::List& result) const;
             private:
-                Directory& findOrCreateDirectory(const Path& path);
+                size_t findEntry(std::string_view path, bool directory) const;
+                size_t findEntry(std::string_view path, uint64_t hash, bool directory) const;
+                size_t findOrCreateDirectory(std::string_view path);
+                size_t createEntry(size_t parent, std::string_view name, uint64_t hash, File* file);
+                void insertIntoBuckets(size_t index);
+                void rehash(size_t bucketCount);
+                bool matches(const Entry& entry, std::string_view path) const;
+
+                Path entryPath(const Entry& entry) const;
+                Path entryName(const Entry& entry) const;
+                std::string_view name(const Entry& entry) const;
+                std::vector<const Entry*> sortedChildren(const Path& path) const;
+
+                static uint64_t hashPath(std::string_view path);
+                static uint64_t hashPath(uint64_t hash, std::string_view path);
             };
         protected:
             Path m_path;
             MappedFile::Ptr m_file;
-            Directory m_root;
+            DirectoryTable m_directoryTable;
         protected:
             ImageFileSystem(const Path& path, MappedFile::Ptr file);
         public:
@@ -89,6 +145,8 @@ namespace TrenchBroom {
             
             Path::List doGetDirectoryContents(const Path& path) const override;
             const MappedFile::Ptr doOpenFile(const Path& path) const override;
+            bool doListFixedContents(Path::List& result) const override;
+            DirectoryEntryList doScanDirectory(const Path& path, bool recurse) const override;
         private:
             virtual void doReadDirectory() = 0;
         };
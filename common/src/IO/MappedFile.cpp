@@ -227,6 +227,11 @@ namespace TrenchBroom {
                 m_address = static_cast<char*>(mmap(nullptr, m_size, prot, MAP_FILE | MAP_PRIVATE, m_filedesc, 0));
                 if (m_address != nullptr) {
                     init(m_address, m_address + m_size);
+
+                    // The mapping remains valid without the descriptor. Entity models keep their files mapped while
+                    // they are loaded, so holding on to the descriptors could exhaust the process limit.
+                    close(m_filedesc);
+                    m_filedesc = -1;
                 } else {
                     close(m_filedesc);
                     m_filedesc = -1;
@@ -33,6 +33,8 @@
 #include "Renderer/Vertex.h"
 #include "Renderer/VertexSpec.h"
 
+#include <memory>
+
 namespace TrenchBroom {
     namespace IO {
         const vm::vec3f Md2Parser::Normals[162] = {
@@ -221,13 +223,26 @@ namespace TrenchBroom {
         vertexCount(static_cast<size_t>(i_vertexCount < 0 ? -i_vertexCount : i_vertexCount)),
         vertices(vertexCount) {}
 
-        Md2Parser::Md2Parser(const String& name, const char* begin, const char* end, const Assets::Palette& palette, const FileSystem& fs) :
+        Md2Parser::Md2Parser(const String& name, MappedFile::Ptr file, const Assets::Palette& palette, const FileSystem& fs) :
         m_name(name),
-        m_begin(begin),
-        /* m_end(end), */
+        m_file(file),
+        m_begin(m_file->begin()),
+        m_end(m_file->end()),
         m_palette(palette),
         m_fs(fs) {}
         
+        const Md2Parser::FrameDataPtr& Md2Parser::frameData() const {
+            return m_frameData;
+        }
+
+        size_t Md2Parser::minFrameSize(const size_t frameVertexCount) {
+            return 2 * 3 * sizeof(float) + Md2Layout::FrameNameLength + frameVertexCount * sizeof(Md2Vertex);
+        }
+
+        Assets::Md2Model::Frame* Md2Parser::decodeFrame(const FrameData& data, const size_t frameIndex) {
+            return buildFrame(parseFrame(data, frameIndex), data.meshes);
+        }
+
         // http://tfc.duke.free.fr/old/models/md2.htm
         Assets::EntityModel* Md2Parser::doParseModel() {
             const char* cursor = m_begin;
@@ -241,7 +256,7 @@ namespace TrenchBroom {
             
             /*const size_t skinWidth =*/ readSize<int32_t>(cursor);
             /*const size_t skinHeight =*/ readSize<int32_t>(cursor);
-            /*const size_t frameSize =*/ readSize<int32_t>(cursor);
+            const size_t frameSize = readSize<int32_t>(cursor);
             
             const size_t skinCount = readSize<int32_t>(cursor);
             const size_t frameVertexCount = readSize<int32_t>(cursor);
@@ -256,11 +271,29 @@ namespace TrenchBroom {
             const size_t frameOffset = readSize<int32_t>(cursor);
             const size_t commandOffset = readSize<int32_t>(cursor);
 
+            const size_t fileSize = static_cast<size_t>(m_end - m_begin);
+            // compare the counts against the file size by division so that corrupt values cannot overflow
+            if (frameVertexCount > fileSize / sizeof(Md2Vertex) ||
+                frameSize < minFrameSize(frameVertexCount) ||
+                frameOffset > fileSize ||
+                frameCount > (fileSize - frameOffset) / frameSize) {
+                throw AssetException() << "Invalid MD2 frames in model '" << m_name << "'";
+            }
+
+            // the frames are only indexed here and decoded when the model requests them
+            auto frameData = std::make_shared<FrameData>();
+            frameData->file = m_file;
+            frameData->frameOffset = frameOffset;
+            frameData->frameSize = frameSize;
+            frameData->frameVertexCount = frameVertexCount;
+            frameData->meshes = parseMeshes(m_begin + commandOffset, commandCount);
+
             const Md2SkinList skins = parseSkins(m_begin + skinOffset, skinCount);
-            const Md2FrameList frames = parseFrames(m_begin + frameOffset, frameCount, frameVertexCount);
-            const Md2MeshList meshes = parseMeshes(m_begin + commandOffset, commandCount);
-            
-            return buildModel(skins, frames, meshes);
+            const Assets::TextureList textures = loadTextures(skins);
+            m_frameData = frameData;
+            return new Assets::Md2Model(m_name, textures, frameCount, [frameData](const size_t frameIndex) {
+                return decodeFrame(*frameData, frameIndex);
+            });
         }
 
         Md2Parser::Md2SkinList Md2Parser::parseSkins(const char* begin, const size_t skinCount) {
@@ -269,20 +302,6 @@ namespace TrenchBroom {
             return skins;
         }
 
-        Md2Parser::Md2FrameList Md2Parser::parseFrames(const char* begin, const size_t frameCount, const size_t frameVertexCount) {
-            Md2FrameList frames(frameCount, Md2Frame(frameVertexCount));
-
-            const char* cursor = begin;
-            for (size_t i = 0; i < frameCount; ++i) {
-                frames[i].scale = readVec3f(cursor);
-                frames[i].offset = readVec3f(cursor);
-                readBytes(cursor, frames[i].name, Md2Layout::FrameNameLength);
-                readVector(cursor, frames[i].vertices);
-            }
-            
-            return frames;
-        }
-
         Md2Parser::Md2MeshList Md2Parser::parseMeshes(const char* begin, const size_t commandCount) {
             Md2MeshList meshes;
             
@@ -303,12 +322,6 @@ namespace TrenchBroom {
             return meshes;
         }
 
-        Assets::EntityModel* Md2Parser::buildModel(const Md2SkinList& skins, const Md2FrameList& frames, const Md2MeshList& meshes) {
-            const Assets::TextureList modelTextures = loadTextures(skins);
-            const Assets::Md2Model::FrameList modelFrames = buildFrames(frames, meshes);
-            return new Assets::Md2Model(m_name, modelTextures, modelFrames);
-        }
-
         Assets::TextureList Md2Parser::loadTextures(const Md2SkinList& skins) {
             Assets::TextureList textures;
             textures.reserve(skins.size());
@@ -337,13 +350,16 @@ namespace TrenchBroom {
             return new Assets::Texture(skin.name, image.width(), image.height(), avgColor, rgbaImage, GL_RGBA, Assets::TextureType::Opaque);
         }
 
-        Assets::Md2Model::FrameList Md2Parser::buildFrames(const Md2FrameList& frames, const Md2MeshList& meshes) {
-            Assets::Md2Model::FrameList modelFrames;
-            modelFrames.reserve(frames.size());
+        Md2Parser::Md2Frame Md2Parser::parseFrame(const FrameData& data, const size_t frameIndex) {
+            Md2Frame frame(data.frameVertexCount);
+
+            const char* cursor = data.file->begin() + data.frameOffset + frameIndex * data.frameSize;
+            frame.scale = readVec3f(cursor);
+            frame.offset = readVec3f(cursor);
+            readBytes(cursor, frame.name, Md2Layout::FrameNameLength);
+            readVector(cursor, frame.vertices);
             
-            for (const Md2Frame& frame : frames)
-                modelFrames.push_back(buildFrame(frame, meshes));
-            return modelFrames;
+            return frame;
         }
 
         Assets::Md2Model::Frame* Md2Parser::buildFrame(const Md2Frame& frame, const Md2MeshList& meshes) {
@@ -372,7 +388,7 @@ namespace TrenchBroom {
             return new Assets::Md2Model::Frame(builder.vertices(), builder.indexArray());
         }
         
-        Assets::Md2Model::VertexList Md2Parser::getVertices(const Md2Frame& frame, const Md2MeshVertexList& meshVertices) const {
+        Assets::Md2Model::VertexList Md2Parser::getVertices(const Md2Frame& frame, const Md2MeshVertexList& meshVertices) {
             typedef Assets::Md2Model::Vertex Vertex;
 
             Vertex::List result(0);
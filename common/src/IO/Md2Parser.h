@@ -24,9 +24,11 @@
 #include "Assets/AssetTypes.h"
 #include "Assets/Md2Model.h"
 #include "IO/EntityModelParser.h"
+#include "IO/MappedFile.h"
 
 #include <vecmath/vec.h>
 
+#include <memory>
 #include <vector>
 
 namespace TrenchBroom {
@@ -48,6 +50,39 @@ namespace TrenchBroom {
 
         // see http://tfc.duke.free.fr/coding/md2-specs-en.html
         class Md2Parser : public EntityModelParser {
+        public:
+            struct Md2MeshVertex {
+                vm::vec2f texCoords;
+                size_t vertexIndex;
+            };
+            using Md2MeshVertexList = std::vector<Md2MeshVertex>;
+            
+            struct Md2Mesh {
+                enum Type {
+                    Fan,
+                    Strip
+                };
+                
+                Type type;
+                size_t vertexCount;
+                Md2MeshVertexList vertices;
+                
+                explicit Md2Mesh(int i_vertexCount);
+            };
+            using Md2MeshList =  std::vector<Md2Mesh>;
+
+            /**
+             * Everything that is needed to decode the frames of a model after it has been parsed. Keeps the file
+             * that contains the frames mapped for as long as the model exists.
+             */
+            struct FrameData {
+                MappedFile::Ptr file;
+                size_t frameOffset;
+                size_t frameSize;
+                size_t frameVertexCount;
+                Md2MeshList meshes;
+            };
+            using FrameDataPtr = std::shared_ptr<const FrameData>;
         private:
             static const vm::vec3f Normals[162];
 
@@ -72,47 +107,41 @@ namespace TrenchBroom {
                 vm::vec3f vertex(size_t index) const;
                 const vm::vec3f& normal(size_t index) const;
             };
-            using Md2FrameList = std::vector<Md2Frame>;
 
-            struct Md2MeshVertex {
-                vm::vec2f texCoords;
-                size_t vertexIndex;
-            };
-            using Md2MeshVertexList = std::vector<Md2MeshVertex>;
-            
-            struct Md2Mesh {
-                enum Type {
-                    Fan,
-                    Strip
-                };
-                
-                Type type;
-                size_t vertexCount;
-                Md2MeshVertexList vertices;
-                
-                explicit Md2Mesh(int i_vertexCount);
-            };
-            using Md2MeshList =  std::vector<Md2Mesh>;
-            
-            
             String m_name;
+            MappedFile::Ptr m_file;
             const char* m_begin;
-            /* const char* m_end; */
+            const char* m_end;
             const Assets::Palette& m_palette;
             const FileSystem& m_fs;
+            FrameDataPtr m_frameData;
         public:
-            Md2Parser(const String& name, const char* begin, const char* end, const Assets::Palette& palette, const FileSystem& fs);
+            Md2Parser(const String& name, MappedFile::Ptr file, const Assets::Palette& palette, const FileSystem& fs);
+
+            /**
+             * Returns the frame data of the most recently parsed model, or null if no model has been parsed yet.
+             */
+            const FrameDataPtr& frameData() const;
+
+            /**
+             * Returns the minimum number of bytes that a single frame with the given number of vertices occupies in
+             * a model file.
+             */
+            static size_t minFrameSize(size_t frameVertexCount);
+
+            /**
+             * Decodes the frame with the given index.
+             */
+            static Assets::Md2Model::Frame* decodeFrame(const FrameData& data, size_t frameIndex);
         private:
             Assets::EntityModel* doParseModel() override;
             Md2SkinList parseSkins(const char* begin, size_t skinCount);
-            Md2FrameList parseFrames(const char* begin, size_t frameCount, size_t frameVertexCount);
             Md2MeshList parseMeshes(const char* begin, size_t commandCount);
-            Assets::EntityModel* buildModel(const Md2SkinList& skins, const Md2FrameList& frames, const Md2MeshList& meshes);
             Assets::TextureList loadTextures(const Md2SkinList& skins);
             Assets::Texture* readTexture(const Md2Skin& skin);
-            Assets::Md2Model::FrameList buildFrames(const Md2FrameList& frames, const Md2MeshList& meshes);
-            Assets::Md2Model::Frame* buildFrame(const Md2Frame& frame, const Md2MeshList& meshes);
-            Assets::Md2Model::VertexList getVertices(const Md2Frame& frame, const Md2MeshVertexList& meshVertices) const;
+            static Md2Frame parseFrame(const FrameData& data, size_t frameIndex);
+            static Assets::Md2Model::Frame* buildFrame(const Md2Frame& frame, const Md2MeshList& meshes);
+            static Assets::Md2Model::VertexList getVertices(const Md2Frame& frame, const Md2MeshVertexList& meshVertices);
         };
     }
 }
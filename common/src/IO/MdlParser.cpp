@@ -20,6 +20,7 @@
 #include "MdlParser.h"
 
 #include "CollectionUtils.h"
+#include "Exceptions.h"
 #include "Macros.h"
 #include "Assets/Texture.h"
 #include "Assets/MdlModel.h"
@@ -27,17 +28,19 @@
 #include "IO/IOUtils.h"
 
 #include <cassert>
+#include <memory>
 
 namespace TrenchBroom {
     namespace IO {
         namespace MdlLayout {
-            static const unsigned int HeaderScale       = 0x8;
-            static const unsigned int HeaderNumSkins    = 0x30;
-            static const unsigned int Skins             = 0x54;
-            static const unsigned int SimpleFrameName   = 0x8;
-            static const unsigned int SimpleFrameLength = 0x10;
-            static const unsigned int MultiFrameTimes   = 0xC;
-            // static const unsigned int FrameVertexSize   = 0x4;
+            static const unsigned int HeaderScale         = 0x8;
+            static const unsigned int HeaderNumSkins      = 0x30;
+            static const unsigned int Skins               = 0x54;
+            static const unsigned int SimpleFrameName     = 0x8;
+            static const unsigned int SimpleFrameLength   = 0x10;
+            static const unsigned int SimpleFrameVertices = 0x18;
+            static const unsigned int MultiFrameTimes     = 0xC;
+            static const unsigned int FrameVertexSize     = 0x4;
         }
 
         const vm::vec3f MdlParser::Normals[] = {
@@ -207,18 +210,24 @@ namespace TrenchBroom {
 
         static const int MF_HOLEY = (1 << 14);
         
-        MdlParser::MdlParser(const String& name, const char* begin, const char* end, const Assets::Palette& palette) :
+        MdlParser::MdlParser(const String& name, MappedFile::Ptr file, const Assets::Palette& palette) :
         m_name(name),
-        m_begin(begin),
-        m_end(end),
+        m_file(file),
+        m_begin(m_file->begin()),
+        m_end(m_file->end()),
         m_palette(palette) {
             assert(m_begin < m_end);
-            unused(m_end);
+        }
+
+        const MdlParser::FrameDataPtr& MdlParser::frameData() const {
+            return m_frameData;
+        }
+
+        size_t MdlParser::frameSize(const FrameData& data) {
+            return MdlLayout::SimpleFrameVertices + data.skinVertices.size() * MdlLayout::FrameVertexSize;
         }
 
         Assets::EntityModel* MdlParser::doParseModel() {
-            auto* model = new Assets::MdlModel(m_name);
-            
             const char* cursor = m_begin + MdlLayout::HeaderScale;
             const vm::vec3f scale = readVec3f(cursor);
             const vm::vec3f origin = readVec3f(cursor);
@@ -232,14 +241,27 @@ namespace TrenchBroom {
             const size_t frameCount = readSize<int32_t>(cursor);
             /* const size_t syncType = */ readSize<int32_t>(cursor);
             const int flags = readInt<int32_t>(cursor);
+
+            // the frames are only indexed here and decoded when the model requests them
+            auto frameData = std::make_shared<FrameData>();
+            std::unique_ptr<Assets::MdlModel> model(new Assets::MdlModel(m_name, frameCount, [frameData](const size_t frameIndex) {
+                return parseFrame(*frameData, frameIndex);
+            }));
             
             parseSkins(cursor, *model, skinCount, skinWidth, skinHeight, flags);
-            const MdlSkinVertexList skinVertices = parseSkinVertices(cursor, skinVertexCount);
-            const MdlSkinTriangleList skinTriangles = parseSkinTriangles(cursor, skinTriangleCount);
-            parseFrames(cursor, *model, frameCount, skinTriangles, skinVertices, skinWidth, skinHeight, origin, scale);
+
+            frameData->file = m_file;
+            frameData->skinVertices = parseSkinVertices(cursor, skinVertexCount);
+            frameData->skinTriangles = parseSkinTriangles(cursor, skinTriangleCount);
+            frameData->skinWidth = skinWidth;
+            frameData->skinHeight = skinHeight;
+            frameData->origin = origin;
+            frameData->scale = scale;
+            frameData->frameOffsets = parseFrameOffsets(cursor, frameCount, skinVertexCount);
+            m_frameData = frameData;
 
             assert(cursor <= m_end);
-            return model;
+            return model.release();
         }
 
         void MdlParser::parseSkins(const char*& cursor, Assets::MdlModel& model, const size_t count, const size_t width, const size_t height, const int flags) {
@@ -312,33 +334,59 @@ namespace TrenchBroom {
             return triangles;
         }
 
-        void MdlParser::parseFrames(const char*& cursor, Assets::MdlModel& model, const size_t count, const MdlSkinTriangleList& skinTriangles, const MdlSkinVertexList& skinVertices, const size_t skinWidth, const size_t skinHeight, const vm::vec3f& origin, const vm::vec3f& scale) {
+        std::vector<size_t> MdlParser::parseFrameOffsets(const char*& cursor, const size_t count, const size_t vertexCount) {
+            const size_t frameSize = MdlLayout::SimpleFrameVertices + vertexCount * MdlLayout::FrameVertexSize;
+
+            std::vector<size_t> offsets;
+            offsets.reserve(count);
+            
             for (size_t i = 0; i < count; ++i) {
+                if (m_end - cursor < 2 * static_cast<std::ptrdiff_t>(sizeof(int32_t))) {
+                    throw AssetException() << "MDL model '" << m_name << "' is truncated";
+                }
+                
                 const int type = readInt<int32_t>(cursor);
                 if (type == 0) { // single frame
-                    model.addFrame(parseFrame(cursor, skinTriangles, skinVertices, skinWidth, skinHeight, origin, scale));
-                } else { // frame group
-                    auto* frameGroup = new Assets::MdlFrameGroup();
-                    
+                    if (frameSize > static_cast<size_t>(m_end - cursor)) {
+                        throw AssetException() << "MDL model '" << m_name << "' is truncated";
+                    }
+                    offsets.push_back(static_cast<size_t>(cursor - m_begin));
+                    cursor += frameSize;
+                } else { // frame group, only its first frame is displayed
                     const char* base = cursor;
                     const size_t groupFrameCount = readSize<int32_t>(cursor);
-                    
-                    const char* timeCursor = base + MdlLayout::MultiFrameTimes;
-                    const char* frameCursor = base + MdlLayout::MultiFrameTimes + groupFrameCount * sizeof(float);
 
-                    for (size_t j = 0; j < groupFrameCount; ++j) {
-                        const float time = readFloat<float>(timeCursor);
-                        Assets::MdlFrame* frame = parseFrame(frameCursor, skinTriangles, skinVertices, skinWidth, skinHeight, origin, scale);
-                        frameGroup->addFrame(frame, time);
+                    // validate the frame count against the remaining bytes before computing any pointers from it
+                    const size_t remaining = static_cast<size_t>(m_end - base);
+                    if (remaining < MdlLayout::MultiFrameTimes ||
+                        groupFrameCount > (remaining - MdlLayout::MultiFrameTimes) / (sizeof(float) + frameSize)) {
+                        throw AssetException() << "MDL model '" << m_name << "' is truncated";
                     }
                     
-                    model.addFrame(frameGroup);
-                    cursor = frameCursor;
+                    const char* frameCursor = base + MdlLayout::MultiFrameTimes + groupFrameCount * sizeof(float);
+                    offsets.push_back(groupFrameCount > 0 ? static_cast<size_t>(frameCursor - m_begin) : 0);
+                    cursor = frameCursor + groupFrameCount * frameSize;
                 }
             }
+            
+            return offsets;
         }
 
-        Assets::MdlFrame* MdlParser::parseFrame(const char*& cursor, const MdlSkinTriangleList& skinTriangles, const MdlSkinVertexList& skinVertices, const size_t skinWidth, const size_t skinHeight, const vm::vec3f& origin, const vm::vec3f& scale) {
+        Assets::MdlFrame* MdlParser::parseFrame(const FrameData& data, const size_t frameIndex) {
+            assert(frameIndex < data.frameOffsets.size());
+            const size_t offset = data.frameOffsets[frameIndex];
+            if (offset == 0) {
+                return new Assets::MdlFrame("", Assets::MdlFrame::VertexList(), vm::bbox3f(-8.0f, 8.0f));
+            }
+
+            const MdlSkinVertexList& skinVertices = data.skinVertices;
+            const MdlSkinTriangleList& skinTriangles = data.skinTriangles;
+            const size_t skinWidth = data.skinWidth;
+            const size_t skinHeight = data.skinHeight;
+            const vm::vec3f& origin = data.origin;
+            const vm::vec3f& scale = data.scale;
+            
+            const char* cursor = data.file->begin() + offset;
             char name[MdlLayout::SimpleFrameLength + 1];
             name[MdlLayout::SimpleFrameLength] = 0;
             cursor += MdlLayout::SimpleFrameName;
@@ -383,7 +431,7 @@ namespace TrenchBroom {
             return new Assets::MdlFrame(String(name), frameTriangles, bounds);
         }
 
-        vm::vec3f MdlParser::unpackFrameVertex(const PackedFrameVertex& vertex, const vm::vec3f& origin, const vm::vec3f& scale) const {
+        vm::vec3f MdlParser::unpackFrameVertex(const PackedFrameVertex& vertex, const vm::vec3f& origin, const vm::vec3f& scale) {
             vm::vec3f result;
             for (size_t i = 0; i < 3; ++i) {
                 result[i] = origin[i] + scale[i]*static_cast<float>(vertex[i]);
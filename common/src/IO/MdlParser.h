@@ -24,10 +24,12 @@
 #include "ByteBuffer.h"
 #include "Assets/AssetTypes.h"
 #include "IO/EntityModelParser.h"
+#include "IO/MappedFile.h"
 
 #include <vecmath/forward.h>
 #include <vecmath/vec.h>
 
+#include <memory>
 #include <vector>
 
 namespace TrenchBroom {
@@ -39,9 +41,7 @@ namespace TrenchBroom {
     
     namespace IO {
         class MdlParser : public EntityModelParser {
-        private:
-            static const vm::vec3f Normals[162];
-            
+        public:
             struct MdlSkinVertex {
                 bool onseam;
                 int s;
@@ -55,24 +55,59 @@ namespace TrenchBroom {
             
             typedef std::vector<MdlSkinVertex> MdlSkinVertexList;
             typedef std::vector<MdlSkinTriangle> MdlSkinTriangleList;
+
+            /**
+             * Everything that is needed to decode the frames of a model after it has been parsed. Keeps the file
+             * that contains the frames mapped for as long as the model exists.
+             */
+            struct FrameData {
+                MappedFile::Ptr file;
+                MdlSkinVertexList skinVertices;
+                MdlSkinTriangleList skinTriangles;
+                size_t skinWidth;
+                size_t skinHeight;
+                vm::vec3f origin;
+                vm::vec3f scale;
+                std::vector<size_t> frameOffsets; // 0 denotes an empty frame group
+            };
+            using FrameDataPtr = std::shared_ptr<const FrameData>;
+        private:
+            static const vm::vec3f Normals[162];
+            
             typedef vm::vec<unsigned char, 4> PackedFrameVertex;
             typedef std::vector<PackedFrameVertex> PackedFrameVertexList;
             
             String m_name;
+            MappedFile::Ptr m_file;
             const char* m_begin;
             const char* m_end;
             const Assets::Palette& m_palette;
+            FrameDataPtr m_frameData;
         public:
-            MdlParser(const String& name, const char* begin, const char* end, const Assets::Palette& palette);
+            MdlParser(const String& name, MappedFile::Ptr file, const Assets::Palette& palette);
+
+            /**
+             * Returns the frame data of the most recently parsed model, or null if no model has been parsed yet.
+             */
+            const FrameDataPtr& frameData() const;
+
+            /**
+             * Returns the number of bytes that a single frame with the given data occupies in a model file.
+             */
+            static size_t frameSize(const FrameData& data);
+
+            /**
+             * Decodes the frame with the given index. For a frame group, its first frame is decoded.
+             */
+            static Assets::MdlFrame* parseFrame(const FrameData& data, size_t frameIndex);
         private:
             Assets::EntityModel* doParseModel() override;
             
             void parseSkins(const char*& cursor, Assets::MdlModel& model, size_t count, size_t width, size_t height, int flags);
             MdlSkinVertexList parseSkinVertices(const char*& cursor, size_t count);
             MdlSkinTriangleList parseSkinTriangles(const char*& cursor, size_t count);
-            void parseFrames(const char*& cursor, Assets::MdlModel& model, size_t count, const MdlSkinTriangleList& skinTriangles, const MdlSkinVertexList& skinVertices, size_t skinWidth, size_t skinHeight, const vm::vec3f& origin, const vm::vec3f& scale);
-            Assets::MdlFrame* parseFrame(const char*& cursor, const MdlSkinTriangleList& skinTriangles, const MdlSkinVertexList& skinVertices, size_t skinWidth, size_t skinHeight, const vm::vec3f& origin, const vm::vec3f& scale);
-            vm::vec3f unpackFrameVertex(const PackedFrameVertex& vertex, const vm::vec3f& origin, const vm::vec3f& scale) const;
+            std::vector<size_t> parseFrameOffsets(const char*& cursor, size_t count, size_t vertexCount);
+            static vm::vec3f unpackFrameVertex(const PackedFrameVertex& vertex, const vm::vec3f& origin, const vm::vec3f& scale);
         };
     }
 }
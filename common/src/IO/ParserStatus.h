@@ -55,6 +55,9 @@ namespace TrenchBroom {
         private:
             virtual void doProgress(double progress) = 0;
             virtual void doLog(Logger::LogLevel level, const String& str);
+
+            // passes on messages that were already formatted by another status
+            friend class BufferedParserStatus;
         };
     }
 }
@@ -27,6 +27,25 @@
 
 namespace TrenchBroom {
     namespace IO {
+        /**
+         * Calls the given function with a view of each of the given number of components, which are joined by
+         * forward slashes in the given string.
+         */
+        template <typename F>
+        static void forEachComponent(const String& components, const size_t length, F f) {
+            if (length == 0) {
+                return;
+            }
+
+            size_t begin = 0;
+            size_t end;
+            while ((end = components.find('/', begin)) != String::npos) {
+                f(std::string_view(components.data() + begin, end - begin));
+                begin = end + 1;
+            }
+            f(std::string_view(components.data() + begin, components.size() - begin));
+        }
+
         const Path::List Path::EmptyList = Path::List(0);
 
         char Path::separator() {
@@ -43,28 +62,52 @@ namespace TrenchBroom {
             return sep;
         }
 
-        Path::Path(bool absolute, const StringList& components) :
-        m_components(components),
+        Path::Path(const bool absolute, String components, const size_t length) :
+        m_components(std::move(components)),
+        m_length(length),
         m_absolute(absolute) {}
 
-        Path::Path(const String& path) {
-            const String trimmed = StringUtils::trim(path);
-            m_components = StringUtils::split(trimmed, separators());
+        Path::Path(const String& path) :
+        m_length(0),
+        m_absolute(false) {
+            static const String whitespace(" \n\t\r");
+            const auto trimmedFirst = path.find_first_not_of(whitespace);
+            if (trimmedFirst == String::npos) {
+                return;
+            }
+            const auto trimmedLast = path.find_last_not_of(whitespace);
+
+            const auto first = path.find_first_not_of(separators(), trimmedFirst);
+            if (first != String::npos && first <= trimmedLast) {
+                const auto last = path.find_last_not_of(separators(), trimmedLast);
+                m_components = path.substr(first, last - first + 1);
+                std::replace(std::begin(m_components), std::end(m_components), '\\', '/');
+                m_length = static_cast<size_t>(std::count(std::begin(m_components), std::end(m_components), '/')) + 1;
+            }
+
 #ifdef _WIN32
-            m_absolute = (hasDriveSpec(m_components) ||
-                          (!trimmed.empty() && trimmed[0] == '/') ||
-                          (!trimmed.empty() && trimmed[0] == '\\'));
+            m_absolute = (hasDriveSpec() ||
+                          path[trimmedFirst] == '/' ||
+                          path[trimmedFirst] == '\\');
 #else
-            m_absolute = !trimmed.empty() && trimmed[0] == separator();
+            m_absolute = path[trimmedFirst] == separator();
 #endif
         }
 
         Path Path::operator+(const Path& rhs) const {
             if (rhs.isAbsolute())
                 throw PathException("Cannot concatenate absolute path");
-            StringList components = m_components;
-            components.insert(std::end(components), std::begin(rhs.m_components), std::end(rhs.m_components));
-            return Path(m_absolute, components);
+            if (rhs.m_length == 0)
+                return *this;
+            if (m_length == 0)
+                return Path(m_absolute, rhs.m_components, rhs.m_length);
+
+            String components;
+            components.reserve(m_components.size() + 1 + rhs.m_components.size());
+            components.append(m_components);
+            components.push_back('/');
+            components.append(rhs.m_components);
+            return Path(m_absolute, std::move(components), m_length + rhs.m_length);
         }
 
         int Path::compare(const Path& rhs) const {
@@ -73,29 +116,35 @@ namespace TrenchBroom {
             if (isAbsolute() && !rhs.isAbsolute())
                 return 1;
             
-            const StringList& rcomps = rhs.m_components;
-            
-            size_t i = 0;
-            const size_t max = std::min(m_components.size(), rcomps.size());
-            while (i < max) {
-                const String& mcomp = m_components[i];
-                const String& rcomp = rcomps[i];
-                const int result = mcomp.compare(rcomp);
-                if (result < 0)
-                    return -1;
-                if (result > 0)
-                    return 1;
-                ++i;
+            // Comparing the joined components while treating the separator as the smallest character yields the
+            // same order as comparing the components one by one.
+            const String& lcomps = m_components;
+            const String& rcomps = rhs.m_components;
+            const size_t max = std::min(lcomps.size(), rcomps.size());
+            for (size_t i = 0; i < max; ++i) {
+                const char lc = lcomps[i];
+                const char rc = rcomps[i];
+                if (lc != rc) {
+                    if (lc == '/')
+                        return -1;
+                    if (rc == '/')
+                        return 1;
+                    return static_cast<unsigned char>(lc) < static_cast<unsigned char>(rc) ? -1 : 1;
+                }
             }
-            if (m_components.size() < rcomps.size())
+            if (m_length < rhs.m_length)
+                return -1;
+            if (m_length > rhs.m_length)
+                return 1;
+            if (lcomps.size() < rcomps.size())
                 return -1;
-            if (m_components.size() > rcomps.size())
+            if (lcomps.size() > rcomps.size())
                 return 1;
             return 0;
         }
 
         bool Path::operator==(const Path& rhs) const {
-            return compare(rhs) == 0;
+            return m_absolute == rhs.m_absolute && m_length == rhs.m_length && m_components == rhs.m_components;
         }
 
         bool Path::operator!= (const Path& rhs) const {
@@ -111,31 +160,31 @@ namespace TrenchBroom {
         }
 
         String Path::asString(const char separator) const {
-            if (m_absolute) {
-#ifdef _WIN32
-                if (hasDriveSpec(m_components))
-                    return StringUtils::join(m_components, separator);
-                else
-                    return separator + StringUtils::join(m_components, separator);
-#else
-                return separator + StringUtils::join(m_components, separator);
-#endif
-            }
-            return StringUtils::join(m_components, separator);
+            String result;
+            result.reserve(m_components.size() + 1);
+            if (m_absolute && !hasDriveSpec())
+                result.push_back(separator);
+            result.append(m_components);
+            if (separator != '/')
+                std::replace(std::begin(result) + (m_absolute && !hasDriveSpec() ? 1 : 0), std::end(result), '/', separator);
+            return result;
         }
 
         String Path::asString(const String& separator) const {
-            if (m_absolute) {
-#ifdef _WIN32
-                if (hasDriveSpec(m_components))
-                    return StringUtils::join(m_components, separator);
-                else
-                    return separator + StringUtils::join(m_components, separator);
-#else
-                return separator + StringUtils::join(m_components, separator);
-#endif
-            }
-            return StringUtils::join(m_components, separator);
+            if (separator.size() == 1)
+                return asString(separator[0]);
+
+            String result;
+            if (m_absolute && !hasDriveSpec())
+                result.append(separator);
+            bool first = true;
+            forEachComponent(m_components, m_length, [&](const std::string_view component) {
+                if (!first)
+                    result.append(separator);
+                result.append(component);
+                first = false;
+            });
+            return result;
         }
 
         StringList Path::asStrings(const Path::List& paths, const char separator) {
@@ -155,21 +204,25 @@ namespace TrenchBroom {
         }
 
         size_t Path::length() const {
-            return m_components.size();
+            return m_length;
+        }
+
+        std::string_view Path::components() const {
+            return m_components;
         }
 
         bool Path::isEmpty() const {
-            return !m_absolute && m_components.empty();
+            return !m_absolute && m_length == 0;
         }
 
         Path Path::firstComponent() const {
             if (isEmpty())
                 throw PathException("Cannot return first component of empty path");
             if (!m_absolute)
-                return Path(m_components.front());
+                return Path(String(component(0)));
 #ifdef _WIN32
-            if (hasDriveSpec(m_components))
-                return Path(m_components.front());
+            if (hasDriveSpec())
+                return Path(String(component(0)));
             return Path("\\");
 #else
             return Path("/");
@@ -179,30 +232,23 @@ namespace TrenchBroom {
         Path Path::deleteFirstComponent() const {
             if (isEmpty())
                 throw PathException("Cannot delete first component of empty path");
-            if (!m_absolute) {
-                StringList components;
-                components.reserve(m_components.size() - 1);
-                components.insert(std::begin(components), std::begin(m_components) + 1, std::end(m_components));
-                return Path(false, components);
-            }
 #ifdef _WIN32
-            if (!m_components.empty() && hasDriveSpec(m_components[0])) {
-                StringList components;
-                components.reserve(m_components.size() - 1);
-                components.insert(std::begin(components), std::begin(m_components) + 1, std::end(m_components));
-                return Path(false, components);
-            }
-            return Path(false, m_components);
+            if (!m_absolute || hasDriveSpec()) {
 #else
-            return Path(false, m_components);
+            if (!m_absolute) {
 #endif
+                if (m_length == 1)
+                    return Path(false, String(), 0);
+                return Path(false, m_components.substr(componentOffset(1)), m_length - 1);
+            }
+            return Path(false, m_components, m_length);
         }
 
         Path Path::lastComponent() const {
             if (isEmpty())
                 throw PathException("Cannot return last component of empty path");
-            if (!m_components.empty()) {
-                return Path(m_components.back());
+            if (m_length > 0) {
+                return Path(String(component(m_length - 1)));
             } else {
                 return Path("");
             }
@@ -211,13 +257,10 @@ namespace TrenchBroom {
         Path Path::deleteLastComponent() const {
             if (isEmpty())
                 throw PathException("Cannot delete last component of empty path");
-            if (!m_components.empty()) {
-                StringList components;
-                components.reserve(m_components.size() - 1);
-                components.insert(std::begin(components), std::begin(m_components), std::end(m_components) - 1);
-                return Path(m_absolute, components);
+            if (m_length > 1) {
+                return Path(m_absolute, m_components.substr(0, componentOffset(m_length - 1) - 1), m_length - 1);
             } else {
-                return Path(m_absolute, m_components);
+                return Path(m_absolute, String(), 0);
             }
         }
 
@@ -226,31 +269,27 @@ namespace TrenchBroom {
         }
         
         Path Path::suffix(const size_t count) const {
-            return subPath(m_components.size() - count, count);
+            return subPath(m_length - count, count);
         }
         
         Path Path::subPath(const size_t index, const size_t count) const {
-            if (index + count > m_components.size())
+            if (index + count > m_length)
                 throw PathException("Sub path out of bounds");
             if (count == 0)
                 return Path("");
             
-            auto begin = std::begin(m_components);
-            std::advance(begin, static_cast<StringList::const_iterator::difference_type>(index));
-            auto end = begin;
-            std::advance(end, static_cast<StringList::const_iterator::difference_type>(count));
-            StringList newComponents(count);
-            std::copy(begin, end, std::begin(newComponents));
-            return Path(m_absolute && index == 0, newComponents);
+            const auto begin = componentOffset(index);
+            const auto end = componentOffset(index + count) - 1;
+            return Path(m_absolute && index == 0, m_components.substr(begin, end - begin), count);
         }
 
         String Path::filename() const {
             if (isEmpty())
                 throw PathException("Cannot get filename of empty path");
-            if (m_components.empty()) {
+            if (m_length == 0) {
                 return "";
             } else {
-                return m_components.back();
+                return String(component(m_length - 1));
             }
         }
         
@@ -281,17 +320,15 @@ namespace TrenchBroom {
         Path Path::addExtension(const String& extension) const {
             if (isEmpty())
                 throw PathException("Cannot add extension to empty path");
-            auto components = m_components;
-            if (components.empty()
+            if (m_length == 0
 #ifdef _WIN32
-				|| hasDriveSpec(m_components.back())
+                || hasDriveSpec(component(m_length - 1))
 #endif
-				) {
-                components.push_back("." + extension);
+                ) {
+                return *this + Path(false, "." + extension, 1);
             } else {
-                components.back() += "." + extension;
+                return Path(m_absolute, m_components + "." + extension, m_length);
             }
-            return Path(m_absolute, components);
         }
 
         Path Path::replaceExtension(const String& extension) const {
@@ -307,9 +344,9 @@ namespace TrenchBroom {
                     isAbsolute() && absolutePath.isAbsolute()
 #ifdef _WIN32
                     && 
-                    !m_components.empty() && !absolutePath.m_components.empty()
+                    m_length > 0 && absolutePath.m_length > 0
                     &&
-                    m_components[0] == absolutePath.m_components[0]
+                    component(0) == absolutePath.component(0)
 #endif
             );
         }
@@ -333,44 +370,55 @@ namespace TrenchBroom {
                 throw PathException("Cannot make relative path with relative sub path");
 
 #ifdef _WIN32
-            if (m_components.empty())
+            if (m_length == 0)
                 throw PathException("Cannot make relative path from an reference path with no drive spec");
-            if (absolutePath.m_components.empty())
+            if (absolutePath.m_length == 0)
                 throw PathException("Cannot make relative path with sub path with no drive spec");
-            if (m_components[0] != absolutePath.m_components[0])
+            if (component(0) != absolutePath.component(0))
                 throw PathException("Cannot make relative path if reference path has different drive spec");
 #endif
             
-            const StringList myResolved = resolvePath(true, m_components);
-            const StringList theirResolved = resolvePath(true, absolutePath.m_components);
+            const Path myResolved = resolvePath();
+            const Path theirResolved = absolutePath.resolvePath();
             
+            std::vector<std::string_view> myComponents;
+            forEachComponent(myResolved.m_components, myResolved.m_length, [&](const std::string_view component) {
+                myComponents.push_back(component);
+            });
+            std::vector<std::string_view> theirComponents;
+            forEachComponent(theirResolved.m_components, theirResolved.m_length, [&](const std::string_view component) {
+                theirComponents.push_back(component);
+            });
+
             // cross off all common prefixes
             size_t p = 0;
-            while (p < std::min(myResolved.size(), theirResolved.size())) {
-                if (myResolved[p] != theirResolved[p])
+            while (p < std::min(myComponents.size(), theirComponents.size())) {
+                if (myComponents[p] != theirComponents[p])
                     break;
                 ++p;
             }
 
-            StringList components;
-            for (size_t i = p; i < myResolved.size(); ++i)
-                components.push_back("..");
-            for (size_t i = p; i < theirResolved.size(); ++i)
-                components.push_back(theirResolved[i]);
+            String components;
+            size_t length = 0;
+            const auto append = [&](const std::string_view component) {
+                if (length++ > 0)
+                    components.push_back('/');
+                components.append(component);
+            };
+            for (size_t i = p; i < myComponents.size(); ++i)
+                append("..");
+            for (size_t i = p; i < theirComponents.size(); ++i)
+                append(theirComponents[i]);
             
-            return Path(false, components);
+            return Path(false, std::move(components), length);
         }
 
         Path Path::makeCanonical() const {
-            return Path(m_absolute, resolvePath(m_absolute, m_components));
+            return resolvePath();
         }
 
         Path Path::makeLowerCase() const {
-            StringList lcComponents;
-            lcComponents.reserve(m_components.size());
-            std::transform(std::begin(m_components), std::end(m_components), std::back_inserter(lcComponents),
-                           [](const String& component) { return StringUtils::toLower(component); });
-            return Path(m_absolute, lcComponents);
+            return Path(m_absolute, StringUtils::toLower(m_components), m_length);
         }
 
         Path::List Path::makeAbsoluteAndCanonical(const List& paths, const Path& relativePath) {
@@ -381,17 +429,39 @@ namespace TrenchBroom {
             return result;
         }
 
-        bool Path::hasDriveSpec(const StringList& components) {
+        size_t Path::componentOffset(const size_t index) const {
+            assert(index <= m_length);
+            if (index == 0)
+                return 0;
+            if (index == m_length)
+                return m_components.size() + 1;
+            if (index == m_length - 1)
+                return m_components.rfind('/') + 1;
+
+            size_t offset = 0;
+            for (size_t i = 0; i < index; ++i)
+                offset = m_components.find('/', offset) + 1;
+            return offset;
+        }
+
+        std::string_view Path::component(const size_t index) const {
+            assert(index < m_length);
+            const auto begin = componentOffset(index);
+            const auto end = componentOffset(index + 1) - 1;
+            return std::string_view(m_components.data() + begin, end - begin);
+        }
+
+        bool Path::hasDriveSpec() const {
 #ifdef _WIN32
-            if (components.empty())
+            if (m_length == 0)
                 return false;
-            return hasDriveSpec(components[0]);
+            return hasDriveSpec(component(0));
 #else
             return false;
 #endif
         }
 
-        bool Path::hasDriveSpec(const String& component) {
+        bool Path::hasDriveSpec(const std::string_view component) {
 #ifdef _WIN32
             if (component.size() <= 1)
                 return false;
@@ -401,24 +471,37 @@ namespace TrenchBroom {
 #endif
         }
 
-        StringList Path::resolvePath(const bool absolute, const StringList& components) const {
-            StringList resolved;
-            for (const String& comp : components) {
-                if (comp == ".")
-                    continue;
-                if (comp == "..") {
-                    if (resolved.empty())
+        Path Path::resolvePath() const {
+            // most paths contain neither "." nor "..", so they need not be rebuilt
+            bool needsResolving = false;
+            forEachComponent(m_components, m_length, [&](const std::string_view component) {
+                needsResolving = needsResolving || component == "." || component == "..";
+            });
+            if (!needsResolving)
+                return *this;
+
+            String resolved;
+            std::vector<size_t> offsets;
+            forEachComponent(m_components, m_length, [&](const std::string_view component) {
+                if (component == ".")
+                    return;
+                if (component == "..") {
+                    if (offsets.empty())
                         throw PathException("Cannot resolve path");
 #ifdef _WIN32
-                    if (absolute && hasDriveSpec(resolved[0]) && resolved.size() < 2)
-                            throw PathException("Cannot resolve path");
+                    if (m_absolute && hasDriveSpec(std::string_view(resolved).substr(0, 2)) && offsets.size() < 2)
+                        throw PathException("Cannot resolve path");
 #endif
-                    resolved.pop_back();
-                    continue;
+                    resolved.erase(offsets.back() > 0 ? offsets.back() - 1 : 0);
+                    offsets.pop_back();
+                    return;
                 }
-                resolved.push_back(comp);
-            }
-            return resolved;
+                if (!offsets.empty())
+                    resolved.push_back('/');
+                offsets.push_back(resolved.size());
+                resolved.append(component);
+            });
+            return Path(m_absolute, std::move(resolved), offsets.size());
         }
 
         std::ostream& operator<<(std::ostream& stream, const Path& path) {
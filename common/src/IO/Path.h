@@ -23,6 +23,7 @@
 #include "StringUtils.h"
 
 #include <iostream>
+#include <string_view>
 #include <vector>
 
 namespace TrenchBroom {
@@ -43,23 +44,18 @@ namespace TrenchBroom {
                 }
             };
             
-            template <typename StringLess>
-            class Less {
-            private:
-                StringLess m_less;
-            public:
-                bool operator()(const Path& lhs, const Path& rhs) const {
-                    return std::lexicographical_compare(std::begin(lhs.m_components), std::end(lhs.m_components),
-                                                        std::begin(rhs.m_components), std::end(rhs.m_components), m_less);
-                }
-            };
         private:
             static const String& separators();
             
-            StringList m_components;
+            /**
+             * The components of this path, joined by forward slashes. Absolute paths do not store a leading
+             * separator here.
+             */
+            String m_components;
+            size_t m_length;
             bool m_absolute;
             
-            Path(bool absolute, const StringList& components);
+            Path(bool absolute, String components, size_t length);
         public:
             explicit Path(const String& path = "");
             
@@ -76,6 +72,14 @@ namespace TrenchBroom {
             static List asPaths(const StringList& strs);
             
             size_t length() const;
+            
+            /**
+             * Returns a view of the components of this path joined by forward slashes, without a leading separator.
+             * The view remains valid as long as this path is not modified or destroyed.
+             *
+             * @return a view of the components of this path
+             */
+            std::string_view components() const;
             bool isEmpty() const;
             Path firstComponent() const;
             Path deleteFirstComponent() const;
@@ -100,9 +104,11 @@ namespace TrenchBroom {
             
             static List makeAbsoluteAndCanonical(const List& paths, const Path& relativePath);
         private:
-            static bool hasDriveSpec(const StringList& components);
-            static bool hasDriveSpec(const String& component);
-            StringList resolvePath(const bool absolute, const StringList& components) const;
+            size_t componentOffset(size_t index) const;
+            std::string_view component(size_t index) const;
+            bool hasDriveSpec() const;
+            static bool hasDriveSpec(std::string_view component);
+            Path resolvePath() const;
         };
 
         std::ostream& operator<<(std::ostream& stream, const Path& path);
@@ -19,9 +19,12 @@
 
 #include "TextureCollectionLoader.h"
 
+#include "Exceptions.h"
 #include "Assets/AssetTypes.h"
+#include "Assets/Texture.h"
 #include "Assets/TextureCollection.h"
 #include "Assets/TextureManager.h"
+#include "IO/AssetCacheIO.h"
 #include "IO/DiskIO.h"
 #include "IO/FileMatcher.h"
 #include "IO/FileSystem.h"
@@ -30,6 +33,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iterator>
 #include <memory>
 
@@ -39,9 +43,35 @@ namespace TrenchBroom {
         TextureCollectionLoader::~TextureCollectionLoader() {}
 
         Assets::TextureCollection* TextureCollectionLoader::loadTextureCollection(const Path& path, const String& textureExtension, const TextureReader& textureReader) {
+            return readTextures(path, doFindTextures(path, textureExtension), textureReader);
+        }
+
+        Assets::TextureCollection* TextureCollectionLoader::loadTextureCollection(const Path& path, const String& textureExtension, const TextureReader& textureReader, AssetCache& cache, const AssetCache::Key& cacheKey) {
+            const MappedFile::List files = doFindTextures(path, textureExtension);
+
+            AssetCache::Key key(cacheKey);
+            key.append(path.asString());
+            key.append(textureExtension);
+            doAppendToCacheKey(path, files, key);
+
+            const MappedFile::Ptr entry = cache.find(key);
+            if (entry != nullptr) {
+                try {
+                    return readCachedTextures(path, *entry);
+                } catch (const AssetException&) {
+                    // the entry is unusable, so we decode the textures and replace it
+                }
+            }
+
+            std::unique_ptr<Assets::TextureCollection> collection(readTextures(path, files, textureReader));
+            storeCachedTextures(*collection, cache, key);
+            return collection.release();
+        }
+
+        Assets::TextureCollection* TextureCollectionLoader::readTextures(const Path& path, const MappedFile::List& files, const TextureReader& textureReader) const {
             std::unique_ptr<Assets::TextureCollection> collection(new Assets::TextureCollection(path));
             
-            for (MappedFile::Ptr file : doFindTextures(path, textureExtension)) {
+            for (MappedFile::Ptr file : files) {
                 Assets::Texture* texture = textureReader.readTexture(file->begin(), file->end(), file->path());
                 collection->addTexture(texture);
             }
@@ -49,6 +79,33 @@ namespace TrenchBroom {
             return collection.release();
         }
 
+        /*
+         A cache entry contains the number of textures followed by every texture as written by
+         AssetCacheWriter::writeTexture.
+         */
+
+        Assets::TextureCollection* TextureCollectionLoader::readCachedTextures(const Path& path, const MappedFile& entry) const {
+            AssetCacheReader reader(entry.begin(), entry.end());
+            std::unique_ptr<Assets::TextureCollection> collection(new Assets::TextureCollection(path));
+
+            const size_t textureCount = reader.readValue<uint32_t>();
+            for (size_t i = 0; i < textureCount; ++i)
+                collection->addTexture(reader.readTexture());
+
+            return collection.release();
+        }
+
+        void TextureCollectionLoader::storeCachedTextures(const Assets::TextureCollection& collection, AssetCache& cache, const AssetCache::Key& key) const {
+            AssetCacheWriter writer;
+
+            const Assets::TextureList& textures = collection.textures();
+            writer.writeValue(static_cast<uint32_t>(textures.size()));
+            for (const Assets::Texture* texture : textures)
+                writer.writeTexture(*texture);
+
+            cache.store(key, writer.data(), writer.size());
+        }
+
         FileTextureCollectionLoader::FileTextureCollectionLoader(const IO::Path::List& searchPaths) :
         m_searchPaths(searchPaths) {}
 
@@ -67,6 +124,10 @@ namespace TrenchBroom {
             return result;
         }
 
+        void FileTextureCollectionLoader::doAppendToCacheKey(const Path& path, const MappedFile::List& files, AssetCache::Key& key) const {
+            key.appendFile(Disk::resolvePath(m_searchPaths, path));
+        }
+
         DirectoryTextureCollectionLoader::DirectoryTextureCollectionLoader(const FileSystem& gameFS) :
         m_gameFS(gameFS) {}
 
@@ -81,5 +142,13 @@ namespace TrenchBroom {
             
             return result;
         }
+
+        void DirectoryTextureCollectionLoader::doAppendToCacheKey(const Path& path, const MappedFile::List& files, AssetCache::Key& key) const {
+            // the files may be stored in archives, so we cannot use their modification times
+            for (const MappedFile::Ptr& file : files) {
+                key.append(file->path().asString());
+                key.appendContents(file->begin(), file->end());
+            }
+        }
     }
 }
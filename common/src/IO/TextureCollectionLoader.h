@@ -21,6 +21,8 @@
 #define TextureCollectionLoader_h
 
 #include "StringUtils.h"
+#include "Assets/AssetTypes.h"
+#include "IO/AssetCache.h"
 #include "IO/MappedFile.h"
 #include "IO/Path.h"
 
@@ -49,8 +51,31 @@ namespace TrenchBroom {
             virtual ~TextureCollectionLoader();
         public:
             Assets::TextureCollection* loadTextureCollection(const Path& path, const String& textureExtension, const TextureReader& textureReader);
+
+            /**
+             * Loads a texture collection, reusing the decoded textures stored in the given cache if the textures have
+             * not changed since they were stored. Otherwise, the textures are read and stored in the cache.
+             *
+             * @param path the path of the texture collection
+             * @param textureExtension the extension of the texture files
+             * @param textureReader the reader to read the textures with
+             * @param cache the cache to use
+             * @param cacheKey a key describing the given texture reader
+             * @return the texture collection
+             */
+            Assets::TextureCollection* loadTextureCollection(const Path& path, const String& textureExtension, const TextureReader& textureReader, AssetCache& cache, const AssetCache::Key& cacheKey);
+        private:
+            Assets::TextureCollection* readTextures(const Path& path, const MappedFile::List& files, const TextureReader& textureReader) const;
+            Assets::TextureCollection* readCachedTextures(const Path& path, const MappedFile& entry) const;
+            void storeCachedTextures(const Assets::TextureCollection& collection, AssetCache& cache, const AssetCache::Key& key) const;
         private:
             virtual MappedFile::List doFindTextures(const Path& path, const String& extension) = 0;
+
+            /**
+             * Appends a description of the sources of the given textures to the given key, which must change whenever
+             * the contents of any of these sources change.
+             */
+            virtual void doAppendToCacheKey(const Path& path, const MappedFile::List& files, AssetCache::Key& key) const = 0;
         };
         
         class FileTextureCollectionLoader : public TextureCollectionLoader {
@@ -60,6 +85,7 @@ namespace TrenchBroom {
             FileTextureCollectionLoader(const Path::List& searchPaths);
         private:
             MappedFile::List doFindTextures(const Path& path, const String& extension) override;
+            void doAppendToCacheKey(const Path& path, const MappedFile::List& files, AssetCache::Key& key) const override;
         };
         
         class DirectoryTextureCollectionLoader : public TextureCollectionLoader {
@@ -69,6 +95,7 @@ namespace TrenchBroom {
             DirectoryTextureCollectionLoader(const FileSystem& gameFS);
         private:
             MappedFile::List doFindTextures(const Path& path, const String& extension) override;
+            void doAppendToCacheKey(const Path& path, const MappedFile::List& files, AssetCache::Key& key) const override;
         };
     }
 }
@@ -26,20 +26,22 @@
 #include "IO/HlMipTextureReader.h"
 #include "IO/IdMipTextureReader.h"
 #include "IO/IdWalTextureReader.h"
-#include "IO/FreeImageTextureReader.h"
+#include "IO/FileSystem.h"
 #include "IO/Path.h"
 #include "IO/TextureCollectionLoader.h"
 #include "Model/GameConfig.h"
 
 namespace TrenchBroom {
     namespace IO {
-        TextureLoader::TextureLoader(const EL::VariableStore& variables, const FileSystem& gameFS, const IO::Path::List& fileSearchPaths, const Model::GameConfig::TextureConfig& textureConfig) :
+        TextureLoader::TextureLoader(const EL::VariableStore& variables, const FileSystem& gameFS, const IO::Path::List& fileSearchPaths, const Model::GameConfig::TextureConfig& textureConfig, AssetCache* cache) :
         m_variables(variables.clone()),
         m_gameFS(gameFS),
         m_fileSearchPaths(fileSearchPaths),
         m_textureExtension(getTextureExtension(textureConfig)),
         m_textureReader(createTextureReader(textureConfig)),
-        m_textureCollectionLoader(createTextureCollectionLoader(textureConfig)) {
+        m_textureCollectionLoader(createTextureCollectionLoader(textureConfig)),
+        m_cache(cache),
+        m_cacheKey(createCacheKey(textureConfig)) {
             ensure(m_textureReader != nullptr, "textureReader is null");
             ensure(m_textureCollectionLoader != nullptr, "textureCollectionLoader is null");
         }
@@ -72,11 +74,14 @@ namespace TrenchBroom {
             }
         }
         
-        Assets::Palette TextureLoader::loadPalette(const Model::GameConfig::TextureConfig& textureConfig) const {
+        Path TextureLoader::palettePath(const Model::GameConfig::TextureConfig& textureConfig) const {
             const String pathSpec = textureConfig.palette.asString();
             const String pathStr = EL::interpolate(pathSpec, EL::EvaluationContext(*m_variables));
-            const Path path(pathStr);
-            return Assets::Palette::loadFile(m_gameFS, path);
+            return Path(pathStr);
+        }
+
+        Assets::Palette TextureLoader::loadPalette(const Model::GameConfig::TextureConfig& textureConfig) const {
+            return Assets::Palette::loadFile(m_gameFS, palettePath(textureConfig));
         }
 
         TextureCollectionLoader* TextureLoader::createTextureCollectionLoader(const Model::GameConfig::TextureConfig& textureConfig) const {
@@ -92,7 +97,24 @@ namespace TrenchBroom {
             }
         }
 
+        AssetCache::Key TextureLoader::createCacheKey(const Model::GameConfig::TextureConfig& textureConfig) const {
+            AssetCache::Key key("textures");
+            key.append(textureConfig.format.format);
+
+            // the palette is not used by every format, but including it anyway does no harm
+            if (m_cache != nullptr && !textureConfig.palette.isEmpty()) {
+                try {
+                    const MappedFile::Ptr file = m_gameFS.openFile(palettePath(textureConfig));
+                    key.appendContents(file->begin(), file->end());
+                } catch (const FileSystemException&) {
+                } catch (const FileNotFoundException&) {}
+            }
+            return key;
+        }
+
         Assets::TextureCollection* TextureLoader::loadTextureCollection(const Path& path) {
+            if (m_cache != nullptr)
+                return m_textureCollectionLoader->loadTextureCollection(path, m_textureExtension, *m_textureReader, *m_cache, m_cacheKey);
             return m_textureCollectionLoader->loadTextureCollection(path, m_textureExtension, *m_textureReader);
         }
 
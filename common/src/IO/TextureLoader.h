@@ -24,6 +24,7 @@
 #include "EL.h"
 #include "StringUtils.h"
 #include "Assets/AssetTypes.h"
+#include "IO/AssetCache.h"
 #include "IO/Path.h"
 #include "Model/GameConfig.h"
 
@@ -48,14 +49,27 @@ namespace TrenchBroom {
             String m_textureExtension;
             TextureReader* m_textureReader;
             TextureCollectionLoader* m_textureCollectionLoader;
+            AssetCache* m_cache;
+            AssetCache::Key m_cacheKey;
         public:
-            TextureLoader(const EL::VariableStore& variables, const FileSystem& gameFS, const IO::Path::List& fileSearchPaths, const Model::GameConfig::TextureConfig& textureConfig);
+            /**
+             * Creates a new texture loader.
+             *
+             * @param variables the variables to interpolate the palette path with
+             * @param gameFS the game file system
+             * @param fileSearchPaths the paths to search for texture collection files
+             * @param textureConfig the texture configuration of the game
+             * @param cache the cache to store decoded textures in, or null to always decode textures
+             */
+            TextureLoader(const EL::VariableStore& variables, const FileSystem& gameFS, const IO::Path::List& fileSearchPaths, const Model::GameConfig::TextureConfig& textureConfig, AssetCache* cache = nullptr);
             ~TextureLoader();
         private:
             String getTextureExtension(const Model::GameConfig::TextureConfig& textureConfig) const;
             TextureReader* createTextureReader(const Model::GameConfig::TextureConfig& textureConfig) const;
+            Path palettePath(const Model::GameConfig::TextureConfig& textureConfig) const;
             Assets::Palette loadPalette(const Model::GameConfig::TextureConfig& textureConfig) const;
             TextureCollectionLoader* createTextureCollectionLoader(const Model::GameConfig::TextureConfig& textureConfig) const;
+            AssetCache::Key createCacheKey(const Model::GameConfig::TextureConfig& textureConfig) const;
         public:
             Assets::TextureCollection* loadTextureCollection(const Path& path);
             void loadTextures(const Path::List& paths, Assets::TextureManager& textureManager);
@@ -105,7 +105,7 @@ namespace TrenchBroom {
                 
                 const auto path = IO::Path(entryName);
                 auto file = std::make_shared<MappedFileView>(m_file, path, entryBegin, entryEnd);
-                m_root.addFile(path, file);
+                m_directoryTable.addFile(path, file);
             }
         }
     }
@@ -40,6 +40,8 @@ namespace TrenchBroom {
             readEntities(format, worldBounds, status);
             m_world->rebuildNodeTree();
             m_world->enableNodeTreeUpdates();
+            m_world->rebuildAttributableIndex();
+            m_world->enableAttributableIndexUpdates();
             return m_world;
         }
 
@@ -47,6 +49,7 @@ namespace TrenchBroom {
             assert(m_world == nullptr);
             m_world = new Model::World(format, m_brushContentTypeBuilder, worldBounds);
             m_world->disableNodeTreeUpdates();
+            m_world->disableAttributableIndexUpdates();
             return m_world;
         }
         
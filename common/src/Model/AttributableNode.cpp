@@ -21,6 +21,10 @@
 
 #include "Assets/AttributeDefinition.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 namespace TrenchBroom {
     namespace Model {
         Assets::EntityDefinition* AttributableNode::selectEntityDefinition(const AttributableNodeList& attributables) {
@@ -247,7 +251,7 @@ namespace TrenchBroom {
             if (!attributes.empty()) {
                 const NotifyAttributeChange notifyChange(this);
 
-                for (const EntityAttribute& attribute : m_attributes.attributes()) {
+                for (const EntityAttribute& attribute : attributes) {
                     const AttributeName& name = attribute.name();
                     const AttributeValue& value = attribute.value();
                     
@@ -304,8 +308,8 @@ namespace TrenchBroom {
             EntityAttribute::List oldSorted = m_attributes.attributes();
             EntityAttribute::List newSorted = newAttributes;
             
-            oldSorted.sort();
-            newSorted.sort();
+            std::sort(std::begin(oldSorted), std::end(oldSorted));
+            std::sort(std::begin(newSorted), std::end(newSorted));
             
             auto oldIt = std::begin(oldSorted);
             auto oldEnd = std::end(oldSorted);
@@ -397,6 +401,41 @@ namespace TrenchBroom {
             return result;
         }
 
+        void AttributableNode::rebuildLinks(const AttributableNodeList& attributables) {
+            for (AttributableNode* attributable : attributables)
+                attributable->removeAllLinks();
+
+            typedef std::pair<const AttributeValue*, AttributableNode*> Targetname;
+            std::vector<Targetname> targetnames;
+            for (AttributableNode* attributable : attributables) {
+                const AttributeValue* targetname = attributable->m_attributes.attribute(AttributeNames::Targetname);
+                if (targetname != nullptr && !targetname->empty())
+                    targetnames.push_back(Targetname(targetname, attributable));
+            }
+
+            const auto compare = [](const Targetname& lhs, const Targetname& rhs) { return *lhs.first < *rhs.first; };
+            std::sort(std::begin(targetnames), std::end(targetnames), compare);
+
+            for (AttributableNode* attributable : attributables) {
+                for (const EntityAttribute& attribute : attributable->m_attributes.numberedAttributes(AttributeNames::Target)) {
+                    const Targetname key(&attribute.value(), nullptr);
+                    const auto range = std::equal_range(std::begin(targetnames), std::end(targetnames), key, compare);
+                    for (auto it = range.first; it != range.second; ++it) {
+                        attributable->addLinkTarget(it->second);
+                        it->second->addLinkSource(attributable);
+                    }
+                }
+                for (const EntityAttribute& attribute : attributable->m_attributes.numberedAttributes(AttributeNames::Killtarget)) {
+                    const Targetname key(&attribute.value(), nullptr);
+                    const auto range = std::equal_range(std::begin(targetnames), std::end(targetnames), key, compare);
+                    for (auto it = range.first; it != range.second; ++it) {
+                        attributable->addKillTarget(it->second);
+                        it->second->addKillSource(attributable);
+                    }
+                }
+            }
+        }
+
         void AttributableNode::findMissingTargets(const AttributeName& prefix, AttributeNameList& result) const {
             for (const EntityAttribute& attribute : m_attributes.numberedAttributes(prefix)) {
                 const AttributeValue& targetname = attribute.value();
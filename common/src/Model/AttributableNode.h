@@ -146,6 +146,15 @@ namespace TrenchBroom {
             bool hasMissingSources() const;
             AttributeNameList findMissingLinkTargets() const;
             AttributeNameList findMissingKillTargets() const;
+
+            /**
+             * Discards the links of the given nodes and links them again among each other. Instead of searching an
+             * index for the targets of each link, the nodes are sorted by their targetnames once. This is used to link
+             * the nodes of a world after they were added without updating the attribute index.
+             *
+             * @param attributables the nodes to link
+             */
+            static void rebuildLinks(const AttributableNodeList& attributables);
         private: // link management internals
             void findMissingTargets(const AttributeName& prefix, AttributeNameList& result) const;
             
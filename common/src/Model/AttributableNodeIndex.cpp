@@ -21,6 +21,7 @@
 
 #include "CollectionUtils.h"
 #include "Macros.h"
+#include "ParallelUtils.h"
 #include "Model/AttributableNode.h"
 
 #include <cassert>
@@ -99,6 +100,31 @@ namespace TrenchBroom {
                 removeAttribute(attributable, attribute.name(), attribute.value());
         }
 
+        void AttributableNodeIndex::build(const AttributableNodeList& attributables) {
+            size_t count = 0;
+            for (const AttributableNode* attributable : attributables)
+                count += attributable->attributes().size();
+
+            AttributableNodeStringIndex::KeyValueList names, values;
+            names.reserve(count);
+            values.reserve(count);
+            for (AttributableNode* attributable : attributables) {
+                for (const EntityAttribute& attribute : attributable->attributes()) {
+                    names.emplace_back(attribute.name(), attributable);
+                    values.emplace_back(attribute.value(), attributable);
+                }
+            }
+
+            m_nameIndex.clear();
+            m_valueIndex.clear();
+            ParallelUtils::parallelFor(2, [&](const size_t i) {
+                if (i == 0)
+                    m_nameIndex.insert(names);
+                else
+                    m_valueIndex.insert(values);
+            });
+        }
+
         void AttributableNodeIndex::addAttribute(AttributableNode* attributable, const AttributeName& name, const AttributeValue& value) {
             m_nameIndex.insert(name, attributable);
             m_valueIndex.insert(value, attributable);
@@ -63,6 +63,14 @@ namespace TrenchBroom {
         public:
             void addAttributableNode(AttributableNode* attributable);
             void removeAttributableNode(AttributableNode* attributable);
+
+            /**
+             * Replaces the contents of this index with the attributes of the given nodes. This is much faster than
+             * adding the nodes one by one because the name and value indices are built in bulk, and in parallel.
+             *
+             * @param attributables the nodes to index
+             */
+            void build(const AttributableNodeList& attributables);
             
             void addAttribute(AttributableNode* attributable, const AttributeName& name, const AttributeValue& value);
             void removeAttribute(AttributableNode* attributable, const AttributeName& name, const AttributeValue& value);
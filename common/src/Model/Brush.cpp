@@ -773,16 +773,19 @@ namespace TrenchBroom {
             ensure(!vertexPositions.empty(), "no vertex positions");
             assert(canRemoveVertices(worldBounds, vertexPositions));
 
-            BrushGeometry newGeometry;
             const auto vertexSet = Brush::createVertexSet(vertexPositions);
 
+            std::vector<vm::vec3> newPositions;
+            newPositions.reserve(m_geometry->vertexCount());
             for (const auto* vertex : m_geometry->vertices()) {
                 const auto& position = vertex->position();
                 if (!vertexSet.count(position)) {
-                    newGeometry.addPoint(position);
+                    newPositions.push_back(position);
                 }
             }
 
+            BrushGeometry newGeometry(newPositions);
+
             const PolyhedronMatcher<BrushGeometry> matcher(*m_geometry, newGeometry);
             doSetNewGeometry(worldBounds, matcher, newGeometry);
         }
@@ -961,17 +964,28 @@ namespace TrenchBroom {
             }
 
             BrushGeometry moving(*m_geometry);
-            BrushGeometry result;
+            std::vector<vm::vec3> resultPositions;
+            resultPositions.reserve(m_geometry->vertexCount());
             for (const auto* vertex : m_geometry->vertices()) {
                 const auto& position = vertex->position();
                 if (!vertexSet.count(position)) {
                     moving.removeVertexByPosition(position);
-                    result.addPoint(position);
+                    resultPositions.push_back(position);
                 } else {
-                    result.addPoint(position + delta);
+                    resultPositions.push_back(position + delta);
                 }
             }
 
+            // If the topology doesn't change, we can move the vertices of a copy of the current geometry instead of
+            // building the convex hull of the new vertex positions.
+            BrushGeometry result;
+            if (m_geometry->canMoveVerticesPreservingTopology(vertexPositions, delta)) {
+                result = *m_geometry;
+                result.moveVerticesPreservingTopology(vertexPositions, delta);
+            } else {
+                result.addPoints(resultPositions);
+            }
+
             assert(remaining.vertexCount() + moving.vertexCount() == vertexCount());
 
             // Will the result go out of world bounds?
@@ -1037,18 +1051,42 @@ namespace TrenchBroom {
             ensure(!vertexPositions.empty(), "no vertex positions");
             assert(canMoveVertices(worldBounds, vertexPositions, delta));
 
-            BrushGeometry newGeometry;
+            // This is the common case when dragging vertices: If the topology doesn't change, the faces of this brush
+            // remain the same, so we can move the vertices of the current geometry in place and update the face points
+            // from them. The geometry faces and the brush faces keep referring to each other, and the geometry updates
+            // its bounds itself, so neither a new convex hull nor a rebuild of the geometry from the face planes is
+            // necessary.
+            if (m_geometry->canMoveVerticesPreservingTopology(vertexPositions, delta)) {
+                const NotifyNodeChange nodeChange(this);
+                const auto oldBounds = bounds();
+
+                m_geometry->moveVerticesPreservingTopology(vertexPositions, delta);
+                for (auto* face : m_faces) {
+                    face->updatePointsFromVertices();
+                    face->resetTexCoordSystemCache();
+                }
+
+                invalidateVertexCache();
+                nodeBoundsDidChange(oldBounds);
+                assert(checkGeometry());
+                return;
+            }
+
             const auto vertexSet = Brush::createVertexSet(vertexPositions);
 
+            std::vector<vm::vec3> newPositions;
+            newPositions.reserve(m_geometry->vertexCount());
             for (auto* vertex : m_geometry->vertices()) {
                 const auto& position = vertex->position();
                 if (vertexSet.count(position)) {
-                    newGeometry.addPoint(position + delta);
+                    newPositions.push_back(position + delta);
                 } else {
-                    newGeometry.addPoint(position);
+                    newPositions.push_back(position);
                 }
             }
 
+            BrushGeometry newGeometry(newPositions);
+
             using VecMap = std::map<vm::vec3, vm::vec3>;
             VecMap vertexMapping;
             for (auto* oldVertex : m_geometry->vertices()) {
@@ -1080,12 +1118,18 @@ namespace TrenchBroom {
         }
 
         BrushList Brush::subtract(const ModelFactory& factory, const vm::bbox3& worldBounds, const String& defaultTextureName, const Brush* subtrahend) const {
-            const auto result = m_geometry->subtract(*subtrahend->m_geometry);
+            return createSubtractionBrushes(factory, worldBounds, defaultTextureName, subtractGeometry(subtrahend), subtrahend);
+        }
+
+        BrushGeometry::SubtractResult Brush::subtractGeometry(const Brush* subtrahend) const {
+            return m_geometry->subtract(*subtrahend->m_geometry);
+        }
 
+        BrushList Brush::createSubtractionBrushes(const ModelFactory& factory, const vm::bbox3& worldBounds, const String& defaultTextureName, const BrushGeometry::SubtractResult& fragments, const Brush* subtrahend) const {
             BrushList brushes;
-            brushes.reserve(result.size());
+            brushes.reserve(fragments.size());
 
-            for (const auto& geometry : result) {
+            for (const auto& geometry : fragments) {
                 auto* brush = createBrush(factory, worldBounds, defaultTextureName, geometry, subtrahend);
                 brushes.push_back(brush);
             }
@@ -220,6 +220,19 @@ namespace TrenchBroom {
         public:
             // CSG operations
             BrushList subtract(const ModelFactory& factory, const vm::bbox3& worldBounds, const String& defaultTextureName, const Brush* subtrahend) const;
+
+            /**
+             * Computes the fragments that remain when subtracting the given subtrahend from this brush, without
+             * creating any brushes from them. This does not modify this brush or the subtrahend, so it is safe to
+             * call concurrently for different minuends.
+             */
+            BrushGeometry::SubtractResult subtractGeometry(const Brush* subtrahend) const;
+
+            /**
+             * Creates brushes for the given fragments, which must have been computed by calling subtractGeometry on
+             * this brush with the given subtrahend.
+             */
+            BrushList createSubtractionBrushes(const ModelFactory& factory, const vm::bbox3& worldBounds, const String& defaultTextureName, const BrushGeometry::SubtractResult& fragments, const Brush* subtrahend) const;
             void intersect(const vm::bbox3& worldBounds, const Brush* brush);
 
             // transformation
@@ -48,7 +48,9 @@ namespace TrenchBroom {
         Entity::Entity() :
         AttributableNode(),
         Object(),
-        m_boundsValid(false) {
+        m_boundsValid(false),
+        m_modelDefinition(nullptr),
+        m_modelSpecificationValid(false) {
             cacheAttributes();
         }
 
@@ -111,11 +113,50 @@ namespace TrenchBroom {
             EntityRotationPolicy::applyRotation(this, transformation);
         }
 
-        Assets::ModelSpecification Entity::modelSpecification() const {
-            if (!hasPointEntityModel())
-                return Assets::ModelSpecification();
-            Assets::PointEntityDefinition* pointDefinition = static_cast<Assets::PointEntityDefinition*>(m_definition);
-            return pointDefinition->model(m_attributes);
+        const Assets::ModelSpecification& Entity::modelSpecification() const {
+            if (!m_modelSpecificationValid) {
+                validateModelSpecification();
+            }
+            return m_modelSpecification;
+        }
+
+        void Entity::invalidateModelSpecification() {
+            if (m_modelSpecificationValid && (m_modelDefinition != m_definition || modelAttributesChanged())) {
+                m_modelSpecificationValid = false;
+            }
+        }
+
+        void Entity::validateModelSpecification() const {
+            m_modelDefinition = m_definition;
+            m_modelAttributeValues.clear();
+
+            if (hasPointEntityModel()) {
+                const Assets::PointEntityDefinition* pointDefinition = static_cast<const Assets::PointEntityDefinition*>(m_definition);
+                for (const AttributeName& name : pointDefinition->modelDefinition().attributeDependencies()) {
+                    m_modelAttributeValues.push_back(attribute(name));
+                }
+                m_modelSpecification = pointDefinition->model(m_attributes);
+            } else {
+                m_modelSpecification = Assets::ModelSpecification();
+            }
+            m_modelSpecificationValid = true;
+        }
+
+        bool Entity::modelAttributesChanged() const {
+            if (!hasPointEntityModel()) {
+                return false;
+            }
+
+            const Assets::PointEntityDefinition* pointDefinition = static_cast<const Assets::PointEntityDefinition*>(m_definition);
+            const StringList& names = pointDefinition->modelDefinition().attributeDependencies();
+            assert(names.size() == m_modelAttributeValues.size());
+
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (attribute(names[i]) != m_modelAttributeValues[i]) {
+                    return true;
+                }
+            }
+            return false;
         }
 
         const vm::bbox3& Entity::doGetBounds() const {
@@ -261,6 +302,7 @@ namespace TrenchBroom {
             // update m_cachedOrigin and m_cachedRotation. Must be done first because nodeBoundsDidChange() might
             // call origin()
             cacheAttributes();
+            invalidateModelSpecification();
 
             nodeBoundsDidChange(oldBounds);
         }
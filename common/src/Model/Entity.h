@@ -23,6 +23,7 @@
 #include "TrenchBroom.h"
 #include "Hit.h"
 #include "Assets/AssetTypes.h"
+#include "Assets/ModelDefinition.h"
 #include "Model/AttributableNode.h"
 #include "Model/EntityRotationPolicy.h"
 #include "Model/Object.h"
@@ -44,6 +45,15 @@ namespace TrenchBroom {
             mutable bool m_boundsValid;
             mutable vm::vec3 m_cachedOrigin;
             mutable vm::mat4x4 m_cachedRotation;
+
+            /**
+             * The model specification is memoized together with the definition and the values of the attributes it
+             * was computed from, and it is only recomputed when one of these changes.
+             */
+            mutable Assets::ModelSpecification m_modelSpecification;
+            mutable const Assets::EntityDefinition* m_modelDefinition;
+            mutable StringList m_modelAttributeValues;
+            mutable bool m_modelSpecificationValid;
         public:
             Entity();
             
@@ -62,7 +72,11 @@ namespace TrenchBroom {
             void setOrigin(const vm::vec3& origin);
             void applyRotation(const vm::mat4x4& transformation);
         public: // entity model
-            Assets::ModelSpecification modelSpecification() const;
+            const Assets::ModelSpecification& modelSpecification() const;
+        private:
+            void invalidateModelSpecification();
+            void validateModelSpecification() const;
+            bool modelAttributesChanged() const;
         private: // implement Node interface
             const vm::bbox3& doGetBounds() const override;
 
@@ -22,6 +22,9 @@
 #include "Exceptions.h"
 #include "Assets/EntityDefinition.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace TrenchBroom {
     namespace Model {
         const String AttributeEscapeChars = "\"\n\\";
@@ -153,6 +156,8 @@ namespace TrenchBroom {
             return defaultValue;
         }
 
+        const size_t EntityAttributes::IndexThreshold = 32;
+
         const EntityAttribute::List& EntityAttributes::attributes() const {
             return m_attributes;
         }
@@ -170,7 +175,11 @@ namespace TrenchBroom {
                 return *it;
             } else {
                 m_attributes.push_back(EntityAttribute(name, value, definition));
-                m_index.insert(name, --std::end(m_attributes));
+                if (m_index != nullptr) {
+                    m_index->insert(name, m_attributes.size() - 1);
+                } else if (m_attributes.size() > IndexThreshold) {
+                    rebuildIndex();
+                }
                 return m_attributes.back();
             }
         }
@@ -188,8 +197,11 @@ namespace TrenchBroom {
             EntityAttribute::List::iterator it = findAttribute(name);
             if (it == std::end(m_attributes))
                 return;
-            m_index.remove(name, it);
             m_attributes.erase(it);
+
+            // the positions of all following attributes have changed
+            if (m_index != nullptr)
+                rebuildIndex();
         }
 
         void EntityAttributes::updateDefinitions(const Assets::EntityDefinition* entityDefinition) {
@@ -212,28 +224,23 @@ namespace TrenchBroom {
         }
         
         bool EntityAttributes::hasAttributeWithPrefix(const AttributeName& prefix, const AttributeValue& value) const {
-            return containsValue(m_index.queryPrefixMatches(prefix), value);
+            return containsValue(queryPrefixMatches(prefix), value);
         }
         
         bool EntityAttributes::hasNumberedAttribute(const AttributeName& prefix, const AttributeValue& value) const {
-            return containsValue(m_index.queryNumberedMatches(prefix), value);
+            return containsValue(queryNumberedMatches(prefix), value);
         }
 
         EntityAttributeSnapshot EntityAttributes::snapshot(const AttributeName& name) const {
-            const AttributeIndex::QueryResult matches = m_index.queryExactMatches(name);
-            if (matches.empty())
+            const EntityAttribute::List::const_iterator it = findAttribute(name);
+            if (it == std::end(m_attributes))
                 return EntityAttributeSnapshot(name);
-            
-            assert(matches.size() == 1);
-            return EntityAttributeSnapshot(name, matches.front()->value());
+            return EntityAttributeSnapshot(name, it->value());
         }
 
-        bool EntityAttributes::containsValue(const AttributeIndex::QueryResult& matches, const AttributeValue& value) const {
-            if (matches.empty())
-                return false;
-            
-            for (auto attrIt : matches) {
-                const EntityAttribute& attribute = *attrIt;
+        bool EntityAttributes::containsValue(const IndexQueryResult& matches, const AttributeValue& value) const {
+            for (const size_t index : matches) {
+                const EntityAttribute& attribute = m_attributes[index];
                 if (attribute.value() == value)
                     return true;
             }
@@ -241,13 +248,12 @@ namespace TrenchBroom {
             return false;
         }
         
-        EntityAttribute::List EntityAttributes::listFromQueryResult(const AttributeIndex::QueryResult& matches) const {
+        EntityAttribute::List EntityAttributes::listFromQueryResult(const IndexQueryResult& matches) const {
             EntityAttribute::List result;
+            result.reserve(matches.size());
             
-            for (auto attrIt : matches) {
-                const EntityAttribute& attribute = *attrIt;
-                result.push_back(attribute);
-            }
+            for (const size_t index : matches)
+                result.push_back(m_attributes[index]);
             
             return result;
         }
@@ -274,49 +280,83 @@ namespace TrenchBroom {
         }
 
         EntityAttribute::List EntityAttributes::attributeWithName(const AttributeName& name) const {
-            return listFromQueryResult(m_index.queryExactMatches(name));
+            const EntityAttribute::List::const_iterator it = findAttribute(name);
+            if (it == std::end(m_attributes))
+                return EntityAttribute::List();
+            return EntityAttribute::List(1, *it);
         }
         
         EntityAttribute::List EntityAttributes::attributesWithPrefix(const AttributeName& prefix) const{
-            return listFromQueryResult(m_index.queryPrefixMatches(prefix));
+            return listFromQueryResult(queryPrefixMatches(prefix));
         }
         
         EntityAttribute::List EntityAttributes::numberedAttributes(const String& prefix) const {
-            EntityAttribute::List result;
-
-            for (const EntityAttribute& attribute : m_attributes) {
-                if (isNumberedAttribute(prefix, attribute.name()))
-                    result.push_back(attribute);
-            }
-            
-            return result;
+            return listFromQueryResult(queryNumberedMatches(prefix));
         }
 
         EntityAttribute::List::const_iterator EntityAttributes::findAttribute(const AttributeName& name) const {
-            const AttributeIndex::QueryResult matches = m_index.queryExactMatches(name);
+            if (m_index == nullptr) {
+                return std::find_if(std::begin(m_attributes), std::end(m_attributes),
+                                    [&name](const EntityAttribute& attribute) { return attribute.name() == name; });
+            }
+
+            const IndexQueryResult matches = m_index->queryExactMatches(name);
             if (matches.empty())
                 return std::end(m_attributes);
             
             assert(matches.size() == 1);
-            return matches.front();
+            return std::next(std::begin(m_attributes), static_cast<std::ptrdiff_t>(matches.front()));
         }
         
         EntityAttribute::List::iterator EntityAttributes::findAttribute(const AttributeName& name) {
-            const AttributeIndex::QueryResult matches = m_index.queryExactMatches(name);
-            if (matches.empty())
-                return std::end(m_attributes);
-            
-            assert(matches.size() == 1);
-            return matches.front();
+            const EntityAttribute::List::const_iterator it = static_cast<const EntityAttributes*>(this)->findAttribute(name);
+            return std::next(std::begin(m_attributes), std::distance(std::cbegin(m_attributes), it));
+        }
+
+        EntityAttributes::IndexQueryResult EntityAttributes::queryPrefixMatches(const AttributeName& prefix) const {
+            if (m_index != nullptr) {
+                // the index returns the matches in the order of their names
+                IndexQueryResult result = m_index->queryPrefixMatches(prefix);
+                std::sort(std::begin(result), std::end(result));
+                return result;
+            }
+
+            IndexQueryResult result;
+            for (size_t i = 0; i < m_attributes.size(); ++i) {
+                if (StringUtils::isPrefix(m_attributes[i].name(), prefix))
+                    result.push_back(i);
+            }
+            return result;
+        }
+
+        EntityAttributes::IndexQueryResult EntityAttributes::queryNumberedMatches(const AttributeName& prefix) const {
+            if (m_index != nullptr) {
+                IndexQueryResult result = m_index->queryNumberedMatches(prefix);
+                std::sort(std::begin(result), std::end(result));
+                return result;
+            }
+
+            IndexQueryResult result;
+            for (size_t i = 0; i < m_attributes.size(); ++i) {
+                if (isNumberedAttribute(prefix, m_attributes[i].name()))
+                    result.push_back(i);
+            }
+            return result;
         }
 
         void EntityAttributes::rebuildIndex() {
-            m_index.clear();
-            
-            for (auto it = std::begin(m_attributes), end = std::end(m_attributes); it != end; ++it) {
-                const EntityAttribute& attribute = *it;
-                m_index.insert(attribute.name(), it);
+            if (m_attributes.size() <= IndexThreshold) {
+                m_index.reset();
+                return;
             }
+
+            if (m_index == nullptr)
+                m_index = std::make_unique<AttributeIndex>();
+            else
+                m_index->clear();
+            
+            for (size_t i = 0; i < m_attributes.size(); ++i)
+                m_index->insert(m_attributes[i].name(), i);
         }
     }
 }
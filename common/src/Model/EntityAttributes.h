@@ -26,7 +26,8 @@
 #include "Model/ModelTypes.h"
 
 #include <map>
-#include <list>
+#include <memory>
+#include <vector>
 
 namespace TrenchBroom {
     namespace Assets {
@@ -77,7 +78,7 @@ namespace TrenchBroom {
         class EntityAttribute {
         public:
             typedef std::map<AttributableNode*, EntityAttribute> Map;
-            typedef std::list<EntityAttribute> List;
+            typedef std::vector<EntityAttribute> List;
             static const List EmptyList;
         private:
             AttributeName m_name;
@@ -102,14 +103,22 @@ namespace TrenchBroom {
         bool isWorldspawn(const String& classname, const EntityAttribute::List& attributes);
         const AttributeValue& findAttribute(const EntityAttribute::List& attributes, const AttributeName& name, const AttributeValue& defaultValue = EmptyString);
         
+        /**
+         * Stores the attributes of an entity in insertion order in a contiguous array. Most entities only have a
+         * handful of attributes, and these are found by a linear search. Only entities with more than IndexThreshold
+         * attributes additionally maintain a radix tree index that maps attribute names to positions in the array.
+         */
         class EntityAttributes {
+        public:
+            static const size_t IndexThreshold;
         private:
             EntityAttribute::List m_attributes;
             
-            typedef EntityAttribute::List::iterator IndexValue;
+            typedef size_t IndexValue;
             typedef StringMapValueContainer<IndexValue> IndexValueContainer;
             typedef StringMap<IndexValue, IndexValueContainer> AttributeIndex;
-            AttributeIndex m_index;
+            typedef AttributeIndex::QueryResult IndexQueryResult;
+            std::unique_ptr<AttributeIndex> m_index;
         public:
             const EntityAttribute::List& attributes() const;
             void setAttributes(const EntityAttribute::List& attributes);
@@ -126,8 +135,8 @@ namespace TrenchBroom {
             
             EntityAttributeSnapshot snapshot(const AttributeName& name) const;
         private:
-            bool containsValue(const AttributeIndex::QueryResult& matches, const AttributeValue& value) const;
-            EntityAttribute::List listFromQueryResult(const AttributeIndex::QueryResult& matches) const;
+            bool containsValue(const IndexQueryResult& matches, const AttributeValue& value) const;
+            EntityAttribute::List listFromQueryResult(const IndexQueryResult& matches) const;
         public:
             const AttributeNameSet names() const;
             const AttributeValue* attribute(const AttributeName& name) const;
@@ -139,6 +148,9 @@ namespace TrenchBroom {
         private:
             EntityAttribute::List::const_iterator findAttribute(const AttributeName& name) const;
             EntityAttribute::List::iterator findAttribute(const AttributeName& name);
+
+            IndexQueryResult queryPrefixMatches(const AttributeName& prefix) const;
+            IndexQueryResult queryNumberedMatches(const AttributeName& prefix) const;
             
             void rebuildIndex();
         };
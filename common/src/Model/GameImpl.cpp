@@ -20,11 +20,16 @@
 #include "GameImpl.h"
 
 #include "Macros.h"
+#include "PreferenceManager.h"
+#include "Preferences.h"
 #include "Assets/Palette.h"
+#include "IO/AssetCache.h"
 #include "IO/BrushFaceReader.h"
 #include "IO/Bsp29Parser.h"
 #include "IO/DefParser.h"
 #include "IO/DiskFileSystem.h"
+#include "IO/EntityDefinitionCache.h"
+#include "IO/EntityModelCache.h"
 #include "IO/FgdParser.h"
 #include "IO/FileMatcher.h"
 #include "IO/FileSystem.h"
@@ -50,26 +55,49 @@
 
 #include "Exceptions.h"
 
+#include <algorithm>
 #include <cstdio>
 
 namespace TrenchBroom {
     namespace Model {
+        static bool isAssetCacheEnabled() {
+            return pref(Preferences::AssetCacheEnabled);
+        }
+
         GameImpl::GameImpl(GameConfig& config, const IO::Path& gamePath, Logger* logger) :
         m_config(config),
-        m_gamePath(gamePath) {
+        m_gamePath(gamePath),
+        m_gameFSMounted(false),
+        m_baseFileSystemCount(0) {
             initializeFileSystem(logger);
+
+            // entity models are loaded on worker threads, which must not be the first to read this preference
+            isAssetCacheEnabled();
         }
         
         void GameImpl::initializeFileSystem(Logger* logger) {
+            m_gameFS.clear();
+            m_gameFSMounted = false;
+            m_baseFileSystemCount = 0;
+            m_additionalFileSystemCounts.clear();
+
             const GameConfig::FileSystemConfig& fileSystemConfig = m_config.fileSystemConfig();
             if (!m_gamePath.isEmpty() && IO::Disk::directoryExists(m_gamePath)) {
                 addSearchPath(fileSystemConfig.searchPath, logger);
                 addPackages(m_gamePath + fileSystemConfig.searchPath);
 
-                for (const IO::Path& searchPath : m_additionalSearchPaths) {
-                    addSearchPath(searchPath, logger);
-                    addPackages(m_gamePath + searchPath);
-                }
+                m_gameFSMounted = true;
+                m_baseFileSystemCount = m_gameFS.fileSystemCount();
+                mountAdditionalSearchPaths(0, logger);
+            }
+        }
+
+        void GameImpl::mountAdditionalSearchPaths(const size_t first, Logger* logger) {
+            for (size_t i = first; i < m_additionalSearchPaths.size(); ++i) {
+                const IO::Path& searchPath = m_additionalSearchPaths[i];
+                addSearchPath(searchPath, logger);
+                addPackages(m_gamePath + searchPath);
+                m_additionalFileSystemCounts.push_back(m_gameFS.fileSystemCount());
             }
         }
 
@@ -111,14 +139,31 @@ namespace TrenchBroom {
 
         void GameImpl::doSetGamePath(const IO::Path& gamePath, Logger* logger) {
             m_gamePath = gamePath;
-            m_gameFS.clear();
             initializeFileSystem(logger);
         }
 
         void GameImpl::doSetAdditionalSearchPaths(const IO::Path::List& searchPaths, Logger* logger) {
+            if (!m_gameFSMounted) {
+                m_additionalSearchPaths = searchPaths;
+                initializeFileSystem(logger);
+                return;
+            }
+
+            // keep the file systems of the game itself and of the unchanged leading search paths mounted
+            size_t unchanged = 0;
+            while (unchanged < m_additionalSearchPaths.size() && unchanged < searchPaths.size() &&
+                   m_additionalSearchPaths[unchanged] == searchPaths[unchanged]) {
+                ++unchanged;
+            }
+
+            const size_t keepCount = unchanged > 0 ? m_additionalFileSystemCounts[unchanged - 1] : m_baseFileSystemCount;
+            while (m_gameFS.fileSystemCount() > keepCount) {
+                m_gameFS.popFileSystem();
+            }
+            m_additionalFileSystemCounts.resize(unchanged);
+
             m_additionalSearchPaths = searchPaths;
-            m_gameFS.clear();
-            initializeFileSystem(logger);
+            mountAdditionalSearchPaths(unchanged, logger);
         }
 
         Game::PathErrors GameImpl::doCheckAdditionalSearchPaths(const IO::Path::List& searchPaths) const {
@@ -212,7 +257,7 @@ namespace TrenchBroom {
             const IO::Path::List paths = extractTextureCollections(node);
 
             const IO::Path::List fileSearchPaths = textureCollectionSearchPaths(documentPath);
-            IO::TextureLoader textureLoader(variables, m_gameFS, fileSearchPaths, m_config.textureConfig());
+            IO::TextureLoader textureLoader(variables, m_gameFS, fileSearchPaths, m_config.textureConfig(), assetCache());
             textureLoader.loadTextures(paths, textureManager);
         }
 
@@ -224,6 +269,27 @@ namespace TrenchBroom {
             return result;
         }
 
+        // shared by all games so that its size accounting covers all entries
+        static IO::AssetCache& sharedAssetCache() {
+            static IO::AssetCache cache(IO::SystemPaths::userDataDirectory() + IO::Path("Cache"), 0);
+            return cache;
+        }
+
+        IO::AssetCache* GameImpl::assetCache() const {
+            if (!isAssetCacheEnabled())
+                return nullptr;
+
+            IO::AssetCache& cache = sharedAssetCache();
+            const size_t maxSize = static_cast<size_t>(std::max(0, pref(Preferences::AssetCacheMaxSize))) * 1024u * 1024u;
+            if (cache.maxSize() != maxSize)
+                cache.setMaxSize(maxSize);
+            return &cache;
+        }
+
+        IO::AssetCache* GameImpl::entityModelCache() const {
+            return isAssetCacheEnabled() ? &sharedAssetCache() : nullptr;
+        }
+
         bool GameImpl::doIsTextureCollection(const IO::Path& path) const {
             const GameConfig::TexturePackageConfig packageConfig = m_config.textureConfig().package;
             switch (packageConfig.type) {
@@ -281,15 +347,27 @@ namespace TrenchBroom {
             const String extension = path.extension();
             const Color& defaultColor = m_config.entityConfig().defaultColor;
 
+            IO::AssetCache* cache = assetCache();
+
             Assets::EntityDefinitionList definitions;
             if (StringUtils::caseInsensitiveEqual("fgd", extension)) {
                 const IO::MappedFile::Ptr file = IO::Disk::openFile(IO::Disk::fixPath(path));
                 IO::FgdParser parser(file->begin(), file->end(), defaultColor, file->path());
-                definitions = parser.parseDefinitions(status);
+                if (cache == nullptr) {
+                    definitions = parser.parseDefinitions(status);
+                } else {
+                    IO::EntityDefinitionCache definitionCache(*cache);
+                    definitions = definitionCache.loadFgdDefinitions(IO::EntityDefinitionCache::createKey(*file, defaultColor), parser, status);
+                }
             } else if (StringUtils::caseInsensitiveEqual("def", extension)) {
                 const IO::MappedFile::Ptr file = IO::Disk::openFile(IO::Disk::fixPath(path));
                 IO::DefParser parser(file->begin(), file->end(), defaultColor);
-                definitions = parser.parseDefinitions(status);
+                if (cache == nullptr) {
+                    definitions = parser.parseDefinitions(status);
+                } else {
+                    IO::EntityDefinitionCache definitionCache(*cache);
+                    definitions = definitionCache.loadDefDefinitions(IO::EntityDefinitionCache::createKey(*file, defaultColor), parser, status);
+                }
             } else {
                 throw GameException("Unknown entity definition format: '" + path.asString() + "'");
             }
@@ -364,21 +442,51 @@ namespace TrenchBroom {
             const Assets::Palette palette = loadTexturePalette();
 
             IO::Bsp29Parser parser(name, file->begin(), file->end(), palette);
-            return parser.parseModel();
+            IO::AssetCache* cache = entityModelCache();
+            if (cache == nullptr)
+                return parser.parseModel();
+
+            IO::EntityModelCache modelCache(*cache, m_gameFS);
+            return modelCache.loadBspModel(entityModelCacheKey("bsp", *file), name, parser);
         }
 
         Assets::EntityModel* GameImpl::loadMdlModel(const String& name, const IO::MappedFile::Ptr& file) const {
             const Assets::Palette palette = loadTexturePalette();
 
-            IO::MdlParser parser(name, file->begin(), file->end(), palette);
-            return parser.parseModel();
+            IO::MdlParser parser(name, file, palette);
+            IO::AssetCache* cache = entityModelCache();
+            if (cache == nullptr)
+                return parser.parseModel();
+
+            IO::EntityModelCache modelCache(*cache, m_gameFS);
+            return modelCache.loadMdlModel(entityModelCacheKey("mdl", *file), name, parser);
         }
 
         Assets::EntityModel* GameImpl::loadMd2Model(const String& name, const IO::MappedFile::Ptr& file) const {
             const Assets::Palette palette = loadTexturePalette();
 
-            IO::Md2Parser parser(name, file->begin(), file->end(), palette, m_gameFS);
-            return parser.parseModel();
+            IO::Md2Parser parser(name, file, palette, m_gameFS);
+            IO::AssetCache* cache = entityModelCache();
+            if (cache == nullptr)
+                return parser.parseModel();
+
+            IO::EntityModelCache modelCache(*cache, m_gameFS);
+            return modelCache.loadMd2Model(entityModelCacheKey("md2", *file), name, parser);
+        }
+
+        IO::AssetCache::Key GameImpl::entityModelCacheKey(const String& format, const IO::MappedFile& file) const {
+            IO::AssetCache::Key key = IO::EntityModelCache::createKey(format, file);
+
+            // the skins are converted using the palette
+            const IO::Path& palettePath = m_config.textureConfig().palette;
+            if (!palettePath.isEmpty()) {
+                try {
+                    const IO::MappedFile::Ptr paletteFile = m_gameFS.openFile(palettePath);
+                    key.appendContents(paletteFile->begin(), paletteFile->end());
+                } catch (const FileSystemException&) {
+                } catch (const FileNotFoundException&) {}
+            }
+            return key;
         }
 
         Assets::Palette GameImpl::loadTexturePalette() const {
@@ -23,6 +23,7 @@
 #include "TrenchBroom.h"
 #include "SharedPointer.h"
 #include "Assets/AssetTypes.h"
+#include "IO/AssetCache.h"
 #include "IO/FileSystemHierarchy.h"
 #include "Model/Game.h"
 #include "Model/GameConfig.h"
@@ -30,7 +31,7 @@
 
 namespace TrenchBroom {
     class Logger;
-    
+
     namespace Model {
         class GameImpl : public Game {
         private:
@@ -39,10 +40,16 @@ namespace TrenchBroom {
             IO::Path::List m_additionalSearchPaths;
             
             IO::FileSystemHierarchy m_gameFS;
+            bool m_gameFSMounted;
+            // the number of file systems of the game itself, the file systems of the mods are mounted on top of these
+            size_t m_baseFileSystemCount;
+            // the number of file systems mounted after mounting each additional search path
+            std::vector<size_t> m_additionalFileSystemCounts;
         public:
             GameImpl(GameConfig& config, const IO::Path& gamePath, Logger* logger);
         private:
             void initializeFileSystem(Logger* logger);
+            void mountAdditionalSearchPaths(size_t first, Logger* logger);
             void addSearchPath(const IO::Path& searchPath, Logger* logger);
             void addPackages(const IO::Path& searchPath);
         private:
@@ -70,6 +77,13 @@ namespace TrenchBroom {
             TexturePackageType doTexturePackageType() const override;
             void doLoadTextureCollections(AttributableNode* node, const IO::Path& documentPath, Assets::TextureManager& textureManager) const override;
             IO::Path::List textureCollectionSearchPaths(const IO::Path& documentPath) const;
+            IO::AssetCache* assetCache() const;
+
+            /**
+             * Returns the asset cache if it is enabled. Unlike assetCache(), this does not update the maximum size of
+             * the cache, so it can be called from the threads that load entity models.
+             */
+            IO::AssetCache* entityModelCache() const;
             
             bool doIsTextureCollection(const IO::Path& path) const override;
             IO::Path::List doFindTextureCollections() const override;
@@ -87,6 +101,7 @@ namespace TrenchBroom {
             Assets::EntityModel* loadBspModel(const String& name, const IO::MappedFile::Ptr& file) const;
             Assets::EntityModel* loadMdlModel(const String& name, const IO::MappedFile::Ptr& file) const;
             Assets::EntityModel* loadMd2Model(const String& name, const IO::MappedFile::Ptr& file) const;
+            IO::AssetCache::Key entityModelCacheKey(const String& format, const IO::MappedFile& file) const;
             Assets::Palette loadTexturePalette() const;
             
             const BrushContentType::List& doBrushContentTypes() const override;
@@ -19,19 +19,26 @@
 
 #include "World.h"
 
+#include "ParallelUtils.h"
 #include "Model/AssortNodesVisitor.h"
 #include "Model/Brush.h"
 #include "Model/BrushFace.h"
 #include "Model/CollectNodesWithDescendantSelectionCountVisitor.h"
+#include "Model/EditorContext.h"
 #include "Model/IssueGenerator.h"
 
+#include <set>
+#include <utility>
+#include <vector>
+
 namespace TrenchBroom {
     namespace Model {
         World::World(MapFormat::Type mapFormat, const BrushContentTypeBuilder* brushContentTypeBuilder, const vm::bbox3& worldBounds) :
         m_factory(mapFormat, brushContentTypeBuilder),
         m_defaultLayer(nullptr),
         // m_nodeTree(VecCodeComputer<vm::vec3>(worldBounds)),
-        m_updateNodeTree(true) {
+        m_updateNodeTree(true),
+        m_updateAttributableIndex(true) {
             addOrUpdateAttribute(AttributeNames::Classname, AttributeValues::WorldspawnClassname);
             createDefaultLayer(worldBounds);
         }
@@ -63,6 +70,35 @@ namespace TrenchBroom {
             return m_attributableIndex;
         }
 
+        class World::CollectAttributableNodes : public NodeVisitor {
+        private:
+            AttributableNodeList m_nodes;
+        public:
+            const AttributableNodeList& nodes() const { return m_nodes; }
+        private:
+            void doVisit(World* world) override   { m_nodes.push_back(world);  }
+            void doVisit(Layer* layer) override   {}
+            void doVisit(Group* group) override   {}
+            void doVisit(Entity* entity) override { m_nodes.push_back(entity); }
+            void doVisit(Brush* brush) override   {}
+        };
+
+        void World::disableAttributableIndexUpdates() {
+            m_updateAttributableIndex = false;
+        }
+
+        void World::enableAttributableIndexUpdates() {
+            m_updateAttributableIndex = true;
+        }
+
+        void World::rebuildAttributableIndex() {
+            CollectAttributableNodes collect;
+            acceptAndRecurse(collect);
+
+            m_attributableIndex.build(collect.nodes());
+            AttributableNode::rebuildLinks(collect.nodes());
+        }
+
         const IssueGeneratorList& World::registeredIssueGenerators() const {
             return m_issueGeneratorRegistry.registeredGenerators();
         }
@@ -159,6 +195,57 @@ namespace TrenchBroom {
             m_nodeTree.clearAndBuild(collect.nodes(), [](const auto* node){ return node->bounds(); });
         }
 
+        NodeList World::findNodesIntersecting(const vm::bbox3& bounds) const {
+            NodeList result;
+            m_nodeTree.findIntersectors(bounds, std::back_inserter(result));
+            return result;
+        }
+
+        NodeList World::findNodesTouching(const BrushList& brushes, const EditorContext& editorContext) const {
+            return findNodesRelatedTo(brushes, editorContext, [](const Brush* brush, const Node* node) {
+                return brush->intersects(node);
+            });
+        }
+
+        NodeList World::findNodesContainedIn(const BrushList& brushes, const EditorContext& editorContext) const {
+            return findNodesRelatedTo(brushes, editorContext, [](const Brush* brush, const Node* node) {
+                return brush->contains(node);
+            });
+        }
+
+        /**
+         * Both touching and contained nodes must intersect the bounds of the brush, so we find candidate pairs in the
+         * node tree and only run the exact test on those. The exact tests are independent of each other and run in
+         * parallel.
+         */
+        template <typename P>
+        NodeList World::findNodesRelatedTo(const BrushList& brushes, const EditorContext& editorContext, const P& related) const {
+            std::vector<std::pair<const Brush*, Node*>> candidates;
+            for (const Brush* brush : brushes) {
+                for (Node* node : findNodesIntersecting(brush->bounds())) {
+                    if (node != brush && editorContext.selectable(node)) {
+                        // the bounds of groups and entities are computed lazily, so do it here and not in the workers
+                        node->bounds();
+                        candidates.emplace_back(brush, node);
+                    }
+                }
+            }
+
+            std::vector<char> matches(candidates.size(), 0);
+            ParallelUtils::parallelFor(candidates.size(), [&](const size_t i) {
+                matches[i] = related(candidates[i].first, candidates[i].second) ? 1 : 0;
+            });
+
+            NodeList result;
+            std::set<Node*> added;
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (matches[i] && added.insert(candidates[i].second).second) {
+                    result.push_back(candidates[i].second);
+                }
+            }
+            return result;
+        }
+
         class World::InvalidateAllIssuesVisitor : public NodeVisitor {
         private:
             void doVisit(World* world) override   { invalidateIssues(world);  }
@@ -299,19 +386,23 @@ namespace TrenchBroom {
         }
         
         void World::doFindAttributableNodesWithAttribute(const AttributeName& name, const AttributeValue& value, AttributableNodeList& result) const {
-            VectorUtils::append(result, m_attributableIndex.findAttributableNodes(AttributableNodeIndexQuery::exact(name), value));
+            if (m_updateAttributableIndex)
+                VectorUtils::append(result, m_attributableIndex.findAttributableNodes(AttributableNodeIndexQuery::exact(name), value));
         }
         
         void World::doFindAttributableNodesWithNumberedAttribute(const AttributeName& prefix, const AttributeValue& value, AttributableNodeList& result) const {
-            VectorUtils::append(result, m_attributableIndex.findAttributableNodes(AttributableNodeIndexQuery::numbered(prefix), value));
+            if (m_updateAttributableIndex)
+                VectorUtils::append(result, m_attributableIndex.findAttributableNodes(AttributableNodeIndexQuery::numbered(prefix), value));
         }
         
         void World::doAddToIndex(AttributableNode* attributable, const AttributeName& name, const AttributeValue& value) {
-            m_attributableIndex.addAttribute(attributable, name, value);
+            if (m_updateAttributableIndex)
+                m_attributableIndex.addAttribute(attributable, name, value);
         }
         
         void World::doRemoveFromIndex(AttributableNode* attributable, const AttributeName& name, const AttributeValue& value) {
-            m_attributableIndex.removeAttribute(attributable, name, value);
+            if (m_updateAttributableIndex)
+                m_attributableIndex.removeAttribute(attributable, name, value);
         }
 
         void World::doAttributesDidChange(const vm::bbox3& oldBounds) {}
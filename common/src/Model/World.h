@@ -33,6 +33,7 @@
 namespace TrenchBroom {
     namespace Model {
         class BrushContentTypeBuilder;
+        class EditorContext;
         class PickResult;
         
         class World : public AttributableNode, public ModelFactory {
@@ -45,6 +46,7 @@ namespace TrenchBroom {
             using NodeTree = AABBTree<FloatType, 3, Node*>;
             NodeTree m_nodeTree;
             bool m_updateNodeTree;
+            bool m_updateAttributableIndex;
         public:
             World(MapFormat::Type mapFormat, const BrushContentTypeBuilder* brushContentTypeBuilder, const vm::bbox3& worldBounds);
         public: // layer management
@@ -55,6 +57,21 @@ namespace TrenchBroom {
             void createDefaultLayer(const vm::bbox3& worldBounds);
         public: // index
             const AttributableNodeIndex& attributableNodeIndex() const;
+        private:
+            class CollectAttributableNodes;
+        public: // index bulk updating
+            /**
+             * Stops updating the attribute index when attributes are added or removed. Until the index is rebuilt,
+             * searching it finds nothing, so nodes that are added in the meantime are not linked either.
+             */
+            void disableAttributableIndexUpdates();
+            void enableAttributableIndexUpdates();
+
+            /**
+             * Builds the attribute index from the attributes of all nodes of this world and links all nodes. This
+             * must be called before updates are enabled again if they were disabled while nodes were added.
+             */
+            void rebuildAttributableIndex();
         public: // selection
             // issue generator registration
             const IssueGeneratorList& registeredIssueGenerators() const;
@@ -70,6 +87,29 @@ namespace TrenchBroom {
             void disableNodeTreeUpdates();
             void enableNodeTreeUpdates();
             void rebuildNodeTree();
+        public: // node tree queries
+            NodeList findNodesIntersecting(const vm::bbox3& bounds) const;
+
+            /**
+             * Finds every selectable node that touches any of the given brushes. A node never touches itself.
+             *
+             * @param brushes the brushes to test against
+             * @param editorContext the editor context that determines which nodes are selectable
+             * @return the touching nodes, without duplicates
+             */
+            NodeList findNodesTouching(const BrushList& brushes, const EditorContext& editorContext) const;
+
+            /**
+             * Finds every selectable node that is contained in any of the given brushes. A node never contains itself.
+             *
+             * @param brushes the brushes to test against
+             * @param editorContext the editor context that determines which nodes are selectable
+             * @return the contained nodes, without duplicates
+             */
+            NodeList findNodesContainedIn(const BrushList& brushes, const EditorContext& editorContext) const;
+        private:
+            template <typename P>
+            NodeList findNodesRelatedTo(const BrushList& brushes, const EditorContext& editorContext, const P& related) const;
         private:
             class InvalidateAllIssuesVisitor;
             void invalidateAllIssues();
@@ -21,10 +21,12 @@
 #define NodeTree_h
 
 #include <vecmath/bbox.h>
+#include <vecmath/plane.h>
 #include <vecmath/ray.h>
 
 #include <functional>
 #include <list>
+#include <vector>
 
 template <typename T, size_t S, typename U, typename Cmp = std::less<U>>
 class NodeTree {
@@ -130,6 +132,26 @@ public:
      */
     virtual List findIntersectors(const vm::ray<T,S>& ray) const = 0;
 
+    /**
+     * Finds every data item in this tree whose bounding box intersects with the given box and retuns a list of those items.
+     *
+     * @param box the box to test
+     * @return a list containing all found data items
+     */
+    virtual List findIntersectors(const Box& box) const = 0;
+
+    /**
+     * Finds every data item in this tree whose bounding box may intersect with the convex volume bounded by the given
+     * planes and returns a list of those items. The volume is the intersection of the half spaces below the planes.
+     *
+     * The test is conservative, so the result may contain items whose bounding box is close to, but not within, the
+     * given volume.
+     *
+     * @param planes the planes bounding the convex volume
+     * @return a list containing all found data items
+     */
+    virtual List findIntersectors(const std::vector<vm::plane<T,S>>& planes) const = 0;
+
     /**
      * Finds every data item in this tree whose bounding box contains the given point and returns a list of those items.
      *
@@ -0,0 +1,133 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_ParallelUtils_h
+#define TrenchBroom_ParallelUtils_h
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ParallelUtils {
+    /**
+     * Returns the number of threads that should be used to process the given number of tasks. This is never more
+     * than the number of tasks and never more than the number of hardware threads.
+     *
+     * @param taskCount the number of tasks
+     * @return the number of threads to use
+     */
+    inline size_t threadCount(const size_t taskCount) {
+        const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        return std::min(hardwareThreads, taskCount);
+    }
+
+    /**
+     * Calls the given function once for every index in [0, count), distributing the calls among a number of
+     * worker threads. The calling thread participates in the work, and this function returns only after all calls
+     * have completed.
+     *
+     * The given function must be safe to call concurrently for distinct indices. If any call throws an exception,
+     * the remaining indices are skipped and the first exception is rethrown on the calling thread.
+     *
+     * @tparam F the function type, must accept a size_t argument
+     * @param count the number of indices
+     * @param func the function to call
+     */
+    template <typename F>
+    void parallelFor(const size_t count, const F& func) {
+        const size_t threads = threadCount(count);
+        if (threads <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> nextIndex(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr exception;
+        std::mutex exceptionMutex;
+
+        const auto work = [&]() {
+            size_t i;
+            while (!failed && (i = nextIndex++) < count) {
+                try {
+                    func(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    if (!failed.exchange(true)) {
+                        exception = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (size_t i = 0; i < threads - 1; ++i) {
+            workers.emplace_back(work);
+        }
+
+        work();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    /**
+     * Applies the given function to every element of the given range in parallel and returns the results in the
+     * order of the corresponding input elements.
+     *
+     * @tparam I the input iterator type, must be a random access iterator
+     * @tparam F the function type
+     * @param begin the start of the range
+     * @param end the end of the range
+     * @param func the function to apply
+     * @return a vector containing the results
+     */
+    template <typename I, typename F>
+    auto parallelTransform(I begin, I end, const F& func) {
+        using R = std::decay_t<decltype(func(*begin))>;
+
+        const auto count = static_cast<size_t>(std::distance(begin, end));
+        std::vector<R> result(count);
+        parallelFor(count, [&](const size_t i) {
+            result[i] = func(*(begin + static_cast<typename std::iterator_traits<I>::difference_type>(i)));
+        });
+        return result;
+    }
+
+    template <typename C, typename F>
+    auto parallelTransform(const C& collection, const F& func) {
+        return parallelTransform(std::begin(collection), std::end(collection), func);
+    }
+}
+
+#endif /* TrenchBroom_ParallelUtils_h */
@@ -408,6 +408,10 @@ public: // Convex hull; adding and removing points
 private:
     template <typename I> void addPoints(I cur, I end);
     template <typename I> void addPoints(I cur, I end, Callback& callback);
+
+    class ConflictCallback;
+    static std::vector<V> selectInitialPoints(const std::vector<V>& points);
+    void addPointsToPolyhedron(typename std::vector<V>::const_iterator cur, typename std::vector<V>::const_iterator end, Callback& callback);
 public:
     Vertex* addPoint(const V& position);
     Vertex* addPoint(const V& position, Callback& callback);
@@ -457,6 +461,11 @@ private:
     
     class ShiftSeamForWeaving;
     Vertex* weave(Seam seam, const V& position, Callback& callback);
+public: // Moving vertices
+    bool canMoveVerticesPreservingTopology(const std::vector<V>& positions, const V& delta) const;
+    void moveVerticesPreservingTopology(const std::vector<V>& positions, const V& delta);
+private:
+    std::pair<bool, VertexSet> findVerticesByPositions(const std::vector<V>& positions) const;
 public: // Clipping
     struct ClipResult {
         typedef enum {
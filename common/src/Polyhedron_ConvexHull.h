@@ -26,7 +26,12 @@
 #include <vecmath/constants.h>
 #include <vecmath/util.h>
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 template <typename T, typename FP, typename VP>
 class Polyhedron<T,FP,VP>::Seam {
@@ -175,14 +180,270 @@ void Polyhedron<T,FP,VP>::addPoints(const std::vector<V>& points, Callback& call
 template <typename T, typename FP, typename VP> template <typename I>
 void Polyhedron<T,FP,VP>::addPoints(I cur, I end) {
     Callback c;
-    while (cur != end)
-        addPoint(*cur++, c);
+    addPoints(cur, end, c);
 }
 
 template <typename T, typename FP, typename VP> template <typename I>
 void Polyhedron<T,FP,VP>::addPoints(I cur, I end, Callback& callback) {
-    while (cur != end)
-        addPoint(*cur++, callback);
+    const std::vector<V> points(cur, end);
+
+    // For the small number of points that make up a typical brush, adding the points one by one is faster than
+    // maintaining the conflict lists.
+    static const size_t MinPointsForConflictLists = 16;
+    if (points.size() < MinPointsForConflictLists) {
+        for (const auto& point : points) {
+            addPoint(point, callback);
+        }
+        return;
+    }
+
+    // Start with a large initial polyhedron so that as many points as possible can be discarded right away.
+    if (empty()) {
+        for (const auto& point : selectInitialPoints(points)) {
+            addPoint(point, callback);
+        }
+    }
+
+    auto it = std::begin(points);
+    while (it != std::end(points) && !polyhedron()) {
+        addPoint(*it++, callback);
+    }
+
+    if (it != std::end(points)) {
+        addPointsToPolyhedron(it, std::end(points), callback);
+    }
+}
+
+/*
+ Selects up to four extreme points from the given points: the minimum and maximum points along the axis of greatest
+ extent, the point farthest from the line through these, and the point farthest from the plane through the first three.
+ */
+template <typename T, typename FP, typename VP>
+std::vector<typename Polyhedron<T,FP,VP>::V> Polyhedron<T,FP,VP>::selectInitialPoints(const std::vector<V>& points) {
+    assert(!points.empty());
+
+    size_t minIndex[3] = { 0, 0, 0 };
+    size_t maxIndex[3] = { 0, 0, 0 };
+    for (size_t i = 1; i < points.size(); ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            if (points[i][j] < points[minIndex[j]][j]) {
+                minIndex[j] = i;
+            }
+            if (points[i][j] > points[maxIndex[j]][j]) {
+                maxIndex[j] = i;
+            }
+        }
+    }
+
+    size_t axis = 0;
+    for (size_t j = 1; j < 3; ++j) {
+        if (points[maxIndex[j]][j] - points[minIndex[j]][j] > points[maxIndex[axis]][axis] - points[minIndex[axis]][axis]) {
+            axis = j;
+        }
+    }
+
+    const auto& p1 = points[minIndex[axis]];
+    const auto& p2 = points[maxIndex[axis]];
+
+    const auto farthest = [&](const auto& distance) {
+        size_t result = 0;
+        T maxDistance = distance(points[0]);
+        for (size_t i = 1; i < points.size(); ++i) {
+            const auto current = distance(points[i]);
+            if (current > maxDistance) {
+                maxDistance = current;
+                result = i;
+            }
+        }
+        return result;
+    };
+
+    const auto& p3 = points[farthest([&](const V& p) { return vm::squaredLength(vm::cross(p - p1, p2 - p1)); })];
+    const auto normal = vm::cross(p2 - p1, p3 - p1);
+    const auto& p4 = points[farthest([&](const V& p) { return std::abs(vm::dot(p - p1, normal)); })];
+
+    return std::vector<V>({ p1, p2, p3, p4 });
+}
+
+/*
+ Forwards all events to the given callback and maintains the conflict lists, that is, for each face, the points that
+ have not yet been added and that are above that face. When a face is deleted, its conflict list is orphaned and must
+ be redistributed among the faces that were created.
+ */
+template <typename T, typename FP, typename VP>
+class Polyhedron<T,FP,VP>::ConflictCallback : public Polyhedron<T,FP,VP>::Callback {
+public:
+    using ConflictList = std::vector<V>;
+    using ConflictMap = std::unordered_map<Face*, ConflictList>;
+private:
+    Callback& m_callback;
+    ConflictMap m_conflicts;
+    std::vector<Face*> m_createdFaces;
+    ConflictList m_orphans;
+public:
+    explicit ConflictCallback(Callback& callback) :
+    m_callback(callback) {}
+
+    ConflictMap& conflicts() {
+        return m_conflicts;
+    }
+
+    const std::vector<Face*>& createdFaces() const {
+        return m_createdFaces;
+    }
+
+    ConflictList& orphans() {
+        return m_orphans;
+    }
+
+    void reset() {
+        m_createdFaces.clear();
+        m_orphans.clear();
+    }
+
+    void vertexWasCreated(Vertex* vertex) override {
+        m_callback.vertexWasCreated(vertex);
+    }
+
+    void vertexWillBeDeleted(Vertex* vertex) override {
+        m_callback.vertexWillBeDeleted(vertex);
+    }
+
+    void vertexWasAdded(Vertex* vertex) override {
+        m_callback.vertexWasAdded(vertex);
+    }
+
+    void vertexWillBeRemoved(Vertex* vertex) override {
+        m_callback.vertexWillBeRemoved(vertex);
+    }
+
+    vm::plane<T,3> getPlane(const Face* face) const override {
+        return m_callback.getPlane(face);
+    }
+
+    void faceWasCreated(Face* face) override {
+        m_createdFaces.push_back(face);
+        m_callback.faceWasCreated(face);
+    }
+
+    void faceWillBeDeleted(Face* face) override {
+        orphan(face);
+        m_callback.faceWillBeDeleted(face);
+    }
+
+    void faceDidChange(Face* face) override {
+        m_callback.faceDidChange(face);
+    }
+
+    void faceWasFlipped(Face* face) override {
+        m_callback.faceWasFlipped(face);
+    }
+
+    void faceWasSplit(Face* original, Face* clone) override {
+        m_callback.faceWasSplit(original, clone);
+    }
+
+    void facesWillBeMerged(Face* remaining, Face* toDelete) override {
+        orphan(toDelete);
+        m_callback.facesWillBeMerged(remaining, toDelete);
+    }
+private:
+    void orphan(Face* face) {
+        auto it = m_conflicts.find(face);
+        if (it != std::end(m_conflicts)) {
+            VectorUtils::append(m_orphans, it->second);
+            m_conflicts.erase(it);
+        }
+    }
+};
+
+/*
+ Adds the given points to this polyhedron using the quickhull algorithm. Every point is assigned to the conflict list
+ of a face that it is above of, and points that are not above any face are discarded since they are contained in the
+ polyhedron. Then the point that is farthest above its face is added, and the points that were assigned to the faces
+ that were deleted in the process are redistributed. This is repeated until all conflict lists are empty.
+ */
+template <typename T, typename FP, typename VP>
+void Polyhedron<T,FP,VP>::addPointsToPolyhedron(typename std::vector<V>::const_iterator cur, typename std::vector<V>::const_iterator end, Callback& callback) {
+    assert(polyhedron());
+
+    ConflictCallback conflictCallback(callback);
+    auto& conflicts = conflictCallback.conflicts();
+
+    const auto assign = [&](const V& point, const std::vector<Face*>& candidates) {
+        for (Face* face : candidates) {
+            if (face->pointStatus(point) == vm::point_status::above) {
+                conflicts[face].push_back(point);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<Face*> allFaces;
+    const auto collectAllFaces = [&]() {
+        allFaces.clear();
+        Face* firstFace = m_faces.front();
+        Face* currentFace = firstFace;
+        do {
+            allFaces.push_back(currentFace);
+            currentFace = currentFace->next();
+        } while (currentFace != firstFace);
+    };
+
+    collectAllFaces();
+    while (cur != end) {
+        assign(*cur++, allFaces);
+    }
+
+    while (true) {
+        // Find the first face with a non-empty conflict list, visiting the faces in a deterministic order.
+        Face* face = nullptr;
+        Face* firstFace = m_faces.front();
+        Face* currentFace = firstFace;
+        do {
+            const auto it = conflicts.find(currentFace);
+            if (it != std::end(conflicts) && !it->second.empty()) {
+                face = currentFace;
+                break;
+            }
+            currentFace = currentFace->next();
+        } while (currentFace != firstFace);
+
+        if (face == nullptr) {
+            break;
+        }
+
+        auto& conflictList = conflicts[face];
+        const auto normal = face->normal();
+        const auto& origin = face->origin();
+
+        auto farthest = std::begin(conflictList);
+        for (auto it = std::next(farthest); it != std::end(conflictList); ++it) {
+            if (vm::dot(*it - origin, normal) > vm::dot(*farthest - origin, normal)) {
+                farthest = it;
+            }
+        }
+
+        const V point = *farthest;
+        *farthest = conflictList.back();
+        conflictList.pop_back();
+
+        conflictCallback.reset();
+        addPoint(point, conflictCallback);
+
+        // Points that were above a deleted face are usually above one of the created faces. If not, we check all faces
+        // to be safe and discard the point if it is not above any of them.
+        if (!conflictCallback.orphans().empty()) {
+            const auto& orphans = conflictCallback.orphans();
+            collectAllFaces();
+            for (const auto& orphan : orphans) {
+                if (!assign(orphan, conflictCallback.createdFaces())) {
+                    assign(orphan, allFaces);
+                }
+            }
+        }
+    }
 }
 
 template <typename T, typename FP, typename VP>
@@ -29,7 +29,10 @@
 #include <vecmath/scalar.h>
 #include <vecmath/util.h>
 
+#include <algorithm>
 #include <map>
+#include <tuple>
+#include <utility>
 
 template <typename T, typename FP, typename VP>
 class Polyhedron<T,FP,VP>::VertexDistanceCmp {
@@ -1129,6 +1132,107 @@ void Polyhedron<T,FP,VP>::correctVertexPositions(const size_t decimals, const T
     updateBounds();
 }
 
+/*
+ Checks whether the vertices at the given positions can be moved by the given delta without changing the topology of
+ this polyhedron. This is the case if every face remains planar and every vertex that does not belong to a face
+ remains strictly below that face, i.e., the polyhedron remains convex and no faces become coplanar. If this check
+ succeeds, the convex hull of the moved vertices has exactly the same vertices, edges and faces as this polyhedron, so
+ the vertices can be moved in place instead of building a new convex hull.
+ */
+template <typename T, typename FP, typename VP>
+bool Polyhedron<T,FP,VP>::canMoveVerticesPreservingTopology(const std::vector<V>& positions, const V& delta) const {
+    if (!polyhedron()) {
+        return false;
+    }
+
+    const auto found = findVerticesByPositions(positions);
+    if (!found.first) {
+        return false;
+    }
+
+    const auto& movingVertices = found.second;
+    const auto newPosition = [&](const Vertex* vertex) {
+        const auto& position = vertex->position();
+        return movingVertices.count(const_cast<Vertex*>(vertex)) ? position + delta : position;
+    };
+
+    std::vector<const Vertex*> faceVertices;
+    const Face* firstFace = m_faces.front();
+    const Face* currentFace = firstFace;
+    do {
+        faceVertices.clear();
+        const HalfEdge* firstEdge = currentFace->boundary().front();
+        const HalfEdge* currentEdge = firstEdge;
+        do {
+            faceVertices.push_back(currentEdge->origin());
+            currentEdge = currentEdge->next();
+        } while (currentEdge != firstEdge);
+
+        // Find a valid plane for the moved face as in Callback::getPlane.
+        bool valid = false;
+        vm::plane<T,3> plane;
+        for (size_t i = 0; i < faceVertices.size() && !valid; ++i) {
+            const auto p1 = newPosition(faceVertices[i]);
+            const auto p2 = newPosition(faceVertices[(i + 1) % faceVertices.size()]);
+            const auto p3 = newPosition(faceVertices[(i + 2) % faceVertices.size()]);
+            std::tie(valid, plane) = fromPoints(p2, p1, p3);
+        }
+
+        if (!valid) {
+            return false;
+        }
+
+        for (const Vertex* vertex : faceVertices) {
+            if (plane.pointStatus(newPosition(vertex)) != vm::point_status::inside) {
+                return false;
+            }
+        }
+
+        const Vertex* firstVertex = m_vertices.front();
+        const Vertex* currentVertex = firstVertex;
+        do {
+            if (std::find(std::begin(faceVertices), std::end(faceVertices), currentVertex) == std::end(faceVertices) &&
+                plane.pointStatus(newPosition(currentVertex)) != vm::point_status::below) {
+                return false;
+            }
+            currentVertex = currentVertex->next();
+        } while (currentVertex != firstVertex);
+
+        currentFace = currentFace->next();
+    } while (currentFace != firstFace);
+
+    return true;
+}
+
+template <typename T, typename FP, typename VP>
+void Polyhedron<T,FP,VP>::moveVerticesPreservingTopology(const std::vector<V>& positions, const V& delta) {
+    assert(canMoveVerticesPreservingTopology(positions, delta));
+
+    // Find all vertices before moving any of them, otherwise a moved vertex could be mistaken for another one.
+    const auto [found, movingVertices] = findVerticesByPositions(positions);
+    assert(found); unused(found);
+
+    for (Vertex* vertex : movingVertices) {
+        vertex->setPosition(vertex->position() + delta);
+    }
+
+    updateBounds();
+    assert(checkInvariant());
+}
+
+template <typename T, typename FP, typename VP>
+std::pair<bool, typename Polyhedron<T,FP,VP>::VertexSet> Polyhedron<T,FP,VP>::findVerticesByPositions(const std::vector<V>& positions) const {
+    VertexSet result;
+    for (const auto& position : positions) {
+        Vertex* vertex = findVertexByPosition(position);
+        if (vertex == nullptr) {
+            return std::make_pair(false, VertexSet());
+        }
+        result.insert(vertex);
+    }
+    return std::make_pair(true, result);
+}
+
 template <typename T, typename FP, typename VP>
 bool Polyhedron<T,FP,VP>::healEdges(const T minLength) {
     Callback callback;
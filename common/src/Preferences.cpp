@@ -123,6 +123,9 @@ namespace TrenchBroom {
 
         Preference<bool> TextureLock(IO::Path("Editor/Texture lock"), true);
 
+        Preference<bool> AssetCacheEnabled(IO::Path("Cache/Enabled"), true);
+        Preference<int> AssetCacheMaxSize(IO::Path("Cache/Maximum size"), 1024);
+
         Preference<IO::Path>& RendererFontPath() {
             static Preference<IO::Path> fontPath(IO::Path("Renderer/Font name"), IO::Path("fonts/SourceSansPro-Regular.otf"));
             return fontPath;
@@ -119,6 +119,9 @@ namespace TrenchBroom {
         extern Preference<int> TextureMagFilter;
         
         extern Preference<bool> TextureLock;
+
+        extern Preference<bool> AssetCacheEnabled;
+        extern Preference<int> AssetCacheMaxSize; // in megabytes
         
         Preference<IO::Path>& RendererFontPath();
         extern Preference<int> RendererFontSize;
@@ -19,8 +19,11 @@
 
 #include "EntityLinkRenderer.h"
 
+#include "CollectionUtils.h"
 #include "Macros.h"
 #include "Model/AttributableNode.h"
+#include "Model/Brush.h"
+#include "Model/CollectAttributableNodesVisitor.h"
 #include "Model/CollectMatchingNodesVisitor.h"
 #include "Model/EditorContext.h"
 #include "Model/Entity.h"
@@ -39,10 +42,16 @@
 
 namespace TrenchBroom {
     namespace Renderer {
+        EntityLinkRenderer::Link::Link(Model::AttributableNode* i_target, const vm::vec3f& i_sourceAnchor, const vm::vec3f& i_targetAnchor) :
+        target(i_target),
+        sourceAnchor(i_sourceAnchor),
+        targetAnchor(i_targetAnchor) {}
+
         EntityLinkRenderer::EntityLinkRenderer(View::MapDocumentWPtr document) :
         m_document(document),
         m_defaultColor(0.5f, 1.0f, 0.5f, 1.0f),
         m_selectedColor(1.0f, 0.0f, 0.0f, 1.0f),
+        m_linksValid(false),
         m_valid(false) {}
         
         void EntityLinkRenderer::setDefaultColor(const Color& color) {
@@ -67,6 +76,65 @@ namespace TrenchBroom {
             m_valid = false;
         }
 
+        void EntityLinkRenderer::invalidateLinks() {
+            m_links.clear();
+            m_linkSources.clear();
+            m_invalidSources.clear();
+            m_linksValid = false;
+            invalidate();
+        }
+
+        /**
+         * Collects the entities whose links may have changed with the given nodes. Transforming a group only reports
+         * the group itself, so groups are searched for the entities they contain. Layers and the world are only
+         * reported as the parents of changed nodes, which are reported themselves, so they are not searched.
+         */
+        class EntityLinkRenderer::CollectChangedEntitiesVisitor : public Model::NodeVisitor {
+        private:
+            Model::AttributableNodeList m_nodes;
+            Model::AttributableNodeSet m_addedNodes;
+        public:
+            const Model::AttributableNodeList& nodes() const {
+                return m_nodes;
+            }
+        private:
+            void doVisit(Model::World* world) override   { addNode(world); stopRecursion(); }
+            void doVisit(Model::Layer* layer) override   { stopRecursion(); }
+            void doVisit(Model::Group* group) override   {}
+            void doVisit(Model::Entity* entity) override { addNode(entity); stopRecursion(); }
+            void doVisit(Model::Brush* brush) override   { addNode(brush->entity()); }
+
+            void addNode(Model::AttributableNode* node) {
+                if (node != nullptr && m_addedNodes.insert(node).second)
+                    m_nodes.push_back(node);
+            }
+        };
+
+        void EntityLinkRenderer::invalidateLinks(const Model::NodeList& nodes) {
+            if (m_linksValid) {
+                CollectChangedEntitiesVisitor collectEntities;
+                Model::Node::acceptAndRecurse(std::begin(nodes), std::end(nodes), collectEntities);
+
+                // The links to a node are stored with their sources. If its targetname has changed, then both its
+                // previous and its current sources must be updated.
+                for (Model::AttributableNode* node : collectEntities.nodes()) {
+                    m_invalidSources.insert(node);
+                    SetUtils::merge(m_invalidSources, linkSources(node));
+                    m_invalidSources.insert(std::begin(node->linkSources()), std::end(node->linkSources()));
+                    m_invalidSources.insert(std::begin(node->killSources()), std::end(node->killSources()));
+                }
+            }
+            invalidate();
+        }
+
+        EntityLinkRenderer::Vertex::List EntityLinkRenderer::linkVertices() {
+            validateLinks();
+
+            Vertex::List links;
+            getLinks(links);
+            return links;
+        }
+
         void EntityLinkRenderer::doPrepareVertices(Vbo& vertexVbo) {
             if (!m_valid) {
                 validate();
@@ -112,6 +180,8 @@ namespace TrenchBroom {
         }
 
         void EntityLinkRenderer::validate() {
+            validateLinks();
+
             Vertex::List links;
             getLinks(links);
 
@@ -173,141 +243,85 @@ namespace TrenchBroom {
         
         class EntityLinkRenderer::CollectEntitiesVisitor : public Model::CollectMatchingNodesVisitor<MatchEntities, Model::UniqueNodeCollectionStrategy> {};
 
-        class EntityLinkRenderer::CollectLinksVisitor : public Model::NodeVisitor {
-        protected:
-            const Model::EditorContext& m_editorContext;
+        class EntityLinkRenderer::UpdateLinksVisitor : public Model::NodeVisitor {
         private:
-            const Color& m_defaultColor;
-            const Color& m_selectedColor;
-            Vertex::List& m_links;
-        protected:
-            CollectLinksVisitor(const Model::EditorContext& editorContext, const Color& defaultColor, const Color& selectedColor, Vertex::List& links) :
-            m_editorContext(editorContext),
-            m_defaultColor(defaultColor),
-            m_selectedColor(selectedColor),
-            m_links(links) {}
+            EntityLinkRenderer& m_renderer;
+        public:
+            UpdateLinksVisitor(EntityLinkRenderer& renderer) :
+            m_renderer(renderer) {}
         private:
             void doVisit(Model::World* world) override   {}
             void doVisit(Model::Layer* layer) override   {}
             void doVisit(Model::Group* group) override   {}
             void doVisit(Model::Brush* brush) override   {}
             void doVisit(Model::Entity* entity) override {
-                if (m_editorContext.visible(entity))
-                    visitEntity(entity);
+                m_renderer.updateLinks(entity);
                 stopRecursion();
             }
-            
-            virtual void visitEntity(Model::Entity* entity) = 0;
-        protected:
-            void addLink(const Model::AttributableNode* source, const Model::AttributableNode* target) {
-                const auto anySelected = source->selected() || source->descendantSelected() || target->selected() || target->descendantSelected();
-                const auto& sourceColor = anySelected ? m_selectedColor : m_defaultColor;
-                const auto targetColor = anySelected ? m_selectedColor : m_defaultColor;
-                
-                m_links.push_back(Vertex(vm::vec3f(source->linkSourceAnchor()), sourceColor));
-                m_links.push_back(Vertex(vm::vec3f(target->linkTargetAnchor()), targetColor));
-            }
         };
-        
-        class EntityLinkRenderer::CollectAllLinksVisitor : public CollectLinksVisitor {
-        public:
-            CollectAllLinksVisitor(const Model::EditorContext& editorContext, const Color& defaultColor, const Color& selectedColor, Vertex::List& links) :
-            CollectLinksVisitor(editorContext, defaultColor, selectedColor, links) {}
-        private:
-            void visitEntity(Model::Entity* entity) override {
-                if (m_editorContext.visible(entity)) {
-                    addTargets(entity, entity->linkTargets());
-                    addTargets(entity, entity->killTargets());
-                }
-            }
-            
-            void addTargets(Model::Entity* source, const Model::AttributableNodeList& targets) {
-                for (const Model::AttributableNode* target : targets) {
-                    if (m_editorContext.visible(target))
-                        addLink(source, target);
-                }
-            }
-        };
-        
-        class EntityLinkRenderer::CollectTransitiveSelectedLinksVisitor : public CollectLinksVisitor {
-        private:
-            Model::NodeSet m_visited;
-        public:
-            CollectTransitiveSelectedLinksVisitor(const Model::EditorContext& editorContext, const Color& defaultColor, const Color& selectedColor, Vertex::List& links) :
-            CollectLinksVisitor(editorContext, defaultColor, selectedColor, links) {}
-        private:
-            void visitEntity(Model::Entity* entity) override {
-                if (m_editorContext.visible(entity)) {
-                    const bool visited = !m_visited.insert(entity).second;
-                    if (!visited) {
-                        addSources(entity->linkSources(), entity);
-                        addSources(entity->killSources(), entity);
-                        addTargets(entity, entity->linkTargets());
-                        addTargets(entity, entity->killTargets());
-                    }
-                }
-            }
 
-            void addSources(const Model::AttributableNodeList& sources, Model::Entity* target) {
-                for (Model::AttributableNode* source : sources) {
-                    if (m_editorContext.visible(source)) {
-                        addLink(source, target);
-                        source->accept(*this);
-                    }
-                }
-            }
-            
-            void addTargets(Model::Entity* source, const Model::AttributableNodeList& targets) {
-                for (Model::AttributableNode* target : targets) {
-                    if (m_editorContext.visible(target)) {
-                        addLink(source, target);
-                        target->accept(*this);
-                    }
-                }
-            }
-        };
-        
-        class EntityLinkRenderer::CollectDirectSelectedLinksVisitor : public CollectLinksVisitor {
-        public:
-            CollectDirectSelectedLinksVisitor(const Model::EditorContext& editorContext, const Color& defaultColor, const Color& selectedColor, Vertex::List& links) :
-            CollectLinksVisitor(editorContext, defaultColor, selectedColor, links) {}
-        private:
-            void visitEntity(Model::Entity* entity) override {
-                if (entity->selected() || entity->descendantSelected()) {
-                    addSources(entity->linkSources(), entity);
-                    addSources(entity->killSources(), entity);
-                    addTargets(entity, entity->linkTargets());
-                    addTargets(entity, entity->killTargets());
+        void EntityLinkRenderer::validateLinks() {
+            View::MapDocumentSPtr document = lock(m_document);
+            UpdateLinksVisitor updateLinks(*this);
+
+            if (!m_linksValid) {
+                Model::World* world = document->world();
+                if (world != nullptr)
+                    world->acceptAndRecurse(updateLinks);
+                m_linksValid = true;
+            } else {
+                for (Model::AttributableNode* source : m_invalidSources) {
+                    removeLinks(source);
+                    source->accept(updateLinks);
                 }
             }
-            
-            void addSources(const Model::AttributableNodeList& sources, Model::Entity* target) {
-                for (const Model::AttributableNode* source : sources) {
-                    if (!source->selected() && !source->descendantSelected() && m_editorContext.visible(source))
-                        addLink(source, target);
-                }
+            m_invalidSources.clear();
+        }
+
+        void EntityLinkRenderer::updateLinks(Model::Entity* source) {
+            const vm::vec3f sourceAnchor(source->linkSourceAnchor());
+
+            LinkList links;
+            for (Model::AttributableNode* target : source->linkTargets())
+                links.push_back(Link(target, sourceAnchor, vm::vec3f(target->linkTargetAnchor())));
+            for (Model::AttributableNode* target : source->killTargets())
+                links.push_back(Link(target, sourceAnchor, vm::vec3f(target->linkTargetAnchor())));
+
+            if (!links.empty()) {
+                for (const Link& link : links)
+                    m_linkSources[link.target].insert(source);
+                m_links[source] = std::move(links);
             }
-            
-            void addTargets(Model::Entity* source, const Model::AttributableNodeList& targets) {
-                for (const Model::AttributableNode* target : targets) {
-                    if (m_editorContext.visible(target))
-                        addLink(source, target);
+        }
+
+        void EntityLinkRenderer::removeLinks(Model::AttributableNode* source) {
+            const auto it = m_links.find(source);
+            if (it == std::end(m_links))
+                return;
+
+            for (const Link& link : it->second) {
+                const auto sourcesIt = m_linkSources.find(link.target);
+                if (sourcesIt != std::end(m_linkSources)) {
+                    sourcesIt->second.erase(source);
+                    if (sourcesIt->second.empty())
+                        m_linkSources.erase(sourcesIt);
                 }
             }
-        };
+            m_links.erase(it);
+        }
         
         void EntityLinkRenderer::getLinks(Vertex::List& links) const {
             View::MapDocumentSPtr document = lock(m_document);
             const Model::EditorContext& editorContext = document->editorContext();
             switch (editorContext.entityLinkMode()) {
                 case Model::EditorContext::EntityLinkMode_All:
-                    getAllLinks(links);
+                    getAllLinks(editorContext, links);
                     break;
                 case Model::EditorContext::EntityLinkMode_Transitive:
-                    getTransitiveSelectedLinks(links);
+                    getTransitiveSelectedLinks(editorContext, links);
                     break;
                 case Model::EditorContext::EntityLinkMode_Direct:
-                    getDirectSelectedLinks(links);
+                    getDirectSelectedLinks(editorContext, links);
                     break;
                 case Model::EditorContext::EntityLinkMode_None:
                     break;
@@ -315,42 +329,99 @@ namespace TrenchBroom {
             }
         }
         
-        void EntityLinkRenderer::getAllLinks(Vertex::List& links) const {
-            View::MapDocumentSPtr document = lock(m_document);
-            const Model::EditorContext& editorContext = document->editorContext();
-            
-            CollectAllLinksVisitor collectLinks(editorContext, m_defaultColor, m_selectedColor, links);
-            
-            Model::World* world = document->world();
-            if (world != nullptr)
-                world->acceptAndRecurse(collectLinks);
+        void EntityLinkRenderer::getAllLinks(const Model::EditorContext& editorContext, Vertex::List& links) const {
+            for (const auto& entry : m_links) {
+                if (editorContext.visible(entry.first)) {
+                    for (const Link& link : entry.second) {
+                        if (editorContext.visible(link.target))
+                            addLink(links, entry.first, link);
+                    }
+                }
+            }
         }
         
-        void EntityLinkRenderer::getTransitiveSelectedLinks(Vertex::List& links) const {
-            View::MapDocumentSPtr document = lock(m_document);
-            const Model::EditorContext& editorContext = document->editorContext();
-            
-            CollectTransitiveSelectedLinksVisitor visitor(editorContext, m_defaultColor, m_selectedColor, links);
-            collectSelectedLinks(visitor);
+        void EntityLinkRenderer::getTransitiveSelectedLinks(const Model::EditorContext& editorContext, Vertex::List& links) const {
+            // walk the link graph in both directions through visible nodes, adding the links of each reached node once
+            Model::AttributableNodeSet visited;
+            Model::AttributableNodeList stack;
+            for (Model::AttributableNode* entity : selectedEntities()) {
+                if (editorContext.visible(entity) && visited.insert(entity).second)
+                    stack.push_back(entity);
+            }
+
+            while (!stack.empty()) {
+                Model::AttributableNode* node = stack.back();
+                stack.pop_back();
+
+                for (const Link& link : this->links(node)) {
+                    if (editorContext.visible(link.target)) {
+                        addLink(links, node, link);
+                        if (visited.insert(link.target).second)
+                            stack.push_back(link.target);
+                    }
+                }
+                for (Model::AttributableNode* source : linkSources(node)) {
+                    if (editorContext.visible(source) && visited.insert(source).second)
+                        stack.push_back(source);
+                }
+            }
         }
         
-        void EntityLinkRenderer::getDirectSelectedLinks(Vertex::List& links) const {
-            View::MapDocumentSPtr document = lock(m_document);
-            const Model::EditorContext& editorContext = document->editorContext();
-            
-            CollectDirectSelectedLinksVisitor visitor(editorContext, m_defaultColor, m_selectedColor, links);
-            collectSelectedLinks(visitor);
+        void EntityLinkRenderer::getDirectSelectedLinks(const Model::EditorContext& editorContext, Vertex::List& links) const {
+            const Model::AttributableNodeList entities = selectedEntities();
+            const Model::AttributableNodeSet selected(std::begin(entities), std::end(entities));
+
+            for (Model::AttributableNode* entity : entities) {
+                if (!editorContext.visible(entity))
+                    continue;
+
+                for (const Link& link : this->links(entity)) {
+                    if (editorContext.visible(link.target))
+                        addLink(links, entity, link);
+                }
+
+                // links from selected sources are added with the links of their source
+                for (Model::AttributableNode* source : linkSources(entity)) {
+                    if (selected.count(source) == 0 && editorContext.visible(source)) {
+                        for (const Link& link : this->links(source)) {
+                            if (link.target == entity)
+                                addLink(links, source, link);
+                        }
+                    }
+                }
+            }
         }
 
-        void EntityLinkRenderer::collectSelectedLinks(CollectLinksVisitor& collectLinks) const {
+        Model::AttributableNodeList EntityLinkRenderer::selectedEntities() const {
             View::MapDocumentSPtr document = lock(m_document);
             
             const Model::NodeList& selectedNodes = document->selectedNodes().nodes();
             CollectEntitiesVisitor collectEntities;
             Model::Node::acceptAndEscalate(std::begin(selectedNodes), std::end(selectedNodes), collectEntities);
             
-            const Model::NodeList& selectedEntities = collectEntities.nodes();
-            Model::Node::accept(std::begin(selectedEntities), std::end(selectedEntities), collectLinks);
+            const Model::NodeList& entities = collectEntities.nodes();
+            Model::CollectAttributableNodesVisitor collectAttributables;
+            Model::Node::accept(std::begin(entities), std::end(entities), collectAttributables);
+            return collectAttributables.nodes();
+        }
+
+        const EntityLinkRenderer::LinkList& EntityLinkRenderer::links(Model::AttributableNode* source) const {
+            static const LinkList EmptyLinkList;
+            const auto it = m_links.find(source);
+            return it != std::end(m_links) ? it->second : EmptyLinkList;
+        }
+
+        const Model::AttributableNodeSet& EntityLinkRenderer::linkSources(Model::AttributableNode* target) const {
+            const auto it = m_linkSources.find(target);
+            return it != std::end(m_linkSources) ? it->second : Model::EmptyAttributableNodeSet;
+        }
+
+        void EntityLinkRenderer::addLink(Vertex::List& vertices, const Model::AttributableNode* source, const Link& link) const {
+            const auto anySelected = source->selected() || source->descendantSelected() || link.target->selected() || link.target->descendantSelected();
+            const auto& color = anySelected ? m_selectedColor : m_defaultColor;
+            
+            vertices.push_back(Vertex(link.sourceAnchor, color));
+            vertices.push_back(Vertex(link.targetAnchor, color));
         }
     }
 }
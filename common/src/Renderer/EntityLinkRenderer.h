@@ -28,6 +28,10 @@
 #include "View/ViewTypes.h"
 
 #include <vecmath/forward.h>
+#include <vecmath/vec.h>
+
+#include <map>
+#include <vector>
 
 namespace TrenchBroom {
     namespace Model {
@@ -39,8 +43,9 @@ namespace TrenchBroom {
         class RenderContext;
         
         class EntityLinkRenderer : public DirectRenderable {
-        private:
+        public:
             using Vertex = VertexSpecs::P3C4::Vertex;
+        private:
 
             using T03 = AttributeSpec<AttributeType_TexCoord0, GL_FLOAT, 3>;
             using T13 = AttributeSpec<AttributeType_TexCoord1, GL_FLOAT, 3>;
@@ -51,6 +56,21 @@ namespace TrenchBroom {
                     T03,                 // arrow position (exposed in shader as gl_MultiTexCoord0)
                     T13>::Vertex;        // direction the arrow is pointing (exposed in shader as gl_MultiTexCoord1)
 
+            /**
+             * A link from a source entity to one of its targets, together with the anchors of its end points.
+             */
+            struct Link {
+                Model::AttributableNode* target;
+                vm::vec3f sourceAnchor;
+                vm::vec3f targetAnchor;
+
+                Link(Model::AttributableNode* i_target, const vm::vec3f& i_sourceAnchor, const vm::vec3f& i_targetAnchor);
+            };
+
+            using LinkList = std::vector<Link>;
+            using LinkMap = std::map<Model::AttributableNode*, LinkList>;
+            using SourceMap = std::map<Model::AttributableNode*, Model::AttributableNodeSet>;
+
             View::MapDocumentWPtr m_document;
             
             Color m_defaultColor;
@@ -59,6 +79,16 @@ namespace TrenchBroom {
             VertexArray m_entityLinks;
             VertexArray m_entityLinkArrows;
 
+            /**
+             * The link graph of all entities regardless of their visibility, which also depends on the selection and
+             * is therefore checked whenever the rendered links are rebuilt. Only the links of the sources in
+             * m_invalidSources are recomputed when the graph is validated, unless the entire graph is invalid.
+             */
+            LinkMap m_links;
+            SourceMap m_linkSources;
+            Model::AttributableNodeSet m_invalidSources;
+            bool m_linksValid;
+
             bool m_valid;
         public:
             EntityLinkRenderer(View::MapDocumentWPtr document);
@@ -67,7 +97,29 @@ namespace TrenchBroom {
             void setSelectedColor(const Color& color);
             
             void render(RenderContext& renderContext, RenderBatch& renderBatch);
+
+            /**
+             * Rebuilds the rendered links from the link graph, e.g. when the selection or the visibility of nodes has
+             * changed.
+             */
             void invalidate();
+
+            /**
+             * Discards the link graph, e.g. when nodes were added or removed.
+             */
+            void invalidateLinks();
+
+            /**
+             * Recomputes only the links from and to the entities of the given nodes and of the groups among them, e.g.
+             * when they were moved or their target or targetname attributes were changed.
+             */
+            void invalidateLinks(const Model::NodeList& nodes);
+
+            /**
+             * Returns the vertices of the links that are currently shown, two per link, and validates the link graph
+             * if necessary.
+             */
+            Vertex::List linkVertices();
         private:
             void doPrepareVertices(Vbo& vertexVbo) override;
             void doRender(RenderContext& renderContext) override;
@@ -75,23 +127,27 @@ namespace TrenchBroom {
             void renderArrows(RenderContext& renderContext);
         private:
             void validate();
+            void validateLinks();
+            void updateLinks(Model::Entity* source);
+            void removeLinks(Model::AttributableNode* source);
 
             static void getArrows(ArrowVertex::List& arrows, const Vertex::List& links);
             static void addArrow(ArrowVertex::List& arrows, const vm::vec4f& color, const vm::vec3f& arrowPosition, const vm::vec3f& lineDir);
             
             class MatchEntities;
             class CollectEntitiesVisitor;
-            
-            class CollectLinksVisitor;
-            class CollectAllLinksVisitor;
-            class CollectTransitiveSelectedLinksVisitor;
-            class CollectDirectSelectedLinksVisitor;
+            class CollectChangedEntitiesVisitor;
+            class UpdateLinksVisitor;
 
             void getLinks(Vertex::List& links) const;
-            void getAllLinks(Vertex::List& links) const;
-            void getTransitiveSelectedLinks(Vertex::List& links) const;
-            void getDirectSelectedLinks(Vertex::List& links) const;
-            void collectSelectedLinks(CollectLinksVisitor& collectLinks) const;
+            void getAllLinks(const Model::EditorContext& editorContext, Vertex::List& links) const;
+            void getTransitiveSelectedLinks(const Model::EditorContext& editorContext, Vertex::List& links) const;
+            void getDirectSelectedLinks(const Model::EditorContext& editorContext, Vertex::List& links) const;
+            Model::AttributableNodeList selectedEntities() const;
+
+            const LinkList& links(Model::AttributableNode* source) const;
+            const Model::AttributableNodeSet& linkSources(Model::AttributableNode* target) const;
+            void addLink(Vertex::List& vertices, const Model::AttributableNode* source, const Link& link) const;
             
             EntityLinkRenderer(const EntityLinkRenderer& other);
             EntityLinkRenderer& operator=(const EntityLinkRenderer& other);
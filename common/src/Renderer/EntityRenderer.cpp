@@ -101,6 +101,8 @@ namespace TrenchBroom {
 
         void EntityRenderer::reloadModels() {
             m_modelRenderer.updateEntities(std::begin(m_entities), std::end(m_entities));
+            // entities without a model are rendered with solid bounds
+            invalidateBounds();
         }
 
         void EntityRenderer::setShowOverlays(const bool showOverlays) {
@@ -67,6 +67,19 @@ namespace TrenchBroom {
             void add(PrimType primType, size_t index, size_t count);
             
             void render(VertexArray& vertexArray) const;
+
+            /**
+             * Calls the given function with the primitive type, the start index and the number of indices of every
+             * range in this map.
+             */
+            template <typename F>
+            void forEachRange(F f) const {
+                for (const auto& entry : *m_data) {
+                    const IndicesAndCounts& indicesAndCounts = entry.second;
+                    for (size_t i = 0; i < indicesAndCounts.size(); ++i)
+                        f(entry.first, static_cast<size_t>(indicesAndCounts.indices[i]), static_cast<size_t>(indicesAndCounts.counts[i]));
+                }
+            }
         };
     }
 }
@@ -153,7 +153,7 @@ namespace TrenchBroom {
             m_defaultRenderer->clear();
             m_selectionRenderer->clear();
             m_lockedRenderer->clear();
-            m_entityLinkRenderer->invalidate();
+            m_entityLinkRenderer->invalidateLinks();
         }
         
         void MapRenderer::overrideSelectionColors(const Color& color, const float mix) {
@@ -186,6 +186,10 @@ namespace TrenchBroom {
             renderTutorialMessages(renderContext, renderBatch);
         }
         
+        EntityLinkRenderer& MapRenderer::entityLinkRenderer() {
+            return *m_entityLinkRenderer;
+        }
+
         void MapRenderer::commitPendingChanges() {
             View::MapDocumentSPtr document = lock(m_document);
             document->commitPendingAssets();
@@ -435,7 +439,6 @@ namespace TrenchBroom {
                                              collect.lockedNodes().entities(),
                                              collect.lockedNodes().brushes());
             }
-            invalidateEntityLinkRenderer();
         }
         
         void MapRenderer::invalidateRenderers(Renderer renderers) {
@@ -460,7 +463,7 @@ namespace TrenchBroom {
         }
 
         void MapRenderer::invalidateEntityLinkRenderer() {
-            m_entityLinkRenderer->invalidate();
+            m_entityLinkRenderer->invalidateLinks();
         }
 
         void MapRenderer::reloadEntityModels() {
@@ -486,6 +489,7 @@ namespace TrenchBroom {
             document->selectionDidChangeNotifier.addObserver(this, &MapRenderer::selectionDidChange);
             document->textureCollectionsDidChangeNotifier.addObserver(this, &MapRenderer::textureCollectionsDidChange);
             document->entityDefinitionsDidChangeNotifier.addObserver(this, &MapRenderer::entityDefinitionsDidChange);
+            document->entityModelsDidChangeNotifier.addObserver(this, &MapRenderer::entityModelsDidChange);
             document->modsDidChangeNotifier.addObserver(this, &MapRenderer::modsDidChange);
             document->editorContextDidChangeNotifier.addObserver(this, &MapRenderer::editorContextDidChange);
             document->mapViewConfigDidChangeNotifier.addObserver(this, &MapRenderer::mapViewConfigDidChange);
@@ -511,6 +515,7 @@ namespace TrenchBroom {
                 document->selectionDidChangeNotifier.removeObserver(this, &MapRenderer::selectionDidChange);
                 document->textureCollectionsDidChangeNotifier.removeObserver(this, &MapRenderer::textureCollectionsDidChange);
                 document->entityDefinitionsDidChangeNotifier.removeObserver(this, &MapRenderer::entityDefinitionsDidChange);
+                document->entityModelsDidChangeNotifier.removeObserver(this, &MapRenderer::entityModelsDidChange);
                 document->modsDidChangeNotifier.removeObserver(this, &MapRenderer::modsDidChange);
                 document->editorContextDidChangeNotifier.removeObserver(this, &MapRenderer::editorContextDidChange);
                 document->mapViewConfigDidChangeNotifier.removeObserver(this, &MapRenderer::mapViewConfigDidChange);
@@ -531,31 +536,37 @@ namespace TrenchBroom {
         
         void MapRenderer::nodesWereAdded(const Model::NodeList& nodes) {
             updateRenderers(Renderer_Default);
+            invalidateEntityLinkRenderer();
         }
         
         void MapRenderer::nodesWereRemoved(const Model::NodeList& nodes) {
             updateRenderers(Renderer_Default);
+            invalidateEntityLinkRenderer();
         }
         
         void MapRenderer::nodesDidChange(const Model::NodeList& nodes) {
             invalidateRenderers(Renderer_Selection);
-            invalidateEntityLinkRenderer();
+            m_entityLinkRenderer->invalidateLinks(nodes);
         }
         
         void MapRenderer::nodeVisibilityDidChange(const Model::NodeList& nodes) {
             invalidateRenderers(Renderer_All);
+            m_entityLinkRenderer->invalidate();
         }
         
         void MapRenderer::nodeLockingDidChange(const Model::NodeList& nodes) {
             updateRenderers(Renderer_Default_Locked);
+            m_entityLinkRenderer->invalidate();
         }
         
         void MapRenderer::groupWasOpened(Model::Group* group) {
             updateRenderers(Renderer_Default_Selection);
+            m_entityLinkRenderer->invalidate();
         }
         
         void MapRenderer::groupWasClosed(Model::Group* group) {
             updateRenderers(Renderer_Default_Selection);
+            m_entityLinkRenderer->invalidate();
         }
 
         void MapRenderer::brushFacesDidChange(const Model::BrushFaceList& faces) {
@@ -565,6 +576,10 @@ namespace TrenchBroom {
         void MapRenderer::selectionDidChange(const View::Selection& selection) {
             updateRenderers(Renderer_All); // need to update locked objects also because a selected object may have been reparented into a locked layer before deselection
 
+            // the link graph does not depend on the selection, but the rendered links, their colors and the
+            // visibility of their end points do
+            m_entityLinkRenderer->invalidate();
+
             // selecting faces needs to invalidate the brushes
             if (!selection.selectedBrushFaces().empty()
                 || !selection.deselectedBrushFaces().empty()) {
@@ -604,6 +619,10 @@ namespace TrenchBroom {
             invalidateEntityLinkRenderer();
         }
         
+        void MapRenderer::entityModelsDidChange() {
+            reloadEntityModels();
+        }
+
         void MapRenderer::modsDidChange() {
             reloadEntityModels();
             invalidateRenderers(Renderer_All);
@@ -69,6 +69,7 @@ namespace TrenchBroom {
             void restoreSelectionColors();
         public: // rendering
             void render(RenderContext& renderContext, RenderBatch& renderBatch);
+            EntityLinkRenderer& entityLinkRenderer();
         private:
             void commitPendingChanges();
             void setupGL(RenderBatch& renderBatch);
@@ -137,6 +138,7 @@ namespace TrenchBroom {
             
             void textureCollectionsDidChange();
             void entityDefinitionsDidChange();
+            void entityModelsDidChange();
             void modsDidChange();
             
             void editorContextDidChange();
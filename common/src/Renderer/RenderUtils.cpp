@@ -257,6 +257,29 @@ namespace TrenchBroom {
             return vertices;
         }
 
+        RoundedRect2DTemplate::RoundedRect2DTemplate(const float cornerRadius, const size_t cornerSegments) :
+        m_cornerRadius(cornerRadius),
+        m_vertices(roundedRect2D(2.0f * cornerRadius, 2.0f * cornerRadius, cornerRadius, cornerSegments)) {
+            // growing the rectangle by 2 in each dimension grows its extent beyond the corners by 1
+            const std::vector<vm::vec2f> largerRect = roundedRect2D(2.0f * cornerRadius + 2.0f, 2.0f * cornerRadius + 2.0f, cornerRadius, cornerSegments);
+            m_slopes.reserve(m_vertices.size());
+            for (size_t i = 0; i < m_vertices.size(); ++i)
+                m_slopes.push_back(largerRect[i] - m_vertices[i]);
+        }
+
+        size_t RoundedRect2DTemplate::vertexCount() const {
+            return m_vertices.size();
+        }
+
+        vm::vec2f RoundedRect2DTemplate::vertex(const size_t index, const vm::vec2f& size) const {
+            assert(index < m_vertices.size());
+            const vm::vec2f extent = size / 2.0f - vm::vec2f(m_cornerRadius, m_cornerRadius);
+            const vm::vec2f& vertex = m_vertices[index];
+            const vm::vec2f& slope = m_slopes[index];
+            return vm::vec2f(vertex.x() + slope.x() * extent.x(),
+                             vertex.y() + slope.y() * extent.y());
+        }
+
         namespace SphereBuilder {
             class Triangle {
             private:
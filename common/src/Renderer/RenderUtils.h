@@ -66,6 +66,28 @@ namespace TrenchBroom {
         size_t roundedRect2DVertexCount(size_t cornerSegments);
         std::vector<vm::vec2f> roundedRect2D(const vm::vec2f& size, float cornerRadius, size_t cornerSegments);
         std::vector<vm::vec2f> roundedRect2D(float width, float height, float cornerRadius, size_t cornerSegments);
+
+        /**
+         * The vertices of a rounded rectangle are affine in the size of the rectangle. This computes the vertices of
+         * rounded rectangles of any size from the vertices of the smallest possible rectangle and their derivatives,
+         * which is much cheaper than calling roundedRect2D for every rectangle.
+         */
+        class RoundedRect2DTemplate {
+        private:
+            float m_cornerRadius;
+            std::vector<vm::vec2f> m_vertices;
+            std::vector<vm::vec2f> m_slopes;
+        public:
+            RoundedRect2DTemplate(float cornerRadius, size_t cornerSegments);
+
+            size_t vertexCount() const;
+
+            /**
+             * Returns the vertex with the given index of the rounded rectangle of the given size that is centered at
+             * the origin. The size must be at least twice the corner radius in both dimensions.
+             */
+            vm::vec2f vertex(size_t index, const vm::vec2f& size) const;
+        };
         
         struct VertsAndNormals {
             std::vector<vm::vec3f> vertices;
@@ -43,24 +43,25 @@ namespace TrenchBroom {
         const size_t TextRenderer::RectCornerSegments = 3;
         const float TextRenderer::RectCornerRadius = 3.0f;
         
-        TextRenderer::Entry::Entry(std::vector<vm::vec2f>& i_vertices, const vm::vec2f& i_size, const vm::vec3f& i_offset, const Color& i_textColor, const Color& i_backgroundColor) :
-        size(i_size),
+        TextRenderer::Entry::Entry(TextureFont::RunPtr i_run, const vm::vec3f& i_offset, const Color& i_textColor, const Color& i_backgroundColor) :
+        run(std::move(i_run)),
         offset(i_offset),
         textColor(i_textColor),
-        backgroundColor(i_backgroundColor) {
-            using std::swap;
-            swap(vertices, i_vertices);
-        }
+        backgroundColor(i_backgroundColor) {}
 
         TextRenderer::EntryCollection::EntryCollection() :
         textVertexCount(0),
-        rectVertexCount(0) {}
+        rectVertexCount(0),
+        textIndex(0),
+        rectIndex(0) {}
         
         TextRenderer::TextRenderer(const FontDescriptor& fontDescriptor, const float maxViewDistance, const float minZoomFactor, const vm::vec2f& inset) :
         m_fontDescriptor(fontDescriptor),
+        m_font(nullptr),
         m_maxViewDistance(maxViewDistance),
         m_minZoomFactor(minZoomFactor),
-        m_inset(inset) {}
+        m_inset(inset),
+        m_rectTemplate(RectCornerRadius, RectCornerSegments) {}
 
         void TextRenderer::renderString(RenderContext& renderContext, const Color& textColor, const Color& backgroundColor, const AttrString& string, const TextAnchor& position) {
             renderString(renderContext, textColor, backgroundColor, string, position, false);
@@ -77,41 +78,40 @@ namespace TrenchBroom {
             if (distance <= 0.0f)
                 return;
             
-            if (!isVisible(renderContext, string, position, distance, onTop))
+            // cull by distance before the string is laid out
+            if (!isInRange(renderContext, distance, onTop))
                 return;
             
-            FontManager& fontManager = renderContext.fontManager();
-            TextureFont& font = fontManager.font(m_fontDescriptor);
+            TextureFont::RunPtr run = font(renderContext).run(string);
+            if (!isVisible(renderContext, run->size, position))
+                return;
 
-            std::vector<vm::vec2f> vertices = font.quads(string, true);
             const float alphaFactor = computeAlphaFactor(renderContext, distance, onTop);
-            const vm::vec2f size = font.measure(string);
-            const vm::vec3f offset = position.offset(camera, size);
+            const vm::vec3f offset = position.offset(camera, run->size);
             
+            addEntry(onTop ? m_entriesOnTop : m_entries,
+                     Entry(std::move(run), offset,
+                           Color(textColor, alphaFactor * textColor.a()),
+                           Color(backgroundColor, alphaFactor * backgroundColor.a())));
+        }
+
+        bool TextRenderer::isInRange(RenderContext& renderContext, const float distance, const bool onTop) const {
             if (onTop)
-                addEntry(m_entriesOnTop, Entry(vertices, size, offset,
-                                               Color(textColor, alphaFactor * textColor.a()),
-                                               Color(backgroundColor, alphaFactor * backgroundColor.a())));
-            else
-                addEntry(m_entries, Entry(vertices, size, offset,
-                                          Color(textColor, alphaFactor * textColor.a()),
-                                          Color(backgroundColor, alphaFactor * backgroundColor.a())));
+                return true;
+            if (renderContext.render3D() && distance > m_maxViewDistance)
+                return false;
+            if (renderContext.render2D() && renderContext.camera().zoom() < m_minZoomFactor)
+                return false;
+            return true;
         }
 
-        bool TextRenderer::isVisible(RenderContext& renderContext, const AttrString& string, const TextAnchor& position, const float distance, const bool onTop) const {
-            if (!onTop) {
-                if (renderContext.render3D() && distance > m_maxViewDistance)
-                    return false;
-                if (renderContext.render2D() && renderContext.camera().zoom() < m_minZoomFactor)
-                    return false;
-            }
-            
+        bool TextRenderer::isVisible(RenderContext& renderContext, const vm::vec2f& size, const TextAnchor& position) const {
             const Camera& camera = renderContext.camera();
             const Camera::Viewport& viewport = camera.unzoomedViewport();
             
-            const vm::vec2f size = stringSize(renderContext, string);
-            const vm::vec2f offset = vm::vec2f(position.offset(camera, size)) - m_inset;
-            const vm::vec2f actualSize = size + 2.0f * m_inset;
+            const vm::vec2f roundedSize = round(size);
+            const vm::vec2f offset = vm::vec2f(position.offset(camera, roundedSize)) - m_inset;
+            const vm::vec2f actualSize = roundedSize + 2.0f * m_inset;
             
             return viewport.contains(offset.x(), offset.y(), actualSize.x(), actualSize.y());
         }
@@ -136,57 +136,60 @@ namespace TrenchBroom {
         
         void TextRenderer::addEntry(EntryCollection& collection, const Entry& entry) {
             collection.entries.push_back(entry);
-            collection.textVertexCount += entry.vertices.size();
-            collection.rectVertexCount += roundedRect2DVertexCount(RectCornerSegments);
+            collection.textVertexCount += entry.run->vertices.size() / 2;
+            collection.rectVertexCount += m_rectTemplate.vertexCount();
         }
         
-        vm::vec2f TextRenderer::stringSize(RenderContext& renderContext, const AttrString& string) const {
-            FontManager& fontManager = renderContext.fontManager();
-            TextureFont& font = fontManager.font(m_fontDescriptor);
-            return round(font.measure(string));
+        TextureFont& TextRenderer::font(RenderContext& renderContext) {
+            if (m_font == nullptr) {
+                FontManager& fontManager = renderContext.fontManager();
+                m_font = &fontManager.font(m_fontDescriptor);
+            }
+            return *m_font;
         }
 
         void TextRenderer::doPrepareVertices(Vbo& vertexVbo) {
-            prepare(m_entries, false, vertexVbo);
-            prepare(m_entriesOnTop, true, vertexVbo);
+            Vertex::List vertices;
+            vertices.reserve(m_entries.rectVertexCount + m_entries.textVertexCount +
+                             m_entriesOnTop.rectVertexCount + m_entriesOnTop.textVertexCount);
+
+            addRects(m_entries, vertices);
+            addText(m_entries, vertices);
+            addRects(m_entriesOnTop, vertices);
+            addText(m_entriesOnTop, vertices);
+
+            m_vertexArray = VertexArray::swap(vertices);
+            m_vertexArray.prepare(vertexVbo);
         }
         
-        void TextRenderer::prepare(EntryCollection& collection, const bool onTop, Vbo& vbo) {
-            TextVertex::List textVertices;
-            textVertices.reserve(collection.textVertexCount);
-            
-            RectVertex::List rectVertices;
-            rectVertices.reserve(collection.rectVertexCount);
-            
-            for (const Entry& entry : collection.entries)
-                addEntry(entry, onTop, textVertices, rectVertices);
-            
-            collection.textArray = VertexArray::swap(textVertices);
-            collection.rectArray = VertexArray::swap(rectVertices);
-            
-            collection.textArray.prepare(vbo);
-            collection.rectArray.prepare(vbo);
+        void TextRenderer::addRects(EntryCollection& collection, Vertex::List& vertices) const {
+            collection.rectIndex = vertices.size();
+
+            for (const Entry& entry : collection.entries) {
+                const vm::vec2f& stringSize = entry.run->size;
+                const vm::vec2f center = entry.offset.xy() + stringSize / 2.0f;
+                const vm::vec2f rectSize = stringSize + 2.0f * m_inset;
+                const float z = -entry.offset.z();
+
+                for (size_t i = 0; i < m_rectTemplate.vertexCount(); ++i) {
+                    const vm::vec2f position = center + m_rectTemplate.vertex(i, rectSize);
+                    vertices.push_back(Vertex(vm::vec3f(position, z), vm::vec2f::zero, entry.backgroundColor));
+                }
+            }
         }
 
-        void TextRenderer::addEntry(const Entry& entry, const bool /* onTop */, TextVertex::List& textVertices, RectVertex::List& rectVertices) {
-            const std::vector<vm::vec2f>& stringVertices = entry.vertices;
-            const vm::vec2f& stringSize = entry.size;
-            
-            const vm::vec3f& offset = entry.offset;
-            
-            const Color& textColor = entry.textColor;
-            const Color& rectColor = entry.backgroundColor;
-            
-            for (size_t i = 0; i < stringVertices.size() / 2; ++i) {
-                const vm::vec2f& position2 = stringVertices[2 * i];
-                const vm::vec2f& texCoords = stringVertices[2 * i + 1];
-                textVertices.push_back(TextVertex(vm::vec3f(position2 + offset.xy(), -offset.z()), texCoords, textColor));
-            }
+        void TextRenderer::addText(EntryCollection& collection, Vertex::List& vertices) const {
+            collection.textIndex = vertices.size();
 
-            const std::vector<vm::vec2f> rect = roundedRect2D(stringSize + 2.0f * m_inset, RectCornerRadius, RectCornerSegments);
-            for (size_t i = 0; i < rect.size(); ++i) {
-                const vm::vec2f& vertex = rect[i];
-                rectVertices.push_back(RectVertex(vm::vec3f(vertex + offset.xy() + stringSize / 2.0f, -offset.z()), rectColor));
+            for (const Entry& entry : collection.entries) {
+                const std::vector<vm::vec2f>& stringVertices = entry.run->vertices;
+                const vm::vec3f& offset = entry.offset;
+
+                for (size_t i = 0; i < stringVertices.size() / 2; ++i) {
+                    const vm::vec2f& position2 = stringVertices[2 * i];
+                    const vm::vec2f& texCoords = stringVertices[2 * i + 1];
+                    vertices.push_back(Vertex(vm::vec3f(position2 + offset.xy(), -offset.z()), texCoords, entry.textColor));
+                }
             }
         }
 
@@ -208,20 +211,21 @@ namespace TrenchBroom {
         }
 
         void TextRenderer::render(EntryCollection& collection, RenderContext& renderContext) {
-            FontManager& fontManager = renderContext.fontManager();
-            TextureFont& font = fontManager.font(m_fontDescriptor);
+            if (collection.entries.empty())
+                return;
             
             glAssert(glDisable(GL_TEXTURE_2D));
             
             ActiveShader backgroundShader(renderContext.shaderManager(), Shaders::TextBackgroundShader);
-            collection.rectArray.render(GL_TRIANGLES);
+            m_vertexArray.render(GL_TRIANGLES, static_cast<GLint>(collection.rectIndex), static_cast<GLsizei>(collection.rectVertexCount));
             
             glAssert(glEnable(GL_TEXTURE_2D));
             
+            TextureFont& font = this->font(renderContext);
             ActiveShader textShader(renderContext.shaderManager(), Shaders::ColoredTextShader);
             textShader.set("Texture", 0);
             font.activate();
-            collection.textArray.render(GL_QUADS);
+            m_vertexArray.render(GL_QUADS, static_cast<GLint>(collection.textIndex), static_cast<GLsizei>(collection.textVertexCount));
             font.deactivate();
         }
     }
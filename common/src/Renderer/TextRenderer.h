@@ -23,6 +23,8 @@
 #include "Color.h"
 #include "Renderer/FontDescriptor.h"
 #include "Renderer/Renderable.h"
+#include "Renderer/RenderUtils.h"
+#include "Renderer/TextureFont.h"
 #include "Renderer/VertexArray.h"
 #include "Renderer/VertexSpec.h"
 
@@ -48,13 +50,12 @@ namespace TrenchBroom {
             static const float RectCornerRadius;
             
             struct Entry {
-                std::vector<vm::vec2f> vertices;
-                vm::vec2f size;
+                TextureFont::RunPtr run;
                 vm::vec3f offset;
                 Color textColor;
                 Color backgroundColor;
 
-                Entry(std::vector<vm::vec2f>& i_vertices, const vm::vec2f& i_size, const vm::vec3f& i_offset, const Color& i_textColor, const Color& i_backgroundColor);
+                Entry(TextureFont::RunPtr i_run, const vm::vec3f& i_offset, const Color& i_textColor, const Color& i_backgroundColor);
             };
             
             typedef std::vector<Entry> EntryList;
@@ -63,23 +64,30 @@ namespace TrenchBroom {
                 EntryList entries;
                 size_t textVertexCount;
                 size_t rectVertexCount;
-                
-                VertexArray textArray;
-                VertexArray rectArray;
+
+                size_t textIndex;
+                size_t rectIndex;
 
                 EntryCollection();
             };
             
-            typedef VertexSpecs::P3T2C4::Vertex TextVertex;
-            typedef VertexSpecs::P3C4::Vertex RectVertex;
+            typedef VertexSpecs::P3T2C4::Vertex Vertex;
             
             FontDescriptor m_fontDescriptor;
+            TextureFont* m_font;
             float m_maxViewDistance;
             float m_minZoomFactor;
             vm::vec2f m_inset;
+
+            RoundedRect2DTemplate m_rectTemplate;
             
             EntryCollection m_entries;
             EntryCollection m_entriesOnTop;
+
+            /**
+             * The backgrounds and glyphs of all strings, uploaded at once and rendered in ranges.
+             */
+            VertexArray m_vertexArray;
         public:
             TextRenderer(const FontDescriptor& fontDescriptor, float maxViewDistance = DefaultMaxViewDistance, float minZoomFactor = DefaultMinZoomFactor, const vm::vec2f& inset = DefaultInset);
             
@@ -88,21 +96,19 @@ namespace TrenchBroom {
         private:
             void renderString(RenderContext& renderContext, const Color& textColor, const Color& backgroundColor, const AttrString& string, const TextAnchor& position, bool onTop);
             
-            bool isVisible(RenderContext& renderContext, const AttrString& string, const TextAnchor& position, float distance, bool onTop) const;
+            bool isInRange(RenderContext& renderContext, float distance, bool onTop) const;
+            bool isVisible(RenderContext& renderContext, const vm::vec2f& size, const TextAnchor& position) const;
             float computeAlphaFactor(const RenderContext& renderContext, float distance, bool onTop) const;
             void addEntry(EntryCollection& collection, const Entry& entry);
             
-            vm::vec2f stringSize(RenderContext& renderContext, const AttrString& string) const;
+            TextureFont& font(RenderContext& renderContext);
         private:
             void doPrepareVertices(Vbo& vertexVbo) override;
-            void prepare(EntryCollection& collection, bool onTop, Vbo& vbo);
-            
-            void addEntry(const Entry& entry, bool onTop, TextVertex::List& textVertices, RectVertex::List& rectVertices);
+            void addRects(EntryCollection& collection, Vertex::List& vertices) const;
+            void addText(EntryCollection& collection, Vertex::List& vertices) const;
             
             void doRender(RenderContext& renderContext) override;
             void render(EntryCollection& collection, RenderContext& renderContext);
-
-            void clear();
         };
     }
 }
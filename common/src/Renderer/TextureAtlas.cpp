@@ -0,0 +1,221 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "TextureAtlas.h"
+
+#include "Assets/Texture.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        TextureAtlas::TextureAtlas(const size_t pageSize, const size_t maxPageCount) :
+        m_pageSize(pageSize),
+        m_maxPageCount(maxPageCount),
+        m_pageCount(0),
+        m_generation(0),
+        m_minFilter(GL_LINEAR),
+        m_magFilter(GL_LINEAR) {
+            assert(m_pageSize > 2 * Margin);
+            assert(m_maxPageCount > 0);
+        }
+
+        TextureAtlas::~TextureAtlas() {
+            for (Page& page : m_pages) {
+                if (page.textureId != 0) {
+                    glAssert(glDeleteTextures(1, &page.textureId));
+                    page.textureId = 0;
+                }
+            }
+        }
+
+        size_t TextureAtlas::pageSize() const {
+            return m_pageSize;
+        }
+
+        size_t TextureAtlas::pageCount() const {
+            return m_pageCount;
+        }
+
+        size_t TextureAtlas::generation() const {
+            return m_generation;
+        }
+
+        void TextureAtlas::clear() {
+            m_entries.clear();
+            m_pageCount = 0;
+            ++m_generation;
+        }
+
+        void TextureAtlas::setTextureMode(int minFilter, const int magFilter) {
+            switch (minFilter) {
+                case GL_NEAREST_MIPMAP_NEAREST:
+                case GL_NEAREST_MIPMAP_LINEAR:
+                    minFilter = GL_NEAREST;
+                    break;
+                case GL_LINEAR_MIPMAP_NEAREST:
+                case GL_LINEAR_MIPMAP_LINEAR:
+                    minFilter = GL_LINEAR;
+                    break;
+                default:
+                    break;
+            }
+
+            if (minFilter == m_minFilter && magFilter == m_magFilter)
+                return;
+
+            m_minFilter = minFilter;
+            m_magFilter = magFilter;
+            for (const Page& page : m_pages) {
+                if (page.textureId != 0) {
+                    glAssert(glBindTexture(GL_TEXTURE_2D, page.textureId));
+                    applyTextureMode();
+                }
+            }
+            glAssert(glBindTexture(GL_TEXTURE_2D, 0));
+        }
+
+        const TextureAtlas::Region* TextureAtlas::region(const Assets::Texture& texture, const size_t minWidth, const size_t minHeight, const bool clearIfFull) {
+            if (!texture.isPrepared())
+                return nullptr;
+
+            const auto it = m_entries.find(&texture);
+            if (it != std::end(m_entries) && it->second.minWidth == minWidth && it->second.minHeight == minHeight)
+                return &it->second.region;
+
+            const size_t level = mipLevel(texture.width(), texture.height(), texture.mipLevelCount(), minWidth, minHeight);
+            const size_t width = std::max(texture.width() >> level, size_t(1));
+            const size_t height = std::max(texture.height() >> level, size_t(1));
+
+            Region region;
+            if (!allocate(width, height, region, clearIfFull))
+                return nullptr;
+            upload(texture, level, region);
+
+            Entry& entry = m_entries[&texture];
+            entry = Entry { region, minWidth, minHeight };
+            return &entry.region;
+        }
+
+        bool TextureAtlas::allocate(const size_t width, const size_t height, Region& result, const bool clearIfFull) {
+            const size_t paddedWidth = width + 2 * Margin;
+            const size_t paddedHeight = height + 2 * Margin;
+            if (paddedWidth > m_pageSize || paddedHeight > m_pageSize)
+                return false;
+
+            // only the last page receives new regions, and only its last shelf is open
+            const auto place = [&](Page& page) {
+                if (page.shelfX + paddedWidth > m_pageSize) {
+                    page.shelfY += page.shelfHeight;
+                    page.shelfX = 0;
+                    page.shelfHeight = 0;
+                }
+                if (page.shelfY + paddedHeight > m_pageSize)
+                    return false;
+
+                result.page = m_pageCount - 1;
+                result.x = page.shelfX + Margin;
+                result.y = page.shelfY + Margin;
+                page.shelfX += paddedWidth;
+                page.shelfHeight = std::max(page.shelfHeight, paddedHeight);
+                return true;
+            };
+
+            if (m_pageCount == 0 || !place(m_pages[m_pageCount - 1])) {
+                if (m_pageCount == m_maxPageCount) {
+                    if (!clearIfFull)
+                        return false;
+                    clear();
+                }
+                if (m_pageCount == m_pages.size())
+                    m_pages.push_back(Page { 0, 0, 0, 0 });
+
+                Page& page = m_pages[m_pageCount++];
+                page.shelfY = page.shelfHeight = page.shelfX = 0;
+
+                const bool placed = place(page);
+                assert(placed);
+                unused(placed);
+            }
+
+            // sample the centers of the border texels so that filtering does not pick up neighbouring regions
+            const float pageSize = static_cast<float>(m_pageSize);
+            result.width = width;
+            result.height = height;
+            result.texCoordsMin = vm::vec2f(static_cast<float>(result.x) + 0.5f, static_cast<float>(result.y) + 0.5f) / pageSize;
+            result.texCoordsMax = vm::vec2f(static_cast<float>(result.x + width) - 0.5f, static_cast<float>(result.y + height) - 0.5f) / pageSize;
+            return true;
+        }
+
+        void TextureAtlas::activatePage(const size_t page) const {
+            assert(page < m_pageCount);
+            assert(m_pages[page].textureId != 0);
+            glAssert(glBindTexture(GL_TEXTURE_2D, m_pages[page].textureId));
+        }
+
+        void TextureAtlas::deactivate() const {
+            glAssert(glBindTexture(GL_TEXTURE_2D, 0));
+        }
+
+        size_t TextureAtlas::mipLevel(const size_t width, const size_t height, const size_t levelCount, const size_t minWidth, const size_t minHeight) {
+            size_t level = 0;
+            while (level + 1 < levelCount && (width >> (level + 1)) >= minWidth && (height >> (level + 1)) >= minHeight)
+                ++level;
+            return level;
+        }
+
+        void TextureAtlas::upload(const Assets::Texture& texture, const size_t level, const Region& region) {
+            std::vector<unsigned char> buffer(region.width * region.height * 4);
+
+            texture.activate();
+            glAssert(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+            glAssert(glGetTexImage(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA, GL_UNSIGNED_BYTE, buffer.data()));
+            texture.deactivate();
+
+            Page& page = m_pages[region.page];
+            if (page.textureId == 0) {
+                glAssert(glGenTextures(1, &page.textureId));
+                glAssert(glBindTexture(GL_TEXTURE_2D, page.textureId));
+                applyTextureMode();
+                glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+                glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+                glAssert(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(m_pageSize), static_cast<GLsizei>(m_pageSize), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+            } else {
+                glAssert(glBindTexture(GL_TEXTURE_2D, page.textureId));
+            }
+
+            glAssert(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+            glAssert(glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0));
+            glAssert(glPixelStorei(GL_UNPACK_SKIP_ROWS, 0));
+            glAssert(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+            glAssert(glTexSubImage2D(GL_TEXTURE_2D, 0,
+                                     static_cast<GLint>(region.x), static_cast<GLint>(region.y),
+                                     static_cast<GLsizei>(region.width), static_cast<GLsizei>(region.height),
+                                     GL_RGBA, GL_UNSIGNED_BYTE, buffer.data()));
+            glAssert(glBindTexture(GL_TEXTURE_2D, 0));
+        }
+
+        void TextureAtlas::applyTextureMode() const {
+            glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_minFilter));
+            glAssert(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_magFilter));
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TrenchBroom_TextureAtlas
+#define TrenchBroom_TextureAtlas
+
+#include "Macros.h"
+#include "Renderer/GL.h"
+
+#include <vecmath/forward.h>
+#include <vecmath/vec.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Assets {
+        class Texture;
+    }
+
+    namespace Renderer {
+        /**
+         * Packs downscaled copies of textures into a few large pages so that many textures can be drawn with a
+         * single draw call per page.
+         *
+         * A texture is copied into the atlas when its region is requested for the first time. The copy is read back
+         * from the smallest mip level of the prepared texture that is at least as large as the requested size. If
+         * all pages are full, the atlas is cleared and its generation is incremented, which invalidates all regions
+         * that were returned before.
+         */
+        class TextureAtlas {
+        public:
+            struct Region {
+                size_t page;
+                size_t x;
+                size_t y;
+                size_t width;
+                size_t height;
+                vm::vec2f texCoordsMin;
+                vm::vec2f texCoordsMax;
+            };
+        private:
+            static const size_t Margin = 1;
+
+            struct Page {
+                GLuint textureId;
+                size_t shelfY;
+                size_t shelfHeight;
+                size_t shelfX;
+            };
+
+            struct Entry {
+                Region region;
+                size_t minWidth;
+                size_t minHeight;
+            };
+
+            size_t m_pageSize;
+            size_t m_maxPageCount;
+            std::vector<Page> m_pages;
+            size_t m_pageCount;
+            size_t m_generation;
+            int m_minFilter;
+            int m_magFilter;
+            std::unordered_map<const Assets::Texture*, Entry> m_entries;
+        public:
+            TextureAtlas(size_t pageSize, size_t maxPageCount);
+            ~TextureAtlas();
+
+            size_t pageSize() const;
+            size_t pageCount() const;
+            size_t generation() const;
+
+            /**
+             * Removes all regions. The pages are kept and reused.
+             */
+            void clear();
+
+            /**
+             * Sets the filters that the pages are sampled with. The pages have no mip maps, so mip mapped
+             * minification filters are replaced by their base filter.
+             */
+            void setTextureMode(int minFilter, int magFilter);
+
+            /**
+             * Returns the region that holds a copy of the given texture that is at least as large as the given
+             * size, and copies the texture into the atlas if necessary. Returns nullptr if the texture is not
+             * prepared, if its copy does not fit into a page, or if all pages are full and clearing the atlas is
+             * not allowed.
+             */
+            const Region* region(const Assets::Texture& texture, size_t minWidth, size_t minHeight, bool clearIfFull = true);
+
+            /**
+             * Reserves space for a rectangle of the given size without copying anything into it.
+             */
+            bool allocate(size_t width, size_t height, Region& result, bool clearIfFull = true);
+
+            void activatePage(size_t page) const;
+            void deactivate() const;
+
+            /**
+             * Returns the index of the smallest mip level of a texture with the given size and number of mip levels
+             * that is at least as large as the given size.
+             */
+            static size_t mipLevel(size_t width, size_t height, size_t levelCount, size_t minWidth, size_t minHeight);
+        private:
+            void upload(const Assets::Texture& texture, size_t level, const Region& region);
+            void applyTextureMode() const;
+
+            deleteCopyAndAssignment(TextureAtlas)
+        };
+    }
+}
+
+#endif /* defined(TrenchBroom_TextureAtlas) */
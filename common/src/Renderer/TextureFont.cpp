@@ -28,6 +28,8 @@
 
 namespace TrenchBroom {
     namespace Renderer {
+        const size_t TextureFont::MaxCachedRuns = 16384;
+
         TextureFont::TextureFont(FontTexture* texture, const FontGlyph::List& glyphs, const size_t lineHeight, const unsigned char firstChar, const unsigned char charCount) :
         m_texture(texture),
         m_glyphs(glyphs),
@@ -226,6 +228,28 @@ namespace TrenchBroom {
             return result;
         }
 
+        TextureFont::RunPtr TextureFont::run(const AttrString& string) {
+            auto it = m_runs.lower_bound(string);
+            if (it != std::end(m_runs) && it->first.compare(string) == 0) {
+                return it->second;
+            }
+
+            if (m_runs.size() >= MaxCachedRuns) {
+                m_runs.clear();
+                it = std::end(m_runs);
+            }
+
+            auto run = std::make_shared<Run>();
+            run->vertices = quads(string, true);
+            run->size = measure(string);
+            m_runs.insert(it, std::make_pair(string, run));
+            return run;
+        }
+
+        size_t TextureFont::cachedRunCount() const {
+            return m_runs.size();
+        }
+
         void TextureFont::activate() {
             m_texture->activate();
         }
@@ -28,6 +28,8 @@
 #include <vecmath/forward.h>
 #include <vecmath/vec.h>
 
+#include <map>
+#include <memory>
 #include <vector>
 
 namespace TrenchBroom {
@@ -36,13 +38,31 @@ namespace TrenchBroom {
         
         class TextureFont {
         public:
+            /**
+             * The clockwise glyph quads of a string laid out at the origin, together with the size of the string.
+             */
+            struct Run {
+                std::vector<vm::vec2f> vertices;
+                vm::vec2f size;
+            };
+
+            typedef std::shared_ptr<const Run> RunPtr;
+
+            /**
+             * The number of cached runs at which the run cache is flushed.
+             */
+            static const size_t MaxCachedRuns;
         private:
+            typedef std::map<AttrString, RunPtr> RunCache;
+
             FontTexture* m_texture;
             FontGlyph::List m_glyphs;
             size_t m_lineHeight;
             
             unsigned char m_firstChar;
             unsigned char m_charCount;
+
+            RunCache m_runs;
         public:
             TextureFont(FontTexture* texture, const FontGlyph::List& glyphs, size_t lineHeight, unsigned char firstChar, unsigned char charCount);
             ~TextureFont();
@@ -52,6 +72,14 @@ namespace TrenchBroom {
 
             std::vector<vm::vec2f> quads(const String& string, bool clockwise, const vm::vec2f& offset = vm::vec2f::zero);
             vm::vec2f measure(const String& string);
+
+            /**
+             * Returns the laid out glyph quads of the given string. Runs are cached per font, so that labels which
+             * are rendered every frame are only laid out once. The cache is flushed when it grows too large, but
+             * the returned runs remain valid for as long as they are referenced.
+             */
+            RunPtr run(const AttrString& string);
+            size_t cachedRunCount() const;
             
             void activate();
             void deactivate();
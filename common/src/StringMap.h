@@ -24,9 +24,12 @@
 #include "Exceptions.h"
 #include "StringUtils.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <map>
 #include <set>
+#include <utility>
 #include <vector>
 
 namespace TrenchBroom {
@@ -39,6 +42,12 @@ namespace TrenchBroom {
         static void insertValue(ValueContainer& values, const V& value) {
             values.push_back(value);
         }
+
+        template <typename I>
+        static void insertValues(ValueContainer& values, I begin, const I end) {
+            while (begin != end)
+                values.push_back((*begin++)->second);
+        }
         
         static void removeValue(ValueContainer& values, const V& value) {
             typename ValueContainer::iterator it = std::find(std::begin(values), std::end(values), value);
@@ -52,122 +61,246 @@ namespace TrenchBroom {
         }
     };
     
+    /**
+     * Stores each distinct value once together with the number of times it was inserted. Most keys only have a few
+     * values, which are kept in a small vector sorted by value. Once a key has more than MaxListSize distinct values,
+     * they are moved into a map so that inserting and removing values stays logarithmic. Values that are inserted in
+     * bulk are kept in the vector regardless of their number until the container is modified for the first time.
+     */
     template <typename V>
     class StringMultiMapValueContainer {
+    private:
+        typedef std::pair<V, size_t> Entry;
+        typedef std::vector<Entry> EntryList;
+        typedef std::map<V, size_t> EntryMap;
+        static constexpr size_t MaxListSize = 64;
     public:
-        typedef std::map<V, size_t> ValueContainer;
+        class ValueContainer {
+        private:
+            EntryList m_list;
+            EntryMap m_map;
+            friend class StringMultiMapValueContainer;
+        public:
+            bool empty() const {
+                return m_list.empty() && m_map.empty();
+            }
+        };
         typedef std::set<V> QueryResult;
         
         static void insertValue(ValueContainer& values, const V& value) {
-            typename ValueContainer::iterator it = MapUtils::findOrInsert(values, value, 0u);
-            ++it->second;
+            if (values.m_list.size() > MaxListSize)
+                convertToMap(values);
+            if (!values.m_map.empty()) {
+                typename EntryMap::iterator it = MapUtils::findOrInsert(values.m_map, value, 0u);
+                ++it->second;
+                return;
+            }
+
+            typename EntryList::iterator it = lowerBound(values.m_list, value);
+            if (it != std::end(values.m_list) && it->first == value) {
+                ++it->second;
+            } else if (values.m_list.size() < MaxListSize) {
+                values.m_list.insert(it, Entry(value, 1u));
+            } else {
+                convertToMap(values);
+                values.m_map.insert(Entry(value, 1u));
+            }
+        }
+
+        /**
+         * Inserts the values of the given range of pointers to key value pairs.
+         */
+        template <typename I>
+        static void insertValues(ValueContainer& values, I begin, const I end) {
+            if (begin == end)
+                return;
+            if (!values.empty()) {
+                while (begin != end)
+                    insertValue(values, (*begin++)->second);
+                return;
+            }
+
+            EntryList& list = values.m_list;
+            list.reserve(static_cast<size_t>(std::distance(begin, end)));
+            while (begin != end)
+                list.push_back(Entry((*begin++)->second, 1u));
+            std::sort(std::begin(list), std::end(list), [](const Entry& lhs, const Entry& rhs) { return lhs.first < rhs.first; });
+
+            // merge the entries of equal values
+            typename EntryList::iterator out = std::begin(list);
+            for (typename EntryList::iterator it = std::next(out); it != std::end(list); ++it) {
+                if (it->first == out->first)
+                    out->second += it->second;
+                else
+                    *(++out) = *it;
+            }
+            list.erase(std::next(out), std::end(list));
         }
         
         static void removeValue(ValueContainer& values, const V& value) {
-            typename ValueContainer::iterator it = values.find(value);
-            if (it == std::end(values))
+            if (values.m_list.size() > MaxListSize)
+                convertToMap(values);
+            if (!values.m_map.empty()) {
+                typename EntryMap::iterator it = values.m_map.find(value);
+                if (it == std::end(values.m_map))
+                    throw Exception("Cannot remove value from string map.");
+                if (it->second == 1)
+                    values.m_map.erase(it);
+                else
+                    --it->second;
+                return;
+            }
+
+            typename EntryList::iterator it = lowerBound(values.m_list, value);
+            if (it == std::end(values.m_list) || it->first != value)
                 throw Exception("Cannot remove value from string map.");
             if (it->second == 1)
-                values.erase(it);
+                values.m_list.erase(it);
             else
                 --it->second;
         }
         
         static void getValues(const ValueContainer& values, QueryResult& result) {
-            for (const auto& entry : values)
-                result.insert(entry.first);
+            for (const auto& entry : values.m_list)
+                result.insert(std::end(result), entry.first);
+            for (const auto& entry : values.m_map)
+                result.insert(std::end(result), entry.first);
+        }
+    private:
+        static void convertToMap(ValueContainer& values) {
+            values.m_map.insert(std::begin(values.m_list), std::end(values.m_list));
+            EntryList().swap(values.m_list);
+        }
+
+        static typename EntryList::iterator lowerBound(EntryList& list, const V& value) {
+            return std::lower_bound(std::begin(list), std::end(list), value,
+                                    [](const Entry& entry, const V& v) { return entry.first < v; });
         }
     };
 
+    /**
+     * A radix tree that maps string keys to values and supports exact, prefix and numbered queries.
+     *
+     * The children of each node are stored by value in a vector sorted by the first character of their keys, so
+     * looking up a child is a binary search over contiguous memory, and a node with several children needs only one
+     * allocation for all of them. Keys are matched in place at an offset, so queries do not copy any substrings.
+     */
     template <typename V, typename P>
     class StringMap {
     public:
         typedef typename P::QueryResult QueryResult;
+        typedef std::pair<String, V> KeyValue;
+        typedef std::vector<KeyValue> KeyValueList;
     private:
         class Node {
         private:
-            typedef std::set<Node> NodeSet;
+            typedef std::vector<Node> NodeList;
             typedef typename P::ValueContainer ValueContainer;
             
-            // The key is declared mutable because we must change it in splitNode and mergeNode, but the resulting new key
-            // will still compare equal to the old key.
-            mutable String m_key;
-            mutable ValueContainer m_values;
-            mutable NodeSet m_children;
+            String m_key;
+            ValueContainer m_values;
+            NodeList m_children;
         public:
             explicit Node(const String& key) :
             m_key(key) {}
-            
-            bool operator<(const Node& rhs) const {
-                const size_t firstDiff = StringUtils::findFirstDifference(m_key, rhs.m_key);
-                if (firstDiff == 0)
-                    return m_key[0] < rhs.m_key[0];
-                // both keys share a common prefix and are thus treated as the same
-                return false;
+
+            bool empty() const {
+                return m_values.empty() && m_children.empty();
             }
-            
+
             /*
              Possible cases for insertion:
               index: 01234567 |   | #m_key: 6
               m_key: target   | ^ | #key | conditions              | todo
              =================|===|======|=========================|======
               case:  key:     |   |      |                         |
-                 1:  targetli | 6 | 8    | ^ < #key AND ^ = #m_key | try insert in all children, if none match, create child 'li' and insert there;
+                 1:  targetli | 6 | 8    | ^ < #key AND ^ = #m_key | find or create child 'li' and insert there;
                            ^  |   |      |                         |
-                 2:  target   | 6 | 6    | ^ = #key AND ^ = #m_key | insert here; return true;
+                 2:  target   | 6 | 6    | ^ = #key AND ^ = #m_key | insert here;
                            ^  |   |      |                         |
                  3:  tarus    | 3 | 5    | ^ < #key AND ^ < #m_key | split this node in 'tar' and 'get'; create child 'us' and insert there;
                         ^     |   |      |                         |
-                 4:  tar      | 3 | 3    | ^ = #key AND ^ < #m_key | split this node in 'tar' and 'get'; insert here; return true;
+                 4:  tar      | 3 | 3    | ^ = #key AND ^ < #m_key | split this node in 'tar' and 'get'; insert here;
                         ^     |   |      |                         |
-                 5:  blah     | 0 | 4    | ^ = 0                   | return false;
+                 5:  blah     | 0 | 4    | ^ = 0                   | do nothing;
                      ^        |   |      |                         |
              ==================================================================================
-              ^ indicates where key and m_key first differ
+              ^ indicates where key and m_key first differ, #key is the length of the key remaining after offset
              */
-            void insert(const String& key, const V& value) const {
-                const size_t firstDiff = StringUtils::findFirstDifference(key, m_key);
+            void insert(const String& key, const size_t offset, const V& value) {
+                const size_t length = key.size() - offset;
+                const size_t firstDiff = matchKey(key, offset);
                 if (firstDiff == 0 && !m_key.empty())
                     // no common prefix
                     return;
-                if (firstDiff < key.size()) {
+                if (firstDiff < length) {
                     if (firstDiff < m_key.size()) {
                         // key and m_key share a common prefix, split this node and insert again
                         splitNode(firstDiff);
-                        insert(key, value);
-                    } else if (firstDiff == m_key.size()) {
-                        // m_key is a prefix of key, find or create a child that shares a common prefix with remainder, and insert there, and insert here
-                        const String remainder = key.substr(firstDiff);
-                        const Node& child = findOrCreateChild(remainder);
-                        child.insert(remainder, value);
+                        insert(key, offset, value);
+                    } else {
+                        // m_key is a prefix of key, find or create a child that shares a common prefix with the
+                        // remainder and insert there
+                        Node& child = findOrCreateChild(key, offset + firstDiff);
+                        child.insert(key, offset + firstDiff, value);
                     }
-                } else if (firstDiff == key.size()) {
-                    if (firstDiff < m_key.size()) {
+                } else {
+                    if (firstDiff < m_key.size())
                         // key is prefix of m_key, split this node and insert here
                         splitNode(firstDiff);
-                        insertValue(value);
-                    } else if (firstDiff == m_key.size()) {
-                        // keys are equal, insert here
-                        insertValue(value);
+                    P::insertValue(m_values, value);
+                }
+            }
+
+            /**
+             * Builds the subtree below this node from the given range of pointers to key value pairs, which is
+             * reordered in the process. Every key in the range must start with the keys of this node and its
+             * ancestors, which together have the given length. This is essentially a most significant digit radix sort
+             * of the keys, the given buffer is used to distribute the range and must be at least as large.
+             */
+            template <typename I>
+            void build(I begin, const I end, const size_t offset, I buffer) {
+                const I valuesEnd = std::partition(begin, end, [offset](const KeyValue* entry) { return entry->first.size() == offset; });
+                P::insertValues(m_values, begin, valuesEnd);
+                begin = valuesEnd;
+
+                // group the remaining keys by their next character, the children must be sorted by that character
+                sortByChar(begin, end, offset, buffer);
+
+                while (begin != end) {
+                    const String& first = (*begin)->first;
+                    const char c = first[offset];
+                    const I groupEnd = std::find_if(std::next(begin), end, [c, offset](const KeyValue* entry) { return entry->first[offset] != c; });
+
+                    // the key of the new child is the longest common prefix of the group
+                    size_t length = first.size();
+                    for (I it = std::next(begin); it != groupEnd && length > offset + 1; ++it) {
+                        const String& key = (*it)->first;
+                        size_t i = offset + 1;
+                        while (i < length && i < key.size() && key[i] == first[i])
+                            ++i;
+                        length = i;
                     }
+
+                    m_children.emplace_back(first.substr(offset, length - offset));
+                    m_children.back().build(begin, groupEnd, length, buffer);
+                    begin = groupEnd;
                 }
             }
             
-            bool remove(const String& key, const V& value) const {
-                const size_t firstDiff = StringUtils::findFirstDifference(key, m_key);
-                if (m_key.size() <= key.size() && firstDiff == m_key.size()) {
+            bool remove(const String& key, const size_t offset, const V& value) {
+                const size_t length = key.size() - offset;
+                const size_t firstDiff = matchKey(key, offset);
+                if (m_key.size() <= length && firstDiff == m_key.size()) {
                     // this node's key is a prefix of the given key
-                    if (firstDiff < key.size()) {
+                    if (firstDiff < length) {
                         // the given key is longer than this node's key, so we must continue at the appropriate child node
-                        const String remainder(key.substr(firstDiff));
-                        const Node query(remainder);
-                        typename NodeSet::iterator it = m_children.find(query);
+                        typename NodeList::iterator it = findChild(key, offset + firstDiff);
                         assert(it != std::end(m_children));
-                        const Node& child = *it;
-                        if (child.remove(remainder, value))
+                        if (it->remove(key, offset + firstDiff, value))
                             m_children.erase(it);
                     } else {
-                        removeValue(value);
+                        P::removeValue(m_values, value);
                     }
                     
                     if (!m_key.empty() && m_values.empty() && m_children.size() == 1)
@@ -176,81 +309,73 @@ namespace TrenchBroom {
                 return !m_key.empty() && m_values.empty() && m_children.empty();
             }
             
-            void queryExact(const String& key, QueryResult& result) const {
-                const size_t firstDiff = StringUtils::findFirstDifference(key, m_key);
+            void queryExact(const String& key, const size_t offset, QueryResult& result) const {
+                const size_t length = key.size() - offset;
+                const size_t firstDiff = matchKey(key, offset);
                 if (firstDiff == 0 && !m_key.empty())
                     // no common prefix
                     return;
-                if (firstDiff == key.size() && firstDiff <= m_key.size()) {
+                if (firstDiff == length) {
                     // this node represents the given (remaining) prefix
                     if (firstDiff == m_key.size())
-                        getValues(result);
-                } else if (firstDiff < key.size() && firstDiff == m_key.size()) {
+                        P::getValues(m_values, result);
+                } else if (firstDiff == m_key.size()) {
                     // this node is only a partial match, try to find a child to continue searching
-                    const String remainder(key.substr(firstDiff));
-                    const Node query(remainder);
-                    typename NodeSet::iterator it = m_children.find(query);
-                    if (it != std::end(m_children)) {
-                        const Node& child = *it;
-                        child.queryExact(remainder, result);
-                    }
+                    const typename NodeList::const_iterator it = findChild(key, offset + firstDiff);
+                    if (it != std::end(m_children))
+                        it->queryExact(key, offset + firstDiff, result);
                 }
             }
             
-            void queryPrefix(const String& prefix, QueryResult& result) const {
-                const size_t firstDiff = StringUtils::findFirstDifference(prefix, m_key);
+            void queryPrefix(const String& prefix, const size_t offset, QueryResult& result) const {
+                const size_t length = prefix.size() - offset;
+                const size_t firstDiff = matchKey(prefix, offset);
                 if (firstDiff == 0 && !m_key.empty())
                     // no common prefix
                     return;
-                if (firstDiff == prefix.size() && firstDiff <= m_key.size()) {
+                if (firstDiff == length) {
                     // the given prefix is a prefix of this node's key, collect all values in the subtree starting at
                     // this node
                     collectValues(result);
-                } else if (firstDiff < prefix.size() && firstDiff == m_key.size()) {
+                } else if (firstDiff == m_key.size()) {
                     // this node is only a partial match, try to find a child to continue searching
-                    const String remainder(prefix.substr(firstDiff));
-                    const Node query(remainder);
-                    typename NodeSet::iterator it = m_children.find(query);
-                    if (it != std::end(m_children)) {
-                        const Node& child = *it;
-                        child.queryPrefix(remainder, result);
-                    }
+                    const typename NodeList::const_iterator it = findChild(prefix, offset + firstDiff);
+                    if (it != std::end(m_children))
+                        it->queryPrefix(prefix, offset + firstDiff, result);
                 }
             }
             
             void collectValues(QueryResult& result) const {
-                getValues(result);
+                P::getValues(m_values, result);
                 for (const Node& child : m_children)
                     child.collectValues(result);
             }
             
-            void queryNumbered(const String& prefix, QueryResult& result) const {
-                const size_t firstDiff = StringUtils::findFirstDifference(prefix, m_key);
+            void queryNumbered(const String& prefix, const size_t offset, QueryResult& result) const {
+                const size_t length = prefix.size() - offset;
+                const size_t firstDiff = matchKey(prefix, offset);
                 if (firstDiff == 0 && !m_key.empty())
                     // no common prefix
                     return;
-                if (firstDiff == prefix.size() && firstDiff <= m_key.size()) {
+                if (firstDiff == length) {
                     // the given prefix is a prefix of this node's key
                     // if the remainder of this node's key is a number, add this node's values and continue searching
                     // the entire subtree starting at this node
-                    const String remainder(m_key.substr(firstDiff));
-                    if (StringUtils::isNumber(remainder)) {
-                        getValues(result);
+                    if (isNumber(firstDiff)) {
+                        P::getValues(m_values, result);
                         for (const Node& child : m_children)
                             child.collectIfNumbered(result);
                     }
-                } else if (firstDiff < prefix.size() && firstDiff == m_key.size()) {
+                } else if (firstDiff == m_key.size()) {
                     // this node is only a partial match, try to find a child to continue searching
-                    const String remainder(prefix.substr(firstDiff));
-                    const Node query(remainder);
                     for (const Node& child : m_children)
-                        child.queryNumbered(remainder, result);
+                        child.queryNumbered(prefix, offset + firstDiff, result);
                 }
             }
             
             void collectIfNumbered(QueryResult& result) const {
-                if (StringUtils::isNumber(m_key)) {
-                    getValues(result);
+                if (isNumber(0)) {
+                    P::getValues(m_values, result);
                     for (const Node& child : m_children)
                         child.collectIfNumbered(result);
                 }
@@ -266,112 +391,174 @@ namespace TrenchBroom {
                 }
             }
         private:
-            void insertValue(const V& value) const {
-                P::insertValue(m_values, value);
+            /**
+             * Sorts the given range of entries by the character at the given offset of their keys. This is a single
+             * counting sort pass of a radix sort, which distributes the entries into the given buffer and copies them
+             * back. Small ranges are sorted by insertion sort instead. The buffer must hold at least as many entries
+             * as the range.
+             */
+            template <typename I>
+            static void sortByChar(const I begin, const I end, const size_t offset, const I buffer) {
+                const size_t count = static_cast<size_t>(std::distance(begin, end));
+                if (count < 32) {
+                    // insertion sort is faster for small ranges
+                    for (I it = begin; it != end; ++it) {
+                        const KeyValue* entry = *it;
+                        const unsigned char c = static_cast<unsigned char>(entry->first[offset]);
+                        I pos = it;
+                        while (pos != begin && static_cast<unsigned char>((*std::prev(pos))->first[offset]) > c) {
+                            *pos = *std::prev(pos);
+                            --pos;
+                        }
+                        *pos = entry;
+                    }
+                    return;
+                }
+
+                size_t positions[256] = {};
+                for (I it = begin; it != end; ++it)
+                    ++positions[static_cast<unsigned char>((*it)->first[offset])];
+
+                size_t position = 0;
+                for (size_t& p : positions) {
+                    const size_t next = position + p;
+                    p = position;
+                    position = next;
+                }
+
+                for (I it = begin; it != end; ++it)
+                    buffer[static_cast<typename std::iterator_traits<I>::difference_type>(positions[static_cast<unsigned char>((*it)->first[offset])]++)] = *it;
+                std::copy(buffer, std::next(buffer, static_cast<typename std::iterator_traits<I>::difference_type>(count)), begin);
             }
-            
-            void removeValue(const V& value) const {
-                P::removeValue(m_values, value);
+
+            /**
+             * Returns the length of the common prefix of this node's key and the given key starting at the given
+             * offset.
+             */
+            size_t matchKey(const String& key, const size_t offset) const {
+                const size_t max = std::min(m_key.size(), key.size() - offset);
+                size_t index = 0;
+                while (index < max && m_key[index] == key[offset + index])
+                    ++index;
+                return index;
+            }
+
+            bool isNumber(const size_t offset) const {
+                for (size_t i = offset; i < m_key.size(); ++i) {
+                    if (m_key[i] < '0' || m_key[i] > '9')
+                        return false;
+                }
+                return true;
+            }
+
+            typename NodeList::iterator lowerBound(const char c) {
+                return std::lower_bound(std::begin(m_children), std::end(m_children), c,
+                                        [](const Node& child, const char ch) { return child.m_key[0] < ch; });
+            }
+
+            typename NodeList::iterator findChild(const String& key, const size_t offset) {
+                const char c = key[offset];
+                const typename NodeList::iterator it = lowerBound(c);
+                if (it == std::end(m_children) || it->m_key[0] != c)
+                    return std::end(m_children);
+                return it;
+            }
+
+            typename NodeList::const_iterator findChild(const String& key, const size_t offset) const {
+                return const_cast<Node*>(this)->findChild(key, offset);
             }
             
-            const Node& findOrCreateChild(const String& key) const {
-                std::pair<typename NodeSet::iterator, bool> result = m_children.insert(Node(key));
-                typename NodeSet::iterator it = result.first;
-                return *it;
+            Node& findOrCreateChild(const String& key, const size_t offset) {
+                const char c = key[offset];
+                const typename NodeList::iterator it = lowerBound(c);
+                if (it != std::end(m_children) && it->m_key[0] == c)
+                    return *it;
+                return *m_children.insert(it, Node(key.substr(offset)));
             }
             
-            void splitNode(const size_t index) const {
+            void splitNode(const size_t index) {
                 using std::swap;
 
                 assert(m_key.size() > 1);
                 ensure(index < m_key.size(), "index out of range");
-                
-                const String newKey = m_key.substr(0, index);
-                const String remainder = m_key.substr(index);
 
-                // We want to avoid copying the children of this node to the new child, therefore we swap with an empty
-                // node set. Afterwards this node's children are empty.
-                NodeSet newChildren;
-                swap(newChildren, m_children);
-
-                const Node& newChild = findOrCreateChild(remainder);
-                swap(newChild.m_children, newChildren);
+                // We want to avoid copying the children of this node to the new child, therefore we swap them.
+                // Afterwards this node's children are empty.
+                Node newChild(m_key.substr(index));
+                swap(newChild.m_children, m_children);
                 swap(newChild.m_values, m_values);
                 
-                m_key = newKey;
+                m_key.erase(index);
+                m_children.push_back(std::move(newChild));
             }
             
-            void mergeNode() const {
-                using std::swap;
-
+            void mergeNode() {
                 assert(m_children.size() == 1);
                 assert(m_values.empty());
                 
-                NodeSet oldChildren;
-                swap(oldChildren, m_children);
-                
-                const Node& child = *std::begin(oldChildren);
-                swap(m_children, child.m_children);
-                swap(m_values, child.m_values);
-                
+                Node child = std::move(m_children.front());
                 m_key += child.m_key;
-            }
-            
-            void getValues(QueryResult& result) const {
-                P::getValues(m_values, result);
+                m_values = std::move(child.m_values);
+                m_children = std::move(child.m_children);
             }
         };
         
-        Node* m_root;
+        Node m_root;
     public:
         StringMap() :
-        m_root(new Node("")) {}
-        
-        ~StringMap() {
-            delete m_root;
-            m_root = nullptr;
-        }
+        m_root("") {}
         
         void insert(const String& key, const V& value) {
-            ensure(m_root != nullptr, "root is null");
-            m_root->insert(key, value);
+            m_root.insert(key, 0, value);
+        }
+
+        /**
+         * Inserts all of the given key value pairs. If this map is empty, the tree is built top down by grouping the
+         * keys level by level, which avoids splitting and searching nodes for every insertion.
+         */
+        void insert(const KeyValueList& keyValues) {
+            if (!m_root.empty()) {
+                for (const auto& keyValue : keyValues)
+                    insert(keyValue.first, keyValue.second);
+            } else {
+                std::vector<const KeyValue*> entries;
+                entries.reserve(keyValues.size());
+                for (const auto& keyValue : keyValues)
+                    entries.push_back(&keyValue);
+                std::vector<const KeyValue*> buffer(entries.size());
+                m_root.build(std::begin(entries), std::end(entries), 0, std::begin(buffer));
+            }
         }
         
         void remove(const String& key, const V& value) {
-            ensure(m_root != nullptr, "root is null");
-            m_root->remove(key, value);
+            m_root.remove(key, 0, value);
         }
         
         void clear() {
-            delete m_root;
-            m_root = new Node("");
+            m_root = Node("");
         }
         
         QueryResult queryPrefixMatches(const String& prefix) const {
-            ensure(m_root != nullptr, "root is null");
             QueryResult result;
-            m_root->queryPrefix(prefix, result);
+            m_root.queryPrefix(prefix, 0, result);
             return result;
         }
         
         QueryResult queryNumberedMatches(const String& prefix) const {
-            ensure(m_root != nullptr, "root is null");
             QueryResult result;
-            m_root->queryNumbered(prefix, result);
+            m_root.queryNumbered(prefix, 0, result);
             return result;
         }
         
         QueryResult queryExactMatches(const String& prefix) const {
-            ensure(m_root != nullptr, "root is null");
             QueryResult result;
-            m_root->queryExact(prefix, result);
+            m_root.queryExact(prefix, 0, result);
             return result;
         }
         
         StringList getKeys() const {
-            ensure(m_root != nullptr, "root is null");
             StringList result;
-            m_root->getKeys("", result);
+            m_root.getKeys("", result);
             return result;
         }
     private:
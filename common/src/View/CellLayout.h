@@ -26,6 +26,7 @@
 #include <cassert>
 #include <limits>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace TrenchBroom {
@@ -306,12 +307,40 @@ namespace TrenchBroom {
             }
         };
 
+        /**
+         * A group of cells that are arranged in rows.
+         *
+         * The group only keeps the items and the extents of its rows. The cells of a row are materialized when the
+         * row is accessed for the first time, so that a view only builds the rows that it actually renders. If all
+         * rows have the same height, the row at a given position is computed arithmetically.
+         */
         template <typename CellType, typename GroupType>
         class LayoutGroup {
         public:
             typedef LayoutRow<CellType> Row;
-            typedef std::vector<Row> RowList;
+
+            struct Item {
+                CellType item;
+                float itemWidth;
+                float itemHeight;
+                float titleWidth;
+                float titleHeight;
+            };
+            typedef std::vector<Item> ItemList;
         private:
+            struct RowInfo {
+                size_t first;
+                size_t count;
+                float top;
+                float height;
+
+                float bottom() const {
+                    return top + height;
+                }
+            };
+            typedef std::vector<RowInfo> RowInfoList;
+            typedef std::vector<std::unique_ptr<Row>> RowList;
+
             GroupType m_item;
             float m_cellMargin;
             float m_titleMargin;
@@ -325,11 +354,21 @@ namespace TrenchBroom {
             LayoutBounds m_titleBounds;
             LayoutBounds m_contentBounds;
 
-            RowList m_rows;
+            ItemList m_items;
+            RowInfoList m_rowInfos;
+            bool m_uniformRows; // whether all rows except the last one have the same height as the first one
+
+            // the last row, which receives the next item
+            std::unique_ptr<Row> m_lastRow;
+            mutable RowList m_rows;
         public:
             const Row& operator[] (const size_t index) const {
-                ensure(index >= 0 && index < m_rows.size(), "index out of range");
-                return m_rows[index];
+                ensure(index >= 0 && index < m_rowInfos.size(), "index out of range");
+                if (m_rows.size() < m_rowInfos.size())
+                    m_rows.resize(m_rowInfos.size());
+                if (m_rows[index] == nullptr)
+                    m_rows[index] = createRow(m_rowInfos[index]);
+                return *m_rows[index];
             }
 
             LayoutGroup(GroupType item,
@@ -353,7 +392,7 @@ namespace TrenchBroom {
             m_maxCellHeight(maxCellHeight),
             m_titleBounds(0.0f, y, width + 2.0f * x, titleHeight),
             m_contentBounds(x, y + titleHeight + m_rowMargin, width, 0.0f),
-            m_rows() {}
+            m_uniformRows(true) {}
 
             LayoutGroup(const float x, const float y,
                         const float cellMargin, const float titleMargin, const float rowMargin,
@@ -373,67 +412,72 @@ namespace TrenchBroom {
             m_maxCellHeight(maxCellHeight),
             m_titleBounds(x, y, width, 0.0f),
             m_contentBounds(x, y, width, 0.0f),
-            m_rows() {}
+            m_uniformRows(true) {}
 
             void addItem(CellType item,
                          const float itemWidth, const float itemHeight,
                          const float titleWidth, const float titleHeight) {
-                if (m_rows.empty()) {
-                    const float y = m_contentBounds.top();
-                    m_rows.push_back(Row(m_contentBounds.left(), y, m_cellMargin, m_titleMargin, m_contentBounds.width(), m_maxCellsPerRow, m_maxUpScale, m_minCellWidth, m_maxCellWidth, m_minCellHeight, m_maxCellHeight));
-                }
+                m_items.push_back(Item { item, itemWidth, itemHeight, titleWidth, titleHeight });
 
-                const LayoutBounds oldBounds = m_rows.back().bounds();
-                const float oldRowHeight = m_rows.back().bounds().height();
-                if (!m_rows.back().addItem(item, itemWidth, itemHeight, titleWidth, titleHeight)) {
-                    const float y = oldBounds.bottom() + m_rowMargin;
-                    m_rows.push_back(Row(m_contentBounds.left(), y, m_cellMargin, m_titleMargin, m_contentBounds.width(), m_maxCellsPerRow, m_maxUpScale, m_minCellWidth, m_maxCellWidth, m_minCellHeight, m_maxCellHeight));
+                if (m_rowInfos.empty())
+                    startRow(m_contentBounds.top());
 
-                    const bool added = (m_rows.back().addItem(item, itemWidth, itemHeight, titleWidth, titleHeight));
+                const float oldRowHeight = m_lastRow->bounds().height();
+                if (!m_lastRow->addItem(item, itemWidth, itemHeight, titleWidth, titleHeight)) {
+                    const RowInfo& lastRow = m_rowInfos.back();
+                    if (lastRow.height != m_rowInfos.front().height)
+                        m_uniformRows = false;
+                    startRow(lastRow.bottom() + m_rowMargin);
+
+                    const bool added = (m_lastRow->addItem(item, itemWidth, itemHeight, titleWidth, titleHeight));
                     assert(added);
                     unused(added);
 
-                    const float newRowHeight = m_rows.back().bounds().height();
+                    const float newRowHeight = m_lastRow->bounds().height();
                     m_contentBounds = LayoutBounds(m_contentBounds.left(), m_contentBounds.top(), m_contentBounds.width(), m_contentBounds.height() + newRowHeight + m_rowMargin);
                 } else {
-                    const float newRowHeight = m_rows.back().bounds().height();
+                    const float newRowHeight = m_lastRow->bounds().height();
                     m_contentBounds = LayoutBounds(m_contentBounds.left(), m_contentBounds.top(), m_contentBounds.width(), m_contentBounds.height() + (newRowHeight - oldRowHeight));
                 }
+
+                RowInfo& lastRow = m_rowInfos.back();
+                lastRow.count += 1;
+                lastRow.height = m_lastRow->bounds().height();
+
+                // the last row might have been materialized before
+                if (m_rows.size() >= m_rowInfos.size())
+                    m_rows[m_rowInfos.size() - 1].reset();
             }
 
             size_t indexOfRowAt(const float y) const {
-                for (size_t i = 0; i < m_rows.size(); ++i) {
-                    const Row& row = m_rows[i];
-                    const LayoutBounds& rowBounds = row.bounds();
-                    if (y < rowBounds.bottom())
-                        return i;
-                }
-                
-                return m_rows.size();
+                return findRow(y, [y](const RowInfo& row) { return y >= row.bottom(); });
             }
             
             bool rowAt(const float y, const Row** result) const {
                 size_t index = indexOfRowAt(y);
-                if (index == m_rows.size())
+                if (index == m_rowInfos.size())
                     return false;
                 
-                *result = &m_rows[index];
+                *result = &(*this)[index];
                 return true;
             }
+
+            /**
+             * Returns the half open range of the indices of the rows that intersect the given vertical range.
+             */
+            std::pair<size_t, size_t> rowsIntersectingY(const float y, const float height) const {
+                const size_t first = findRow(y, [y](const RowInfo& row) { return y > row.bottom(); });
+                size_t last = first;
+                while (last < m_rowInfos.size() && m_rowInfos[last].top <= y + height)
+                    ++last;
+                return std::make_pair(first, last);
+            }
             
             bool cellAt(const float x, const float y, const typename Row::Cell** result) const {
-                for (size_t i = 0; i < m_rows.size(); ++i) {
-                    const Row& row = m_rows[i];
-                    const LayoutBounds& rowBounds = row.bounds();
-                    if (y > rowBounds.bottom())
-                        continue;
-                    else if (y < rowBounds.top())
-                        break;
-                    if (row.cellAt(x, y, result))
-                        return true;
-                }
-
-                return false;
+                const size_t index = findRow(y, [y](const RowInfo& row) { return y > row.bottom(); });
+                if (index == m_rowInfos.size() || y < m_rowInfos[index].top)
+                    return false;
+                return (*this)[index].cellAt(x, y, result);
             }
 
             bool hitTest(const float x, const float y) const {
@@ -469,8 +513,66 @@ namespace TrenchBroom {
                 return m_item;
             }
 
+            const ItemList& items() const {
+                return m_items;
+            }
+
             size_t size() const {
-                return m_rows.size();
+                return m_rowInfos.size();
+            }
+        private:
+            void startRow(const float y) {
+                m_rowInfos.push_back(RowInfo { m_items.size() - 1, 0, y, 0.0f });
+                m_lastRow = createRow(m_rowInfos.back());
+            }
+
+            std::unique_ptr<Row> createRow(const RowInfo& rowInfo) const {
+                std::unique_ptr<Row> row(new Row(m_contentBounds.left(), rowInfo.top, m_cellMargin, m_titleMargin, m_contentBounds.width(), m_maxCellsPerRow, m_maxUpScale, m_minCellWidth, m_maxCellWidth, m_minCellHeight, m_maxCellHeight));
+                for (size_t i = rowInfo.first; i < rowInfo.first + rowInfo.count; ++i) {
+                    const Item& item = m_items[i];
+                    const bool added = row->addItem(item.item, item.itemWidth, item.itemHeight, item.titleWidth, item.titleHeight);
+                    assert(added);
+                    unused(added);
+                }
+                return row;
+            }
+
+            /**
+             * Returns the index of the first row for which the given predicate is false, assuming that the predicate
+             * is true for some prefix of the rows. The index is computed from the row height if all rows have the
+             * same height, and otherwise by a binary search.
+             */
+            template <typename P>
+            size_t findRow(const float y, const P& isAbove) const {
+                if (m_rowInfos.empty())
+                    return 0;
+
+                if (m_uniformRows) {
+                    const RowInfo& firstRow = m_rowInfos.front();
+                    const float stride = firstRow.height + m_rowMargin;
+                    const float offset = std::max(0.0f, y - firstRow.top);
+
+                    // the row positions were accumulated, so the result may be off by one
+                    size_t index = stride > 0.0f ? std::min(static_cast<size_t>(offset / stride), m_rowInfos.size()) : 0;
+                    while (index > 0 && !isAbove(m_rowInfos[index - 1]))
+                        --index;
+                    while (index < m_rowInfos.size() && isAbove(m_rowInfos[index]))
+                        ++index;
+                    return index;
+                }
+
+                size_t first = 0;
+                size_t count = m_rowInfos.size();
+                while (count > 0) {
+                    const size_t step = count / 2;
+                    if (isAbove(m_rowInfos[first + step])) {
+                        first += step + 1;
+                        count -= step + 1;
+                    } else {
+                        count = step;
+                    }
+                }
+                return first;
             }
         };
 
@@ -504,24 +606,14 @@ namespace TrenchBroom {
                 m_height = 2.0f * m_outerMargin;
                 m_valid = true;
                 if (!m_groups.empty()) {
-                    GroupList copy = m_groups;
-                    m_groups.clear();
+                    GroupList groups;
+                    using std::swap;
+                    swap(groups, m_groups);
 
-                    for (size_t i = 0; i < copy.size(); ++i) {
-                        Group& group = copy[i];
+                    for (const Group& group : groups) {
                         addGroup(group.item(), group.titleBounds().height());
-                        for (size_t j = 0; j < group.size(); ++j) {
-                            const typename Group::Row& row = group[j];
-                            for (size_t k = 0; k < row.size(); k++) {
-                                const typename Group::Row::Cell& cell = row[k];
-                                const LayoutBounds& itemBounds = cell.itemBounds();
-                                const LayoutBounds& titleBounds = cell.titleBounds();
-                                float scale = cell.scale();
-                                float itemWidth = itemBounds.width() / scale;
-                                float itemHeight = itemBounds.height() / scale;
-                                addItem(cell.item(), itemWidth, itemHeight, titleBounds.width(), titleBounds.height());
-                            }
-                        }
+                        for (const typename Group::Item& item : group.items())
+                            addItem(item.item, item.itemWidth, item.itemHeight, item.titleWidth, item.titleHeight);
                     }
                 }
             }
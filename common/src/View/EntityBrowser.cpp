@@ -137,6 +137,7 @@ namespace TrenchBroom {
             document->documentWasLoadedNotifier.addObserver(this, &EntityBrowser::documentWasLoaded);
             document->modsDidChangeNotifier.addObserver(this, &EntityBrowser::modsDidChange);
             document->entityDefinitionsDidChangeNotifier.addObserver(this, &EntityBrowser::entityDefinitionsDidChange);
+            document->entityModelsDidChangeNotifier.addObserver(this, &EntityBrowser::entityModelsDidChange);
             
             PreferenceManager& prefs = PreferenceManager::instance();
             prefs.preferenceDidChangeNotifier.addObserver(this, &EntityBrowser::preferenceDidChange);
@@ -149,6 +150,7 @@ namespace TrenchBroom {
                 document->documentWasLoadedNotifier.removeObserver(this, &EntityBrowser::documentWasLoaded);
                 document->modsDidChangeNotifier.removeObserver(this, &EntityBrowser::modsDidChange);
                 document->entityDefinitionsDidChangeNotifier.removeObserver(this, &EntityBrowser::entityDefinitionsDidChange);
+                document->entityModelsDidChangeNotifier.removeObserver(this, &EntityBrowser::entityModelsDidChange);
             }
             
             PreferenceManager& prefs = PreferenceManager::instance();
@@ -171,6 +173,10 @@ namespace TrenchBroom {
             reload();
         }
 
+        void EntityBrowser::entityModelsDidChange() {
+            reload();
+        }
+
         void EntityBrowser::preferenceDidChange(const IO::Path& path) {
             MapDocumentSPtr document = lock(m_document);
             if (document->isGamePathPreference(path))
@@ -71,6 +71,7 @@ namespace TrenchBroom {
             
             void modsDidChange();
             void entityDefinitionsDidChange();
+            void entityModelsDidChange();
             void preferenceDidChange(const IO::Path& path);
         };
     }
@@ -57,6 +57,10 @@ namespace TrenchBroom {
         fontDescriptor(i_fontDescriptor),
         bounds(i_bounds) {}
 
+        EntityBrowserView::EntityTitleCache::EntityTitleCache(const Renderer::FontDescriptor& i_font, const float i_maxCellWidth) :
+        font(i_font),
+        maxCellWidth(i_maxCellWidth) {}
+
         EntityBrowserView::EntityBrowserView(wxWindow* parent,
                                              wxScrollBar* scrollBar,
                                              GLContextManager& contextManager,
@@ -134,6 +138,7 @@ namespace TrenchBroom {
             assert(fontSize > 0);
             
             const Renderer::FontDescriptor font(fontPath, static_cast<size_t>(fontSize));
+            const String filterText = StringUtils::toLower(m_filterText);
             
             if (m_group) {
                 for (const Assets::EntityDefinitionGroup& group : m_entityDefinitionManager.groups()) {
@@ -145,7 +150,7 @@ namespace TrenchBroom {
 
                         for (Assets::EntityDefinition* definition : definitions) {
                             Assets::PointEntityDefinition* pointEntityDefinition = static_cast<Assets::PointEntityDefinition*>(definition);
-                            addEntityToLayout(layout, pointEntityDefinition, font);
+                            addEntityToLayout(layout, pointEntityDefinition, font, filterText);
                         }
                     }
                 }
@@ -153,7 +158,7 @@ namespace TrenchBroom {
                 const Assets::EntityDefinitionList& definitions = m_entityDefinitionManager.definitions(Assets::EntityDefinition::Type_PointEntity, m_sortOrder);
                 for (Assets::EntityDefinition* definition : definitions) {
                     Assets::PointEntityDefinition* pointEntityDefinition = static_cast<Assets::PointEntityDefinition*>(definition);
-                    addEntityToLayout(layout, pointEntityDefinition, font);
+                    addEntityToLayout(layout, pointEntityDefinition, font, filterText);
                 }
             }
         }
@@ -180,14 +185,12 @@ namespace TrenchBroom {
             return wxString(prefix + name);
         }
 
-        void EntityBrowserView::addEntityToLayout(Layout& layout, Assets::PointEntityDefinition* definition, const Renderer::FontDescriptor& font) {
-            if ((!m_hideUnused || definition->usageCount() > 0) &&
-                (m_filterText.empty() || StringUtils::containsCaseInsensitive(definition->name(), m_filterText))) {
-                
-                const auto maxCellWidth = layout.maxCellWidth();
-                const auto actualFont = fontManager().selectFontSize(font, definition->name(), maxCellWidth, 5);
-                const auto actualSize = fontManager().font(actualFont).measure(definition->name());
-                
+        void EntityBrowserView::addEntityToLayout(Layout& layout, Assets::PointEntityDefinition* definition, const Renderer::FontDescriptor& font, const String& filterText) {
+            if (m_hideUnused && definition->usageCount() == 0)
+                return;
+
+            const EntityTitle& title = entityTitle(definition, font, layout.maxCellWidth());
+            if (filterText.empty() || title.lowercaseName.find(filterText) != String::npos) {
                 const auto spec = definition->defaultModel();
                 auto* model = safeGetModel(m_entityModelManager, spec, m_logger);
                 EntityRenderer* modelRenderer = nullptr;
@@ -206,14 +209,28 @@ namespace TrenchBroom {
                 }
 
                 const vm::vec3f boundsSize = rotatedBounds.size();
-                layout.addItem(EntityCellData(definition, modelRenderer, actualFont, rotatedBounds),
+                layout.addItem(EntityCellData(definition, modelRenderer, title.font, rotatedBounds),
                                boundsSize.y(),
                                boundsSize.z(),
-                               actualSize.x(),
+                               title.width,
                                font.size() + 2.0f);
             }
         }
 
+        const EntityBrowserView::EntityTitle& EntityBrowserView::entityTitle(const Assets::PointEntityDefinition* definition, const Renderer::FontDescriptor& font, const float maxCellWidth) {
+            if (m_titleCache == nullptr || m_titleCache->font.compare(font) != 0 || m_titleCache->maxCellWidth != maxCellWidth)
+                m_titleCache = std::make_unique<EntityTitleCache>(font, maxCellWidth);
+
+            const String& name = definition->name();
+            auto it = m_titleCache->titles.find(name);
+            if (it == std::end(m_titleCache->titles)) {
+                const auto actualFont = fontManager().selectFontSize(font, name, maxCellWidth, 5);
+                const auto actualSize = fontManager().font(actualFont).measure(name);
+                it = m_titleCache->titles.insert(std::make_pair(name, EntityTitle { StringUtils::toLower(name), actualFont, actualSize.x() })).first;
+            }
+            return it->second;
+        }
+
         void EntityBrowserView::doClear() {}
         
         void EntityBrowserView::doRender(Layout& layout, const float y, const float height) {
@@ -259,7 +276,8 @@ namespace TrenchBroom {
             for (size_t i = 0; i < layout.size(); ++i) {
                 const Layout::Group& group = layout[i];
                 if (group.intersectsY(y, height)) {
-                    for (size_t j = 0; j < group.size(); ++j) {
+                    const auto rows = group.rowsIntersectingY(y, height);
+                    for (size_t j = rows.first; j < rows.second; ++j) {
                         const Layout::Group::Row& row = group[j];
                         if (row.intersectsY(y, height)) {
                             for (size_t k = 0; k < row.size(); ++k) {
@@ -301,7 +319,8 @@ namespace TrenchBroom {
             for (size_t i = 0; i < layout.size(); ++i) {
                 const Layout::Group& group = layout[i];
                 if (group.intersectsY(y, height)) {
-                    for (size_t j = 0; j < group.size(); ++j) {
+                    const auto rows = group.rowsIntersectingY(y, height);
+                    for (size_t j = rows.first; j < rows.second; ++j) {
                         const Layout::Group::Row& row = group[j];
                         if (row.intersectsY(y, height)) {
                             for (size_t k = 0; k < row.size(); ++k) {
@@ -407,7 +426,8 @@ namespace TrenchBroom {
                         VectorUtils::append(stringVertices[defaultDescriptor], titleVertices);
                     }
                     
-                    for (size_t j = 0; j < group.size(); ++j) {
+                    const auto rows = group.rowsIntersectingY(y, height);
+                    for (size_t j = rows.first; j < rows.second; ++j) {
                         const Layout::Group::Row& row = group[j];
                         if (row.intersectsY(y, height)) {
                             for (unsigned int k = 0; k < row.size(); k++) {
@@ -29,6 +29,9 @@
 #include <vecmath/quat.h>
 #include <vecmath/bbox.h>
 
+#include <map>
+#include <memory>
+
 namespace TrenchBroom {
     class Logger;
 
@@ -67,6 +70,24 @@ namespace TrenchBroom {
             typedef Renderer::VertexSpecs::P2T2C4::Vertex TextVertex;
             typedef std::map<Renderer::FontDescriptor, TextVertex::List> StringMap;
 
+            /**
+             * The parts of a cell that only depend on the entity definition name. These are kept by name, so they
+             * remain valid when the entity definitions are reloaded.
+             */
+            struct EntityTitle {
+                String lowercaseName;
+                Renderer::FontDescriptor font;
+                float width;
+            };
+
+            struct EntityTitleCache {
+                Renderer::FontDescriptor font;
+                float maxCellWidth;
+                std::map<String, EntityTitle> titles;
+
+                EntityTitleCache(const Renderer::FontDescriptor& i_font, float i_maxCellWidth);
+            };
+
             Assets::EntityDefinitionManager& m_entityDefinitionManager;
             Assets::EntityModelManager& m_entityModelManager;
             Logger& m_logger;
@@ -76,6 +97,8 @@ namespace TrenchBroom {
             bool m_hideUnused;
             Assets::EntityDefinition::SortOrder m_sortOrder;
             String m_filterText;
+
+            std::unique_ptr<EntityTitleCache> m_titleCache;
         public:
             EntityBrowserView(wxWindow* parent,
                               wxScrollBar* scrollBar,
@@ -100,7 +123,8 @@ namespace TrenchBroom {
             void dndDidEnd() override;
             wxString dndData(const Layout::Group::Row::Cell& cell) override;
 
-            void addEntityToLayout(Layout& layout, Assets::PointEntityDefinition* definition, const Renderer::FontDescriptor& font);
+            void addEntityToLayout(Layout& layout, Assets::PointEntityDefinition* definition, const Renderer::FontDescriptor& font, const String& filterText);
+            const EntityTitle& entityTitle(const Assets::PointEntityDefinition* definition, const Renderer::FontDescriptor& font, float maxCellWidth);
             
             void doClear() override;
             void doRender(Layout& layout, float y, float height) override;
@@ -69,6 +69,43 @@ namespace TrenchBroom {
             return m_transform * hitPoint;
         }
 
+        std::vector<vm::plane3> Lasso::planes() const {
+            static const auto margin = 1.0;
+
+            const auto box = this->box();
+            const auto [invertible, inverseTransform] = invert(m_transform);
+            assert(invertible); unused(invertible);
+
+            const vm::vec3 corners[4] = {
+                inverseTransform * vm::vec3(box.min.x(), box.min.y(), 0.0),
+                inverseTransform * vm::vec3(box.min.x(), box.max.y(), 0.0),
+                inverseTransform * vm::vec3(box.max.x(), box.max.y(), 0.0),
+                inverseTransform * vm::vec3(box.max.x(), box.min.y(), 0.0)
+            };
+            const auto center = inverseTransform * vm::vec3(box.center().x(), box.center().y(), 0.0);
+
+            std::vector<vm::plane3> result;
+            result.reserve(4);
+            for (size_t i = 0; i < 4; ++i) {
+                const auto& a = corners[i];
+                const auto& b = corners[(i + 1) % 4];
+
+                // the plane contains the edge and the pick ray through its start
+                const auto rayDirection = vm::vec3(m_camera.pickRay(vm::vec3f(a)).direction);
+                const auto normal = cross(b - a, rayDirection);
+                if (vm::isZero(normal, vm::C::almostZero())) {
+                    return std::vector<vm::plane3>();
+                }
+
+                auto plane = vm::plane3(a, normalize(normal));
+                if (plane.pointStatus(center) == vm::point_status::above) {
+                    plane = plane.flip();
+                }
+                result.push_back(vm::plane3(plane.distance + margin, plane.normal));
+            }
+            return result;
+        }
+
         void Lasso::render(Renderer::RenderContext& renderContext, Renderer::RenderBatch& renderBatch) const {
             const auto box = this->box();
             const auto [invertible, inverseTransform] = invert(m_transform);
@@ -21,9 +21,12 @@
 #define TrenchBroom_Lasso
 
 #include "TrenchBroom.h"
+#include "ParallelUtils.h"
 
 #include <vecmath/plane.h>
 
+#include <vector>
+
 namespace TrenchBroom {
     namespace Renderer {
         class Camera;
@@ -44,12 +47,25 @@ namespace TrenchBroom {
             
             void update(const vm::vec3& point);
             
+            /**
+             * Appends every element of the given range that is selected by this lasso to the given output iterator,
+             * preserving their order. The elements are tested in parallel.
+             *
+             * @tparam I the range iterator type, must be a random access iterator
+             * @tparam O the output iterator type
+             * @param cur the range start iterator
+             * @param end the range end iterator
+             * @param out the output iterator
+             */
             template <typename I, typename O>
             void selected(I cur, I end, O out) const {
                 const vm::plane3 plane = this->plane();
                 const vm::bbox2 box = this->box();
-                while (cur != end) {
-                    if (selects(*cur, plane, box))
+                const auto selection = ParallelUtils::parallelTransform(cur, end, [&](const auto& h) {
+                    return static_cast<char>(selects(h, plane, box));
+                });
+                for (const char selected : selection) {
+                    if (selected)
                         out = *cur;
                     ++cur;
                 }
@@ -65,6 +81,15 @@ namespace TrenchBroom {
             bool selects(const vm::polygon3& polygon, const vm::plane3& plane, const vm::bbox2& box) const;
             vm::vec3 project(const vm::vec3& point, const vm::plane3& plane) const;
         public:
+            /**
+             * Returns the planes that bound the volume of space selected by this lasso. This volume is a pyramid
+             * for a perspective camera and a prism for an orthographic camera. The planes are moved slightly outward
+             * so that they can be used to find candidates for the selection test.
+             *
+             * @return the bounding planes, or an empty list if the lasso is degenerate
+             */
+            std::vector<vm::plane3> planes() const;
+
             void render(Renderer::RenderContext& renderContext, Renderer::RenderBatch& renderBatch) const;
         private:
             vm::plane3 plane() const;
@@ -19,6 +19,7 @@
 
 #include "View/MapDocument.h"
 
+#include "ParallelUtils.h"
 #include "PreferenceManager.h"
 #include "Preferences.h"
 #include "Polyhedron.h"
@@ -37,14 +38,13 @@
 #include "Model/BrushGeometry.h"
 #include "Model/ChangeBrushFaceAttributesRequest.h"
 #include "Model/CollectAttributableNodesVisitor.h"
-#include "Model/CollectContainedNodesVisitor.h"
 #include "Model/CollectMatchingBrushFacesVisitor.h"
+#include "Model/CollectMatchingNodesVisitor.h"
 #include "Model/CollectNodesVisitor.h"
 #include "Model/CollectNodesByVisibilityVisitor.h"
 #include "Model/CollectSelectableNodesVisitor.h"
 #include "Model/CollectSelectableNodesWithFilePositionVisitor.h"
 #include "Model/CollectSelectedNodesVisitor.h"
-#include "Model/CollectTouchingNodesVisitor.h"
 #include "Model/CollectUniqueNodesVisitor.h"
 #include "Model/ComputeNodeBoundsVisitor.h"
 #include "Model/EditorContext.h"
@@ -509,13 +509,35 @@ namespace TrenchBroom {
             select(visitor.nodes());
         }
         
+        class MatchNodesInSet {
+        private:
+            const Model::NodeSet& m_nodes;
+        public:
+            explicit MatchNodesInSet(const Model::NodeSet& nodes) :
+            m_nodes(nodes) {}
+
+            bool operator()(Model::Node* node) const {
+                return m_nodes.count(node) > 0;
+            }
+        };
+
+        /**
+         * Returns the given nodes in the order in which they appear in the document. Callers such as csgSubtract
+         * depend on the order of the selected brushes, so nodes found by a spatial query must be selected in the same
+         * order as if they had been found by visiting the document.
+         */
+        static Model::NodeList sortInDocumentOrder(Model::World* world, const Model::NodeList& nodes) {
+            const Model::NodeSet nodeSet(std::begin(nodes), std::end(nodes));
+
+            Model::CollectMatchingNodesVisitor<MatchNodesInSet> visitor((MatchNodesInSet(nodeSet)));
+            world->acceptAndRecurse(visitor);
+            return visitor.nodes();
+        }
+
         void MapDocument::selectTouching(const bool del) {
             const Model::BrushList& brushes = m_selectedNodes.brushes();
             
-            Model::CollectTouchingNodesVisitor<Model::BrushList::const_iterator> visitor(std::begin(brushes), std::end(brushes), editorContext());
-            m_world->acceptAndRecurse(visitor);
-            
-            const Model::NodeList nodes = visitor.nodes();
+            const Model::NodeList nodes = sortInDocumentOrder(m_world, m_world->findNodesTouching(brushes, editorContext()));
             
             Transaction transaction(this, "Select Touching");
             if (del)
@@ -528,10 +550,7 @@ namespace TrenchBroom {
         void MapDocument::selectInside(const bool del) {
             const Model::BrushList& brushes = m_selectedNodes.brushes();
 
-            Model::CollectContainedNodesVisitor<Model::BrushList::const_iterator> visitor(std::begin(brushes), std::end(brushes), editorContext());
-            m_world->acceptAndRecurse(visitor);
-            
-            const Model::NodeList nodes = visitor.nodes();
+            const Model::NodeList nodes = sortInDocumentOrder(m_world, m_world->findNodesContainedIn(brushes, editorContext()));
 
             Transaction transaction(this, "Select Inside");
             if (del)
@@ -1076,6 +1095,26 @@ namespace TrenchBroom {
             return true;
         }
         
+        /**
+         * Partitions the given brushes into those whose bounds intersect the given bounds and those whose bounds
+         * don't, preserving their order. The candidates are looked up in the world's node tree so that we don't have
+         * to test every brush.
+         */
+        static std::pair<Model::BrushList, Model::BrushList> partitionBrushesByIntersection(const Model::World* world, const vm::bbox3& bounds, const Model::BrushList& brushes) {
+            const Model::NodeList candidates = world->findNodesIntersecting(bounds);
+            const std::set<const Model::Node*> candidateSet(std::begin(candidates), std::end(candidates));
+
+            Model::BrushList intersecting, disjoint;
+            for (Model::Brush* brush : brushes) {
+                if (candidateSet.count(brush) > 0) {
+                    intersecting.push_back(brush);
+                } else {
+                    disjoint.push_back(brush);
+                }
+            }
+            return std::make_pair(intersecting, disjoint);
+        }
+
         bool MapDocument::csgSubtract() {
             const Model::BrushList brushes = selectedNodes().brushes();
             if (brushes.size() < 2)
@@ -1084,12 +1123,20 @@ namespace TrenchBroom {
             const Model::BrushList minuends(std::begin(brushes), std::end(brushes) - 1);
             Model::Brush* subtrahend = brushes.back();
             
+            // minuends which don't touch the subtrahend are not affected by the subtraction and remain untouched
+            const auto [affectedMinuends, unaffectedMinuends] = partitionBrushesByIntersection(m_world, subtrahend->bounds(), minuends);
+
+            const auto fragments = ParallelUtils::parallelTransform(affectedMinuends, [&](const Model::Brush* minuend) {
+                return minuend->subtractGeometry(subtrahend);
+            });
+
             Model::ParentChildrenMap toAdd;
             Model::NodeList toRemove;
             toRemove.push_back(subtrahend);
             
-            for (Model::Brush* minuend : minuends) {
-                const Model::BrushList result = minuend->subtract(*m_world, m_worldBounds, currentTextureName(), subtrahend);
+            for (size_t i = 0; i < affectedMinuends.size(); ++i) {
+                Model::Brush* minuend = affectedMinuends[i];
+                const Model::BrushList result = minuend->createSubtractionBrushes(*m_world, m_worldBounds, currentTextureName(), fragments[i], subtrahend);
 
                 if (!result.empty()) {
                     VectorUtils::append(toAdd[minuend->parent()], result);
@@ -1099,9 +1146,10 @@ namespace TrenchBroom {
             
             Transaction transaction(this, "CSG Subtract");
             deselectAll();
-            const Model::NodeList added = addNodes(toAdd);
+            Model::NodeList toSelect = addNodes(toAdd);
             removeNodes(toRemove);
-            select(added);
+            VectorUtils::append(toSelect, unaffectedMinuends);
+            select(toSelect);
             
             return true;
         }
@@ -1111,9 +1159,11 @@ namespace TrenchBroom {
             if (brushes.size() < 2)
                 return false;
             
-            Model::Brush* result = brushes.front()->clone(m_worldBounds);
+            // if any brush doesn't touch the first one, the intersection is empty and we can skip the geometry
+            bool valid = partitionBrushesByIntersection(m_world, brushes.front()->bounds(), brushes).second.empty();
+
+            Model::Brush* result = valid ? brushes.front()->clone(m_worldBounds) : nullptr;
 
-            bool valid = true;
             Model::BrushList::const_iterator it, end;
             for (it = std::begin(brushes), end = std::end(brushes); it != end && valid; ++it) {
                 Model::Brush* brush = *it;
@@ -1147,23 +1197,45 @@ namespace TrenchBroom {
                 return false;
             }
             
+            // cloning must happen on this thread because it updates the texture usage counts
+            Model::BrushList shrunkenBrushes;
+            shrunkenBrushes.reserve(brushes.size());
+            for (const Model::Brush* brush : brushes) {
+                shrunkenBrushes.push_back(brush->clone(m_worldBounds));
+            }
+
+            // shrinking the copies and computing the fragments only touches the copies' geometry
+            const auto delta = -1.0 * static_cast<FloatType>(m_grid->actualSize());
+            struct HollowResult {
+                bool valid = false;
+                Model::BrushGeometry::SubtractResult fragments;
+            };
+            std::vector<HollowResult> results(brushes.size());
+
+            ParallelUtils::parallelFor(brushes.size(), [&](const size_t i) {
+                Model::Brush* shrunken = shrunkenBrushes[i];
+                if (shrunken->expand(m_worldBounds, delta, true)) {
+                    results[i].fragments = brushes[i]->subtractGeometry(shrunken);
+                    results[i].valid = true;
+                }
+            });
+
             Model::ParentChildrenMap toAdd;
             Model::NodeList toRemove;
             
-            for (Model::Brush* brush : brushes) {
-                // make an shrunken copy of brush
-                Model::Brush* shrunken = brush->clone(m_worldBounds);
-                if (shrunken->expand(m_worldBounds, -1.0 * static_cast<FloatType>(m_grid->actualSize()), true)) {
+            for (size_t i = 0; i < brushes.size(); ++i) {
+                Model::Brush* brush = brushes[i];
+                if (results[i].valid) {
                     // shrinking gave us a valid brush, so subtract it from `brush`
-                    const Model::BrushList fragments = brush->subtract(*m_world, m_worldBounds, currentTextureName(), shrunken);
+                    const Model::BrushList result = brush->createSubtractionBrushes(*m_world, m_worldBounds, currentTextureName(), results[i].fragments, shrunkenBrushes[i]);
                     
-                    VectorUtils::append(toAdd[brush->parent()], fragments);
+                    VectorUtils::append(toAdd[brush->parent()], result);
                     toRemove.push_back(brush);
                 }
-                
-                delete shrunken;
             }
 
+            VectorUtils::clearAndDelete(shrunkenBrushes);
+
             Transaction transaction(this, "CSG Hollow");
             deselectAll();
             const Model::NodeList added = addNodes(toAdd);
@@ -1531,6 +1603,11 @@ namespace TrenchBroom {
             setTextures();
         }
 
+        void MapDocument::updateEntityModels() {
+            if (m_entityModelManager->update())
+                entityModelsDidChangeNotifier();
+        }
+
         void MapDocument::loadAssets() {
             loadEntityDefinitions();
             setEntityDefinitions();
@@ -1822,9 +1899,10 @@ namespace TrenchBroom {
             if (isGamePathPreference(path)) {
                 const Model::GameFactory& gameFactory = Model::GameFactory::instance();
                 const IO::Path newGamePath = gameFactory.gamePath(m_game->gameName());
-                m_game->setGamePath(newGamePath, this);
-                
+
+                // cancel and join pending model loads before the game file system is rebuilt
                 clearEntityModels();
+                m_game->setGamePath(newGamePath, this);
                 
                 unsetTextures();
                 loadTextures();
@@ -142,6 +142,7 @@ namespace TrenchBroom {
             
             Notifier0 textureCollectionsDidChangeNotifier;
             Notifier0 entityDefinitionsDidChangeNotifier;
+            Notifier0 entityModelsDidChangeNotifier;
             Notifier0 modsDidChangeNotifier;
             
             Notifier0 pointFileWasLoadedNotifier;
@@ -403,6 +404,12 @@ namespace TrenchBroom {
             IO::Path::List availableTextureCollections() const;
             void setEnabledTextureCollections(const IO::Path::List& paths);
             void reloadTextureCollections();
+
+            /**
+             * Takes over entity models that finished loading in the background and notifies the views if models
+             * became available for rendering. Must be called regularly on the main thread.
+             */
+            void updateEntityModels();
         private:
             void loadAssets();
             void unloadAssets();
@@ -22,6 +22,7 @@
 #include "TrenchBroomApp.h"
 #include "Preferences.h"
 #include "PreferenceManager.h"
+#include "Assets/EntityModelManager.h"
 #include "IO/DiskFileSystem.h"
 #include "IO/ResourceUtils.h"
 #include "Model/AttributableNode.h"
@@ -64,6 +65,7 @@
 
 #include <vecmath/util.h>
 
+#include <wx/app.h>
 #include <wx/clipbrd.h>
 #include <wx/display.h>
 #include <wx/filedlg.h>
@@ -88,6 +90,7 @@ namespace TrenchBroom {
         m_frameManager(nullptr),
         m_autosaver(nullptr),
         m_autosaveTimer(nullptr),
+        m_entityModelTimer(nullptr),
         m_contextManager(nullptr),
         m_mapView(nullptr),
         m_console(nullptr),
@@ -102,6 +105,7 @@ namespace TrenchBroom {
         m_frameManager(nullptr),
         m_autosaver(nullptr),
         m_autosaveTimer(nullptr),
+        m_entityModelTimer(nullptr),
         m_contextManager(nullptr),
         m_mapView(nullptr),
         m_console(nullptr),
@@ -130,10 +134,14 @@ namespace TrenchBroom {
 
             m_document->setParentLogger(logger());
             m_document->setViewEffectsService(m_mapView);
+            m_document->entityModelManager().setLoadCallback([]() { wxWakeUpIdle(); });
 
             m_autosaveTimer = new wxTimer(this);
             m_autosaveTimer->Start(1000);
 
+            m_entityModelTimer = new wxTimer();
+            m_entityModelTimer->Bind(wxEVT_TIMER, &MapFrame::OnEntityModelTimer, this);
+
             bindObservers();
             bindEvents();
 
@@ -186,6 +194,9 @@ namespace TrenchBroom {
             delete m_autosaveTimer;
             m_autosaveTimer = nullptr;
 
+            delete m_entityModelTimer;
+            m_entityModelTimer = nullptr;
+
             delete m_autosaver;
             m_autosaver = nullptr;
 
@@ -792,6 +803,7 @@ namespace TrenchBroom {
 
             Bind(wxEVT_CLOSE_WINDOW, &MapFrame::OnClose, this);
             Bind(wxEVT_TIMER, &MapFrame::OnAutosaveTimer, this);
+            Bind(wxEVT_IDLE, &MapFrame::OnIdle, this);
 			Bind(wxEVT_CHILD_FOCUS, &MapFrame::OnChildFocus, this);
 
 #if defined(_WIN32)
@@ -1988,6 +2000,27 @@ namespace TrenchBroom {
 
             m_autosaver->triggerAutosave(logger());
         }
+
+        void MapFrame::OnEntityModelTimer(wxTimerEvent& event) {
+            if (IsBeingDeleted()) return;
+
+            updateEntityModels();
+        }
+
+        void MapFrame::OnIdle(wxIdleEvent& event) {
+            if (IsBeingDeleted()) return;
+
+            updateEntityModels();
+            event.Skip();
+        }
+
+        void MapFrame::updateEntityModels() {
+            m_document->updateEntityModels();
+
+            // deferred changes must be reported even if no further models are loaded to wake us up
+            if (m_document->entityModelManager().hasPendingChanges() && !m_entityModelTimer->IsRunning())
+                m_entityModelTimer->Start(Assets::EntityModelManager::UpdateInterval, wxTIMER_ONE_SHOT);
+        }
         
         int MapFrame::indexForGridSize(const int gridSize) {
             return gridSize - Grid::MinSize;
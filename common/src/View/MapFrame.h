@@ -59,6 +59,7 @@ namespace TrenchBroom {
 
             Autosaver* m_autosaver;
             wxTimer* m_autosaveTimer;
+            wxTimer* m_entityModelTimer;
 
             SplitterWindow2* m_hSplitter;
             SplitterWindow2* m_vSplitter;
@@ -285,6 +286,9 @@ namespace TrenchBroom {
         private: // other event handlers
             void OnClose(wxCloseEvent& event);
             void OnAutosaveTimer(wxTimerEvent& event);
+            void OnEntityModelTimer(wxTimerEvent& event);
+            void OnIdle(wxIdleEvent& event);
+            void updateEntityModels();
         private: // grid helpers
             static int indexForGridSize(const int gridSize);
             static int gridSizeForIndex(const int index);
@@ -97,6 +97,7 @@ namespace TrenchBroom {
             void selectionDidChange(const Selection& selection);
             void textureCollectionsDidChange();
             void entityDefinitionsDidChange();
+            void entityModelsDidChange();
             void modsDidChange();
             void editorContextDidChange();
             void mapViewConfigDidChange();
@@ -27,6 +27,7 @@
 #include "Renderer/FontManager.h"
 #include "Renderer/Shaders.h"
 #include "Renderer/ShaderManager.h"
+#include "Renderer/TextureAtlas.h"
 #include "Renderer/TextureFont.h"
 #include "Renderer/VertexArray.h"
 #include "View/TextureSelectedCommand.h"
@@ -35,27 +36,37 @@
 #include <vecmath/mat.h>
 #include <vecmath/mat_ext.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace TrenchBroom {
     namespace View {
         TextureCellData::TextureCellData(Assets::Texture* i_texture, const Renderer::FontDescriptor& i_fontDescriptor) :
         texture(i_texture),
         fontDescriptor(i_fontDescriptor) {}
 
+        TextureBrowserView::TextureIndex::TextureIndex(const Renderer::FontDescriptor& i_font, const float i_maxCellWidth) :
+        font(i_font),
+        maxCellWidth(i_maxCellWidth) {}
+
         TextureBrowserView::TextureBrowserView(wxWindow* parent,
                                                wxScrollBar* scrollBar,
                                                GLContextManager& contextManager,
                                                Assets::TextureManager& textureManager) :
         CellView(parent, contextManager, GLAttribs::attribs(), scrollBar),
         m_textureManager(textureManager),
+        m_thumbnails(ThumbnailPageSize, MaxThumbnailPages),
         m_group(false),
         m_hideUnused(false),
         m_sortOrder(SO_Name),
         m_selectedTexture(nullptr) {
             m_textureManager.usageCountDidChange.addObserver(this, &TextureBrowserView::usageCountDidChange);
+            m_textureManager.texturesDidChange.addObserver(this, &TextureBrowserView::texturesDidChange);
         }
         
         TextureBrowserView::~TextureBrowserView() {
             m_textureManager.usageCountDidChange.removeObserver(this, &TextureBrowserView::usageCountDidChange);
+            m_textureManager.texturesDidChange.removeObserver(this, &TextureBrowserView::texturesDidChange);
             clear();
         }
 
@@ -107,6 +118,13 @@ namespace TrenchBroom {
             Refresh();
         }
 
+        void TextureBrowserView::texturesDidChange() {
+            m_textureIndex.reset();
+            m_thumbnails.clear();
+            invalidate();
+            Refresh();
+        }
+
         void TextureBrowserView::doInitLayout(Layout& layout) {
             const float scaleFactor = pref(Preferences::TextureBrowserIconSize);
             
@@ -125,32 +143,31 @@ namespace TrenchBroom {
             assert(fontSize > 0);
             
             const Renderer::FontDescriptor font(fontPath, static_cast<size_t>(fontSize));
+            const TextureIndex& index = textureIndex(font, layout.maxCellWidth());
             
             if (m_group) {
                 for (const Assets::TextureCollection* collection : getCollections()) {
                     layout.addGroup(collection->name(), fontSize + 2.0f);
-                    for (Assets::Texture* texture : getTextures(collection))
-                        addTextureToLayout(layout, texture, font);
+                    for (const TextureEntry* entry : getTextures(index.collectionTextures.at(collection)))
+                        addTextureToLayout(layout, *entry, font);
                 }
             } else {
-                for (Assets::Texture* texture : getTextures())
-                    addTextureToLayout(layout, texture, font);
+                for (const TextureEntry* entry : getTextures(index.textures))
+                    addTextureToLayout(layout, *entry, font);
             }
         }
         
-        void TextureBrowserView::addTextureToLayout(Layout& layout, Assets::Texture* texture, const Renderer::FontDescriptor& font) {
-            const float maxCellWidth = layout.maxCellWidth();
-            const Renderer::FontDescriptor actualFont = fontManager().selectFontSize(font, texture->name(), maxCellWidth, 5);
-            const vm::vec2f actualSize = fontManager().font(actualFont).measure(texture->name());
-            
+        void TextureBrowserView::addTextureToLayout(Layout& layout, const TextureEntry& entry, const Renderer::FontDescriptor& font) {
+            const Assets::Texture* texture = entry.texture;
+
             const float scaleFactor = pref(Preferences::TextureBrowserIconSize);
             const size_t scaledTextureWidth = static_cast<size_t>(vm::round(scaleFactor * static_cast<float>(texture->width())));
             const size_t scaledTextureHeight = static_cast<size_t>(vm::round(scaleFactor * static_cast<float>(texture->height())));
             
-            layout.addItem(TextureCellData(texture, actualFont),
+            layout.addItem(TextureCellData(entry.texture, entry.font),
                            scaledTextureWidth,
                            scaledTextureHeight,
-                           actualSize.x(),
+                           entry.titleWidth,
                            font.size() + 2.0f);
         }
 
@@ -168,31 +185,46 @@ namespace TrenchBroom {
             }
         };
         
-        struct TextureBrowserView::CompareByName {
-            StringUtils::CaseInsensitiveStringLess m_less;
-            
-            template <typename T>
-            bool operator()(const T* lhs, const T* rhs) const {
-                return m_less(lhs->name(), rhs->name());
-            }
-        };
-
         struct TextureBrowserView::MatchUsageCount {
             template <typename T>
             bool operator()(const T* t) const {
                 return t->usageCount() == 0;
             }
         };
-        
-        struct TextureBrowserView::MatchName {
-            String pattern;
-            
-            MatchName(const String& i_pattern) : pattern(i_pattern) {}
-            
-            bool operator()(const Assets::Texture* texture) const {
-                return !StringUtils::containsCaseInsensitive(texture->name(), pattern);
+
+        const TextureBrowserView::TextureIndex& TextureBrowserView::textureIndex(const Renderer::FontDescriptor& font, const float maxCellWidth) {
+            if (m_textureIndex != nullptr && m_textureIndex->font.compare(font) == 0 && m_textureIndex->maxCellWidth == maxCellWidth)
+                return *m_textureIndex;
+
+            m_textureIndex = std::make_unique<TextureIndex>(font, maxCellWidth);
+
+            const auto compareByName = [](const TextureEntry* lhs, const TextureEntry* rhs) {
+                return lhs->lowercaseName < rhs->lowercaseName;
+            };
+
+            for (Assets::Texture* texture : m_textureManager.textures())
+                m_textureIndex->textures.push_back(&indexTexture(*m_textureIndex, texture));
+            std::stable_sort(std::begin(m_textureIndex->textures), std::end(m_textureIndex->textures), compareByName);
+
+            for (const Assets::TextureCollection* collection : m_textureManager.collections()) {
+                TextureEntryList& textures = m_textureIndex->collectionTextures[collection];
+                for (Assets::Texture* texture : collection->textures())
+                    textures.push_back(&indexTexture(*m_textureIndex, texture));
+                std::stable_sort(std::begin(textures), std::end(textures), compareByName);
             }
-        };
+
+            return *m_textureIndex;
+        }
+
+        const TextureBrowserView::TextureEntry& TextureBrowserView::indexTexture(TextureIndex& index, Assets::Texture* texture) {
+            auto it = index.entries.find(texture);
+            if (it == std::end(index.entries)) {
+                const Renderer::FontDescriptor actualFont = fontManager().selectFontSize(index.font, texture->name(), index.maxCellWidth, 5);
+                const vm::vec2f actualSize = fontManager().font(actualFont).measure(texture->name());
+                it = index.entries.insert(std::make_pair(texture, TextureEntry { texture, StringUtils::toLower(texture->name()), actualFont, actualSize.x() })).first;
+            }
+            return it->second;
+        }
 
         Assets::TextureCollectionList TextureBrowserView::getCollections() const {
             Assets::TextureCollectionList collections = m_textureManager.collections();
@@ -203,36 +235,25 @@ namespace TrenchBroom {
             return collections;
         }
         
-        Assets::TextureList TextureBrowserView::getTextures(const Assets::TextureCollection* collection) const {
-            Assets::TextureList textures = collection->textures();
-            filterTextures(textures);
-            sortTextures(textures);
-            return textures;
-        }
-        
-        Assets::TextureList TextureBrowserView::getTextures() const {
-            Assets::TextureList textures = m_textureManager.textures();
-            filterTextures(textures);
-            sortTextures(textures);
-            return textures;
-        }
+        TextureBrowserView::TextureEntryList TextureBrowserView::getTextures(const TextureEntryList& textures) const {
+            const String filterText = StringUtils::toLower(m_filterText);
 
-        void TextureBrowserView::filterTextures(Assets::TextureList& textures) const {
-            if (m_hideUnused)
-                VectorUtils::eraseIf(textures, MatchUsageCount());
-            if (!m_filterText.empty())
-                VectorUtils::eraseIf(textures, MatchName(m_filterText));
-        }
-        
-        void TextureBrowserView::sortTextures(Assets::TextureList& textures) const {
-            switch (m_sortOrder) {
-                case SO_Name:
-                    VectorUtils::sort(textures, CompareByName());
-                    break;
-                case SO_Usage:
-                    VectorUtils::sort(textures, CompareByUsageCount());
-                    break;
+            TextureEntryList result;
+            result.reserve(textures.size());
+            for (const TextureEntry* entry : textures) {
+                if ((!m_hideUnused || entry->texture->usageCount() > 0) &&
+                    (filterText.empty() || entry->lowercaseName.find(filterText) != String::npos))
+                    result.push_back(entry);
+            }
+
+            // the entries are sorted by name, which breaks ties between textures with the same usage count
+            if (m_sortOrder == SO_Usage) {
+                std::stable_sort(std::begin(result), std::end(result), [](const TextureEntry* lhs, const TextureEntry* rhs) {
+                    return lhs->texture->usageCount() > rhs->texture->usageCount();
+                });
             }
+
+            return result;
         }
 
         void TextureBrowserView::doClear() {}
@@ -270,7 +291,8 @@ namespace TrenchBroom {
             for (size_t i = 0; i < layout.size(); ++i) {
                 const Layout::Group& group = layout[i];
                 if (group.intersectsY(y, height)) {
-                    for (size_t j = 0; j < group.size(); ++j) {
+                    const auto rows = group.rowsIntersectingY(y, height);
+                    for (size_t j = rows.first; j < rows.second; ++j) {
                         const Layout::Group::Row& row = group[j];
                         if (row.intersectsY(y, height)) {
                             for (size_t k = 0; k < row.size(); ++k) {
@@ -306,46 +328,99 @@ namespace TrenchBroom {
 
         void TextureBrowserView::renderTextures(Layout& layout, const float y, const float height) {
             typedef Renderer::VertexSpecs::P2T2::Vertex TextureVertex;
-            TextureVertex::List vertices(4);
 
-            Renderer::ActiveShader shader(shaderManager(), Renderer::Shaders::TextureBrowserShader);
-            shader.set("ApplyTinting", false);
-            shader.set("Texture", 0);
-            shader.set("Brightness", pref(Preferences::Brightness));
-            
-            size_t num = 0;
-            
-            Renderer::ActivateVbo activate(vertexVbo());
+            // the vertices of the cells whose thumbnails are in the atlas, by page and gray scale flag
+            typedef std::pair<size_t, bool> BatchKey;
+            std::map<BatchKey, TextureVertex::List> batches;
+            std::vector<const Layout::Group::Row::Cell*> unbatchedCells;
 
-            for (size_t i = 0; i < layout.size(); ++i) {
-                const Layout::Group& group = layout[i];
-                if (group.intersectsY(y, height)) {
-                    for (size_t j = 0; j < group.size(); ++j) {
-                        const Layout::Group::Row& row = group[j];
-                        if (row.intersectsY(y, height)) {
-                            for (size_t k = 0; k < row.size(); ++k) {
-                                const Layout::Group::Row::Cell& cell = row[k];
-                                const LayoutBounds& bounds = cell.itemBounds();
-                                const Assets::Texture* texture = cell.item().texture;
-                                
-                                vertices[0] = TextureVertex(vm::vec2f(bounds.left(),  height - (bounds.top() - y)),    vm::vec2f(0.0f, 0.0f));
-                                vertices[1] = TextureVertex(vm::vec2f(bounds.left(),  height - (bounds.bottom() - y)), vm::vec2f(0.0f, 1.0f));
-                                vertices[2] = TextureVertex(vm::vec2f(bounds.right(), height - (bounds.bottom() - y)), vm::vec2f(1.0f, 1.0f));
-                                vertices[3] = TextureVertex(vm::vec2f(bounds.right(), height - (bounds.top() - y)),    vm::vec2f(1.0f, 0.0f));
+            const auto addQuad = [&](TextureVertex::List& vertices, const LayoutBounds& bounds, const vm::vec2f& texCoordsMin, const vm::vec2f& texCoordsMax) {
+                vertices.push_back(TextureVertex(vm::vec2f(bounds.left(),  height - (bounds.top() - y)),    vm::vec2f(texCoordsMin.x(), texCoordsMin.y())));
+                vertices.push_back(TextureVertex(vm::vec2f(bounds.left(),  height - (bounds.bottom() - y)), vm::vec2f(texCoordsMin.x(), texCoordsMax.y())));
+                vertices.push_back(TextureVertex(vm::vec2f(bounds.right(), height - (bounds.bottom() - y)), vm::vec2f(texCoordsMax.x(), texCoordsMax.y())));
+                vertices.push_back(TextureVertex(vm::vec2f(bounds.right(), height - (bounds.top() - y)),    vm::vec2f(texCoordsMax.x(), texCoordsMin.y())));
+            };
 
-                                Renderer::VertexArray vertexArray = Renderer::VertexArray::copy(vertices);
+            const auto collectCells = [&](const bool clearIfFull) {
+                batches.clear();
+                unbatchedCells.clear();
 
-                                shader.set("GrayScale", texture->overridden());
-                                texture->activate();
+                for (size_t i = 0; i < layout.size(); ++i) {
+                    const Layout::Group& group = layout[i];
+                    if (group.intersectsY(y, height)) {
+                        const auto rows = group.rowsIntersectingY(y, height);
+                        for (size_t j = rows.first; j < rows.second; ++j) {
+                            const Layout::Group::Row& row = group[j];
+                            if (row.intersectsY(y, height)) {
+                                for (size_t k = 0; k < row.size(); ++k) {
+                                    const Layout::Group::Row::Cell& cell = row[k];
+                                    const LayoutBounds& bounds = cell.itemBounds();
+                                    const Assets::Texture* texture = cell.item().texture;
 
-                                vertexArray.prepare(vertexVbo());
-                                vertexArray.render(GL_QUADS);
-                                
-                                ++num;
+                                    const size_t minWidth = static_cast<size_t>(std::ceil(bounds.width()));
+                                    const size_t minHeight = static_cast<size_t>(std::ceil(bounds.height()));
+                                    const Renderer::TextureAtlas::Region* region = m_thumbnails.region(*texture, minWidth, minHeight, clearIfFull);
+                                    if (region != nullptr)
+                                        addQuad(batches[BatchKey(region->page, texture->overridden())], bounds, region->texCoordsMin, region->texCoordsMax);
+                                    else
+                                        unbatchedCells.push_back(&cell);
+                                }
                             }
                         }
                     }
                 }
+            };
+
+            m_thumbnails.setTextureMode(m_textureManager.minFilter(), m_textureManager.magFilter());
+
+            // If the atlas ran out of space, it was cleared and the regions collected before are no longer valid.
+            // The cells are then collected again into an empty atlas which must not be cleared a second time, and
+            // the cells that still do not fit are drawn one by one.
+            const size_t generation = m_thumbnails.generation();
+            collectCells(true);
+            if (m_thumbnails.generation() != generation) {
+                m_thumbnails.clear();
+                collectCells(false);
+            }
+
+            std::vector<std::pair<BatchKey, std::pair<GLint, GLsizei>>> ranges;
+            TextureVertex::List vertices;
+            for (auto& batch : batches) {
+                const GLint index = static_cast<GLint>(vertices.size());
+                const GLsizei count = static_cast<GLsizei>(batch.second.size());
+                ranges.push_back(std::make_pair(batch.first, std::make_pair(index, count)));
+                VectorUtils::append(vertices, batch.second);
+            }
+
+            const size_t batchedVertexCount = vertices.size();
+            for (const Layout::Group::Row::Cell* cell : unbatchedCells)
+                addQuad(vertices, cell->itemBounds(), vm::vec2f(0.0f, 0.0f), vm::vec2f(1.0f, 1.0f));
+
+            Renderer::ActiveShader shader(shaderManager(), Renderer::Shaders::TextureBrowserShader);
+            shader.set("ApplyTinting", false);
+            shader.set("Texture", 0);
+            shader.set("Brightness", pref(Preferences::Brightness));
+
+            Renderer::ActivateVbo activate(vertexVbo());
+            Renderer::VertexArray vertexArray = Renderer::VertexArray::swap(vertices);
+            vertexArray.prepare(vertexVbo());
+
+            for (const auto& range : ranges) {
+                shader.set("GrayScale", range.first.second);
+                m_thumbnails.activatePage(range.first.first);
+                vertexArray.render(GL_QUADS, range.second.first, range.second.second);
+            }
+            m_thumbnails.deactivate();
+
+            // textures that do not fit into the atlas are drawn one by one
+            for (size_t i = 0; i < unbatchedCells.size(); ++i) {
+                const Assets::Texture* texture = unbatchedCells[i]->item().texture;
+                if (texture->isPrepared()) {
+                    shader.set("GrayScale", texture->overridden());
+                    texture->activate();
+                    vertexArray.render(GL_QUADS, static_cast<GLint>(batchedVertexCount + 4 * i), 4);
+                    texture->deactivate();
+                }
             }
         }
         
@@ -428,7 +503,8 @@ namespace TrenchBroom {
                         vertices.insert(std::end(vertices), std::begin(titleVertices), std::end(titleVertices));
                     }
                     
-                    for (size_t j = 0; j < group.size(); ++j) {
+                    const auto rows = group.rowsIntersectingY(y, height);
+                    for (size_t j = rows.first; j < rows.second; ++j) {
                         const auto& row = group[j];
                         if (row.intersectsY(y, height)) {
                             for (unsigned int k = 0; k < row.size(); k++) {
@@ -23,12 +23,15 @@
 #include "StringUtils.h"
 #include "Assets/TextureManager.h"
 #include "Renderer/FontDescriptor.h"
+#include "Renderer/TextureAtlas.h"
 #include "Renderer/Vbo.h"
 #include "Renderer/Vertex.h"
 #include "Renderer/VertexSpec.h"
 #include "View/CellView.h"
 
 #include <map>
+#include <memory>
+#include <vector>
 
 class wxScrollBar;
 
@@ -60,7 +63,37 @@ namespace TrenchBroom {
             typedef Renderer::VertexSpecs::P2T2C4::Vertex TextVertex;
             typedef std::map<Renderer::FontDescriptor, TextVertex::List> StringMap;
 
+            /**
+             * The parts of a cell that only depend on the texture name, computed once per texture.
+             */
+            struct TextureEntry {
+                Assets::Texture* texture;
+                String lowercaseName;
+                Renderer::FontDescriptor font;
+                float titleWidth;
+            };
+            typedef std::vector<const TextureEntry*> TextureEntryList;
+
+            /**
+             * Holds an entry for every texture, and the entries of all textures and of every collection sorted by
+             * name, so that changing the filter text only needs to filter these lists.
+             */
+            struct TextureIndex {
+                Renderer::FontDescriptor font;
+                float maxCellWidth;
+                std::map<const Assets::Texture*, TextureEntry> entries;
+                TextureEntryList textures;
+                std::map<const Assets::TextureCollection*, TextureEntryList> collectionTextures;
+
+                TextureIndex(const Renderer::FontDescriptor& i_font, float i_maxCellWidth);
+            };
+
+            static const size_t ThumbnailPageSize = 2048;
+            static const size_t MaxThumbnailPages = 4;
+
             Assets::TextureManager& m_textureManager;
+            std::unique_ptr<TextureIndex> m_textureIndex;
+            Renderer::TextureAtlas m_thumbnails;
 
             bool m_group;
             bool m_hideUnused;
@@ -84,22 +117,20 @@ namespace TrenchBroom {
             void setSelectedTexture(Assets::Texture* selectedTexture);
         private:
             void usageCountDidChange();
+            void texturesDidChange();
 
             void doInitLayout(Layout& layout) override;
             void doReloadLayout(Layout& layout) override;
-            void addTextureToLayout(Layout& layout, Assets::Texture* texture, const Renderer::FontDescriptor& font);
+            void addTextureToLayout(Layout& layout, const TextureEntry& entry, const Renderer::FontDescriptor& font);
             
             struct CompareByUsageCount;
-            struct CompareByName;
             struct MatchUsageCount;
-            struct MatchName;
             
+            const TextureIndex& textureIndex(const Renderer::FontDescriptor& font, float maxCellWidth);
+            const TextureEntry& indexTexture(TextureIndex& index, Assets::Texture* texture);
+
             Assets::TextureCollectionList getCollections() const;
-            Assets::TextureList getTextures(const Assets::TextureCollection* collection) const;
-            Assets::TextureList getTextures() const;
-            
-            void filterTextures(Assets::TextureList& textures) const;
-            void sortTextures(Assets::TextureList& textures) const;
+            TextureEntryList getTextures(const TextureEntryList& textures) const;
             
             void doClear() override;
             void doRender(Layout& layout, float y, float height) override;
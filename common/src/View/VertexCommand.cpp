@@ -174,12 +174,12 @@ namespace TrenchBroom {
             m_snapshot = nullptr;
         }
 
-        void VertexCommand::removeHandles(VertexHandleManagerBase& manager) {
-            manager.removeHandles(std::begin(m_brushes), std::end(m_brushes));
+        void VertexCommand::beginUpdateHandles(VertexHandleManagerBase& manager) {
+            manager.beginUpdateHandles(std::begin(m_brushes), std::end(m_brushes));
         }
         
-        void VertexCommand::addHandles(VertexHandleManagerBase& manager) {
-            manager.addHandles(std::begin(m_brushes), std::end(m_brushes));
+        void VertexCommand::endUpdateHandles(VertexHandleManagerBase& manager) {
+            manager.endUpdateHandles(std::begin(m_brushes), std::end(m_brushes));
         }
         
         void VertexCommand::selectNewHandlePositions(VertexHandleManagerBaseT<vm::vec3>& manager) const {
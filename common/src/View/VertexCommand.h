@@ -79,8 +79,8 @@ namespace TrenchBroom {
             virtual bool doCanDoVertexOperation(const MapDocument* document) const = 0;
             virtual bool doVertexOperation(MapDocumentCommandFacade* document) = 0;
         public:
-            void removeHandles(VertexHandleManagerBase& manager);
-            void addHandles(VertexHandleManagerBase& manager);
+            void beginUpdateHandles(VertexHandleManagerBase& manager);
+            void endUpdateHandles(VertexHandleManagerBase& manager);
         public:
             void selectNewHandlePositions(VertexHandleManagerBaseT<vm::vec3>& manager) const;
             void selectOldHandlePositions(VertexHandleManagerBaseT<vm::vec3>& manager) const;
@@ -28,38 +28,166 @@
 #include <vecmath/plane.h>
 #include <vecmath/intersection.h>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
 namespace TrenchBroom {
     namespace View {
+        static size_t hashValue(const FloatType value) {
+            // +0.0 and -0.0 are equal, so they must have the same hash value
+            return std::hash<FloatType>()(value == 0.0 ? 0.0 : value);
+        }
+
+        static void combineHash(size_t& seed, const size_t value) {
+            seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+
+        size_t VertexHandleManagerBase::HandleHash::operator()(const vm::vec3& handle) const {
+            size_t result = hashValue(handle.x());
+            combineHash(result, hashValue(handle.y()));
+            combineHash(result, hashValue(handle.z()));
+            return result;
+        }
+
+        size_t VertexHandleManagerBase::HandleHash::operator()(const vm::segment3& handle) const {
+            size_t result = (*this)(handle.start());
+            combineHash(result, (*this)(handle.end()));
+            return result;
+        }
+
+        size_t VertexHandleManagerBase::HandleHash::operator()(const vm::polygon3& handle) const {
+            size_t result = handle.vertexCount();
+            for (const auto& vertex : handle.vertices()) {
+                combineHash(result, (*this)(vertex));
+            }
+            return result;
+        }
+
         VertexHandleManagerBase::~VertexHandleManagerBase() {}
 
+        vm::bbox3 VertexHandleManagerBase::handleBounds(const vm::vec3& handle) {
+            return vm::bbox3(handle, handle);
+        }
+
+        vm::bbox3 VertexHandleManagerBase::handleBounds(const vm::segment3& handle) {
+            return vm::bbox3(vm::min(handle.start(), handle.end()), vm::max(handle.start(), handle.end()));
+        }
+
+        vm::bbox3 VertexHandleManagerBase::handleBounds(const vm::polygon3& handle) {
+            assert(handle.vertexCount() > 0);
+
+            const auto& vertices = handle.vertices();
+            vm::bbox3 result(vertices.front(), vertices.front());
+            for (const auto& vertex : vertices) {
+                result = vm::merge(result, vertex);
+            }
+            return result;
+        }
+
+        void VertexHandleManagerBase::HandleTree::build(std::vector<Item> items) {
+            clear();
+            if (!items.empty()) {
+                build(items, 0, items.size());
+
+                m_slots.reserve(items.size());
+                for (const auto& item : items) {
+                    m_slots.push_back(item.second);
+                }
+            }
+        }
+
+        void VertexHandleManagerBase::HandleTree::clear() {
+            m_nodes.clear();
+            m_slots.clear();
+        }
+
+        size_t VertexHandleManagerBase::HandleTree::build(std::vector<Item>& items, const size_t begin, const size_t end) {
+            static const size_t MaxLeafSize = 4;
+            assert(begin < end);
+
+            auto bounds = items[begin].first;
+            for (size_t i = begin + 1; i < end; ++i) {
+                bounds = vm::merge(bounds, items[i].first);
+            }
+
+            const auto index = m_nodes.size();
+            m_nodes.push_back(Node{ bounds, begin, end });
+
+            if (end - begin > MaxLeafSize) {
+                const auto axis = vm::firstComponent(bounds.size());
+                const auto mid = begin + (end - begin) / 2;
+                std::nth_element(std::next(std::begin(items), static_cast<long>(begin)),
+                                 std::next(std::begin(items), static_cast<long>(mid)),
+                                 std::next(std::begin(items), static_cast<long>(end)),
+                                 [axis](const Item& lhs, const Item& rhs) {
+                                     return lhs.first.min[axis] + lhs.first.max[axis] < rhs.first.min[axis] + rhs.first.max[axis];
+                                 });
+
+                build(items, begin, mid);
+                const auto right = build(items, mid, end);
+
+                // the node is an inner node now, see Node
+                m_nodes[index].begin = right;
+                m_nodes[index].end = 0;
+            }
+
+            return index;
+        }
+
+        VertexHandleManagerBase::PickRayFilter::PickRayFilter(const vm::ray3& pickRay, const Renderer::Camera& camera, const FloatType handleRadius) :
+        m_pickRay(pickRay),
+        m_handleRadius(handleRadius) {
+            // Sample the camera's perspective scaling factor at a reference point and at some distance along each axis
+            // to obtain the affine function that computes it.
+            static const FloatType distance = 1024.0;
+            const auto reference = vm::vec3(camera.position());
+            const auto scaling = static_cast<FloatType>(camera.perspectiveScalingFactor(vm::vec3f(reference)));
+            for (size_t i = 0; i < 3; ++i) {
+                auto sample = reference;
+                sample[i] += distance;
+                m_scalingGradient[i] = (static_cast<FloatType>(camera.perspectiveScalingFactor(vm::vec3f(sample))) - scaling) / distance;
+            }
+            m_scalingOffset = scaling - vm::dot(m_scalingGradient, reference);
+        }
+
+        bool VertexHandleManagerBase::PickRayFilter::operator()(const vm::bbox3& bounds) const {
+            // the maximum absolute value of an affine function within a box
+            const auto maxScaling = std::abs(m_scalingOffset + vm::dot(m_scalingGradient, bounds.center()))
+                                  + vm::dot(vm::abs(m_scalingGradient), bounds.size() / 2.0);
+
+            // Camera::pickPointHandle uses a sphere with a radius of twice the scaled handle radius; the additional
+            // slack accounts for rounding errors in the camera's computations
+            const auto radius = 2.0 * m_handleRadius * maxScaling * 1.01 + vm::constants<FloatType>::almostZero();
+            const auto enlarged = bounds.expand(radius);
+            return enlarged.contains(m_pickRay.origin) || !vm::isnan(vm::intersect(m_pickRay, enlarged));
+        }
+
         const Model::Hit::HitType VertexHandleManager::HandleHit = Model::Hit::freeHitType();
 
         void VertexHandleManager::pick(const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const {
-            for (const auto& entry : m_handles) {
-                const auto& position = entry.first;
-                const auto distance = camera.pickPointHandle(pickRay, position, pref(Preferences::HandleRadius));
+            const FloatType handleRadius = pref(Preferences::HandleRadius);
+            forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::vec3& position) {
+                const auto distance = camera.pickPointHandle(pickRay, position, handleRadius);
                 if (!vm::isnan(distance)) {
                     const auto hitPoint = pickRay.pointAtDistance(distance);
                     const auto error = vm::squaredDistance(pickRay, position).distance;
                     pickResult.addHit(Model::Hit::hit(HandleHit, distance, hitPoint, position, error));
                 }
-            }
+            });
         }
         
-        void VertexHandleManager::addHandles(const Model::Brush* brush) {
-            for (const Model::BrushVertex* vertex : brush->vertices()) {
-                add(vertex->position());
-            }
+        Model::Hit::HitType VertexHandleManager::hitType() const {
+            return HandleHit;
         }
-        
-        void VertexHandleManager::removeHandles(const Model::Brush* brush) {
+
+        VertexHandleManager::HandleList VertexHandleManager::brushHandles(const Model::Brush* brush) const {
+            HandleList result;
+            result.reserve(brush->vertexCount());
             for (const Model::BrushVertex* vertex : brush->vertices()) {
-                assertResult(remove(vertex->position()));
+                result.push_back(vertex->position());
             }
-        }
-
-        Model::Hit::HitType VertexHandleManager::hitType() const {
-            return HandleHit;
+            return result;
         }
 
         bool VertexHandleManager::isIncident(const Handle& handle, const Model::Brush* brush) const {
@@ -69,47 +197,44 @@ namespace TrenchBroom {
         const Model::Hit::HitType EdgeHandleManager::HandleHit = Model::Hit::freeHitType();
 
         void EdgeHandleManager::pickGridHandle(const vm::ray3& pickRay, const Renderer::Camera& camera, const Grid& grid, Model::PickResult& pickResult) const {
-            for (const HandleEntry& entry : m_handles) {
-                const vm::segment3& position = entry.first;
-                const FloatType edgeDist = camera.pickLineSegmentHandle(pickRay, position, pref(Preferences::HandleRadius));
+            const FloatType handleRadius = pref(Preferences::HandleRadius);
+            forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::segment3& position) {
+                const FloatType edgeDist = camera.pickLineSegmentHandle(pickRay, position, handleRadius);
                 if (!vm::isnan(edgeDist)) {
                     const vm::vec3 pointHandle = grid.snap(pickRay.pointAtDistance(edgeDist), position);
-                    const FloatType pointDist = camera.pickPointHandle(pickRay, pointHandle, pref(Preferences::HandleRadius));
+                    const FloatType pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
                     if (!vm::isnan(pointDist)) {
                         const vm::vec3 hitPoint = pickRay.pointAtDistance(pointDist);
                         pickResult.addHit(Model::Hit::hit(HandleHit, pointDist, hitPoint, HitType(position, pointHandle)));
                     }
                 }
-            }
+            });
         }
 
         void EdgeHandleManager::pickCenterHandle(const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const {
-            for (const HandleEntry& entry : m_handles) {
-                const vm::segment3& position = entry.first;
+            const FloatType handleRadius = pref(Preferences::HandleRadius);
+            forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::segment3& position) {
                 const vm::vec3 pointHandle = position.center();
 
-                const FloatType pointDist = camera.pickPointHandle(pickRay, pointHandle, pref(Preferences::HandleRadius));
+                const FloatType pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
                 if (!vm::isnan(pointDist)) {
                     const vm::vec3 hitPoint = pickRay.pointAtDistance(pointDist);
                     pickResult.addHit(Model::Hit::hit(HandleHit, pointDist, hitPoint, position));
                 }
-            }
+            });
         }
 
-        void EdgeHandleManager::addHandles(const Model::Brush* brush) {
-            for (const Model::BrushEdge* edge : brush->edges()) {
-                add(vm::segment3(edge->firstVertex()->position(), edge->secondVertex()->position()));
-            }
+        Model::Hit::HitType EdgeHandleManager::hitType() const {
+            return HandleHit;
         }
 
-        void EdgeHandleManager::removeHandles(const Model::Brush* brush) {
+        EdgeHandleManager::HandleList EdgeHandleManager::brushHandles(const Model::Brush* brush) const {
+            HandleList result;
+            result.reserve(brush->edgeCount());
             for (const Model::BrushEdge* edge : brush->edges()) {
-                assertResult(remove(vm::segment3(edge->firstVertex()->position(), edge->secondVertex()->position())));
+                result.push_back(vm::segment3(edge->firstVertex()->position(), edge->secondVertex()->position()));
             }
-        }
-
-        Model::Hit::HitType EdgeHandleManager::hitType() const {
-            return HandleHit;
+            return result;
         }
 
         bool EdgeHandleManager::isIncident(const Handle& handle, const Model::Brush* brush) const {
@@ -119,54 +244,50 @@ namespace TrenchBroom {
         const Model::Hit::HitType FaceHandleManager::HandleHit = Model::Hit::freeHitType();
 
         void FaceHandleManager::pickGridHandle(const vm::ray3& pickRay, const Renderer::Camera& camera, const Grid& grid, Model::PickResult& pickResult) const {
-            for (const auto& entry : m_handles) {
-                const auto& position = entry.first;
-
+            const FloatType handleRadius = pref(Preferences::HandleRadius);
+            forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::polygon3& position) {
                 const auto [valid, plane] = vm::fromPoints(std::begin(position), std::end(position));
                 if (!valid) {
-                    continue;
+                    return;
                 }
 
                 const auto distance = vm::intersect(pickRay, plane, std::begin(position), std::end(position));
                 if (!vm::isnan(distance)) {
                     const auto pointHandle = grid.snap(pickRay.pointAtDistance(distance), plane);
                     
-                    const auto pointDist = camera.pickPointHandle(pickRay, pointHandle, pref(Preferences::HandleRadius));
+                    const auto pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
                     if (!vm::isnan(pointDist)) {
                         const auto hitPoint = pickRay.pointAtDistance(pointDist);
                         pickResult.addHit(Model::Hit::hit(HandleHit, pointDist, hitPoint, HitType(position, pointHandle)));
                     }
                 }
-            }
+            });
         }
 
         void FaceHandleManager::pickCenterHandle(const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const {
-            for (const HandleEntry& entry : m_handles) {
-                const auto& position = entry.first;
+            const FloatType handleRadius = pref(Preferences::HandleRadius);
+            forEachHandleNearRay(pickRay, camera, handleRadius, [&](const vm::polygon3& position) {
                 const auto pointHandle = position.center();
 
-                const auto pointDist = camera.pickPointHandle(pickRay, pointHandle, pref(Preferences::HandleRadius));
+                const auto pointDist = camera.pickPointHandle(pickRay, pointHandle, handleRadius);
                 if (!vm::isnan(pointDist)) {
                     const auto hitPoint = pickRay.pointAtDistance(pointDist);
                     pickResult.addHit(Model::Hit::hit(HandleHit, pointDist, hitPoint, position));
                 }
-            }
+            });
         }
 
-        void FaceHandleManager::addHandles(const Model::Brush* brush) {
-            for (const Model::BrushFace* face : brush->faces()) {
-                add(face->polygon());
-            }
+        Model::Hit::HitType FaceHandleManager::hitType() const {
+            return HandleHit;
         }
-        
-        void FaceHandleManager::removeHandles(const Model::Brush* brush) {
+
+        FaceHandleManager::HandleList FaceHandleManager::brushHandles(const Model::Brush* brush) const {
+            HandleList result;
+            result.reserve(brush->faceCount());
             for (const Model::BrushFace* face : brush->faces()) {
-                assertResult(remove(face->polygon()));
+                result.push_back(face->polygon());
             }
-        }
-
-        Model::Hit::HitType FaceHandleManager::hitType() const {
-            return HandleHit;
+            return result;
         }
 
         bool FaceHandleManager::isIncident(const Handle& handle, const Model::Brush* brush) const {
@@ -21,6 +21,7 @@
 #define VertexHandleManager_h
 
 #include "TrenchBroom.h"
+#include "CollectionUtils.h"
 #include "Model/Brush.h"
 #include "Model/BrushFace.h"
 #include "Model/Hit.h"
@@ -28,12 +29,21 @@
 #include "Renderer/Camera.h"
 #include "View/ViewTypes.h"
 
+#include <vecmath/bbox.h>
 #include <vecmath/distance.h>
+#include <vecmath/intersection.h>
+#include <vecmath/plane.h>
+#include <vecmath/polygon.h>
+#include <vecmath/ray.h>
+#include <vecmath/segment.h>
 
 #include <algorithm>
 #include <functional>
 #include <iterator>
 #include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace TrenchBroom {
     namespace Model {
@@ -49,6 +59,109 @@ namespace TrenchBroom {
         class Grid;
         
         class VertexHandleManagerBase {
+        protected:
+            /**
+             * Computes hash values of handle positions.
+             */
+            struct HandleHash {
+                size_t operator()(const vm::vec3& handle) const;
+                size_t operator()(const vm::segment3& handle) const;
+                size_t operator()(const vm::polygon3& handle) const;
+            };
+
+            /**
+             * A bounding volume hierarchy over the bounds of the handles, used to find the handles near a pick ray or
+             * near a given position. Each leaf refers to a small number of handle slots. The hierarchy is not updated
+             * incrementally, rather it is rebuilt from scratch by splitting at the median of the longest axis.
+             */
+            class HandleTree {
+            public:
+                using Item = std::pair<vm::bbox3, size_t>;
+            private:
+                struct Node {
+                    vm::bbox3 bounds;
+                    // for leafs, the range of slots in m_slots, otherwise, [right child index, 0)
+                    size_t begin;
+                    size_t end;
+
+                    bool leaf() const {
+                        return end > 0;
+                    }
+                };
+
+                // the nodes in depth first order, the left child of an inner node is its immediate successor
+                std::vector<Node> m_nodes;
+                std::vector<size_t> m_slots;
+            public:
+                /**
+                 * Rebuilds this tree from the given items, each of which consists of the bounds of a handle and its
+                 * slot.
+                 *
+                 * @param items the items to build the tree from
+                 */
+                void build(std::vector<Item> items);
+
+                /**
+                 * Removes all nodes from this tree.
+                 */
+                void clear();
+
+                /**
+                 * Calls the given function for the slot of every leaf whose bounds satisfy the given predicate. The
+                 * predicate is also used to prune the subtrees of inner nodes, so it must be conservative: If it does
+                 * not hold for a box, then it must not hold for any box contained therein.
+                 *
+                 * @tparam P the predicate type, must accept a box and return a boolean
+                 * @tparam F the function type, must accept a slot
+                 * @param predicate the predicate to test
+                 * @param fun the function to call
+                 */
+                template <typename P, typename F>
+                void find(const P& predicate, const F& fun) const {
+                    if (m_nodes.empty()) {
+                        return;
+                    }
+
+                    std::vector<size_t> stack;
+                    stack.push_back(0);
+                    while (!stack.empty()) {
+                        const auto index = stack.back();
+                        stack.pop_back();
+
+                        const auto& node = m_nodes[index];
+                        if (predicate(node.bounds)) {
+                            if (node.leaf()) {
+                                for (size_t i = node.begin; i < node.end; ++i) {
+                                    fun(m_slots[i]);
+                                }
+                            } else {
+                                stack.push_back(node.begin);
+                                stack.push_back(index + 1);
+                            }
+                        }
+                    }
+                }
+            private:
+                size_t build(std::vector<Item>& items, size_t begin, size_t end);
+            };
+
+            /**
+             * Conservatively checks whether a handle within a given box could be hit by a pick ray. The box is enlarged
+             * by the largest handle radius that the camera may apply anywhere within it, and then the pick ray is
+             * intersected with the enlarged box.
+             */
+            class PickRayFilter {
+            private:
+                vm::ray3 m_pickRay;
+                FloatType m_handleRadius;
+                // the camera's perspective scaling factor is an affine function of the position, given by these
+                FloatType m_scalingOffset;
+                vm::vec3 m_scalingGradient;
+            public:
+                PickRayFilter(const vm::ray3& pickRay, const Renderer::Camera& camera, FloatType handleRadius);
+
+                bool operator()(const vm::bbox3& bounds) const;
+            };
         public:
             virtual ~VertexHandleManagerBase();
         public:
@@ -89,6 +202,56 @@ namespace TrenchBroom {
              * @param brush the brush whose handles to remove
              */
             virtual void removeHandles(const Model::Brush* brush) = 0;
+
+            /**
+             * Begins updating the handles of the given range of brushes, see beginUpdateHandles(const Model::Brush*).
+             *
+             * @tparam I the type of the range iterators
+             * @param begin the beginning of the range
+             * @param end the end of the range
+             */
+            template <typename I>
+            void beginUpdateHandles(I begin, I end) {
+                std::for_each(begin, end, [this](const Model::Brush* brush) { beginUpdateHandles(brush); });
+            }
+
+            /**
+             * Begins updating the handles of the given brush, which is about to change. The current handles of the
+             * brush are remembered and remain in this manager until endUpdateHandles is called for the brush. Then,
+             * only the handles that the brush gained or lost are added or removed, and all other handles keep their
+             * selection state.
+             *
+             * Calls to this function and endUpdateHandles may be nested, in which case only the outermost pair has an
+             * effect.
+             *
+             * @param brush the brush whose handles to update
+             */
+            virtual void beginUpdateHandles(const Model::Brush* brush) = 0;
+
+            /**
+             * Ends updating the handles of the given range of brushes, see endUpdateHandles(const Model::Brush*).
+             *
+             * @tparam I the type of the range iterators
+             * @param begin the beginning of the range
+             * @param end the end of the range
+             */
+            template <typename I>
+            void endUpdateHandles(I begin, I end) {
+                std::for_each(begin, end, [this](const Model::Brush* brush) { endUpdateHandles(brush); });
+            }
+
+            /**
+             * Ends updating the handles of the given brush, which has changed, and adds or removes the handles that
+             * differ from the handles remembered by beginUpdateHandles. If no update was begun for the given brush, all
+             * of its handles are added.
+             *
+             * @param brush the brush whose handles to update
+             */
+            virtual void endUpdateHandles(const Model::Brush* brush) = 0;
+        protected:
+            static vm::bbox3 handleBounds(const vm::vec3& handle);
+            static vm::bbox3 handleBounds(const vm::segment3& handle);
+            static vm::bbox3 handleBounds(const vm::polygon3& handle);
         };
 
         template <typename H>
@@ -96,81 +259,51 @@ namespace TrenchBroom {
         public:
             typedef H Handle;
             typedef std::vector<H> HandleList;
-        private:
         protected:
             /**
-             * Represents the status of a handle, i.e., how many duplicates exist at the same coordinates and whether
-             * or not all of these are selected.
+             * The handles contained in this manager, indexed by slot. A slot is free if its count is zero.
              */
-            struct HandleInfo {
-                size_t count;
-                bool selected;
-                
-                HandleInfo() :
-                count(0),
-                selected(false) {}
-
-                /**
-                 * Sets this handle to selected.
-                 *
-                 * @return true if and only if this handle was not previously selected
-                 */
-                bool select() {
-                    const bool result = !selected;
-                    selected = true;
-                    return result;
-                }
+            HandleList m_handles;
 
-                /**
-                 * Sets this handle to deselected.
-                 *
-                 * @return true if and only if this handle was previously selected
-                 */
-                bool deselect() {
-                    const bool result = selected;
-                    selected = false;
-                    return result;
-                }
+            /**
+             * The number of duplicates of the handle in each slot.
+             */
+            std::vector<size_t> m_counts;
 
-                /**
-                 * Toggles the selection state of this handle.
-                 *
-                 * @return true if and only if this handle was previously selected
-                 */
-                bool toggle() {
-                    selected = !selected;
-                    return selected;
-                }
+            /**
+             * The slots that were freed by removing handles and that can be reused.
+             */
+            std::vector<size_t> m_freeSlots;
 
-                /**
-                 * Increments the number of handles at the same coordinates.
-                 */
-                void inc() {
-                    ++count;
-                }
+            /**
+             * The selection state of the handle in each slot.
+             */
+            Bitset m_selection;
 
-                /**
-                 * Deccrements the number of handles at the same coordinates.
-                 */
-                void dec() {
-                    --count;
-                }
-            };
-            
-            typedef std::map<H, HandleInfo> HandleMap;
-            typedef typename HandleMap::value_type HandleEntry;
+            /**
+             * Maps a handle position to its slot.
+             */
+            std::unordered_map<H, size_t, HandleHash> m_slots;
 
             /**
-             * Maps a handle position to its info.
+             * Spatial index of the handle slots, used for picking. Rebuilt lazily when handles have been added.
              */
-            HandleMap m_handles;
+            mutable HandleTree m_tree;
+            mutable bool m_treeValid;
 
             /**
              * The total number of selected handles, not counting duplicates.
              */
             size_t m_selectedHandleCount;
+
+            /**
+             * The sorted slots of the handles of the brushes whose handles are being updated, and the nesting depth of
+             * the updates.
+             */
+            std::unordered_map<const Model::Brush*, std::pair<std::vector<size_t>, size_t>> m_updates;
         public:
             VertexHandleManagerBaseT() :
+            m_treeValid(true),
             m_selectedHandleCount(0) {}
             
             virtual ~VertexHandleManagerBaseT() {}
@@ -206,7 +339,7 @@ namespace TrenchBroom {
              * @return the total number of handles
              */
             size_t totalHandleCount() const {
-                return m_handles.size();
+                return m_slots.size();
             }
         public:
             /**
@@ -217,7 +350,22 @@ namespace TrenchBroom {
             HandleList allHandles() const {
                 HandleList result;
                 result.reserve(totalHandleCount());
-                collectHandles([](const HandleInfo& info) { return true; }, std::back_inserter(result));
+                collectHandles([](const bool selected) { return true; }, std::back_inserter(result));
+                return result;
+            }
+
+            /**
+             * Returns all handles whose bounds may intersect the convex volume bounded by the given planes. The test is
+             * conservative, so the result may contain handles that lie outside of the volume, but close to it.
+             *
+             * @param planes the planes bounding the convex volume
+             * @return a list containing the found handles
+             */
+            HandleList findHandles(const std::vector<vm::plane3>& planes) const {
+                HandleList result;
+                forEachSlotInTree([&](const vm::bbox3& nodeBounds) { return vm::intersects(nodeBounds, std::begin(planes), std::end(planes)); }, [&](const size_t slot) {
+                    result.push_back(m_handles[slot]);
+                });
                 return result;
             }
 
@@ -229,7 +377,7 @@ namespace TrenchBroom {
             HandleList selectedHandles() const {
                 HandleList result;
                 result.reserve(selectedHandleCount());
-                collectHandles([](const HandleInfo& info) { return info.selected; }, std::back_inserter(result));
+                collectHandles([](const bool selected) { return selected; }, std::back_inserter(result));
                 return result;
             }
 
@@ -241,17 +389,16 @@ namespace TrenchBroom {
             HandleList unselectedHandles() const {
                 HandleList result;
                 result.reserve(unselectedHandleCount());
-                collectHandles([](const HandleInfo& info) { return !info.selected; }, std::back_inserter(result));
+                collectHandles([](const bool selected) { return !selected; }, std::back_inserter(result));
                 return result;
             }
         private:
             template <typename T, typename O>
             void collectHandles(const T& test, O out) const {
-                for (const HandleEntry& entry : m_handles) {
-                    const Handle& handle = entry.first;
-                    const HandleInfo& info = entry.second;
-                    if (test(info))
-                        out = handle;
+                for (size_t slot = 0; slot < m_handles.size(); ++slot) {
+                    if (m_counts[slot] > 0 && test(m_selection[slot])) {
+                        out = m_handles[slot];
+                    }
                 }
             }
         public:
@@ -262,7 +409,7 @@ namespace TrenchBroom {
              * @return true if and only if the given handle is contained in this manager
              */
             bool contains(const Handle& handle) const {
-                return m_handles.count(handle) > 0;
+                return m_slots.count(handle) > 0;
             }
 
             /**
@@ -272,10 +419,10 @@ namespace TrenchBroom {
              * @return true if and only if the given handle is contained in this manager and it is selected
              */
             bool selected(const Handle& handle) const {
-                const auto it = m_handles.find(handle);
-                if (it == std::end(m_handles))
+                const auto it = m_slots.find(handle);
+                if (it == std::end(m_slots))
                     return false;
-                return it->second.selected;
+                return m_selection[it->second];
             }
 
             /**
@@ -301,7 +448,26 @@ namespace TrenchBroom {
              * @param handle the handle to add
              */
             void add(const Handle& handle) {
-                MapUtils::findOrInsert(m_handles, handle, HandleInfo())->second.inc();
+                const auto it = m_slots.find(handle);
+                if (it != std::end(m_slots)) {
+                    ++m_counts[it->second];
+                    return;
+                }
+
+                size_t slot;
+                if (!m_freeSlots.empty()) {
+                    slot = m_freeSlots.back();
+                    m_freeSlots.pop_back();
+                    m_handles[slot] = handle;
+                    m_counts[slot] = 1;
+                } else {
+                    slot = m_handles.size();
+                    m_handles.push_back(handle);
+                    m_counts.push_back(1);
+                }
+
+                m_slots.insert(std::make_pair(handle, slot));
+                m_treeValid = false;
             }
 
             /**
@@ -311,27 +477,109 @@ namespace TrenchBroom {
              * @return true if the given handle was contained in this manager (and therefore removed) and false otherwise
              */
             bool remove(const Handle& handle) {
-                const auto it = m_handles.find(handle);
-                if (it != std::end(m_handles)) {
-                    HandleInfo& info = it->second;
-                    info.dec();
-                    
-                    if (info.count == 0) {
-                        deselect(info);
-                        m_handles.erase(it);
-                    }
+                const auto it = m_slots.find(handle);
+                if (it != std::end(m_slots)) {
+                    removeSlot(it->second);
                     return true;
                 }
 
                 return false;
             }
+        private:
+            void removeSlot(const size_t slot) {
+                assert(m_counts[slot] > 0);
+                if (--m_counts[slot] == 0) {
+                    // the tree may keep referring to the free slot, it is skipped when searching the tree
+                    deselectSlot(slot);
+                    m_slots.erase(m_handles[slot]);
+                    m_freeSlots.push_back(slot);
+                }
+            }
+        public:
+
+            void addHandles(const Model::Brush* brush) override {
+                for (const auto& handle : brushHandles(brush)) {
+                    add(handle);
+                }
+            }
+
+            void removeHandles(const Model::Brush* brush) override {
+                for (const auto& handle : brushHandles(brush)) {
+                    assertResult(remove(handle));
+                }
+            }
+
+            void beginUpdateHandles(const Model::Brush* brush) override {
+                auto it = m_updates.find(brush);
+                if (it != std::end(m_updates)) {
+                    ++it->second.second;
+                    return;
+                }
+
+                std::vector<size_t> slots;
+                for (const auto& handle : brushHandles(brush)) {
+                    const auto slotIt = m_slots.find(handle);
+                    if (slotIt != std::end(m_slots)) {
+                        slots.push_back(slotIt->second);
+                    }
+                }
+                std::sort(std::begin(slots), std::end(slots));
+                m_updates.insert(std::make_pair(brush, std::make_pair(std::move(slots), 1u)));
+            }
+
+            void endUpdateHandles(const Model::Brush* brush) override {
+                auto it = m_updates.find(brush);
+                if (it == std::end(m_updates)) {
+                    addHandles(brush);
+                    return;
+                }
+
+                if (--it->second.second > 0) {
+                    return;
+                }
+
+                const auto oldSlots = std::move(it->second.first);
+                m_updates.erase(it);
+
+                // A handle is kept if it occupies one of the brush's old slots. Since the counts of the old slots
+                // include the brush, none of them can have been freed and reused in the meantime.
+                std::vector<bool> kept(oldSlots.size(), false);
+                HandleList gained;
+                for (const auto& handle : brushHandles(brush)) {
+                    const auto slotIt = m_slots.find(handle);
+                    if (slotIt != std::end(m_slots)) {
+                        const auto oldIt = std::lower_bound(std::begin(oldSlots), std::end(oldSlots), slotIt->second);
+                        if (oldIt != std::end(oldSlots) && *oldIt == slotIt->second) {
+                            kept[static_cast<size_t>(std::distance(std::begin(oldSlots), oldIt))] = true;
+                            continue;
+                        }
+                    }
+                    gained.push_back(handle);
+                }
+
+                for (size_t i = 0; i < oldSlots.size(); ++i) {
+                    if (!kept[i]) {
+                        removeSlot(oldSlots[i]);
+                    }
+                }
+                for (const auto& handle : gained) {
+                    add(handle);
+                }
+            }
 
             /**
              * Removes all handles from this manager.
              */
             void clear() {
                 m_handles.clear();
+                m_counts.clear();
+                m_freeSlots.clear();
+                m_selection.reset();
+                m_slots.clear();
+                m_tree.clear();
+                m_treeValid = true;
                 m_selectedHandleCount = 0;
+                m_updates.clear();
             }
 
             /**
@@ -353,7 +601,7 @@ namespace TrenchBroom {
              * @param handle the handle to select
              */
             void select(const Handle& handle) {
-                forEachCloseHandle(handle, [this](HandleInfo& info){ select(info); });
+                forEachCloseHandle(handle, [this](const size_t slot){ selectSlot(slot); });
             }
 
             /**
@@ -375,16 +623,15 @@ namespace TrenchBroom {
              * @param handle the handle to deselect
              */
             void deselect(const Handle& handle) {
-                forEachCloseHandle(handle, [this](HandleInfo& info){ deselect(info); });
+                forEachCloseHandle(handle, [this](const size_t slot){ deselectSlot(slot); });
             }
 
             /**
              * Deselects all currently selected handles
              */
             void deselectAll() {
-                std::for_each(std::begin(m_handles), std::end(m_handles), [this](HandleEntry& entry) {
-                    deselect(entry.second);
-                });
+                m_selection.reset();
+                m_selectedHandleCount = 0;
             }
 
             /**
@@ -409,35 +656,50 @@ namespace TrenchBroom {
                 });
             }
         private:
-            void forEachCloseHandle(const H& handle, std::function<void(HandleInfo&)> fun) {
+            void forEachCloseHandle(const H& handle, std::function<void(size_t)> fun) {
                 static const auto epsilon = 0.001 * 0.001;
-                for (auto& entry : m_handles) {
-                    if (compare(handle, entry.first, epsilon) == 0) {
-                        fun(entry.second);
+
+                const auto bounds = handleBounds(handle).expand(epsilon);
+                forEachSlotInTree([&](const vm::bbox3& nodeBounds) { return nodeBounds.intersects(bounds); }, [&](const size_t slot) {
+                    if (compare(handle, m_handles[slot], epsilon) == 0) {
+                        fun(slot);
                     }
+                });
+            }
+
+            template <typename P, typename F>
+            void forEachSlotInTree(const P& predicate, const F& fun) const {
+                if (!m_treeValid) {
+                    std::vector<HandleTree::Item> items;
+                    items.reserve(totalHandleCount());
+                    for (size_t slot = 0; slot < m_handles.size(); ++slot) {
+                        if (m_counts[slot] > 0) {
+                            items.emplace_back(handleBounds(m_handles[slot]), slot);
+                        }
+                    }
+                    m_tree.build(std::move(items));
+                    m_treeValid = true;
                 }
+
+                m_tree.find(predicate, [&](const size_t slot) {
+                    if (m_counts[slot] > 0) {
+                        fun(slot);
+                    }
+                });
             }
 
-            void select(HandleInfo& info) {
-                if (info.select()) {
+            void selectSlot(const size_t slot) {
+                if (!m_selection[slot]) {
                     assert(selectedHandleCount() < totalHandleCount());
+                    m_selection[slot] = true;
                     ++m_selectedHandleCount;
                 }
             }
             
-            void deselect(HandleInfo& info) {
-                if (info.deselect()) {
-                    assert(m_selectedHandleCount > 0);
-                    --m_selectedHandleCount;
-                }
-            }
-            
-            void toggle(HandleInfo& info) {
-                if (info.toggle()) {
-                    assert(selectedHandleCount() < totalHandleCount());
-                    ++m_selectedHandleCount;
-                } else {
+            void deselectSlot(const size_t slot) {
+                if (m_selection[slot]) {
                     assert(m_selectedHandleCount > 0);
+                    m_selection[slot] = false;
                     --m_selectedHandleCount;
                 }
             }
@@ -452,11 +714,30 @@ namespace TrenchBroom {
              */
             template <typename P>
             void pick(const P& test, Model::PickResult& pickResult) const {
-                std::for_each(std::begin(m_handles), std::end(m_handles), [&test, &pickResult](const HandleEntry& entry) {
-                    const Model::Hit hit = test(entry.first);
-                    if (hit.isMatch())
-                        pickResult.addHit(hit);
-                });
+                for (size_t slot = 0; slot < m_handles.size(); ++slot) {
+                    if (m_counts[slot] > 0) {
+                        const Model::Hit hit = test(m_handles[slot]);
+                        if (hit.isMatch())
+                            pickResult.addHit(hit);
+                    }
+                }
+            }
+        protected:
+            /**
+             * Calls the given function for every handle that could be hit by the given pick ray. Only the handles whose
+             * bounds pass a conservative test are considered, so the given function must still perform the actual
+             * picking test.
+             *
+             * @tparam F the function type, must accept a handle
+             * @param pickRay the pick ray
+             * @param camera the camera
+             * @param handleRadius the handle radius
+             * @param fun the function to call
+             */
+            template <typename F>
+            void forEachHandleNearRay(const vm::ray3& pickRay, const Renderer::Camera& camera, const FloatType handleRadius, const F& fun) const {
+                const PickRayFilter filter(pickRay, camera, handleRadius);
+                forEachSlotInTree(filter, [&](const size_t slot) { fun(m_handles[slot]); });
             }
         public:
             /**
@@ -511,6 +792,14 @@ namespace TrenchBroom {
                 std::copy_if(begin, end, out, [this, &handle](const Model::Brush* brush) { return this->isIncident(handle, brush); });
             }
         private:
+            /**
+             * Returns the handles of the given brush.
+             *
+             * @param brush the brush
+             * @return the handles of the given brush
+             */
+            virtual HandleList brushHandles(const Model::Brush* brush) const = 0;
+
             /**
              * Checks whether the given brush is incident to the given handle.
              *
@@ -541,11 +830,9 @@ namespace TrenchBroom {
              */
             void pick(const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const;
         public:
-            void addHandles(const Model::Brush* brush) override;
-            void removeHandles(const Model::Brush* brush) override;
-            
             Model::Hit::HitType hitType() const override;
         private:
+            HandleList brushHandles(const Model::Brush* brush) const override;
             bool isIncident(const Handle& handle, const Model::Brush* brush) const override;
         };
 
@@ -586,11 +873,9 @@ namespace TrenchBroom {
              */
             void pickCenterHandle(const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const;
         public:
-            void addHandles(const Model::Brush* brush) override;
-            void removeHandles(const Model::Brush* brush) override;
-            
             Model::Hit::HitType hitType() const override;
         private:
+            HandleList brushHandles(const Model::Brush* brush) const override;
             bool isIncident(const Handle& handle, const Model::Brush* brush) const override;
         };
 
@@ -632,11 +917,9 @@ namespace TrenchBroom {
              */
             void pickCenterHandle(const vm::ray3& pickRay, const Renderer::Camera& camera, Model::PickResult& pickResult) const;
         public:
-            void addHandles(const Model::Brush* brush) override;
-            void removeHandles(const Model::Brush* brush) override;
-
             Model::Hit::HitType hitType() const override;
         private:
+            HandleList brushHandles(const Model::Brush* brush) const override;
             bool isIncident(const Handle& handle, const Model::Brush* brush) const override;
         };
     }
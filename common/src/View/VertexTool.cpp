@@ -253,16 +253,30 @@ namespace TrenchBroom {
             Model::Node::accept(std::begin(nodes), std::end(nodes), removeFaceHandles);
         }
 
-        void VertexTool::addHandles(VertexCommand* command) {
-            command->addHandles(m_vertexHandles);
-            command->addHandles(m_edgeHandles);
-            command->addHandles(m_faceHandles);
+        void VertexTool::beginUpdateHandles(const Model::NodeList& nodes) {
+            const auto brushes = collectBrushes(nodes);
+            m_vertexHandles.beginUpdateHandles(std::begin(brushes), std::end(brushes));
+            m_edgeHandles.beginUpdateHandles(std::begin(brushes), std::end(brushes));
+            m_faceHandles.beginUpdateHandles(std::begin(brushes), std::end(brushes));
+        }
+
+        void VertexTool::endUpdateHandles(const Model::NodeList& nodes) {
+            const auto brushes = collectBrushes(nodes);
+            m_vertexHandles.endUpdateHandles(std::begin(brushes), std::end(brushes));
+            m_edgeHandles.endUpdateHandles(std::begin(brushes), std::end(brushes));
+            m_faceHandles.endUpdateHandles(std::begin(brushes), std::end(brushes));
+        }
+
+        void VertexTool::beginUpdateHandles(VertexCommand* command) {
+            command->beginUpdateHandles(m_vertexHandles);
+            command->beginUpdateHandles(m_edgeHandles);
+            command->beginUpdateHandles(m_faceHandles);
         }
         
-        void VertexTool::removeHandles(VertexCommand* command) {
-            command->removeHandles(m_vertexHandles);
-            command->removeHandles(m_edgeHandles);
-            command->removeHandles(m_faceHandles);
+        void VertexTool::endUpdateHandles(VertexCommand* command) {
+            command->endUpdateHandles(m_vertexHandles);
+            command->endUpdateHandles(m_edgeHandles);
+            command->endUpdateHandles(m_faceHandles);
         }
 
         void VertexTool::resetModeAfterDeselection() {
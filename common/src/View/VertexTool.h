@@ -91,8 +91,11 @@ namespace TrenchBroom {
             void addHandles(const Model::NodeList& nodes) override;
             void removeHandles(const Model::NodeList& nodes) override;
 
-            void addHandles(VertexCommand* command) override;
-            void removeHandles(VertexCommand* command) override;
+            void beginUpdateHandles(const Model::NodeList& nodes) override;
+            void endUpdateHandles(const Model::NodeList& nodes) override;
+
+            void beginUpdateHandles(VertexCommand* command) override;
+            void endUpdateHandles(VertexCommand* command) override;
         private: // General helper methods
             void resetModeAfterDeselection();
         };
@@ -24,6 +24,7 @@
 #include "TrenchBroom.h"
 #include "PreferenceManager.h"
 #include "Preferences.h"
+#include "Model/AssortNodesVisitor.h"
 #include "Model/Hit.h"
 #include "Model/ModelTypes.h"
 #include "Renderer/RenderBatch.h"
@@ -160,10 +161,10 @@ namespace TrenchBroom {
             void select(const Lasso& lasso, const bool modifySelection) {
                 typedef std::vector<H> HandleList;
                 
-                const HandleList allHandles = handleManager().allHandles();
+                const HandleList candidates = handleManager().findHandles(lasso.planes());
                 HandleList selectedHandles;
                 
-                lasso.selected(std::begin(allHandles), std::end(allHandles), std::back_inserter(selectedHandles));
+                lasso.selected(std::begin(candidates), std::end(candidates), std::back_inserter(selectedHandles));
                 if (!modifySelection)
                     handleManager().deselectAll();
                 handleManager().toggle(std::begin(selectedHandles), std::end(selectedHandles));
@@ -386,7 +387,7 @@ namespace TrenchBroom {
                 if (isVertexCommand(command)) {
                     auto* vertexCommand = static_cast<VertexCommand*>(command.get());
                     deselectHandles();
-                    removeHandles(vertexCommand);
+                    beginUpdateHandles(vertexCommand);
                     m_ignoreChangeNotifications.pushLiteral();
                 }
             }
@@ -394,7 +395,7 @@ namespace TrenchBroom {
             void commandDoneOrUndoFailed(Command::Ptr command) {
                 if (isVertexCommand(command)) {
                     auto* vertexCommand = static_cast<VertexCommand*>(command.get());
-                    addHandles(vertexCommand);
+                    endUpdateHandles(vertexCommand);
                     selectNewHandlePositions(vertexCommand);
                     m_ignoreChangeNotifications.popLiteral();
                 }
@@ -403,7 +404,7 @@ namespace TrenchBroom {
             void commandDoFailedOrUndone(Command::Ptr command) {
                 if (isVertexCommand(command)) {
                     auto* vertexCommand = static_cast<VertexCommand*>(command.get());
-                    addHandles(vertexCommand);
+                    endUpdateHandles(vertexCommand);
                     selectOldHandlePositions(vertexCommand);
                     m_ignoreChangeNotifications.popLiteral();
                 }
@@ -428,22 +429,22 @@ namespace TrenchBroom {
             
             void nodesWillChange(const Model::NodeList& nodes) {
                 if (!m_ignoreChangeNotifications) {
-                    removeHandles(nodes);
+                    beginUpdateHandles(nodes);
                 }
             }
             
             void nodesDidChange(const Model::NodeList& nodes) {
                 if (!m_ignoreChangeNotifications) {
-                    addHandles(nodes);
+                    endUpdateHandles(nodes);
                 }
             }
         protected:
-            virtual void addHandles(VertexCommand* command) {
-                command->addHandles(handleManager());
+            virtual void beginUpdateHandles(VertexCommand* command) {
+                command->beginUpdateHandles(handleManager());
             }
             
-            virtual void removeHandles(VertexCommand* command) {
-                command->removeHandles(handleManager());
+            virtual void endUpdateHandles(VertexCommand* command) {
+                command->endUpdateHandles(handleManager());
             }
 
             virtual void deselectHandles() {
@@ -501,6 +502,22 @@ namespace TrenchBroom {
                 RemoveHandles<H> removeVisitor(handleManager());
                 Model::Node::accept(std::begin(nodes), std::end(nodes), removeVisitor);
             }
+
+            virtual void beginUpdateHandles(const Model::NodeList& nodes) {
+                const auto brushes = collectBrushes(nodes);
+                handleManager().beginUpdateHandles(std::begin(brushes), std::end(brushes));
+            }
+
+            virtual void endUpdateHandles(const Model::NodeList& nodes) {
+                const auto brushes = collectBrushes(nodes);
+                handleManager().endUpdateHandles(std::begin(brushes), std::end(brushes));
+            }
+
+            static Model::BrushList collectBrushes(const Model::NodeList& nodes) {
+                Model::CollectBrushesVisitor collect;
+                Model::Node::accept(std::begin(nodes), std::end(nodes), collect);
+                return collect.brushes();
+            }
         };
     }
 }
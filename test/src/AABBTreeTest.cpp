@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include <vecmath/vec.h>
+#include <vecmath/plane.h>
 #include <vecmath/ray.h>
 #include "AABBTree.h"
 
@@ -27,9 +28,13 @@ using AABB = AABBTree<double, 3, size_t>;
 using BOX = AABB::Box;
 using RAY = vm::ray<AABB::FloatType, AABB::Components>;
 using VEC = vm::vec<AABB::FloatType, AABB::Components>;
+using PLANE = vm::plane<AABB::FloatType, AABB::Components>;
+using PLANES = std::vector<PLANE>;
 
 void assertTree(const std::string& exp, const AABB& actual);
 void assertIntersectors(const AABB& tree, const RAY& ray, std::initializer_list<AABB::DataType> items);
+void assertIntersectors(const AABB& tree, const BOX& box, std::initializer_list<AABB::DataType> items);
+void assertIntersectors(const AABB& tree, const PLANES& planes, std::initializer_list<AABB::DataType> items);
 
 TEST(AABBTreeTest, createEmptyTree) {
     AABB tree;
@@ -468,6 +473,50 @@ TEST(AABBTreeTest, findIntersectorsFromInsideRootBBox) {
     assertIntersectors(tree, RAY(VEC(0.0,  0.0,  0.0), VEC::pos_x), { 2u });
 }
 
+TEST(AABBTreeTest, findBoxIntersectorsOfEmptyTree) {
+    AABB tree;
+    assertIntersectors(tree, BOX(VEC(-1.0, -1.0, -1.0), VEC(1.0, 1.0, 1.0)), {});
+}
+
+TEST(AABBTreeTest, findBoxIntersectors) {
+    AABB tree;
+    tree.insert(BOX(VEC(-4.0, -1.0, -1.0), VEC(-2.0, +1.0, +1.0)), 1u);
+    tree.insert(BOX(VEC(+2.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)), 2u);
+    tree.insert(BOX(VEC(-1.0, +2.0, -1.0), VEC(+1.0, +4.0, +1.0)), 3u);
+
+    assertIntersectors(tree, BOX(VEC(-1.0, -1.0, -1.0), VEC(+1.0, +1.0, +1.0)), {});
+    assertIntersectors(tree, BOX(VEC(-3.0, -1.0, -1.0), VEC(-1.0, +1.0, +1.0)), { 1u });
+    assertIntersectors(tree, BOX(VEC(-3.0, -1.0, -1.0), VEC(+3.0, +1.0, +1.0)), { 1u, 2u });
+    assertIntersectors(tree, BOX(VEC(-2.0, +1.0, -1.0), VEC(+2.0, +2.0, +1.0)), { 1u, 2u, 3u });
+    assertIntersectors(tree, BOX(VEC(-8.0, -8.0, -8.0), VEC(+8.0, +8.0, +8.0)), { 1u, 2u, 3u });
+}
+
+TEST(AABBTreeTest, findConvexVolumeIntersectorsOfEmptyTree) {
+    AABB tree;
+    assertIntersectors(tree, PLANES { PLANE(1.0, VEC::pos_x) }, {});
+}
+
+TEST(AABBTreeTest, findConvexVolumeIntersectors) {
+    AABB tree;
+    tree.insert(BOX(VEC(-4.0, -1.0, -1.0), VEC(-2.0, +1.0, +1.0)), 1u);
+    tree.insert(BOX(VEC(+2.0, -1.0, -1.0), VEC(+4.0, +1.0, +1.0)), 2u);
+    tree.insert(BOX(VEC(-1.0, +2.0, -1.0), VEC(+1.0, +4.0, +1.0)), 3u);
+
+    // slabs along the X axis
+    assertIntersectors(tree, PLANES { PLANE(-1.5, VEC::pos_x), PLANE(-1.5, VEC::neg_x) }, {});
+    assertIntersectors(tree, PLANES { PLANE(-3.0, VEC::pos_x), PLANE(8.0, VEC::neg_x) }, { 1u });
+    assertIntersectors(tree, PLANES { PLANE(0.0, VEC::pos_x), PLANE(8.0, VEC::neg_x) }, { 1u, 3u });
+
+    // a wedge that opens towards +y
+    const PLANES wedge {
+        PLANE(VEC::zero, vm::normalize(VEC(+1.0, -1.0, 0.0))),
+        PLANE(VEC::zero, vm::normalize(VEC(-1.0, -1.0, 0.0)))
+    };
+    assertIntersectors(tree, wedge, { 3u });
+
+    assertIntersectors(tree, PLANES {}, { 1u, 2u, 3u });
+}
+
 void assertTree(const std::string& exp, const AABB& actual) {
     std::stringstream str;
     actual.print(str);
@@ -482,3 +531,21 @@ void assertIntersectors(const AABB& tree, const RAY& ray, std::initializer_list<
 
     ASSERT_EQ(expected, actual);
 }
+
+void assertIntersectors(const AABB& tree, const BOX& box, std::initializer_list<AABB::DataType> items) {
+    const std::set<AABB::DataType> expected(items);
+    std::set<AABB::DataType> actual;
+
+    tree.findIntersectors(box, std::inserter(actual, std::end(actual)));
+
+    ASSERT_EQ(expected, actual);
+}
+
+void assertIntersectors(const AABB& tree, const PLANES& planes, std::initializer_list<AABB::DataType> items) {
+    const std::set<AABB::DataType> expected(items);
+    std::set<AABB::DataType> actual;
+
+    tree.findIntersectors(planes, std::inserter(actual, std::end(actual)));
+
+    ASSERT_EQ(expected, actual);
+}
@@ -0,0 +1,60 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Assets/EntityModelFrameCache.h"
+
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Assets {
+        TEST(EntityModelFrameCacheTest, decodeRecentlyUsedFramesOnce) {
+            std::vector<size_t> decoded;
+            const EntityModelFrameCache<size_t> cache(10, [&decoded](const size_t index) {
+                decoded.push_back(index);
+                return new size_t(index);
+            }, 2);
+
+            ASSERT_EQ(10u, cache.frameCount());
+            ASSERT_EQ(0u, cache.cachedFrameCount());
+
+            const auto first = cache.frame(0);
+            ASSERT_EQ(0u, *first);
+            ASSERT_EQ(1u, *cache.frame(1));
+            ASSERT_EQ(0u, *cache.frame(0));
+            ASSERT_EQ(std::vector<size_t>({ 0, 1 }), decoded);
+
+            // frame 1 is the least recently used one
+            ASSERT_EQ(2u, *cache.frame(2));
+            ASSERT_EQ(0u, *cache.frame(0));
+            ASSERT_EQ(1u, *cache.frame(1));
+            ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 1 }), decoded);
+            ASSERT_EQ(2u, cache.cachedFrameCount());
+
+            // frame 0 is evicted, but remains valid while it is referenced
+            ASSERT_EQ(2u, *cache.frame(2));
+            ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 1, 2 }), decoded);
+            ASSERT_EQ(0u, *first);
+            ASSERT_EQ(0u, *cache.frame(0));
+            ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 1, 2, 0 }), decoded);
+        }
+    }
+}
@@ -0,0 +1,201 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Exceptions.h"
+#include "Assets/EntityModel.h"
+#include "Assets/EntityModelManager.h"
+#include "IO/EntityModelLoader.h"
+#include "IO/Path.h"
+
+#include <vecmath/bbox.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace TrenchBroom {
+    namespace Assets {
+        class TestEntityModel : public EntityModel {
+        private:
+            Renderer::TexturedIndexRangeRenderer* doBuildRenderer(const size_t /* skinIndex */, const size_t /* frameIndex */) const override {
+                return nullptr;
+            }
+
+            vm::bbox3f doGetBounds(const size_t /* skinIndex */, const size_t /* frameIndex */) const override {
+                return vm::bbox3f(8.0f);
+            }
+
+            vm::bbox3f doGetTransformedBounds(const size_t /* skinIndex */, const size_t /* frameIndex */, const vm::mat4x4f& /* transformation */) const override {
+                return vm::bbox3f(8.0f);
+            }
+
+            void doPrepare(const int /* minFilter */, const int /* magFilter */) override {}
+            void doSetTextureMode(const int /* minFilter */, const int /* magFilter */) override {}
+        };
+
+        /**
+         * Blocks the threads that load models until it is opened.
+         */
+        class Gate {
+        private:
+            std::mutex m_mutex;
+            std::condition_variable m_opened;
+            bool m_open;
+        public:
+            explicit Gate(const bool open) :
+            m_open(open) {}
+
+            void open() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_open = true;
+                }
+                m_opened.notify_all();
+            }
+
+            void pass() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_opened.wait(lock, [this]() { return m_open; });
+            }
+        };
+
+        /**
+         * Counts the models that have been loaded, using the manager's load callback.
+         */
+        class LoadCounter {
+        private:
+            std::mutex m_mutex;
+            std::condition_variable m_loaded;
+            size_t m_count;
+        public:
+            explicit LoadCounter(EntityModelManager& manager) :
+            m_count(0) {
+                manager.setLoadCallback([this]() { countLoad(); });
+            }
+
+            size_t count() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_count;
+            }
+
+            /**
+             * Waits until the given number of models have been loaded. Their results are available to
+             * EntityModelManager::update() once this returns.
+             */
+            void wait(const size_t count) {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_loaded.wait(lock, [this, count]() { return m_count >= count; });
+            }
+        private:
+            void countLoad() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    ++m_count;
+                }
+                m_loaded.notify_all();
+            }
+        };
+
+        class TestEntityModelLoader : public IO::EntityModelLoader {
+        private:
+            Gate& m_gate;
+        public:
+            mutable std::atomic<size_t> loadCount;
+
+            explicit TestEntityModelLoader(Gate& gate) :
+            m_gate(gate),
+            loadCount(0) {}
+        private:
+            EntityModel* doLoadEntityModel(const IO::Path& path) const override {
+                m_gate.pass();
+                ++loadCount;
+                if (path.extension() != "mdl") {
+                    throw GameException("Unsupported model format '" + path.asString() + "'");
+                }
+                return new TestEntityModel();
+            }
+        };
+
+        TEST(EntityModelManagerTest, loadModelsInBackground) {
+            Gate gate(false);
+            TestEntityModelLoader loader(gate);
+            EntityModelManager manager(nullptr, 0, 0);
+            manager.setLoader(&loader);
+            LoadCounter loadCounter(manager);
+
+            const IO::Path modelPath("progs/player.mdl");
+            const IO::Path invalidPath("progs/player.abc");
+
+            // models are reported as missing until they have been loaded
+            ASSERT_EQ(nullptr, manager.model(modelPath));
+            ASSERT_EQ(nullptr, manager.model(invalidPath));
+            ASSERT_EQ(nullptr, manager.model(modelPath));
+            ASSERT_EQ(2u, manager.stats().maxQueueDepth);
+            ASSERT_FALSE(manager.update());
+
+            gate.open();
+            loadCounter.wait(2);
+            ASSERT_TRUE(manager.update());
+            ASSERT_NE(nullptr, manager.model(modelPath));
+            ASSERT_EQ(nullptr, manager.model(invalidPath));
+            ASSERT_EQ(2u, loader.loadCount.load());
+
+            const auto stats = manager.stats();
+            ASSERT_EQ(1u, stats.loaded);
+            ASSERT_EQ(1u, stats.failed);
+            ASSERT_EQ(0u, stats.queueDepth);
+            ASSERT_LE(stats.maxLatency, stats.totalLatency);
+
+            // nothing changed since the models were taken over
+            ASSERT_FALSE(manager.update());
+            ASSERT_FALSE(manager.hasPendingChanges());
+        }
+
+        TEST(EntityModelManagerTest, clearDiscardsQueuedModels) {
+            Gate gate(false);
+            TestEntityModelLoader loader(gate);
+            EntityModelManager manager(nullptr, 0, 0);
+            manager.setLoader(&loader);
+            LoadCounter loadCounter(manager);
+
+            for (size_t i = 0; i < 20; ++i) {
+                ASSERT_EQ(nullptr, manager.model(IO::Path("progs/model" + std::to_string(i) + ".mdl")));
+            }
+
+            // the models that are being loaded when the manager is cleared are finished and discarded
+            gate.open();
+            manager.clear();
+            ASSERT_EQ(loader.loadCount.load(), loadCounter.count());
+            ASSERT_EQ(0u, manager.stats().queueDepth);
+            ASSERT_FALSE(manager.update());
+            ASSERT_EQ(0u, manager.stats().loaded);
+
+            // a model that was discarded is loaded again when it is requested again
+            const size_t loadCount = loadCounter.count();
+            const IO::Path modelPath("progs/model0.mdl");
+            ASSERT_EQ(nullptr, manager.model(modelPath));
+            loadCounter.wait(loadCount + 1);
+            ASSERT_TRUE(manager.update());
+            ASSERT_NE(nullptr, manager.model(modelPath));
+        }
+    }
+}
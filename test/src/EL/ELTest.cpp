@@ -36,7 +36,34 @@ namespace TrenchBroom {
             ASSERT_EQ(Type_Map,     Value(MapType()).type());
             ASSERT_EQ(Type_Null,    Value().type());
         }
-        
+
+        TEST(ELTest, copyValues) {
+            const String shortString("abc");
+            const String longString(256, 'x');
+
+            const Value shortValue(shortString);
+            const Value longValue(longString);
+            const Value refValue = Value::ref(longString);
+            const Value arrayValue(ArrayType({ Value(1), Value(longString) }));
+
+            const Value shortCopy = shortValue;
+            const Value longCopy = longValue;
+            const Value refCopy = refValue;
+            const Value arrayCopy = arrayValue;
+
+            ASSERT_EQ(shortString, shortCopy.stringValue());
+            ASSERT_EQ(longString, longCopy.stringValue());
+            ASSERT_EQ(longString, refCopy.stringValue());
+            ASSERT_EQ(&longString, &refCopy.stringValue());
+            ASSERT_EQ(&longValue.stringValue(), &longCopy.stringValue());
+            ASSERT_EQ(&arrayValue.arrayValue(), &arrayCopy.arrayValue());
+
+            ASSERT_EQ(Type_String, refValue.type());
+            ASSERT_EQ(longValue, refValue);
+            ASSERT_EQ(256u, refValue.length());
+            ASSERT_EQ(arrayValue, arrayCopy);
+        }
+
         TEST(ELTest, typeConversions) {
             ASSERT_EQ(Value(true), Value(true).convertTo(Type_Boolean));
             ASSERT_EQ(Value(false), Value(false).convertTo(Type_Boolean));
@@ -0,0 +1,94 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "EL.h"
+#include "EL/ExpressionIO.h"
+#include "IO/ELParser.h"
+
+namespace TrenchBroom {
+    namespace EL {
+        static void assertReadWrite(const Expression& expression, const EvaluationContext& context) {
+            ExpressionWriter writer;
+            writer.writeExpression(expression);
+            const Expression actual = ExpressionReader(writer.data()).readExpression();
+
+            const Value expectedValue = expression.evaluate(context);
+            const Value actualValue = actual.evaluate(context);
+            ASSERT_EQ(expression.asString(), actual.asString());
+            ASSERT_EQ(expression.line(), actual.line());
+            ASSERT_EQ(expression.column(), actual.column());
+            ASSERT_EQ(expression.variables(), actual.variables());
+            ASSERT_EQ(expectedValue, actualValue);
+            ASSERT_EQ(expectedValue.line(), actualValue.line());
+            ASSERT_EQ(expectedValue.column(), actualValue.column());
+        }
+
+        static void assertReadWrite(const String& str, const EvaluationContext& context) {
+            Expression expression = IO::ELParser::parseStrict(str);
+            assertReadWrite(expression, context);
+            expression.optimize();
+            assertReadWrite(expression, context);
+        }
+
+        TEST(ExpressionIOTest, readWrittenExpressions) {
+            VariableTable table;
+            table.declare("x", Value(3));
+            table.declare("s", Value("abc"));
+            table.declare("a", Value(ArrayType({ Value(1), Value(2), Value(3), Value(4) })));
+            const EvaluationContext context(table);
+
+            assertReadWrite("1 + 2 * 3 - 4 / 2 % 3", context);
+            assertReadWrite("-x + +x", context);
+            assertReadWrite("(x + 1) * 2", context);
+            assertReadWrite("~x & 7 | 1 ^ 2 << 3 >> 1", context);
+            assertReadWrite("!(x < 2) && x <= 3 || x == 4", context);
+            assertReadWrite("x != 3 || (x >= 2 && x > 1)", context);
+            assertReadWrite("s + \"d\\\"ef\"", context);
+            assertReadWrite("[ 1, x, 1..3, s, true, null ]", context);
+            assertReadWrite("{ \"path\": s, \"skin\": x, \"frame\": [ x ] }", context);
+            assertReadWrite("a[1..]", context);
+            assertReadWrite("a[..1]", context);
+            assertReadWrite("s[1..][..0]", context);
+            assertReadWrite("{{ x == 2 -> 1, x == 3 -> 2.5, 3 }}", context);
+        }
+
+        TEST(ExpressionIOTest, readWrittenNestedSwitch) {
+            // nested switches and undefined literals have no string representation that the parser accepts
+            ExpressionBase::List cases;
+            cases.push_back(IO::ELParser::parseStrict("{{ x == 1 -> 'a' }}").clone());
+            cases.push_back(LiteralExpression::create(Value::Undefined, 3, 4));
+            const Expression expression(SwitchOperator::create(cases, 1, 2));
+
+            VariableTable table;
+            table.declare("x", Value(1));
+            assertReadWrite(expression, EvaluationContext(table));
+        }
+
+        TEST(ExpressionIOTest, readTruncatedData) {
+            ExpressionWriter writer;
+            writer.writeExpression(IO::ELParser::parseStrict("{ \"path\": s, \"skin\": 1 }"));
+
+            const String& data = writer.data();
+            ASSERT_THROW(ExpressionReader(data.data(), data.data() + data.size() - 1).readExpression(), Exception);
+        }
+    }
+}
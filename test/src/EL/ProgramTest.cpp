@@ -0,0 +1,152 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "EL.h"
+#include "EL/Program.h"
+#include "IO/ELParser.h"
+
+#include <memory>
+
+namespace TrenchBroom {
+    namespace EL {
+        class CountingVariableStore : public VariableStore {
+        private:
+            VariableTable m_table;
+            size_t& m_lookups;
+        public:
+            CountingVariableStore(const VariableTable& table, size_t& lookups) :
+            m_table(table),
+            m_lookups(lookups) {}
+        private:
+            VariableStore* doClone() const override {
+                return new CountingVariableStore(m_table, m_lookups);
+            }
+
+            Value doGetValue(const String& name) const override {
+                ++m_lookups;
+                return m_table.value(name);
+            }
+
+            StringSet doGetNames() const override {
+                return m_table.names();
+            }
+
+            void doDeclare(const String& name, const Value& value) override {}
+            void doAssign(const String& name, const Value& value) override {}
+        };
+
+        void assertProgramEvaluation(const String& str, const EvaluationContext& context = EvaluationContext());
+        void assertProgramEvaluation(const String& str, const EvaluationContext& context) {
+            const Expression expression = IO::ELParser::parseStrict(str);
+            const std::unique_ptr<ExpressionBase> tree(expression.clone());
+
+            const Value expected = tree->evaluate(context);
+            const Value actual = Program(*tree).evaluate(context);
+            ASSERT_EQ(expected, actual) << str;
+            ASSERT_EQ(expected.type(), actual.type()) << str;
+            ASSERT_EQ(expected.line(), actual.line()) << str;
+            ASSERT_EQ(expected.column(), actual.column()) << str;
+        }
+
+        TEST(ProgramTest, evaluateLikeExpressionTree) {
+            VariableTable table;
+            table.declare("x", Value(3));
+            table.declare("s", Value("abc"));
+            table.declare("a", Value(ArrayType({ Value(1), Value(2), Value(3), Value(4) })));
+            const EvaluationContext context(table);
+
+            assertProgramEvaluation("1 + 2 * 3 - 4 / 2 % 3", context);
+            assertProgramEvaluation("-x + +x", context);
+            assertProgramEvaluation("(x + 1) * 2", context);
+            assertProgramEvaluation("~x & 7 | 1 ^ 2 << 3 >> 1", context);
+            assertProgramEvaluation("!(x < 2) && x <= 3 || x == 4", context);
+            assertProgramEvaluation("x != 3 || (x >= 2 && x > 1)", context);
+            assertProgramEvaluation("s + \"def\"", context);
+            assertProgramEvaluation("[ 1, x, 1..3, s ]", context);
+            assertProgramEvaluation("{ \"path\": s, \"skin\": x, \"frame\": [ x ] }", context);
+            assertProgramEvaluation("[ 1..x ]", context);
+            assertProgramEvaluation("[ x..1 ]", context);
+            assertProgramEvaluation("a[1]", context);
+            assertProgramEvaluation("a[1..]", context);
+            assertProgramEvaluation("a[..1]", context);
+            assertProgramEvaluation("a[a[0]..]", context);
+            assertProgramEvaluation("s[1..][..0]", context);
+            assertProgramEvaluation("x == 3 -> s", context);
+            assertProgramEvaluation("x == 2 -> s", context);
+            assertProgramEvaluation("{{ x == 2 -> 1, x == 3 -> 2, 3 }}", context);
+            assertProgramEvaluation("{{ x == 2 -> 1, x == 4 -> 2 }}", context);
+            assertProgramEvaluation("y", context);
+        }
+
+        TEST(ProgramTest, resolveVariablesOnce) {
+            VariableTable table;
+            table.declare("x", Value(3));
+            table.declare("y", Value(4));
+
+            size_t lookups = 0;
+            const EvaluationContext context(CountingVariableStore(table, lookups));
+
+            const Expression expression = IO::ELParser::parseStrict("x * x + x - y");
+            ASSERT_EQ(Value(8), expression.evaluate(context));
+            ASSERT_EQ(2u, lookups);
+
+            const std::unique_ptr<ExpressionBase> tree(expression.clone());
+            ASSERT_EQ(2u, Program(*tree).variableCount());
+        }
+
+        TEST(ProgramTest, shortCircuitSkipsVariables) {
+            VariableTable table;
+            table.declare("x", Value(3));
+            table.declare("y", Value(4));
+
+            size_t lookups = 0;
+            const EvaluationContext context(CountingVariableStore(table, lookups));
+
+            ASSERT_EQ(Value(true), IO::ELParser::parseStrict("x == 3 || y == 4").evaluate(context));
+            ASSERT_EQ(1u, lookups);
+
+            lookups = 0;
+            ASSERT_EQ(Value(false), IO::ELParser::parseStrict("x == 4 && y == 4").evaluate(context));
+            ASSERT_EQ(1u, lookups);
+
+            lookups = 0;
+            ASSERT_EQ(Value(1), IO::ELParser::parseStrict("{{ x == 3 -> 1, y == 4 -> 2 }}").evaluate(context));
+            ASSERT_EQ(1u, lookups);
+        }
+
+        TEST(ProgramTest, copiesShareProgram) {
+            VariableTable table;
+            table.declare("x", Value(3));
+            const EvaluationContext context(table);
+
+            const Expression expression = IO::ELParser::parseStrict("x + 1");
+            const Expression copy = expression;
+            ASSERT_EQ(Value(4), expression.evaluate(context));
+            ASSERT_EQ(Value(4), copy.evaluate(context));
+        }
+
+        TEST(ProgramTest, throwEvaluationError) {
+            ASSERT_THROW(IO::ELParser::parseStrict("true + [ 1 ]").evaluate(EvaluationContext()), EvaluationError);
+            ASSERT_THROW(IO::ELParser::parseStrict("[ 1 ][ 2 ]").evaluate(EvaluationContext()), EvaluationError);
+        }
+    }
+}
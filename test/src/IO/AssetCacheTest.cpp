@@ -0,0 +1,204 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Assets/Palette.h"
+#include "Assets/Texture.h"
+#include "Assets/TextureCollection.h"
+#include "IO/AssetCache.h"
+#include "IO/DiskFileSystem.h"
+#include "IO/DiskIO.h"
+#include "IO/IdMipTextureReader.h"
+#include "IO/Path.h"
+#include "IO/TextureCollectionLoader.h"
+
+#include <cstring>
+#include <memory>
+
+#include <wx/filefn.h>
+
+namespace TrenchBroom {
+    namespace IO {
+        class AssetCacheTestEnvironment {
+        private:
+            Path m_dir;
+        public:
+            AssetCacheTestEnvironment() :
+            m_dir(Disk::getCurrentWorkingDir() + Path("assetcachetest")) {
+                AssetCache(m_dir, 0).clear();
+            }
+
+            ~AssetCacheTestEnvironment() {
+                AssetCache(m_dir, 0).clear();
+                ::wxRmdir(m_dir.asString());
+            }
+
+            const Path& dir() const {
+                return m_dir;
+            }
+        };
+
+        static String asString(const MappedFile::Ptr& file) {
+            return String(file->begin(), file->end());
+        }
+
+        TEST(AssetCacheTest, storeAndFind) {
+            AssetCacheTestEnvironment env;
+            AssetCache cache(env.dir(), 1024 * 1024);
+
+            const String data = "some data";
+            const AssetCache::Key key = AssetCache::Key("test").append("a").append(1u);
+            ASSERT_EQ(nullptr, cache.find(key));
+
+            cache.store(key, data.data(), data.size());
+            const MappedFile::Ptr entry = cache.find(key);
+            ASSERT_NE(nullptr, entry);
+            ASSERT_EQ(data, asString(entry));
+
+            ASSERT_EQ(nullptr, cache.find(AssetCache::Key("test").append("a").append(2u)));
+            ASSERT_EQ(nullptr, cache.find(AssetCache::Key("other").append("a").append(1u)));
+
+            // another cache using the same directory sees the entry
+            AssetCache other(env.dir(), 1024 * 1024);
+            ASSERT_EQ(data, asString(other.find(key)));
+
+            ASSERT_EQ(1u, cache.stats().hits);
+            ASSERT_EQ(3u, cache.stats().misses);
+        }
+
+        TEST(AssetCacheTest, findWithoutListingDirectory) {
+            AssetCacheTestEnvironment env;
+            AssetCache cache(env.dir(), 1024 * 1024);
+
+            const String data = "some data";
+            cache.store(AssetCache::Key("test").append(0u), data.data(), data.size());
+
+            // every store changes the cache directory, which must not make the following lookups list it again
+            const size_t misses = Disk::directoryCacheStats().misses;
+            for (unsigned int i = 1; i < 10; ++i) {
+                const AssetCache::Key key = AssetCache::Key("test").append(i);
+                ASSERT_EQ(nullptr, cache.find(key));
+                cache.store(key, data.data(), data.size());
+                ASSERT_NE(nullptr, cache.find(key));
+            }
+            ASSERT_EQ(misses, Disk::directoryCacheStats().misses);
+        }
+
+        TEST(AssetCacheTest, keyContents) {
+            const String a = "abcdefghijklmnopq";
+            const String b = "abcdefghijklmnopr";
+            ASSERT_EQ(AssetCache::Key("test").appendContents(a.data(), a.data() + a.size()).identity(),
+                      AssetCache::Key("test").appendContents(a.data(), a.data() + a.size()).identity());
+            ASSERT_NE(AssetCache::Key("test").appendContents(a.data(), a.data() + a.size()).identity(),
+                      AssetCache::Key("test").appendContents(b.data(), b.data() + b.size()).identity());
+
+            // values are delimited
+            ASSERT_NE(AssetCache::Key("test").append("ab").append("c").identity(),
+                      AssetCache::Key("test").append("a").append("bc").identity());
+        }
+
+        TEST(AssetCacheTest, keyFile) {
+            AssetCacheTestEnvironment env;
+            const Path path = env.dir() + Path("source.txt");
+
+            ASSERT_THROW(AssetCache::Key("test").appendFile(path), FileSystemException);
+
+            Disk::createFile(path, "first");
+            const AssetCache::Key first = AssetCache::Key("test").appendFile(path);
+            ASSERT_EQ(first.identity(), AssetCache::Key("test").appendFile(path).identity());
+
+            Disk::createFile(path, "second");
+            ASSERT_NE(first.identity(), AssetCache::Key("test").appendFile(path).identity());
+
+            Disk::deleteFile(path);
+        }
+
+        TEST(AssetCacheTest, evict) {
+            AssetCacheTestEnvironment env;
+            AssetCache cache(env.dir(), 1000);
+
+            const String data(300, 'x');
+            for (unsigned int i = 0; i < 10; ++i) {
+                cache.store(AssetCache::Key("test").append(i), data.data(), data.size());
+            }
+
+            ASSERT_GT(cache.stats().evictions, 0u);
+            // the entry stored last is never evicted
+            ASSERT_NE(nullptr, cache.find(AssetCache::Key("test").append(9u)));
+
+            size_t size = 0;
+            for (const Path& path : Disk::findItems(env.dir()))
+                size += Disk::openFile(path)->size();
+            ASSERT_LE(size, 1000u);
+
+            cache.setMaxSize(0);
+            ASSERT_EQ(nullptr, cache.find(AssetCache::Key("test").append(9u)));
+            ASSERT_TRUE(Disk::findItems(env.dir()).empty());
+        }
+
+        TEST(AssetCacheTest, textureCollection) {
+            AssetCacheTestEnvironment env;
+            AssetCache cache(env.dir(), 16 * 1024 * 1024);
+
+            DiskFileSystem fs(Disk::getCurrentWorkingDir());
+            const Assets::Palette palette = Assets::Palette::loadFile(fs, Path("data/palette.lmp"));
+
+            TextureReader::TextureNameStrategy nameStrategy;
+            IdMipTextureReader textureReader(nameStrategy, palette);
+
+            const Path::List searchPaths { Disk::getCurrentWorkingDir() };
+            FileTextureCollectionLoader loader(searchPaths);
+            const Path wadPath("data/IO/Wad/cr8_czg.wad");
+            const AssetCache::Key key("textures");
+
+            std::unique_ptr<Assets::TextureCollection> expected(loader.loadTextureCollection(wadPath, "D", textureReader));
+            std::unique_ptr<Assets::TextureCollection> stored(loader.loadTextureCollection(wadPath, "D", textureReader, cache, key));
+            std::unique_ptr<Assets::TextureCollection> cached(loader.loadTextureCollection(wadPath, "D", textureReader, cache, key));
+            ASSERT_EQ(1u, cache.stats().hits);
+            ASSERT_EQ(1u, cache.stats().misses);
+
+            ASSERT_EQ(21u, cached->textures().size());
+            ASSERT_EQ(expected->textures().size(), cached->textures().size());
+            for (size_t i = 0; i < expected->textures().size(); ++i) {
+                const Assets::Texture* expectedTexture = expected->textures()[i];
+                const Assets::Texture* cachedTexture = cached->textures()[i];
+                ASSERT_EQ(expectedTexture->name(), cachedTexture->name());
+                ASSERT_EQ(expectedTexture->width(), cachedTexture->width());
+                ASSERT_EQ(expectedTexture->height(), cachedTexture->height());
+                ASSERT_EQ(expectedTexture->averageColor(), cachedTexture->averageColor());
+                ASSERT_EQ(expectedTexture->format(), cachedTexture->format());
+                ASSERT_EQ(expectedTexture->type(), cachedTexture->type());
+
+                const Assets::TextureBuffer::List& expectedBuffers = expectedTexture->buffers();
+                const Assets::TextureBuffer::List& cachedBuffers = cachedTexture->buffers();
+                ASSERT_EQ(expectedBuffers.size(), cachedBuffers.size());
+                for (size_t j = 0; j < expectedBuffers.size(); ++j) {
+                    ASSERT_EQ(expectedBuffers[j].size(), cachedBuffers[j].size());
+                    ASSERT_EQ(0, std::memcmp(expectedBuffers[j].ptr(), cachedBuffers[j].ptr(), expectedBuffers[j].size()));
+                }
+            }
+
+            // a different reader configuration does not use the entry
+            std::unique_ptr<Assets::TextureCollection> other(loader.loadTextureCollection(wadPath, "D", textureReader, cache, AssetCache::Key("textures").append("other")));
+            ASSERT_EQ(2u, cache.stats().misses);
+        }
+    }
+}
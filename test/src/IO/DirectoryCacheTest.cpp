@@ -0,0 +1,172 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "IO/DirectoryCache.h"
+#include "IO/Path.h"
+
+#include <cstdio>
+#include <fstream>
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TrenchBroom {
+    namespace IO {
+        TEST(DirectoryCacheTest, findEntry) {
+            size_t listings = 0;
+            DirectoryCache cache([&](const Path& directory, StringList& names) {
+                ++listings;
+                if (directory == Path("/dir")) {
+                    names = StringList { "File.txt", "file.TXT", "Sub" };
+                    return true;
+                }
+                return false;
+            }, false);
+
+            // exact matches are preferred, otherwise the first matching entry is returned
+            ASSERT_EQ("file.TXT", cache.findEntry(Path("/dir"), "file.TXT"));
+            ASSERT_EQ("File.txt", cache.findEntry(Path("/dir"), "FILE.TXT"));
+            ASSERT_EQ("Sub", cache.findEntry(Path("/dir"), "sub"));
+            ASSERT_EQ("", cache.findEntry(Path("/dir"), "missing"));
+            ASSERT_EQ("", cache.findEntry(Path("/unreadable"), "file.txt"));
+
+            ASSERT_EQ(2u, listings);
+            ASSERT_EQ(3u, cache.stats().hits);
+            ASSERT_EQ(2u, cache.stats().misses);
+        }
+
+        TEST(DirectoryCacheTest, invalidate) {
+            StringList contents { "a" };
+            DirectoryCache cache([&](const Path& directory, StringList& names) {
+                names = contents;
+                return true;
+            }, false);
+
+            ASSERT_EQ("", cache.findEntry(Path("/dir"), "B"));
+
+            contents.push_back("b");
+            ASSERT_EQ("", cache.findEntry(Path("/dir"), "B"));
+
+            cache.invalidate(Path("/dir"));
+            ASSERT_EQ("b", cache.findEntry(Path("/dir"), "B"));
+
+            contents.push_back("c");
+            cache.invalidateAll();
+            ASSERT_EQ("c", cache.findEntry(Path("/dir"), "C"));
+            ASSERT_EQ(3u, cache.stats().misses);
+        }
+
+        TEST(DirectoryCacheTest, unwatchedListingsAreNotCached) {
+            // a directory that does not exist cannot be watched on any platform
+            size_t listings = 0;
+            DirectoryCache cache([&](const Path& directory, StringList& names) {
+                ++listings;
+                names = StringList { "File.txt" };
+                return true;
+            }, true);
+
+            ASSERT_EQ("File.txt", cache.findEntry(Path("/DirectoryCacheTest/missing"), "file.txt"));
+            ASSERT_EQ("File.txt", cache.findEntry(Path("/DirectoryCacheTest/missing"), "file.txt"));
+
+            ASSERT_EQ(2u, listings);
+            ASSERT_EQ(0u, cache.stats().hits);
+            ASSERT_EQ(2u, cache.stats().misses);
+        }
+
+#ifdef __linux__
+        TEST(DirectoryCacheTest, watchDirectory) {
+            char tmpl[] = "/tmp/DirectoryCacheTestXXXXXX";
+            ASSERT_NE(nullptr, mkdtemp(tmpl));
+            const Path dir(tmpl);
+
+            DirectoryCache cache([](const Path& directory, StringList& names) {
+                const String path = directory.asString();
+                names.clear();
+                std::ifstream probe((path + "/Test.txt").c_str());
+                if (probe.good()) {
+                    names.push_back("Test.txt");
+                }
+                return true;
+            }, true);
+
+            if (!cache.watching()) {
+                rmdir(tmpl);
+                return;
+            }
+
+            ASSERT_EQ("", cache.findEntry(dir, "test.txt"));
+
+            const String file = dir.asString() + "/Test.txt";
+            std::ofstream(file.c_str()) << "test";
+            ASSERT_EQ("Test.txt", cache.findEntry(dir, "test.txt"));
+
+            std::remove(file.c_str());
+            ASSERT_EQ("", cache.findEntry(dir, "test.txt"));
+
+            rmdir(tmpl);
+        }
+
+        TEST(DirectoryCacheTest, watchDirectoryThroughLink) {
+            char tmpl[] = "/tmp/DirectoryCacheTestXXXXXX";
+            ASSERT_NE(nullptr, mkdtemp(tmpl));
+            const String dirPath = String(tmpl) + "/dir";
+            const String linkPath = String(tmpl) + "/link";
+            ASSERT_EQ(0, mkdir(dirPath.c_str(), 0755));
+            ASSERT_EQ(0, symlink(dirPath.c_str(), linkPath.c_str()));
+
+            DirectoryCache cache([](const Path& directory, StringList& names) {
+                const String path = directory.asString();
+                names.clear();
+                std::ifstream probe((path + "/Test.txt").c_str());
+                if (probe.good()) {
+                    names.push_back("Test.txt");
+                }
+                return true;
+            }, true);
+
+            if (cache.watching()) {
+                // both paths name the same directory and therefore share a single watch
+                const Path dir(dirPath);
+                const Path link(linkPath);
+                ASSERT_EQ("", cache.findEntry(dir, "test.txt"));
+                ASSERT_EQ("", cache.findEntry(link, "test.txt"));
+
+                const String file = dirPath + "/Test.txt";
+                std::ofstream(file.c_str()) << "test";
+                ASSERT_EQ("Test.txt", cache.findEntry(dir, "test.txt"));
+                ASSERT_EQ("Test.txt", cache.findEntry(link, "test.txt"));
+
+                // discarding one listing must not remove the watch of the other one
+                cache.invalidate(dir);
+                std::remove(file.c_str());
+                ASSERT_EQ("", cache.findEntry(link, "test.txt"));
+            }
+
+            unlink(linkPath.c_str());
+            rmdir(dirPath.c_str());
+            rmdir(tmpl);
+        }
+#endif
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Exceptions.h"
+#include "IO/DirectoryScanner.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace TrenchBroom {
+    namespace IO {
+        using Tree = std::map<String, DirectoryEntryList>;
+
+        static DirectoryScanner::ListDirectory listTree(const Tree& tree) {
+            return [&tree](const Path& directory, DirectoryEntryList& entries) {
+                const auto it = tree.find(directory.asString('/'));
+                if (it == std::end(tree))
+                    throw FileSystemException("Cannot open directory: '" + directory.asString() + "'");
+                entries.insert(std::end(entries), std::begin(it->second), std::end(it->second));
+            };
+        }
+
+        static Path::List paths(const DirectoryEntryList& entries) {
+            Path::List result;
+            for (const DirectoryEntry& entry : entries)
+                result.push_back(entry.path);
+            return result;
+        }
+
+        TEST(DirectoryScannerTest, scanInDepthFirstOrder) {
+            const Tree tree {
+                { "/root", { { Path("a"), true }, { Path("b.txt"), false }, { Path("c"), true } } },
+                { "/root/a", { { Path("d"), true }, { Path("e.txt"), false } } },
+                { "/root/a/d", {} },
+                { "/root/c", { { Path("f.txt"), false } } },
+            };
+
+            const DirectoryScanner scanner(listTree(tree), 1);
+            ASSERT_EQ(Path::List({ Path("a"), Path("b.txt"), Path("c") }), paths(scanner.scan(Path("/root"), false)));
+
+            const Path::List expected({
+                Path("a/d"), Path("a/e.txt"), Path("a"), Path("b.txt"), Path("c/f.txt"), Path("c")
+            });
+            const DirectoryEntryList entries = scanner.scan(Path("/root"), true);
+            ASSERT_EQ(expected, paths(entries));
+            ASSERT_TRUE(entries[0].directory);
+            ASSERT_FALSE(entries[1].directory);
+            ASSERT_TRUE(entries[2].directory);
+        }
+
+        TEST(DirectoryScannerTest, parallelScanMatchesSerialScan) {
+            // a tree of directories with six subdirectories and three files each, four levels deep
+            Tree tree;
+            std::vector<String> directories({ "/root" });
+            for (size_t level = 0; level < 4; ++level) {
+                std::vector<String> subdirectories;
+                for (const String& directory : directories) {
+                    auto& entries = tree[directory];
+                    for (size_t i = 0; i < 6; ++i) {
+                        entries.emplace_back(Path("dir" + std::to_string(i)), true);
+                        subdirectories.push_back(directory + "/dir" + std::to_string(i));
+                    }
+                    for (size_t i = 0; i < 3; ++i)
+                        entries.emplace_back(Path("file" + std::to_string(i)), false);
+                }
+                directories = subdirectories;
+            }
+            for (const String& directory : directories)
+                tree[directory];
+
+            const auto list = listTree(tree);
+            const DirectoryScanner serialScanner(list, 1);
+            const DirectoryScanner parallelScanner([&list](const Path& directory, DirectoryEntryList& entries) {
+                // vary the time it takes to list a directory so that the workers finish in a different order
+                std::this_thread::sleep_for(std::chrono::microseconds(directory.asString().size() % 7 * 20));
+                list(directory, entries);
+            }, 8);
+
+            const Path::List expected = paths(serialScanner.scan(Path("/root"), true));
+            ASSERT_EQ(6u * (1u + 6u + 36u + 216u) + 3u * (1u + 6u + 36u + 216u), expected.size());
+            for (size_t i = 0; i < 5; ++i)
+                ASSERT_EQ(expected, paths(parallelScanner.scan(Path("/root"), true)));
+        }
+
+        TEST(DirectoryScannerTest, rethrowListingErrors) {
+            Tree tree;
+            auto& rootEntries = tree["/root"];
+            for (size_t i = 0; i < 20; ++i) {
+                rootEntries.emplace_back(Path("dir" + std::to_string(i)), true);
+                if (i != 13)
+                    tree["/root/dir" + std::to_string(i)];
+            }
+
+            ASSERT_THROW(DirectoryScanner(listTree(tree), 1).scan(Path("/root"), true), FileSystemException);
+            ASSERT_THROW(DirectoryScanner(listTree(tree), 4).scan(Path("/root"), true), FileSystemException);
+            ASSERT_NO_THROW(DirectoryScanner(listTree(tree), 4).scan(Path("/root"), false));
+        }
+    }
+}
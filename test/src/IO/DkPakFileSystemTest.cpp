@@ -22,13 +22,106 @@
 #include "IO/DiskFileSystem.h"
 #include "IO/FileMatcher.h"
 #include "IO/DkPakFileSystem.h"
+#include "IO/IdPakFileSystem.h"
 #include "IO/MappedFile.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
 
 namespace TrenchBroom {
     namespace IO {
+        struct DkPakEntry {
+            String name;
+            String data;
+            size_t uncompressedSize;
+            bool compressed;
+        };
+
+        /**
+         * Creates a Daikatana pak file in memory that contains the given entries.
+         */
+        static MappedFile::Ptr createDkPak(const Path& path, const std::vector<DkPakEntry>& entries) {
+            std::vector<char> data(12, 0);
+            std::vector<int32_t> addresses;
+            for (const DkPakEntry& entry : entries) {
+                addresses.push_back(static_cast<int32_t>(data.size()));
+                data.insert(std::end(data), std::begin(entry.data), std::end(entry.data));
+            }
+
+            const auto directoryAddress = static_cast<int32_t>(data.size());
+            const auto directorySize = static_cast<int32_t>(entries.size() * 0x48);
+            for (size_t i = 0; i < entries.size(); ++i) {
+                char entry[0x48];
+                std::memset(entry, 0, sizeof(entry));
+                std::strncpy(entry, entries[i].name.c_str(), 0x37);
+                const int32_t values[] = {
+                    addresses[i],
+                    static_cast<int32_t>(entries[i].uncompressedSize),
+                    static_cast<int32_t>(entries[i].data.size()),
+                    entries[i].compressed ? 1 : 0
+                };
+                std::memcpy(entry + 0x38, values, sizeof(values));
+                data.insert(std::end(data), entry, entry + sizeof(entry));
+            }
+
+            std::memcpy(data.data(), "PACK", 4);
+            std::memcpy(data.data() + 4, &directoryAddress, sizeof(int32_t));
+            std::memcpy(data.data() + 8, &directorySize, sizeof(int32_t));
+
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+            return MappedFile::Ptr(new MappedFileBuffer(path, buffer, data.size()));
+        }
+
+        /**
+         * Creates a compressed entry from the given number of randomly chosen commands, expanding every command byte
+         * by byte to obtain the expected contents.
+         */
+        static DkPakEntry createCompressedEntry(const String& name, const size_t commandCount, const unsigned int seed, String& expected) {
+            std::mt19937 random(seed);
+            String compressed;
+            expected.clear();
+
+            for (size_t i = 0; i < commandCount; ++i) {
+                const auto command = random() % 4;
+                if (command == 0 || expected.size() < 2) {
+                    const auto x = static_cast<unsigned char>(random() % 0x40);
+                    compressed.push_back(static_cast<char>(x));
+                    for (size_t j = 0; j <= x; ++j) {
+                        const auto c = static_cast<char>(random() % 4);
+                        compressed.push_back(c);
+                        expected.push_back(c);
+                    }
+                } else if (command == 1) {
+                    const auto x = static_cast<unsigned char>(0x40 + random() % 0x40);
+                    compressed.push_back(static_cast<char>(x));
+                    expected.append(static_cast<size_t>(x) - 62, '\0');
+                } else if (command == 2) {
+                    const auto x = static_cast<unsigned char>(0x80 + random() % 0x40);
+                    const auto c = static_cast<char>(random() % 256);
+                    compressed.push_back(static_cast<char>(x));
+                    compressed.push_back(c);
+                    expected.append(static_cast<size_t>(x) - 126, c);
+                } else {
+                    // short distances produce overlapping copies
+                    const auto x = static_cast<unsigned char>(0xC0 + random() % 0x3E);
+                    const auto maxOffset = std::min(expected.size() - 2, size_t(255));
+                    const auto offset = random() % 2 == 0 ? random() % std::min(maxOffset + 1, size_t(4)) : random() % (maxOffset + 1);
+                    compressed.push_back(static_cast<char>(x));
+                    compressed.push_back(static_cast<char>(offset));
+                    for (size_t j = 0; j < static_cast<size_t>(x) - 190; ++j)
+                        expected.push_back(expected[expected.size() - offset - 2]);
+                }
+            }
+            compressed.push_back(static_cast<char>(0xFF));
+
+            return DkPakEntry { name, compressed, expected.size(), true };
+        }
+
         TEST(DkPakFileSystemTest, directoryExists) {
             const Path pakPath = Disk::getCurrentWorkingDir() + Path("data/IO/Pak/dkpak_test.pak");
             const MappedFile::Ptr pakFile = Disk::openFile(pakPath);
@@ -149,5 +242,71 @@ namespace TrenchBroom {
             
             ASSERT_TRUE(fs.openFile(Path("amnet.cfg")) != nullptr);
         }
+
+        TEST(DkPakFileSystemTest, openUncompressedFiles) {
+            const Path dkPakPath = Disk::getCurrentWorkingDir() + Path("data/IO/Pak/dkpak_test.pak");
+            const DkPakFileSystem dkFS(dkPakPath, Disk::openFile(dkPakPath));
+
+            // pak1.pak contains the same files
+            const Path pakPath = Disk::getCurrentWorkingDir() + Path("data/IO/Pak/pak1.pak");
+            const IdPakFileSystem idFS(pakPath, Disk::openFile(pakPath));
+
+            const Path::List paths = idFS.findItemsRecursively(Path(""), FileTypeMatcher(true, false));
+            ASSERT_EQ(11u, paths.size());
+            for (const Path& path : paths) {
+                const MappedFile::Ptr expected = idFS.openFile(path);
+                const MappedFile::Ptr actual = dkFS.openFile(path);
+                ASSERT_EQ(String(expected->begin(), expected->end()), String(actual->begin(), actual->end()));
+            }
+        }
+
+        TEST(DkPakFileSystemTest, openCompressedFiles) {
+            std::vector<DkPakEntry> entries;
+            std::vector<String> expected(8);
+            for (size_t i = 0; i < expected.size(); ++i)
+                entries.push_back(createCompressedEntry("data/file" + std::to_string(i) + ".dat", 50 + i * 500, static_cast<unsigned int>(i), expected[i]));
+            entries.push_back(DkPakEntry { "data/plain.dat", "plain", 5, false });
+
+            const Path pakPath("pak0.pak");
+            const MappedFile::Ptr pakFile = createDkPak(pakPath, entries);
+
+            const DkPakFileSystem fs(pakPath, pakFile);
+            for (size_t i = 0; i < expected.size(); ++i) {
+                const MappedFile::Ptr file = fs.openFile(Path(entries[i].name));
+                ASSERT_EQ(expected[i], String(file->begin(), file->end()));
+            }
+
+            const MappedFile::Ptr plain = fs.openFile(Path("data/plain.dat"));
+            ASSERT_EQ(String("plain"), String(plain->begin(), plain->end()));
+
+            // decompressed files are kept in memory
+            ASSERT_EQ(fs.openFile(Path("data/file0.dat"))->begin(), fs.openFile(Path("data/file0.dat"))->begin());
+
+            // unless they do not fit into the cache
+            const DkPakFileSystem uncachedFS(pakPath, pakFile, 0);
+            const MappedFile::Ptr first = uncachedFS.openFile(Path("data/file1.dat"));
+            const MappedFile::Ptr second = uncachedFS.openFile(Path("data/file1.dat"));
+            ASSERT_NE(first->begin(), second->begin());
+            ASSERT_EQ(String(first->begin(), first->end()), String(second->begin(), second->end()));
+        }
+
+        TEST(DkPakFileSystemTest, openInvalidCompressedFile) {
+            const Path pakPath("pak0.pak");
+            const DkPakFileSystem fs(pakPath, createDkPak(pakPath, {
+                // refers to data before the start of the file
+                { "backref.dat", String("\x01" "ab" "\xC0\x05\xFF", 6), 4, true },
+                // literal exceeds the input
+                { "truncated.dat", String("\x05" "ab", 3), 6, true },
+                // produces less data than expected
+                { "short.dat", String("\x01" "ab" "\xFF", 4), 3, true },
+                // produces more data than expected
+                { "long.dat", String("\x7F", 1), 3, true },
+            }));
+
+            ASSERT_THROW(fs.openFile(Path("backref.dat")), FileSystemException);
+            ASSERT_THROW(fs.openFile(Path("truncated.dat")), FileSystemException);
+            ASSERT_THROW(fs.openFile(Path("short.dat")), FileSystemException);
+            ASSERT_THROW(fs.openFile(Path("long.dat")), FileSystemException);
+        }
     }
 }
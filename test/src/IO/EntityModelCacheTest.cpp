@@ -0,0 +1,388 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Assets/Bsp29Model.h"
+#include "Assets/EntityModel.h"
+#include "Assets/Md2Model.h"
+#include "Assets/Palette.h"
+#include "Assets/Texture.h"
+#include "Assets/TextureCollection.h"
+#include "IO/AssetCache.h"
+#include "IO/Bsp29Parser.h"
+#include "IO/DiskFileSystem.h"
+#include "IO/DiskIO.h"
+#include "IO/EntityModelCache.h"
+#include "IO/MappedFile.h"
+#include "IO/Md2Parser.h"
+#include "IO/Path.h"
+#include "Renderer/IndexRangeMap.h"
+
+#include <vecmath/bbox.h>
+#include <vecmath/vec.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <wx/filefn.h>
+
+namespace TrenchBroom {
+    namespace IO {
+        template <typename T>
+        static void append(std::vector<char>& data, const T value) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            data.insert(std::end(data), bytes, bytes + sizeof(T));
+        }
+
+        template <typename T>
+        static void write(std::vector<char>& data, const size_t offset, const T value) {
+            std::memcpy(&data[offset], &value, sizeof(T));
+        }
+
+        static void appendName(std::vector<char>& data, const String& name, const size_t length) {
+            const size_t offset = data.size();
+            data.insert(std::end(data), length, 0);
+            std::copy(std::begin(name), std::end(name), std::begin(data) + static_cast<std::ptrdiff_t>(offset));
+        }
+
+        static MappedFile::Ptr createFile(const String& name, const std::vector<char>& data) {
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+            return MappedFile::Ptr(new MappedFileBuffer(Path(name), buffer, data.size()));
+        }
+
+        static Assets::Palette createPalette() {
+            auto* data = new unsigned char[768];
+            for (size_t i = 0; i < 768; ++i)
+                data[i] = static_cast<unsigned char>(i);
+            return Assets::Palette(768, data);
+        }
+
+        /**
+         * Creates an uncompressed 2x2 PCX image with the given palette indices, each of which must be less than 0xC0.
+         */
+        static std::vector<char> createPcx(const std::vector<unsigned char>& indices) {
+            std::vector<char> data(128, 0);
+            data[0] = 10; // manufacturer
+            data[1] = 5;  // version
+            data[2] = 1;  // encoding
+            data[3] = 8;  // bits per pixel
+            write<uint16_t>(data, 8, 1);  // max x
+            write<uint16_t>(data, 10, 1); // max y
+            data[65] = 1; // planes
+            write<uint16_t>(data, 66, 2); // bytes per line
+            write<uint16_t>(data, 68, 1); // palette info
+
+            for (const unsigned char index : indices)
+                data.push_back(static_cast<char>(index));
+
+            data.push_back(0x0C);
+            for (size_t i = 0; i < 768; ++i)
+                data.push_back(static_cast<char>(i));
+            return data;
+        }
+
+        /**
+         * Creates an MD2 model with the given skins, three vertices and a triangle fan. Every frame moves the
+         * vertices by its index.
+         */
+        static std::vector<char> createMd2(const StringList& skins, const size_t frameCount) {
+            const size_t vertexCount = 3;
+            const size_t frameSize = 2 * 3 * sizeof(float) + Md2Layout::FrameNameLength + vertexCount * 4;
+            const size_t commandCount = 1 + 3 * 3 + 1; // a fan of three vertices and the terminating zero
+
+            const size_t skinOffset = 68;
+            const size_t frameOffset = skinOffset + skins.size() * Md2Layout::SkinNameLength;
+            const size_t commandOffset = frameOffset + frameCount * frameSize;
+            const size_t endOffset = commandOffset + commandCount * sizeof(int32_t);
+
+            std::vector<char> data;
+            append<int32_t>(data, Md2Layout::Ident);
+            append<int32_t>(data, Md2Layout::Version);
+            for (const size_t i : { size_t(2), size_t(2), frameSize, skins.size(), vertexCount, size_t(0), size_t(0), commandCount, frameCount,
+                                    skinOffset, endOffset, endOffset, frameOffset, commandOffset, endOffset }) {
+                append<int32_t>(data, static_cast<int32_t>(i));
+            }
+
+            for (const String& skin : skins)
+                appendName(data, skin, Md2Layout::SkinNameLength);
+
+            for (size_t i = 0; i < frameCount; ++i) {
+                for (const float f : { 1.0f, 1.0f, 1.0f, static_cast<float>(i), 0.0f, 0.0f }) { // scale, offset
+                    append<float>(data, f);
+                }
+                appendName(data, "frame" + std::to_string(i), Md2Layout::FrameNameLength);
+                for (const unsigned char c : { 0, 0, 0, 0, 8, 0, 0, 0, 0, 8, 0, 0 }) { // position and normal index
+                    data.push_back(static_cast<char>(c));
+                }
+            }
+
+            append<int32_t>(data, -3);
+            for (const int32_t index : { 0, 1, 2 }) {
+                append<float>(data, 0.5f * static_cast<float>(index)); // texture coordinates
+                append<float>(data, 0.25f);
+                append<int32_t>(data, index);
+            }
+            append<int32_t>(data, 0);
+
+            return data;
+        }
+
+        /**
+         * Creates a BSP file with an 8x8 texture and two sub models. The first one is a textured quad, and the second
+         * one is a triangle with a texture index that does not exist.
+         */
+        static std::vector<char> createBsp() {
+            std::vector<char> textures;
+            append<int32_t>(textures, 1);
+            append<int32_t>(textures, 8);
+            appendName(textures, "tex", 16);
+            append<int32_t>(textures, 8);
+            append<int32_t>(textures, 8);
+            for (const int32_t offset : { 40, 40 + 64, 40 + 64 + 16, 40 + 64 + 16 + 4 }) {
+                append<int32_t>(textures, offset);
+            }
+            for (size_t i = 0; i < 64 + 16 + 4 + 1; ++i)
+                textures.push_back(static_cast<char>(i));
+
+            std::vector<char> vertices;
+            for (const float f : { 0.0f, 0.0f, 0.0f,  8.0f, 0.0f, 0.0f,  8.0f, 8.0f, 0.0f,  0.0f, 8.0f, 0.0f,
+                                   0.0f, 0.0f, 16.0f,  4.0f, 0.0f, 16.0f,  0.0f, 4.0f, 16.0f }) {
+                append<float>(vertices, f);
+            }
+
+            std::vector<char> texInfos;
+            for (const uint32_t textureIndex : { 0u, 5u }) {
+                for (const float f : { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f }) { // s axis and offset, t axis and offset
+                    append<float>(texInfos, f);
+                }
+                append<uint32_t>(texInfos, textureIndex);
+                append<int32_t>(texInfos, 0);
+            }
+
+            std::vector<char> faces;
+            for (const auto& face : std::vector<std::vector<int32_t>>({ { 0, 4, 0 }, { 4, 3, 1 } })) { // first edge, edge count, texture info
+                append<int32_t>(faces, 0); // plane and side
+                append<int32_t>(faces, face[0]);
+                append<uint16_t>(faces, static_cast<uint16_t>(face[1]));
+                append<uint16_t>(faces, static_cast<uint16_t>(face[2]));
+                faces.insert(std::end(faces), 8, 0); // light styles and offset
+            }
+
+            std::vector<char> edges;
+            for (const uint16_t index : { 0, 0,  0, 1,  1, 2,  2, 3,  3, 0,  4, 5,  5, 6,  6, 4 }) {
+                append<uint16_t>(edges, index);
+            }
+
+            std::vector<char> faceEdges;
+            for (const int32_t index : { 1, 2, 3, 4, 5, 6, -8 }) {
+                append<int32_t>(faceEdges, index);
+            }
+
+            std::vector<char> models;
+            for (const int32_t firstFace : { 0, 1 }) {
+                models.insert(std::end(models), 0x38, 0); // bounds, origin, head nodes and leaf count
+                append<int32_t>(models, firstFace);
+                append<int32_t>(models, 1);
+            }
+
+            // version and the offset and size of 15 lumps
+            std::vector<char> data(4 + 15 * 8, 0);
+            write<int32_t>(data, 0, 29);
+
+            const auto addLump = [&data](const size_t index, const std::vector<char>& lump) {
+                write<int32_t>(data, 4 + index * 8, static_cast<int32_t>(data.size()));
+                write<int32_t>(data, 8 + index * 8, static_cast<int32_t>(lump.size()));
+                data.insert(std::end(data), std::begin(lump), std::end(lump));
+            };
+            addLump(2, textures);
+            addLump(3, vertices);
+            addLump(6, texInfos);
+            addLump(7, faces);
+            addLump(12, edges);
+            addLump(13, faceEdges);
+            addLump(14, models);
+            return data;
+        }
+
+        class EntityModelCacheTestEnvironment {
+        private:
+            Path m_dir;
+        public:
+            explicit EntityModelCacheTestEnvironment(const String& name) :
+            m_dir(Disk::getCurrentWorkingDir() + Path(name)) {
+                AssetCache(cacheDir(), 0).clear();
+            }
+
+            ~EntityModelCacheTestEnvironment() {
+                AssetCache(cacheDir(), 0).clear();
+                ::wxRmdir(cacheDir().asString());
+                if (Disk::directoryExists(m_dir)) {
+                    for (const Path& path : Disk::findItems(m_dir))
+                        Disk::deleteFile(path);
+                    ::wxRmdir(m_dir.asString());
+                }
+            }
+
+            const Path& dir() const {
+                return m_dir;
+            }
+
+            Path cacheDir() const {
+                return m_dir + Path("cache");
+            }
+        };
+
+        using RangeList = std::vector<size_t>;
+
+        static RangeList ranges(const Renderer::IndexRangeMap& indices) {
+            RangeList result;
+            indices.forEachRange([&result](const PrimType primType, const size_t index, const size_t count) {
+                result.insert(std::end(result), { static_cast<size_t>(primType), index, count });
+            });
+            return result;
+        }
+
+        TEST(EntityModelCacheTest, cacheMd2Model) {
+            EntityModelCacheTestEnvironment env("md2cachetest");
+            AssetCache cache(env.cacheDir(), 1024 * 1024);
+
+            const auto writeSkin = [&env](const std::vector<unsigned char>& indices) {
+                const std::vector<char> pcx = createPcx(indices);
+                Disk::createFile(env.dir() + Path("skin.pcx"), String(std::begin(pcx), std::end(pcx)));
+            };
+            writeSkin({ 1, 2, 3, 4 });
+
+            const Assets::Palette palette = createPalette();
+            const MappedFile::Ptr file = createFile("test.md2", createMd2({ "skin.pcx" }, 3));
+            const AssetCache::Key key = EntityModelCache::createKey("md2", *file);
+
+            DiskFileSystem fs(env.dir());
+            EntityModelCache modelCache(cache, fs);
+
+            Md2Parser storeParser("test", file, palette, fs);
+            std::unique_ptr<Assets::EntityModel> stored(modelCache.loadMd2Model(key, "test", storeParser));
+            Md2Parser findParser("test", file, palette, fs);
+            std::unique_ptr<Assets::EntityModel> cached(modelCache.loadMd2Model(key, "test", findParser));
+            ASSERT_EQ(1u, cache.stats().hits);
+            ASSERT_EQ(1u, cache.stats().misses);
+
+            const auto* expectedModel = static_cast<const Assets::Md2Model*>(stored.get());
+            const auto* cachedModel = static_cast<const Assets::Md2Model*>(cached.get());
+
+            // storing a model copies its frames without decoding them
+            ASSERT_EQ(0u, expectedModel->cachedFrameCount());
+            ASSERT_EQ(0u, cachedModel->cachedFrameCount());
+
+            ASSERT_EQ(3u, cachedModel->frameCount());
+            for (size_t i = 0; i < expectedModel->frameCount(); ++i) {
+                const auto expectedFrame = expectedModel->frame(i);
+                const auto cachedFrame = cachedModel->frame(i);
+                ASSERT_EQ(3u, cachedFrame->vertices().size());
+                ASSERT_TRUE(expectedFrame->vertices() == cachedFrame->vertices());
+                ASSERT_EQ(ranges(expectedFrame->indices()), ranges(cachedFrame->indices()));
+                ASSERT_EQ(expectedFrame->bounds(), cachedFrame->bounds());
+            }
+
+            ASSERT_EQ(1u, cachedModel->skins().size());
+            const Assets::Texture* expectedSkin = expectedModel->skins()[0];
+            const Assets::Texture* cachedSkin = cachedModel->skins()[0];
+            ASSERT_EQ(expectedSkin->name(), cachedSkin->name());
+            ASSERT_EQ(expectedSkin->width(), cachedSkin->width());
+            ASSERT_EQ(expectedSkin->height(), cachedSkin->height());
+            ASSERT_EQ(0, std::memcmp(expectedSkin->buffers()[0].ptr(), cachedSkin->buffers()[0].ptr(), expectedSkin->buffers()[0].size()));
+
+            // an entry with a changed skin is replaced
+            writeSkin({ 5, 6, 7, 8 });
+            Md2Parser changedParser("test", file, palette, fs);
+            std::unique_ptr<Assets::EntityModel> changed(modelCache.loadMd2Model(key, "test", changedParser));
+            const Assets::Texture* changedSkin = static_cast<const Assets::Md2Model*>(changed.get())->skins()[0];
+            ASSERT_NE(0, std::memcmp(expectedSkin->buffers()[0].ptr(), changedSkin->buffers()[0].ptr(), expectedSkin->buffers()[0].size()));
+
+            Md2Parser replacedParser("test", file, palette, fs);
+            std::unique_ptr<Assets::EntityModel> replaced(modelCache.loadMd2Model(key, "test", replacedParser));
+            const Assets::Texture* replacedSkin = static_cast<const Assets::Md2Model*>(replaced.get())->skins()[0];
+            ASSERT_EQ(0, std::memcmp(changedSkin->buffers()[0].ptr(), replacedSkin->buffers()[0].ptr(), changedSkin->buffers()[0].size()));
+        }
+
+        TEST(EntityModelCacheTest, cacheBspModel) {
+            EntityModelCacheTestEnvironment env("bspcachetest");
+            AssetCache cache(env.cacheDir(), 1024 * 1024);
+
+            const Assets::Palette palette = createPalette();
+            const std::vector<char> data = createBsp();
+            const MappedFile::Ptr file = createFile("test.bsp", data);
+            const AssetCache::Key key = EntityModelCache::createKey("bsp", *file);
+
+            DiskFileSystem fs(Disk::getCurrentWorkingDir());
+            EntityModelCache modelCache(cache, fs);
+
+            Bsp29Parser storeParser("test", file->begin(), file->end(), palette);
+            std::unique_ptr<Assets::EntityModel> stored(modelCache.loadBspModel(key, "test", storeParser));
+            Bsp29Parser findParser("test", file->begin(), file->end(), palette);
+            std::unique_ptr<Assets::EntityModel> cached(modelCache.loadBspModel(key, "test", findParser));
+            ASSERT_EQ(1u, cache.stats().hits);
+            ASSERT_EQ(1u, cache.stats().misses);
+
+            const auto* expectedModel = static_cast<const Assets::Bsp29Model*>(stored.get());
+            const auto* cachedModel = static_cast<const Assets::Bsp29Model*>(cached.get());
+
+            const Assets::TextureList& expectedTextures = expectedModel->textureCollection().textures();
+            const Assets::TextureList& cachedTextures = cachedModel->textureCollection().textures();
+            ASSERT_EQ(1u, cachedTextures.size());
+            ASSERT_EQ(expectedTextures[0]->name(), cachedTextures[0]->name());
+            ASSERT_EQ(expectedTextures[0]->width(), cachedTextures[0]->width());
+            ASSERT_EQ(expectedTextures[0]->height(), cachedTextures[0]->height());
+            ASSERT_EQ(expectedTextures[0]->buffers().size(), cachedTextures[0]->buffers().size());
+            for (size_t i = 0; i < expectedTextures[0]->buffers().size(); ++i) {
+                const Assets::TextureBuffer& expectedBuffer = expectedTextures[0]->buffers()[i];
+                const Assets::TextureBuffer& cachedBuffer = cachedTextures[0]->buffers()[i];
+                ASSERT_EQ(expectedBuffer.size(), cachedBuffer.size());
+                ASSERT_EQ(0, std::memcmp(expectedBuffer.ptr(), cachedBuffer.ptr(), expectedBuffer.size()));
+            }
+
+            ASSERT_EQ(2u, cachedModel->subModelCount());
+            for (size_t i = 0; i < expectedModel->subModelCount(); ++i) {
+                ASSERT_EQ(expectedModel->subModelBounds(i), cachedModel->subModelBounds(i));
+
+                const Assets::Bsp29Model::FaceList& expectedFaces = expectedModel->subModelFaces(i);
+                const Assets::Bsp29Model::FaceList& cachedFaces = cachedModel->subModelFaces(i);
+                ASSERT_EQ(1u, cachedFaces.size());
+                ASSERT_TRUE(expectedFaces[0].vertices() == cachedFaces[0].vertices());
+            }
+
+            // the faces refer to the textures of the cached model, or to none if their texture does not exist
+            ASSERT_EQ(4u, cachedModel->subModelFaces(0)[0].vertices().size());
+            ASSERT_EQ(cachedTextures[0], cachedModel->subModelFaces(0)[0].texture());
+            ASSERT_EQ(3u, cachedModel->subModelFaces(1)[0].vertices().size());
+            ASSERT_EQ(nullptr, cachedModel->subModelFaces(1)[0].texture());
+
+            // a changed model file does not use the entry
+            std::vector<char> changedData = data;
+            changedData.back() ^= 1;
+            ASSERT_EQ(nullptr, cache.find(EntityModelCache::createKey("bsp", *createFile("test.bsp", changedData))));
+        }
+    }
+}
@@ -24,14 +24,22 @@
 #include "Assets/EntityDefinition.h"
 #include "Assets/AttributeDefinition.h"
 #include "Assets/EntityDefinitionTestUtils.h"
+#include "Assets/ModelDefinition.h"
+#include "EL/Expression.h"
+#include "IO/AssetCache.h"
+#include "IO/BufferedParserStatus.h"
 #include "IO/DiskIO.h"
+#include "IO/EntityDefinitionCache.h"
 #include "IO/FgdParser.h"
 #include "IO/Path.h"
 #include "IO/TestParserStatus.h"
+#include "Model/EntityAttributes.h"
 #include "Model/ModelTypes.h"
 
 #include <algorithm>
 
+#include <wx/filefn.h>
+
 namespace TrenchBroom {
     namespace IO {
         TEST(FgdParserTest, parseIncludedFgdFiles) {
@@ -686,5 +694,227 @@ namespace TrenchBroom {
             ASSERT_EQ(1u, defs.size());
             ASSERT_TRUE(std::any_of(std::begin(defs), std::end(defs), [](const auto* def) { return def->name() == "worldspawn"; }));
         }
+
+        TEST(FgdParserTest, parseIncludeMessageOrder) {
+            const Path dir = Disk::getCurrentWorkingDir() + Path("fgdmessagetest");
+            const Path hostPath = dir + Path("host.fgd");
+            const Path basePath = dir + Path("base.fgd");
+            Disk::createFile(hostPath,
+                             "@PointClass color(255 0 0) color(0 255 0) = point_a : \"A\" []\n"
+                             "@include \"base.fgd\"\n"
+                             "@PointClass color(255 0 0) color(0 255 0) = point_c : \"C\" []\n"
+                             "@SolidClass size(-8 -8 -8, 8 8 8) = solid_d : \"D\" []\n"
+                             "@include \"missing.fgd\"\n");
+            Disk::createFile(basePath,
+                             "@PointClass color(255 0 0) color(0 255 0) = point_b : \"B\" []\n");
+
+            MappedFile::Ptr file = Disk::openFile(hostPath);
+            const Color defaultColor(1.0f, 1.0f, 1.0f, 1.0f);
+            FgdParser parser(file->begin(), file->end(), defaultColor, file->path());
+
+            BufferedParserStatus status;
+            auto defs = parser.parseDefinitions(status);
+            ASSERT_EQ(4u, defs.size());
+
+            // the messages appear as if every included file was parsed at the position of its include directive
+            const StringList expected {
+                "Found multiple color attributes (line 1",
+                "Parsing included file 'base.fgd' (line 2)",
+                "Resolved 'base.fgd'",
+                "Found multiple color attributes (line 1",
+                "Found multiple color attributes (line 3",
+                "Solid entity definition must not have a size (line 4",
+                "Parsing included file 'missing.fgd' (line 5)",
+                "Failed to parse included file"
+            };
+            const auto& messages = status.messages();
+            ASSERT_EQ(expected.size(), messages.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_TRUE(StringUtils::isPrefix(messages[i].second, expected[i])) << messages[i].second;
+            }
+
+            VectorUtils::clearAndDelete(defs);
+
+            file.reset();
+            Disk::deleteFile(hostPath);
+            Disk::deleteFile(basePath);
+            ::wxRmdir(dir.asString());
+        }
+
+        static void assertEntityDefinitionsEqual(const Assets::EntityDefinitionList& expected, const Assets::EntityDefinitionList& actual) {
+            ASSERT_EQ(expected.size(), actual.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                const auto* expectedDef = expected[i];
+                const auto* actualDef = actual[i];
+                ASSERT_NE(expectedDef, actualDef);
+                ASSERT_EQ(expectedDef->type(), actualDef->type());
+                ASSERT_EQ(expectedDef->name(), actualDef->name());
+                ASSERT_EQ(expectedDef->color(), actualDef->color());
+                ASSERT_EQ(expectedDef->description(), actualDef->description());
+
+                const auto& expectedAttributeDefs = expectedDef->attributeDefinitions();
+                const auto& actualAttributeDefs = actualDef->attributeDefinitions();
+                ASSERT_EQ(expectedAttributeDefs.size(), actualAttributeDefs.size());
+                for (size_t j = 0; j < expectedAttributeDefs.size(); ++j) {
+                    const auto& expectedAttributeDef = *expectedAttributeDefs[j];
+                    const auto& actualAttributeDef = *actualAttributeDefs[j];
+                    ASSERT_TRUE(expectedAttributeDef.equals(&actualAttributeDef));
+                    ASSERT_EQ(expectedAttributeDef.shortDescription(), actualAttributeDef.shortDescription());
+                    ASSERT_EQ(expectedAttributeDef.longDescription(), actualAttributeDef.longDescription());
+                    ASSERT_EQ(Assets::AttributeDefinition::defaultValue(expectedAttributeDef), Assets::AttributeDefinition::defaultValue(actualAttributeDef));
+                }
+
+                if (expectedDef->type() == Assets::EntityDefinition::Type_PointEntity) {
+                    const auto* expectedPointDef = static_cast<const Assets::PointEntityDefinition*>(expectedDef);
+                    const auto* actualPointDef = static_cast<const Assets::PointEntityDefinition*>(actualDef);
+                    ASSERT_EQ(expectedPointDef->bounds(), actualPointDef->bounds());
+                    ASSERT_EQ(expectedPointDef->defaultModel(), actualPointDef->defaultModel());
+                    ASSERT_EQ(expectedPointDef->modelDefinition().expression().asString(), actualPointDef->modelDefinition().expression().asString());
+                }
+            }
+        }
+
+        TEST(FgdParserTest, cacheParsedDefinitions) {
+            const Path dir = Disk::getCurrentWorkingDir() + Path("fgdcachetest");
+            const Path hostPath = dir + Path("host.fgd");
+            const Path basePath = dir + Path("base.fgd");
+            const String baseContents =
+            "@BaseClass = Targetname [ targetname(target_source) : \"Name\" target(target_destination) : \"Target\" ]\n"
+            "@SolidClass = worldspawn : \"World\" [ message(string) : \"Message\" : \"Hello\" sounds(integer) : \"CD track\" : 2 ]\n";
+            Disk::createFile(hostPath,
+                             "@include \"base.fgd\"\n"
+                             "@PointClass base(Targetname) size(-16 -16 -24, 16 16 32) color(255 0 0) model(\":progs/player.mdl\" 0 1) = info_player_start : \"Player start\"\n"
+                             "[\n"
+                             "    spawnflags(flags) = [ 1 : \"Not in easy\" : 0 2 : \"Not in normal\" : 1 ]\n"
+                             "    style(choices) : \"Style\" : 1 = [ 0 : \"Normal\" 1 : \"Flicker\" ]\n"
+                             "    angle(float) : \"Angle\" : \"1.5\"\n"
+                             "    _color(color255) : \"Color\"\n"
+                             "]\n"
+                             "@PointClass model({{ spawnflags == 1 -> 'maps/b_shell1.bsp', 'maps/b_shell0.bsp' }}) = item_shells : \"Shells\" []\n"
+                             "@PointClass = info_null : \"Null\" []\n");
+            Disk::createFile(basePath, baseContents);
+
+            const Path cacheDir = dir + Path("cache");
+            AssetCache cache(cacheDir, 1024 * 1024);
+            cache.clear();
+            EntityDefinitionCache definitionCache(cache);
+
+            const Color defaultColor(1.0f, 1.0f, 1.0f, 1.0f);
+            MappedFile::Ptr file = Disk::openFile(hostPath);
+            const AssetCache::Key key = EntityDefinitionCache::createKey(*file, defaultColor);
+
+            FgdParser storeParser(file->begin(), file->end(), defaultColor, hostPath);
+            TestParserStatus storeStatus;
+            auto defs = definitionCache.loadFgdDefinitions(key, storeParser, storeStatus);
+            ASSERT_EQ(4u, defs.size());
+            ASSERT_EQ(0u, cache.stats().hits);
+            ASSERT_EQ(1u, cache.stats().misses);
+            ASSERT_EQ(4u, storeStatus.countStatus(Logger::LogLevel_Debug));
+
+            // the cached definitions and the messages of the parser are restored without parsing
+            FgdParser findParser(file->begin(), file->end(), defaultColor, hostPath);
+            TestParserStatus findStatus;
+            auto cachedDefs = definitionCache.loadFgdDefinitions(key, findParser, findStatus);
+            ASSERT_EQ(1u, cache.stats().hits);
+            ASSERT_TRUE(findParser.searchedIncludePaths().empty());
+            assertEntityDefinitionsEqual(defs, cachedDefs);
+            ASSERT_EQ(4u, findStatus.countStatus(Logger::LogLevel_Debug));
+
+            const auto* shells = static_cast<const Assets::PointEntityDefinition*>(cachedDefs[2]);
+            ASSERT_EQ(String("item_shells"), shells->name());
+            Model::EntityAttributes attributes;
+            attributes.addOrUpdateAttribute("spawnflags", "1", nullptr);
+            ASSERT_EQ(Assets::ModelSpecification(Path("maps/b_shell1.bsp")), shells->model(attributes));
+
+            // a different default color uses a different entry
+            ASSERT_NE(key.identity(), EntityDefinitionCache::createKey(*file, Color(0.0f, 0.0f, 0.0f, 1.0f)).identity());
+
+            // a changed included file invalidates the entry
+            const String changedContents = baseContents + "@PointClass = info_notnull : \"Not null\" []\n";
+            Disk::createFile(basePath, changedContents);
+            FgdParser changedParser(file->begin(), file->end(), defaultColor, hostPath);
+            TestParserStatus changedStatus;
+            auto changedDefs = definitionCache.loadFgdDefinitions(key, changedParser, changedStatus);
+            ASSERT_EQ(5u, changedDefs.size());
+            ASSERT_EQ(1u, changedParser.searchedIncludePaths().size());
+
+            // so does an edit that preserves the size of the file
+            const String editedContents = StringUtils::replaceAll(changedContents, "Hello", "Howdy");
+            ASSERT_EQ(changedContents.size(), editedContents.size());
+            Disk::createFile(basePath, editedContents);
+            FgdParser editedParser(file->begin(), file->end(), defaultColor, hostPath);
+            TestParserStatus editedStatus;
+            auto editedDefs = definitionCache.loadFgdDefinitions(key, editedParser, editedStatus);
+            ASSERT_EQ(1u, editedParser.searchedIncludePaths().size());
+
+            const auto* worldspawn = editedDefs[0];
+            ASSERT_EQ(String("worldspawn"), worldspawn->name());
+            ASSERT_EQ(String("Howdy"), Assets::AttributeDefinition::defaultValue(*worldspawn->attributeDefinition("message")));
+
+            VectorUtils::clearAndDelete(defs);
+            VectorUtils::clearAndDelete(cachedDefs);
+            VectorUtils::clearAndDelete(changedDefs);
+            VectorUtils::clearAndDelete(editedDefs);
+
+            file.reset();
+            cache.clear();
+            ::wxRmdir(cacheDir.asString());
+            Disk::deleteFile(hostPath);
+            Disk::deleteFile(basePath);
+            ::wxRmdir(dir.asString());
+        }
+
+        TEST(FgdParserTest, cacheDefinitionsWithMissingInclude) {
+            const Path dir = Disk::getCurrentWorkingDir() + Path("fgdcachetest");
+            const Path hostPath = dir + Path("host.fgd");
+            const Path basePath = dir + Path("base.fgd");
+            Disk::createFile(hostPath,
+                             "@include \"base.fgd\"\n"
+                             "@PointClass = info_null : \"Null\" []\n");
+
+            const Path cacheDir = dir + Path("cache");
+            AssetCache cache(cacheDir, 1024 * 1024);
+            cache.clear();
+            EntityDefinitionCache definitionCache(cache);
+
+            const Color defaultColor(1.0f, 1.0f, 1.0f, 1.0f);
+            MappedFile::Ptr file = Disk::openFile(hostPath);
+            const AssetCache::Key key = EntityDefinitionCache::createKey(*file, defaultColor);
+
+            FgdParser missingParser(file->begin(), file->end(), defaultColor, hostPath);
+            BufferedParserStatus missingStatus;
+            auto missingDefs = definitionCache.loadFgdDefinitions(key, missingParser, missingStatus);
+            ASSERT_EQ(1u, missingDefs.size());
+            ASSERT_EQ(2u, missingStatus.messages().size());
+            ASSERT_TRUE(StringUtils::isPrefix(missingStatus.messages()[1].second, "Failed to parse included file"));
+            ASSERT_EQ(Path::List(1, basePath), missingParser.searchedIncludePaths());
+
+            FgdParser findParser(file->begin(), file->end(), defaultColor, hostPath);
+            BufferedParserStatus findStatus;
+            auto cachedDefs = definitionCache.loadFgdDefinitions(key, findParser, findStatus);
+            ASSERT_EQ(1u, cache.stats().hits);
+            ASSERT_EQ(1u, cachedDefs.size());
+            ASSERT_EQ(missingStatus.messages(), findStatus.messages());
+
+            // creating the missing file invalidates the entry
+            Disk::createFile(basePath, "@PointClass = info_notnull : \"Not null\" []\n");
+            FgdParser createdParser(file->begin(), file->end(), defaultColor, hostPath);
+            BufferedParserStatus createdStatus;
+            auto createdDefs = definitionCache.loadFgdDefinitions(key, createdParser, createdStatus);
+            ASSERT_EQ(2u, createdDefs.size());
+            ASSERT_EQ(2u, createdStatus.messages().size());
+            ASSERT_TRUE(StringUtils::isPrefix(createdStatus.messages()[1].second, "Resolved"));
+
+            VectorUtils::clearAndDelete(missingDefs);
+            VectorUtils::clearAndDelete(cachedDefs);
+            VectorUtils::clearAndDelete(createdDefs);
+
+            file.reset();
+            cache.clear();
+            ::wxRmdir(cacheDir.asString());
+            Disk::deleteFile(hostPath);
+            Disk::deleteFile(basePath);
+            ::wxRmdir(dir.asString());
+        }
     }
 }
@@ -0,0 +1,122 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "IO/FileSystemHierarchy.h"
+#include "IO/IdPakFileSystem.h"
+#include "IO/MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        /**
+         * Creates a pak file in memory that contains a file for each of the given names. The contents of each file
+         * are the name of the pak followed by the name of the file.
+         */
+        static IdPakFileSystem* createPak(const String& pakName, const StringList& fileNames) {
+            std::vector<char> data(12, 0);
+            std::vector<std::pair<int32_t, int32_t>> entries;
+            for (const String& fileName : fileNames) {
+                const String contents = pakName + ":" + fileName;
+                entries.emplace_back(static_cast<int32_t>(data.size()), static_cast<int32_t>(contents.size()));
+                data.insert(std::end(data), std::begin(contents), std::end(contents));
+            }
+
+            const auto directoryAddress = static_cast<int32_t>(data.size());
+            const auto directorySize = static_cast<int32_t>(fileNames.size() * 0x40);
+            for (size_t i = 0; i < fileNames.size(); ++i) {
+                char entry[0x40];
+                std::memset(entry, 0, sizeof(entry));
+                std::strncpy(entry, fileNames[i].c_str(), 0x37);
+                std::memcpy(entry + 0x38, &entries[i].first, sizeof(int32_t));
+                std::memcpy(entry + 0x3C, &entries[i].second, sizeof(int32_t));
+                data.insert(std::end(data), entry, entry + sizeof(entry));
+            }
+
+            std::memcpy(data.data(), "PACK", 4);
+            std::memcpy(data.data() + 4, &directoryAddress, sizeof(int32_t));
+            std::memcpy(data.data() + 8, &directorySize, sizeof(int32_t));
+
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+
+            const Path path(pakName);
+            return new IdPakFileSystem(path, MappedFile::Ptr(new MappedFileBuffer(path, buffer, data.size())));
+        }
+
+        static String readFile(const FileSystem& fs, const Path& path) {
+            const auto file = fs.openFile(path);
+            return String(file->begin(), file->end());
+        }
+
+        TEST(FileSystemHierarchyTest, findFilesInPushedFileSystems) {
+            FileSystemHierarchy fs;
+            fs.pushFileSystem(createPak("pak0", { "progs/player.mdl", "maps/start.bsp" }));
+            fs.pushFileSystem(createPak("pak1", { "progs/player.mdl", "gfx/palette.lmp" }));
+
+            ASSERT_TRUE(fs.fileExists(Path("progs/player.mdl")));
+            ASSERT_TRUE(fs.fileExists(Path("PROGS/Player.mdl")));
+            ASSERT_TRUE(fs.fileExists(Path("maps/start.bsp")));
+            ASSERT_TRUE(fs.fileExists(Path("gfx/palette.lmp")));
+            ASSERT_FALSE(fs.fileExists(Path("progs/missing.mdl")));
+            ASSERT_FALSE(fs.fileExists(Path("progs")));
+
+            ASSERT_TRUE(fs.directoryExists(Path("")));
+            ASSERT_TRUE(fs.directoryExists(Path("Progs")));
+            ASSERT_TRUE(fs.directoryExists(Path("gfx")));
+            ASSERT_FALSE(fs.directoryExists(Path("sound")));
+            ASSERT_FALSE(fs.directoryExists(Path("progs/player.mdl")));
+
+            // the file systems pushed later override the ones pushed earlier
+            ASSERT_EQ("pak1:progs/player.mdl", readFile(fs, Path("progs/player.mdl")));
+            ASSERT_EQ("pak0:maps/start.bsp", readFile(fs, Path("maps/start.bsp")));
+        }
+
+        TEST(FileSystemHierarchyTest, popFileSystem) {
+            FileSystemHierarchy fs;
+            fs.pushFileSystem(createPak("pak0", { "progs/player.mdl" }));
+            fs.pushFileSystem(createPak("pak1", { "progs/player.mdl", "gfx/palette.lmp" }));
+            fs.pushFileSystem(createPak("pak2", { "progs/player.mdl" }));
+            ASSERT_EQ(3u, fs.fileSystemCount());
+            ASSERT_EQ("pak2:progs/player.mdl", readFile(fs, Path("progs/player.mdl")));
+
+            fs.popFileSystem();
+            ASSERT_EQ("pak1:progs/player.mdl", readFile(fs, Path("progs/player.mdl")));
+            ASSERT_TRUE(fs.directoryExists(Path("gfx")));
+
+            fs.popFileSystem();
+            ASSERT_EQ("pak0:progs/player.mdl", readFile(fs, Path("progs/player.mdl")));
+            ASSERT_FALSE(fs.fileExists(Path("gfx/palette.lmp")));
+            ASSERT_FALSE(fs.directoryExists(Path("gfx")));
+            ASSERT_TRUE(fs.directoryExists(Path("progs")));
+
+            fs.popFileSystem();
+            ASSERT_FALSE(fs.fileExists(Path("progs/player.mdl")));
+            ASSERT_FALSE(fs.directoryExists(Path("progs")));
+
+            fs.pushFileSystem(createPak("pak3", { "progs/player.mdl" }));
+            ASSERT_EQ("pak3:progs/player.mdl", readFile(fs, Path("progs/player.mdl")));
+        }
+    }
+}
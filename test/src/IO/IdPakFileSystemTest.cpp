@@ -26,9 +26,44 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 namespace TrenchBroom {
     namespace IO {
+        /**
+         * Creates a pak file in memory that contains the given files, each given as a pair of name and contents.
+         */
+        static MappedFile::Ptr createPak(const Path& path, const std::vector<std::pair<String, String>>& files) {
+            std::vector<char> data(12, 0);
+            std::vector<int32_t> addresses;
+            for (const auto& file : files) {
+                addresses.push_back(static_cast<int32_t>(data.size()));
+                data.insert(std::end(data), std::begin(file.second), std::end(file.second));
+            }
+
+            const auto directoryAddress = static_cast<int32_t>(data.size());
+            const auto directorySize = static_cast<int32_t>(files.size() * 0x40);
+            for (size_t i = 0; i < files.size(); ++i) {
+                char entry[0x40];
+                std::memset(entry, 0, sizeof(entry));
+                std::strncpy(entry, files[i].first.c_str(), 0x37);
+                const auto length = static_cast<int32_t>(files[i].second.size());
+                std::memcpy(entry + 0x38, &addresses[i], sizeof(int32_t));
+                std::memcpy(entry + 0x3C, &length, sizeof(int32_t));
+                data.insert(std::end(data), entry, entry + sizeof(entry));
+            }
+
+            std::memcpy(data.data(), "PACK", 4);
+            std::memcpy(data.data() + 4, &directoryAddress, sizeof(int32_t));
+            std::memcpy(data.data() + 8, &directorySize, sizeof(int32_t));
+
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+            return MappedFile::Ptr(new MappedFileBuffer(path, buffer, data.size()));
+        }
+
         TEST(IdPakFileSystemTest, directoryExists) {
             const Path pakPath = Disk::getCurrentWorkingDir() + Path("data/IO/Pak/pak3.pak");
             const MappedFile::Ptr pakFile = Disk::openFile(pakPath);
@@ -149,5 +184,36 @@ namespace TrenchBroom {
             
             ASSERT_TRUE(fs.openFile(Path("amnet.cfg")) != nullptr);
         }
+
+        TEST(IdPakFileSystemTest, caseInsensitiveEntries) {
+            const Path pakPath("pak0.pak");
+            const IdPakFileSystem fs(pakPath, createPak(pakPath, {
+                { "Maps/Start.bsp", "first" },
+                { "maps/e1/m1.bsp", "m1" },
+                { "progs/player.mdl", "player" },
+                { "MAPS/START.BSP", "second" },
+                { "maps/B.bsp", "b" },
+                { "maps/a.bsp", "a" },
+            }));
+
+            ASSERT_TRUE(fs.directoryExists(Path("maps")));
+            ASSERT_TRUE(fs.directoryExists(Path("MAPS/E1")));
+            ASSERT_FALSE(fs.directoryExists(Path("maps/start.bsp")));
+            ASSERT_FALSE(fs.directoryExists(Path("maps/e2")));
+            ASSERT_FALSE(fs.fileExists(Path("maps")));
+            ASSERT_FALSE(fs.fileExists(Path("maps/start")));
+            ASSERT_FALSE(fs.fileExists(Path("maps/start.bspx")));
+            ASSERT_TRUE(fs.fileExists(Path("maps/e1/M1.BSP")));
+
+            // later entries replace earlier entries with the same path
+            const auto file = fs.openFile(Path("maps/start.bsp"));
+            ASSERT_EQ(String("second"), String(file->begin(), file->end()));
+
+            // directories are listed first, then files, each sorted by name
+            const Path::List expected({ Path("e1"), Path("a.bsp"), Path("b.bsp"), Path("start.bsp") });
+            ASSERT_EQ(expected, fs.getDirectoryContents(Path("Maps")));
+            ASSERT_EQ(Path::List({ Path("maps"), Path("progs") }), fs.getDirectoryContents(Path("")));
+            ASSERT_THROW(fs.getDirectoryContents(Path("textures")), FileSystemException);
+        }
     }
 }
@@ -0,0 +1,246 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Exceptions.h"
+#include "Assets/EntityModel.h"
+#include "Assets/MdlModel.h"
+#include "Assets/Palette.h"
+#include "Assets/Texture.h"
+#include "IO/AssetCache.h"
+#include "IO/DiskFileSystem.h"
+#include "IO/DiskIO.h"
+#include "IO/EntityModelCache.h"
+#include "IO/MappedFile.h"
+#include "IO/MdlParser.h"
+#include "IO/Path.h"
+
+#include <vecmath/bbox.h>
+#include <vecmath/vec.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <wx/filefn.h>
+
+namespace TrenchBroom {
+    namespace IO {
+        using PackedVertex = vm::vec<unsigned char, 4>;
+        using PackedFrame = std::vector<PackedVertex>;
+        using PackedFrameGroup = std::vector<PackedFrame>;
+
+        template <typename T>
+        static void append(std::vector<char>& data, const T value) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            data.insert(std::end(data), bytes, bytes + sizeof(T));
+        }
+
+        static void appendFrame(std::vector<char>& data, const PackedFrame& frame) {
+            data.insert(std::end(data), 8 + 16, 0); // bounds and name
+            for (const PackedVertex& vertex : frame) {
+                for (size_t i = 0; i < 4; ++i) {
+                    data.push_back(static_cast<char>(vertex[i]));
+                }
+            }
+        }
+
+        /**
+         * Creates an MDL model with a single 2x2 skin and a single triangle. A frame group with one element is stored
+         * as a single frame, any other frame group is stored as a frame group.
+         */
+        static std::vector<char> createMdl(const std::vector<PackedFrameGroup>& frames) {
+            std::vector<char> data;
+            data.insert(std::end(data), { 'I', 'D', 'P', 'O' });
+            append<int32_t>(data, 6);
+            for (const float f : { 2.0f, 2.0f, 2.0f, -8.0f, -8.0f, -8.0f, 16.0f, 0.0f, 0.0f, 0.0f }) { // scale, origin, radius, eye position
+                append<float>(data, f);
+            }
+            for (const int32_t i : { 1, 2, 2, 3, 1, static_cast<int32_t>(frames.size()), 0, 0, 0 }) { // skins, skin size, vertices, triangles, frames, sync type, flags, size
+                append<int32_t>(data, i);
+            }
+
+            append<int32_t>(data, 0);
+            data.insert(std::end(data), 4, 0);
+
+            for (const int32_t i : { 0, 0, 0, 0, 1, 0, 0, 0, 1 }) { // skin vertices
+                append<int32_t>(data, i);
+            }
+            for (const int32_t i : { 1, 0, 1, 2 }) { // triangle
+                append<int32_t>(data, i);
+            }
+
+            for (const PackedFrameGroup& group : frames) {
+                if (group.size() == 1) {
+                    append<int32_t>(data, 0);
+                    appendFrame(data, group.front());
+                } else {
+                    append<int32_t>(data, 1);
+                    append<int32_t>(data, static_cast<int32_t>(group.size()));
+                    data.insert(std::end(data), 8, 0); // bounds
+                    for (size_t i = 0; i < group.size(); ++i) {
+                        append<float>(data, 0.1f * static_cast<float>(i));
+                    }
+                    for (const PackedFrame& frame : group) {
+                        appendFrame(data, frame);
+                    }
+                }
+            }
+
+            return data;
+        }
+
+        static MappedFile::Ptr createFile(const std::vector<char>& data) {
+            char* buffer = new char[data.size()];
+            std::copy(std::begin(data), std::end(data), buffer);
+            return MappedFile::Ptr(new MappedFileBuffer(Path("test.mdl"), buffer, data.size()));
+        }
+
+        static Assets::Palette createPalette() {
+            auto* data = new unsigned char[768];
+            std::fill(data, data + 768, 0);
+            return Assets::Palette(768, data);
+        }
+
+        TEST(MdlParserTest, parseFramesOnDemand) {
+            const std::vector<PackedFrameGroup> frames = {
+                { { PackedVertex(0, 0, 0, 0), PackedVertex(4, 0, 0, 0), PackedVertex(0, 4, 8, 0) } },
+                { { PackedVertex(1, 1, 1, 0), PackedVertex(2, 2, 2, 0), PackedVertex(3, 3, 3, 0) },
+                  { PackedVertex(9, 9, 9, 0), PackedVertex(9, 9, 9, 0), PackedVertex(9, 9, 9, 0) } },
+                { },
+                { { PackedVertex(8, 8, 8, 0), PackedVertex(8, 9, 8, 0), PackedVertex(8, 8, 10, 0) } }
+            };
+
+            const Assets::Palette palette = createPalette();
+            MappedFile::Ptr file = createFile(createMdl(frames));
+
+            MdlParser parser("test", file, palette);
+            std::unique_ptr<Assets::EntityModel> model(parser.parseModel());
+
+            // the model keeps the file alive
+            file.reset();
+
+            ASSERT_EQ(4u, static_cast<const Assets::MdlModel*>(model.get())->frameCount());
+            ASSERT_EQ(vm::bbox3f(vm::vec3f(-8.0f, -8.0f, -8.0f), vm::vec3f(0.0f, 0.0f, 8.0f)), model->bounds(0, 0));
+            ASSERT_EQ(vm::bbox3f(vm::vec3f(-6.0f, -6.0f, -6.0f), vm::vec3f(-2.0f, -2.0f, -2.0f)), model->bounds(0, 1));
+            ASSERT_EQ(vm::bbox3f(-8.0f, 8.0f), model->bounds(0, 2));
+            ASSERT_EQ(vm::bbox3f(vm::vec3f(8.0f, 8.0f, 8.0f), vm::vec3f(8.0f, 10.0f, 12.0f)), model->bounds(0, 3));
+            ASSERT_EQ(vm::bbox3f(-8.0f, 8.0f), model->bounds(0, 4));
+        }
+
+        TEST(MdlParserTest, parseTruncatedModel) {
+            const std::vector<PackedFrameGroup> frames = {
+                { { PackedVertex(0, 0, 0, 0), PackedVertex(4, 0, 0, 0), PackedVertex(0, 4, 8, 0) } },
+                { { PackedVertex(1, 1, 1, 0), PackedVertex(2, 2, 2, 0), PackedVertex(3, 3, 3, 0) } }
+            };
+
+            std::vector<char> data = createMdl(frames);
+            data.resize(data.size() - 4);
+
+            const Assets::Palette palette = createPalette();
+            MdlParser parser("test", createFile(data), palette);
+            ASSERT_THROW(parser.parseModel(), AssetException);
+        }
+
+        TEST(MdlParserTest, parseCorruptFrameGroupCount) {
+            const std::vector<PackedFrameGroup> frames = {
+                { { PackedVertex(1, 1, 1, 0), PackedVertex(2, 2, 2, 0), PackedVertex(3, 3, 3, 0) },
+                  { PackedVertex(9, 9, 9, 0), PackedVertex(9, 9, 9, 0), PackedVertex(9, 9, 9, 0) } }
+            };
+
+            const Assets::Palette palette = createPalette();
+            for (const int32_t groupFrameCount : { -1, 0x7FFFFFFF, 3 }) {
+                std::vector<char> data = createMdl(frames);
+
+                // the group is stored as its type, its frame count, its bounds, two times and two frames of 3 vertices
+                const size_t groupSize = 4 + 4 + 8 + 2 * 4 + 2 * (8 + 16 + 3 * 4);
+                std::memcpy(data.data() + data.size() - groupSize + 4, &groupFrameCount, sizeof(int32_t));
+
+                MdlParser parser("test", createFile(data), palette);
+                ASSERT_THROW(parser.parseModel(), AssetException);
+            }
+        }
+
+        TEST(MdlParserTest, cacheModel) {
+            const std::vector<PackedFrameGroup> frames = {
+                { { PackedVertex(0, 0, 0, 0), PackedVertex(4, 0, 0, 0), PackedVertex(0, 4, 8, 0) } },
+                { { PackedVertex(1, 1, 1, 0), PackedVertex(2, 2, 2, 0), PackedVertex(3, 3, 3, 0) },
+                  { PackedVertex(9, 9, 9, 0), PackedVertex(9, 9, 9, 0), PackedVertex(9, 9, 9, 0) } },
+                { },
+                { { PackedVertex(8, 8, 8, 0), PackedVertex(8, 9, 8, 0), PackedVertex(8, 8, 10, 0) } }
+            };
+
+            const Path cacheDir = Disk::getCurrentWorkingDir() + Path("mdlcachetest");
+            AssetCache cache(cacheDir, 1024 * 1024);
+            cache.clear();
+
+            const Assets::Palette palette = createPalette();
+            const MappedFile::Ptr file = createFile(createMdl(frames));
+            const AssetCache::Key key = EntityModelCache::createKey("mdl", *file);
+
+            DiskFileSystem fs(Disk::getCurrentWorkingDir());
+            EntityModelCache modelCache(cache, fs);
+
+            MdlParser storeParser("test", file, palette);
+            std::unique_ptr<Assets::EntityModel> stored(modelCache.loadMdlModel(key, "test", storeParser));
+            MdlParser findParser("test", file, palette);
+            std::unique_ptr<Assets::EntityModel> cached(modelCache.loadMdlModel(key, "test", findParser));
+            ASSERT_EQ(1u, cache.stats().hits);
+            ASSERT_EQ(1u, cache.stats().misses);
+
+            const auto* expectedModel = static_cast<const Assets::MdlModel*>(stored.get());
+            const auto* cachedModel = static_cast<const Assets::MdlModel*>(cached.get());
+
+            // storing a model copies its frames without decoding them
+            ASSERT_EQ(0u, expectedModel->cachedFrameCount());
+            ASSERT_EQ(0u, cachedModel->cachedFrameCount());
+
+            ASSERT_EQ(4u, cachedModel->frameCount());
+            for (size_t i = 0; i < expectedModel->frameCount(); ++i) {
+                const auto expectedFrame = expectedModel->frame(i);
+                const auto cachedFrame = cachedModel->frame(i);
+                ASSERT_EQ(expectedFrame->name(), cachedFrame->name());
+                ASSERT_EQ(expectedFrame->bounds(), cachedFrame->bounds());
+                ASSERT_TRUE(expectedFrame->triangles() == cachedFrame->triangles());
+            }
+
+            ASSERT_EQ(1u, cachedModel->skinCount());
+            ASSERT_EQ(expectedModel->skin(0)->times(), cachedModel->skin(0)->times());
+            const Assets::Texture* expectedSkin = expectedModel->skin(0)->firstPicture();
+            const Assets::Texture* cachedSkin = cachedModel->skin(0)->firstPicture();
+            ASSERT_EQ(expectedSkin->width(), cachedSkin->width());
+            ASSERT_EQ(expectedSkin->height(), cachedSkin->height());
+            ASSERT_EQ(expectedSkin->buffers().size(), cachedSkin->buffers().size());
+            ASSERT_EQ(0, std::memcmp(expectedSkin->buffers()[0].ptr(), cachedSkin->buffers()[0].ptr(), expectedSkin->buffers()[0].size()));
+
+            // a changed model file does not use the entry
+            std::vector<char> data = createMdl(frames);
+            data.back() ^= 1;
+            ASSERT_EQ(nullptr, cache.find(EntityModelCache::createKey("mdl", *createFile(data))));
+
+            cache.clear();
+            ::wxRmdir(cacheDir.asString());
+        }
+    }
+}
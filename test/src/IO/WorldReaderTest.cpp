@@ -24,6 +24,7 @@
 #include "Model/Brush.h"
 #include "Model/BrushFace.h"
 #include "Model/Entity.h"
+#include "Model/Layer.h"
 #include "Model/World.h"
 
 namespace TrenchBroom {
@@ -761,6 +762,61 @@ namespace TrenchBroom {
             delete world;
         }
 
+        TEST(WorldReaderTest, parseMapAndLinkEntities) {
+            const String data("{"
+                              "\"classname\" \"worldspawn\""
+                              "}"
+                              "{"
+                              "\"classname\" \"func_door\""
+                              "\"targetname\" \"door\""
+                              "}"
+                              "{"
+                              "\"classname\" \"trigger_multiple\""
+                              "\"target\" \"door\""
+                              "\"killtarget\" \"door\""
+                              "}"
+                              "{"
+                              "\"classname\" \"trigger_once\""
+                              "\"target2\" \"door\""
+                              "\"target3\" \"missing\""
+                              "}");
+            vm::bbox3 worldBounds(8192);
+            
+            IO::TestParserStatus status;
+            WorldReader reader(data, nullptr);
+            
+            Model::World* world = reader.read(Model::MapFormat::Standard, worldBounds, status);
+            ASSERT_TRUE(world != nullptr);
+            
+            Model::Layer* defaultLayer = world->defaultLayer();
+            ASSERT_EQ(3u, defaultLayer->childCount());
+            
+            Model::Entity* door = static_cast<Model::Entity*>(defaultLayer->children()[0]);
+            Model::Entity* trigger = static_cast<Model::Entity*>(defaultLayer->children()[1]);
+            Model::Entity* once = static_cast<Model::Entity*>(defaultLayer->children()[2]);
+            
+            ASSERT_EQ((Model::AttributableNodeList{ door }), world->attributableNodeIndex().findAttributableNodes(Model::AttributableNodeIndexQuery::exact("targetname"), "door"));
+            ASSERT_EQ((Model::AttributableNodeList{ world }), world->attributableNodeIndex().findAttributableNodes(Model::AttributableNodeIndexQuery::exact("classname"), "worldspawn"));
+            
+            ASSERT_EQ((Model::AttributableNodeSet{ trigger, once }), SetUtils::makeSet(door->linkSources()));
+            ASSERT_EQ((Model::AttributableNodeList{ trigger }), door->killSources());
+            ASSERT_EQ((Model::AttributableNodeList{ door }), trigger->linkTargets());
+            ASSERT_EQ((Model::AttributableNodeList{ door }), trigger->killTargets());
+            ASSERT_EQ((Model::AttributableNodeList{ door }), once->linkTargets());
+            ASSERT_EQ((Model::AttributeNameList{ "target3" }), once->findMissingLinkTargets());
+            
+            // the index and the links are updated incrementally after loading
+            once->removeAttribute("target2");
+            ASSERT_EQ((Model::AttributableNodeList{ trigger }), door->linkSources());
+            ASSERT_TRUE(once->linkTargets().empty());
+            
+            door->addOrUpdateAttribute("targetname", "missing");
+            ASSERT_TRUE(trigger->linkTargets().empty());
+            ASSERT_EQ((Model::AttributableNodeList{ door }), once->linkTargets());
+            
+            delete world;
+        }
+
         /*
         TEST(WorldReaderTest, parseIssueIgnoreFlags) {
             const String data("{"
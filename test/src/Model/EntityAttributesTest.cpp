@@ -0,0 +1,124 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Model/EntityAttributes.h"
+
+#include <string>
+
+namespace TrenchBroom {
+    namespace Model {
+        static void addNumberedAttributes(EntityAttributes& attributes, const size_t count) {
+            for (size_t i = 0; i < count; ++i)
+                attributes.addOrUpdateAttribute("key" + std::to_string(i), "value" + std::to_string(i), nullptr);
+        }
+
+        static void assertAttributeQueries(const size_t extraAttributes) {
+            EntityAttributes attributes;
+            attributes.addOrUpdateAttribute("classname", "light", nullptr);
+            attributes.addOrUpdateAttribute("target", "door", nullptr);
+            attributes.addOrUpdateAttribute("target2", "button", nullptr);
+            addNumberedAttributes(attributes, extraAttributes);
+            attributes.addOrUpdateAttribute("origin", "0 0 0", nullptr);
+
+            ASSERT_EQ(4u + extraAttributes, attributes.attributes().size());
+            ASSERT_EQ("origin", attributes.attributes().back().name());
+
+            ASSERT_TRUE(attributes.hasAttribute("target"));
+            ASSERT_TRUE(attributes.hasAttribute("target", "door"));
+            ASSERT_FALSE(attributes.hasAttribute("target", "button"));
+            ASSERT_FALSE(attributes.hasAttribute("targetname"));
+            ASSERT_EQ(nullptr, attributes.attribute("targetname"));
+            ASSERT_EQ("light", *attributes.attribute("classname"));
+
+            ASSERT_TRUE(attributes.hasAttributeWithPrefix("targ", "button"));
+            ASSERT_FALSE(attributes.hasAttributeWithPrefix("orig", "button"));
+            ASSERT_TRUE(attributes.hasNumberedAttribute("target", "door"));
+            ASSERT_TRUE(attributes.hasNumberedAttribute("target", "button"));
+            ASSERT_FALSE(attributes.hasNumberedAttribute("targ", "button"));
+
+            ASSERT_EQ(2u, attributes.attributesWithPrefix("target").size());
+            ASSERT_EQ(2u, attributes.numberedAttributes("target").size());
+            ASSERT_EQ(1u, attributes.attributeWithName("target2").size());
+            ASSERT_TRUE(attributes.attributeWithName("target3").empty());
+
+            attributes.addOrUpdateAttribute("target", "window", nullptr);
+            ASSERT_EQ("window", *attributes.attribute("target"));
+            ASSERT_EQ(4u + extraAttributes, attributes.attributes().size());
+
+            attributes.renameAttribute("target", "killtarget", nullptr);
+            ASSERT_FALSE(attributes.hasAttribute("target"));
+            ASSERT_EQ("window", *attributes.attribute("killtarget"));
+            ASSERT_EQ("0 0 0", *attributes.attribute("origin"));
+
+            attributes.removeAttribute("classname");
+            ASSERT_FALSE(attributes.hasAttribute("classname"));
+            ASSERT_EQ("button", *attributes.attribute("target2"));
+            ASSERT_EQ("window", *attributes.attribute("killtarget"));
+            ASSERT_EQ(3u + extraAttributes, attributes.attributes().size());
+            ASSERT_EQ(extraAttributes, attributes.numberedAttributes("key").size());
+
+            // matches are returned in insertion order
+            const EntityAttribute::List prefixMatches = attributes.attributesWithPrefix("key");
+            const EntityAttribute::List numberedMatches = attributes.numberedAttributes("key");
+            for (size_t i = 0; i < extraAttributes; ++i) {
+                ASSERT_EQ("key" + std::to_string(i), prefixMatches[i].name());
+                ASSERT_EQ("key" + std::to_string(i), numberedMatches[i].name());
+            }
+        }
+
+        TEST(EntityAttributesTest, queryFewAttributes) {
+            assertAttributeQueries(0);
+        }
+
+        TEST(EntityAttributesTest, queryManyAttributes) {
+            assertAttributeQueries(EntityAttributes::IndexThreshold);
+        }
+
+        TEST(EntityAttributesTest, shrinkBelowIndexThreshold) {
+            EntityAttributes attributes;
+            addNumberedAttributes(attributes, EntityAttributes::IndexThreshold + 1);
+
+            for (size_t i = 0; i < EntityAttributes::IndexThreshold; ++i)
+                attributes.removeAttribute("key" + std::to_string(i));
+
+            ASSERT_EQ(1u, attributes.attributes().size());
+            ASSERT_EQ("value" + std::to_string(EntityAttributes::IndexThreshold), *attributes.attribute("key" + std::to_string(EntityAttributes::IndexThreshold)));
+            ASSERT_FALSE(attributes.hasAttribute("key0"));
+        }
+
+        TEST(EntityAttributesTest, setAttributes) {
+            EntityAttribute::List list;
+            for (size_t i = 0; i < 2 * EntityAttributes::IndexThreshold; ++i)
+                list.push_back(EntityAttribute("key" + std::to_string(i), std::to_string(i)));
+
+            EntityAttributes attributes;
+            attributes.setAttributes(list);
+            ASSERT_EQ(list.size(), attributes.attributes().size());
+            ASSERT_EQ("17", *attributes.attribute("key17"));
+
+            attributes.setAttributes(EntityAttribute::List({ EntityAttribute("classname", "info_null") }));
+            ASSERT_EQ(1u, attributes.attributes().size());
+            ASSERT_EQ(nullptr, attributes.attribute("key17"));
+            ASSERT_EQ("info_null", *attributes.attribute("classname"));
+        }
+    }
+}
@@ -22,6 +22,8 @@
 
 #include <memory>
 
+#include "Assets/EntityDefinition.h"
+#include "IO/ELParser.h"
 #include "Model/Entity.h"
 #include "Model/EntityAttributes.h"
 #include "Model/MapFormat.h"
@@ -90,5 +92,34 @@ namespace TrenchBroom {
             EXPECT_EQ(newOrigin, m_entity->origin());
             EXPECT_EQ(newBounds, m_entity->bounds());
         }
+    
+        TEST_F(EntityTest, modelSpecification) {
+            const Assets::ModelDefinition modelDefinition(IO::ELParser::parseStrict(R"({{ spawnflags == 1 -> "large.mdl", "small.mdl" }})"));
+            Assets::PointEntityDefinition definition("thing", Color(), vm::bbox3(8.0), "", Assets::AttributeDefinitionList(), modelDefinition);
+
+            ASSERT_EQ(StringList({ "spawnflags" }), modelDefinition.attributeDependencies());
+            ASSERT_EQ(Assets::ModelSpecification(), m_entity->modelSpecification());
+
+            m_entity->setDefinition(&definition);
+            ASSERT_EQ(Assets::ModelSpecification(IO::Path("small.mdl")), m_entity->modelSpecification());
+
+            m_entity->addOrUpdateAttribute("spawnflags", "1");
+            ASSERT_EQ(Assets::ModelSpecification(IO::Path("large.mdl")), m_entity->modelSpecification());
+
+            m_entity->addOrUpdateAttribute("origin", "10 20 30");
+            ASSERT_EQ(Assets::ModelSpecification(IO::Path("large.mdl")), m_entity->modelSpecification());
+
+            m_entity->renameAttribute("spawnflags", "spawnflags2");
+            ASSERT_EQ(Assets::ModelSpecification(IO::Path("small.mdl")), m_entity->modelSpecification());
+
+            m_entity->setAttributes({ EntityAttribute("spawnflags", "1") });
+            ASSERT_EQ(Assets::ModelSpecification(IO::Path("large.mdl")), m_entity->modelSpecification());
+
+            m_entity->removeAttribute("spawnflags");
+            ASSERT_EQ(Assets::ModelSpecification(IO::Path("small.mdl")), m_entity->modelSpecification());
+
+            m_entity->setDefinition(nullptr);
+            ASSERT_EQ(Assets::ModelSpecification(), m_entity->modelSpecification());
+        }
     }
 }
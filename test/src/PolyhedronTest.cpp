@@ -28,6 +28,7 @@
 #include <vecmath/plane.h>
 #include <vecmath/scalar.h>
 
+#include <cmath>
 #include <iterator>
 #include <tuple>
 
@@ -788,6 +789,90 @@ TEST(PolyhedronTest, testAddExistingPoints) {
     ASSERT_TRUE(p.addPoint(p4) == nullptr);
 }
 
+TEST(PolyhedronTest, convexHullOfGridPoints) {
+    // enough points to use conflict lists, most of them inside or on the boundary of the hull
+    std::vector<vm::vec3d> points;
+    for (size_t x = 0; x < 5; ++x) {
+        for (size_t y = 0; y < 5; ++y) {
+            for (size_t z = 0; z < 5; ++z) {
+                points.push_back(vm::vec3d(x * 8.0, y * 8.0, z * 8.0));
+            }
+        }
+    }
+
+    const Polyhedron3d p(points);
+    ASSERT_TRUE(p.polyhedron());
+    ASSERT_TRUE(p.closed());
+    ASSERT_EQ(8u, p.vertexCount());
+    ASSERT_EQ(12u, p.edgeCount());
+    ASSERT_EQ(6u, p.faceCount());
+    ASSERT_EQ(Polyhedron3d(vm::bbox3d(vm::vec3d::zero, vm::vec3d(32.0, 32.0, 32.0))), p);
+}
+
+TEST(PolyhedronTest, convexHullOfManyPointsEqualsIncrementalHull) {
+    std::vector<vm::vec3d> points;
+    for (size_t i = 0; i < 64; ++i) {
+        // points on a sphere with integer coordinates, followed by points on a smaller sphere
+        const auto theta = static_cast<double>(i) * 2.399963;
+        const auto z = 1.0 - (static_cast<double>(i) + 0.5) / 32.0;
+        const auto r = std::sqrt(1.0 - z * z);
+        points.push_back(vm::round(vm::vec3d(std::cos(theta) * r, std::sin(theta) * r, z) * 64.0));
+        points.push_back(vm::round(vm::vec3d(std::cos(theta) * r, std::sin(theta) * r, z) * 32.0));
+    }
+
+    Polyhedron3d incremental;
+    for (const auto& point : points) {
+        incremental.addPoint(point);
+    }
+
+    const Polyhedron3d batch(points);
+    ASSERT_TRUE(batch.polyhedron());
+    ASSERT_TRUE(batch.closed());
+    ASSERT_EQ(incremental, batch);
+}
+
+TEST(PolyhedronTest, moveVerticesPreservingTopology) {
+    const vm::vec3d p1( 0.0,  0.0,  0.0);
+    const vm::vec3d p2(32.0,  0.0,  0.0);
+    const vm::vec3d p3( 0.0, 32.0,  0.0);
+    const vm::vec3d p4( 0.0,  0.0, 32.0);
+
+    Polyhedron3d p(p1, p2, p3, p4);
+
+    // moving a vertex of a tetrahedron never changes its topology unless it passes through the opposite face
+    ASSERT_TRUE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p4 }), vm::vec3d(8.0, 8.0, 8.0)));
+    ASSERT_FALSE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p4 }), vm::vec3d(0.0, 0.0, -64.0)));
+    ASSERT_FALSE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p4 }), vm::vec3d(0.0, 0.0, -32.0)));
+    ASSERT_FALSE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ vm::vec3d(1.0, 1.0, 1.0) }), vm::vec3d(8.0, 8.0, 8.0)));
+
+    p.moveVerticesPreservingTopology(std::vector<vm::vec3d>({ p4 }), vm::vec3d(8.0, 8.0, 8.0));
+    ASSERT_EQ(Polyhedron3d(p1, p2, p3, p4 + vm::vec3d(8.0, 8.0, 8.0)), p);
+    ASSERT_EQ(vm::bbox3d(vm::vec3d::zero, vm::vec3d(32.0, 32.0, 40.0)), p.bounds());
+}
+
+TEST(PolyhedronTest, moveVerticesChangingTopology) {
+    const vm::vec3d p1( 0.0,  0.0,  0.0);
+    const vm::vec3d p2(32.0,  0.0,  0.0);
+    const vm::vec3d p3(32.0, 32.0,  0.0);
+    const vm::vec3d p4( 0.0, 32.0,  0.0);
+    const vm::vec3d p5(16.0, 16.0, 32.0);
+
+    const Polyhedron3d p({ p1, p2, p3, p4, p5 });
+
+    // moving p5 into the plane of the base would make the polyhedron flat
+    ASSERT_TRUE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p5 }), vm::vec3d(8.0, 0.0, 0.0)));
+    ASSERT_FALSE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p5 }), vm::vec3d(0.0, 0.0, -32.0)));
+
+    // moving p1 down would make the base non-planar
+    ASSERT_FALSE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p1 }), vm::vec3d(0.0, 0.0, -8.0)));
+
+    // moving p1 and p2 down keeps the base planar
+    ASSERT_TRUE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p1, p2 }), vm::vec3d(0.0, 0.0, -8.0)));
+
+    // moving p1 and p2 onto p4 and p3 collapses the base
+    ASSERT_FALSE(p.canMoveVerticesPreservingTopology(std::vector<vm::vec3d>({ p1, p2 }), vm::vec3d(0.0, 32.0, 0.0)));
+}
+
 TEST(PolyhedronTest, testAddManyPointsCrash) {
     const vm::vec3d p1( 8, 10, 0);
     const vm::vec3d p2( 0, 24, 0);
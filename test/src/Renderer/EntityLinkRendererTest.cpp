@@ -0,0 +1,147 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Model/EditorContext.h"
+#include "Model/Entity.h"
+#include "Model/Group.h"
+#include "Renderer/EntityLinkRenderer.h"
+#include "Renderer/MapRenderer.h"
+#include "View/MapDocument.h"
+#include "View/MapDocumentTest.h"
+
+#include <vecmath/vec.h>
+
+#include <memory>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class EntityLinkRendererTest : public View::MapDocumentTest {
+        protected:
+            std::unique_ptr<MapRenderer> mapRenderer;
+        protected:
+            void SetUp() override {
+                View::MapDocumentTest::SetUp();
+                document->editorContext().setEntityLinkMode(Model::EditorContext::EntityLinkMode_All);
+
+                // the map renderer forwards the document's notifications to its entity link renderer
+                mapRenderer = std::make_unique<MapRenderer>(document);
+            }
+
+            void TearDown() override {
+                mapRenderer.reset();
+                View::MapDocumentTest::TearDown();
+            }
+
+            EntityLinkRenderer& renderer() {
+                return mapRenderer->entityLinkRenderer();
+            }
+
+            Model::Entity* createEntity(const Model::AttributeName& name, const Model::AttributeValue& value) {
+                Model::Entity* entity = new Model::Entity();
+                entity->addOrUpdateAttribute(name, value);
+                document->addNode(entity, document->currentParent());
+                return entity;
+            }
+
+            void assertLink(const Model::Entity* source, const Model::Entity* target) {
+                const EntityLinkRenderer::Vertex::List vertices = renderer().linkVertices();
+                ASSERT_EQ(2u, vertices.size());
+                ASSERT_EQ(vm::vec3f(source->linkSourceAnchor()), vertices[0].v1);
+                ASSERT_EQ(vm::vec3f(target->linkTargetAnchor()), vertices[1].v1);
+            }
+        };
+
+        TEST_F(EntityLinkRendererTest, moveTarget) {
+            Model::Entity* source = createEntity("target", "t1");
+            Model::Entity* target = createEntity("targetname", "t1");
+            assertLink(source, target);
+
+            document->select(target);
+            ASSERT_TRUE(document->translateObjects(vm::vec3(64.0, 0.0, 0.0)));
+            assertLink(source, target);
+        }
+
+        TEST_F(EntityLinkRendererTest, renameTarget) {
+            Model::Entity* source = createEntity("target", "t1");
+            Model::Entity* target = createEntity("targetname", "t1");
+            assertLink(source, target);
+
+            document->select(target);
+            ASSERT_TRUE(document->setAttribute("targetname", "t2"));
+            ASSERT_TRUE(renderer().linkVertices().empty());
+
+            document->deselectAll();
+            document->select(source);
+            ASSERT_TRUE(document->setAttribute("target", "t2"));
+            assertLink(source, target);
+        }
+
+        TEST_F(EntityLinkRendererTest, moveGroupContainingTarget) {
+            Model::Entity* source = createEntity("target", "t1");
+            Model::Entity* target = createEntity("targetname", "t1");
+            assertLink(source, target);
+
+            document->select(target);
+            Model::Group* group = document->groupSelection("group");
+            ASSERT_TRUE(group != nullptr);
+            ASSERT_TRUE(group->selected());
+            assertLink(source, target);
+
+            // only the group and its parent are reported as changed
+            ASSERT_TRUE(document->translateObjects(vm::vec3(64.0, 0.0, 0.0)));
+            assertLink(source, target);
+        }
+
+        TEST_F(EntityLinkRendererTest, moveGroupContainingSource) {
+            Model::Entity* source = createEntity("target", "t1");
+            Model::Entity* target = createEntity("targetname", "t1");
+            assertLink(source, target);
+
+            document->select(source);
+            Model::Group* group = document->groupSelection("group");
+            ASSERT_TRUE(group != nullptr);
+            assertLink(source, target);
+
+            ASSERT_TRUE(document->translateObjects(vm::vec3(0.0, 64.0, 0.0)));
+            assertLink(source, target);
+
+            document->undoLastCommand();
+            assertLink(source, target);
+        }
+
+        TEST_F(EntityLinkRendererTest, selectHiddenEntities) {
+            Model::Entity* source = createEntity("target", "t1");
+            Model::Entity* target = createEntity("targetname", "t1");
+            ASSERT_EQ(2u, renderer().linkVertices().size());
+
+            // hidden point entities are only visible while they are selected
+            document->editorContext().setShowPointEntities(false);
+            ASSERT_TRUE(renderer().linkVertices().empty());
+
+            document->select(Model::NodeList { source, target });
+            ASSERT_EQ(2u, renderer().linkVertices().size());
+
+            document->deselectAll();
+            ASSERT_TRUE(renderer().linkVertices().empty());
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "TestUtils.h"
+#include "Renderer/RenderUtils.h"
+
+#include <vecmath/vec.h>
+
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        static void assertRoundedRectTemplate(const RoundedRect2DTemplate& rectTemplate, const vm::vec2f& size, const float cornerRadius, const size_t cornerSegments) {
+            const std::vector<vm::vec2f> expected = roundedRect2D(size, cornerRadius, cornerSegments);
+            ASSERT_EQ(expected.size(), rectTemplate.vertexCount());
+            for (size_t i = 0; i < expected.size(); ++i)
+                ASSERT_VEC_EQ(expected[i], rectTemplate.vertex(i, size));
+        }
+
+        TEST(RenderUtilsTest, roundedRect2DTemplate) {
+            const RoundedRect2DTemplate rectTemplate(3.0f, 3);
+
+            // the smallest possible rectangle
+            assertRoundedRectTemplate(rectTemplate, vm::vec2f(6.0f, 6.0f), 3.0f, 3);
+
+            // the backgrounds of single and multi line strings
+            assertRoundedRectTemplate(rectTemplate, vm::vec2f(72.0f, 21.0f), 3.0f, 3);
+            assertRoundedRectTemplate(rectTemplate, vm::vec2f(13.5f, 150.25f), 3.0f, 3);
+        }
+
+        TEST(RenderUtilsTest, roundedRect2DTemplateWithOtherCorners) {
+            const RoundedRect2DTemplate rectTemplate(5.0f, 8);
+            assertRoundedRectTemplate(rectTemplate, vm::vec2f(10.0f, 10.0f), 5.0f, 8);
+            assertRoundedRectTemplate(rectTemplate, vm::vec2f(250.0f, 32.0f), 5.0f, 8);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Renderer/TextureAtlas.h"
+
+namespace TrenchBroom {
+    namespace Renderer {
+        TEST(TextureAtlasTest, mipLevel) {
+            ASSERT_EQ(0u, TextureAtlas::mipLevel(64, 64, 4, 64, 64));
+            ASSERT_EQ(1u, TextureAtlas::mipLevel(128, 128, 4, 64, 64));
+            ASSERT_EQ(1u, TextureAtlas::mipLevel(128, 128, 4, 50, 50));
+            ASSERT_EQ(3u, TextureAtlas::mipLevel(512, 256, 4, 32, 32));
+            ASSERT_EQ(2u, TextureAtlas::mipLevel(256, 64, 4, 64, 16));
+
+            // the level count limits the result
+            ASSERT_EQ(0u, TextureAtlas::mipLevel(256, 256, 1, 64, 64));
+
+            // textures smaller than the requested size use the first level
+            ASSERT_EQ(0u, TextureAtlas::mipLevel(32, 32, 6, 64, 64));
+        }
+
+        TEST(TextureAtlasTest, allocateFillsShelves) {
+            TextureAtlas atlas(128, 2);
+
+            TextureAtlas::Region region;
+            ASSERT_TRUE(atlas.allocate(62, 30, region));
+            ASSERT_EQ(0u, region.page);
+            ASSERT_EQ(1u, region.x);
+            ASSERT_EQ(1u, region.y);
+            ASSERT_EQ(62u, region.width);
+            ASSERT_EQ(30u, region.height);
+
+            ASSERT_TRUE(atlas.allocate(62, 62, region));
+            ASSERT_EQ(0u, region.page);
+            ASSERT_EQ(65u, region.x);
+            ASSERT_EQ(1u, region.y);
+
+            // starts a new shelf below the tallest region of the first one
+            ASSERT_TRUE(atlas.allocate(30, 30, region));
+            ASSERT_EQ(0u, region.page);
+            ASSERT_EQ(1u, region.x);
+            ASSERT_EQ(65u, region.y);
+
+            // does not fit below the second shelf
+            ASSERT_TRUE(atlas.allocate(100, 62, region));
+            ASSERT_EQ(1u, region.page);
+            ASSERT_EQ(1u, region.x);
+            ASSERT_EQ(1u, region.y);
+            ASSERT_EQ(2u, atlas.pageCount());
+        }
+
+        TEST(TextureAtlasTest, allocateWithoutClearing) {
+            TextureAtlas atlas(64, 1);
+
+            TextureAtlas::Region region;
+            ASSERT_TRUE(atlas.allocate(62, 62, region, false));
+            ASSERT_FALSE(atlas.allocate(30, 30, region, false));
+            ASSERT_EQ(0u, atlas.generation());
+
+            ASSERT_TRUE(atlas.allocate(30, 30, region));
+            ASSERT_EQ(1u, atlas.generation());
+        }
+
+        TEST(TextureAtlasTest, allocateTexCoords) {
+            TextureAtlas atlas(128, 1);
+
+            TextureAtlas::Region region;
+            ASSERT_TRUE(atlas.allocate(63, 31, region));
+            ASSERT_FLOAT_EQ(1.5f / 128.0f, region.texCoordsMin.x());
+            ASSERT_FLOAT_EQ(1.5f / 128.0f, region.texCoordsMin.y());
+            ASSERT_FLOAT_EQ(63.5f / 128.0f, region.texCoordsMax.x());
+            ASSERT_FLOAT_EQ(31.5f / 128.0f, region.texCoordsMax.y());
+        }
+
+        TEST(TextureAtlasTest, allocateTooLarge) {
+            TextureAtlas atlas(128, 1);
+
+            TextureAtlas::Region region;
+            ASSERT_FALSE(atlas.allocate(127, 16, region));
+            ASSERT_FALSE(atlas.allocate(16, 128, region));
+            ASSERT_TRUE(atlas.allocate(126, 126, region));
+        }
+
+        TEST(TextureAtlasTest, clearWhenFull) {
+            TextureAtlas atlas(128, 2);
+            ASSERT_EQ(0u, atlas.generation());
+
+            TextureAtlas::Region region;
+            ASSERT_TRUE(atlas.allocate(126, 126, region));
+            ASSERT_TRUE(atlas.allocate(126, 126, region));
+            ASSERT_EQ(1u, region.page);
+            ASSERT_EQ(0u, atlas.generation());
+
+            ASSERT_TRUE(atlas.allocate(126, 126, region));
+            ASSERT_EQ(0u, region.page);
+            ASSERT_EQ(1u, atlas.pageCount());
+            ASSERT_EQ(1u, atlas.generation());
+        }
+    }
+}
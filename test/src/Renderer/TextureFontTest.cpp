@@ -0,0 +1,87 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "AttrString.h"
+#include "Renderer/FontGlyph.h"
+#include "Renderer/FontTexture.h"
+#include "Renderer/TextureFont.h"
+
+#include <vecmath/vec.h>
+
+#include <string>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        static const unsigned char FirstChar = ' ';
+        static const unsigned char CharCount = 96;
+
+        static TextureFont* createFont() {
+            FontGlyph::List glyphs;
+            for (size_t i = 0; i < CharCount; ++i)
+                glyphs.push_back(FontGlyph(i * 8, 0, 8, 12, 8));
+            return new TextureFont(new FontTexture(CharCount, 12, 1), glyphs, 12, FirstChar, CharCount);
+        }
+
+        TEST(TextureFontTest, runIsLaidOutOnce) {
+            TextureFont* font = createFont();
+
+            const AttrString string("info_player_start");
+            const TextureFont::RunPtr run = font->run(string);
+            ASSERT_EQ(font->quads(string, true), run->vertices);
+            ASSERT_EQ(font->measure(string), run->size);
+            ASSERT_EQ(1u, font->cachedRunCount());
+
+            ASSERT_EQ(run, font->run(AttrString("info_player_start")));
+            ASSERT_EQ(1u, font->cachedRunCount());
+
+            const TextureFont::RunPtr otherRun = font->run(AttrString("light"));
+            ASSERT_NE(run, otherRun);
+            ASSERT_EQ(2u, font->cachedRunCount());
+
+            delete font;
+        }
+
+        TEST(TextureFontTest, runCacheIsFlushedWhenFull) {
+            TextureFont* font = createFont();
+
+            const AttrString firstString("0");
+            const TextureFont::RunPtr firstRun = font->run(firstString);
+            for (size_t i = 1; i < TextureFont::MaxCachedRuns; ++i)
+                font->run(AttrString(std::to_string(i)));
+            ASSERT_EQ(TextureFont::MaxCachedRuns, font->cachedRunCount());
+            ASSERT_EQ(firstRun, font->run(firstString));
+
+            // the run that does not fit into the cache anymore flushes it
+            font->run(AttrString(std::to_string(TextureFont::MaxCachedRuns)));
+            ASSERT_EQ(1u, font->cachedRunCount());
+
+            // runs which were flushed from the cache remain valid, but are laid out again when requested
+            ASSERT_EQ(font->quads(firstString, true), firstRun->vertices);
+            const TextureFont::RunPtr newFirstRun = font->run(firstString);
+            ASSERT_NE(firstRun, newFirstRun);
+            ASSERT_EQ(firstRun->vertices, newFirstRun->vertices);
+            ASSERT_EQ(2u, font->cachedRunCount());
+
+            delete font;
+        }
+    }
+}
@@ -231,4 +231,65 @@ namespace TrenchBroom {
         ASSERT_EQ((StringSet{"key", "key2", "key22", "k1", "test"}),
                   SetUtils::makeSet(index.getKeys()));
     }
+
+    TEST(StringMultiMapTest, bulkInsert) {
+        const TestMultiMap::KeyValueList keyValues {
+            { "target", "value1" },
+            { "targetname", "value2" },
+            { "target2", "value3" },
+            { "target22", "value1" },
+            { "tar", "value4" },
+            { "killtarget", "value5" },
+            { "3.67", "value6" },
+            { "3.6", "value7" },
+            { "", "value8" },
+            { "target", "value9" },
+            { "target", "value1" }
+        };
+
+        TestMultiMap bulk;
+        bulk.insert(keyValues);
+
+        TestMultiMap incremental;
+        for (const auto& keyValue : keyValues)
+            incremental.insert(keyValue.first, keyValue.second);
+
+        ASSERT_EQ(SetUtils::makeSet(incremental.getKeys()), SetUtils::makeSet(bulk.getKeys()));
+        for (const String& query : StringList { "", "t", "tar", "targ", "target", "target2", "targetname", "k", "3.", "3.6", "x" }) {
+            ASSERT_EQ(incremental.queryExactMatches(query), bulk.queryExactMatches(query));
+            ASSERT_EQ(incremental.queryPrefixMatches(query), bulk.queryPrefixMatches(query));
+            ASSERT_EQ(incremental.queryNumberedMatches(query), bulk.queryNumberedMatches(query));
+        }
+
+        // removing a value that was inserted twice only removes one of its occurrences
+        bulk.remove("target", "value1");
+        ASSERT_EQ((StringSet{"value1", "value9"}), bulk.queryExactMatches("target"));
+        bulk.remove("target", "value1");
+        ASSERT_EQ((StringSet{"value9"}), bulk.queryExactMatches("target"));
+
+        // inserting into a non-empty map adds to the existing tree
+        bulk.insert(TestMultiMap::KeyValueList { { "targetname", "value10" }, { "tarp", "value11" } });
+        ASSERT_EQ((StringSet{"value2", "value10"}), bulk.queryExactMatches("targetname"));
+        ASSERT_EQ((StringSet{"value11"}), bulk.queryExactMatches("tarp"));
+    }
+
+    TEST(StringMultiMapTest, bulkInsertMany) {
+        TestMultiMap::KeyValueList keyValues;
+        for (size_t i = 0; i < 500; ++i)
+            keyValues.emplace_back((i % 2 == 0 ? "target" : "killtarget") + std::to_string(i % 170), "value" + std::to_string(i % 7));
+
+        TestMultiMap bulk;
+        bulk.insert(keyValues);
+
+        TestMultiMap incremental;
+        for (const auto& keyValue : keyValues)
+            incremental.insert(keyValue.first, keyValue.second);
+
+        ASSERT_EQ(SetUtils::makeSet(incremental.getKeys()), SetUtils::makeSet(bulk.getKeys()));
+        for (const String& query : StringList { "", "target", "target1", "target16", "killtarget", "killtarget9", "x" }) {
+            ASSERT_EQ(incremental.queryExactMatches(query), bulk.queryExactMatches(query));
+            ASSERT_EQ(incremental.queryPrefixMatches(query), bulk.queryPrefixMatches(query));
+            ASSERT_EQ(incremental.queryNumberedMatches(query), bulk.queryNumberedMatches(query));
+        }
+    }
 }
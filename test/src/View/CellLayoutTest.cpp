@@ -0,0 +1,127 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "View/CellLayout.h"
+
+#include <random>
+
+namespace TrenchBroom {
+    namespace View {
+        typedef CellLayout<size_t, int> Layout;
+
+        static void initLayout(Layout& layout) {
+            layout.setWidth(400.0f);
+            layout.setOuterMargin(5.0f);
+            layout.setGroupMargin(5.0f);
+            layout.setRowMargin(5.0f);
+            layout.setCellMargin(5.0f);
+            layout.setTitleMargin(2.0f);
+            layout.setCellWidth(64.0f, 64.0f);
+            layout.setCellHeight(64.0f, 128.0f);
+        }
+
+        static void assertRowsIntersectingY(Layout& layout, const float y, const float height) {
+            for (size_t i = 0; i < layout.size(); ++i) {
+                const Layout::Group& group = layout[i];
+                const auto rows = group.rowsIntersectingY(y, height);
+                ASSERT_LE(rows.first, rows.second);
+                for (size_t j = 0; j < group.size(); ++j) {
+                    const bool inRange = j >= rows.first && j < rows.second;
+                    ASSERT_EQ(group[j].intersectsY(y, height), inRange);
+                }
+            }
+        }
+
+        static void assertCellsAreFound(Layout& layout, const size_t itemCount) {
+            size_t count = 0;
+            for (size_t i = 0; i < layout.size(); ++i) {
+                const Layout::Group& group = layout[i];
+                for (size_t j = 0; j < group.size(); ++j) {
+                    const Layout::Group::Row& row = group[j];
+                    for (size_t k = 0; k < row.size(); ++k) {
+                        const Layout::Group::Row::Cell& cell = row[k];
+                        const LayoutBounds& bounds = cell.itemBounds();
+
+                        const Layout::Group::Row::Cell* result = nullptr;
+                        ASSERT_TRUE(layout.cellAt(bounds.midX(), bounds.midY(), &result));
+                        ASSERT_EQ(cell.item(), result->item());
+                        ++count;
+                    }
+                }
+            }
+            ASSERT_EQ(itemCount, count);
+        }
+
+        TEST(CellLayoutTest, uniformRows) {
+            Layout layout;
+            initLayout(layout);
+
+            for (size_t i = 0; i < 100; ++i)
+                layout.addItem(i, 64.0f, 64.0f, 40.0f, 12.0f);
+
+            ASSERT_EQ(1u, layout.size());
+            const Layout::Group& group = layout[0];
+            ASSERT_EQ(20u, group.size());
+
+            for (size_t j = 1; j < group.size(); ++j)
+                ASSERT_FLOAT_EQ(group[j - 1].bounds().bottom() + 5.0f, group[j].bounds().top());
+
+            for (float y = -10.0f; y < layout.height() + 10.0f; y += 7.0f)
+                assertRowsIntersectingY(layout, y, 200.0f);
+            assertCellsAreFound(layout, 100);
+        }
+
+        TEST(CellLayoutTest, mixedRowHeights) {
+            Layout layout;
+            initLayout(layout);
+
+            std::mt19937 random(0);
+            size_t itemCount = 0;
+            for (int i = 0; i < 3; ++i) {
+                layout.addGroup(i, 14.0f);
+                for (size_t j = 0; j < 50; ++j) {
+                    const float height = static_cast<float>(16 << (random() % 4));
+                    layout.addItem(itemCount++, 64.0f, height, 40.0f, 12.0f);
+                }
+            }
+
+            ASSERT_EQ(3u, layout.size());
+            for (float y = -10.0f; y < layout.height() + 10.0f; y += 7.0f)
+                assertRowsIntersectingY(layout, y, 200.0f);
+            assertCellsAreFound(layout, itemCount);
+        }
+
+        TEST(CellLayoutTest, relayoutKeepsItems) {
+            Layout layout;
+            initLayout(layout);
+
+            layout.addGroup(0, 14.0f);
+            for (size_t i = 0; i < 30; ++i)
+                layout.addItem(i, 64.0f, 64.0f, 40.0f, 12.0f);
+
+            layout.setWidth(200.0f);
+            ASSERT_EQ(1u, layout.size());
+            ASSERT_EQ(15u, layout[0].size());
+            assertCellsAreFound(layout, 30);
+        }
+    }
+}
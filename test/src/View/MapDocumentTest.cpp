@@ -372,6 +372,35 @@ namespace TrenchBroom {
             delete texAlignmentSnapshot;
         }
         
+        TEST_F(MapDocumentTest, csgSubtractLeavesDisjointMinuendsUntouched) {
+            document->selectAllNodes();
+            document->deleteObjects();
+            assert(document->selectedNodes().nodeCount() == 0);
+
+            const Model::BrushBuilder builder(document->world(), document->worldBounds());
+
+            Model::Brush* minuend1 = builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(64, 64, 64)), "texture");
+            Model::Brush* minuend2 = builder.createCuboid(vm::bbox3(vm::vec3(128, 0, 0), vm::vec3(192, 64, 64)), "texture");
+            Model::Brush* subtrahend = builder.createCuboid(vm::bbox3(vm::vec3(0, 0, 0), vm::vec3(64, 64, 32)), "texture");
+            document->addNode(minuend1, document->currentParent());
+            document->addNode(minuend2, document->currentParent());
+            document->addNode(subtrahend, document->currentParent());
+
+            document->select(Model::NodeList { minuend1, minuend2, subtrahend });
+            ASSERT_TRUE(document->csgSubtract());
+
+            const Model::NodeList& children = document->currentParent()->children();
+            ASSERT_EQ(2u, children.size());
+            ASSERT_TRUE(VectorUtils::contains(children, minuend2));
+            ASSERT_TRUE(minuend2->selected());
+
+            const Model::BrushList selectedBrushes = document->selectedNodes().brushes();
+            ASSERT_EQ(2u, selectedBrushes.size());
+
+            const Model::Brush* fragment = static_cast<Model::Brush*>(children[0] == minuend2 ? children[1] : children[0]);
+            ASSERT_EQ(vm::bbox3(vm::vec3(0, 0, 32), vm::vec3(64, 64, 64)), fragment->bounds());
+        }
+
         TEST_F(MapDocumentTest, newWithGroupOpen) {
             Model::Entity* entity = new Model::Entity();
             document->addNode(entity, document->currentParent());
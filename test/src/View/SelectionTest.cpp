@@ -28,6 +28,8 @@
 #include "View/MapDocumentTest.h"
 #include "View/MapDocument.h"
 
+#include <algorithm>
+
 namespace TrenchBroom {
     namespace View {
         class SelectionTest : public MapDocumentTest {};
@@ -62,6 +64,65 @@ namespace TrenchBroom {
             ASSERT_EQ(1u, document->selectedNodes().nodeCount());
         }
         
+        TEST_F(SelectionTest, selectTouchingOnlySelectsTouchingBrushes) {
+            document->selectAllNodes();
+            document->deleteObjects();
+            assert(document->selectedNodes().nodeCount() == 0);
+
+            Model::BrushBuilder builder(document->world(), document->worldBounds());
+
+            // a row of cubes along the X axis
+            Model::BrushList row;
+            for (size_t i = 0; i < 8; ++i) {
+                const auto x = static_cast<FloatType>(i) * 64.0;
+                Model::Brush* brush = builder.createCuboid(vm::bbox3(vm::vec3(x, 0.0, 0.0), vm::vec3(x + 32.0, 32.0, 32.0)), "texture");
+                document->addNode(brush, document->currentParent());
+                row.push_back(brush);
+            }
+
+            // touches the cubes at indices 2, 3 and 4
+            Model::Brush* selectionBrush = builder.createCuboid(vm::bbox3(vm::vec3(128.0, 8.0, 8.0), vm::vec3(272.0, 24.0, 24.0)), "texture");
+            document->addNode(selectionBrush, document->currentParent());
+
+            document->select(selectionBrush);
+            document->selectTouching(false);
+
+            Model::BrushList expected { row[2], row[3], row[4] };
+            Model::BrushList actual = document->selectedNodes().brushes();
+            std::sort(std::begin(expected), std::end(expected));
+            std::sort(std::begin(actual), std::end(actual));
+            ASSERT_EQ(expected, actual);
+        }
+
+        TEST_F(SelectionTest, selectTouchingSelectsInDocumentOrder) {
+            document->selectAllNodes();
+            document->deleteObjects();
+            assert(document->selectedNodes().nodeCount() == 0);
+
+            Model::BrushBuilder builder(document->world(), document->worldBounds());
+
+            // a row of cubes along the X axis
+            Model::BrushList row;
+            for (size_t i = 0; i < 8; ++i) {
+                const auto x = static_cast<FloatType>(i) * 64.0;
+                Model::Brush* brush = builder.createCuboid(vm::bbox3(vm::vec3(x, 0.0, 0.0), vm::vec3(x + 32.0, 32.0, 32.0)), "texture");
+                document->addNode(brush, document->currentParent());
+                row.push_back(brush);
+            }
+
+            // touch the cubes at indices 5 and 1
+            Model::Brush* selectionBrush1 = builder.createCuboid(vm::bbox3(vm::vec3(328.0, 8.0, 8.0), vm::vec3(344.0, 24.0, 24.0)), "texture");
+            Model::Brush* selectionBrush2 = builder.createCuboid(vm::bbox3(vm::vec3(72.0, 8.0, 8.0), vm::vec3(88.0, 24.0, 24.0)), "texture");
+            document->addNode(selectionBrush1, document->currentParent());
+            document->addNode(selectionBrush2, document->currentParent());
+
+            document->select(Model::NodeList { selectionBrush1, selectionBrush2 });
+            document->selectTouching(false);
+
+            const Model::BrushList expected { row[1], row[5] };
+            ASSERT_EQ(expected, document->selectedNodes().brushes());
+        }
+
         TEST_F(SelectionTest, selectInsideWithGroup) {
             document->selectAllNodes();
             document->deleteObjects();
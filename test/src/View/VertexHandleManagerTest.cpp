@@ -0,0 +1,183 @@
+/*
+ Copyright (C) 2010-2017 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "PreferenceManager.h"
+#include "Preferences.h"
+#include "Model/Brush.h"
+#include "Model/BrushBuilder.h"
+#include "Model/Hit.h"
+#include "Model/MapFormat.h"
+#include "Model/PickResult.h"
+#include "Model/World.h"
+#include "Renderer/PerspectiveCamera.h"
+#include "View/VertexHandleManager.h"
+
+#include <vecmath/vec.h>
+#include <vecmath/ray.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace View {
+        static std::vector<vm::vec3> makeGrid(const size_t size, const FloatType spacing) {
+            std::vector<vm::vec3> result;
+            for (size_t x = 0; x < size; ++x) {
+                for (size_t y = 0; y < size; ++y) {
+                    for (size_t z = 0; z < size; ++z) {
+                        result.emplace_back(static_cast<FloatType>(x) * spacing, static_cast<FloatType>(y) * spacing, static_cast<FloatType>(z) * spacing);
+                    }
+                }
+            }
+            return result;
+        }
+
+        static std::vector<vm::vec3> hitHandles(const Model::PickResult& pickResult) {
+            std::vector<vm::vec3> result;
+            for (const auto& hit : pickResult.all()) {
+                result.push_back(hit.target<vm::vec3>());
+            }
+            std::sort(std::begin(result), std::end(result));
+            return result;
+        }
+
+        static void addHandles(VertexHandleManager& manager, const std::vector<vm::vec3>& handles) {
+            for (const auto& handle : handles) {
+                manager.add(handle);
+            }
+        }
+
+        TEST(VertexHandleManagerTest, addRemoveAndSelect) {
+            VertexHandleManager manager;
+            const auto handles = makeGrid(4, 16.0);
+            addHandles(manager, handles);
+            manager.add(handles.front());
+
+            ASSERT_EQ(handles.size(), manager.allHandles().size());
+            ASSERT_TRUE(manager.contains(handles.front()));
+            ASSERT_FALSE(manager.contains(vm::vec3(1.0, 1.0, 1.0)));
+
+            manager.select(handles[1]);
+            manager.select(handles[2]);
+            ASSERT_EQ(2u, manager.selectedHandleCount());
+            ASSERT_TRUE(manager.selected(handles[1]));
+            ASSERT_FALSE(manager.selected(handles[3]));
+
+            manager.remove(handles[1]);
+            ASSERT_EQ(1u, manager.selectedHandleCount());
+            ASSERT_FALSE(manager.contains(handles[1]));
+
+            // the freed slot is reused and must not inherit the selection state
+            manager.add(handles[1]);
+            ASSERT_TRUE(manager.contains(handles[1]));
+            ASSERT_FALSE(manager.selected(handles[1]));
+            ASSERT_EQ(1u, manager.selectedHandleCount());
+
+            manager.deselectAll();
+            ASSERT_EQ(0u, manager.selectedHandleCount());
+            ASSERT_TRUE(manager.selectedHandles().empty());
+
+            manager.clear();
+            ASSERT_TRUE(manager.allHandles().empty());
+            ASSERT_FALSE(manager.contains(handles.front()));
+        }
+
+        TEST(VertexHandleManagerTest, pickMatchesExhaustiveSearch) {
+            VertexHandleManager manager;
+            const auto handles = makeGrid(16, 8.0);
+            addHandles(manager, handles);
+
+            const Renderer::Camera::Viewport viewport(0, 0, 800, 600);
+            const Renderer::PerspectiveCamera camera(90.0f, 1.0f, 8192.0f, viewport, vm::vec3f(-64.0f, -48.0f, 96.0f), vm::normalize(vm::vec3f(1.0f, 1.0f, -0.5f)), vm::vec3f::pos_z);
+            const FloatType handleRadius = pref(Preferences::HandleRadius);
+
+            size_t hitCount = 0;
+            for (int x = 0; x < 800; x += 37) {
+                for (int y = 0; y < 600; y += 29) {
+                    const auto pickRay = vm::ray3(camera.pickRay(x, y));
+
+                    Model::PickResult pickResult;
+                    manager.pick(pickRay, camera, pickResult);
+
+                    std::vector<vm::vec3> expected;
+                    for (const auto& handle : handles) {
+                        if (!vm::isnan(camera.pickPointHandle(pickRay, handle, handleRadius))) {
+                            expected.push_back(handle);
+                        }
+                    }
+                    std::sort(std::begin(expected), std::end(expected));
+
+                    ASSERT_EQ(expected, hitHandles(pickResult));
+                    hitCount += expected.size();
+                }
+            }
+
+            ASSERT_LT(0u, hitCount);
+        }
+
+        TEST(VertexHandleManagerTest, updateHandles) {
+            const vm::bbox3 worldBounds(4096.0);
+            Model::World world(Model::MapFormat::Standard, nullptr, worldBounds);
+            Model::BrushBuilder builder(&world, worldBounds);
+            std::unique_ptr<Model::Brush> brush(builder.createCube(64.0, "texture"));
+
+            VertexHandleManager vertexHandles;
+            EdgeHandleManager edgeHandles;
+            vertexHandles.addHandles(brush.get());
+            edgeHandles.addHandles(brush.get());
+
+            const vm::vec3 moved(32.0, 32.0, 32.0);
+            const vm::vec3 unmoved(-32.0, -32.0, -32.0);
+            vertexHandles.select(moved);
+            vertexHandles.select(unmoved);
+
+            // nested updates only take effect when the outermost update ends
+            vertexHandles.beginUpdateHandles(brush.get());
+            vertexHandles.beginUpdateHandles(brush.get());
+            edgeHandles.beginUpdateHandles(brush.get());
+            brush->moveVertices(worldBounds, std::vector<vm::vec3>{ moved }, vm::vec3(16.0, 16.0, 16.0));
+            vertexHandles.endUpdateHandles(brush.get());
+            ASSERT_TRUE(vertexHandles.contains(moved));
+
+            vertexHandles.endUpdateHandles(brush.get());
+            edgeHandles.endUpdateHandles(brush.get());
+
+            ASSERT_FALSE(vertexHandles.contains(moved));
+            ASSERT_TRUE(vertexHandles.contains(vm::vec3(48.0, 48.0, 48.0)));
+            ASSERT_EQ(brush->vertexCount(), vertexHandles.allHandles().size());
+            ASSERT_EQ(brush->edgeCount(), edgeHandles.allHandles().size());
+            for (const auto* edge : brush->edges()) {
+                ASSERT_TRUE(edgeHandles.contains(vm::segment3(edge->firstVertex()->position(), edge->secondVertex()->position())));
+            }
+
+            // the handles that did not change keep their selection state
+            ASSERT_EQ(1u, vertexHandles.selectedHandleCount());
+            ASSERT_TRUE(vertexHandles.selected(unmoved));
+
+            // ending an update that was not begun adds all handles
+            vertexHandles.endUpdateHandles(brush.get());
+            ASSERT_EQ(brush->vertexCount(), vertexHandles.allHandles().size());
+            vertexHandles.removeHandles(brush.get());
+            ASSERT_EQ(brush->vertexCount(), vertexHandles.allHandles().size());
+        }
+    }
+}
@@ -31,6 +31,8 @@
 #include <vecmath/util.h>
 #include <vecmath/intersection.h>
 
+#include <vector>
+
 namespace vm {
     bool lineOnPlane(const plane3f& plane, const line3f& line);
 
@@ -168,6 +170,34 @@ namespace vm {
 
     }
 
+    TEST(IntersectionTest, intersectBBoxAndConvexVolume) {
+        // the pyramid with its apex at the origin that opens towards +z, having a square base of size 2x2 at z = 1
+        const std::vector<plane3d> pyramid {
+            plane3d(vec3d::zero, normalize(vec3d(+1.0, 0.0, -1.0))),
+            plane3d(vec3d::zero, normalize(vec3d(-1.0, 0.0, -1.0))),
+            plane3d(vec3d::zero, normalize(vec3d(0.0, +1.0, -1.0))),
+            plane3d(vec3d::zero, normalize(vec3d(0.0, -1.0, -1.0))),
+        };
+
+        const auto test = [&](const bbox3d& box) { return intersects(box, std::begin(pyramid), std::end(pyramid)); };
+
+        ASSERT_TRUE(test(bbox3d(vec3d(-0.5, -0.5, 0.5), vec3d(0.5, 0.5, 1.5))));
+        ASSERT_TRUE(test(bbox3d(vec3d(-8.0, -8.0, -8.0), vec3d(8.0, 8.0, 8.0))));
+        ASSERT_TRUE(test(bbox3d(vec3d(0.9, 0.9, 0.9), vec3d(1.0, 1.0, 1.0))));
+        ASSERT_TRUE(test(bbox3d(vec3d(0.0, 0.0, 0.0), vec3d(0.0, 0.0, 0.0))));
+
+        // behind the apex
+        ASSERT_FALSE(test(bbox3d(vec3d(-0.2, -0.2, -2.0), vec3d(0.2, 0.2, -1.0))));
+        // the test is conservative: this box is behind the apex, but not entirely above any single plane
+        ASSERT_TRUE(test(bbox3d(vec3d(-1.0, -1.0, -2.0), vec3d(1.0, 1.0, -0.5))));
+        // beside the pyramid
+        ASSERT_FALSE(test(bbox3d(vec3d(2.0, -0.5, 0.5), vec3d(3.0, 0.5, 1.5))));
+        ASSERT_FALSE(test(bbox3d(vec3d(-0.5, -3.0, 0.5), vec3d(0.5, -2.0, 1.5))));
+
+        // an empty range of planes is the entire space
+        ASSERT_TRUE(intersects(bbox3d(1.0), std::end(pyramid), std::end(pyramid)));
+    }
+
     TEST(IntersectionTest, intersectRayAndSphere) {
         const ray3f ray(vec3f::zero, vec3f::pos_z);
 
@@ -397,6 +397,40 @@ namespace vm {
         return distances[bestPlane];
     }
 
+    /**
+     * Checks whether the given bounding box may intersect the convex volume formed by the intersection of the half
+     * spaces below the planes in the given range.
+     *
+     * This test is conservative: It returns false only if the box is entirely above one of the planes, so it may return
+     * true for a box that lies outside of the volume, but close to one of its edges or corners.
+     *
+     * @tparam T the component type
+     * @tparam S the number of components
+     * @tparam I the plane range iterator
+     * @param b the bounding box
+     * @param cur the range start iterator
+     * @param end the range end iterator
+     * @return false if the given box is certainly disjoint from the given convex volume, and true otherwise
+     */
+    template <typename T, size_t S, typename I>
+    bool intersects(const bbox<T,S>& b, I cur, I end) {
+        while (cur != end) {
+            const plane<T,S>& p = *cur;
+
+            // the corner of the box that is furthest below the plane
+            vec<T,S> corner;
+            for (size_t i = 0; i < S; ++i) {
+                corner[i] = p.normal[i] >= static_cast<T>(0.0) ? b.min[i] : b.max[i];
+            }
+
+            if (p.pointDistance(corner) > static_cast<T>(0.0)) {
+                return false;
+            }
+            ++cur;
+        }
+        return true;
+    }
+
     /**
      * Computes the point of intersection between the given ray and a sphere centered at the given position and with the
      * given radius.